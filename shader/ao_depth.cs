@@ -0,0 +1,48 @@
+#version 460 core
+
+// Depth pyramid of the ambient occlusion: one level per dispatch, each texel averages the linear
+// view depth of the 2x2 texels under it, leaving out the ones far behind the closest so
+// silhouettes don't blend into the background. The average is taken over the inverse depth, which
+// is linear in screen space, so planes stay planes; a plain minimum would turn slanted surfaces
+// into steps the horizon search sees as occluders. The first level is half the render resolution
+// and reads the depth buffer
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D depthTexture; // depth buffer, or the pyramid
+layout(r32f, binding = 0) uniform writeonly image2D targetLevel;
+
+uniform bool  fromDepthBuffer;
+uniform int   sourceLevel;
+uniform ivec2 sourceArea;      // texels of the source in use
+uniform ivec2 targetArea;
+uniform vec2  projectionDepth; // projection[2][2] and [3][2], to linearize the depth buffer
+
+// relative depth behind the closest texel over which the others fade out of the average
+#define DEPTH_RANGE 0.1
+
+float LinearDepth(ivec2 texel)
+{
+    texel = min(texel, sourceArea - 1);
+    if (!fromDepthBuffer)
+        return texelFetch(depthTexture, texel, sourceLevel).r;
+
+    float ndc = 2.0 * texelFetch(depthTexture, texel, 0).r - 1.0;
+    return projectionDepth.y / (ndc + projectionDepth.x);
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, targetArea)))
+        return;
+
+    ivec2 source  = texel * 2;
+    vec4  depths  = vec4(LinearDepth(source),
+                        LinearDepth(source + ivec2(1, 0)),
+                        LinearDepth(source + ivec2(0, 1)),
+                        LinearDepth(source + ivec2(1, 1)));
+    float closest = min(min(depths.x, depths.y), min(depths.z, depths.w));
+    vec4  weights = clamp(1.0 - (depths - closest) / (DEPTH_RANGE * closest), 0.0, 1.0);
+    float depth   = dot(weights, vec4(1.0)) / dot(weights, 1.0 / depths);
+    imageStore(targetLevel, texel, vec4(depth));
+}
@@ -0,0 +1,159 @@
+#version 460 core
+
+// Ground-truth ambient occlusion (Jimenez et al. 2016, after XeGTAO). Every pixel searches the
+// depth pyramid for the highest horizon on both sides of a few screen-space slices through it and
+// integrates the visible arc, cosine-weighted around the normal, between the two horizons. Far
+// samples read coarser pyramid levels so the texture cache holds up with large radii. The slice
+// rotation and step offsets change every frame, the temporal pass averages them
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#define PI 3.14159265
+#define HALF_PI 1.57079633
+#define PYRAMID_LEVELS 4
+
+layout(binding = 0) uniform sampler2D depthPyramid; // linear view depth
+layout(r16f, binding = 0) uniform writeonly image2D occlusionImage;
+
+uniform int   baseLevel;    // pyramid level at the occlusion resolution
+uniform ivec2 area;         // occlusion texels in use
+uniform vec2  baseArea;     // render size over the level's scale, area rounds it up
+uniform vec4  unproject;    // 1 / projection[0][0], 1 / projection[1][1], projection[2][0], [2][1]
+uniform float projectionScale; // projection[1][1] * baseArea.y / 2, texels per unit at depth 1
+uniform float farDepth;
+uniform float radius;       // world units
+uniform int   sliceCount;
+uniform int   stepCount;
+uniform uint  frame;
+
+vec3 ViewPosition(vec2 uv, float depth)
+{
+    vec2 ndc = uv * 2.0 - 1.0;
+    return vec3((ndc + unproject.zw) * unproject.xy * depth, -depth);
+}
+
+// position of the pyramid texel under uv, at the texel center so the depth matches it exactly
+vec3 ViewPositionAt(vec2 uv, float level)
+{
+    int   lod       = int(level + 0.5);
+    vec2  levelArea = baseArea * exp2(float(baseLevel - lod));
+    ivec2 texel     = ivec2(clamp(uv * levelArea, vec2(0.0), ceil(levelArea) - 1.0));
+    vec2  center    = (vec2(texel) + 0.5) / levelArea;
+    return ViewPosition(center, texelFetch(depthPyramid, texel, lod).r);
+}
+
+float OnScreen(vec2 uv)
+{
+    return all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0))) ? 1.0 : 0.0;
+}
+
+// interleaved gradient noise (Jimenez 2014)
+float Noise(vec2 pixel)
+{
+    return fract(52.9829189 * fract(dot(pixel, vec2(0.06711056, 0.00583715))));
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, area)))
+        return;
+
+    vec2  texelSize = 1.0 / baseArea;
+    vec2  uv        = (vec2(pixel) + 0.5) * texelSize;
+    float level     = float(baseLevel);
+    float depth     = texelFetch(depthPyramid, pixel, baseLevel).r;
+    if (depth >= farDepth)
+    {
+        imageStore(occlusionImage, pixel, vec4(1.0));
+        return;
+    }
+
+    // normal from the neighbors on the side of the smallest depth step, so it doesn't bend
+    // across silhouettes, and from the one on screen at the borders
+    vec3 position = ViewPosition(uv, depth);
+    vec3 left     = ViewPositionAt(uv - vec2(texelSize.x, 0.0), level);
+    vec3 right    = ViewPositionAt(uv + vec2(texelSize.x, 0.0), level);
+    vec3 down     = ViewPositionAt(uv - vec2(0.0, texelSize.y), level);
+    vec3 up       = ViewPositionAt(uv + vec2(0.0, texelSize.y), level);
+    bool useRight = pixel.x == 0 || (pixel.x < area.x - 1 &&
+                                     abs(right.z - position.z) < abs(position.z - left.z));
+    bool useUp    = pixel.y == 0 || (pixel.y < area.y - 1 &&
+                                     abs(up.z - position.z) < abs(position.z - down.z));
+    vec3 dx       = useRight ? right - position : position - left;
+    vec3 dy       = useUp ? up - position : position - down;
+    vec3 normal = normalize(cross(dx, dy));
+
+    vec3  viewVec      = normalize(-position);
+    float pixelRadius  = min(radius * projectionScale / depth, 0.25 * float(area.y));
+    float minStep      = 1.3 / max(pixelRadius, 1.3);
+    float falloffRange = 0.615 * radius;
+    float falloffMul   = -1.0 / falloffRange;
+    float falloffAdd   = (radius - falloffRange) / falloffRange + 1.0;
+
+    vec2  noisePixel = vec2(pixel) + 5.588238 * float(frame % 64u);
+    float noiseSlice = Noise(noisePixel);
+    float noiseStep  = Noise(noisePixel.yx + vec2(13.0, 7.0));
+
+    float visibility = 0.0;
+    for (int slice = 0; slice < sliceCount; slice++)
+    {
+        float phi       = (float(slice) + noiseSlice) / float(sliceCount) * PI;
+        vec2  direction = vec2(cos(phi), sin(phi));
+
+        // the slice plane holds the view vector and the screen direction, the normal is
+        // projected into it
+        vec3  directionVec     = vec3(direction, 0.0);
+        vec3  orthoDirection   = directionVec - dot(directionVec, viewVec) * viewVec;
+        vec3  axis             = normalize(cross(orthoDirection, viewVec));
+        vec3  projectedNormal  = normal - axis * dot(normal, axis);
+        float projectedLength  = length(projectedNormal);
+        float signNormal       = sign(dot(orthoDirection, projectedNormal));
+        float cosNormal        = clamp(dot(projectedNormal, viewVec) / projectedLength, 0.0, 1.0);
+        float n                = signNormal * acos(cosNormal);
+        float lowHorizonCos0   = cos(n + HALF_PI);
+        float lowHorizonCos1   = cos(n - HALF_PI);
+        float horizonCos0      = lowHorizonCos0;
+        float horizonCos1      = lowHorizonCos1;
+
+        for (int step = 0; step < stepCount; step++)
+        {
+            // quadratic step distribution, more samples close to the pixel
+            float s = (float(step) + fract(noiseStep + float(slice) * 0.618034)) /
+                      float(stepCount);
+            s = s * s + minStep;
+
+            vec2  offset      = round(s * pixelRadius * direction) * texelSize;
+            float sampleLevel = clamp(level + log2(length(offset * vec2(area))) - 3.3,
+                                      level,
+                                      float(PYRAMID_LEVELS - 1));
+            vec2  uv0         = uv + offset;
+            vec2  uv1         = uv - offset;
+            vec3  delta0      = ViewPositionAt(uv0, sampleLevel) - position;
+            vec3  delta1      = ViewPositionAt(uv1, sampleLevel) - position;
+
+            // samples off screen don't occlude
+            float distance0 = max(length(delta0), 1e-5);
+            float distance1 = max(length(delta1), 1e-5);
+            float weight0   = OnScreen(uv0) * clamp(distance0 * falloffMul + falloffAdd, 0.0, 1.0);
+            float weight1   = OnScreen(uv1) * clamp(distance1 * falloffMul + falloffAdd, 0.0, 1.0);
+            float cos0      = mix(lowHorizonCos0, dot(delta0 / distance0, viewVec), weight0);
+            float cos1      = mix(lowHorizonCos1, dot(delta1 / distance1, viewVec), weight1);
+            horizonCos0     = max(horizonCos0, cos0);
+            horizonCos1     = max(horizonCos1, cos1);
+        }
+
+        // horizon angles clamped to the hemisphere around the normal, then the arc integral
+        float h0 = -acos(clamp(horizonCos1, -1.0, 1.0));
+        float h1 = acos(clamp(horizonCos0, -1.0, 1.0));
+        h0       = n + clamp(h0 - n, -HALF_PI, HALF_PI);
+        h1       = n + clamp(h1 - n, -HALF_PI, HALF_PI);
+
+        float arc0 = (cosNormal + 2.0 * h0 * sin(n) - cos(2.0 * h0 - n)) / 4.0;
+        float arc1 = (cosNormal + 2.0 * h1 * sin(n) - cos(2.0 * h1 - n)) / 4.0;
+        visibility += projectedLength * (arc0 + arc1);
+    }
+
+    // not clamped to 1: a single slice overshoots in some directions and undershoots in others,
+    // the estimate only averages out right over the denoise
+    imageStore(occlusionImage, pixel, vec4(max(visibility / float(sliceCount), 0.0)));
+}
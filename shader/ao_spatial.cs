@@ -0,0 +1,39 @@
+#version 460 core
+
+// Spatial denoise of the accumulated ambient occlusion: a 5x5 gaussian whose taps fade out with
+// the relative depth difference to the center, so occlusion doesn't bleed across silhouettes
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D accumulatedTexture; // occlusion and linear depth
+layout(r8, binding = 0) uniform writeonly image2D occlusionImage;
+
+uniform ivec2 area;
+
+#define DEPTH_SHARPNESS 20.0
+
+const float k_gaussian[3] = float[](0.4026, 0.2442, 0.0545);
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, area)))
+        return;
+
+    vec2  center      = texelFetch(accumulatedTexture, pixel, 0).rg;
+    float total       = 0.0;
+    float totalWeight = 0.0;
+    for (int y = -2; y <= 2; y++)
+    {
+        for (int x = -2; x <= 2; x++)
+        {
+            ivec2 texel  = clamp(pixel + ivec2(x, y), ivec2(0), area - 1);
+            vec2  value  = texelFetch(accumulatedTexture, texel, 0).rg;
+            float weight = k_gaussian[abs(x)] * k_gaussian[abs(y)] *
+                           max(0.0, 1.0 - DEPTH_SHARPNESS * abs(value.g - center.g) / center.g);
+            total += value.r * weight;
+            totalWeight += weight;
+        }
+    }
+
+    imageStore(occlusionImage, pixel, vec4(min(total / totalWeight, 1.0)));
+}
@@ -0,0 +1,70 @@
+#version 460 core
+
+// Temporal accumulation of the ambient occlusion. Every pixel is reprojected into the previous
+// frame with its depth; the history is kept where the depth stored with it matches, clamped to
+// the occlusion range around the pixel so moving objects don't leave trails, and blended with the
+// new noisy estimate. The history keeps the linear depth next to the occlusion for the next test
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D occlusionTexture;
+layout(binding = 1) uniform sampler2D depthPyramid;
+layout(binding = 2) uniform sampler2D historyTexture; // occlusion and depth of the last frame
+layout(rg16f, binding = 0) uniform writeonly image2D accumulatedImage;
+
+uniform int   baseLevel;
+uniform ivec2 area;             // texels in use
+uniform vec2  baseArea;         // render size over the level's scale, area rounds it up
+uniform vec2  previousBaseArea; // of the history, the render scale may have changed
+uniform vec2  historySize;    // storage size of the history
+uniform bool  historyValid;
+uniform vec4  unproject;
+uniform float farDepth;
+uniform mat4  inverseView;
+uniform mat4  previousViewProjection;
+
+#define CURRENT_WEIGHT 0.1
+#define DEPTH_TOLERANCE 0.05
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, area)))
+        return;
+
+    float depth     = texelFetch(depthPyramid, pixel, baseLevel).r;
+    float occlusion = texelFetch(occlusionTexture, pixel, 0).r;
+    if (depth >= farDepth || !historyValid)
+    {
+        imageStore(accumulatedImage, pixel, vec4(occlusion, depth, 0.0, 0.0));
+        return;
+    }
+
+    // 3x3 range of the new estimate
+    float low  = occlusion;
+    float high = occlusion;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            ivec2 texel = clamp(pixel + ivec2(x, y), ivec2(0), area - 1);
+            float value = texelFetch(occlusionTexture, texel, 0).r;
+            low  = min(low, value);
+            high = max(high, value);
+        }
+    }
+
+    vec2 ndc      = (vec2(pixel) + 0.5) / baseArea * 2.0 - 1.0;
+    vec3 position = vec3((ndc + unproject.zw) * unproject.xy * depth, -depth);
+    vec4 previous = previousViewProjection * (inverseView * vec4(position, 1.0));
+    vec2 uv       = previous.xy / previous.w * 0.5 + 0.5;
+
+    if (all(greaterThanEqual(uv, vec2(0.0))) && all(lessThanEqual(uv, vec2(1.0))))
+    {
+        vec2 coord   = clamp(uv * previousBaseArea, vec2(0.5), previousBaseArea - 0.5);
+        vec2 history = textureLod(historyTexture, coord / historySize, 0.0).rg;
+        if (abs(history.g - previous.w) < DEPTH_TOLERANCE * previous.w)
+            occlusion = mix(clamp(history.r, low, high), occlusion, CURRENT_WEIGHT);
+    }
+
+    imageStore(accumulatedImage, pixel, vec4(occlusion, depth, 0.0, 0.0));
+}
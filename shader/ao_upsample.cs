@@ -0,0 +1,45 @@
+#version 460 core
+
+// Bilateral upsample of the ambient occlusion to the render resolution. Each pixel blends the
+// four nearest low-resolution texels with their bilinear weights, scaled down by how far their
+// depth is from the pixel's own, so edges stay as sharp as the depth buffer
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D occlusionTexture;
+layout(binding = 1) uniform sampler2D depthPyramid;
+layout(binding = 2) uniform sampler2D depthTexture; // full-resolution depth buffer
+layout(r8, binding = 0) uniform writeonly image2D outputImage;
+
+uniform int   baseLevel;
+uniform ivec2 area;            // render area
+uniform ivec2 lowArea;         // occlusion area
+uniform vec2  projectionDepth; // projection[2][2] and [3][2]
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, area)))
+        return;
+
+    float ndc   = 2.0 * texelFetch(depthTexture, pixel, 0).r - 1.0;
+    float depth = projectionDepth.y / (ndc + projectionDepth.x);
+
+    vec2  position = (vec2(pixel) + 0.5) * exp2(-float(baseLevel + 1)) - 0.5;
+    ivec2 base     = ivec2(floor(position));
+    vec2  f        = position - vec2(base);
+
+    float total       = 0.0;
+    float totalWeight = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 offset     = ivec2(i & 1, i >> 1);
+        ivec2 texel      = clamp(base + offset, ivec2(0), lowArea - 1);
+        vec2  bilinear   = mix(1.0 - f, f, vec2(offset));
+        float texelDepth = texelFetch(depthPyramid, texel, baseLevel).r;
+        float weight     = bilinear.x * bilinear.y / (1e-3 + abs(texelDepth - depth) / depth);
+        total += texelFetch(occlusionTexture, texel, 0).r * weight;
+        totalWeight += weight;
+    }
+
+    imageStore(outputImage, pixel, vec4(total / max(totalWeight, 1e-6)));
+}
@@ -0,0 +1,277 @@
+#version 460 core
+
+// tiled deferred lighting: each 16x16 tile bounds its depth range, culls the point lights against
+// the resulting view-space box once, then every pixel of the tile is shaded by the surviving lights
+#define TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 256
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 color;
+    vec4 attenuation;
+};
+
+layout(std430, binding = 0) readonly buffer PointLights
+{
+    PointLight lights[];
+};
+
+layout(binding = 0) uniform sampler2D gNormal;
+layout(binding = 1) uniform sampler2D gAlbedoSpec;
+layout(binding = 2) uniform sampler2D gDepth;
+layout(binding = 3) uniform sampler2D gOcclusion;
+
+layout(std140, binding = 0) uniform ShadowData
+{
+    mat4 lightSpace[4];
+    mat4 cameraView;
+    vec4 cascadeSplits;  // far distance of each cascade in view space
+    vec4 lightDirection; // xyz direction of the directional light, w cascade count
+    vec4 lightColor;     // rgb diffuse, a specular
+};
+
+layout(binding = 4) uniform sampler2DArrayShadow shadowMap;
+
+struct PointShadow
+{
+    ivec4 atlas; // tier (-1 when unshadowed), cube slot, resolution
+    vec4  depth; // window depth = x - y / major axis distance
+};
+
+layout(std430, binding = 6) readonly buffer PointShadows
+{
+    PointShadow pointShadows[];
+};
+
+layout(binding = 5) uniform samplerCubeArrayShadow pointShadowTier0;
+layout(binding = 6) uniform samplerCubeArrayShadow pointShadowTier1;
+layout(binding = 7) uniform samplerCubeArrayShadow pointShadowTier2;
+layout(binding = 8) uniform samplerCubeArrayShadow pointShadowTier3;
+
+// ambient occlusion of the render area, a 1x1 white texture when it is off
+layout(binding = 9) uniform sampler2D ambientOcclusion;
+
+layout(rgba16f, binding = 0) uniform writeonly image2D litImage;
+
+uniform mat4  view;
+uniform mat4  invView;
+uniform mat4  invProjection;
+uniform uint  lightCount;
+uniform vec3  clearColor;
+uniform ivec2 renderSize; // area of the targets in use, they may be larger
+
+shared uint tileMinDepth;
+shared uint tileMaxDepth;
+shared uint tileLightCount;
+shared uint tileLightIndices[MAX_LIGHTS_PER_TILE];
+
+vec3 decodeOctahedral(vec2 f)
+{
+    vec3  n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+vec3 unproject(vec2 ndc, float depth)
+{
+    vec4 position = invProjection * vec4(ndc, depth * 2.0 - 1.0, 1.0);
+    return position.xyz / position.w;
+}
+
+// 3x3 PCF in the cascade covering the fragment, 1 when lit
+float CalcShadow(vec3 fragPos, vec3 normal)
+{
+    int   cascadeCount = int(lightDirection.w);
+    float depth        = -(cameraView * vec4(fragPos, 1.0)).z;
+    if (cascadeCount == 0 || depth > cascadeSplits[cascadeCount - 1])
+        return 1.0;
+
+    int cascade = 0;
+    while (cascade < cascadeCount - 1 && depth > cascadeSplits[cascade])
+        cascade++;
+
+    // push the lookup along the normal in proportion to the cascade texel size
+    vec4 lightPos = lightSpace[cascade] * vec4(fragPos + normal * 0.02 * float(cascade + 1), 1.0);
+    vec3 coords   = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+
+    vec2  texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float shadow    = 0.0;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            shadow += texture(shadowMap,
+                              vec4(coords.xy + vec2(x, y) * texelSize, float(cascade), coords.z));
+        }
+    }
+    return shadow / 9.0;
+}
+
+vec3 CalcDirLight(vec3 albedo, float specularStrength, vec3 normal, vec3 viewDir, float shadow)
+{
+    vec3 lightDir = normalize(-lightDirection.xyz);
+
+    // diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // specular
+    vec3  halfwayDir = normalize(lightDir + viewDir);
+    float spec       = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+
+    return (albedo * diff + vec3(specularStrength * lightColor.a) * spec) * lightColor.rgb *
+           shadow;
+}
+
+// single filtered tap in the light's cube of the shadow atlas, 1 when lit
+float CalcPointShadow(uint index, vec3 fragPos, vec3 normal)
+{
+    PointShadow shadow = pointShadows[index];
+    if (shadow.atlas.x < 0)
+        return 1.0;
+
+    // push the lookup along the normal by about two cube texels at that distance
+    vec3 fromLight = fragPos - lights[index].positionRadius.xyz;
+    fromLight += normal * 4.0 * length(fromLight) / float(shadow.atlas.z);
+
+    vec3  axis   = abs(fromLight);
+    float depth  = shadow.depth.x - shadow.depth.y / max(axis.x, max(axis.y, axis.z));
+    vec4  coords = vec4(fromLight, float(shadow.atlas.y));
+
+    // the tier is not dynamically uniform, branch instead of indexing a sampler array
+    switch (shadow.atlas.x)
+    {
+    case 0:
+        return texture(pointShadowTier0, coords, depth);
+    case 1:
+        return texture(pointShadowTier1, coords, depth);
+    case 2:
+        return texture(pointShadowTier2, coords, depth);
+    default:
+        return texture(pointShadowTier3, coords, depth);
+    }
+}
+
+vec3 CalcPointLight(uint index, vec3 albedo, float specularStrength, vec3 normal, vec3 fragPos,
+                    vec3 viewDir)
+{
+    PointLight light = lights[index];
+
+    vec3  toLight  = light.positionRadius.xyz - fragPos;
+    float distance = length(toLight);
+    if (distance > light.positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = toLight / distance;
+
+    // diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // specular
+    vec3  halfwayDir = normalize(lightDir + viewDir);
+    float spec       = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+
+    // attenuation, windowed so the light reaches exactly zero at its radius
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+                               light.attenuation.z * distance * distance);
+    float window      = clamp(1.0 - pow(distance / light.positionRadius.w, 4.0), 0.0, 1.0);
+
+    return (albedo * diff + vec3(specularStrength * light.color.a) * spec) * light.color.rgb *
+           attenuation * window * window * CalcPointShadow(index, fragPos, normal);
+}
+
+void main()
+{
+    ivec2 pixel  = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size   = renderSize;
+    bool  inside = all(lessThan(pixel, size));
+
+    if (gl_LocalInvocationIndex == 0)
+    {
+        tileMinDepth   = floatBitsToUint(1.0);
+        tileMaxDepth   = 0;
+        tileLightCount = 0;
+    }
+    barrier();
+
+    // depths are positive so their bit patterns sort like the floats
+    float depth = inside ? texelFetch(gDepth, pixel, 0).r : 1.0;
+    if (depth < 1.0)
+    {
+        atomicMin(tileMinDepth, floatBitsToUint(depth));
+        atomicMax(tileMaxDepth, floatBitsToUint(depth));
+    }
+    barrier();
+
+    float minDepth = uintBitsToFloat(tileMinDepth);
+    float maxDepth = uintBitsToFloat(tileMaxDepth);
+    if (minDepth <= maxDepth)
+    {
+        // view-space box enclosing the tile between its nearest and farthest samples
+        vec2 tileMin = vec2(gl_WorkGroupID.xy * TILE_SIZE) / vec2(size) * 2.0 - 1.0;
+        vec2 tileMax = vec2((gl_WorkGroupID.xy + 1) * TILE_SIZE) / vec2(size) * 2.0 - 1.0;
+
+        vec3 boxMin = vec3(1e30);
+        vec3 boxMax = vec3(-1e30);
+        for (int corner = 0; corner < 8; corner++)
+        {
+            vec2 ndc = vec2((corner & 1) != 0 ? tileMax.x : tileMin.x,
+                            (corner & 2) != 0 ? tileMax.y : tileMin.y);
+            vec3 p   = unproject(ndc, (corner & 4) != 0 ? maxDepth : minDepth);
+            boxMin   = min(boxMin, p);
+            boxMax   = max(boxMax, p);
+        }
+
+        for (uint index = gl_LocalInvocationIndex; index < lightCount;
+             index += TILE_SIZE * TILE_SIZE)
+        {
+            vec3  center  = vec3(view * vec4(lights[index].positionRadius.xyz, 1.0));
+            float radius  = lights[index].positionRadius.w;
+            vec3  closest = clamp(center, boxMin, boxMax);
+            vec3  delta   = center - closest;
+            if (dot(delta, delta) <= radius * radius)
+            {
+                uint slot = atomicAdd(tileLightCount, 1);
+                if (slot < MAX_LIGHTS_PER_TILE)
+                    tileLightIndices[slot] = index;
+            }
+        }
+    }
+    barrier();
+
+    if (!inside)
+        return;
+
+    if (depth >= 1.0)
+    {
+        imageStore(litImage, pixel, vec4(clearColor, 1.0));
+        return;
+    }
+
+    vec2 ndc      = (vec2(pixel) + 0.5) / vec2(size) * 2.0 - 1.0;
+    vec3 fragPos  = vec3(invView * vec4(unproject(ndc, depth), 1.0));
+    vec3 normal   = decodeOctahedral(texelFetch(gNormal, pixel, 0).rg);
+    vec4 material = texelFetch(gAlbedoSpec, pixel, 0);
+    vec3 viewDir  = normalize(invView[3].xyz - fragPos);
+
+    // ambient, darkened by the baked and the screen-space occlusion
+    ivec2 occlusionTexel = min(pixel, textureSize(ambientOcclusion, 0) - 1);
+    float occlusion      = texelFetch(ambientOcclusion, occlusionTexel, 0).r *
+                           texelFetch(gOcclusion, pixel, 0).r;
+    vec3  color          = 0.05 * occlusion * material.rgb;
+    float shadow         = CalcShadow(fragPos, normal);
+    color += CalcDirLight(material.rgb, material.a, normal, viewDir, shadow);
+
+    uint count = min(tileLightCount, uint(MAX_LIGHTS_PER_TILE));
+    for (uint index = 0; index < count; index++)
+    {
+        color += CalcPointLight(tileLightIndices[index], material.rgb, material.a, normal, fragPos,
+                                viewDir);
+    }
+
+    imageStore(litImage, pixel, vec4(color, 1.0));
+}
@@ -0,0 +1,198 @@
+#version 460 core
+
+layout(location = 0) out vec4 FragColor;
+// screen-space motion in uv, only stored when temporal anti-aliasing is on
+layout(location = 1) out vec2 Velocity;
+
+in VS_OUT
+{
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 CurrentPosition;
+    vec4 PreviousPosition;
+    vec2 LightmapTexCoords;
+    float BakedOcclusion;
+    vec3 Tint;
+}
+fs_in;
+
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 color;
+    vec4 attenuation;
+};
+
+layout(std430, binding = 0) readonly buffer PointLights
+{
+    PointLight lights[];
+};
+
+layout(std140, binding = 0) uniform ShadowData
+{
+    mat4 lightSpace[4];
+    mat4 cameraView;
+    vec4 cascadeSplits;  // far distance of each cascade in view space
+    vec4 lightDirection; // xyz direction of the directional light, w cascade count
+    vec4 lightColor;     // rgb diffuse, a specular
+};
+
+layout(binding = 4) uniform sampler2DArrayShadow shadowMap;
+
+struct PointShadow
+{
+    ivec4 atlas; // tier (-1 when unshadowed), cube slot, resolution
+    vec4  depth; // window depth = x - y / major axis distance
+};
+
+layout(std430, binding = 6) readonly buffer PointShadows
+{
+    PointShadow pointShadows[];
+};
+
+layout(binding = 5) uniform samplerCubeArrayShadow pointShadowTier0;
+layout(binding = 6) uniform samplerCubeArrayShadow pointShadowTier1;
+layout(binding = 7) uniform samplerCubeArrayShadow pointShadowTier2;
+layout(binding = 8) uniform samplerCubeArrayShadow pointShadowTier3;
+
+// ambient occlusion of the render area, a 1x1 white texture when it is off
+layout(binding = 9) uniform sampler2D ambientOcclusion;
+// baked occlusion of the static model, a 1x1 white texture when it has no lightmap
+layout(binding = 10) uniform sampler2D bakedLightmap;
+
+uniform sampler2D texture_diffuse1;
+uniform sampler2D texture_specular1;
+uniform bool      hasSpecularMap;
+uniform vec3      viewPos;
+uniform uint      lightCount;
+
+// 3x3 PCF in the cascade covering the fragment, 1 when lit
+float CalcShadow(vec3 fragPos, vec3 normal)
+{
+    int   cascadeCount = int(lightDirection.w);
+    float depth        = -(cameraView * vec4(fragPos, 1.0)).z;
+    if (cascadeCount == 0 || depth > cascadeSplits[cascadeCount - 1])
+        return 1.0;
+
+    int cascade = 0;
+    while (cascade < cascadeCount - 1 && depth > cascadeSplits[cascade])
+        cascade++;
+
+    // push the lookup along the normal in proportion to the cascade texel size
+    vec4 lightPos = lightSpace[cascade] * vec4(fragPos + normal * 0.02 * float(cascade + 1), 1.0);
+    vec3 coords   = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+
+    vec2  texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float shadow    = 0.0;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            shadow += texture(shadowMap,
+                              vec4(coords.xy + vec2(x, y) * texelSize, float(cascade), coords.z));
+        }
+    }
+    return shadow / 9.0;
+}
+
+vec3 CalcDirLight(vec3 albedo, float specularStrength, vec3 normal, vec3 viewDir, float shadow)
+{
+    vec3 lightDir = normalize(-lightDirection.xyz);
+
+    // diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // specular
+    vec3  halfwayDir = normalize(lightDir + viewDir);
+    float spec       = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+
+    return (albedo * diff + vec3(specularStrength * lightColor.a) * spec) * lightColor.rgb *
+           shadow;
+}
+
+// single filtered tap in the light's cube of the shadow atlas, 1 when lit
+float CalcPointShadow(uint index, vec3 fragPos, vec3 normal)
+{
+    PointShadow shadow = pointShadows[index];
+    if (shadow.atlas.x < 0)
+        return 1.0;
+
+    // push the lookup along the normal by about two cube texels at that distance
+    vec3 fromLight = fragPos - lights[index].positionRadius.xyz;
+    fromLight += normal * 4.0 * length(fromLight) / float(shadow.atlas.z);
+
+    vec3  axis   = abs(fromLight);
+    float depth  = shadow.depth.x - shadow.depth.y / max(axis.x, max(axis.y, axis.z));
+    vec4  coords = vec4(fromLight, float(shadow.atlas.y));
+
+    // the tier is not dynamically uniform, branch instead of indexing a sampler array
+    switch (shadow.atlas.x)
+    {
+    case 0:
+        return texture(pointShadowTier0, coords, depth);
+    case 1:
+        return texture(pointShadowTier1, coords, depth);
+    case 2:
+        return texture(pointShadowTier2, coords, depth);
+    default:
+        return texture(pointShadowTier3, coords, depth);
+    }
+}
+
+vec3 CalcPointLight(uint index, vec3 albedo, float specularStrength, vec3 normal, vec3 fragPos,
+                    vec3 viewDir)
+{
+    PointLight light = lights[index];
+
+    vec3  toLight  = light.positionRadius.xyz - fragPos;
+    float distance = length(toLight);
+    if (distance > light.positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = toLight / distance;
+
+    // diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // specular
+    vec3  halfwayDir = normalize(lightDir + viewDir);
+    float spec       = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+
+    // attenuation, windowed so the light reaches exactly zero at its radius
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+                               light.attenuation.z * distance * distance);
+    float window      = clamp(1.0 - pow(distance / light.positionRadius.w, 4.0), 0.0, 1.0);
+
+    return (albedo * diff + vec3(specularStrength * light.color.a) * spec) * light.color.rgb *
+           attenuation * window * window * CalcPointShadow(index, fragPos, normal);
+}
+
+void main()
+{
+    vec3  albedo           = texture(texture_diffuse1, fs_in.TexCoords).rgb * fs_in.Tint;
+    float specularStrength = hasSpecularMap ? texture(texture_specular1, fs_in.TexCoords).r : 0.3;
+
+    vec3 normal  = normalize(fs_in.Normal);
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+
+    // ambient, darkened by the baked and the screen-space occlusion
+    float bakedOcclusion =
+        fs_in.BakedOcclusion * texture(bakedLightmap, fs_in.LightmapTexCoords).r;
+    ivec2 occlusionTexel = min(ivec2(gl_FragCoord.xy), textureSize(ambientOcclusion, 0) - 1);
+    float occlusion      = texelFetch(ambientOcclusion, occlusionTexel, 0).r * bakedOcclusion;
+    vec3  color          = 0.05 * occlusion * albedo;
+    float shadow         = CalcShadow(fs_in.FragPos, normal);
+    color += CalcDirLight(albedo, specularStrength, normal, viewDir, shadow);
+
+    for (uint index = 0; index < lightCount; index++)
+    {
+        color += CalcPointLight(index, albedo, specularStrength, normal, fs_in.FragPos, viewDir);
+    }
+
+    FragColor = vec4(color, 1.0);
+
+    vec2 current  = fs_in.CurrentPosition.xy / fs_in.CurrentPosition.w;
+    vec2 previous = fs_in.PreviousPosition.xy / fs_in.PreviousPosition.w;
+    Velocity      = 0.5 * (current - previous);
+}
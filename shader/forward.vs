@@ -0,0 +1,206 @@
+#version 460 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+layout(location = 5) in ivec4 aBoneIds;
+layout(location = 6) in vec4 aBoneWeights;
+layout(location = 7) in vec2 aLightmapTexCoords;
+layout(location = 8) in float aOcclusion;
+
+out VS_OUT
+{
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 CurrentPosition; // clip space without jitter
+    vec4 PreviousPosition;
+    vec2 LightmapTexCoords;
+    float BakedOcclusion;
+    vec3 Tint;
+}
+vs_out;
+
+// matches the depth prepass exactly
+invariant gl_Position;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+// for the velocity buffer, both without the projection jitter
+uniform mat4 currentViewProjection;
+uniform mat4 previousViewProjection;
+uniform mat4 previousModel;
+
+// Instanced characters, skinned when jointCount isn't 0: jointCount joint matrices per instance,
+// each as the three rows of its affine transform, and a model matrix per instance
+layout(std430, binding = 7) readonly buffer JointPalettes
+{
+    vec4 palettes[];
+};
+layout(std430, binding = 8) readonly buffer PreviousJointPalettes
+{
+    vec4 previousPalettes[];
+};
+layout(std430, binding = 9) readonly buffer CharacterTransforms
+{
+    mat4 characterModels[];
+};
+
+uniform uint jointCount;
+
+// Streamed instances when streamedInstances is set: the draw covers a list of the visible ones,
+// indexed from gl_BaseInstance, and each has the three rows of its affine model matrix and a tint,
+// this frame and the last
+struct Instance
+{
+    vec4 rows[3];
+    vec4 custom;
+};
+layout(std430, binding = 16) readonly buffer Instances
+{
+    Instance instances[];
+};
+layout(std430, binding = 17) readonly buffer PreviousInstances
+{
+    Instance previousInstances[];
+};
+layout(std430, binding = 18) readonly buffer VisibleInstances
+{
+    uint visibleInstances[];
+};
+
+uniform bool streamedInstances;
+
+mat4 InstanceModel(Instance instance)
+{
+    return transpose(
+        mat4(instance.rows[0], instance.rows[1], instance.rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+// Baked vertex animation of streamed instances when vertexAnimation is set, their custom data
+// holds the clip, the time offset and the speed instead of a tint. A frame is a run of a texel
+// per vertex wrapped over animationRowsPerFrame rows, the frames of a clip follow each other
+struct VertexAnimationClip
+{
+    uint  firstFrame;
+    uint  frameCount;
+    float duration;
+    float padding;
+};
+layout(std430, binding = 19) readonly buffer VertexAnimation
+{
+    vec3                animationBoundsMin;
+    uint                animationRowsPerFrame;
+    vec3                animationBoundsExtent;
+    uint                animationWidth;
+    VertexAnimationClip animationClips[];
+};
+layout(binding = 11) uniform sampler2D animationPositions; // unorm over the bounds
+layout(binding = 12) uniform sampler2D animationNormals;
+
+uniform bool  vertexAnimation;
+uniform uint  animationVertexOffset; // of the drawn mesh
+uniform float animationTime;
+uniform float previousAnimationTime;
+
+ivec2 AnimationTexel(uint frame)
+{
+    uint vertex = animationVertexOffset + uint(gl_VertexID);
+    return ivec2(vertex % animationWidth, frame * animationRowsPerFrame + vertex / animationWidth);
+}
+
+// the vertex in the instance's clip at time, interpolated between the two frames around it
+void AnimateVertex(vec4 custom, float time, out vec4 position, out vec3 normal)
+{
+    VertexAnimationClip clip = animationClips[uint(custom.x)];
+
+    float frame  = fract((time * custom.z + custom.y) / clip.duration) * float(clip.frameCount);
+    uint  first  = min(uint(frame), clip.frameCount - 1u);
+    uint  second = (first + 1u) % clip.frameCount;
+    float weight = frame - float(first);
+    ivec2 a      = AnimationTexel(clip.firstFrame + first);
+    ivec2 b      = AnimationTexel(clip.firstFrame + second);
+
+    vec3 unit = mix(texelFetch(animationPositions, a, 0).xyz,
+                    texelFetch(animationPositions, b, 0).xyz,
+                    weight);
+    position  = vec4(animationBoundsMin + unit * animationBoundsExtent, 1.0);
+    normal    = normalize(mix(
+        texelFetch(animationNormals, a, 0).xyz, texelFetch(animationNormals, b, 0).xyz, weight));
+}
+
+// blended joint matrix of the vertex, vertices no joint moves keep their bind position
+mat3x4 SkinMatrix(bool previous)
+{
+    uint   base   = uint(gl_InstanceID) * jointCount;
+    mat3x4 matrix = mat3x4(0.0);
+    float  total  = 0.0;
+    for (int influence = 0; influence < 4; influence++)
+    {
+        float weight = aBoneWeights[influence];
+        if (weight <= 0.0)
+            continue;
+
+        uint joint = (base + uint(aBoneIds[influence])) * 3u;
+        for (uint row = 0u; row < 3u; row++)
+        {
+            vec4 jointRow = previous ? previousPalettes[joint + row] : palettes[joint + row];
+            matrix[row] += weight * jointRow;
+        }
+        total += weight;
+    }
+    if (total == 0.0)
+        return mat3x4(vec4(1.0, 0.0, 0.0, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0));
+    return matrix;
+}
+
+void main()
+{
+    vec4 position         = vec4(aPos, 1.0);
+    vec3 normal           = aNormal;
+    vec4 previousPosition = position;
+    mat4 currentModel     = model;
+    mat4 lastModel        = previousModel;
+    vec3 tint             = vec3(1.0);
+    if (jointCount > 0u)
+    {
+        mat3x4 skin      = SkinMatrix(false);
+        position         = vec4(position * skin, 1.0);
+        normal           = vec4(aNormal, 0.0) * skin;
+        previousPosition = vec4(previousPosition * SkinMatrix(true), 1.0);
+        currentModel     = characterModels[gl_InstanceID];
+        lastModel        = currentModel;
+    }
+    else if (streamedInstances)
+    {
+        uint instance = visibleInstances[gl_BaseInstance + gl_InstanceID];
+        currentModel  = InstanceModel(instances[instance]);
+        lastModel     = InstanceModel(previousInstances[instance]);
+        tint          = instances[instance].custom.rgb;
+        if (vertexAnimation)
+        {
+            vec3 previousNormal;
+            AnimateVertex(instances[instance].custom, animationTime, position, normal);
+            AnimateVertex(instances[instance].custom,
+                          previousAnimationTime,
+                          previousPosition,
+                          previousNormal);
+            tint = vec3(1.0);
+        }
+    }
+
+    vs_out.FragPos   = vec3(currentModel * position);
+    vs_out.Normal    = mat3(transpose(inverse(currentModel))) * normal;
+    vs_out.TexCoords = aTexCoords;
+
+    vs_out.LightmapTexCoords = aLightmapTexCoords;
+    vs_out.BakedOcclusion    = aOcclusion;
+    vs_out.Tint              = tint;
+
+    vs_out.CurrentPosition  = currentViewProjection * vec4(vs_out.FragPos, 1.0);
+    vs_out.PreviousPosition = previousViewProjection * lastModel * previousPosition;
+
+    gl_Position = projection * view * vec4(vs_out.FragPos, 1.0);
+}
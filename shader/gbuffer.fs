@@ -0,0 +1,46 @@
+#version 460 core
+
+// compact g-buffer: 4 bytes of octahedral normal, 4 bytes of albedo/specular, 1 byte of baked
+// occlusion, position is reconstructed from the depth buffer
+layout(location = 0) out vec2 gNormal;
+layout(location = 1) out vec4 gAlbedoSpec;
+layout(location = 2) out float gOcclusion;
+
+in VS_OUT
+{
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec2 LightmapTexCoords;
+    float BakedOcclusion;
+    vec3 Tint;
+}
+fs_in;
+
+uniform sampler2D texture_diffuse1;
+uniform sampler2D texture_specular1;
+uniform bool      hasSpecularMap;
+
+// baked occlusion of the static model, a 1x1 white texture when it has no lightmap
+layout(binding = 10) uniform sampler2D bakedLightmap;
+
+vec2 octWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+vec2 encodeOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    return n.z >= 0.0 ? n.xy : octWrap(n.xy);
+}
+
+void main()
+{
+    gNormal = encodeOctahedral(normalize(fs_in.Normal));
+
+    gAlbedoSpec.rgb = texture(texture_diffuse1, fs_in.TexCoords).rgb * fs_in.Tint;
+    gAlbedoSpec.a   = hasSpecularMap ? texture(texture_specular1, fs_in.TexCoords).r : 0.3;
+
+    gOcclusion = fs_in.BakedOcclusion * texture(bakedLightmap, fs_in.LightmapTexCoords).r;
+}
@@ -0,0 +1,166 @@
+#version 460 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+layout(location = 5) in ivec4 aBoneIds;
+layout(location = 6) in vec4 aBoneWeights;
+layout(location = 7) in vec2 aLightmapTexCoords;
+layout(location = 8) in float aOcclusion;
+
+out VS_OUT
+{
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec2 LightmapTexCoords;
+    float BakedOcclusion;
+    vec3 Tint;
+}
+vs_out;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+// skinned instances as in forward.vs
+layout(std430, binding = 7) readonly buffer JointPalettes
+{
+    vec4 palettes[];
+};
+layout(std430, binding = 9) readonly buffer CharacterTransforms
+{
+    mat4 characterModels[];
+};
+
+uniform uint jointCount;
+
+// streamed instances and their vertex animation as in forward.vs
+struct Instance
+{
+    vec4 rows[3];
+    vec4 custom;
+};
+layout(std430, binding = 16) readonly buffer Instances
+{
+    Instance instances[];
+};
+layout(std430, binding = 18) readonly buffer VisibleInstances
+{
+    uint visibleInstances[];
+};
+
+uniform bool streamedInstances;
+
+mat4 InstanceModel(Instance instance)
+{
+    return transpose(
+        mat4(instance.rows[0], instance.rows[1], instance.rows[2], vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+struct VertexAnimationClip
+{
+    uint  firstFrame;
+    uint  frameCount;
+    float duration;
+    float padding;
+};
+layout(std430, binding = 19) readonly buffer VertexAnimation
+{
+    vec3                animationBoundsMin;
+    uint                animationRowsPerFrame;
+    vec3                animationBoundsExtent;
+    uint                animationWidth;
+    VertexAnimationClip animationClips[];
+};
+layout(binding = 11) uniform sampler2D animationPositions; // unorm over the bounds
+layout(binding = 12) uniform sampler2D animationNormals;
+
+uniform bool  vertexAnimation;
+uniform uint  animationVertexOffset; // of the drawn mesh
+uniform float animationTime;
+
+ivec2 AnimationTexel(uint frame)
+{
+    uint vertex = animationVertexOffset + uint(gl_VertexID);
+    return ivec2(vertex % animationWidth, frame * animationRowsPerFrame + vertex / animationWidth);
+}
+
+// the vertex in the instance's clip at time, interpolated between the two frames around it
+void AnimateVertex(vec4 custom, float time, out vec4 position, out vec3 normal)
+{
+    VertexAnimationClip clip = animationClips[uint(custom.x)];
+
+    float frame  = fract((time * custom.z + custom.y) / clip.duration) * float(clip.frameCount);
+    uint  first  = min(uint(frame), clip.frameCount - 1u);
+    uint  second = (first + 1u) % clip.frameCount;
+    float weight = frame - float(first);
+    ivec2 a      = AnimationTexel(clip.firstFrame + first);
+    ivec2 b      = AnimationTexel(clip.firstFrame + second);
+
+    vec3 unit = mix(texelFetch(animationPositions, a, 0).xyz,
+                    texelFetch(animationPositions, b, 0).xyz,
+                    weight);
+    position  = vec4(animationBoundsMin + unit * animationBoundsExtent, 1.0);
+    normal    = normalize(mix(
+        texelFetch(animationNormals, a, 0).xyz, texelFetch(animationNormals, b, 0).xyz, weight));
+}
+
+mat3x4 SkinMatrix()
+{
+    uint   base   = uint(gl_InstanceID) * jointCount;
+    mat3x4 matrix = mat3x4(0.0);
+    float  total  = 0.0;
+    for (int influence = 0; influence < 4; influence++)
+    {
+        float weight = aBoneWeights[influence];
+        if (weight <= 0.0)
+            continue;
+
+        uint joint = (base + uint(aBoneIds[influence])) * 3u;
+        for (uint row = 0u; row < 3u; row++)
+        {
+            matrix[row] += weight * palettes[joint + row];
+        }
+        total += weight;
+    }
+    if (total == 0.0)
+        return mat3x4(vec4(1.0, 0.0, 0.0, 0.0), vec4(0.0, 1.0, 0.0, 0.0), vec4(0.0, 0.0, 1.0, 0.0));
+    return matrix;
+}
+
+void main()
+{
+    vec4 position     = vec4(aPos, 1.0);
+    vec3 normal       = aNormal;
+    mat4 currentModel = model;
+    vec3 tint         = vec3(1.0);
+    if (jointCount > 0u)
+    {
+        mat3x4 skin  = SkinMatrix();
+        position     = vec4(position * skin, 1.0);
+        normal       = vec4(aNormal, 0.0) * skin;
+        currentModel = characterModels[gl_InstanceID];
+    }
+    else if (streamedInstances)
+    {
+        Instance instance = instances[visibleInstances[gl_BaseInstance + gl_InstanceID]];
+        currentModel      = InstanceModel(instance);
+        tint              = instance.custom.rgb;
+        if (vertexAnimation)
+        {
+            AnimateVertex(instance.custom, animationTime, position, normal);
+            tint = vec3(1.0);
+        }
+    }
+
+    vs_out.FragPos   = vec3(currentModel * position);
+    vs_out.Normal    = mat3(transpose(inverse(currentModel))) * normal;
+    vs_out.TexCoords = aTexCoords;
+
+    vs_out.LightmapTexCoords = aLightmapTexCoords;
+    vs_out.BakedOcclusion    = aOcclusion;
+    vs_out.Tint              = tint;
+
+    gl_Position = projection * view * vec4(vs_out.FragPos, 1.0);
+}
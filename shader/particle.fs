@@ -0,0 +1,14 @@
+#version 460 core
+out vec4 FragColor;
+
+in vec2 fCorner;
+in vec4 fColor;
+
+void main()
+{
+    // round particles with a soft edge
+    float alpha = fColor.a * smoothstep(1.0, 0.5, length(fCorner));
+    if (alpha <= 0.0)
+        discard;
+    FragColor = vec4(fColor.rgb, alpha);
+}
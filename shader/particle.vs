@@ -0,0 +1,42 @@
+#version 460 core
+
+// camera-facing quads of the sorted draw list, the vertices come from gl_VertexID
+struct Particle
+{
+    vec4 positionAge;
+    vec4 velocityLifetime;
+};
+
+layout(std430, binding = 10) readonly buffer Particles
+{
+    Particle particles[];
+};
+
+layout(std430, binding = 14) readonly buffer DrawList
+{
+    uvec2 drawList[];
+};
+
+uniform mat4  view;
+uniform mat4  projection;
+uniform float particleSize;
+
+out vec2 fCorner;
+out vec4 fColor;
+
+const vec2 k_corners[6] =
+    vec2[](vec2(-1, -1), vec2(1, -1), vec2(1, 1), vec2(-1, -1), vec2(1, 1), vec2(-1, 1));
+
+void main()
+{
+    Particle particle = particles[drawList[gl_InstanceID].y];
+    fCorner           = k_corners[gl_VertexID];
+
+    vec4 position = view * vec4(particle.positionAge.xyz, 1.0);
+    position.xy += fCorner * particleSize;
+    gl_Position = projection * position;
+
+    // hot sparks that cool down and fade out, bright enough for the bloom
+    float life = particle.positionAge.w / particle.velocityLifetime.w;
+    fColor     = vec4(mix(vec3(8.0, 5.0, 1.5), vec3(1.0, 0.2, 0.05), life), 1.0 - life);
+}
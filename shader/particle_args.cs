@@ -0,0 +1,54 @@
+#version 460 core
+
+// Turns the particle counters into the sizes of the indirect dispatches that follow, so the CPU
+// never reads them back. Before the emission it clamps the requested particles to the dead ones
+// and resets the per-frame counters, after the simulation it makes the survivors the alive
+// particles and sizes the sort of the visible ones
+layout(local_size_x = 1) in;
+
+#define GROUP_SIZE 256
+#define SORT_BLOCK 1024
+
+layout(std430, binding = 15) buffer Counters
+{
+    uint drawArgs[4]; // vertices, instances, first vertex, base instance
+    uint emitArgs[3];
+    uint simulateArgs[3];
+    uint sortArgs[3];
+    uint aliveCount;
+    uint nextAliveCount;
+    uint deadCount;
+    uint emitCount;
+    uint sortSize;
+    uint boundsMin[3];
+    uint boundsMax[3];
+};
+
+uniform bool afterSimulation;
+uniform uint requestedCount;
+
+void main()
+{
+    if (!afterSimulation)
+    {
+        emitCount       = min(requestedCount, deadCount);
+        emitArgs[0]     = (emitCount + GROUP_SIZE - 1) / GROUP_SIZE;
+        simulateArgs[0] = (aliveCount + emitCount + GROUP_SIZE - 1) / GROUP_SIZE;
+        nextAliveCount  = 0;
+        drawArgs[1]     = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            boundsMin[axis] = 0xffffffffu;
+            boundsMax[axis] = 0u;
+        }
+    }
+    else
+    {
+        aliveCount = nextAliveCount;
+
+        // the sort works on whole blocks of a power of two
+        uint visible = drawArgs[1];
+        sortSize     = visible > SORT_BLOCK ? 2u << findMSB(visible - 1) : SORT_BLOCK;
+        sortArgs[0]  = sortSize / SORT_BLOCK;
+    }
+}
@@ -0,0 +1,90 @@
+#version 460 core
+
+// Spawns the particles of the frame: each thread takes a particle off the dead list, starts it
+// somewhere in the emitter sphere with a random velocity and lifetime, and appends it to the alive
+// list the simulation runs over next
+layout(local_size_x = 256) in;
+
+struct Particle
+{
+    vec4 positionAge;      // age in seconds
+    vec4 velocityLifetime; // lifetime in seconds
+};
+
+layout(std430, binding = 10) writeonly buffer Particles
+{
+    Particle particles[];
+};
+
+layout(std430, binding = 11) readonly buffer DeadList
+{
+    uint deadList[];
+};
+
+layout(std430, binding = 12) writeonly buffer AliveList
+{
+    uint aliveList[];
+};
+
+layout(std430, binding = 15) buffer Counters
+{
+    uint drawArgs[4];
+    uint emitArgs[3];
+    uint simulateArgs[3];
+    uint sortArgs[3];
+    uint aliveCount;
+    uint nextAliveCount;
+    uint deadCount;
+    uint emitCount;
+    uint sortSize;
+    uint boundsMin[3];
+    uint boundsMax[3];
+};
+
+uniform vec3  emitterPosition;
+uniform float emitterRadius;
+uniform vec3  emitterVelocity;
+uniform float spread;
+uniform vec2  lifetimeRange;
+uniform uint  seed; // changes every frame
+
+#define PI 3.14159265
+
+uint hash(uint value)
+{
+    uint state = value * 747796405u + 2891336453u;
+    uint word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float random(inout uint state)
+{
+    state = hash(state);
+    return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+vec3 randomDirection(inout uint state)
+{
+    float z   = random(state) * 2.0 - 1.0;
+    float phi = random(state) * 2.0 * PI;
+    return vec3(sqrt(1.0 - z * z) * vec2(cos(phi), sin(phi)), z);
+}
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= emitCount)
+        return;
+
+    // the args pass clamped the emission to the dead particles, the list can't run dry
+    uint index = deadList[atomicAdd(deadCount, 0xffffffffu) - 1u];
+
+    uint  state    = hash(id ^ hash(seed));
+    vec3  position = emitterPosition +
+                    randomDirection(state) * emitterRadius * pow(random(state), 1.0 / 3.0);
+    vec3  velocity = emitterVelocity + randomDirection(state) * spread * random(state);
+    float lifetime = mix(lifetimeRange.x, lifetimeRange.y, random(state));
+
+    particles[index] = Particle(vec4(position, 0.0), vec4(velocity, lifetime));
+    aliveList[atomicAdd(aliveCount, 1u)] = index;
+}
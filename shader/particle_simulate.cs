@@ -0,0 +1,139 @@
+#version 460 core
+
+// Ages and integrates every alive particle. Expired ones go back to the dead list, survivors are
+// appended to the next alive list, grow the bounds, and when they are in the view frustum are
+// appended to the draw list with a key that sorts them back to front
+layout(local_size_x = 256) in;
+
+struct Particle
+{
+    vec4 positionAge;
+    vec4 velocityLifetime;
+};
+
+layout(std430, binding = 10) buffer Particles
+{
+    Particle particles[];
+};
+
+layout(std430, binding = 11) writeonly buffer DeadList
+{
+    uint deadList[];
+};
+
+layout(std430, binding = 12) readonly buffer AliveList
+{
+    uint aliveList[];
+};
+
+layout(std430, binding = 13) writeonly buffer NextAliveList
+{
+    uint nextAliveList[];
+};
+
+// distance key and particle index
+layout(std430, binding = 14) writeonly buffer DrawList
+{
+    uvec2 drawList[];
+};
+
+layout(std430, binding = 15) buffer Counters
+{
+    uint drawArgs[4];
+    uint emitArgs[3];
+    uint simulateArgs[3];
+    uint sortArgs[3];
+    uint aliveCount;
+    uint nextAliveCount;
+    uint deadCount;
+    uint emitCount;
+    uint sortSize;
+    uint boundsMin[3];
+    uint boundsMax[3];
+};
+
+uniform float deltaTime;
+uniform vec3  gravity;
+uniform float drag;        // fraction of the velocity lost per second
+uniform float ground;      // height of the plane particles bounce off
+uniform float restitution; // of the vertical velocity at a bounce
+uniform float friction;    // of the horizontal velocity at a bounce
+uniform vec4  frustumPlanes[6];
+uniform vec3  cameraPosition;
+uniform float particleSize;
+
+// the bounds of the group, merged into the global ones once
+shared uint groupMin[3];
+shared uint groupMax[3];
+
+// floats as integers that compare in the same order
+uint orderedBits(float value)
+{
+    uint bits = floatBitsToUint(value);
+    return (bits & 0x80000000u) != 0u ? ~bits : bits | 0x80000000u;
+}
+
+void main()
+{
+    if (gl_LocalInvocationIndex < 3)
+    {
+        groupMin[gl_LocalInvocationIndex] = 0xffffffffu;
+        groupMax[gl_LocalInvocationIndex] = 0u;
+    }
+    barrier();
+
+    uint id = gl_GlobalInvocationID.x;
+    if (id < aliveCount)
+    {
+        uint     index    = aliveList[id];
+        Particle particle = particles[index];
+        float    age      = particle.positionAge.w + deltaTime;
+        if (age >= particle.velocityLifetime.w)
+        {
+            deadList[atomicAdd(deadCount, 1u)] = index;
+        }
+        else
+        {
+            vec3 velocity = particle.velocityLifetime.xyz + gravity * deltaTime;
+            velocity *= max(1.0 - drag * deltaTime, 0.0);
+            vec3 position = particle.positionAge.xyz + velocity * deltaTime;
+            if (position.y < ground)
+            {
+                position.y = ground;
+                velocity.y = abs(velocity.y) * restitution;
+                velocity.xz *= friction;
+            }
+
+            particles[index].positionAge      = vec4(position, age);
+            particles[index].velocityLifetime = vec4(velocity, particle.velocityLifetime.w);
+            nextAliveList[atomicAdd(nextAliveCount, 1u)] = index;
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                atomicMin(groupMin[axis], orderedBits(position[axis]));
+                atomicMax(groupMax[axis], orderedBits(position[axis]));
+            }
+
+            bool visible = true;
+            for (int plane = 0; plane < 6; plane++)
+            {
+                vec4 frustumPlane = frustumPlanes[plane];
+                if (dot(frustumPlane.xyz, position) + frustumPlane.w < -particleSize)
+                    visible = false;
+            }
+            if (visible)
+            {
+                // the largest distance gets the smallest key, never the empty key of the sort
+                float distance = max(length(position - cameraPosition), 1e-6);
+                drawList[atomicAdd(drawArgs[1], 1u)] = uvec2(~floatBitsToUint(distance), index);
+            }
+        }
+    }
+    barrier();
+
+    if (gl_LocalInvocationIndex < 3 && groupMin[gl_LocalInvocationIndex] != 0xffffffffu)
+    {
+        atomicMin(boundsMin[gl_LocalInvocationIndex], groupMin[gl_LocalInvocationIndex]);
+        atomicMax(boundsMax[gl_LocalInvocationIndex], groupMax[gl_LocalInvocationIndex]);
+    }
+}
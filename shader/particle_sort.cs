@@ -0,0 +1,106 @@
+#version 460 core
+
+// Bitonic sort of the draw list by key, over the visible particles rounded up to a power of two
+// no smaller than a block. The presort sorts every block of SORT_BLOCK keys in shared memory and
+// pads the list past the visible particles with the empty key, which sorts last. Each longer
+// sequence is then merged by global steps while the compared keys are a block or more apart, and
+// by one shared memory pass for the steps within a block
+layout(local_size_x = 512) in;
+
+#define SORT_BLOCK 1024
+#define EMPTY_KEY 0xffffffffu
+
+#define STAGE_PRESORT 0
+#define STAGE_GLOBAL 1
+#define STAGE_LOCAL 2
+
+layout(std430, binding = 14) buffer DrawList
+{
+    uvec2 drawList[];
+};
+
+layout(std430, binding = 15) readonly buffer Counters
+{
+    uint drawArgs[4];
+    uint emitArgs[3];
+    uint simulateArgs[3];
+    uint sortArgs[3];
+    uint aliveCount;
+    uint nextAliveCount;
+    uint deadCount;
+    uint emitCount;
+    uint sortSize;
+    uint boundsMin[3];
+    uint boundsMax[3];
+};
+
+uniform int  stage;
+uniform uint sequenceSize; // length of the sequences being merged
+uniform uint stride;       // distance of the compared keys, for the global steps
+
+shared uvec2 block[SORT_BLOCK];
+
+// the lower of the two keys goes first in ascending sequences
+bool outOfOrder(uvec2 low, uvec2 high, bool ascending)
+{
+    return ascending ? low.x > high.x : low.x < high.x;
+}
+
+void main()
+{
+    uint thread = gl_LocalInvocationID.x;
+    if (stage == STAGE_GLOBAL)
+    {
+        uint id   = gl_GlobalInvocationID.x;
+        uint low  = (id / stride) * 2u * stride + id % stride;
+        uint high = low + stride;
+        // past the sorted size is all empty keys, which sequences longer than it already end in
+        if (high >= sortSize)
+            return;
+
+        uvec2 a = drawList[low];
+        uvec2 b = drawList[high];
+        if (outOfOrder(a, b, (low & sequenceSize) == 0u))
+        {
+            drawList[low]  = b;
+            drawList[high] = a;
+        }
+        return;
+    }
+
+    uint base = gl_WorkGroupID.x * SORT_BLOCK;
+    for (uint offset = thread; offset < SORT_BLOCK; offset += gl_WorkGroupSize.x)
+    {
+        uint index = base + offset;
+        if (stage == STAGE_PRESORT)
+            block[offset] = index < drawArgs[1] ? drawList[index] : uvec2(EMPTY_KEY, 0u);
+        else
+            block[offset] = drawList[index];
+    }
+    barrier();
+
+    uint firstSequence = stage == STAGE_PRESORT ? 2u : sequenceSize;
+    uint lastSequence  = stage == STAGE_PRESORT ? SORT_BLOCK : sequenceSize;
+    for (uint sequence = firstSequence; sequence <= lastSequence; sequence *= 2u)
+    {
+        for (uint distance = min(sequence, SORT_BLOCK) / 2u; distance > 0u; distance /= 2u)
+        {
+            uint low  = (thread / distance) * 2u * distance + thread % distance;
+            uint high = low + distance;
+
+            uvec2 a = block[low];
+            uvec2 b = block[high];
+            if (outOfOrder(a, b, ((base + low) & sequence) == 0u))
+            {
+                block[low]  = b;
+                block[high] = a;
+            }
+            barrier();
+        }
+    }
+
+    for (uint offset = thread; offset < SORT_BLOCK; offset += gl_WorkGroupSize.x)
+    {
+        drawList[base + offset] = block[offset];
+    }
+}
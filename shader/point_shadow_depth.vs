@@ -0,0 +1,20 @@
+#version 460 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 faceMatrices[6];
+uniform mat4 model;
+uniform int  faceOffset;
+uniform int  baseLayer;
+
+// one instance per cube face, routed to its layer of the cube map array. Without the extension
+// the faces are drawn one at a time into a single attached layer and faceOffset picks the face
+void main()
+{
+    int face    = faceOffset + gl_InstanceID;
+    gl_Position = faceMatrices[face] * model * vec4(aPos, 1.0);
+#ifdef GL_ARB_shader_viewport_layer_array
+    gl_Layer = baseLayer + face;
+#endif
+}
@@ -0,0 +1,131 @@
+#version 460 core
+
+// Single-pass downsample of the HDR scene into the whole bloom mip chain, building the luminance
+// histogram of the auto-exposure from the same texels so the scene is read once for both. Every
+// workgroup reduces a 64x64 tile of the first mip on its own: each thread keeps its 4x4 block of
+// mip 0 in registers down to its texel of mip 2, the last levels go through shared memory
+layout(local_size_x = 16, local_size_y = 16) in;
+
+#define MIP_COUNT 6
+#define BINS 256
+#define MIN_LOG_LUMINANCE -10.0
+#define LOG_LUMINANCE_RANGE 16.0
+
+// only the bottom-left renderSize texels of the scene hold the image
+layout(binding = 0) uniform sampler2D sceneTexture;
+
+layout(r11f_g11f_b10f, binding = 0) uniform writeonly image2D bloomMips[MIP_COUNT];
+
+layout(std430, binding = 0) buffer Histogram
+{
+    uint bins[BINS];
+};
+
+uniform vec2  sceneSize;  // storage size of the scene
+uniform vec2  renderSize;
+uniform ivec2 bloomSize;  // area of mip 0 in use, half the render size
+
+shared uint localBins[BINS];
+shared vec3 tile[16][16];
+
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// bin 0 holds the black pixels, the others split the log luminance range evenly
+uint LuminanceBin(float luminance)
+{
+    if (luminance < exp2(MIN_LOG_LUMINANCE))
+        return 0;
+    float t = clamp((log2(luminance) - MIN_LOG_LUMINANCE) / LOG_LUMINANCE_RANGE, 0.0, 1.0);
+    return 1 + uint(t * float(BINS - 2));
+}
+
+vec3 Tap(vec2 position)
+{
+    position = clamp(position, vec2(0.5), renderSize - 0.5);
+    return textureLod(sceneTexture, position / sceneSize, 0.0).rgb;
+}
+
+void main()
+{
+    uint index       = gl_LocalInvocationIndex;
+    localBins[index] = 0;
+    barrier();
+
+    ivec2 thread = ivec2(gl_LocalInvocationID.xy);
+    ivec2 base   = ivec2(gl_WorkGroupID.xy) * 64 + thread * 4;
+    vec2  scale  = renderSize / vec2(bloomSize);
+
+    // mip 0: four bilinear taps over the 4x4 scene pixels of each texel. They are averaged with
+    // inverse luminance weights so a lone very bright pixel doesn't bloom into a flickering square
+    vec3 block[4][4];
+    for (int y = 0; y < 4; y++)
+    {
+        for (int x = 0; x < 4; x++)
+        {
+            ivec2 texel  = base + ivec2(x, y);
+            vec2  center = (vec2(texel) + 0.5) * scale;
+
+            vec3  color       = vec3(0.0);
+            float totalWeight = 0.0;
+            float luminance   = 0.0;
+            for (int tap = 0; tap < 4; tap++)
+            {
+                vec3  value  = Tap(center + vec2(tap & 1, tap >> 1) * 2.0 - 1.0);
+                float weight = 1.0 / (1.0 + Luminance(value));
+                color += value * weight;
+                totalWeight += weight;
+                luminance += 0.25 * Luminance(value);
+            }
+            block[y][x] = color / totalWeight;
+
+            if (all(lessThan(texel, bloomSize)))
+                atomicAdd(localBins[LuminanceBin(luminance)], 1);
+            imageStore(bloomMips[0], texel, vec4(block[y][x], 1.0));
+        }
+    }
+
+    // mips 1 and 2 from the registers
+    vec3 mip2 = vec3(0.0);
+    for (int y = 0; y < 2; y++)
+    {
+        for (int x = 0; x < 2; x++)
+        {
+            vec3 value = 0.25 * (block[2 * y][2 * x] + block[2 * y][2 * x + 1] +
+                                 block[2 * y + 1][2 * x] + block[2 * y + 1][2 * x + 1]);
+            imageStore(bloomMips[1], base / 2 + ivec2(x, y), vec4(value, 1.0));
+            mip2 += 0.25 * value;
+        }
+    }
+    imageStore(bloomMips[2], base / 4, vec4(mip2, 1.0));
+    tile[thread.y][thread.x] = mip2;
+
+    // the next levels through shared memory, each one with a quarter of the previous threads
+    for (int mip = 3; mip < MIP_COUNT; mip++)
+    {
+        barrier();
+
+        int  size   = 16 >> (mip - 2);
+        bool inside = all(lessThan(thread, ivec2(size)));
+        vec3 value  = vec3(0.0);
+        if (inside)
+        {
+            ivec2 child = thread * 2;
+            value       = 0.25 * (tile[child.y][child.x] + tile[child.y][child.x + 1] +
+                                  tile[child.y + 1][child.x] + tile[child.y + 1][child.x + 1]);
+        }
+        barrier();
+
+        if (inside)
+        {
+            tile[thread.y][thread.x] = value;
+            imageStore(bloomMips[mip], ivec2(gl_WorkGroupID.xy) * size + thread, vec4(value, 1.0));
+        }
+    }
+
+    barrier();
+    if (localBins[index] > 0)
+        atomicAdd(bins[index], localBins[index]);
+}
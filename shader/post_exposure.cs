@@ -0,0 +1,75 @@
+#version 460 core
+
+// Auto-exposure from the luminance histogram: averages the log luminance of the pixels between
+// two percentiles, so neither a dark corner nor a few bright lights drive it, and moves the
+// exposure toward the one mapping that average to middle gray. One workgroup, a thread per bin
+layout(local_size_x = 256) in;
+
+#define BINS 256
+#define MIN_LOG_LUMINANCE -10.0
+#define LOG_LUMINANCE_RANGE 16.0
+#define KEY_VALUE 0.18
+
+layout(std430, binding = 0) buffer Histogram
+{
+    uint bins[BINS];
+};
+
+layout(std430, binding = 1) buffer Exposure
+{
+    float averageLuminance; // adapted, 0 until the first frame
+    float exposure;
+};
+
+uniform float lowPercentile;
+uniform float highPercentile;
+uniform float adaptation; // fraction of the way to the target covered this frame
+
+shared uint prefix[BINS];
+shared vec2 sums[BINS]; // pixels kept, and their log luminance sum
+
+void main()
+{
+    uint index = gl_LocalInvocationIndex;
+    uint count = bins[index];
+    // cleared for the next frame
+    bins[index]   = 0;
+    prefix[index] = count;
+    barrier();
+
+    // inclusive prefix sum over the bins
+    for (uint offset = 1; offset < BINS; offset *= 2)
+    {
+        uint value = index >= offset ? prefix[index - offset] : 0;
+        barrier();
+        prefix[index] += value;
+        barrier();
+    }
+
+    float total = float(prefix[BINS - 1]);
+    float end   = float(prefix[index]);
+    float start = end - float(count);
+    float kept  = max(min(end, highPercentile * total) - max(start, lowPercentile * total), 0.0);
+
+    float logLuminance = MIN_LOG_LUMINANCE;
+    if (index > 0)
+        logLuminance += (float(index - 1) + 0.5) / float(BINS - 2) * LOG_LUMINANCE_RANGE;
+    sums[index] = vec2(kept, kept * logLuminance);
+    barrier();
+
+    for (uint stride = BINS / 2; stride > 0; stride /= 2)
+    {
+        if (index < stride)
+            sums[index] += sums[index + stride];
+        barrier();
+    }
+
+    if (index == 0)
+    {
+        float target = exp2(sums[0].x > 0.0 ? sums[0].y / sums[0].x : MIN_LOG_LUMINANCE);
+        float adapted =
+            averageLuminance > 0.0 ? mix(averageLuminance, target, adaptation) : target;
+        averageLuminance = adapted;
+        exposure         = KEY_VALUE / adapted;
+    }
+}
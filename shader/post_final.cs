@@ -0,0 +1,232 @@
+#version 460 core
+
+// Final post-processing dispatch: exposure, bloom, ACES tonemapping and sRGB encoding, fused with
+// the anti-aliasing filter. FXAA and the SMAA neighborhood blending both read the image at a few
+// positions around the pixel, every one of them is tonemapped on the fly so the tonemapped image
+// is never stored before it is filtered
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#define FILTER_NONE 0
+#define FILTER_FXAA 1
+#define FILTER_SMAA 2
+#define BLOOM_MIP_COUNT 6
+
+// only the bottom-left renderSize texels of the scene hold the image
+layout(binding = 0) uniform sampler2D sceneTexture;
+layout(binding = 1) uniform sampler2D bloomTexture;   // first mip of the upsampled chain
+layout(binding = 2) uniform sampler2D weightsTexture; // SMAA blending weights
+
+layout(rgba8, binding = 0) uniform writeonly image2D outputImage;
+
+layout(std430, binding = 1) readonly buffer Exposure
+{
+    float averageLuminance;
+    float exposure;
+};
+
+uniform vec2  sceneSize; // storage size of the scene
+uniform ivec2 renderSize;
+uniform vec2  bloomSize; // storage size of the first bloom mip
+uniform vec2  bloomArea; // of the first bloom mip in use
+uniform float bloomStrength;
+uniform int   filterMode;
+
+#define EDGE_THRESHOLD 0.166
+#define EDGE_THRESHOLD_MIN 0.0833
+#define SUBPIXEL_QUALITY 0.75
+#define SEARCH_STEPS 10
+
+const float stepSizes[SEARCH_STEPS] = float[](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 4.0, 8.0);
+
+// ACES filmic curve fit by Krzysztof Narkowicz
+vec3 Tonemap(vec3 color)
+{
+    color *= 0.6;
+    return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14),
+                 0.0,
+                 1.0);
+}
+
+vec3 LinearToSrgb(vec3 color)
+{
+    return mix(12.92 * color, 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, color));
+}
+
+// display color of the image at a pixel position, bilinearly filtered
+vec3 Sample(vec2 position)
+{
+    vec2 extent = vec2(renderSize);
+    position    = clamp(position, vec2(0.5), extent - 0.5);
+    vec3 color  = textureLod(sceneTexture, position / sceneSize, 0.0).rgb;
+
+    vec2 bloomPosition = clamp(position * bloomArea / extent, vec2(0.5), bloomArea - 0.5);
+    vec3 bloom         = textureLod(bloomTexture, bloomPosition / bloomSize, 0.0).rgb;
+
+    // every level of the chain added up into the first mip
+    color = mix(color, bloom / float(BLOOM_MIP_COUNT), bloomStrength);
+    return LinearToSrgb(Tonemap(color * exposure));
+}
+
+float Luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+float LumaAt(vec2 position)
+{
+    return Luma(Sample(position));
+}
+
+// FXAA 3.11 quality: finds the direction of the edge through a high-contrast pixel, walks along
+// it to both ends and resamples the pixel across the edge by how close the nearest end is
+vec3 Fxaa(vec2 position)
+{
+    vec3 color = Sample(position);
+
+    float lumaCenter = Luma(color);
+    float lumaDown   = LumaAt(position + vec2(0.0, -1.0));
+    float lumaUp     = LumaAt(position + vec2(0.0, 1.0));
+    float lumaLeft   = LumaAt(position + vec2(-1.0, 0.0));
+    float lumaRight  = LumaAt(position + vec2(1.0, 0.0));
+
+    float lumaMin   = min(lumaCenter, min(min(lumaDown, lumaUp), min(lumaLeft, lumaRight)));
+    float lumaMax   = max(lumaCenter, max(max(lumaDown, lumaUp), max(lumaLeft, lumaRight)));
+    float lumaRange = lumaMax - lumaMin;
+    if (lumaRange < max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD))
+        return color;
+
+    float lumaDownLeft  = LumaAt(position + vec2(-1.0, -1.0));
+    float lumaUpRight   = LumaAt(position + vec2(1.0, 1.0));
+    float lumaUpLeft    = LumaAt(position + vec2(-1.0, 1.0));
+    float lumaDownRight = LumaAt(position + vec2(1.0, -1.0));
+
+    float lumaDownUp       = lumaDown + lumaUp;
+    float lumaLeftRight    = lumaLeft + lumaRight;
+    float lumaLeftCorners  = lumaDownLeft + lumaUpLeft;
+    float lumaDownCorners  = lumaDownLeft + lumaDownRight;
+    float lumaRightCorners = lumaDownRight + lumaUpRight;
+    float lumaUpCorners    = lumaUpRight + lumaUpLeft;
+
+    // the edge runs along the direction with the weakest second derivative
+    float edgeHorizontal = abs(-2.0 * lumaLeft + lumaLeftCorners) +
+                           abs(-2.0 * lumaCenter + lumaDownUp) * 2.0 +
+                           abs(-2.0 * lumaRight + lumaRightCorners);
+    float edgeVertical   = abs(-2.0 * lumaUp + lumaUpCorners) +
+                           abs(-2.0 * lumaCenter + lumaLeftRight) * 2.0 +
+                           abs(-2.0 * lumaDown + lumaDownCorners);
+    bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+    // pick the side of the pixel the edge is on, the one with the steepest gradient
+    float luma1        = isHorizontal ? lumaDown : lumaLeft;
+    float luma2        = isHorizontal ? lumaUp : lumaRight;
+    float gradient1    = luma1 - lumaCenter;
+    float gradient2    = luma2 - lumaCenter;
+    bool  is1Steepest  = abs(gradient1) >= abs(gradient2);
+    float gradientEnd  = 0.25 * max(abs(gradient1), abs(gradient2));
+    float stepLength   = is1Steepest ? -1.0 : 1.0;
+    float lumaAverage  = 0.5 * ((is1Steepest ? luma1 : luma2) + lumaCenter);
+    vec2  edgePosition = position;
+    if (isHorizontal)
+        edgePosition.y += 0.5 * stepLength;
+    else
+        edgePosition.x += 0.5 * stepLength;
+
+    // walk along the edge until the luma along it leaves the average of its two sides
+    vec2  direction = isHorizontal ? vec2(1.0, 0.0) : vec2(0.0, 1.0);
+    vec2  end1      = edgePosition;
+    vec2  end2      = edgePosition;
+    float lumaEnd1  = 0.0;
+    float lumaEnd2  = 0.0;
+    bool  reached1  = false;
+    bool  reached2  = false;
+    for (int index = 0; index < SEARCH_STEPS && !(reached1 && reached2); index++)
+    {
+        if (!reached1)
+        {
+            end1 -= direction * stepSizes[index];
+            lumaEnd1 = LumaAt(end1) - lumaAverage;
+            reached1 = abs(lumaEnd1) >= gradientEnd;
+        }
+        if (!reached2)
+        {
+            end2 += direction * stepSizes[index];
+            lumaEnd2 = LumaAt(end2) - lumaAverage;
+            reached2 = abs(lumaEnd2) >= gradientEnd;
+        }
+    }
+
+    float distance1    = isHorizontal ? position.x - end1.x : position.y - end1.y;
+    float distance2    = isHorizontal ? end2.x - position.x : end2.y - position.y;
+    bool  isDirection1 = distance1 < distance2;
+    float pixelOffset  = 0.5 - min(distance1, distance2) / (distance1 + distance2);
+
+    // only move across the edge when the nearest end agrees with the side the center is on
+    bool  isCenterSmaller  = lumaCenter < lumaAverage;
+    bool  correctVariation = ((isDirection1 ? lumaEnd1 : lumaEnd2) < 0.0) != isCenterSmaller;
+    float finalOffset      = correctVariation ? pixelOffset : 0.0;
+
+    // subpixel aliasing, from the contrast of the pixel against its whole neighborhood
+    float lumaNeighborhood = (2.0 * (lumaDownUp + lumaLeftRight) + lumaLeftCorners +
+                              lumaRightCorners) / 12.0;
+    float subpixel = clamp(abs(lumaNeighborhood - lumaCenter) / lumaRange, 0.0, 1.0);
+    subpixel       = (-2.0 * subpixel + 3.0) * subpixel * subpixel;
+    finalOffset    = max(finalOffset, subpixel * subpixel * SUBPIXEL_QUALITY);
+
+    if (isHorizontal)
+        position.y += finalOffset * stepLength;
+    else
+        position.x += finalOffset * stepLength;
+
+    return Sample(position);
+}
+
+float FetchWeight(ivec2 texel, int channel)
+{
+    if (any(lessThan(texel, ivec2(0))) || any(greaterThanEqual(texel, renderSize)))
+        return 0.0;
+    return texelFetch(weightsTexture, texel, 0)[channel];
+}
+
+// SMAA neighborhood blending: the pixel mixes with the neighbors across its edges by the weights
+// the blending weight pass found, along the axis with the strongest one
+vec3 SmaaBlend(vec2 position)
+{
+    ivec2 pixel = ivec2(position);
+
+    // toward the right, top, left and bottom neighbors, each edge stores the weights of both
+    // pixels around it
+    vec4 weights = vec4(FetchWeight(pixel + ivec2(1, 0), 3),
+                        FetchWeight(pixel, 0),
+                        FetchWeight(pixel, 2),
+                        FetchWeight(pixel + ivec2(0, -1), 1));
+
+    if (dot(weights, vec4(1.0)) < 1e-5)
+        return Sample(position);
+
+    // bilinear fetches offset by the weights mix the pixel with each neighbor
+    bool horizontal = max(weights.x, weights.z) > max(weights.y, weights.w);
+    vec2 offset1    = horizontal ? vec2(weights.x, 0.0) : vec2(0.0, weights.y);
+    vec2 offset2    = horizontal ? vec2(-weights.z, 0.0) : vec2(0.0, -weights.w);
+    vec2 blend      = horizontal ? weights.xz : weights.yw;
+    blend /= blend.x + blend.y;
+
+    return blend.x * Sample(position + offset1) + blend.y * Sample(position + offset2);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, renderSize)))
+        return;
+
+    vec2 position = vec2(pixel) + 0.5;
+    vec3 color;
+    if (filterMode == FILTER_FXAA)
+        color = Fxaa(position);
+    else if (filterMode == FILTER_SMAA)
+        color = SmaaBlend(position);
+    else
+        color = Sample(position);
+
+    imageStore(outputImage, pixel, vec4(color, 1.0));
+}
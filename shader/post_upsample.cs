@@ -0,0 +1,39 @@
+#version 460 core
+
+// Bloom upsampling: adds the level below, blurred by a 3x3 tent, into a level of the chain. Run
+// from the smallest mip up, the first mip ends up with the sum of every level, each one blurred
+// wider than the previous
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D bloomTexture;
+
+layout(r11f_g11f_b10f, binding = 0) uniform image2D targetMip;
+
+uniform int   sourceMip;
+uniform vec2  sourceSize;    // storage size of the source level
+uniform vec2  sourceArea;    // of the source level in use
+uniform ivec2 targetArea;
+
+vec3 Tap(vec2 position)
+{
+    position = clamp(position, vec2(0.5), sourceArea - 0.5);
+    return textureLod(bloomTexture, position / sourceSize, float(sourceMip)).rgb;
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(texel, targetArea)))
+        return;
+
+    vec2 position = (vec2(texel) + 0.5) * sourceArea / vec2(targetArea);
+
+    vec3 blurred = 4.0 * Tap(position);
+    blurred += 2.0 * (Tap(position + vec2(-1.0, 0.0)) + Tap(position + vec2(1.0, 0.0)) +
+                      Tap(position + vec2(0.0, -1.0)) + Tap(position + vec2(0.0, 1.0)));
+    blurred += Tap(position + vec2(-1.0, -1.0)) + Tap(position + vec2(1.0, -1.0)) +
+               Tap(position + vec2(-1.0, 1.0)) + Tap(position + vec2(1.0, 1.0));
+
+    vec3 color = imageLoad(targetMip, texel).rgb + blurred / 16.0;
+    imageStore(targetMip, texel, vec4(color, 1.0));
+}
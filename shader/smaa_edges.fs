@@ -0,0 +1,62 @@
+#version 460 core
+
+// SMAA edge detection on luma. Each pixel stores the edge on its left side in r and the one on
+// its top side in g, the blending weight pass walks along them. The source is the HDR scene, its
+// luma is taken after exposure and tonemapping like the final image's, bloom left out
+layout(location = 0) out vec2 Edges;
+
+uniform sampler2D sourceTexture;
+uniform ivec2     renderSize;
+
+layout(std430, binding = 1) readonly buffer Exposure
+{
+    float averageLuminance;
+    float exposure;
+};
+
+#define THRESHOLD 0.1
+// an edge is dropped when a neighboring edge is that many times stronger, the eye doesn't see it
+#define LOCAL_CONTRAST_ADAPTATION 2.0
+
+// same curve as the final post-processing dispatch
+vec3 Tonemap(vec3 color)
+{
+    color *= 0.6;
+    return clamp((color * (2.51 * color + 0.03)) / (color * (2.43 * color + 0.59) + 0.14),
+                 0.0,
+                 1.0);
+}
+
+float Luma(ivec2 texel)
+{
+    texel       = clamp(texel, ivec2(0), renderSize - 1);
+    vec3 color  = Tonemap(texelFetch(sourceTexture, texel, 0).rgb * exposure);
+    return dot(pow(color, vec3(1.0 / 2.2)), vec3(0.2126, 0.7152, 0.0722));
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    float luma      = Luma(pixel);
+    float lumaLeft  = Luma(pixel + ivec2(-1, 0));
+    float lumaTop   = Luma(pixel + ivec2(0, 1));
+    vec2  delta     = abs(luma - vec2(lumaLeft, lumaTop));
+    vec2  edges     = step(THRESHOLD, delta);
+    if (edges.x + edges.y == 0.0)
+    {
+        Edges = vec2(0.0);
+        return;
+    }
+
+    float lumaRight  = Luma(pixel + ivec2(1, 0));
+    float lumaBottom = Luma(pixel + ivec2(0, -1));
+    vec2  maxDelta   = max(delta, abs(luma - vec2(lumaRight, lumaBottom)));
+
+    float lumaLeftLeft = Luma(pixel + ivec2(-2, 0));
+    float lumaTopTop   = Luma(pixel + ivec2(0, 2));
+    maxDelta = max(maxDelta, abs(vec2(lumaLeft, lumaTop) - vec2(lumaLeftLeft, lumaTopTop)));
+
+    float finalDelta = max(maxDelta.x, maxDelta.y);
+    Edges            = edges * step(finalDelta, LOCAL_CONTRAST_ADAPTATION * delta);
+}
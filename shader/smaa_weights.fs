@@ -0,0 +1,122 @@
+#version 460 core
+
+// SMAA blending weights, orthogonal patterns only. For every edge a pixel owns, it searches both
+// ends of the line the edge is part of, reads the crossing edges at each end and looks the
+// coverage of the revectorized silhouette up in the area texture.
+//   rg: top edge, how much this pixel blends into the one above / the one above into this one
+//   ba: left edge, the same with the pixel on the left
+// The searches fetch the edges between texels, so one bilinear fetch reads four edges: two along
+// the line and two crossing it, with weights that keep every combination distinct. The search
+// texture decodes where the line stops in the last fetch.
+layout(location = 0) out vec4 Weights;
+
+layout(binding = 0) uniform sampler2D  edgesTexture;
+layout(binding = 1) uniform sampler2D  areaTexture;
+layout(binding = 2) uniform usampler2D searchTexture;
+
+uniform vec2 sourceSize; // storage size of the edges texture
+
+#define MAX_SEARCH_STEPS 16
+// the area texture holds 5x5 slots of 16x16 texels indexed by the crossing edges at both ends,
+// within a slot the texel is the square root of the distance to each end
+#define AREA_MAX_DISTANCE 16.0
+#define AREA_SIZE 80.0
+#define SEARCH_SLOTS 33
+
+vec2 SampleEdges(vec2 position)
+{
+    return textureLod(edgesTexture, position / sourceSize, 0.0).rg;
+}
+
+// pixels to step back from the last fetch, e holds the crossing edges in x and the line in y.
+// Searches left and up read the first half of the texture, right and down the second
+float SearchLength(vec2 e, int side)
+{
+    ivec2 texel = ivec2(round(e * 32.0)) + ivec2(side * SEARCH_SLOTS, 0);
+    return float(texelFetch(searchTexture, texel, 0).r);
+}
+
+// each search starts a quarter pixel inside the current pixel and returns the center of the last
+// pixel of the line
+float SearchXLeft(vec2 position)
+{
+    vec2 e = vec2(0.0, 1.0);
+    for (int index = 0; index < MAX_SEARCH_STEPS && e.g > 0.8281 && e.r == 0.0; index++)
+    {
+        e = SampleEdges(position);
+        position.x -= 2.0;
+    }
+    return position.x + 3.25 - SearchLength(e, 0);
+}
+
+float SearchXRight(vec2 position)
+{
+    vec2 e = vec2(0.0, 1.0);
+    for (int index = 0; index < MAX_SEARCH_STEPS && e.g > 0.8281 && e.r == 0.0; index++)
+    {
+        e = SampleEdges(position);
+        position.x += 2.0;
+    }
+    return position.x - 3.25 + SearchLength(e, 1);
+}
+
+// vertical lines are made of left edges (r) and end at top edges (g)
+float SearchYUp(vec2 position)
+{
+    vec2 e = vec2(1.0, 0.0);
+    for (int index = 0; index < MAX_SEARCH_STEPS && e.r > 0.8281 && e.g == 0.0; index++)
+    {
+        e = SampleEdges(position);
+        position.y += 2.0;
+    }
+    return position.y - 3.25 + SearchLength(e.gr, 0);
+}
+
+float SearchYDown(vec2 position)
+{
+    vec2 e = vec2(1.0, 0.0);
+    for (int index = 0; index < MAX_SEARCH_STEPS && e.r > 0.8281 && e.g == 0.0; index++)
+    {
+        e = SampleEdges(position);
+        position.y -= 2.0;
+    }
+    return position.y + 3.25 - SearchLength(e.gr, 1);
+}
+
+// e1, e2 are the crossing edges at both ends, fetched a quarter pixel off the line so a crossing
+// on the side of the current pixel reads 0.75 and one on the other side 0.25
+vec2 Area(vec2 distance, float e1, float e2)
+{
+    vec2 texel = AREA_MAX_DISTANCE * round(4.0 * vec2(e1, e2)) + sqrt(distance) + 0.5;
+    return textureLod(areaTexture, texel / AREA_SIZE, 0.0).rg;
+}
+
+void main()
+{
+    vec2 pixel = gl_FragCoord.xy;
+    vec2 edges = texelFetch(edgesTexture, ivec2(pixel), 0).rg;
+
+    vec4 weights = vec4(0.0);
+
+    if (edges.g > 0.0)
+    {
+        float left  = SearchXLeft(pixel + vec2(-0.25, 0.125));
+        float right = SearchXRight(pixel + vec2(1.25, 0.125));
+        float e1    = SampleEdges(vec2(left, pixel.y + 0.25)).r;
+        float e2    = SampleEdges(vec2(right + 1.0, pixel.y + 0.25)).r;
+        vec2  d     = abs(round(vec2(left, right) - pixel.x));
+        weights.rg  = Area(d, e1, e2);
+    }
+
+    if (edges.r > 0.0)
+    {
+        float top    = SearchYUp(pixel + vec2(-0.125, 0.25));
+        float bottom = SearchYDown(pixel + vec2(-0.125, -1.25));
+        float e1     = SampleEdges(vec2(pixel.x - 0.25, top)).g;
+        float e2     = SampleEdges(vec2(pixel.x - 0.25, bottom - 1.0)).g;
+        vec2  d      = abs(round(vec2(top, bottom) - pixel.y));
+        weights.ba   = Area(d, e1, e2);
+    }
+
+    Weights = weights;
+}
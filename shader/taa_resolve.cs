@@ -0,0 +1,159 @@
+#version 460 core
+
+// temporal anti-aliasing resolve: blends the jittered current frame into the history reprojected
+// with the velocity buffer. The current frame may be rendered at a lower resolution than the
+// output, the history then accumulates the samples of several frames into each output pixel
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// the current frame only holds the bottom-left renderSize texels of these
+layout(binding = 0) uniform sampler2D currentColor;
+layout(binding = 1) uniform sampler2D velocityTexture; // current - previous uv
+layout(binding = 2) uniform sampler2D depthTexture;
+layout(binding = 3) uniform sampler2D historyTexture;
+
+layout(rgba16f, binding = 0) uniform writeonly image2D outputImage;
+
+uniform ivec2 outputSize;
+uniform ivec2 renderSize;
+uniform vec2  jitter;      // of the current frame, in render pixels
+uniform float blendFactor; // weight of a current sample that lands on the output pixel center
+uniform bool  historyValid;
+
+vec3 RGBToYCoCg(vec3 color)
+{
+    return vec3(dot(color, vec3(0.25, 0.5, 0.25)),
+                dot(color, vec3(0.5, 0.0, -0.5)),
+                dot(color, vec3(-0.25, 0.5, -0.25)));
+}
+
+vec3 YCoCgToRGB(vec3 color)
+{
+    return vec3(color.x + color.y - color.z, color.x + color.z, color.x - color.y - color.z);
+}
+
+vec3 FetchCurrent(ivec2 texel)
+{
+    return RGBToYCoCg(texelFetch(currentColor, clamp(texel, ivec2(0), renderSize - 1), 0).rgb);
+}
+
+// Catmull-Rom filtered history in 9 bilinear taps, a bilinear fetch alone would blur the history
+// a little more every frame
+vec3 SampleHistory(vec2 uv)
+{
+    vec2 size     = vec2(outputSize);
+    vec2 position = uv * size;
+    vec2 center   = floor(position - 0.5) + 0.5;
+    vec2 f        = position - center;
+
+    vec2 w0  = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1  = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2  = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3  = f * f * (-0.5 + 0.5 * f);
+    vec2 w12 = w1 + w2;
+
+    vec2 uv0  = (center - 1.0) / size;
+    vec2 uv12 = (center + w2 / w12) / size;
+    vec2 uv3  = (center + 2.0) / size;
+
+    vec3 result = vec3(0.0);
+    result += textureLod(historyTexture, vec2(uv0.x, uv0.y), 0.0).rgb * w0.x * w0.y;
+    result += textureLod(historyTexture, vec2(uv12.x, uv0.y), 0.0).rgb * w12.x * w0.y;
+    result += textureLod(historyTexture, vec2(uv3.x, uv0.y), 0.0).rgb * w3.x * w0.y;
+
+    result += textureLod(historyTexture, vec2(uv0.x, uv12.y), 0.0).rgb * w0.x * w12.y;
+    result += textureLod(historyTexture, vec2(uv12.x, uv12.y), 0.0).rgb * w12.x * w12.y;
+    result += textureLod(historyTexture, vec2(uv3.x, uv12.y), 0.0).rgb * w3.x * w12.y;
+
+    result += textureLod(historyTexture, vec2(uv0.x, uv3.y), 0.0).rgb * w0.x * w3.y;
+    result += textureLod(historyTexture, vec2(uv12.x, uv3.y), 0.0).rgb * w12.x * w3.y;
+    result += textureLod(historyTexture, vec2(uv3.x, uv3.y), 0.0).rgb * w3.x * w3.y;
+
+    return max(result, vec3(0.0));
+}
+
+// pulls the history toward the center of the neighborhood box until it is inside, unlike a clamp
+// per channel this keeps its hue
+vec3 ClipToBox(vec3 history, vec3 boxMin, vec3 boxMax)
+{
+    vec3 center = 0.5 * (boxMax + boxMin);
+    vec3 extent = 0.5 * (boxMax - boxMin) + 1e-4;
+    vec3 offset = history - center;
+    vec3 units  = abs(offset / extent);
+    float ratio = max(units.x, max(units.y, units.z));
+    return ratio > 1.0 ? center + offset / ratio : history;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(pixel, outputSize)))
+        return;
+
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(outputSize);
+
+    // the rendered sample closest to this output pixel: jittering moved the image by +jitter
+    vec2  position = uv * vec2(renderSize) + jitter;
+    ivec2 texel    = clamp(ivec2(floor(position)), ivec2(0), renderSize - 1);
+    vec2  offset   = (position - (vec2(texel) + 0.5)) * vec2(outputSize) / vec2(renderSize);
+
+    // neighborhood statistics of the current frame, and the velocity of the closest surface so
+    // edges reproject with the object in front of them
+    vec3  current      = vec3(0.0);
+    vec3  moment1      = vec3(0.0);
+    vec3  moment2      = vec3(0.0);
+    vec3  boxMin       = vec3(1e4);
+    vec3  boxMax       = vec3(-1e4);
+    float closestDepth = 1.0;
+    ivec2 closestTexel = texel;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            ivec2 neighbor = clamp(texel + ivec2(x, y), ivec2(0), renderSize - 1);
+            vec3  color    = FetchCurrent(neighbor);
+            moment1 += color;
+            moment2 += color * color;
+            boxMin = min(boxMin, color);
+            boxMax = max(boxMax, color);
+            if (x == 0 && y == 0)
+                current = color;
+
+            float depth = texelFetch(depthTexture, neighbor, 0).r;
+            if (depth < closestDepth)
+            {
+                closestDepth = depth;
+                closestTexel = neighbor;
+            }
+        }
+    }
+
+    vec2 velocity  = texelFetch(velocityTexture, closestTexel, 0).rg;
+    vec2 historyUV = uv - velocity;
+    bool offscreen = any(lessThan(historyUV, vec2(0.0))) || any(greaterThan(historyUV, vec2(1.0)));
+    if (!historyValid || offscreen)
+    {
+        imageStore(outputImage, pixel, vec4(YCoCgToRGB(current), 1.0));
+        return;
+    }
+
+    // variance clipping: the box is tightened to the mean +- 1.25 standard deviations
+    vec3 mean  = moment1 / 9.0;
+    vec3 sigma = sqrt(max(moment2 / 9.0 - mean * mean, vec3(0.0)));
+    boxMin     = max(boxMin, mean - 1.25 * sigma);
+    boxMax     = min(boxMax, mean + 1.25 * sigma);
+
+    vec3 history = RGBToYCoCg(SampleHistory(historyUV));
+    history      = ClipToBox(history, boxMin, boxMax);
+
+    // a sample far from the output pixel center, when upsampling, contributes less, the history
+    // fills in until a later jitter lands closer
+    float weight = blendFactor * exp(-2.0 * dot(offset, offset));
+
+    // weighting by inverse luma keeps bright subpixel details from flickering
+    float currentLuma = 1.0 / (1.0 + current.x);
+    float historyLuma = 1.0 / (1.0 + history.x);
+    float mixed       = weight * currentLuma / mix(historyLuma, currentLuma, weight);
+    vec3  result      = mix(history, current, mixed);
+
+    imageStore(outputImage, pixel, vec4(YCoCgToRGB(result), 1.0));
+}
@@ -0,0 +1,53 @@
+#version 460 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// only the bottom-left renderSize texels of the source hold the image
+uniform sampler2D sourceTexture;
+uniform vec2      sourceSize;
+uniform vec2      renderSize;
+
+// bilinear tap at a texel position, kept inside the rendered area so nothing from the unused part
+// of the storage bleeds in at the edges
+vec3 Tap(vec2 position)
+{
+    position = clamp(position, vec2(0.5), renderSize - 0.5);
+    return texture(sourceTexture, position / sourceSize).rgb;
+}
+
+// Catmull-Rom filter, the 16 taps fold into 9 bilinear ones by merging the two middle weights of
+// each axis into a single tap between their texels
+void main()
+{
+    vec2 position = TexCoords * renderSize;
+    vec2 center   = floor(position - 0.5) + 0.5;
+    vec2 f        = position - center;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    vec2 w12     = w1 + w2;
+    vec2 offset0 = center - 1.0;
+    vec2 offset1 = center + w2 / w12;
+    vec2 offset3 = center + 2.0;
+
+    vec3 result = vec3(0.0);
+    result += Tap(vec2(offset0.x, offset0.y)) * w0.x * w0.y;
+    result += Tap(vec2(offset1.x, offset0.y)) * w12.x * w0.y;
+    result += Tap(vec2(offset3.x, offset0.y)) * w3.x * w0.y;
+
+    result += Tap(vec2(offset0.x, offset1.y)) * w0.x * w12.y;
+    result += Tap(vec2(offset1.x, offset1.y)) * w12.x * w12.y;
+    result += Tap(vec2(offset3.x, offset1.y)) * w3.x * w12.y;
+
+    result += Tap(vec2(offset0.x, offset3.y)) * w0.x * w3.y;
+    result += Tap(vec2(offset1.x, offset3.y)) * w12.x * w3.y;
+    result += Tap(vec2(offset3.x, offset3.y)) * w3.x * w3.y;
+
+    // the negative lobes overshoot next to hard edges
+    FragColor = vec4(max(result, vec3(0.0)), 1.0);
+}
@@ -0,0 +1,14 @@
+#version 460 core
+
+// 32-bit visibility: draw index in the high bits, triangle index within the draw in the low bits
+#define TRIANGLE_BITS 23
+
+layout(location = 0) out uint visibility;
+
+flat in uint drawId;
+flat in uint firstTriangle;
+
+void main()
+{
+    visibility = (drawId << TRIANGLE_BITS) | (firstTriangle + uint(gl_PrimitiveID));
+}
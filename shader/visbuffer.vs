@@ -0,0 +1,48 @@
+#version 460 core
+
+layout(location = 0) in vec3 aPos;
+
+struct DrawData
+{
+    mat4 model;
+    mat4 normalMatrix;
+    uint firstIndex;
+    uint baseVertex;
+    uint material;
+    uint pad;
+};
+
+// a meshlet of a draw, every draw command covers one
+struct ClusterData
+{
+    vec4 sphere;
+    vec4 cone;
+    uint draw;
+    uint firstTriangle;
+    uint triangleCount;
+    uint pad;
+};
+
+layout(std430, binding = 1) readonly buffer Draws
+{
+    DrawData draws[];
+};
+
+layout(std430, binding = 20) readonly buffer Clusters
+{
+    ClusterData clusters[];
+};
+
+uniform mat4 viewProjection;
+
+flat out uint drawId;
+flat out uint firstTriangle;
+
+void main()
+{
+    // the base instance of a command is the index of its cluster, culled or not
+    ClusterData cluster = clusters[gl_BaseInstance];
+    drawId              = cluster.draw;
+    firstTriangle       = cluster.firstTriangle;
+    gl_Position         = viewProjection * draws[cluster.draw].model * vec4(aPos, 1.0);
+}
@@ -0,0 +1,77 @@
+#version 460 core
+
+// bins 8x8 screen tiles per material: every material present in a tile appends the tile to its
+// list and bumps its indirect dispatch size, so the shading pass only visits relevant tiles
+#define TILE_SIZE 8
+#define TRIANGLE_BITS 23
+#define MAX_MATERIALS 256
+#define EMPTY_PIXEL 0xffffffffu
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+struct DrawData
+{
+    mat4 model;
+    mat4 normalMatrix;
+    uint firstIndex;
+    uint baseVertex;
+    uint material;
+    uint pad;
+};
+
+layout(std430, binding = 1) readonly buffer Draws
+{
+    DrawData draws[];
+};
+
+// x holds the tile count of each material, y and z stay 1 so it is a dispatch-indirect command
+layout(std430, binding = 4) buffer MaterialArgs
+{
+    uvec4 materialArgs[];
+};
+
+layout(std430, binding = 5) writeonly buffer MaterialTiles
+{
+    uint materialTiles[];
+};
+
+layout(r32ui, binding = 0) uniform readonly uimage2D visibilityImage;
+
+uniform uint  maxTiles;
+uniform ivec2 renderSize;
+
+shared uint tileMaterials[MAX_MATERIALS / 32];
+
+void main()
+{
+    if (gl_LocalInvocationIndex < MAX_MATERIALS / 32)
+        tileMaterials[gl_LocalInvocationIndex] = 0;
+    barrier();
+
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (all(lessThan(pixel, renderSize)))
+    {
+        uint visibility = imageLoad(visibilityImage, pixel).r;
+        if (visibility != EMPTY_PIXEL)
+        {
+            uint material = draws[visibility >> TRIANGLE_BITS].material;
+            atomicOr(tileMaterials[material / 32], 1u << (material % 32));
+        }
+    }
+    barrier();
+
+    if (gl_LocalInvocationIndex < MAX_MATERIALS / 32)
+    {
+        uint bits = tileMaterials[gl_LocalInvocationIndex];
+        uint tile = (gl_WorkGroupID.y << 16) | gl_WorkGroupID.x;
+        while (bits != 0)
+        {
+            int  bit      = findLSB(bits);
+            uint material = gl_LocalInvocationIndex * 32 + uint(bit);
+            uint slot     = atomicAdd(materialArgs[material].x, 1);
+
+            materialTiles[material * maxTiles + slot] = tile;
+            bits &= ~(1u << bit);
+        }
+    }
+}
@@ -0,0 +1,103 @@
+#version 460 core
+
+// one thread per cluster: clusters outside the frustum or whose triangles all face away from the
+// camera are dropped, the others append their draw command. The count of commands is the
+// parameter of the multi-draw that follows
+layout(local_size_x = 64) in;
+
+struct DrawData
+{
+    mat4 model;
+    mat4 normalMatrix;
+    uint firstIndex;
+    uint baseVertex;
+    uint material;
+    uint pad;
+};
+
+struct ClusterData
+{
+    vec4 sphere; // model space center, radius
+    vec4 cone;   // model space axis, cutoff
+    uint draw;
+    uint firstTriangle;
+    uint triangleCount;
+    uint pad;
+};
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int  baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 1) readonly buffer Draws
+{
+    DrawData draws[];
+};
+
+layout(std430, binding = 20) readonly buffer Clusters
+{
+    ClusterData clusters[];
+};
+
+layout(std430, binding = 21) writeonly buffer Commands
+{
+    DrawCommand commands[];
+};
+
+layout(std430, binding = 22) buffer Counts
+{
+    uint drawCount;
+    uint drawnTriangles;
+    uint frustumCulled;
+    uint coneCulled;
+};
+
+uniform vec4 frustumPlanes[6];
+uniform vec3 cameraPosition;
+uniform uint clusterCount;
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= clusterCount)
+        return;
+
+    ClusterData cluster = clusters[index];
+    DrawData    draw    = draws[cluster.draw];
+
+    // the transforms are similarities, the largest scale keeps the sphere conservative
+    vec3  center = (draw.model * vec4(cluster.sphere.xyz, 1.0)).xyz;
+    float scale  = max(length(draw.model[0].xyz),
+                      max(length(draw.model[1].xyz), length(draw.model[2].xyz)));
+    float radius = cluster.sphere.w * scale;
+
+    for (int plane = 0; plane < 6; plane++)
+    {
+        if (dot(frustumPlanes[plane].xyz, center) + frustumPlanes[plane].w < -radius)
+        {
+            atomicAdd(frustumCulled, 1u);
+            return;
+        }
+    }
+
+    vec3 axis      = normalize(mat3(draw.model) * cluster.cone.xyz);
+    vec3 direction = center - cameraPosition;
+    if (dot(direction, axis) >= cluster.cone.w * length(direction) + radius)
+    {
+        atomicAdd(coneCulled, 1u);
+        return;
+    }
+
+    uint slot = atomicAdd(drawCount, 1u);
+    atomicAdd(drawnTriangles, cluster.triangleCount);
+    commands[slot] = DrawCommand(cluster.triangleCount * 3u,
+                                 1u,
+                                 draw.firstIndex + cluster.firstTriangle * 3u,
+                                 int(draw.baseVertex),
+                                 index);
+}
@@ -0,0 +1,345 @@
+#version 460 core
+
+// shades the pixels of one material: each work group takes a tile from the material's list,
+// rebuilds the covering triangle from the geometry buffers and interpolates its attributes with
+// analytic barycentrics (and their screen derivatives for texture filtering)
+#define TILE_SIZE 8
+#define TRIANGLE_BITS 23
+#define EMPTY_PIXEL 0xffffffffu
+
+layout(local_size_x = TILE_SIZE, local_size_y = TILE_SIZE) in;
+
+struct PointLight
+{
+    vec4 positionRadius;
+    vec4 color;
+    vec4 attenuation;
+};
+
+struct DrawData
+{
+    mat4 model;
+    mat4 normalMatrix;
+    uint firstIndex;
+    uint baseVertex;
+    uint material;
+    uint pad;
+};
+
+layout(std430, binding = 0) readonly buffer PointLights
+{
+    PointLight lights[];
+};
+
+layout(std430, binding = 1) readonly buffer Draws
+{
+    DrawData draws[];
+};
+
+// position, normal, texcoords, lightmap texcoords, baked occlusion: 11 floats per vertex
+layout(std430, binding = 2) readonly buffer Vertices
+{
+    float vertices[];
+};
+
+layout(std430, binding = 3) readonly buffer Indices
+{
+    uint indices[];
+};
+
+layout(std430, binding = 5) readonly buffer MaterialTiles
+{
+    uint materialTiles[];
+};
+
+layout(std140, binding = 0) uniform ShadowData
+{
+    mat4 lightSpace[4];
+    mat4 cameraView;
+    vec4 cascadeSplits;  // far distance of each cascade in view space
+    vec4 lightDirection; // xyz direction of the directional light, w cascade count
+    vec4 lightColor;     // rgb diffuse, a specular
+};
+
+layout(binding = 4) uniform sampler2DArrayShadow shadowMap;
+
+struct PointShadow
+{
+    ivec4 atlas; // tier (-1 when unshadowed), cube slot, resolution
+    vec4  depth; // window depth = x - y / major axis distance
+};
+
+layout(std430, binding = 6) readonly buffer PointShadows
+{
+    PointShadow pointShadows[];
+};
+
+layout(binding = 5) uniform samplerCubeArrayShadow pointShadowTier0;
+layout(binding = 6) uniform samplerCubeArrayShadow pointShadowTier1;
+layout(binding = 7) uniform samplerCubeArrayShadow pointShadowTier2;
+layout(binding = 8) uniform samplerCubeArrayShadow pointShadowTier3;
+
+// ambient occlusion of the render area, a 1x1 white texture when it is off
+layout(binding = 9) uniform sampler2D ambientOcclusion;
+// baked occlusion of the static model, a 1x1 white texture when it has no lightmap
+layout(binding = 10) uniform sampler2D bakedLightmap;
+
+layout(r32ui, binding = 0) uniform readonly uimage2D visibilityImage;
+layout(rgba16f, binding = 1) uniform writeonly image2D litImage;
+
+layout(binding = 0) uniform sampler2D texture_diffuse1;
+layout(binding = 1) uniform sampler2D texture_specular1;
+
+uniform bool hasSpecularMap;
+uniform uint material;
+uniform uint maxTiles;
+uniform ivec2 renderSize;
+uniform uint lightCount;
+uniform vec3 viewPos;
+uniform mat4 viewProjection;
+
+struct Barycentrics
+{
+    vec3 lambda;
+    vec3 ddx;
+    vec3 ddy;
+};
+
+// perspective-correct barycentrics of the pixel inside the clip-space triangle, and their change
+// over one pixel step in x and y
+Barycentrics computeBarycentrics(vec4 p0, vec4 p1, vec4 p2, vec2 pixelNdc, vec2 size)
+{
+    Barycentrics result;
+
+    vec3 invW = 1.0 / vec3(p0.w, p1.w, p2.w);
+    vec2 ndc0 = p0.xy * invW.x;
+    vec2 ndc1 = p1.xy * invW.y;
+    vec2 ndc2 = p2.xy * invW.z;
+
+    float invDet = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+    result.ddx   = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * invDet * invW;
+    result.ddy   = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * invDet * invW;
+
+    float ddxSum = dot(result.ddx, vec3(1.0));
+    float ddySum = dot(result.ddy, vec3(1.0));
+
+    vec2  delta      = pixelNdc - ndc0;
+    float interpInvW = invW.x + delta.x * ddxSum + delta.y * ddySum;
+    float interpW    = 1.0 / interpInvW;
+
+    result.lambda.x = interpW * (invW.x + delta.x * result.ddx.x + delta.y * result.ddy.x);
+    result.lambda.y = interpW * (delta.x * result.ddx.y + delta.y * result.ddy.y);
+    result.lambda.z = interpW * (delta.x * result.ddx.z + delta.y * result.ddy.z);
+
+    // from ndc units to pixels
+    result.ddx *= 2.0 / size.x;
+    result.ddy *= 2.0 / size.y;
+    ddxSum *= 2.0 / size.x;
+    ddySum *= 2.0 / size.y;
+
+    float interpWdx = 1.0 / (interpInvW + ddxSum);
+    float interpWdy = 1.0 / (interpInvW + ddySum);
+    result.ddx      = interpWdx * (result.lambda * interpInvW + result.ddx) - result.lambda;
+    result.ddy      = interpWdy * (result.lambda * interpInvW + result.ddy) - result.lambda;
+
+    return result;
+}
+
+vec3 loadPosition(uint index)
+{
+    return vec3(vertices[index * 11 + 0], vertices[index * 11 + 1], vertices[index * 11 + 2]);
+}
+
+vec3 loadNormal(uint index)
+{
+    return vec3(vertices[index * 11 + 3], vertices[index * 11 + 4], vertices[index * 11 + 5]);
+}
+
+vec2 loadTexCoords(uint index)
+{
+    return vec2(vertices[index * 11 + 6], vertices[index * 11 + 7]);
+}
+
+vec2 loadLightmapTexCoords(uint index)
+{
+    return vec2(vertices[index * 11 + 8], vertices[index * 11 + 9]);
+}
+
+float loadOcclusion(uint index)
+{
+    return vertices[index * 11 + 10];
+}
+
+// 3x3 PCF in the cascade covering the fragment, 1 when lit
+float CalcShadow(vec3 fragPos, vec3 normal)
+{
+    int   cascadeCount = int(lightDirection.w);
+    float depth        = -(cameraView * vec4(fragPos, 1.0)).z;
+    if (cascadeCount == 0 || depth > cascadeSplits[cascadeCount - 1])
+        return 1.0;
+
+    int cascade = 0;
+    while (cascade < cascadeCount - 1 && depth > cascadeSplits[cascade])
+        cascade++;
+
+    // push the lookup along the normal in proportion to the cascade texel size
+    vec4 lightPos = lightSpace[cascade] * vec4(fragPos + normal * 0.02 * float(cascade + 1), 1.0);
+    vec3 coords   = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+
+    vec2  texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float shadow    = 0.0;
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            shadow += texture(shadowMap,
+                              vec4(coords.xy + vec2(x, y) * texelSize, float(cascade), coords.z));
+        }
+    }
+    return shadow / 9.0;
+}
+
+vec3 CalcDirLight(vec3 albedo, float specularStrength, vec3 normal, vec3 viewDir, float shadow)
+{
+    vec3 lightDir = normalize(-lightDirection.xyz);
+
+    // diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // specular
+    vec3  halfwayDir = normalize(lightDir + viewDir);
+    float spec       = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+
+    return (albedo * diff + vec3(specularStrength * lightColor.a) * spec) * lightColor.rgb *
+           shadow;
+}
+
+// single filtered tap in the light's cube of the shadow atlas, 1 when lit
+float CalcPointShadow(uint index, vec3 fragPos, vec3 normal)
+{
+    PointShadow shadow = pointShadows[index];
+    if (shadow.atlas.x < 0)
+        return 1.0;
+
+    // push the lookup along the normal by about two cube texels at that distance
+    vec3 fromLight = fragPos - lights[index].positionRadius.xyz;
+    fromLight += normal * 4.0 * length(fromLight) / float(shadow.atlas.z);
+
+    vec3  axis   = abs(fromLight);
+    float depth  = shadow.depth.x - shadow.depth.y / max(axis.x, max(axis.y, axis.z));
+    vec4  coords = vec4(fromLight, float(shadow.atlas.y));
+
+    // the tier is not dynamically uniform, branch instead of indexing a sampler array
+    switch (shadow.atlas.x)
+    {
+    case 0:
+        return texture(pointShadowTier0, coords, depth);
+    case 1:
+        return texture(pointShadowTier1, coords, depth);
+    case 2:
+        return texture(pointShadowTier2, coords, depth);
+    default:
+        return texture(pointShadowTier3, coords, depth);
+    }
+}
+
+vec3 CalcPointLight(uint index, vec3 albedo, float specularStrength, vec3 normal, vec3 fragPos,
+                    vec3 viewDir)
+{
+    PointLight light = lights[index];
+
+    vec3  toLight  = light.positionRadius.xyz - fragPos;
+    float distance = length(toLight);
+    if (distance > light.positionRadius.w)
+        return vec3(0.0);
+
+    vec3 lightDir = toLight / distance;
+
+    // diffuse
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // specular
+    vec3  halfwayDir = normalize(lightDir + viewDir);
+    float spec       = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+
+    // attenuation, windowed so the light reaches exactly zero at its radius
+    float attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance +
+                               light.attenuation.z * distance * distance);
+    float window      = clamp(1.0 - pow(distance / light.positionRadius.w, 4.0), 0.0, 1.0);
+
+    return (albedo * diff + vec3(specularStrength * light.color.a) * spec) * light.color.rgb *
+           attenuation * window * window * CalcPointShadow(index, fragPos, normal);
+}
+
+void main()
+{
+    uint  tile  = materialTiles[material * maxTiles + gl_WorkGroupID.x];
+    ivec2 pixel = ivec2(tile & 0xffffu, tile >> 16) * TILE_SIZE + ivec2(gl_LocalInvocationID.xy);
+    ivec2 size  = renderSize;
+    if (any(greaterThanEqual(pixel, size)))
+        return;
+
+    uint visibility = imageLoad(visibilityImage, pixel).r;
+    if (visibility == EMPTY_PIXEL)
+        return;
+
+    DrawData draw = draws[visibility >> TRIANGLE_BITS];
+    if (draw.material != material)
+        return;
+
+    uint triangle = visibility & ((1u << TRIANGLE_BITS) - 1u);
+    uint i0       = indices[draw.firstIndex + triangle * 3 + 0] + draw.baseVertex;
+    uint i1       = indices[draw.firstIndex + triangle * 3 + 1] + draw.baseVertex;
+    uint i2       = indices[draw.firstIndex + triangle * 3 + 2] + draw.baseVertex;
+
+    vec3 w0 = vec3(draw.model * vec4(loadPosition(i0), 1.0));
+    vec3 w1 = vec3(draw.model * vec4(loadPosition(i1), 1.0));
+    vec3 w2 = vec3(draw.model * vec4(loadPosition(i2), 1.0));
+
+    vec2         pixelNdc = (vec2(pixel) + 0.5) / vec2(size) * 2.0 - 1.0;
+    Barycentrics bary     = computeBarycentrics(viewProjection * vec4(w0, 1.0),
+                                            viewProjection * vec4(w1, 1.0),
+                                            viewProjection * vec4(w2, 1.0),
+                                            pixelNdc,
+                                            vec2(size));
+
+    vec2 uv0       = loadTexCoords(i0);
+    vec2 uv1       = loadTexCoords(i1);
+    vec2 uv2       = loadTexCoords(i2);
+    vec2 texCoords = uv0 * bary.lambda.x + uv1 * bary.lambda.y + uv2 * bary.lambda.z;
+    vec2 texDx     = uv0 * bary.ddx.x + uv1 * bary.ddx.y + uv2 * bary.ddx.z;
+    vec2 texDy     = uv0 * bary.ddy.x + uv1 * bary.ddy.y + uv2 * bary.ddy.z;
+
+    vec3 fragPos = w0 * bary.lambda.x + w1 * bary.lambda.y + w2 * bary.lambda.z;
+    vec3 normal  = loadNormal(i0) * bary.lambda.x + loadNormal(i1) * bary.lambda.y +
+                  loadNormal(i2) * bary.lambda.z;
+    normal = normalize(mat3(draw.normalMatrix) * normal);
+
+    vec3  albedo           = textureGrad(texture_diffuse1, texCoords, texDx, texDy).rgb;
+    float specularStrength = hasSpecularMap ?
+                                 textureGrad(texture_specular1, texCoords, texDx, texDy).r :
+                                 0.3;
+
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec2 lightmapTexCoords = loadLightmapTexCoords(i0) * bary.lambda.x +
+                             loadLightmapTexCoords(i1) * bary.lambda.y +
+                             loadLightmapTexCoords(i2) * bary.lambda.z;
+    float bakedOcclusion = loadOcclusion(i0) * bary.lambda.x + loadOcclusion(i1) * bary.lambda.y +
+                           loadOcclusion(i2) * bary.lambda.z;
+    bakedOcclusion *= textureLod(bakedLightmap, lightmapTexCoords, 0.0).r;
+
+    // ambient, darkened by the baked and the screen-space occlusion
+    ivec2 occlusionTexel = min(pixel, textureSize(ambientOcclusion, 0) - 1);
+    float occlusion      = texelFetch(ambientOcclusion, occlusionTexel, 0).r * bakedOcclusion;
+    vec3  color          = 0.05 * occlusion * albedo;
+    float shadow         = CalcShadow(fragPos, normal);
+    color += CalcDirLight(albedo, specularStrength, normal, viewDir, shadow);
+
+    for (uint index = 0; index < lightCount; index++)
+    {
+        color += CalcPointLight(index, albedo, specularStrength, normal, fragPos, viewDir);
+    }
+
+    imageStore(litImage, pixel, vec4(color, 1.0));
+}
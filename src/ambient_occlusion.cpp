@@ -0,0 +1,283 @@
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+#include "ambient_occlusion.h"
+
+static constexpr uint32_t k_group_size = 8;
+
+// occlusion radius in world units, about the size of a chair in the scene
+static constexpr float k_radius = 0.5f;
+
+struct QualityPreset
+{
+    uint32_t base_level; // pyramid level the occlusion is computed at
+    uint32_t slices;
+    uint32_t steps;      // per side of a slice
+};
+
+static constexpr QualityPreset k_presets[] = {
+    {1, 1, 4}, // low
+    {0, 2, 4}, // medium
+    {0, 3, 6}, // high
+};
+
+static uint32_t groupCount(uint32_t size)
+{
+    return (size + k_group_size - 1) / k_group_size;
+}
+
+AmbientOcclusion::AmbientOcclusion(uint32_t width, uint32_t height) :
+    width_(width),
+    height_(height),
+    depth_shader_("../../../shader/ao_depth.cs"),
+    gtao_shader_("../../../shader/ao_gtao.cs"),
+    temporal_shader_("../../../shader/ao_temporal.cs"),
+    spatial_shader_("../../../shader/ao_spatial.cs"),
+    upsample_shader_("../../../shader/ao_upsample.cs")
+{
+    const uint8_t white = 255;
+    glGenTextures(1, &white_tex_);
+    glBindTexture(GL_TEXTURE_2D, white_tex_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8, 1, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RED, GL_UNSIGNED_BYTE, &white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    createTargets();
+}
+
+AmbientOcclusion::~AmbientOcclusion()
+{
+    destroyTargets();
+    glDeleteTextures(1, &white_tex_);
+}
+
+void AmbientOcclusion::resize(uint32_t width, uint32_t height)
+{
+    if (width == width_ && height == height_)
+        return;
+
+    width_  = width;
+    height_ = height;
+
+    destroyTargets();
+    createTargets();
+}
+
+void AmbientOcclusion::setQuality(Quality quality)
+{
+    if (quality != quality_)
+        resetHistory();
+    quality_ = quality;
+}
+
+void AmbientOcclusion::render(uint32_t         depth_texture,
+                              uint32_t         width,
+                              uint32_t         height,
+                              const glm::mat4& view,
+                              const glm::mat4& projection)
+{
+    const QualityPreset& preset = k_presets[static_cast<uint32_t>(quality_)];
+
+    timer_.begin();
+
+    uint32_t level_width[k_pyramid_levels];
+    uint32_t level_height[k_pyramid_levels];
+    level_width[0]  = std::max((width + 1) / 2, 1u);
+    level_height[0] = std::max((height + 1) / 2, 1u);
+    for (uint32_t level = 1; level < k_pyramid_levels; level++)
+    {
+        level_width[level]  = std::max((level_width[level - 1] + 1) / 2, 1u);
+        level_height[level] = std::max((level_height[level - 1] + 1) / 2, 1u);
+    }
+
+    // texels in use, and the exact size they cover, as the texel centers map to the render area
+    const uint32_t  low_width  = level_width[preset.base_level];
+    const uint32_t  low_height = level_height[preset.base_level];
+    const glm::vec2 base_area  = glm::vec2(width, height) / float(2u << preset.base_level);
+    const float     far_depth  = projection[3][2] / (1.f + projection[2][2]);
+
+    // depth pyramid
+    depth_shader_.use();
+    depth_shader_.setVec2f("projectionDepth", projection[2][2], projection[3][2]);
+    glActiveTexture(GL_TEXTURE0);
+    for (uint32_t level = 0; level < k_pyramid_levels; level++)
+    {
+        depth_shader_.setBool("fromDepthBuffer", level == 0);
+        depth_shader_.setInt("sourceLevel", level == 0 ? 0 : level - 1);
+        if (level == 0)
+            depth_shader_.setVec2i("sourceArea", width, height);
+        else
+            depth_shader_.setVec2i("sourceArea", level_width[level - 1], level_height[level - 1]);
+        depth_shader_.setVec2i("targetArea", level_width[level], level_height[level]);
+
+        glBindTexture(GL_TEXTURE_2D, level == 0 ? depth_texture : pyramid_tex_);
+        glBindImageTexture(0, pyramid_tex_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute(groupCount(level_width[level]), groupCount(level_height[level]), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    // horizon search
+    gtao_shader_.use();
+    gtao_shader_.setInt("baseLevel", preset.base_level);
+    gtao_shader_.setVec2i("area", low_width, low_height);
+    gtao_shader_.setVec2f("baseArea", base_area.x, base_area.y);
+    gtao_shader_.setVec4f("unproject",
+                          1.f / projection[0][0],
+                          1.f / projection[1][1],
+                          projection[2][0],
+                          projection[2][1]);
+    gtao_shader_.setFloat("projectionScale", projection[1][1] * 0.5f * base_area.y);
+    gtao_shader_.setFloat("farDepth", far_depth * 0.999f);
+    gtao_shader_.setFloat("radius", k_radius);
+    gtao_shader_.setInt("sliceCount", preset.slices);
+    gtao_shader_.setInt("stepCount", preset.steps);
+    gtao_shader_.setUint("frame", frame_);
+
+    glBindTexture(GL_TEXTURE_2D, pyramid_tex_);
+    glBindImageTexture(0, occlusion_tex_, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R16F);
+    glDispatchCompute(groupCount(low_width), groupCount(low_height), 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    // temporal accumulation into the current history
+    const uint32_t  current_history = history_tex_[history_index_];
+    const glm::mat4 inverse_view    = glm::inverse(view);
+
+    temporal_shader_.use();
+    temporal_shader_.setInt("baseLevel", preset.base_level);
+    temporal_shader_.setVec2i("area", low_width, low_height);
+    temporal_shader_.setVec2f("baseArea", base_area.x, base_area.y);
+    temporal_shader_.setVec2f("previousBaseArea", history_area_.x, history_area_.y);
+    temporal_shader_.setVec2f("historySize", (float)half_width_, (float)half_height_);
+    temporal_shader_.setBool("historyValid", history_valid_);
+    temporal_shader_.setVec4f("unproject",
+                              1.f / projection[0][0],
+                              1.f / projection[1][1],
+                              projection[2][0],
+                              projection[2][1]);
+    temporal_shader_.setFloat("farDepth", far_depth * 0.999f);
+    temporal_shader_.setMat4fv("inverseView", glm::value_ptr(inverse_view));
+    temporal_shader_.setMat4fv("previousViewProjection",
+                               glm::value_ptr(previous_view_projection_));
+
+    glBindTexture(GL_TEXTURE_2D, occlusion_tex_);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, pyramid_tex_);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, history_tex_[history_index_ ^ 1]);
+    glBindImageTexture(0, current_history, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
+    glDispatchCompute(groupCount(low_width), groupCount(low_height), 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    // spatial denoise
+    spatial_shader_.use();
+    spatial_shader_.setVec2i("area", low_width, low_height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, current_history);
+    glBindImageTexture(0, blurred_tex_, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+    glDispatchCompute(groupCount(low_width), groupCount(low_height), 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    // bilateral upsample to the render resolution
+    upsample_shader_.use();
+    upsample_shader_.setInt("baseLevel", preset.base_level);
+    upsample_shader_.setVec2i("area", width, height);
+    upsample_shader_.setVec2i("lowArea", low_width, low_height);
+    upsample_shader_.setVec2f("projectionDepth", projection[2][2], projection[3][2]);
+
+    glBindTexture(GL_TEXTURE_2D, blurred_tex_);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, pyramid_tex_);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depth_texture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindImageTexture(0, output_tex_, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8);
+    glDispatchCompute(groupCount(width), groupCount(height), 1);
+    // sampled by the shading passes
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    timer_.end();
+
+    previous_view_projection_ = projection * view;
+    history_area_             = base_area;
+    history_valid_            = true;
+    history_index_ ^= 1;
+    frame_++;
+}
+
+void AmbientOcclusion::bind(uint32_t texture_unit, bool enabled) const
+{
+    glActiveTexture(GL_TEXTURE0 + texture_unit);
+    glBindTexture(GL_TEXTURE_2D, enabled ? output_tex_ : white_tex_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+size_t AmbientOcclusion::getMemoryUsage() const
+{
+    size_t pyramid = 0;
+    for (uint32_t level = 0; level < k_pyramid_levels; level++)
+    {
+        pyramid += static_cast<size_t>(half_width_ >> level) * (half_height_ >> level) * 4;
+    }
+
+    // R16F raw and R8 blurred occlusion, two RG16F histories, R8 output
+    const size_t half = static_cast<size_t>(half_width_) * half_height_;
+    return pyramid + half * (2 + 1 + 2 * 4) + static_cast<size_t>(width_) * height_;
+}
+
+void AmbientOcclusion::createTargets()
+{
+    // rounded up so every pyramid level has room for the rounded up area of the level above
+    const uint32_t alignment = 1u << k_pyramid_levels;
+    half_width_  = ((width_ + 1) / 2 + alignment - 1) / alignment * alignment;
+    half_height_ = ((height_ + 1) / 2 + alignment - 1) / alignment * alignment;
+
+    auto create_texture = [](GLenum internal_format, uint32_t width, uint32_t height) {
+        uint32_t texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    };
+
+    glGenTextures(1, &pyramid_tex_);
+    glBindTexture(GL_TEXTURE_2D, pyramid_tex_);
+    glTexStorage2D(GL_TEXTURE_2D, k_pyramid_levels, GL_R32F, half_width_, half_height_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    occlusion_tex_ = create_texture(GL_R16F, half_width_, half_height_);
+    blurred_tex_   = create_texture(GL_R8, half_width_, half_height_);
+    output_tex_    = create_texture(GL_R8, width_, height_);
+    for (uint32_t& history : history_tex_)
+    {
+        // reprojected with bilinear filtering
+        history = create_texture(GL_RG16F, half_width_, half_height_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    history_valid_ = false;
+
+    std::cout << "Info: Ambient occlusion " << half_width_ << "x" << half_height_ << " targets, "
+              << getMemoryUsage() / (1024 * 1024) << " MB" << std::endl;
+}
+
+void AmbientOcclusion::destroyTargets()
+{
+    const uint32_t textures[] = {
+        pyramid_tex_, occlusion_tex_, blurred_tex_, history_tex_[0], history_tex_[1], output_tex_};
+    glDeleteTextures(6, textures);
+}
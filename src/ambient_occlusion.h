@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gpu_timer.h"
+#include "shader.h"
+
+// Screen-space ambient occlusion at reduced resolution, in compute:
+//   - depth: a linear depth pyramid, its first level half the render size, each texel averaging
+//     the depths of four texels that lie close to the nearest of them,
+//   - gtao: horizon-based occlusion at half or quarter resolution, distant samples read coarser
+//     pyramid levels,
+//   - denoise: temporal accumulation with depth-checked reprojection, then a depth-aware blur,
+//   - upsample: a bilateral upsample against the full-resolution depth into an R8 texture.
+// The shading passes multiply their ambient term with the result, or with the 1x1 white texture
+// bind() puts in its place when the occlusion is off.
+class AmbientOcclusion {
+public:
+    static constexpr uint32_t k_pyramid_levels = 4;
+
+    enum class Quality
+    {
+        low,    // quarter resolution, 1 slice of 4 steps
+        medium, // half resolution, 2 slices of 4 steps
+        high    // half resolution, 3 slices of 6 steps
+    };
+
+    AmbientOcclusion(uint32_t width, uint32_t height);
+    ~AmbientOcclusion();
+
+    AmbientOcclusion(const AmbientOcclusion&) = delete;
+    AmbientOcclusion& operator=(const AmbientOcclusion&) = delete;
+
+    // output size, the pyramid and the half-resolution targets follow it
+    void resize(uint32_t width, uint32_t height);
+
+    void setQuality(Quality quality);
+    Quality getQuality() const
+    {
+        return quality_;
+    }
+
+    // the next frame starts the accumulation over, for camera cuts
+    void resetHistory()
+    {
+        history_valid_ = false;
+    }
+
+    // occlusion of the bottom-left width x height of the depth texture into the same area of the
+    // output. The projection may be jittered, the previous view-projection is kept for the
+    // reprojection of the next frame
+    void render(uint32_t         depth_texture,
+                uint32_t         width,
+                uint32_t         height,
+                const glm::mat4& view,
+                const glm::mat4& projection);
+
+    uint32_t getOutputTexture() const
+    {
+        return output_tex_;
+    }
+
+    // binds the occlusion, or a white texture when disabled, for the shading passes
+    void bind(uint32_t texture_unit, bool enabled) const;
+
+    float getGpuMs() const
+    {
+        return timer_.getElapsedMs();
+    }
+
+    // pyramid, history and output in bytes, for reporting
+    size_t getMemoryUsage() const;
+
+private:
+    void createTargets();
+    void destroyTargets();
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t half_width_; // storage of the first pyramid level and the occlusion targets
+    uint32_t half_height_;
+    Quality  quality_ {Quality::medium};
+
+    uint32_t pyramid_tex_ {0};
+    uint32_t occlusion_tex_ {0}; // raw estimate of the frame
+    uint32_t blurred_tex_ {0};
+    uint32_t history_tex_[2] {0, 0}; // occlusion and linear depth, ping-ponged
+    uint32_t output_tex_ {0};
+    uint32_t white_tex_ {0};
+
+    uint32_t  history_index_ {0};
+    bool      history_valid_ {false};
+    glm::vec2 history_area_ {1.f}; // base level area of the last frame in the history
+    glm::mat4 previous_view_projection_ {1.f};
+    uint32_t  frame_ {0};
+
+    Shader   depth_shader_;
+    Shader   gtao_shader_;
+    Shader   temporal_shader_;
+    Shader   spatial_shader_;
+    Shader   upsample_shader_;
+    GpuTimer timer_;
+};
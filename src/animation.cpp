@@ -0,0 +1,284 @@
+#include <assimp/scene.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+
+#include "animation.h"
+
+// assimp matrices are row major
+static glm::mat4 toMat4(const aiMatrix4x4& matrix)
+{
+    return glm::transpose(glm::make_mat4(&matrix.a1));
+}
+
+int32_t Skeleton::findJoint(const std::string& name) const
+{
+    for (size_t joint = 0; joint < names.size(); joint++)
+    {
+        if (names[joint] == name)
+            return static_cast<int32_t>(joint);
+    }
+    return -1;
+}
+
+uint32_t Skeleton::addJoint(const std::string& name,
+                            uint32_t           parent,
+                            const glm::vec3&   translation,
+                            const glm::quat&   rotation,
+                            const glm::vec3&   scale)
+{
+    names.push_back(name);
+    parents.push_back(parent);
+    inverse_binds.push_back(glm::mat4(1.f));
+    bind_translations.push_back(translation);
+    bind_rotations.push_back(rotation);
+    bind_scales.push_back(scale);
+    return getJointCount() - 1;
+}
+
+void Pose::resize(uint32_t joint_count)
+{
+    translations.resize(joint_count);
+    rotations.resize(joint_count);
+    scales.resize(joint_count);
+}
+
+// marks the nodes that are bones or have one below them
+static bool markJoints(const aiNode*                           node,
+                       const std::map<std::string, glm::mat4>& bones,
+                       std::set<const aiNode*>&                joints)
+{
+    bool is_joint = bones.count(node->mName.C_Str()) > 0;
+    for (uint32_t index = 0; index < node->mNumChildren; index++)
+    {
+        is_joint = markJoints(node->mChildren[index], bones, joints) || is_joint;
+    }
+    if (is_joint)
+        joints.insert(node);
+    return is_joint;
+}
+
+static void addJoints(const aiNode*                           node,
+                      uint32_t                                parent,
+                      const std::map<std::string, glm::mat4>& bones,
+                      const std::set<const aiNode*>&          joints,
+                      Skeleton&                               skeleton)
+{
+    if (joints.count(node) == 0)
+        return;
+
+    aiVector3D   scaling, position;
+    aiQuaternion rotation;
+    node->mTransformation.Decompose(scaling, rotation, position);
+
+    const std::string name  = node->mName.C_Str();
+    const uint32_t    joint = skeleton.addJoint(
+        name,
+        parent,
+        glm::vec3(position.x, position.y, position.z),
+        glm::quat(rotation.w, rotation.x, rotation.y, rotation.z),
+        glm::vec3(scaling.x, scaling.y, scaling.z));
+
+    const auto bone = bones.find(name);
+    if (bone != bones.end())
+        skeleton.inverse_binds[joint] = bone->second;
+
+    for (uint32_t index = 0; index < node->mNumChildren; index++)
+    {
+        addJoints(node->mChildren[index], joint, bones, joints, skeleton);
+    }
+}
+
+bool importSkeleton(const aiScene* scene, Skeleton& skeleton)
+{
+    skeleton = Skeleton();
+
+    std::map<std::string, glm::mat4> bones;
+    for (uint32_t mesh = 0; mesh < scene->mNumMeshes; mesh++)
+    {
+        for (uint32_t index = 0; index < scene->mMeshes[mesh]->mNumBones; index++)
+        {
+            const aiBone* bone = scene->mMeshes[mesh]->mBones[index];
+            bones.emplace(bone->mName.C_Str(), toMat4(bone->mOffsetMatrix));
+        }
+    }
+    if (bones.empty())
+        return false;
+
+    std::set<const aiNode*> joints;
+    markJoints(scene->mRootNode, bones, joints);
+    addJoints(scene->mRootNode, Skeleton::k_no_parent, bones, joints, skeleton);
+    return skeleton.getJointCount() > 0;
+}
+
+void importClips(const aiScene* scene, const Skeleton& skeleton, std::vector<AnimationClip>& clips)
+{
+    for (uint32_t index = 0; index < scene->mNumAnimations; index++)
+    {
+        const aiAnimation* animation = scene->mAnimations[index];
+        // formats that leave the rate out count in frames, at 25 a second by assimp's convention
+        const double seconds_per_tick =
+            1.0 / (animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0);
+
+        AnimationClip clip;
+        clip.name     = animation->mName.C_Str();
+        clip.duration = static_cast<float>(animation->mDuration * seconds_per_tick);
+        clip.tracks.resize(skeleton.getJointCount());
+
+        for (uint32_t channel_index = 0; channel_index < animation->mNumChannels; channel_index++)
+        {
+            const aiNodeAnim* channel = animation->mChannels[channel_index];
+            const int32_t     joint   = skeleton.findJoint(channel->mNodeName.C_Str());
+            if (joint < 0)
+                continue;
+
+            JointTrack& track = clip.tracks[joint];
+            for (uint32_t key = 0; key < channel->mNumPositionKeys; key++)
+            {
+                const aiVectorKey& source = channel->mPositionKeys[key];
+                track.translations.push_back(
+                    {static_cast<float>(source.mTime * seconds_per_tick),
+                     glm::vec3(source.mValue.x, source.mValue.y, source.mValue.z)});
+            }
+            for (uint32_t key = 0; key < channel->mNumRotationKeys; key++)
+            {
+                const aiQuatKey&    source = channel->mRotationKeys[key];
+                const aiQuaternion& value  = source.mValue;
+                track.rotations.push_back({static_cast<float>(source.mTime * seconds_per_tick),
+                                           glm::quat(value.w, value.x, value.y, value.z)});
+            }
+            for (uint32_t key = 0; key < channel->mNumScalingKeys; key++)
+            {
+                const aiVectorKey& source = channel->mScalingKeys[key];
+                track.scales.push_back(
+                    {static_cast<float>(source.mTime * seconds_per_tick),
+                     glm::vec3(source.mValue.x, source.mValue.y, source.mValue.z)});
+            }
+        }
+
+        clips.push_back(std::move(clip));
+    }
+}
+
+// the last key at or before time, the first one before the track starts
+template <typename T>
+static size_t findKey(const std::vector<AnimationKey<T>>& keys, float time)
+{
+    const auto next = std::upper_bound(
+        keys.begin(), keys.end(), time, [](float value, const AnimationKey<T>& key) {
+            return value < key.time;
+        });
+    return next == keys.begin() ? 0 : static_cast<size_t>(next - keys.begin()) - 1;
+}
+
+// fraction of the way from key to key + 1, 0 when time is outside the keys
+template <typename T>
+static float keyFraction(const std::vector<AnimationKey<T>>& keys, size_t key, float time)
+{
+    if (key + 1 >= keys.size() || time <= keys[key].time)
+        return 0.f;
+    return std::min((time - keys[key].time) / (keys[key + 1].time - keys[key].time), 1.f);
+}
+
+static glm::vec3
+sampleTrack(const std::vector<AnimationKey<glm::vec3>>& keys, float time, const glm::vec3& bind)
+{
+    if (keys.empty())
+        return bind;
+
+    const size_t key      = findKey(keys, time);
+    const float  fraction = keyFraction(keys, key, time);
+    if (fraction == 0.f)
+        return keys[key].value;
+    return glm::mix(keys[key].value, keys[key + 1].value, fraction);
+}
+
+static glm::quat
+sampleTrack(const std::vector<AnimationKey<glm::quat>>& keys, float time, const glm::quat& bind)
+{
+    if (keys.empty())
+        return bind;
+
+    const size_t key      = findKey(keys, time);
+    const float  fraction = keyFraction(keys, key, time);
+    if (fraction == 0.f)
+        return keys[key].value;
+    return glm::slerp(keys[key].value, keys[key + 1].value, fraction);
+}
+
+void sampleClip(const Skeleton& skeleton, const AnimationClip& clip, float time, Pose& pose)
+{
+    if (clip.duration > 0.f)
+    {
+        time = std::fmod(time, clip.duration);
+        if (time < 0.f)
+            time += clip.duration;
+    }
+    sampleClipClamped(skeleton, clip, time, pose);
+}
+
+void sampleClipClamped(const Skeleton& skeleton, const AnimationClip& clip, float time, Pose& pose)
+{
+    const uint32_t joint_count = skeleton.getJointCount();
+    pose.resize(joint_count);
+    for (uint32_t joint = 0; joint < joint_count; joint++)
+    {
+        const JointTrack& track = clip.tracks[joint];
+        pose.translations[joint] =
+            sampleTrack(track.translations, time, skeleton.bind_translations[joint]);
+        pose.rotations[joint] = sampleTrack(track.rotations, time, skeleton.bind_rotations[joint]);
+        pose.scales[joint]    = sampleTrack(track.scales, time, skeleton.bind_scales[joint]);
+    }
+}
+
+void blendPoses(const Pose& a, const Pose& b, float weight, Pose& pose)
+{
+    const uint32_t joint_count = static_cast<uint32_t>(a.rotations.size());
+    pose.resize(joint_count);
+    for (uint32_t joint = 0; joint < joint_count; joint++)
+    {
+        pose.translations[joint] = glm::mix(a.translations[joint], b.translations[joint], weight);
+    }
+    for (uint32_t joint = 0; joint < joint_count; joint++)
+    {
+        const glm::quat& from = a.rotations[joint];
+        const glm::quat  to = glm::dot(from, b.rotations[joint]) < 0.f ? -b.rotations[joint] :
+                                                                          b.rotations[joint];
+        pose.rotations[joint] = glm::normalize(from * (1.f - weight) + to * weight);
+    }
+    for (uint32_t joint = 0; joint < joint_count; joint++)
+    {
+        pose.scales[joint] = glm::mix(a.scales[joint], b.scales[joint], weight);
+    }
+}
+
+void computeSkinningMatrices(const Skeleton&         skeleton,
+                             const Pose&             pose,
+                             std::vector<glm::mat4>& model_space,
+                             JointMatrix*            palette)
+{
+    const uint32_t joint_count = skeleton.getJointCount();
+    model_space.resize(joint_count);
+    for (uint32_t joint = 0; joint < joint_count; joint++)
+    {
+        glm::mat4 local = glm::mat4_cast(pose.rotations[joint]);
+        local[0] *= pose.scales[joint].x;
+        local[1] *= pose.scales[joint].y;
+        local[2] *= pose.scales[joint].z;
+        local[3] = glm::vec4(pose.translations[joint], 1.f);
+
+        const uint32_t parent = skeleton.parents[joint];
+        model_space[joint] =
+            parent == Skeleton::k_no_parent ? local : model_space[parent] * local;
+
+        const glm::mat4 skinning = model_space[joint] * skeleton.inverse_binds[joint];
+        for (uint32_t row = 0; row < 3; row++)
+        {
+            palette[joint].rows[row] =
+                glm::vec4(skinning[0][row], skinning[1][row], skinning[2][row], skinning[3][row]);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct aiScene;
+
+// Joint hierarchy of a skinned model: every node of the imported scene that is a bone or an
+// ancestor of one, parents before their children
+class Skeleton {
+public:
+    static constexpr uint32_t k_no_parent = UINT32_MAX;
+
+    std::vector<std::string> names;
+    std::vector<uint32_t>    parents;
+    // mesh space to joint space at bind time, identity for joints no vertex is bound to
+    std::vector<glm::mat4> inverse_binds;
+
+    // local transforms of the bind pose, what joints without an animation track keep
+    std::vector<glm::vec3> bind_translations;
+    std::vector<glm::quat> bind_rotations;
+    std::vector<glm::vec3> bind_scales;
+
+    uint32_t getJointCount() const
+    {
+        return static_cast<uint32_t>(parents.size());
+    }
+
+    // -1 when no joint has that name
+    int32_t findJoint(const std::string& name) const;
+
+    // appends a joint, the parent must already be in the skeleton
+    uint32_t addJoint(const std::string& name,
+                      uint32_t           parent,
+                      const glm::vec3&   translation,
+                      const glm::quat&   rotation,
+                      const glm::vec3&   scale);
+};
+
+template <typename T>
+struct AnimationKey
+{
+    float time; // seconds
+    T     value;
+};
+
+// keys of one joint sorted by time, an empty channel keeps the bind pose
+struct JointTrack
+{
+    std::vector<AnimationKey<glm::vec3>> translations;
+    std::vector<AnimationKey<glm::quat>> rotations;
+    std::vector<AnimationKey<glm::vec3>> scales;
+};
+
+struct AnimationClip
+{
+    std::string             name;
+    float                   duration {0.f}; // seconds
+    std::vector<JointTrack> tracks;         // one per joint of the skeleton
+};
+
+// Local joint transforms as separate arrays, so sampling and blending stream through each one
+struct Pose
+{
+    std::vector<glm::vec3> translations;
+    std::vector<glm::quat> rotations;
+    std::vector<glm::vec3> scales;
+
+    void resize(uint32_t joint_count);
+};
+
+// Skinning matrix of a joint, the first three rows of the affine transform from mesh space to
+// posed model space. 48 bytes instead of the 64 of a mat4, laid out as the shaders read it
+struct JointMatrix
+{
+    glm::vec4 rows[3];
+};
+
+// joints of every bone of the scene's meshes and their ancestors. Returns false when the scene
+// has no bones
+bool importSkeleton(const aiScene* scene, Skeleton& skeleton);
+
+// every animation of the scene, channels of nodes that aren't joints are dropped. Key times are
+// converted from ticks to seconds
+void importClips(const aiScene* scene, const Skeleton& skeleton, std::vector<AnimationClip>& clips);
+
+// interpolates every track at time, which is wrapped into the clip so clips loop
+void sampleClip(const Skeleton& skeleton, const AnimationClip& clip, float time, Pose& pose);
+
+// the same without the wrap, tracks hold their first and last keys outside of them
+void sampleClipClamped(const Skeleton& skeleton, const AnimationClip& clip, float time, Pose& pose);
+
+// weight 0 is a, 1 is b. Rotations are normalized lerps on the shortest arc
+void blendPoses(const Pose& a, const Pose& b, float weight, Pose& pose);
+
+// concatenates the local transforms down the hierarchy and writes the skinning matrix of every
+// joint. model_space is scratch of the joint count
+void computeSkinningMatrices(const Skeleton&         skeleton,
+                             const Pose&             pose,
+                             std::vector<glm::mat4>& model_space,
+                             JointMatrix*            palette);
@@ -0,0 +1,405 @@
+// CPU benchmark of the crowd pose evaluation, no GPU needed. Compresses the clips of an animated
+// model, or of a procedural skeleton when no model is given, reports the compression ratio, the
+// error against the imported clips and the sampling throughput of both, then evaluates a crowd of
+// characters on one thread and on every thread, checks both give the same palettes and reports
+// the throughput. Fails when the compressed clips miss the tolerances at the resampled frames:
+//   animation_benchmark [model] [options]
+//     --characters <n>          crowd size (default 1000)
+//     --frames <n>              frames timed per run (default 300)
+//     --threads <n>             worker threads, 0 for all (default)
+//     --joints <n>              joints of the procedural skeleton (default 64)
+//     --sample-rate <hz>        frames per second the clips are resampled at (default 30)
+//     --rotation-error <rad>    rotation tolerance of the key reduction (default 0.0002)
+//     --translation-error <x>   translation and scale tolerance (default 0.0001)
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "animation.h"
+#include "animation_compression.h"
+#include "animation_system.h"
+#include "job_system.h"
+
+static constexpr float    k_pi         = 3.14159265f;
+static constexpr float    k_time_step  = 1.f / 60.f;
+static constexpr float    k_key_rate   = 30.f; // keys per second of the procedural clips
+static constexpr uint32_t k_chain_size = 8;
+static constexpr uint32_t k_sample_count = 20000; // time points of the error and sampling runs
+static constexpr float    k_root_travel  = 100.f; // forward root motion of the odd clips
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static uint32_t hash(uint32_t value)
+{
+    const uint32_t state = value * 747796405u + 2891336453u;
+    const uint32_t word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+static float toUnitFloat(uint32_t value)
+{
+    return (value >> 8) * (1.f / 16777216.f);
+}
+
+// chains of k_chain_size joints, each hanging off a joint of the first chain like the spine,
+// limbs and fingers of a character
+static void createSkeleton(uint32_t joint_count, Skeleton& skeleton)
+{
+    std::vector<glm::mat4> bind_model_space;
+    for (uint32_t joint = 0; joint < joint_count; joint++)
+    {
+        uint32_t parent = joint - 1;
+        if (joint == 0)
+            parent = Skeleton::k_no_parent;
+        else if (joint % k_chain_size == 0)
+            parent = joint / k_chain_size - 1;
+
+        const glm::vec3 translation(0.f, joint == 0 ? 1.f : 0.1f, 0.f);
+        skeleton.addJoint("joint" + std::to_string(joint),
+                          parent,
+                          translation,
+                          glm::quat(1.f, 0.f, 0.f, 0.f),
+                          glm::vec3(1.f));
+
+        const glm::mat4 local = glm::translate(glm::mat4(1.f), translation);
+        bind_model_space.push_back(
+            parent == Skeleton::k_no_parent ? local : bind_model_space[parent] * local);
+        skeleton.inverse_binds[joint] = glm::inverse(bind_model_space[joint]);
+    }
+}
+
+// every joint swings around its own axis, the root also bounces and, in the odd clips, walks
+// k_root_travel units forward, further than 16-bit keys reach within the default error
+static AnimationClip createClip(const Skeleton& skeleton, uint32_t clip_index)
+{
+    // a whole number of key intervals long, like exported clips
+    const uint32_t key_count = static_cast<uint32_t>((1.f + 0.25f * clip_index) * k_key_rate) + 1;
+
+    AnimationClip clip;
+    clip.name     = "procedural" + std::to_string(clip_index);
+    clip.duration = (key_count - 1) / k_key_rate;
+    clip.tracks.resize(skeleton.getJointCount());
+
+    for (uint32_t joint = 0; joint < skeleton.getJointCount(); joint++)
+    {
+        const float     angle = static_cast<float>(joint);
+        const glm::vec3 axis  = glm::normalize(glm::vec3(std::sin(angle), std::cos(angle), 0.5f));
+        for (uint32_t key = 0; key < key_count; key++)
+        {
+            const float time  = key / k_key_rate;
+            const float phase = 2.f * k_pi * time / clip.duration + 0.3f * joint + clip_index;
+            clip.tracks[joint].rotations.push_back(
+                {time, glm::angleAxis(0.5f * std::sin(phase), axis)});
+            if (joint == 0)
+            {
+                const float travel = clip_index % 2 ? k_root_travel * time / clip.duration : 0.f;
+                const glm::vec3 motion(0.f, 0.05f * std::sin(phase), travel);
+                clip.tracks[joint].translations.push_back(
+                    {time, skeleton.bind_translations[0] + motion});
+            }
+        }
+    }
+    return clip;
+}
+
+static bool loadAnimation(const std::string&          path,
+                          Skeleton&                   skeleton,
+                          std::vector<AnimationClip>& clips)
+{
+    Assimp::Importer importer;
+    const aiScene*   scene = importer.ReadFile(path, 0);
+    if (!scene || !scene->mRootNode)
+    {
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return false;
+    }
+    if (!importSkeleton(scene, skeleton))
+    {
+        std::cout << "ERROR::ANIMATION:: " << path << " has no bones" << std::endl;
+        return false;
+    }
+    importClips(scene, skeleton, clips);
+    if (clips.empty())
+    {
+        std::cout << "ERROR::ANIMATION:: " << path << " has no animations" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// largest differences between the imported and the compressed clips: angle of the local
+// rotations, distance of the local translations and scales, and distance of the joints in model
+// space, where the errors of the parents add up
+struct PoseError
+{
+    float rotation {0.f};
+    float translation {0.f};
+    float scale {0.f};
+    float position {0.f};
+};
+
+// over random time points, or over the frames the clips were resampled at, the only ones the
+// tolerances bound
+static PoseError measureError(const Skeleton&                    skeleton,
+                              const std::vector<AnimationClip>&  clips,
+                              const std::vector<CompressedClip>& compressed,
+                              bool                               at_frames)
+{
+    Pose                     reference;
+    Pose                     decoded;
+    std::vector<glm::mat4>   reference_space;
+    std::vector<glm::mat4>   decoded_space;
+    std::vector<JointMatrix> palette(skeleton.getJointCount());
+
+    std::vector<std::pair<uint32_t, float>> times; // clip and time point
+    for (uint32_t clip = 0; clip < clips.size(); clip++)
+    {
+        for (uint32_t frame = 0; at_frames && frame <= compressed[clip].interval_count; frame++)
+        {
+            times.emplace_back(
+                clip, std::min(frame / compressed[clip].sample_rate, compressed[clip].duration));
+        }
+    }
+    for (uint32_t sample = 0; !at_frames && sample < k_sample_count; sample++)
+    {
+        const uint32_t clip = sample % clips.size();
+        times.emplace_back(clip, clips[clip].duration * toUnitFloat(hash(sample)));
+    }
+
+    PoseError error;
+    for (const auto& time : times)
+    {
+        sampleClip(skeleton, clips[time.first], time.second, reference);
+        sampleClip(skeleton, compressed[time.first], time.second, decoded);
+        computeSkinningMatrices(skeleton, reference, reference_space, palette.data());
+        computeSkinningMatrices(skeleton, decoded, decoded_space, palette.data());
+
+        for (uint32_t joint = 0; joint < skeleton.getJointCount(); joint++)
+        {
+            // the acos of the dot product loses too much precision near 0
+            const glm::quat delta =
+                glm::conjugate(reference.rotations[joint]) * decoded.rotations[joint];
+            const float angle =
+                2.f * std::atan2(glm::length(glm::vec3(delta.x, delta.y, delta.z)), delta.w);
+            error.rotation    = std::max(error.rotation, std::min(angle, 4.f * k_pi - angle));
+            error.translation = std::max(
+                error.translation,
+                glm::length(reference.translations[joint] - decoded.translations[joint]));
+            error.scale =
+                std::max(error.scale, glm::length(reference.scales[joint] - decoded.scales[joint]));
+            error.position = std::max(
+                error.position,
+                glm::length(glm::vec3(reference_space[joint][3] - decoded_space[joint][3])));
+        }
+    }
+    return error;
+}
+
+static void reportError(const char* name, const PoseError& error)
+{
+    std::cout << "Info: max error " << name << " " << error.rotation << " rad local rotation, "
+              << error.translation << " local translation, " << error.scale << " local scale, "
+              << error.position << " model space joint position" << std::endl;
+}
+
+// poses per second sampling random time points of the clips on one thread
+template <typename Clip>
+static double measureSampling(const Skeleton& skeleton, const std::vector<Clip>& clips)
+{
+    Pose pose;
+    sampleClip(skeleton, clips[0], 0.f, pose);
+
+    const Clock::time_point start = Clock::now();
+    for (uint32_t sample = 0; sample < k_sample_count; sample++)
+    {
+        const uint32_t clip = sample % clips.size();
+        sampleClip(skeleton, clips[clip], clips[clip].duration * toUnitFloat(hash(sample)), pose);
+    }
+    return k_sample_count / secondsSince(start);
+}
+
+// the same crowd for every run: two clips, a blend weight, a phase and a speed per character
+static void addCharacters(AnimationSystem& system, uint32_t count, uint32_t clip_count)
+{
+    for (uint32_t index = 0; index < count; index++)
+    {
+        AnimationSystem::Character character;
+        character.clips[0] = hash(index * 4 + 0) % clip_count;
+        character.clips[1] = hash(index * 4 + 1) % clip_count;
+        character.times[0] = toUnitFloat(hash(index * 4 + 2));
+        character.times[1] = character.times[0];
+        character.blend    = toUnitFloat(hash(index * 4 + 3));
+        character.speed    = 0.8f + 0.4f * toUnitFloat(hash(hash(index)));
+        system.addCharacter(character);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string model_path;
+    uint32_t    character_count = 1000;
+    uint32_t    frame_count     = 300;
+    uint32_t    thread_count    = 0;
+    uint32_t    joint_count     = 64;
+
+    CompressionSettings settings;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--characters") == 0 && index + 1 < argc)
+            character_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--frames") == 0 && index + 1 < argc)
+            frame_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            thread_count = std::max(0, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--joints") == 0 && index + 1 < argc)
+            joint_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--sample-rate") == 0 && index + 1 < argc)
+            settings.sample_rate = std::max(1.f, static_cast<float>(atof(argv[++index])));
+        else if (strcmp(argv[index], "--rotation-error") == 0 && index + 1 < argc)
+            settings.rotation_error = static_cast<float>(atof(argv[++index]));
+        else if (strcmp(argv[index], "--translation-error") == 0 && index + 1 < argc)
+        {
+            settings.translation_error = static_cast<float>(atof(argv[++index]));
+            settings.scale_error       = settings.translation_error;
+        }
+        else if (argv[index][0] != '-')
+            model_path = argv[index];
+    }
+
+    Skeleton                   skeleton;
+    std::vector<AnimationClip> clips;
+    if (model_path.empty())
+    {
+        createSkeleton(joint_count, skeleton);
+        for (uint32_t clip = 0; clip < 4; clip++)
+        {
+            clips.push_back(createClip(skeleton, clip));
+        }
+    }
+    else if (!loadAnimation(model_path, skeleton, clips))
+    {
+        return 1;
+    }
+
+    size_t key_count = 0;
+    for (const auto& clip : clips)
+    {
+        for (const auto& track : clip.tracks)
+        {
+            key_count += track.translations.size() + track.rotations.size() + track.scales.size();
+        }
+    }
+    std::cout << "Info: " << (model_path.empty() ? "procedural" : model_path) << ", "
+              << skeleton.getJointCount() << " joints, " << clips.size() << " clips, " << key_count
+              << " keys, " << character_count << " characters" << std::endl;
+
+    // the bind pose has to give identity palettes, or the inverse binds don't match the joints
+    AnimationClip bind_clip;
+    bind_clip.tracks.resize(skeleton.getJointCount());
+    Pose                     bind_pose;
+    std::vector<glm::mat4>   model_space;
+    std::vector<JointMatrix> bind_palette(skeleton.getJointCount());
+    sampleClip(skeleton, bind_clip, 0.f, bind_pose);
+    computeSkinningMatrices(skeleton, bind_pose, model_space, bind_palette.data());
+    float bind_error = 0.f;
+    for (const auto& matrix : bind_palette)
+    {
+        for (uint32_t row = 0; row < 3; row++)
+        {
+            for (uint32_t column = 0; column < 4; column++)
+            {
+                const float expected = row == column ? 1.f : 0.f;
+                bind_error = std::max(bind_error, std::abs(matrix.rows[row][column] - expected));
+            }
+        }
+    }
+    std::cout << "Info: bind pose palette error " << bind_error << std::endl;
+
+    std::vector<CompressedClip> compressed;
+    size_t                      raw_size        = 0;
+    size_t                      compressed_size = 0;
+    const Clock::time_point     compress_start  = Clock::now();
+    for (const auto& clip : clips)
+    {
+        compressed.push_back(compressClip(skeleton, clip, settings));
+        raw_size += getMemoryUsage(clip);
+        compressed_size += compressed.back().getMemoryUsage();
+    }
+    const double compress_seconds = secondsSince(compress_start);
+    std::cout << "Info: compressed " << raw_size / 1024 << " KB to " << compressed_size / 1024
+              << " KB, ratio " << static_cast<double>(raw_size) / compressed_size << ", in "
+              << compress_seconds * 1e3 << " ms" << std::endl;
+
+    const PoseError frame_error = measureError(skeleton, clips, compressed, true);
+    reportError("at the frames", frame_error);
+    reportError("between them", measureError(skeleton, clips, compressed, false));
+    // the compression works in the same floats, a little slack covers the sampling's rounding
+    const float slack = 1.01f;
+    if (frame_error.rotation > slack * settings.rotation_error ||
+        frame_error.translation > slack * settings.translation_error ||
+        frame_error.scale > slack * settings.scale_error)
+    {
+        std::cout << "ERROR::ANIMATION_BENCHMARK:: the compressed clips miss the tolerances"
+                  << std::endl;
+        return 1;
+    }
+
+    const double raw_rate        = measureSampling(skeleton, clips);
+    const double compressed_rate = measureSampling(skeleton, compressed);
+    std::cout << "Info: sampling " << 1e-6 * raw_rate * skeleton.getJointCount()
+              << " Mjoints/s imported, " << 1e-6 * compressed_rate * skeleton.getJointCount()
+              << " Mjoints/s compressed" << std::endl;
+
+    JobSystem                jobs(thread_count);
+    JobSystem                single_thread(1);
+    std::vector<JointMatrix> palettes[2];
+    uint32_t                 run = 0;
+    for (JobSystem* pool : {&single_thread, &jobs})
+    {
+        AnimationSystem system(skeleton, compressed);
+        addCharacters(system, character_count, static_cast<uint32_t>(clips.size()));
+        palettes[run].resize(system.getPaletteSize());
+
+        // the first frame sizes the scratch poses
+        system.update(k_time_step, *pool, palettes[run].data());
+
+        const Clock::time_point start = Clock::now();
+        for (uint32_t frame = 0; frame < frame_count; frame++)
+        {
+            system.update(k_time_step, *pool, palettes[run].data());
+        }
+        const double seconds = secondsSince(start);
+
+        std::cout << "Info:   " << pool->getThreadCount() << " threads: "
+                  << seconds * 1e3 / frame_count << " ms per frame, "
+                  << 1e-6 * system.getPaletteSize() * frame_count / seconds << " Mjoints/s, "
+                  << system.getPaletteSize() * sizeof(JointMatrix) / 1024 << " KB of palettes"
+                  << std::endl;
+        run++;
+    }
+
+    // every character only depends on its own state, the thread count must not change anything
+    if (memcmp(palettes[0].data(),
+               palettes[1].data(),
+               palettes[0].size() * sizeof(JointMatrix)) != 0)
+    {
+        std::cout << "ERROR::ANIMATION:: palettes differ between thread counts" << std::endl;
+        return 1;
+    }
+    return 0;
+}
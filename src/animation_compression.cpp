@@ -0,0 +1,485 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "animation_compression.h"
+
+static constexpr float    k_sqrt2        = 1.41421356f;
+static constexpr uint32_t k_rotation_max = 0x7fff; // 15 bits per component
+static constexpr uint32_t k_vector_max   = 0xffff;
+static constexpr uint32_t k_key_words    = 3; // of a quantized key
+
+// the channels of a joint, in the order of CompressedClip::tracks
+static constexpr uint32_t k_rotation_channel    = 0;
+static constexpr uint32_t k_translation_channel = 1;
+static constexpr uint32_t k_scale_channel       = 2;
+static constexpr uint32_t k_channel_count       = 3;
+
+static uint32_t countBits(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    return __popcnt(bits);
+#else
+    return static_cast<uint32_t>(__builtin_popcount(bits));
+#endif
+}
+
+// index of the highest and lowest set bit, bits must not be 0
+static uint32_t highestBit(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse(&index, bits);
+    return index;
+#else
+    return 31 - static_cast<uint32_t>(__builtin_clz(bits));
+#endif
+}
+
+static uint32_t lowestBit(uint32_t bits)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return index;
+#else
+    return static_cast<uint32_t>(__builtin_ctz(bits));
+#endif
+}
+
+// rotations are handled as xyzw, translations and scales as xyz0
+static glm::vec4 toVec4(const glm::quat& rotation)
+{
+    return glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+}
+
+static glm::quat toQuat(const glm::vec4& rotation)
+{
+    return glm::quat(rotation.w, rotation.x, rotation.y, rotation.z);
+}
+
+static float trackError(uint32_t channel, const glm::vec4& a, const glm::vec4& b)
+{
+    if (channel != k_rotation_channel)
+        return glm::length(glm::vec3(a) - glm::vec3(b));
+
+    // angle of the rotation from a to b
+    const glm::quat delta = glm::conjugate(toQuat(a)) * toQuat(b);
+    return 2.f * std::atan2(glm::length(glm::vec3(delta.x, delta.y, delta.z)), std::abs(delta.w));
+}
+
+static glm::vec4 interpolate(uint32_t channel, const glm::vec4& a, const glm::vec4& b, float alpha)
+{
+    if (channel != k_rotation_channel)
+        return glm::mix(a, b, alpha);
+
+    const glm::vec4 to = glm::dot(a, b) < 0.f ? -b : b;
+    return glm::normalize(glm::mix(a, to, alpha));
+}
+
+// the largest component is implied by the unit length, its index goes into the top bits of the
+// first two words. The other three lie within +-1/sqrt(2)
+static void encodeRotation(glm::vec4 rotation, uint16_t* words)
+{
+    uint32_t largest = 0;
+    for (uint32_t component = 1; component < 4; component++)
+    {
+        if (std::abs(rotation[component]) > std::abs(rotation[largest]))
+            largest = component;
+    }
+    if (rotation[largest] < 0.f)
+        rotation = -rotation;
+
+    uint32_t word = 0;
+    for (uint32_t component = 0; component < 4; component++)
+    {
+        if (component == largest)
+            continue;
+
+        const float normalized = glm::clamp(rotation[component] * k_sqrt2 * 0.5f + 0.5f, 0.f, 1.f);
+        words[word++] = static_cast<uint16_t>(std::lround(normalized * k_rotation_max));
+    }
+    words[0] |= static_cast<uint16_t>((largest & 1) << 15);
+    words[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+}
+
+static glm::vec4 decodeRotation(const uint16_t* words)
+{
+    const uint32_t largest = (words[0] >> 15) | (words[1] >> 15) << 1;
+
+    glm::vec4 rotation;
+    float     length_squared = 0.f;
+    uint32_t  word           = 0;
+    for (uint32_t component = 0; component < 4; component++)
+    {
+        if (component == largest)
+            continue;
+
+        const float normalized = (words[word++] & k_rotation_max) * (1.f / k_rotation_max);
+        rotation[component]    = (normalized * 2.f - 1.f) * (1.f / k_sqrt2);
+        length_squared += rotation[component] * rotation[component];
+    }
+    rotation[largest] = std::sqrt(std::max(1.f - length_squared, 0.f));
+    return rotation;
+}
+
+static void
+encodeVector(const glm::vec4& value, const glm::vec3& min, const glm::vec3& extent, uint16_t* words)
+{
+    for (uint32_t component = 0; component < 3; component++)
+    {
+        const float normalized =
+            extent[component] > 0.f ? (value[component] - min[component]) / extent[component] : 0.f;
+        words[component] =
+            static_cast<uint16_t>(std::lround(glm::clamp(normalized, 0.f, 1.f) * k_vector_max));
+    }
+}
+
+static glm::vec4 decodeVector(const uint16_t* words, const glm::vec3& min, const glm::vec3& extent)
+{
+    const glm::vec3 normalized = glm::vec3(words[0], words[1], words[2]) * (1.f / k_vector_max);
+    return glm::vec4(min + extent * normalized, 0.f);
+}
+
+// full precision keys: the floats of xyzw rotations and xyz vectors, two words each
+static uint32_t fullKeyWords(uint32_t channel)
+{
+    return channel == k_rotation_channel ? 8 : 6;
+}
+
+static void encodeFull(uint32_t channel, const glm::vec4& value, uint16_t* words)
+{
+    memcpy(words, &value[0], fullKeyWords(channel) * sizeof(uint16_t));
+}
+
+static glm::vec4 decodeFull(uint32_t channel, const uint16_t* words)
+{
+    glm::vec4 value(0.f);
+    memcpy(&value[0], words, fullKeyWords(channel) * sizeof(uint16_t));
+    return value;
+}
+
+size_t CompressedClip::getMemoryUsage() const
+{
+    return sizeof(CompressedClip) + tracks.size() * sizeof(Track) +
+           constants.size() * sizeof(glm::vec4) +
+           (range_mins.size() + range_extents.size()) * sizeof(glm::vec3) +
+           segment_offsets.size() * sizeof(uint32_t) + segments.size() * sizeof(uint16_t);
+}
+
+size_t getMemoryUsage(const AnimationClip& clip)
+{
+    size_t size = sizeof(AnimationClip) + clip.tracks.size() * sizeof(JointTrack);
+    for (const auto& track : clip.tracks)
+    {
+        size += track.translations.size() * sizeof(AnimationKey<glm::vec3>) +
+                track.rotations.size() * sizeof(AnimationKey<glm::quat>) +
+                track.scales.size() * sizeof(AnimationKey<glm::vec3>);
+    }
+    return size;
+}
+
+CompressedClip compressClip(const Skeleton&            skeleton,
+                            const AnimationClip&       clip,
+                            const CompressionSettings& settings)
+{
+    const uint32_t joint_count = skeleton.getJointCount();
+    const float    errors[k_channel_count] = {
+        settings.rotation_error, settings.translation_error, settings.scale_error};
+
+    CompressedClip compressed;
+    compressed.name           = clip.name;
+    compressed.duration       = std::max(clip.duration, 0.f);
+    compressed.interval_count = std::max(
+        1u,
+        static_cast<uint32_t>(std::ceil(compressed.duration * settings.sample_rate - 1e-3f)));
+    compressed.sample_rate = compressed.duration > 0.f ?
+                                 compressed.interval_count / compressed.duration :
+                                 settings.sample_rate;
+    const uint32_t frame_count = compressed.interval_count + 1;
+
+    // every track resampled, frames[channel * joint_count + joint][frame]. Consecutive rotations
+    // are kept on the same hemisphere so they interpolate on the shortest arc
+    std::vector<std::vector<glm::vec4>> frames(k_channel_count * joint_count,
+                                               std::vector<glm::vec4>(frame_count));
+    Pose pose;
+    for (uint32_t frame = 0; frame < frame_count; frame++)
+    {
+        const float time = std::min(frame / compressed.sample_rate, compressed.duration);
+        sampleClipClamped(skeleton, clip, time, pose);
+        for (uint32_t joint = 0; joint < joint_count; joint++)
+        {
+            glm::vec4 rotation = glm::normalize(toVec4(pose.rotations[joint]));
+            if (frame > 0 && glm::dot(rotation, frames[joint][frame - 1]) < 0.f)
+                rotation = -rotation;
+
+            const glm::vec4 translation(pose.translations[joint], 0.f);
+            const glm::vec4 scale(pose.scales[joint], 0.f);
+            frames[k_rotation_channel * joint_count + joint][frame]    = rotation;
+            frames[k_translation_channel * joint_count + joint][frame] = translation;
+            frames[k_scale_channel * joint_count + joint][frame]       = scale;
+        }
+    }
+
+    // drops the tracks within the error of one value, quantizes the others
+    std::vector<uint32_t>               animated;  // track of frames
+    std::vector<uint32_t>               key_words; // of every key of the track
+    std::vector<std::vector<uint16_t>>  encoded;
+    std::vector<std::vector<glm::vec4>> decoded; // what sampling gets back from encoded
+    compressed.tracks.resize(k_channel_count * joint_count);
+    for (uint32_t channel = 0; channel < k_channel_count; channel++)
+    {
+        for (uint32_t joint = 0; joint < joint_count; joint++)
+        {
+            const std::vector<glm::vec4>& values = frames[channel * joint_count + joint];
+            auto within = [&](const glm::vec4& value) {
+                for (const auto& frame_value : values)
+                {
+                    if (trackError(channel, frame_value, value) > errors[channel])
+                        return false;
+                }
+                return true;
+            };
+
+            glm::vec4 bind = toVec4(skeleton.bind_rotations[joint]);
+            if (channel == k_translation_channel)
+                bind = glm::vec4(skeleton.bind_translations[joint], 0.f);
+            else if (channel == k_scale_channel)
+                bind = glm::vec4(skeleton.bind_scales[joint], 0.f);
+
+            CompressedClip::Track& track =
+                compressed.tracks[joint * k_channel_count + channel];
+            if (within(bind))
+            {
+                track = CompressedClip::Track::bind;
+                continue;
+            }
+            if (within(values[0]))
+            {
+                track = CompressedClip::Track::constant;
+                compressed.constants.push_back(values[0]);
+                continue;
+            }
+
+            track = CompressedClip::Track::animated;
+            animated.push_back(channel * joint_count + joint);
+            key_words.push_back(k_key_words);
+            encoded.emplace_back(frame_count * k_key_words);
+            decoded.emplace_back(frame_count);
+
+            glm::vec3 min(values[0]);
+            glm::vec3 max(values[0]);
+            for (const auto& value : values)
+            {
+                min = glm::min(min, glm::vec3(value));
+                max = glm::max(max, glm::vec3(value));
+            }
+
+            bool quantized = true;
+            for (uint32_t frame = 0; frame < frame_count; frame++)
+            {
+                uint16_t* words = &encoded.back()[frame * k_key_words];
+                if (channel == k_rotation_channel)
+                {
+                    encodeRotation(values[frame], words);
+                    decoded.back()[frame] = decodeRotation(words);
+                }
+                else
+                {
+                    encodeVector(values[frame], min, max - min, words);
+                    decoded.back()[frame] = decodeVector(words, min, max - min);
+                }
+                quantized &=
+                    trackError(channel, values[frame], decoded.back()[frame]) <= errors[channel];
+            }
+
+            // a track the quantization alone can't keep within the error, one spanning more than
+            // about 13 units at the default error, keeps its keys at full precision
+            if (!quantized)
+            {
+                track            = CompressedClip::Track::animated_full;
+                key_words.back() = fullKeyWords(channel);
+                encoded.back().resize(frame_count * key_words.back());
+                for (uint32_t frame = 0; frame < frame_count; frame++)
+                {
+                    uint16_t* words = &encoded.back()[frame * key_words.back()];
+                    encodeFull(channel, values[frame], words);
+                    decoded.back()[frame] = decodeFull(channel, words);
+                }
+            }
+            else if (channel != k_rotation_channel)
+            {
+                compressed.range_mins.push_back(min);
+                compressed.range_extents.push_back(max - min);
+            }
+        }
+    }
+    compressed.animated_count = static_cast<uint32_t>(animated.size());
+
+    // the keys of every segment: from each kept frame, the furthest one that interpolates every
+    // frame in between within the error is kept next
+    const uint32_t segment_count =
+        (compressed.interval_count + CompressedClip::k_segment_intervals - 1) /
+        CompressedClip::k_segment_intervals;
+    for (uint32_t segment = 0; segment < segment_count; segment++)
+    {
+        const uint32_t first = segment * CompressedClip::k_segment_intervals;
+        const uint32_t last =
+            std::min(first + CompressedClip::k_segment_intervals, compressed.interval_count);
+
+        const size_t masks = compressed.segments.size();
+        compressed.segment_offsets.push_back(static_cast<uint32_t>(masks));
+        compressed.segments.resize(masks + animated.size());
+
+        for (size_t index = 0; index < animated.size(); index++)
+        {
+            const uint32_t                channel = animated[index] / joint_count;
+            const std::vector<glm::vec4>& values  = frames[animated[index]];
+            auto fits = [&](uint32_t from, uint32_t to) {
+                for (uint32_t frame = from + 1; frame < to; frame++)
+                {
+                    const float     alpha = static_cast<float>(frame - from) / (to - from);
+                    const glm::vec4 value =
+                        interpolate(channel, decoded[index][from], decoded[index][to], alpha);
+                    if (trackError(channel, value, values[frame]) > errors[channel])
+                        return false;
+                }
+                return true;
+            };
+
+            uint32_t mask = 1;
+            for (uint32_t key = first; key < last;)
+            {
+                uint32_t next = key + 1;
+                while (next < last && fits(key, next + 1))
+                {
+                    next++;
+                }
+                mask |= 1u << (next - first);
+                key = next;
+            }
+            compressed.segments[masks + index] = static_cast<uint16_t>(mask);
+
+            for (uint32_t frame = first; frame <= last; frame++)
+            {
+                if (mask & (1u << (frame - first)))
+                {
+                    const uint16_t* words = &encoded[index][frame * key_words[index]];
+                    compressed.segments.insert(
+                        compressed.segments.end(), words, words + key_words[index]);
+                }
+            }
+        }
+    }
+
+    return compressed;
+}
+
+void sampleClip(const Skeleton& skeleton, const CompressedClip& clip, float time, Pose& pose)
+{
+    if (clip.duration > 0.f)
+    {
+        time = std::fmod(time, clip.duration);
+        if (time < 0.f)
+            time += clip.duration;
+    }
+
+    const uint32_t segment_count = static_cast<uint32_t>(clip.segment_offsets.size());
+    const float    frame =
+        glm::clamp(time * clip.sample_rate, 0.f, static_cast<float>(clip.interval_count));
+    const uint32_t segment = std::min(
+        static_cast<uint32_t>(frame) / CompressedClip::k_segment_intervals, segment_count - 1);
+    const uint32_t first = segment * CompressedClip::k_segment_intervals;
+    const uint32_t last =
+        std::min(first + CompressedClip::k_segment_intervals, clip.interval_count) - first;
+    const float local = frame - static_cast<float>(first);
+    // frames up to the one starting the interval local is in
+    const uint32_t below = (2u << std::min(static_cast<uint32_t>(local), last - 1)) - 1;
+
+    const uint16_t* masks = clip.segments.data() + clip.segment_offsets[segment];
+    const uint16_t* keys  = masks + clip.animated_count;
+
+    const uint32_t joint_count = skeleton.getJointCount();
+    pose.resize(joint_count);
+
+    uint32_t animated = 0;
+    uint32_t constant = 0;
+    uint32_t range    = 0;
+    for (uint32_t channel = 0; channel < k_channel_count; channel++)
+    {
+        for (uint32_t joint = 0; joint < joint_count; joint++)
+        {
+            glm::vec4 value;
+            switch (clip.tracks[joint * k_channel_count + channel])
+            {
+            case CompressedClip::Track::bind:
+                if (channel == k_rotation_channel)
+                    pose.rotations[joint] = skeleton.bind_rotations[joint];
+                else if (channel == k_translation_channel)
+                    pose.translations[joint] = skeleton.bind_translations[joint];
+                else
+                    pose.scales[joint] = skeleton.bind_scales[joint];
+                continue;
+
+            case CompressedClip::Track::constant:
+                value = clip.constants[constant++];
+                break;
+
+            case CompressedClip::Track::animated:
+            {
+                const uint32_t mask     = masks[animated++];
+                const uint32_t previous = highestBit(mask & below);
+                const uint32_t next     = lowestBit(mask & ~below);
+                const float alpha = (local - static_cast<float>(previous)) / (next - previous);
+
+                const uint32_t  key  = countBits(mask & ((1u << previous) - 1));
+                const uint16_t* from = keys + key * k_key_words;
+                if (channel == k_rotation_channel)
+                {
+                    value = interpolate(
+                        channel, decodeRotation(from), decodeRotation(from + k_key_words), alpha);
+                }
+                else
+                {
+                    const glm::vec3& min    = clip.range_mins[range];
+                    const glm::vec3& extent = clip.range_extents[range];
+                    range++;
+                    value = glm::mix(decodeVector(from, min, extent),
+                                     decodeVector(from + k_key_words, min, extent),
+                                     alpha);
+                }
+                keys += countBits(mask) * k_key_words;
+                break;
+            }
+
+            case CompressedClip::Track::animated_full:
+            {
+                const uint32_t mask     = masks[animated++];
+                const uint32_t previous = highestBit(mask & below);
+                const uint32_t next     = lowestBit(mask & ~below);
+                const float alpha = (local - static_cast<float>(previous)) / (next - previous);
+
+                const uint32_t  words = fullKeyWords(channel);
+                const uint32_t  key   = countBits(mask & ((1u << previous) - 1));
+                const uint16_t* from  = keys + key * words;
+
+                value = interpolate(
+                    channel, decodeFull(channel, from), decodeFull(channel, from + words), alpha);
+                keys += countBits(mask) * words;
+                break;
+            }
+            }
+
+            if (channel == k_rotation_channel)
+                pose.rotations[joint] = toQuat(value);
+            else if (channel == k_translation_channel)
+                pose.translations[joint] = glm::vec3(value);
+            else
+                pose.scales[joint] = glm::vec3(value);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "animation.h"
+
+struct CompressionSettings
+{
+    // frames per second the tracks are resampled at, best the rate the clips were exported at:
+    // the errors below bound the difference at those frames only
+    float sample_rate {30.f};
+    float rotation_error {0.0002f};    // radians
+    float translation_error {0.0001f}; // model units
+    float scale_error {0.0001f};
+};
+
+// Runtime form of an AnimationClip.
+//
+// The tracks are resampled at a uniform rate. A track that stays within the error of the bind
+// pose is dropped, one that stays within the error of a single value keeps only that value. The
+// other tracks are cut into segments of k_segment_intervals frame intervals. Each segment keeps
+// the frames of a track that linear interpolation between them can't reproduce within the error,
+// its first and last frame always. Rotations are quantized to the three smallest components of
+// the quaternion, 15 bits each, translations and scales to 16 bits per component over the range
+// of their track. A track whose quantized keys miss the error, a translation spanning a long way,
+// keeps them as floats instead.
+//
+// A segment is one contiguous block of 16-bit words: a mask of the kept frames per animated
+// track, then the keys of every animated track, 3 words each, or the words of the floats of full
+// precision keys, rotation tracks first, then translations, then scales, in joint order. Sampling
+// a time point reads one block front to back.
+struct CompressedClip
+{
+    static constexpr uint32_t k_segment_intervals = 15; // 16 frames, one bit each in the masks
+
+    enum class Track : uint8_t
+    {
+        bind,
+        constant,
+        animated,
+        animated_full // keys at full precision
+    };
+
+    std::string name;
+    float       duration {0.f};
+    float       sample_rate {0.f}; // adjusted so the duration is a whole number of intervals
+    uint32_t    interval_count {0};
+
+    // rotation, translation and scale of every joint
+    std::vector<Track> tracks;
+    // xyzw of the constant rotations, then xyz of the translations, then of the scales
+    std::vector<glm::vec4> constants;
+    // quantization range of the quantized translations, then of the scales
+    std::vector<glm::vec3> range_mins;
+    std::vector<glm::vec3> range_extents;
+    uint32_t               animated_count {0};
+
+    std::vector<uint32_t> segment_offsets; // in words
+    std::vector<uint16_t> segments;
+
+    size_t getMemoryUsage() const;
+};
+
+// memory of the keys of a clip as imported
+size_t getMemoryUsage(const AnimationClip& clip);
+
+CompressedClip compressClip(const Skeleton&            skeleton,
+                            const AnimationClip&       clip,
+                            const CompressionSettings& settings);
+
+// like sampleClip(), time wraps into the clip
+void sampleClip(const Skeleton& skeleton, const CompressedClip& clip, float time, Pose& pose);
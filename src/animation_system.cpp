@@ -0,0 +1,51 @@
+#include "animation_system.h"
+#include "job_system.h"
+
+// characters per batch, enough to amortize pulling it from the shared counter
+static constexpr uint32_t k_batch_size = 16;
+
+AnimationSystem::AnimationSystem(const Skeleton&                    skeleton,
+                                 const std::vector<CompressedClip>& clips)
+    : skeleton_(skeleton), clips_(clips)
+{
+}
+
+uint32_t AnimationSystem::addCharacter(const Character& character)
+{
+    characters_.push_back(character);
+    return getCharacterCount() - 1;
+}
+
+void AnimationSystem::update(float delta_time, JobSystem& jobs, JointMatrix* palettes)
+{
+    if (clips_.empty() || characters_.empty())
+        return;
+
+    scratch_.resize(jobs.getThreadCount());
+
+    const uint32_t joint_count = skeleton_.getJointCount();
+    jobs.parallelFor(
+        getCharacterCount(), k_batch_size, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+            Scratch& scratch = scratch_[thread];
+            for (uint32_t index = begin; index < end; index++)
+            {
+                Character& character = characters_[index];
+                for (uint32_t clip = 0; clip < 2; clip++)
+                {
+                    const CompressedClip& source = clips_[character.clips[clip]];
+                    character.times[clip] += delta_time * character.speed;
+                    if (source.duration > 0.f && character.times[clip] >= source.duration)
+                        character.times[clip] -= source.duration;
+
+                    sampleClip(skeleton_, source, character.times[clip], scratch.sampled[clip]);
+                }
+
+                blendPoses(
+                    scratch.sampled[0], scratch.sampled[1], character.blend, scratch.blended);
+                computeSkinningMatrices(skeleton_,
+                                        scratch.blended,
+                                        scratch.model_space,
+                                        palettes + static_cast<size_t>(index) * joint_count);
+            }
+        });
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "animation_compression.h"
+
+class JobSystem;
+
+// Poses a crowd of characters sharing one skeleton. Every character plays two clips of the
+// skeleton at its own times and blends them. update() evaluates the characters in parallel, each
+// thread keeps its own poses, and writes the skinning palettes straight to the destination, which
+// may be mapped GPU memory: it is only ever written, in order.
+class AnimationSystem {
+public:
+    struct Character
+    {
+        uint32_t clips[2] {0, 0};
+        float    times[2] {0.f, 0.f}; // seconds into each clip
+        float    blend {0.f};         // weight of the second clip
+        float    speed {1.f};
+    };
+
+    // the skeleton and clips must outlive the system
+    AnimationSystem(const Skeleton& skeleton, const std::vector<CompressedClip>& clips);
+
+    uint32_t addCharacter(const Character& character);
+
+    Character& getCharacter(uint32_t index)
+    {
+        return characters_[index];
+    }
+    uint32_t getCharacterCount() const
+    {
+        return static_cast<uint32_t>(characters_.size());
+    }
+
+    // JointMatrix count of all the palettes, character i's starts at i * the joint count
+    uint32_t getPaletteSize() const
+    {
+        return getCharacterCount() * skeleton_.getJointCount();
+    }
+
+    // advances every character by delta_time and writes its palette
+    void update(float delta_time, JobSystem& jobs, JointMatrix* palettes);
+
+private:
+    struct Scratch
+    {
+        Pose                   sampled[2];
+        Pose                   blended;
+        std::vector<glm::mat4> model_space;
+    };
+
+    const Skeleton&                    skeleton_;
+    const std::vector<CompressedClip>& clips_;
+    std::vector<Character>             characters_;
+    std::vector<Scratch>               scratch_; // per thread
+};
@@ -0,0 +1,124 @@
+#include <fstream>
+#include <iostream>
+
+#include "asset_file.h"
+#include "asset_pack.h"
+
+// the pack paths are looked up in, mounted once at startup before anything loads
+struct MountedPack
+{
+    AssetPack   pack;
+    std::string root; // normalized, empty for the working directory
+    JobSystem*  jobs {nullptr};
+};
+
+static MountedPack mounted_pack;
+
+bool AssetFile::mountPack(const std::string& pack_path, const std::string& root, JobSystem* jobs)
+{
+    unmountPack();
+    if (!mounted_pack.pack.open(pack_path))
+        return false;
+
+    mounted_pack.root = AssetPack::normalizePath(root);
+    mounted_pack.jobs = jobs;
+    if (mounted_pack.root == ".")
+        mounted_pack.root.clear();
+    return true;
+}
+
+void AssetFile::unmountPack()
+{
+    mounted_pack.pack.close();
+    mounted_pack.root.clear();
+    mounted_pack.jobs = nullptr;
+}
+
+bool AssetFile::isPackMounted()
+{
+    return mounted_pack.pack.isOpen();
+}
+
+// the entry of a path under the root of the pack, nullptr for paths outside it or not packed
+static const AssetPackEntry* findEntry(const std::string& path)
+{
+    if (!mounted_pack.pack.isOpen())
+        return nullptr;
+
+    const std::string  normalized = AssetPack::normalizePath(path);
+    const std::string& root       = mounted_pack.root;
+    if (root.empty())
+        return mounted_pack.pack.find(normalized);
+    if (normalized.size() <= root.size() || normalized.compare(0, root.size(), root) != 0 ||
+        normalized[root.size()] != '/')
+        return nullptr;
+    return mounted_pack.pack.find(normalized.substr(root.size() + 1));
+}
+
+bool AssetFile::open(const std::string& path, bool use_jobs)
+{
+    close();
+
+    const AssetPackEntry* entry = findEntry(path);
+    if (!entry)
+    {
+        if (!file_.open(path))
+            return false;
+        data_ = file_.getData();
+        size_ = file_.getSize();
+        open_ = true;
+        return true;
+    }
+
+    if (entry->compression == static_cast<uint32_t>(AssetCompression::none))
+    {
+        data_ = reinterpret_cast<const char*>(mounted_pack.pack.getStoredData(*entry));
+    }
+    else
+    {
+        decompressed_.resize(static_cast<size_t>(entry->size));
+        if (!mounted_pack.pack.decompress(*entry,
+                                          use_jobs ? mounted_pack.jobs : nullptr,
+                                          reinterpret_cast<uint8_t*>(decompressed_.data())))
+        {
+            std::cout << "ERROR::ASSET_PACK:: the packed " << path << " is corrupt" << std::endl;
+            decompressed_.clear();
+            return false;
+        }
+        data_ = decompressed_.data();
+    }
+    size_   = static_cast<size_t>(entry->size);
+    open_   = true;
+    packed_ = true;
+    return true;
+}
+
+bool AssetFile::exists(const std::string& path)
+{
+    return findEntry(path) || std::ifstream(path, std::ios::binary).is_open();
+}
+
+bool AssetFile::isInPack(const std::string& path)
+{
+    return findEntry(path) != nullptr;
+}
+
+void AssetFile::close()
+{
+    file_.close();
+    decompressed_.clear();
+    decompressed_.shrink_to_fit();
+    data_   = nullptr;
+    size_   = 0;
+    open_   = false;
+    packed_ = false;
+}
+
+bool AssetFile::readText(const std::string& path, std::string& text)
+{
+    AssetFile file;
+    if (!file.open(path))
+        return false;
+    text.assign(file.getData(), file.getSize());
+    return true;
+}
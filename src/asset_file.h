@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+class JobSystem;
+
+// A file the loaders read, out of the mounted asset pack when it holds the file and from the disk
+// otherwise, so the same paths work with and without a pack. Files stored raw in the pack are
+// used in place and files on disk mapped like MappedFile does, compressed ones are decompressed
+// into memory the object owns.
+class AssetFile {
+public:
+    AssetFile() = default;
+
+    AssetFile(const AssetFile&) = delete;
+    AssetFile& operator=(const AssetFile&) = delete;
+
+    // Mounts the pack built from the directory root, see pack_assets: the paths opened from then
+    // on are looked up in it relative to root. Compressed entries are decompressed on the jobs
+    // when given, which makes opening them from inside a job wrong. Returns false with an error
+    // when the pack can't be read, the files on disk are read then
+    static bool mountPack(const std::string& pack_path, const std::string& root, JobSystem* jobs);
+    static void unmountPack();
+    static bool isPackMounted();
+
+    // returns false when neither the pack nor the disk has the file, or its entry is corrupt.
+    // Without use_jobs a compressed entry is decompressed on the calling thread, for opening files
+    // from inside a job
+    bool open(const std::string& path, bool use_jobs = true);
+    // whether open would find the file, without reading it
+    static bool exists(const std::string& path);
+    // whether open would read the file out of the mounted pack
+    static bool isInPack(const std::string& path);
+    void close();
+
+    bool isOpen() const
+    {
+        return open_;
+    }
+    const char* getData() const
+    {
+        return data_;
+    }
+    size_t getSize() const
+    {
+        return size_;
+    }
+    // read out of the pack rather than from the disk
+    bool isPacked() const
+    {
+        return packed_;
+    }
+
+    // reads a whole file as text, the way the shaders are
+    static bool readText(const std::string& path, std::string& text);
+
+private:
+    MappedFile        file_;
+    std::vector<char> decompressed_;
+    const char*       data_ {nullptr};
+    size_t            size_ {0};
+    bool              open_ {false};
+    bool              packed_ {false};
+};
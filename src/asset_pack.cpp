@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "asset_pack.h"
+#include "job_system.h"
+#include "lz4_block.h"
+
+static constexpr uint32_t k_magic   = 0x4b434150; // "PACK"
+static constexpr uint32_t k_version = 1;
+
+// the header, then the entries and their names, then the data of the entries in name order
+struct AssetPackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t names_size;
+};
+
+static_assert(sizeof(AssetPackEntry) == 40, "AssetPackEntry must not be padded");
+
+static uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + k_asset_pack_alignment - 1) & ~(k_asset_pack_alignment - 1);
+}
+
+static uint32_t getBlockCount(uint64_t size)
+{
+    return static_cast<uint32_t>((size + k_asset_pack_block_size - 1) / k_asset_pack_block_size);
+}
+
+static size_t getBlockSize(uint64_t size, uint32_t block)
+{
+    const uint64_t offset = uint64_t(block) * k_asset_pack_block_size;
+    return static_cast<size_t>(std::min<uint64_t>(k_asset_pack_block_size, size - offset));
+}
+
+bool AssetPack::open(const std::string& path)
+{
+    close();
+    if (!file_.open(path))
+    {
+        std::cout << "ERROR::ASSET_PACK:: can't open " << path << std::endl;
+        return false;
+    }
+
+    AssetPackHeader header = {};
+    const size_t    size   = file_.getSize();
+    if (size >= sizeof(header))
+        memcpy(&header, file_.getData(), sizeof(header));
+    const uint64_t table_size = uint64_t(header.entry_count) * sizeof(AssetPackEntry);
+    if (size < sizeof(header) || header.magic != k_magic || header.version != k_version ||
+        size - sizeof(header) < table_size + header.names_size)
+    {
+        std::cout << "ERROR::ASSET_PACK:: " << path << " is not a version " << k_version
+                  << " asset pack, pack it again" << std::endl;
+        close();
+        return false;
+    }
+
+    entries_.resize(header.entry_count);
+    memcpy(entries_.data(), file_.getData() + sizeof(header), static_cast<size_t>(table_size));
+    names_ = file_.getData() + sizeof(header) + table_size;
+
+    // lookups rely on the order, reads on the entries staying inside the file
+    for (size_t index = 0; index < entries_.size(); index++)
+    {
+        const AssetPackEntry& entry = entries_[index];
+        const bool            compressed =
+            entry.compression == static_cast<uint32_t>(AssetCompression::lz4);
+        bool valid = uint64_t(entry.name_offset) + entry.name_size <= header.names_size &&
+                     entry.offset <= size && entry.stored_size <= size - entry.offset;
+        if (compressed)
+        {
+            valid = valid && entry.block_count == getBlockCount(entry.size) &&
+                    entry.stored_size >= uint64_t(entry.block_count) * 4;
+        }
+        else
+        {
+            valid = valid && entry.compression == static_cast<uint32_t>(AssetCompression::none) &&
+                    entry.stored_size == entry.size;
+        }
+        if (valid && index > 0)
+            valid = getName(entries_[index - 1]) < getName(entry);
+
+        if (!valid)
+        {
+            std::cout << "ERROR::ASSET_PACK:: entry " << index << " of " << path << " is corrupt"
+                      << std::endl;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetPack::close()
+{
+    file_.close();
+    entries_.clear();
+    names_ = nullptr;
+}
+
+const AssetPackEntry* AssetPack::find(const std::string& name) const
+{
+    const auto entry = std::lower_bound(
+        entries_.begin(), entries_.end(), name, [&](const AssetPackEntry& a, const std::string& b) {
+            return b.compare(0, b.size(), names_ + a.name_offset, a.name_size) > 0;
+        });
+    if (entry == entries_.end() || name.compare(0, name.size(), names_ + entry->name_offset,
+                                                entry->name_size) != 0)
+        return nullptr;
+    return &*entry;
+}
+
+const uint8_t* AssetPack::getStoredData(const AssetPackEntry& entry) const
+{
+    return reinterpret_cast<const uint8_t*>(file_.getData() + entry.offset);
+}
+
+std::string AssetPack::getName(const AssetPackEntry& entry) const
+{
+    return std::string(names_ + entry.name_offset, entry.name_size);
+}
+
+bool AssetPack::decompress(const AssetPackEntry& entry,
+                           JobSystem*            jobs,
+                           uint8_t*              destination) const
+{
+    const uint8_t* data = getStoredData(entry);
+    if (entry.compression == static_cast<uint32_t>(AssetCompression::none))
+    {
+        memcpy(destination, data, static_cast<size_t>(entry.size));
+        return true;
+    }
+
+    // where every block starts, the sizes have to add up to the data after them
+    std::vector<uint32_t> block_sizes(entry.block_count);
+    std::vector<uint64_t> block_offsets(entry.block_count);
+    memcpy(block_sizes.data(), data, block_sizes.size() * 4);
+    uint64_t offset = uint64_t(entry.block_count) * 4;
+    for (uint32_t block = 0; block < entry.block_count; block++)
+    {
+        block_offsets[block] = offset;
+        offset += block_sizes[block];
+    }
+    if (offset != entry.stored_size)
+        return false;
+
+    std::atomic<bool> valid {true};
+    const auto        job = [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t block = begin; block < end; block++)
+        {
+            const size_t   size   = getBlockSize(entry.size, block);
+            const uint8_t* source = data + block_offsets[block];
+            uint8_t*       target = destination + size_t(block) * k_asset_pack_block_size;
+            if (block_sizes[block] == size)
+                memcpy(target, source, size);
+            else if (!decompressLz4Block(source, block_sizes[block], target, size))
+                valid = false;
+        }
+    };
+    if (jobs)
+        jobs->parallelFor(entry.block_count, 1, job);
+    else
+        job(0, entry.block_count, 0);
+    return valid;
+}
+
+bool AssetPack::write(const std::string&                  path,
+                      const std::vector<AssetPackSource>& sources,
+                      JobSystem&                          jobs)
+{
+    std::vector<AssetPackSource> sorted = sources;
+    std::sort(sorted.begin(),
+              sorted.end(),
+              [](const AssetPackSource& a, const AssetPackSource& b) { return a.name < b.name; });
+
+    std::vector<std::unique_ptr<MappedFile>> files;
+    for (size_t index = 0; index < sorted.size(); index++)
+    {
+        if (index > 0 && sorted[index].name == sorted[index - 1].name)
+        {
+            std::cout << "ERROR::ASSET_PACK:: " << sorted[index].name << " is packed twice"
+                      << std::endl;
+            return false;
+        }
+        files.push_back(std::make_unique<MappedFile>());
+        if (!files.back()->open(sorted[index].path))
+        {
+            std::cout << "ERROR::ASSET_PACK:: can't open " << sorted[index].path << std::endl;
+            return false;
+        }
+    }
+
+    // the blocks of every file go to the jobs together, so one large file doesn't hold the rest up
+    struct Block
+    {
+        uint32_t             file;
+        uint32_t             index;
+        std::vector<uint8_t> data; // empty when the block doesn't compress
+    };
+    std::vector<Block>    blocks;
+    std::vector<uint32_t> first_blocks(sorted.size());
+    for (uint32_t file = 0; file < files.size(); file++)
+    {
+        first_blocks[file] = static_cast<uint32_t>(blocks.size());
+        for (uint32_t block = 0; block < getBlockCount(files[file]->getSize()); block++)
+        {
+            blocks.push_back({file, block, {}});
+        }
+    }
+    const auto compress_blocks = [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t index = begin; index < end; index++)
+        {
+            Block&            block = blocks[index];
+            const MappedFile& file  = *files[block.file];
+            const size_t      size  = getBlockSize(file.getSize(), block.index);
+            const uint8_t*    source =
+                reinterpret_cast<const uint8_t*>(file.getData()) +
+                size_t(block.index) * k_asset_pack_block_size;
+            block.data.resize(getLz4Bound(size));
+            block.data.resize(compressLz4Block(source, size, block.data.data()));
+            if (block.data.size() >= size)
+                block.data.clear();
+        }
+    };
+    jobs.parallelFor(static_cast<uint32_t>(blocks.size()), 1, compress_blocks);
+
+    // the table and names, then every entry compressed or raw at the next aligned offset
+    std::vector<AssetPackEntry> entries(sorted.size());
+    std::string                 names;
+    for (const auto& source : sorted)
+    {
+        names += source.name;
+    }
+    const uint64_t table_end =
+        sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry) + names.size();
+    uint64_t offset      = alignOffset(table_end);
+    uint32_t name_offset = 0;
+    for (uint32_t file = 0; file < files.size(); file++)
+    {
+        AssetPackEntry& entry = entries[file];
+        entry.size            = files[file]->getSize();
+        entry.name_offset     = name_offset;
+        entry.name_size       = static_cast<uint32_t>(sorted[file].name.size());
+        name_offset += entry.name_size;
+
+        uint64_t compressed_size = uint64_t(getBlockCount(entry.size)) * 4;
+        for (uint32_t block = 0; block < getBlockCount(entry.size); block++)
+        {
+            const Block& stored = blocks[first_blocks[file] + block];
+            compressed_size += stored.data.empty() ? getBlockSize(entry.size, block)
+                                                   : stored.data.size();
+        }
+        const bool compress = compressed_size * 8 <= entry.size * 7;
+        entry.compression   = static_cast<uint32_t>(compress ? AssetCompression::lz4
+                                                             : AssetCompression::none);
+        entry.block_count   = compress ? getBlockCount(entry.size) : 0;
+        entry.stored_size   = compress ? compressed_size : entry.size;
+        entry.offset        = offset;
+        offset              = alignOffset(offset + entry.stored_size);
+    }
+
+    std::ofstream pack(path, std::ios::binary);
+    if (!pack)
+    {
+        std::cout << "ERROR::ASSET_PACK:: Failed to write " << path << std::endl;
+        return false;
+    }
+    const AssetPackHeader header = {k_magic,
+                                    k_version,
+                                    static_cast<uint32_t>(entries.size()),
+                                    static_cast<uint32_t>(names.size())};
+    pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pack.write(reinterpret_cast<const char*>(entries.data()),
+               static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+    pack.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+    const std::vector<char> padding(k_asset_pack_alignment, 0);
+    uint64_t                written = table_end;
+    for (uint32_t file = 0; file < files.size(); file++)
+    {
+        const AssetPackEntry& entry = entries[file];
+        pack.write(padding.data(), static_cast<std::streamsize>(entry.offset - written));
+        if (entry.compression == static_cast<uint32_t>(AssetCompression::none))
+        {
+            pack.write(files[file]->getData(), static_cast<std::streamsize>(entry.size));
+        }
+        else
+        {
+            for (uint32_t block = 0; block < entry.block_count; block++)
+            {
+                const Block&   stored = blocks[first_blocks[file] + block];
+                const uint32_t size   = static_cast<uint32_t>(
+                    stored.data.empty() ? getBlockSize(entry.size, block) : stored.data.size());
+                pack.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            }
+            for (uint32_t block = 0; block < entry.block_count; block++)
+            {
+                const Block& stored = blocks[first_blocks[file] + block];
+                if (stored.data.empty())
+                {
+                    pack.write(files[file]->getData() + size_t(block) * k_asset_pack_block_size,
+                               static_cast<std::streamsize>(getBlockSize(entry.size, block)));
+                }
+                else
+                {
+                    pack.write(reinterpret_cast<const char*>(stored.data.data()),
+                               static_cast<std::streamsize>(stored.data.size()));
+                }
+            }
+        }
+        written = entry.offset + entry.stored_size;
+    }
+    // the last entry is padded too, so every entry can be mapped in whole pages
+    pack.write(padding.data(), static_cast<std::streamsize>(alignOffset(written) - written));
+
+    if (!pack)
+    {
+        std::cout << "ERROR::ASSET_PACK:: Failed to write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string AssetPack::normalizePath(const std::string& path)
+{
+    std::vector<std::string> parts;
+    size_t                   begin = 0;
+    while (begin <= path.size())
+    {
+        size_t end = path.find_first_of("/\\", begin);
+        if (end == std::string::npos)
+            end = path.size();
+
+        const std::string part = path.substr(begin, end - begin);
+        if (part == ".." && !parts.empty() && parts.back() != "..")
+            parts.pop_back();
+        else if (!part.empty() && part != ".")
+            parts.push_back(part);
+        begin = end + 1;
+    }
+
+    std::string normalized = !path.empty() && (path[0] == '/' || path[0] == '\\') ? "/" : "";
+    for (size_t index = 0; index < parts.size(); index++)
+    {
+        normalized += (index > 0 ? "/" : "") + parts[index];
+    }
+    return normalized;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+class JobSystem;
+
+// every entry starts at a multiple of this in the pack, the page size mappings work in
+static constexpr uint64_t k_asset_pack_alignment = 4096;
+// compressed entries are cut into blocks of this many bytes, each decompressed on its own
+static constexpr uint32_t k_asset_pack_block_size = 64 * 1024;
+
+enum class AssetCompression : uint32_t
+{
+    none, // the file as it is, read in place from the mapped pack
+    lz4   // blocks in the LZ4 block format, see lz4_block.h
+};
+
+// An entry of the table of contents. The entries are sorted by name, the path of the file
+// relative to the directory the pack was built from with '/' between its parts
+struct AssetPackEntry
+{
+    uint64_t offset;      // of the data in the pack
+    uint64_t size;        // of the file
+    uint64_t stored_size; // of the data in the pack
+    uint32_t name_offset; // into the names after the table
+    uint32_t name_size;
+    uint32_t compression; // AssetCompression
+    // a compressed entry starts with the stored size of every block, then the blocks. A block
+    // stored as large as it is was kept raw
+    uint32_t block_count;
+};
+
+// a file to pack, its name in the pack and where it is on disk
+struct AssetPackSource
+{
+    std::string name;
+    std::string path;
+};
+
+// An asset pack mapped read-only: a header, the table of contents and the names, then the entries.
+// Lookups are a binary search of the table, raw entries are used in place and compressed ones
+// decompressed block by block on the jobs.
+class AssetPack {
+public:
+    // returns false with an error when the file isn't a pack of this version
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const
+    {
+        return file_.isOpen();
+    }
+
+    // the entry of the normalized name, nullptr when the pack has none
+    const AssetPackEntry* find(const std::string& name) const;
+    // the stored bytes of an entry, the file itself when it isn't compressed
+    const uint8_t* getStoredData(const AssetPackEntry& entry) const;
+    // decompresses an entry into entry.size bytes of destination, on the jobs when given. Returns
+    // false when its data is corrupt
+    bool decompress(const AssetPackEntry& entry, JobSystem* jobs, uint8_t* destination) const;
+
+    const std::vector<AssetPackEntry>& getEntries() const
+    {
+        return entries_;
+    }
+    std::string getName(const AssetPackEntry& entry) const;
+
+    // Writes the files into a pack at path, compressing the blocks of all of them on the jobs.
+    // An entry that doesn't shrink by an eighth is stored raw so it is read in place. The names
+    // must be normalized and different. Returns false with an error when a file can't be read or
+    // the pack written
+    static bool write(const std::string&                  path,
+                      const std::vector<AssetPackSource>& sources,
+                      JobSystem&                          jobs);
+
+    // a path with '/' between its parts and the "." and "dir/.." parts taken out, how names and
+    // the paths looked up in packs are compared
+    static std::string normalizePath(const std::string& path);
+
+private:
+    MappedFile                  file_;
+    std::vector<AssetPackEntry> entries_;
+    const char*                 names_ {nullptr};
+};
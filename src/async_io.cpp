@@ -0,0 +1,589 @@
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+
+#include "asset_file.h"
+#include "async_io.h"
+#include "job_system.h"
+
+// the data of an empty file, which has to be told apart from one that can't be read
+static const char k_empty_file[1] = {};
+
+#ifdef __linux__
+
+// size of a buffer registered with the ring, the files that fit are read into one
+static constexpr size_t k_fixed_buffer_size = 256 * 1024;
+// what O_DIRECT wants buffers, offsets and sizes to be multiples of, the largest logical block
+static constexpr size_t k_direct_alignment = 4096;
+// longest single read, the kernel caps them a little under 2 GB
+static constexpr size_t k_max_read_size = 1u << 30;
+
+static size_t alignUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// An io_uring driven with the raw system calls, no liburing needed: the submission and completion
+// rings mapped from the kernel and the buffers registered with it
+struct IoUring
+{
+    int    fd {-1};
+    void*  sq_ring {MAP_FAILED};
+    size_t sq_ring_size {0};
+    void*  cq_ring {MAP_FAILED};
+    size_t cq_ring_size {0};
+    void*  sqes {MAP_FAILED};
+    size_t sqes_size {0};
+
+    unsigned*     sq_tail {nullptr};
+    unsigned      sq_mask {0};
+    unsigned*     sq_array {nullptr};
+    unsigned*     cq_head {nullptr};
+    unsigned*     cq_tail {nullptr};
+    unsigned      cq_mask {0};
+    io_uring_cqe* cqes {nullptr};
+
+    char*    fixed_memory {nullptr};
+    uint32_t fixed_count {0};
+
+    // the memory of every request for the files larger than its registered buffer, kept for the
+    // next files so their pages are only faulted in once
+    struct Buffer
+    {
+        char*  data {nullptr};
+        size_t size {0};
+    };
+    std::vector<Buffer> buffers;
+
+    ~IoUring()
+    {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqes_size);
+        if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+            munmap(cq_ring, cq_ring_size);
+        if (sq_ring != MAP_FAILED)
+            munmap(sq_ring, sq_ring_size);
+        if (fd >= 0)
+            close(fd);
+        free(fixed_memory);
+        for (auto& buffer : buffers)
+        {
+            free(buffer.data);
+        }
+    }
+
+    // returns the errno of the failing call, 0 once the rings are mapped
+    int setup(uint32_t entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+            return errno;
+        // IORING_OP_READ came a release before the fast poll, older kernels only have readv
+        if (!(params.features & IORING_FEAT_FAST_POLL))
+            return ENOSYS;
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        sq_ring = mmap(nullptr,
+                       sq_ring_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       fd,
+                       IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED)
+            return errno;
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+            cq_ring = sq_ring;
+        else
+            cq_ring = mmap(nullptr,
+                           cq_ring_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE,
+                           fd,
+                           IORING_OFF_CQ_RING);
+        if (cq_ring == MAP_FAILED)
+            return errno;
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes      = mmap(nullptr,
+                         sqes_size,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE,
+                         fd,
+                         IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return errno;
+
+        char* sq = static_cast<char*>(sq_ring);
+        char* cq = static_cast<char*>(cq_ring);
+        sq_tail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask  = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask  = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return 0;
+    }
+
+    // registers up to count buffers, fewer when the locked memory limit doesn't allow them all
+    void registerBuffers(uint32_t count)
+    {
+        void* memory = nullptr;
+        if (posix_memalign(&memory, k_direct_alignment, count * k_fixed_buffer_size) != 0)
+            return;
+        fixed_memory = static_cast<char*>(memory);
+        std::vector<iovec> buffers(count);
+        for (uint32_t index = 0; index < count; index++)
+        {
+            buffers[index].iov_base = fixed_memory + index * k_fixed_buffer_size;
+            buffers[index].iov_len  = k_fixed_buffer_size;
+        }
+        for (; count > 0; count /= 2)
+        {
+            const long result =
+                syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers.data(), count);
+            if (result == 0)
+            {
+                fixed_count = count;
+                return;
+            }
+            if (errno != ENOMEM)
+                break;
+        }
+        std::cout << "Info: No buffers registered with io_uring: " << strerror(errno) << std::endl;
+        free(fixed_memory);
+        fixed_memory = nullptr;
+    }
+
+    char* getFixedBuffer(uint32_t request) const
+    {
+        return fixed_memory + request * k_fixed_buffer_size;
+    }
+
+    // the memory of a request grown to size, nullptr when it can't be
+    char* getBuffer(uint32_t request, size_t size)
+    {
+        Buffer& buffer = buffers[request];
+        if (buffer.size < size)
+        {
+            free(buffer.data);
+            buffer     = Buffer();
+            void* data = nullptr;
+            if (posix_memalign(&data, k_direct_alignment, size) != 0)
+                return nullptr;
+            buffer.data = static_cast<char*>(data);
+            buffer.size = size;
+        }
+        return buffer.data;
+    }
+};
+
+// a file of a batch from the time it is opened until its job is done with it
+struct ReadRequest
+{
+    uint32_t index {0}; // of the path
+    int      file {-1};
+    char*    data {nullptr};
+    bool     fixed {false}; // data is its registered buffer
+    bool     direct {false};
+    bool     queued {false}; // a read of it is in the ring
+    bool     mapped {false}; // the job opens it with AssetFile, see complete()
+    bool     failed {false};
+    size_t   size {0};
+    size_t   read {0};
+};
+
+// A readFiles() on the io_uring. Every thread of the parallelFor() runs work(): one at a time
+// drives the ring, opening files and queuing their reads and waiting for them, the rest run the
+// completions of the files read in the meantime. Each file holds a request and its buffer until
+// its completion has run, then the next file takes them.
+class RingBatch {
+public:
+    RingBatch(IoUring&                           ring,
+              const AsyncReadSettings&           settings,
+              uint32_t                           request_count,
+              const std::vector<std::string>&    paths,
+              const AsyncFileReader::Completion& completion)
+        : ring_(ring), settings_(settings), paths_(paths), completion_(completion),
+          requests_(request_count)
+    {
+        for (uint32_t slot = request_count; slot > 0; slot--)
+        {
+            free_slots_.push_back(slot - 1);
+        }
+    }
+
+    void work(uint32_t thread)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (finished_ < paths_.size())
+        {
+            if (!ready_.empty())
+            {
+                const uint32_t slot = ready_.front();
+                ready_.pop_front();
+                lock.unlock();
+                complete(requests_[slot], thread);
+                lock.lock();
+                free_slots_.push_back(slot);
+                if (++finished_ == paths_.size())
+                    ready_changed_.notify_all();
+            }
+            else if (!driving_)
+            {
+                driving_ = true;
+                lock.unlock();
+                drive();
+                lock.lock();
+                driving_ = false;
+                ready_changed_.notify_all();
+            }
+            else
+            {
+                ready_changed_.wait(lock);
+            }
+        }
+    }
+
+private:
+    // opens the next files and queues their reads, then waits for reads to complete unless there
+    // are files to hand out already
+    void drive()
+    {
+        for (;;)
+        {
+            uint32_t slot;
+            uint32_t index;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (in_flight_ >= settings_.queue_depth || free_slots_.empty() ||
+                    next_path_ == paths_.size())
+                    break;
+                slot  = free_slots_.back();
+                index = next_path_++;
+                free_slots_.pop_back();
+            }
+
+            ReadRequest& request = requests_[slot];
+            request              = ReadRequest();
+            request.index        = index;
+            if (broken_ || AssetFile::isInPack(paths_[index]))
+                request.mapped = true;
+            else if (!openFile(request, slot))
+                request.failed = true;
+            if (request.mapped || request.failed || request.size == 0)
+                finish(slot);
+            else
+                queueRead(slot);
+        }
+        if (in_flight_ == 0)
+            return;
+
+        bool wait;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wait = ready_.empty();
+        }
+        const int submitted = static_cast<int>(syscall(__NR_io_uring_enter,
+                                                       ring_.fd,
+                                                       unsubmitted_,
+                                                       wait ? 1 : 0,
+                                                       IORING_ENTER_GETEVENTS,
+                                                       nullptr,
+                                                       0));
+        if (submitted >= 0)
+        {
+            unsubmitted_ -= std::min<uint32_t>(unsubmitted_, submitted);
+        }
+        else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            // the files in the ring and the rest are mapped on the jobs instead
+            std::cout << "ERROR::ASYNC_IO:: io_uring_enter failed: " << strerror(errno)
+                      << std::endl;
+            broken_ = true;
+            for (uint32_t slot = 0; slot < requests_.size(); slot++)
+            {
+                if (requests_[slot].queued)
+                {
+                    requests_[slot].queued = false;
+                    requests_[slot].mapped = true;
+                    finish(slot);
+                }
+            }
+            in_flight_   = 0;
+            unsubmitted_ = 0;
+            return;
+        }
+
+        unsigned       head = *ring_.cq_head;
+        const unsigned tail = __atomic_load_n(ring_.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++)
+        {
+            const io_uring_cqe& cqe = ring_.cqes[head & ring_.cq_mask];
+            in_flight_--;
+            completeRead(static_cast<uint32_t>(cqe.user_data), cqe.res);
+        }
+        __atomic_store_n(ring_.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    bool openFile(ReadRequest& request, uint32_t slot)
+    {
+        const char* path = paths_[request.index].c_str();
+        request.file     = open(path, O_RDONLY | O_CLOEXEC);
+        struct stat status;
+        if (request.file < 0 || fstat(request.file, &status) != 0 || !S_ISREG(status.st_mode))
+            return false;
+        request.size = static_cast<size_t>(status.st_size);
+
+        // a file system without O_DIRECT has the file read through the page cache
+        if (settings_.direct && request.size >= k_direct_read_size)
+        {
+            const int direct = open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+            if (direct >= 0)
+            {
+                close(request.file);
+                request.file   = direct;
+                request.direct = true;
+            }
+        }
+
+        // O_DIRECT reads whole blocks, past the end of the file into the buffer
+        const size_t capacity = alignUp(std::max<size_t>(request.size, 1), k_direct_alignment);
+        request.fixed         = slot < ring_.fixed_count && capacity <= k_fixed_buffer_size;
+        request.data = request.fixed ? ring_.getFixedBuffer(slot) : ring_.getBuffer(slot, capacity);
+        return request.data != nullptr;
+    }
+
+    // queues the read of the rest of a file, submitted with the next io_uring_enter
+    void queueRead(uint32_t slot)
+    {
+        ReadRequest& request = requests_[slot];
+        size_t       length  = request.size - request.read;
+        if (request.direct)
+            length = alignUp(length, k_direct_alignment);
+
+        // only the thread driving writes the tail
+        const unsigned tail  = *ring_.sq_tail;
+        const unsigned index = tail & ring_.sq_mask;
+        io_uring_sqe&  sqe   = static_cast<io_uring_sqe*>(ring_.sqes)[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode    = request.fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe.fd        = request.file;
+        sqe.off       = request.read;
+        sqe.addr      = reinterpret_cast<uint64_t>(request.data + request.read);
+        sqe.len       = static_cast<uint32_t>(std::min(length, k_max_read_size));
+        sqe.buf_index = request.fixed ? static_cast<uint16_t>(slot) : 0;
+        sqe.user_data = slot;
+        ring_.sq_array[index] = index;
+        __atomic_store_n(ring_.sq_tail, tail + 1, __ATOMIC_RELEASE);
+        request.queued = true;
+        in_flight_++;
+        unsubmitted_++;
+    }
+
+    // a read of result bytes or -errno came back, the file is read again from where it stopped
+    // until it is read whole
+    void completeRead(uint32_t slot, int result)
+    {
+        ReadRequest& request = requests_[slot];
+        request.queued       = false;
+        if (result > 0)
+            request.read = std::min(request.size, request.read + result);
+        if (request.read == request.size)
+        {
+            finish(slot);
+            return;
+        }
+
+        // O_DIRECT can't go on from the middle of a block, nor read some files
+        if (request.direct && (result == -EINVAL || request.read % k_direct_alignment != 0))
+        {
+            const int file = open(paths_[request.index].c_str(), O_RDONLY | O_CLOEXEC);
+            if (file >= 0)
+            {
+                close(request.file);
+                request.file   = file;
+                request.direct = false;
+                queueRead(slot);
+                return;
+            }
+        }
+        if (result > 0 || result == -EINTR || result == -EAGAIN)
+        {
+            queueRead(slot);
+            return;
+        }
+        request.failed = true;
+        finish(slot);
+    }
+
+    // hands a file to the threads waiting for one
+    void finish(uint32_t slot)
+    {
+        ReadRequest& request = requests_[slot];
+        if (request.file >= 0)
+        {
+            close(request.file);
+            request.file = -1;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(slot);
+        ready_changed_.notify_one();
+    }
+
+    // runs the completion of a file read, on any thread. The files in the asset pack, and all of
+    // them once the ring failed, are opened here like the jobs backend does
+    void complete(ReadRequest& request, uint32_t thread)
+    {
+        if (request.mapped)
+        {
+            AssetFile file;
+            if (file.open(paths_[request.index], false))
+                completion_(request.index,
+                            file.getSize() > 0 ? file.getData() : k_empty_file,
+                            file.getSize(),
+                            thread);
+            else
+                completion_(request.index, nullptr, 0, thread);
+        }
+        else if (request.failed)
+        {
+            completion_(request.index, nullptr, 0, thread);
+        }
+        else
+        {
+            completion_(request.index,
+                        request.size > 0 ? request.data : k_empty_file,
+                        request.size,
+                        thread);
+        }
+    }
+
+    IoUring&                           ring_;
+    const AsyncReadSettings&           settings_;
+    const std::vector<std::string>&    paths_;
+    const AsyncFileReader::Completion& completion_;
+    std::vector<ReadRequest>           requests_;
+
+    // the driving thread's alone
+    uint32_t in_flight_ {0};
+    uint32_t unsubmitted_ {0};
+    bool     broken_ {false};
+
+    std::mutex              mutex_;
+    std::condition_variable ready_changed_;
+    std::vector<uint32_t>   free_slots_;
+    std::deque<uint32_t>    ready_; // read, waiting for a thread to run their completion
+    size_t                  next_path_ {0};
+    size_t                  finished_ {0};
+    bool                    driving_ {false};
+};
+
+#else
+
+struct IoUring
+{
+};
+
+#endif
+
+AsyncFileReader::AsyncFileReader(JobSystem& jobs, const AsyncReadSettings& settings)
+    : jobs_(jobs), settings_(settings)
+{
+    settings_.queue_depth = std::max(1u, std::min(settings_.queue_depth, 4096u));
+#ifdef __linux__
+    if (!settings_.use_io_uring)
+        return;
+
+    auto      ring  = std::make_unique<IoUring>();
+    const int error = ring->setup(settings_.queue_depth);
+    if (error != 0)
+    {
+        std::cout << "Info: io_uring isn't available, " << strerror(error)
+                  << ", the files are read on the jobs" << std::endl;
+        return;
+    }
+    // a request for every read in flight and every file being worked on
+    const uint32_t request_count = settings_.queue_depth + jobs_.getThreadCount();
+    ring->registerBuffers(request_count);
+    ring->buffers.resize(request_count);
+    ring_ = std::move(ring);
+#endif
+}
+
+AsyncFileReader::~AsyncFileReader() = default;
+
+AsyncReadBackend AsyncFileReader::getBackend() const
+{
+    return ring_ ? AsyncReadBackend::io_uring : AsyncReadBackend::jobs;
+}
+
+uint32_t AsyncFileReader::getFixedBufferCount() const
+{
+#ifdef __linux__
+    if (ring_)
+        return ring_->fixed_count;
+#endif
+    return 0;
+}
+
+void AsyncFileReader::readFiles(const std::vector<std::string>& paths,
+                                const Completion&               completion)
+{
+    if (paths.empty())
+        return;
+#ifdef __linux__
+    if (ring_)
+    {
+        RingBatch batch(*ring_,
+                        settings_,
+                        static_cast<uint32_t>(ring_->buffers.size()),
+                        paths,
+                        completion);
+        jobs_.parallelFor(jobs_.getThreadCount(),
+                          1,
+                          [&](uint32_t, uint32_t, uint32_t thread) { batch.work(thread); });
+        return;
+    }
+#endif
+    readOnJobs(paths, completion);
+}
+
+void AsyncFileReader::readOnJobs(const std::vector<std::string>& paths,
+                                 const Completion&               completion)
+{
+    jobs_.parallelFor(static_cast<uint32_t>(paths.size()),
+                      1,
+                      [&](uint32_t begin, uint32_t end, uint32_t thread) {
+                          for (uint32_t index = begin; index < end; index++)
+                          {
+                              AssetFile file;
+                              if (!file.open(paths[index], false))
+                                  completion(index, nullptr, 0, thread);
+                              else if (file.getSize() == 0)
+                                  completion(index, k_empty_file, 0, thread);
+                              else
+                                  completion(index, file.getData(), file.getSize(), thread);
+                          }
+                      });
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class JobSystem;
+struct IoUring;
+
+enum class AsyncReadBackend
+{
+    io_uring, // the reads are queued to the kernel while the jobs work on the files read
+    jobs      // every job reads its files itself, blocking
+};
+
+struct AsyncReadSettings
+{
+    // reads in flight at once. A file read but still waiting for a job keeps its buffer, not a read
+    uint32_t queue_depth {32};
+    // io_uring on Linux when the kernel has it, the jobs otherwise. Off by default: the jobs
+    // mapping the files measured faster warm and no slower cold, see io_benchmark
+    bool use_io_uring {false};
+    // files of k_direct_read_size and more are read past the page cache with O_DIRECT, on io_uring
+    // only. It pays off on cold loads of files read once, but every load of them goes to the disk
+    bool direct {false};
+};
+
+// files at least this large are read with O_DIRECT when the settings ask for it
+static constexpr size_t k_direct_read_size = 256 * 1024;
+
+// Reads batches of files and hands every one to a job as soon as it is read, so the files are
+// decoded while the rest are still coming from the disk. On Linux the reads are queued to an
+// io_uring, the files that fit into the buffers registered with it are read into those. Elsewhere,
+// or when the kernel has no io_uring, the jobs map the files and fault them in themselves.
+class AsyncFileReader {
+public:
+    // Runs on a job for every file with the thread JobSystem gives it. data is nullptr when the
+    // file can't be read and only lives until the call returns
+    using Completion =
+        std::function<void(uint32_t index, const char* data, size_t size, uint32_t thread)>;
+
+    explicit AsyncFileReader(JobSystem& jobs, const AsyncReadSettings& settings = {});
+    ~AsyncFileReader();
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    AsyncReadBackend getBackend() const;
+    // the buffers registered with the io_uring, 0 when there are none
+    uint32_t getFixedBufferCount() const;
+
+    // Reads the files, out of the mounted asset pack when it has them, and runs completion for each
+    // in the order they arrive. Returns once every completion has returned. It runs a
+    // parallelFor(), so it can't be called from inside a job
+    void readFiles(const std::vector<std::string>& paths, const Completion& completion);
+
+private:
+    void readOnJobs(const std::vector<std::string>& paths, const Completion& completion);
+
+    JobSystem&               jobs_;
+    AsyncReadSettings        settings_;
+    std::unique_ptr<IoUring> ring_; // null without io_uring
+};
@@ -0,0 +1,578 @@
+// Offline lighting baker for static models. It needs no GPU: the model is imported with Assimp
+// and traced on the CPU with a SIMD BVH, on every core. The result goes into the mesh cache next
+// to the model, which Model applies at load time:
+//   bake <model> [options]
+//     --rays <n>          rays per vertex or texel (default 128)
+//     --distance <d>      occlusion distance in model units (default 5% of the model size)
+//     --lightmap <size>   bakes a size x size lightmap with generated uvs instead of vertices
+//     --threads <n>       worker threads, 0 for all (default)
+//     --width <4|8>       SIMD width of the BVH (default 8 in BAKE_AVX2 builds, 4 otherwise)
+//     --benchmark         measures rays per second and writes nothing
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bvh.h"
+#include "job_system.h"
+#include "lightmap_unwrap.h"
+#include "mesh_cache.h"
+#include "node_transform.h"
+
+static constexpr float    k_pi               = 3.14159265f;
+static constexpr uint32_t k_lightmap_padding = 2;
+static constexpr uint32_t k_benchmark_rays   = 1u << 20;
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static uint32_t hash(uint32_t value)
+{
+    const uint32_t state = value * 747796405u + 2891336453u;
+    const uint32_t word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+static float toUnitFloat(uint32_t value)
+{
+    return (value >> 8) * (1.f / 16777216.f);
+}
+
+static float radicalInverse(uint32_t bits)
+{
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return toUnitFloat(bits);
+}
+
+// cosine-weighted direction around normal for the 2D sample (u1, u2)
+static glm::vec3 sampleHemisphere(const glm::vec3& normal, float u1, float u2)
+{
+    // orthonormal basis of Duff et al.
+    const float     sign = std::copysign(1.f, normal.z);
+    const float     a    = -1.f / (sign + normal.z);
+    const float     b    = normal.x * normal.y * a;
+    const glm::vec3 tangent(1.f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    const glm::vec3 bitangent(b, sign + normal.y * normal.y * a, -normal.y);
+
+    const float radius = std::sqrt(u2);
+    const float phi    = 2.f * k_pi * u1;
+    return tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi)) +
+           normal * std::sqrt(std::max(0.f, 1.f - u2));
+}
+
+struct OcclusionSettings
+{
+    uint32_t rays;
+    float    distance;
+    float    bias; // origin offset along the surface normal
+};
+
+// fraction of the cosine-weighted hemisphere that sees nothing within the distance. A Hammersley
+// set rotated per sample point (seed) keeps the noise low and independent of the thread count
+static float traceOcclusion(const Bvh&               bvh,
+                            const glm::vec3&         position,
+                            const glm::vec3&         normal,
+                            const glm::vec3&         surface_normal,
+                            const OcclusionSettings& settings,
+                            uint32_t                 seed)
+{
+    const glm::vec3 origin     = position + surface_normal * settings.bias;
+    const float     rotation_x = toUnitFloat(hash(seed * 2 + 0));
+    const float     rotation_y = toUnitFloat(hash(seed * 2 + 1));
+
+    uint32_t unoccluded = 0;
+    for (uint32_t ray = 0; ray < settings.rays; ray++)
+    {
+        const float u1 = std::fmod((ray + 0.5f) / settings.rays + rotation_x, 1.f);
+        const float u2 = std::fmod(radicalInverse(ray) + rotation_y, 1.f);
+        if (!bvh.occluded(origin, sampleHemisphere(normal, u1, u2), settings.distance))
+        {
+            unoccluded++;
+        }
+    }
+    return static_cast<float>(unoccluded) / settings.rays;
+}
+
+// the meshes in the order Model creates them, moved by their node like Model moves them.
+// Meshes with point or line faces are left empty and are not baked
+static void extractMeshes(const aiScene*              scene,
+                          std::vector<TriangleMesh>&  meshes,
+                          std::vector<MeshCacheMesh>& cache_meshes)
+{
+    std::vector<const aiMesh*> scene_meshes;
+    std::vector<glm::mat4>     transforms;
+    collectMeshes(scene, scene_meshes, transforms);
+    for (size_t index = 0; index < scene_meshes.size(); index++)
+    {
+        const aiMesh* mesh = scene_meshes[index];
+
+        MeshCacheMesh cache_mesh;
+        cache_mesh.source_vertex_count = mesh->mNumVertices;
+        for (uint32_t face = 0; face < mesh->mNumFaces; face++)
+        {
+            cache_mesh.source_index_count += mesh->mFaces[face].mNumIndices;
+        }
+        cache_meshes.push_back(cache_mesh);
+
+        TriangleMesh triangle_mesh;
+        if (cache_mesh.source_index_count == mesh->mNumFaces * 3)
+        {
+            const bool          moved = isMovedByNode(mesh, transforms[index]);
+            const NodeTransform node_transform(transforms[index]);
+            for (uint32_t vertex = 0; vertex < mesh->mNumVertices; vertex++)
+            {
+                const aiVector3D& source_position = mesh->mVertices[vertex];
+                const aiVector3D  source_normal =
+                    mesh->HasNormals() ? mesh->mNormals[vertex] : aiVector3D(0.f);
+                glm::vec3 position(source_position.x, source_position.y, source_position.z);
+                glm::vec3 normal(source_normal.x, source_normal.y, source_normal.z);
+                if (moved)
+                {
+                    position = node_transform.transformPosition(position);
+                    normal   = node_transform.transformNormal(normal);
+                }
+                triangle_mesh.positions.push_back(position);
+                triangle_mesh.normals.push_back(normal);
+            }
+            // the cache keeps the index buffer, mirrored meshes turn their triangles like Model's
+            for (uint32_t face = 0; face < mesh->mNumFaces; face++)
+            {
+                const uint32_t* corners = mesh->mFaces[face].mIndices;
+                triangle_mesh.indices.insert(triangle_mesh.indices.end(), corners, corners + 3);
+            }
+            if (moved)
+                node_transform.orientTriangles(triangle_mesh.indices);
+        }
+        meshes.push_back(std::move(triangle_mesh));
+    }
+}
+
+// the same import processing as Model::loadModel, so vertex counts and order match
+static bool loadMeshes(const std::string&          path,
+                       std::vector<TriangleMesh>&  meshes,
+                       std::vector<MeshCacheMesh>& cache_meshes)
+{
+    Assimp::Importer importer;
+    const aiScene*   scene =
+        importer.ReadFile(path,
+                          aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals);
+
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    extractMeshes(scene, meshes, cache_meshes);
+    return true;
+}
+
+static void bakeVertices(const Bvh&                       bvh,
+                         JobSystem&                       jobs,
+                         const OcclusionSettings&         settings,
+                         const std::vector<TriangleMesh>& meshes,
+                         std::vector<MeshCacheMesh>&      cache_meshes)
+{
+    std::vector<glm::uvec2> vertices; // (mesh, vertex)
+    for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        const TriangleMesh& source = meshes[mesh];
+        cache_meshes[mesh].indices = source.indices;
+        for (uint32_t vertex = 0; vertex < source.positions.size(); vertex++)
+        {
+            cache_meshes[mesh].vertices.push_back({vertex, glm::vec2(0.f), 1.f});
+            vertices.emplace_back(mesh, vertex);
+        }
+    }
+
+    const Clock::time_point start = Clock::now();
+    jobs.parallelFor(
+        static_cast<uint32_t>(vertices.size()), 64, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t index = begin; index < end; index++)
+            {
+                const TriangleMesh& source = meshes[vertices[index].x];
+                const uint32_t      vertex = vertices[index].y;
+                const glm::vec3&    normal = source.normals[vertex];
+                if (glm::dot(normal, normal) < 1e-12f)
+                    continue;
+
+                const glm::vec3 direction = glm::normalize(normal);
+                cache_meshes[vertices[index].x].vertices[vertex].occlusion = traceOcclusion(
+                    bvh, source.positions[vertex], direction, direction, settings, index);
+            }
+        });
+    const double seconds = secondsSince(start);
+
+    std::cout << "Info: Baked " << vertices.size() << " vertices in " << seconds << " s, "
+              << vertices.size() * settings.rays / seconds * 1e-6 << " Mrays/s" << std::endl;
+}
+
+// the value of every texel covered by a triangle, the rest is filled by dilation
+struct LightmapTexel
+{
+    uint32_t  texel;
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec3 surface_normal;
+};
+
+static float edgeFunction(const glm::vec2& a, const glm::vec2& b, const glm::vec2& point)
+{
+    return (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+}
+
+static bool bakeLightmap(const Bvh&                       bvh,
+                         JobSystem&                       jobs,
+                         const OcclusionSettings&         settings,
+                         const std::vector<TriangleMesh>& meshes,
+                         uint32_t                         size,
+                         MeshCache&                       cache)
+{
+    std::vector<LightmapUnwrap> unwraps;
+    const float density = unwrapLightmap(meshes, size, k_lightmap_padding, unwraps);
+    if (density <= 0.f)
+        return false;
+
+    std::cout << "Info: Lightmap " << size << "x" << size << ", " << density
+              << " texels per unit" << std::endl;
+
+    std::vector<LightmapTexel> texels;
+    std::vector<uint8_t>       covered(static_cast<size_t>(size) * size, 0);
+    for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        const TriangleMesh&   source = meshes[mesh];
+        const LightmapUnwrap& unwrap = unwraps[mesh];
+        MeshCacheMesh&        target = cache.meshes[mesh];
+
+        target.indices = unwrap.indices;
+        for (size_t vertex = 0; vertex < unwrap.sources.size(); vertex++)
+        {
+            target.vertices.push_back({unwrap.sources[vertex], unwrap.texcoords[vertex], 1.f});
+        }
+
+        for (size_t index = 0; index < unwrap.indices.size(); index += 3)
+        {
+            glm::vec2 corners[3];
+            uint32_t  sources[3];
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                corners[corner] = unwrap.texcoords[unwrap.indices[index + corner]] *
+                                  static_cast<float>(size);
+                sources[corner] = unwrap.sources[unwrap.indices[index + corner]];
+            }
+
+            const float area = edgeFunction(corners[0], corners[1], corners[2]);
+            if (std::fabs(area) < 1e-12f)
+                continue;
+
+            const glm::vec3& p0 = source.positions[sources[0]];
+            const glm::vec3& p1 = source.positions[sources[1]];
+            const glm::vec3& p2 = source.positions[sources[2]];
+            const glm::vec3  face_normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+
+            const glm::uvec2 low =
+                glm::uvec2(glm::min(corners[0], glm::min(corners[1], corners[2])));
+            const glm::uvec2 high = glm::min(
+                glm::uvec2(glm::max(corners[0], glm::max(corners[1], corners[2]))),
+                glm::uvec2(size - 1));
+            for (uint32_t y = low.y; y <= high.y; y++)
+            {
+                for (uint32_t x = low.x; x <= high.x; x++)
+                {
+                    const glm::vec2 center(x + 0.5f, y + 0.5f);
+                    const glm::vec3 weights =
+                        glm::vec3(edgeFunction(corners[1], corners[2], center),
+                                  edgeFunction(corners[2], corners[0], center),
+                                  edgeFunction(corners[0], corners[1], center)) /
+                        area;
+                    const uint32_t texel = y * size + x;
+                    if (weights.x < 0.f || weights.y < 0.f || weights.z < 0.f || covered[texel])
+                        continue;
+                    covered[texel] = 1;
+
+                    glm::vec3 normal = weights.x * source.normals[sources[0]] +
+                                       weights.y * source.normals[sources[1]] +
+                                       weights.z * source.normals[sources[2]];
+                    normal = glm::dot(normal, normal) > 1e-12f ? glm::normalize(normal)
+                                                               : face_normal;
+
+                    // rays leave from the side of the triangle the shading normal is on
+                    const glm::vec3 position = weights.x * p0 + weights.y * p1 + weights.z * p2;
+                    texels.push_back(
+                        {texel,
+                         position,
+                         normal,
+                         glm::dot(face_normal, normal) < 0.f ? -face_normal : face_normal});
+                }
+            }
+        }
+    }
+
+    std::vector<float>      values(static_cast<size_t>(size) * size, -1.f);
+    const Clock::time_point start = Clock::now();
+    jobs.parallelFor(
+        static_cast<uint32_t>(texels.size()), 64, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t index = begin; index < end; index++)
+            {
+                const LightmapTexel& texel = texels[index];
+                values[texel.texel]        = traceOcclusion(bvh,
+                                                     texel.position,
+                                                     texel.normal,
+                                                     texel.surface_normal,
+                                                     settings,
+                                                     texel.texel);
+            }
+        });
+    const double seconds = secondsSince(start);
+
+    std::cout << "Info: Baked " << texels.size() << " texels in " << seconds << " s, "
+              << texels.size() * settings.rays / seconds * 1e-6 << " Mrays/s" << std::endl;
+
+    // grow the charts into their padding so bilinear filtering never reads unbaked texels
+    for (uint32_t pass = 0; pass < k_lightmap_padding * 2; pass++)
+    {
+        std::vector<float> dilated = values;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                if (values[y * size + x] >= 0.f)
+                    continue;
+
+                float    total = 0.f;
+                uint32_t count = 0;
+                for (uint32_t ny = y > 0 ? y - 1 : 0; ny <= std::min(y + 1, size - 1); ny++)
+                {
+                    for (uint32_t nx = x > 0 ? x - 1 : 0; nx <= std::min(x + 1, size - 1); nx++)
+                    {
+                        if (values[ny * size + nx] >= 0.f)
+                        {
+                            total += values[ny * size + nx];
+                            count++;
+                        }
+                    }
+                }
+                if (count > 0)
+                {
+                    dilated[y * size + x] = total / count;
+                }
+            }
+        }
+        values.swap(dilated);
+    }
+
+    cache.lightmap_width  = size;
+    cache.lightmap_height = size;
+    cache.lightmap.resize(values.size());
+    for (size_t texel = 0; texel < values.size(); texel++)
+    {
+        cache.lightmap[texel] =
+            values[texel] < 0.f ? 255 : static_cast<uint8_t>(std::lround(values[texel] * 255.f));
+    }
+    // uv (0, 0) of the meshes without a lightmap
+    cache.lightmap[0] = 255;
+
+    return true;
+}
+
+// random occlusion rays from the surface, short ones like the bake and long ones across the
+// model, on one thread and on all of them
+static void runBenchmark(const std::vector<glm::vec3>& positions,
+                         const std::vector<uint32_t>&  indices,
+                         const OcclusionSettings&      settings,
+                         float                         model_size,
+                         JobSystem&                    jobs)
+{
+    struct BenchmarkRay
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+    };
+
+    std::vector<BenchmarkRay> rays(k_benchmark_rays);
+    const uint32_t            triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    for (uint32_t ray = 0; ray < k_benchmark_rays; ray++)
+    {
+        const uint32_t  triangle = hash(ray * 4) % triangle_count;
+        const glm::vec3 p0       = positions[indices[triangle * 3 + 0]];
+        const glm::vec3 p1       = positions[indices[triangle * 3 + 1]];
+        const glm::vec3 p2       = positions[indices[triangle * 3 + 2]];
+        glm::vec3       normal   = glm::cross(p1 - p0, p2 - p0);
+        normal = glm::dot(normal, normal) > 0.f ? glm::normalize(normal) : glm::vec3(0.f, 1.f, 0.f);
+
+        float u = toUnitFloat(hash(ray * 4 + 1));
+        float v = toUnitFloat(hash(ray * 4 + 2));
+        if (u + v > 1.f)
+        {
+            u = 1.f - u;
+            v = 1.f - v;
+        }
+        rays[ray].origin    = p0 + u * (p1 - p0) + v * (p2 - p0) + normal * settings.bias;
+        rays[ray].direction = sampleHemisphere(
+            normal, toUnitFloat(hash(ray * 4 + 3)), toUnitFloat(hash(hash(ray * 4 + 3))));
+    }
+
+    JobSystem single_thread(1);
+    for (uint32_t width : {4u, 8u})
+    {
+        if (!Bvh::isWidthSupported(width))
+        {
+            std::cout << "Info: " << width << "-wide BVH not available in this build" << std::endl;
+            continue;
+        }
+
+        const Clock::time_point build_start = Clock::now();
+        const Bvh               bvh(positions, indices, width);
+        std::cout << "Info: " << width << "-wide BVH, " << secondsSince(build_start) * 1e3
+                  << " ms build, " << bvh.getNodeCount() << " nodes, "
+                  << bvh.getMemoryUsage() / (1024 * 1024) << " MB" << std::endl;
+
+        for (float distance : {settings.distance, model_size})
+        {
+            for (JobSystem* pool : {&single_thread, &jobs})
+            {
+                std::vector<uint32_t>   hits(pool->getThreadCount(), 0);
+                const Clock::time_point start = Clock::now();
+                pool->parallelFor(
+                    k_benchmark_rays, 256, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+                        uint32_t batch_hits = 0;
+                        for (uint32_t ray = begin; ray < end; ray++)
+                        {
+                            const BenchmarkRay& benchmark_ray = rays[ray];
+                            batch_hits += bvh.occluded(
+                                benchmark_ray.origin, benchmark_ray.direction, distance);
+                        }
+                        hits[thread] += batch_hits;
+                    });
+                const double seconds = secondsSince(start);
+
+                uint32_t hit_count = 0;
+                for (uint32_t count : hits)
+                {
+                    hit_count += count;
+                }
+                std::cout << "Info:   distance " << distance << ", " << pool->getThreadCount()
+                          << " threads: " << k_benchmark_rays / seconds * 1e-6 << " Mrays/s, "
+                          << 100.0 * hit_count / k_benchmark_rays << "% occluded" << std::endl;
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: bake <model> [--rays n] [--distance d] [--lightmap size] "
+                  << "[--threads n] [--width 4|8] [--benchmark]" << std::endl;
+        return 1;
+    }
+
+    const std::string model_path    = argv[1];
+    uint32_t          rays          = 128;
+    float             distance      = 0.f;
+    uint32_t          lightmap_size = 0;
+    uint32_t          thread_count  = 0;
+    uint32_t          width         = Bvh::isWidthSupported(8) ? 8 : 4;
+    bool              benchmark     = false;
+    for (int index = 2; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--benchmark") == 0)
+            benchmark = true;
+        else if (strcmp(argv[index], "--rays") == 0 && index + 1 < argc)
+            rays = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--distance") == 0 && index + 1 < argc)
+            distance = static_cast<float>(atof(argv[++index]));
+        else if (strcmp(argv[index], "--lightmap") == 0 && index + 1 < argc)
+            lightmap_size = std::max(0, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            thread_count = std::max(0, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--width") == 0 && index + 1 < argc)
+            width = std::max(0, atoi(argv[++index]));
+    }
+
+    MeshCache                 cache;
+    std::vector<TriangleMesh> meshes;
+    if (!loadMeshes(model_path, meshes, cache.meshes))
+        return 1;
+
+    // one BVH over every mesh, in the space Model draws them
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t>  indices;
+    glm::vec3              bounds_min(1e30f);
+    glm::vec3              bounds_max(-1e30f);
+    for (const auto& mesh : meshes)
+    {
+        const uint32_t base_vertex = static_cast<uint32_t>(positions.size());
+        positions.insert(positions.end(), mesh.positions.begin(), mesh.positions.end());
+        for (uint32_t index : mesh.indices)
+        {
+            indices.push_back(base_vertex + index);
+        }
+        for (const auto& position : mesh.positions)
+        {
+            bounds_min = glm::min(bounds_min, position);
+            bounds_max = glm::max(bounds_max, position);
+        }
+    }
+    if (indices.empty())
+    {
+        std::cout << "ERROR::BAKE:: " << model_path << " has no triangles" << std::endl;
+        return 1;
+    }
+
+    const float       model_size = glm::length(bounds_max - bounds_min);
+    OcclusionSettings settings;
+    settings.rays     = rays;
+    settings.distance = distance > 0.f ? distance : 0.05f * model_size;
+    settings.bias     = 1e-4f * model_size;
+
+    JobSystem jobs(thread_count);
+    std::cout << "Info: " << meshes.size() << " meshes, " << indices.size() / 3 << " triangles, "
+              << jobs.getThreadCount() << " threads" << std::endl;
+
+    if (benchmark)
+    {
+        runBenchmark(positions, indices, settings, model_size, jobs);
+        return 0;
+    }
+
+    const Clock::time_point build_start = Clock::now();
+    const Bvh               bvh(positions, indices, width);
+    std::cout << "Info: " << bvh.getWidth() << "-wide BVH, " << secondsSince(build_start) * 1e3
+              << " ms build" << std::endl;
+
+    if (lightmap_size > 0)
+    {
+        if (!bakeLightmap(bvh, jobs, settings, meshes, lightmap_size, cache))
+            return 1;
+    }
+    else
+    {
+        bakeVertices(bvh, jobs, settings, meshes, cache.meshes);
+    }
+
+    const std::string cache_path = MeshCache::getPath(model_path);
+    if (!cache.save(cache_path))
+        return 1;
+
+    std::cout << "Info: Wrote " << cache_path << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "benchmark.h"
+
+std::vector<CameraPath> Benchmark::standardPaths()
+{
+    std::vector<CameraPath> paths;
+
+    // circles the origin just above the floor plane
+    std::vector<CameraPath::Key> orbit;
+    for (int index = 0; index < 8; index++)
+    {
+        const float angle = glm::radians(45.f * static_cast<float>(index));
+        orbit.push_back(CameraPath::Key {
+            glm::vec3(6.f * glm::cos(angle), 1.5f, 6.f * glm::sin(angle)), glm::vec3(0.f)});
+    }
+    paths.emplace_back("floor_orbit", orbit);
+
+    // walks down the sponza nave and back through the side aisles
+    paths.emplace_back("sponza_nave",
+                       std::vector<CameraPath::Key> {
+                           {glm::vec3(-11.f, 1.5f, 0.f), glm::vec3(0.f, 2.f, 0.f)},
+                           {glm::vec3(-4.f, 1.2f, 0.5f), glm::vec3(6.f, 3.f, 0.f)},
+                           {glm::vec3(4.f, 1.8f, -0.5f), glm::vec3(11.f, 1.f, 0.f)},
+                           {glm::vec3(10.f, 4.f, 0.f), glm::vec3(0.f, 3.f, 0.f)},
+                           {glm::vec3(6.f, 1.5f, 4.f), glm::vec3(-6.f, 1.5f, 4.f)},
+                           {glm::vec3(-8.f, 1.5f, -4.f), glm::vec3(0.f, 1.f, 0.f)},
+                       });
+
+    return paths;
+}
+
+Benchmark::Benchmark(const std::vector<std::string>& configurations,
+                     const std::vector<CameraPath>&  paths,
+                     uint32_t                        frames_per_run,
+                     uint32_t                        warmup_frames) :
+    paths_(paths), frames_per_run_(frames_per_run), warmup_frames_(warmup_frames)
+{
+    // all configurations run over one path before moving to the next one, so they see the same
+    // resident data
+    for (size_t path_index = 0; path_index < paths_.size(); path_index++)
+    {
+        for (const auto& configuration : configurations)
+        {
+            runs_.push_back(Run {configuration, path_index, {}});
+        }
+    }
+}
+
+const std::string& Benchmark::getConfiguration() const
+{
+    return runs_[std::min(run_index_, runs_.size() - 1)].configuration;
+}
+
+const CameraPath& Benchmark::getPath() const
+{
+    return paths_[runs_[std::min(run_index_, runs_.size() - 1)].path_index];
+}
+
+CameraPath::Key Benchmark::getCameraKey() const
+{
+    // warm-up frames hold the first pose so the measured frames cover the full path
+    const uint32_t measured = frame_index_ > warmup_frames_ ? frame_index_ - warmup_frames_ : 0;
+    return getPath().sample(static_cast<float>(measured) / static_cast<float>(frames_per_run_));
+}
+
+void Benchmark::record(const std::string& metric, double value)
+{
+    if (isFinished() || frame_index_ < warmup_frames_)
+        return;
+
+    Run& run = runs_[run_index_];
+    auto it  = std::find_if(
+        run.metrics.begin(), run.metrics.end(), [&](const Metric& m) { return m.name == metric; });
+    if (it == run.metrics.end())
+    {
+        run.metrics.push_back(Metric {metric, {}});
+        it = run.metrics.end() - 1;
+    }
+    it->samples.push_back(value);
+}
+
+void Benchmark::endFrame()
+{
+    if (isFinished())
+        return;
+
+    if (++frame_index_ >= warmup_frames_ + frames_per_run_)
+    {
+        frame_index_ = 0;
+        run_index_++;
+    }
+}
+
+void Benchmark::report(std::ostream& out) const
+{
+    char line[256];
+    snprintf(line,
+             sizeof(line),
+             "%-30s %-14s %-24s %10s %10s %10s %10s",
+             "configuration",
+             "path",
+             "metric",
+             "mean",
+             "p50",
+             "p95",
+             "max");
+    out << line << std::endl;
+
+    for (const auto& run : runs_)
+    {
+        for (const auto& metric : run.metrics)
+        {
+            if (metric.samples.empty())
+                continue;
+
+            std::vector<double> sorted = metric.samples;
+            std::sort(sorted.begin(), sorted.end());
+
+            double sum = 0.0;
+            for (double value : sorted)
+            {
+                sum += value;
+            }
+
+            const size_t count = sorted.size();
+            snprintf(line,
+                     sizeof(line),
+                     "%-30s %-14s %-24s %10.3f %10.3f %10.3f %10.3f",
+                     run.configuration.c_str(),
+                     paths_[run.path_index].getName().c_str(),
+                     metric.name.c_str(),
+                     sum / static_cast<double>(count),
+                     sorted[count / 2],
+                     sorted[std::min(count - 1, count * 95 / 100)],
+                     sorted[count - 1]);
+            out << line << std::endl;
+        }
+    }
+}
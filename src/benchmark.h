@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "camera_path.h"
+
+// Replays every camera path once per renderer configuration and collects per-frame metrics
+// (GPU/CPU times, draw calls, ...). The owner drives it from the frame loop: it reads the
+// configuration and camera pose, renders, records metrics and calls endFrame().
+class Benchmark {
+public:
+    // camera paths shared by every benchmark over the bundled scenes
+    static std::vector<CameraPath> standardPaths();
+
+    Benchmark(const std::vector<std::string>& configurations,
+              const std::vector<CameraPath>&  paths,
+              uint32_t                        frames_per_run,
+              uint32_t                        warmup_frames);
+
+    bool isFinished() const
+    {
+        return run_index_ >= runs_.size();
+    }
+
+    const std::string& getConfiguration() const;
+    const CameraPath&  getPath() const;
+    CameraPath::Key    getCameraKey() const;
+
+    // records a sample for the current frame, samples are discarded during warm-up
+    void record(const std::string& metric, double value);
+    // moves to the next frame, and to the next run when the current one is complete
+    void endFrame();
+
+    void report(std::ostream& out) const;
+
+private:
+    struct Metric
+    {
+        std::string         name;
+        std::vector<double> samples;
+    };
+
+    struct Run
+    {
+        std::string         configuration;
+        size_t              path_index;
+        std::vector<Metric> metrics;
+    };
+
+    std::vector<CameraPath> paths_;
+    std::vector<Run>        runs_;
+    uint32_t                frames_per_run_;
+    uint32_t                warmup_frames_;
+    size_t                  run_index_ {0};
+    uint32_t                frame_index_ {0};
+};
@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+#include "bvh.h"
+#include "simd.h"
+
+static constexpr uint32_t k_leaf_bit   = 1u << 31;
+static constexpr uint32_t k_sah_bins   = 16;
+static constexpr uint32_t k_stack_size = 512;
+
+struct Aabb
+{
+    glm::vec3 bounds_min {FLT_MAX};
+    glm::vec3 bounds_max {-FLT_MAX};
+
+    void grow(const glm::vec3& point)
+    {
+        bounds_min = glm::min(bounds_min, point);
+        bounds_max = glm::max(bounds_max, point);
+    }
+    void grow(const Aabb& other)
+    {
+        bounds_min = glm::min(bounds_min, other.bounds_min);
+        bounds_max = glm::max(bounds_max, other.bounds_max);
+    }
+    float area() const
+    {
+        const glm::vec3 extent = glm::max(bounds_max - bounds_min, glm::vec3(0.f));
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+};
+
+bool Bvh::isWidthSupported(uint32_t width)
+{
+    return width == 4 || (width == 8 && SIMD_HAS_AVX);
+}
+
+Bvh::Bvh(const std::vector<glm::vec3>& positions,
+         const std::vector<uint32_t>&  indices,
+         uint32_t                      width) :
+    width_(width)
+{
+    if (!isWidthSupported(width_))
+    {
+        std::cout << "ERROR::BVH:: " << width_ << "-wide nodes are not available in this build, "
+                  << "using 4" << std::endl;
+        width_ = 4;
+    }
+
+    if (indices.size() < 3)
+        return;
+
+    std::vector<BuildNode> nodes;
+    std::vector<uint32_t>  triangles;
+    buildBinary(positions, indices, nodes, triangles);
+
+    root_ = collapse(nodes, 0, positions, indices, triangles);
+}
+
+bool Bvh::occluded(const glm::vec3& origin, const glm::vec3& direction, float distance) const
+{
+    if (packets_.empty())
+        return false;
+
+#if SIMD_HAS_AVX
+    if (width_ == 8)
+        return occludedWide<SimdFloat8>(origin, direction, distance);
+#endif
+    return occludedWide<SimdFloat4>(origin, direction, distance);
+}
+
+size_t Bvh::getMemoryUsage() const
+{
+    return (node_bounds_.size() + packets_.size()) * sizeof(float) +
+           (node_children_.size() + node_masks_.size()) * sizeof(uint32_t);
+}
+
+void Bvh::buildBinary(const std::vector<glm::vec3>& positions,
+                      const std::vector<uint32_t>&  indices,
+                      std::vector<BuildNode>&       nodes,
+                      std::vector<uint32_t>&        triangles) const
+{
+    const uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+    std::vector<Aabb>      triangle_bounds(triangle_count);
+    std::vector<glm::vec3> centroids(triangle_count);
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            triangle_bounds[triangle].grow(positions[indices[triangle * 3 + corner]]);
+        }
+        centroids[triangle] =
+            0.5f * (triangle_bounds[triangle].bounds_min + triangle_bounds[triangle].bounds_max);
+    }
+
+    triangles.resize(triangle_count);
+    std::iota(triangles.begin(), triangles.end(), 0u);
+
+    auto range_bounds = [&](uint32_t first, uint32_t count) {
+        Aabb bounds;
+        for (uint32_t index = first; index < first + count; index++)
+        {
+            bounds.grow(triangle_bounds[triangles[index]]);
+        }
+        return bounds;
+    };
+
+    const Aabb root_bounds = range_bounds(0, triangle_count);
+    nodes.reserve(triangle_count * 2);
+    nodes.push_back({root_bounds.bounds_min, root_bounds.bounds_max, 0, triangle_count});
+
+    std::vector<uint32_t> stack = {0};
+    while (!stack.empty())
+    {
+        const uint32_t  node_index = stack.back();
+        const BuildNode node       = nodes[node_index];
+        stack.pop_back();
+
+        // a leaf is exactly one triangle packet
+        if (node.count <= width_)
+            continue;
+
+        Aabb centroid_bounds;
+        for (uint32_t index = node.first; index < node.first + node.count; index++)
+        {
+            centroid_bounds.grow(centroids[triangles[index]]);
+        }
+
+        // binned SAH: the cheapest split between bins along any axis
+        int32_t best_axis = -1;
+        int32_t best_bin  = 0;
+        float   best_cost = FLT_MAX;
+        for (int32_t axis = 0; axis < 3; axis++)
+        {
+            const float extent =
+                centroid_bounds.bounds_max[axis] - centroid_bounds.bounds_min[axis];
+            if (extent <= 0.f)
+                continue;
+
+            Aabb     bins[k_sah_bins];
+            uint32_t bin_counts[k_sah_bins] = {};
+            const float scale = k_sah_bins / extent;
+            for (uint32_t index = node.first; index < node.first + node.count; index++)
+            {
+                const uint32_t triangle = triangles[index];
+                const uint32_t bin      = std::min(
+                    k_sah_bins - 1,
+                    static_cast<uint32_t>(
+                        (centroids[triangle][axis] - centroid_bounds.bounds_min[axis]) * scale));
+                bins[bin].grow(triangle_bounds[triangle]);
+                bin_counts[bin]++;
+            }
+
+            float    left_areas[k_sah_bins];
+            uint32_t left_counts[k_sah_bins];
+            Aabb     left;
+            uint32_t left_count = 0;
+            for (uint32_t bin = 0; bin < k_sah_bins; bin++)
+            {
+                left.grow(bins[bin]);
+                left_count += bin_counts[bin];
+                left_areas[bin]  = left.area();
+                left_counts[bin] = left_count;
+            }
+
+            Aabb     right;
+            uint32_t right_count = 0;
+            for (uint32_t bin = k_sah_bins - 1; bin > 0; bin--)
+            {
+                right.grow(bins[bin]);
+                right_count += bin_counts[bin];
+
+                const float cost = left_areas[bin - 1] * left_counts[bin - 1] +
+                                   right.area() * right_count;
+                if (left_counts[bin - 1] > 0 && right_count > 0 && cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_axis = axis;
+                    best_bin  = static_cast<int32_t>(bin) - 1;
+                }
+            }
+        }
+
+        uint32_t middle = node.first + node.count / 2;
+        if (best_axis >= 0)
+        {
+            const float scale = k_sah_bins / (centroid_bounds.bounds_max[best_axis] -
+                                              centroid_bounds.bounds_min[best_axis]);
+            auto        split = std::partition(triangles.begin() + node.first,
+                                        triangles.begin() + node.first + node.count,
+                                        [&](uint32_t triangle) {
+                                            const int32_t bin = std::min(
+                                                static_cast<int32_t>(k_sah_bins) - 1,
+                                                static_cast<int32_t>(
+                                                    (centroids[triangle][best_axis] -
+                                                     centroid_bounds.bounds_min[best_axis]) *
+                                                    scale));
+                                            return bin <= best_bin;
+                                        });
+            middle = static_cast<uint32_t>(split - triangles.begin());
+        }
+        // every centroid in the same spot, or a split that left one side empty
+        if (middle == node.first || middle == node.first + node.count)
+        {
+            middle = node.first + node.count / 2;
+        }
+
+        const uint32_t left_count  = middle - node.first;
+        const uint32_t right_count = node.count - left_count;
+        const Aabb     left        = range_bounds(node.first, left_count);
+        const Aabb     right       = range_bounds(middle, right_count);
+
+        const uint32_t left_index = static_cast<uint32_t>(nodes.size());
+        nodes[node_index].first   = left_index;
+        nodes[node_index].count   = 0;
+        nodes.push_back({left.bounds_min, left.bounds_max, node.first, left_count});
+        nodes.push_back({right.bounds_min, right.bounds_max, middle, right_count});
+
+        stack.push_back(left_index);
+        stack.push_back(left_index + 1);
+    }
+}
+
+uint32_t Bvh::collapse(const std::vector<BuildNode>& nodes,
+                       uint32_t                      node,
+                       const std::vector<glm::vec3>& positions,
+                       const std::vector<uint32_t>&  indices,
+                       const std::vector<uint32_t>&  triangles)
+{
+    if (nodes[node].count > 0)
+        return k_leaf_bit | addPacket(nodes[node], positions, indices, triangles);
+
+    // pull grandchildren up, largest inner child first, until the node is full
+    std::vector<uint32_t> children = {nodes[node].first, nodes[node].first + 1};
+    while (children.size() < width_)
+    {
+        int32_t largest      = -1;
+        float   largest_area = -1.f;
+        for (size_t index = 0; index < children.size(); index++)
+        {
+            const BuildNode& child = nodes[children[index]];
+            const float      area  = Aabb {child.bounds_min, child.bounds_max}.area();
+            if (child.count == 0 && area > largest_area)
+            {
+                largest      = static_cast<int32_t>(index);
+                largest_area = area;
+            }
+        }
+        if (largest < 0)
+            break;
+
+        const uint32_t first = nodes[children[largest]].first;
+        children[largest]    = first;
+        children.push_back(first + 1);
+    }
+
+    const uint32_t wide_node = static_cast<uint32_t>(node_masks_.size());
+    node_bounds_.resize(node_bounds_.size() + 6 * width_, 0.f);
+    node_children_.resize(node_children_.size() + width_, 0);
+    node_masks_.push_back((1u << children.size()) - 1);
+
+    for (uint32_t lane = 0; lane < children.size(); lane++)
+    {
+        const BuildNode& child = nodes[children[lane]];
+        const uint32_t   reference =
+            child.count > 0 ? k_leaf_bit | addPacket(child, positions, indices, triangles)
+                            : collapse(nodes, children[lane], positions, indices, triangles);
+
+        float* bounds = &node_bounds_[static_cast<size_t>(wide_node) * 6 * width_];
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            bounds[axis * width_ + lane]       = child.bounds_min[axis];
+            bounds[(axis + 3) * width_ + lane] = child.bounds_max[axis];
+        }
+        node_children_[static_cast<size_t>(wide_node) * width_ + lane] = reference;
+    }
+
+    return wide_node;
+}
+
+uint32_t Bvh::addPacket(const BuildNode&              leaf,
+                        const std::vector<glm::vec3>& positions,
+                        const std::vector<uint32_t>&  indices,
+                        const std::vector<uint32_t>&  triangles)
+{
+    const uint32_t packet = static_cast<uint32_t>(packets_.size() / (9 * width_));
+    packets_.resize(packets_.size() + 9 * width_, 0.f);
+
+    float* rows = &packets_[static_cast<size_t>(packet) * 9 * width_];
+    for (uint32_t lane = 0; lane < leaf.count; lane++)
+    {
+        const uint32_t  triangle = triangles[leaf.first + lane];
+        const glm::vec3 v0       = positions[indices[triangle * 3 + 0]];
+        const glm::vec3 edge1    = positions[indices[triangle * 3 + 1]] - v0;
+        const glm::vec3 edge2    = positions[indices[triangle * 3 + 2]] - v0;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            rows[axis * width_ + lane]       = v0[axis];
+            rows[(axis + 3) * width_ + lane] = edge1[axis];
+            rows[(axis + 6) * width_ + lane] = edge2[axis];
+        }
+    }
+
+    return packet;
+}
+
+template <typename SimdFloat>
+bool Bvh::occludedWide(const glm::vec3& origin, const glm::vec3& direction, float distance) const
+{
+    constexpr uint32_t width = SimdFloat::k_width;
+
+    // slab test as bounds * inv_direction - origin * inv_direction, axis-parallel rays get a
+    // huge finite reciprocal instead of infinity so no lane turns into NaN
+    glm::vec3 inv_direction;
+    for (uint32_t axis = 0; axis < 3; axis++)
+    {
+        const float component = std::fabs(direction[axis]) < 1e-12f
+                                    ? std::copysign(1e-12f, direction[axis])
+                                    : direction[axis];
+        inv_direction[axis]   = 1.f / component;
+    }
+    const glm::vec3 scaled_origin = origin * inv_direction;
+
+    const SimdFloat inv_x    = SimdFloat::broadcast(inv_direction.x);
+    const SimdFloat inv_y    = SimdFloat::broadcast(inv_direction.y);
+    const SimdFloat inv_z    = SimdFloat::broadcast(inv_direction.z);
+    const SimdFloat scaled_x = SimdFloat::broadcast(scaled_origin.x);
+    const SimdFloat scaled_y = SimdFloat::broadcast(scaled_origin.y);
+    const SimdFloat scaled_z = SimdFloat::broadcast(scaled_origin.z);
+    const SimdFloat origin_x = SimdFloat::broadcast(origin.x);
+    const SimdFloat origin_y = SimdFloat::broadcast(origin.y);
+    const SimdFloat origin_z = SimdFloat::broadcast(origin.z);
+    const SimdFloat dir_x    = SimdFloat::broadcast(direction.x);
+    const SimdFloat dir_y    = SimdFloat::broadcast(direction.y);
+    const SimdFloat dir_z    = SimdFloat::broadcast(direction.z);
+    const SimdFloat zero     = SimdFloat::broadcast(0.f);
+    const SimdFloat one      = SimdFloat::broadcast(1.f);
+    const SimdFloat t_max    = SimdFloat::broadcast(distance);
+
+    uint32_t stack[k_stack_size];
+    uint32_t stack_size = 0;
+    stack[stack_size++] = root_;
+
+    while (stack_size > 0)
+    {
+        const uint32_t reference = stack[--stack_size];
+
+        if (reference & k_leaf_bit)
+        {
+            // Moller-Trumbore against every triangle of the packet
+            const float* rows = &packets_[static_cast<size_t>(reference & ~k_leaf_bit) * 9 * width];
+            const SimdFloat v0_x    = SimdFloat::load(rows + 0 * width);
+            const SimdFloat v0_y    = SimdFloat::load(rows + 1 * width);
+            const SimdFloat v0_z    = SimdFloat::load(rows + 2 * width);
+            const SimdFloat edge1_x = SimdFloat::load(rows + 3 * width);
+            const SimdFloat edge1_y = SimdFloat::load(rows + 4 * width);
+            const SimdFloat edge1_z = SimdFloat::load(rows + 5 * width);
+            const SimdFloat edge2_x = SimdFloat::load(rows + 6 * width);
+            const SimdFloat edge2_y = SimdFloat::load(rows + 7 * width);
+            const SimdFloat edge2_z = SimdFloat::load(rows + 8 * width);
+
+            const SimdFloat p_x = dir_y * edge2_z - dir_z * edge2_y;
+            const SimdFloat p_y = dir_z * edge2_x - dir_x * edge2_z;
+            const SimdFloat p_z = dir_x * edge2_y - dir_y * edge2_x;
+            const SimdFloat det = edge1_x * p_x + edge1_y * p_y + edge1_z * p_z;
+            const SimdFloat inv_det = one / det;
+
+            const SimdFloat s_x = origin_x - v0_x;
+            const SimdFloat s_y = origin_y - v0_y;
+            const SimdFloat s_z = origin_z - v0_z;
+            const SimdFloat u   = (s_x * p_x + s_y * p_y + s_z * p_z) * inv_det;
+
+            const SimdFloat q_x = s_y * edge1_z - s_z * edge1_y;
+            const SimdFloat q_y = s_z * edge1_x - s_x * edge1_z;
+            const SimdFloat q_z = s_x * edge1_y - s_y * edge1_x;
+            const SimdFloat v   = (dir_x * q_x + dir_y * q_y + dir_z * q_z) * inv_det;
+            const SimdFloat t   = (edge2_x * q_x + edge2_y * q_y + edge2_z * q_z) * inv_det;
+
+            // degenerate padding lanes have a zero determinant
+            const SimdFloat hit = (abs(det) > zero) & (u >= zero) & (v >= zero) &
+                                  (u + v <= one) & (t > zero) & (t < t_max);
+            if (mask(hit))
+                return true;
+            continue;
+        }
+
+        const float* bounds = &node_bounds_[static_cast<size_t>(reference) * 6 * width];
+        const SimdFloat x0 = SimdFloat::load(bounds + 0 * width) * inv_x - scaled_x;
+        const SimdFloat y0 = SimdFloat::load(bounds + 1 * width) * inv_y - scaled_y;
+        const SimdFloat z0 = SimdFloat::load(bounds + 2 * width) * inv_z - scaled_z;
+        const SimdFloat x1 = SimdFloat::load(bounds + 3 * width) * inv_x - scaled_x;
+        const SimdFloat y1 = SimdFloat::load(bounds + 4 * width) * inv_y - scaled_y;
+        const SimdFloat z1 = SimdFloat::load(bounds + 5 * width) * inv_z - scaled_z;
+
+        const SimdFloat t_near =
+            max(max(min(x0, x1), min(y0, y1)), max(min(z0, z1), zero));
+        const SimdFloat t_far = min(min(max(x0, x1), max(y0, y1)), min(max(z0, z1), t_max));
+
+        const uint32_t  hits     = mask(t_near <= t_far) & node_masks_[reference];
+        const uint32_t* children = &node_children_[static_cast<size_t>(reference) * width];
+        for (uint32_t lane = 0; lane < width; lane++)
+        {
+            if (hits & (1u << lane))
+                stack[stack_size++] = children[lane];
+        }
+    }
+
+    return false;
+}
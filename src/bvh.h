@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounding volume hierarchy over a triangle soup for CPU ray queries. It is built as a binary
+// tree with binned SAH splits, then collapsed into nodes of width children whose boxes are
+// stored as struct-of-arrays, so a ray tests all of them at once in SIMD. Leaves hold one packet
+// of up to width triangles, tested the same way. Width is 4 (SSE) or 8 (AVX builds only).
+class Bvh {
+public:
+    static bool isWidthSupported(uint32_t width);
+
+    Bvh(const std::vector<glm::vec3>& positions,
+        const std::vector<uint32_t>&  indices,
+        uint32_t                      width);
+
+    // true when anything is hit along direction (normalized) closer than distance. Thread safe
+    bool occluded(const glm::vec3& origin, const glm::vec3& direction, float distance) const;
+
+    uint32_t getWidth() const
+    {
+        return width_;
+    }
+    size_t getNodeCount() const
+    {
+        return node_children_.size() / width_;
+    }
+    // nodes and triangle packets in bytes
+    size_t getMemoryUsage() const;
+
+private:
+    struct BuildNode
+    {
+        glm::vec3 bounds_min;
+        glm::vec3 bounds_max;
+        uint32_t  first; // first triangle for a leaf, left child otherwise
+        uint32_t  count; // triangle count, 0 for inner nodes
+    };
+
+    void     buildBinary(const std::vector<glm::vec3>& positions,
+                         const std::vector<uint32_t>&  indices,
+                         std::vector<BuildNode>&       nodes,
+                         std::vector<uint32_t>&        triangles) const;
+    uint32_t collapse(const std::vector<BuildNode>& nodes,
+                      uint32_t                      node,
+                      const std::vector<glm::vec3>& positions,
+                      const std::vector<uint32_t>&  indices,
+                      const std::vector<uint32_t>&  triangles);
+    uint32_t addPacket(const BuildNode&              leaf,
+                       const std::vector<glm::vec3>& positions,
+                       const std::vector<uint32_t>&  indices,
+                       const std::vector<uint32_t>&  triangles);
+
+    template <typename SimdFloat>
+    bool occludedWide(const glm::vec3& origin, const glm::vec3& direction, float distance) const;
+
+    uint32_t width_;
+    uint32_t root_ {0};
+
+    // per node: min x, y, z then max x, y, z of each child, width floats each
+    std::vector<float> node_bounds_;
+    // per node: width child references, inner node index or k_leaf_bit | packet index
+    std::vector<uint32_t> node_children_;
+    // per node: bit i set when child i exists
+    std::vector<uint32_t> node_masks_;
+    // per packet: vertex 0, edge 1, edge 2 as x, y, z rows of width floats, unused lanes are
+    // degenerate triangles
+    std::vector<float> packets_;
+};
@@ -46,15 +46,64 @@ public:
         return glm::lookAt(camera_position_, target_position_, WORLD_UP_DIR);
     }
 
-    void updateProjection(float aspect_ratio);
-    
+    void setPerspective(float fov, float near_clip, float far_clip)
+    {
+        fov_       = fov;
+        near_clip_ = near_clip;
+        far_clip_  = far_clip;
+    }
+    float getFov() const
+    {
+        return fov_;
+    }
+    float getNearClip() const
+    {
+        return near_clip_;
+    }
+    float getFarClip() const
+    {
+        return far_clip_;
+    }
+
+    // sub-pixel offset of the projection in normalized device coordinates, temporal anti-aliasing
+    // moves it every frame so successive frames sample different points of each pixel
+    void setJitter(const glm::vec2& jitter)
+    {
+        jitter_ = jitter;
+    }
+    glm::vec2 getJitter() const
+    {
+        return jitter_;
+    }
+
+    void updateProjection(float aspect_ratio)
+    {
+        projection_ = glm::perspective(glm::radians(fov_), aspect_ratio, near_clip_, far_clip_);
+    }
+    // the jittered projection to render with
+    glm::mat4 getProjection() const
+    {
+        // clip w is -z in view space, the z column shifts x/w and y/w by minus its value
+        glm::mat4 projection = projection_;
+        projection[2][0] -= jitter_.x;
+        projection[2][1] -= jitter_.y;
+        return projection;
+    }
+    // the projection without jitter, for everything that has to stay stable across frames
+    glm::mat4 getUnjitteredProjection() const
+    {
+        return projection_;
+    }
+
 protected:
     glm::vec3 camera_position_ {0.f, 0.f, 0.f};
     glm::vec3 target_position_ {0.f, 0.f, 0.f};
     glm::vec3 up_dir_ {0.f, 0.f, 0.f};
-    float     fov_ {50.f}; // horizontal fov
+    float     fov_ {50.f}; // vertical fov in degrees
     float     near_clip_ {1.f};
     float     far_clip_ {10000.f};
+    glm::vec2 jitter_ {0.f, 0.f};
+    glm::mat4 projection_ {1.f};
 };
 
 const glm::vec3 Camera::WORLD_UP_DIR = glm::vec3(0.f, 1.f, 0.f);
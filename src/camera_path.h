@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// A closed loop of camera key poses sampled with Catmull-Rom interpolation. Replaying the same
+// path makes frame timings of different renderer configurations comparable.
+class CameraPath {
+public:
+    struct Key
+    {
+        glm::vec3 position;
+        glm::vec3 target;
+    };
+
+    CameraPath()
+    {}
+    CameraPath(const std::string& name, const std::vector<Key>& keys) : name_(name), keys_(keys)
+    {}
+
+    const std::string& getName() const
+    {
+        return name_;
+    }
+
+    // t in [0, 1) covers the whole loop
+    Key sample(float t) const
+    {
+        const size_t count = keys_.size();
+        if (count == 0)
+            return Key {glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f)};
+
+        const float  segment_pos = (t - glm::floor(t)) * static_cast<float>(count);
+        const size_t segment     = static_cast<size_t>(segment_pos) % count;
+        const float  s           = segment_pos - glm::floor(segment_pos);
+
+        const Key& k0 = keys_[(segment + count - 1) % count];
+        const Key& k1 = keys_[segment];
+        const Key& k2 = keys_[(segment + 1) % count];
+        const Key& k3 = keys_[(segment + 2) % count];
+
+        return Key {catmullRom(k0.position, k1.position, k2.position, k3.position, s),
+                    catmullRom(k0.target, k1.target, k2.target, k3.target, s)};
+    }
+
+private:
+    static glm::vec3 catmullRom(const glm::vec3& p0,
+                                const glm::vec3& p1,
+                                const glm::vec3& p2,
+                                const glm::vec3& p3,
+                                float            s)
+    {
+        const float s2 = s * s;
+        const float s3 = s2 * s;
+        return 0.5f * ((2.f * p1) + (-p0 + p2) * s + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * s2 +
+                       (-p0 + 3.f * p1 - 3.f * p2 + p3) * s3);
+    }
+
+    std::string      name_;
+    std::vector<Key> keys_;
+};
@@ -0,0 +1,160 @@
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+
+#include "deferred_renderer.h"
+
+static constexpr uint32_t k_tile_size = 16;
+
+DeferredRenderer::DeferredRenderer(uint32_t width, uint32_t height) :
+    width_(width),
+    height_(height),
+    render_width_(width),
+    render_height_(height),
+    geometry_shader_("../../../shader/gbuffer.vs", "../../../shader/gbuffer.fs"),
+    lighting_shader_("../../../shader/deferred_tiled.cs")
+{
+    createTargets();
+}
+
+DeferredRenderer::~DeferredRenderer()
+{
+    destroyTargets();
+}
+
+void DeferredRenderer::resize(uint32_t width, uint32_t height)
+{
+    if (width == width_ && height == height_)
+        return;
+
+    width_         = width;
+    height_        = height;
+    render_width_  = width;
+    render_height_ = height;
+
+    destroyTargets();
+    createTargets();
+}
+
+void DeferredRenderer::setRenderSize(uint32_t width, uint32_t height)
+{
+    render_width_  = glm::clamp(width, 1u, width_);
+    render_height_ = glm::clamp(height, 1u, height_);
+}
+
+Shader& DeferredRenderer::beginGeometryPass(const glm::mat4& view, const glm::mat4& projection)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer_fbo_);
+    glViewport(0, 0, render_width_, render_height_);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+
+    geometry_shader_.use();
+    geometry_shader_.setMat4fv("projection", glm::value_ptr(projection));
+    geometry_shader_.setMat4fv("view", glm::value_ptr(view));
+    geometry_shader_.setInt("texture_diffuse1", 0);
+    geometry_shader_.setInt("texture_specular1", 1);
+
+    return geometry_shader_;
+}
+
+void DeferredRenderer::lightingPass(const glm::mat4& view,
+                                    const glm::mat4& projection,
+                                    uint32_t         light_count,
+                                    const glm::vec3& clear_color)
+{
+    const glm::mat4 inv_view       = glm::inverse(view);
+    const glm::mat4 inv_projection = glm::inverse(projection);
+
+    lighting_shader_.use();
+    lighting_shader_.setMat4fv("view", glm::value_ptr(view));
+    lighting_shader_.setMat4fv("invView", glm::value_ptr(inv_view));
+    lighting_shader_.setMat4fv("invProjection", glm::value_ptr(inv_projection));
+    lighting_shader_.setUint("lightCount", light_count);
+    lighting_shader_.setVec3f("clearColor", clear_color.x, clear_color.y, clear_color.z);
+    lighting_shader_.setVec2i("renderSize", render_width_, render_height_);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, normal_tex_);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, albedo_spec_tex_);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depth_tex_);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, occlusion_tex_);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindImageTexture(0, output_tex_, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute((render_width_ + k_tile_size - 1) / k_tile_size,
+                      (render_height_ + k_tile_size - 1) / k_tile_size,
+                      1);
+
+    // the output is sampled by the post-processing
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+size_t DeferredRenderer::getMemoryUsage() const
+{
+    // RG16_SNORM + RGBA8 + R8 + D32F
+    return static_cast<size_t>(width_) * height_ * (4 + 4 + 1 + 4);
+}
+
+void DeferredRenderer::createTargets()
+{
+    glGenFramebuffers(1, &gbuffer_fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer_fbo_);
+
+    auto create_texture = [this](GLenum internal_format) {
+        uint32_t texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, internal_format, width_, height_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        return texture;
+    };
+
+    normal_tex_      = create_texture(GL_RG16_SNORM);
+    albedo_spec_tex_ = create_texture(GL_RGBA8);
+    occlusion_tex_   = create_texture(GL_R8);
+    depth_tex_       = create_texture(GL_DEPTH_COMPONENT32F);
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, normal_tex_, 0);
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, albedo_spec_tex_, 0);
+    glFramebufferTexture2D(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, occlusion_tex_, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_tex_, 0);
+
+    const GLenum draw_buffers[] = {
+        GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2};
+    glDrawBuffers(3, draw_buffers);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::FRAMEBUFFER:: G-buffer is not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // lit result in HDR, filtered by the post-processing
+    output_tex_ = create_texture(GL_RGBA16F);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    std::cout << "Info: G-buffer " << width_ << "x" << height_ << ", 13 bytes/pixel, "
+              << getMemoryUsage() / (1024 * 1024) << " MB" << std::endl;
+}
+
+void DeferredRenderer::destroyTargets()
+{
+    const uint32_t textures[] = {
+        normal_tex_, albedo_spec_tex_, occlusion_tex_, depth_tex_, output_tex_};
+    glDeleteTextures(5, textures);
+    glDeleteFramebuffers(1, &gbuffer_fbo_);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+#include "shader.h"
+
+// Deferred shading path. The geometry pass writes a compact g-buffer:
+//   RT0 RG16_SNORM  octahedral world-space normal
+//   RT1 RGBA8       albedo, specular intensity
+//   RT2 R8          baked occlusion, see MeshCache
+//   D32F            depth, world position is reconstructed from it
+// and a tiled compute pass shades each pixel once with the point lights overlapping its tile.
+class DeferredRenderer {
+public:
+    DeferredRenderer(uint32_t width, uint32_t height);
+    ~DeferredRenderer();
+
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    void resize(uint32_t width, uint32_t height);
+
+    // renders into the bottom-left width x height of the targets only, for dynamic resolution.
+    // resize() goes back to the full targets
+    void setRenderSize(uint32_t width, uint32_t height);
+
+    // binds the g-buffer and returns the geometry shader with the camera uniforms set, the caller
+    // draws the scene with it (setting "model" per object)
+    Shader& beginGeometryPass(const glm::mat4& view, const glm::mat4& projection);
+
+    // shades the g-buffer into the output texture, lights are read from the GpuPointLight
+    // storage buffer bound at binding point 0
+    void lightingPass(const glm::mat4& view,
+                      const glm::mat4& projection,
+                      uint32_t         light_count,
+                      const glm::vec3& clear_color);
+
+    uint32_t getOutputTexture() const
+    {
+        return output_tex_;
+    }
+    uint32_t getDepthTexture() const
+    {
+        return depth_tex_;
+    }
+
+    // g-buffer size in bytes, for reporting
+    size_t getMemoryUsage() const;
+
+private:
+    void createTargets();
+    void destroyTargets();
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t render_width_;
+    uint32_t render_height_;
+
+    uint32_t gbuffer_fbo_ {0};
+    uint32_t normal_tex_ {0};
+    uint32_t albedo_spec_tex_ {0};
+    uint32_t occlusion_tex_ {0};
+    uint32_t depth_tex_ {0};
+    uint32_t output_tex_ {0};
+
+    Shader geometry_shader_;
+    Shader lighting_shader_;
+};
@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ostream>
+
+#include "dynamic_resolution.h"
+#include "gpu_timer.h"
+
+DynamicResolution::DynamicResolution(float target_ms, float min_scale, float max_scale) :
+    target_ms_(target_ms), min_scale_(min_scale), max_scale_(std::max(min_scale, max_scale))
+{
+    scale_ = max_scale_;
+    histogram_.resize(static_cast<size_t>(std::lround((max_scale_ - min_scale_) / k_step)) + 1, 0);
+}
+
+void DynamicResolution::setTargetMs(float target_ms)
+{
+    target_ms_     = target_ms;
+    history_count_ = 0;
+}
+
+float DynamicResolution::update(float gpu_ms)
+{
+    histogram_[static_cast<size_t>(std::lround((scale_ - min_scale_) / k_step))]++;
+
+    // the timer reports nothing until its first queries resolve
+    if (gpu_ms <= 0.f)
+        return scale_;
+
+    if (cooldown_ > 0)
+    {
+        cooldown_--;
+        return scale_;
+    }
+
+    history_[history_next_] = gpu_ms;
+    history_next_           = (history_next_ + 1) % k_history_size;
+    history_count_          = std::min(history_count_ + 1, k_history_size);
+
+    const bool panic = gpu_ms > 1.5f * target_ms_;
+    if (!panic && history_count_ < k_estimate_size)
+        return scale_;
+
+    float estimate = gpu_ms;
+    if (!panic)
+    {
+        float sum = 0.f;
+        for (uint32_t index = 1; index <= k_estimate_size; index++)
+        {
+            sum += history_[(history_next_ + k_history_size - index) % k_history_size];
+        }
+        estimate = sum / static_cast<float>(k_estimate_size);
+    }
+
+    // hysteresis band, inside it the scale is good enough
+    if (estimate <= target_ms_ && estimate >= 0.8f * target_ms_)
+        return scale_;
+
+    // the cost follows the pixel count, aim a bit under the target so the next frames fit in it
+    float scale = scale_ * std::sqrt(0.9f * target_ms_ / estimate);
+    scale       = quantize(std::min(scale, scale_ + 2.f * k_step));
+    if (scale == scale_)
+        return scale_;
+
+    scale_ = scale;
+    // the timer results lag behind, wait for the ones rendered at the new scale
+    cooldown_      = GpuTimer::k_latency + 2;
+    history_count_ = 0;
+    return scale_;
+}
+
+void DynamicResolution::report(std::ostream& out, uint32_t width, uint32_t height) const
+{
+    uint64_t total = 0;
+    for (uint64_t count : histogram_)
+    {
+        total += count;
+    }
+    if (total == 0)
+        return;
+
+    out << "Dynamic resolution (target " << target_ms_ << " ms)" << std::endl;
+
+    char line[128];
+    for (size_t index = histogram_.size(); index-- > 0;)
+    {
+        if (histogram_[index] == 0)
+            continue;
+
+        const float scale = min_scale_ + static_cast<float>(index) * k_step;
+        snprintf(line,
+                 sizeof(line),
+                 "  %5.3f %5ux%-5u %6.2f%%",
+                 scale,
+                 std::max(static_cast<uint32_t>(width * scale + 0.5f), 1u),
+                 std::max(static_cast<uint32_t>(height * scale + 0.5f), 1u),
+                 100.0 * static_cast<double>(histogram_[index]) / static_cast<double>(total));
+        out << line << std::endl;
+    }
+}
+
+float DynamicResolution::quantize(float scale) const
+{
+    scale = min_scale_ + std::round((scale - min_scale_) / k_step) * k_step;
+    return std::clamp(scale, min_scale_, max_scale_);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+// Picks the render scale that keeps the GPU frame time under a target.
+//
+// It is fed the GPU time of every frame, as measured by a GpuTimer. The estimate is the mean of
+// the last few frames, so a single slow frame doesn't move the scale; a frame way over the target
+// reacts immediately. The scale only changes when the estimate leaves the band between 80% and
+// 100% of the target, goes up by small steps and then waits for the frames rendered at the old
+// scale to leave the timer before looking again. Scales are quantized so the resolution doesn't
+// drift by a few pixels every frame.
+class DynamicResolution {
+public:
+    static constexpr float    k_step          = 0.025f;
+    static constexpr uint32_t k_history_size  = 16;
+    static constexpr uint32_t k_estimate_size = 8; // frames averaged into the estimate
+
+    DynamicResolution(float target_ms, float min_scale = 0.5f, float max_scale = 1.f);
+
+    void  setTargetMs(float target_ms);
+    float getTargetMs() const
+    {
+        return target_ms_;
+    }
+
+    // scale to render the next frame at, from the last measured GPU time
+    float update(float gpu_ms);
+    float getScale() const
+    {
+        return scale_;
+    }
+
+    // share of the frames rendered at each scale, with the resolution it gives for the output size
+    void report(std::ostream& out, uint32_t width, uint32_t height) const;
+
+private:
+    float quantize(float scale) const;
+
+    float    target_ms_;
+    float    min_scale_;
+    float    max_scale_;
+    float    scale_;
+    uint32_t cooldown_ {0}; // frames left before the scale may change again
+
+    float    history_[k_history_size];
+    uint32_t history_count_ {0};
+    uint32_t history_next_ {0};
+
+    std::vector<uint64_t> histogram_; // frames per quantized scale, from min_scale_ up
+};
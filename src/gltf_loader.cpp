@@ -0,0 +1,1003 @@
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+
+#include "asset_file.h"
+#include "gltf_loader.h"
+#include "job_system.h"
+#include "json.h"
+#include "mesh_import.h"
+#include "meshopt_decode.h"
+
+static constexpr uint32_t k_glb_magic      = 0x46546c67; // "glTF"
+static constexpr uint32_t k_glb_json_chunk = 0x4e4f534a;
+static constexpr uint32_t k_glb_bin_chunk  = 0x004e4942;
+
+// accessor component types
+static constexpr uint32_t k_byte           = 5120;
+static constexpr uint32_t k_unsigned_byte  = 5121;
+static constexpr uint32_t k_short          = 5122;
+static constexpr uint32_t k_unsigned_short = 5123;
+static constexpr uint32_t k_unsigned_int   = 5125;
+static constexpr uint32_t k_float          = 5126;
+
+// primitive modes, the ones below triangles are points and lines
+static constexpr uint64_t k_triangles      = 4;
+static constexpr uint64_t k_triangle_strip = 5;
+static constexpr uint64_t k_triangle_fan   = 6;
+
+static constexpr uint64_t k_no_index = ~0ull;
+
+// node trees deeper than this aren't read, so a broken file can't exhaust the stack
+static constexpr uint32_t k_max_node_depth = 256;
+
+static const char* k_default_material = "DefaultMaterial";
+
+// bytes of a buffer or view in memory, mapped from the files or decoded
+struct GltfView
+{
+    const uint8_t* data {nullptr};
+    size_t         size {0};
+    size_t         stride {0}; // 0 for tightly packed elements
+};
+
+struct GltfDocument
+{
+    JsonValue                                json;
+    std::vector<std::unique_ptr<AssetFile>> files; // the model and the buffers it names
+    std::vector<GltfView>                    buffers;
+    std::vector<GltfView>                    views; // compressed ones have no data until decoded
+    std::vector<std::vector<uint8_t>>        decoded_views;
+};
+
+// a primitive in the world space of a node that draws it
+struct GltfPrimitive
+{
+    const JsonValue* primitive;
+    glm::mat4        transform;
+};
+
+struct GltfAccessor
+{
+    const uint8_t*   data {nullptr}; // nullptr for all zeros
+    size_t           stride {0};
+    size_t           count {0};
+    uint32_t         component_type {0};
+    uint32_t         component_count {0};
+    bool             normalized {false};
+    const JsonValue* sparse {nullptr};
+};
+
+static uint32_t readU32(const char* data)
+{
+    uint32_t value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+static size_t getComponentSize(uint32_t component_type)
+{
+    switch (component_type)
+    {
+        case k_byte:
+        case k_unsigned_byte:
+            return 1;
+        case k_short:
+        case k_unsigned_short:
+            return 2;
+        case k_unsigned_int:
+        case k_float:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t getComponentCount(const std::string& type)
+{
+    if (type == "SCALAR")
+        return 1;
+    if (type.size() == 4 && type.compare(0, 3, "VEC") == 0 && type[3] >= '2' && type[3] <= '4')
+        return type[3] - '0';
+    return 0;
+}
+
+// uris are relative references with percent escapes
+static std::string decodeUri(const std::string& uri)
+{
+    std::string path;
+    for (size_t index = 0; index < uri.size(); index++)
+    {
+        if (uri[index] == '%' && index + 2 < uri.size() && isxdigit(uri[index + 1]) &&
+            isxdigit(uri[index + 2]))
+        {
+            path += static_cast<char>(std::stoi(uri.substr(index + 1, 2), nullptr, 16));
+            index += 2;
+        }
+        else
+        {
+            path += uri[index];
+        }
+    }
+    return path;
+}
+
+// the JSON of a .gltf, or the JSON and binary chunk of a .glb: a 12 byte header, then chunks of
+// a length, a type and the data padded to 4 bytes
+static bool readFile(const std::string& path, GltfDocument& document, GltfView& binary)
+{
+    auto file = std::make_unique<AssetFile>();
+    if (!file->open(path))
+    {
+        std::cout << "ERROR::GLTF:: can't open " << path << std::endl;
+        return false;
+    }
+
+    const char* data      = file->getData();
+    const char* json      = data;
+    size_t      json_size = file->getSize();
+    if (file->getSize() >= 12 && readU32(data) == k_glb_magic)
+    {
+        if (readU32(data + 4) != 2)
+        {
+            std::cout << "ERROR::GLTF:: " << path << " is glb version " << readU32(data + 4)
+                      << ", not 2" << std::endl;
+            return false;
+        }
+
+        const size_t length = std::min<size_t>(readU32(data + 8), file->getSize());
+        json                = nullptr;
+        for (size_t offset = 12; offset + 8 <= length;)
+        {
+            const size_t   chunk_length = readU32(data + offset);
+            const uint32_t chunk_type   = readU32(data + offset + 4);
+            if (chunk_length > length - offset - 8)
+            {
+                std::cout << "ERROR::GLTF:: " << path << " is cut short" << std::endl;
+                return false;
+            }
+            if (chunk_type == k_glb_json_chunk && !json)
+            {
+                json      = data + offset + 8;
+                json_size = chunk_length;
+            }
+            else if (chunk_type == k_glb_bin_chunk && !binary.data)
+            {
+                binary.data = reinterpret_cast<const uint8_t*>(data + offset + 8);
+                binary.size = chunk_length;
+            }
+            offset += 8 + ((chunk_length + 3) & ~size_t(3));
+        }
+        if (!json)
+        {
+            std::cout << "ERROR::GLTF:: " << path << " has no JSON chunk" << std::endl;
+            return false;
+        }
+    }
+
+    std::string error;
+    if (!JsonValue::parse(json, json ? json_size : 0, document.json, error))
+    {
+        std::cout << "ERROR::GLTF:: " << path << ": " << error << std::endl;
+        return false;
+    }
+    document.files.push_back(std::move(file));
+    return true;
+}
+
+// glTF 2 without what the loader leaves to Assimp
+static bool checkDocument(const std::string& path, const JsonValue& json)
+{
+    const std::string& version = json["asset"]["version"].getString();
+    if (version.empty() || version[0] != '2')
+    {
+        std::cout << "ERROR::GLTF:: " << path << " is glTF version " << version << ", not 2"
+                  << std::endl;
+        return false;
+    }
+
+    const JsonValue& required = json["extensionsRequired"];
+    for (size_t index = 0; index < required.getSize(); index++)
+    {
+        const std::string& extension = required.getItem(index).getString();
+        if (extension != "KHR_mesh_quantization" && extension != "EXT_meshopt_compression")
+        {
+            std::cout << "ERROR::GLTF:: " << path << " requires " << extension
+                      << ", which the loader doesn't read" << std::endl;
+            return false;
+        }
+    }
+
+    if (json["skins"].getSize() > 0)
+    {
+        std::cout << "ERROR::GLTF:: " << path << " has skins, which the loader doesn't read"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// every buffer is the binary chunk or a mapped file. Fallbacks for EXT_meshopt_compression may
+// have no data at all, only their compressed views are read
+static bool mapBuffers(const std::string& path,
+                       const std::string& directory,
+                       const GltfView&    binary,
+                       GltfDocument&      document)
+{
+    const JsonValue& buffers = document.json["buffers"];
+    document.buffers.resize(buffers.getSize());
+    for (size_t index = 0; index < buffers.getSize(); index++)
+    {
+        const JsonValue&   buffer = buffers.getItem(index);
+        const std::string& uri    = buffer["uri"].getString();
+        const uint64_t     length = buffer["byteLength"].getIndex(0);
+        GltfView&          view   = document.buffers[index];
+        if (uri.empty())
+        {
+            if (index == 0 && binary.data)
+                view = binary;
+            else if (!buffer["extensions"]["EXT_meshopt_compression"]["fallback"].getBool())
+            {
+                std::cout << "ERROR::GLTF:: buffer " << index << " of " << path << " has no data"
+                          << std::endl;
+                return false;
+            }
+        }
+        else if (uri.compare(0, 5, "data:") == 0)
+        {
+            std::cout << "ERROR::GLTF:: " << path
+                      << " keeps a buffer in a data uri, which the loader doesn't read"
+                      << std::endl;
+            return false;
+        }
+        else
+        {
+            auto file = std::make_unique<AssetFile>();
+            if (!file->open(directory + '/' + decodeUri(uri)))
+            {
+                std::cout << "ERROR::GLTF:: can't open " << uri << " of " << path << std::endl;
+                return false;
+            }
+            view.data = reinterpret_cast<const uint8_t*>(file->getData());
+            view.size = file->getSize();
+            document.files.push_back(std::move(file));
+        }
+
+        if (view.data && view.size < length)
+        {
+            std::cout << "ERROR::GLTF:: buffer " << index << " of " << path << " is shorter than "
+                      << length << " bytes" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// the range of a view or of its compressed data in a buffer, false when it lies outside
+static bool getBufferRange(const GltfDocument& document, const JsonValue& range, GltfView& view)
+{
+    const uint64_t buffer = range["buffer"].getIndex();
+    const uint64_t offset = range["byteOffset"].getIndex(0);
+    const uint64_t length = range["byteLength"].getIndex();
+    if (buffer >= document.buffers.size() || length == k_no_index)
+        return false;
+
+    const GltfView& source = document.buffers[buffer];
+    if (!source.data)
+        return true;
+    if (offset > source.size || length > source.size - offset)
+        return false;
+
+    view.data = source.data + offset;
+    view.size = length;
+    return true;
+}
+
+static bool resolveViews(const std::string& path, GltfDocument& document)
+{
+    const JsonValue& views = document.json["bufferViews"];
+    document.views.resize(views.getSize());
+    document.decoded_views.resize(views.getSize());
+    for (size_t index = 0; index < views.getSize(); index++)
+    {
+        const JsonValue& view       = views.getItem(index);
+        const bool       compressed = view["extensions"]["EXT_meshopt_compression"].isObject();
+        GltfView&        resolved   = document.views[index];
+        resolved.stride             = view["byteStride"].getIndex(0);
+        if (!compressed && !getBufferRange(document, view, resolved))
+        {
+            std::cout << "ERROR::GLTF:: view " << index << " of " << path
+                      << " lies outside its buffer" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// the compressed data of a view decoded into its own storage. Only the filters attributes of
+// meshes use are taken
+static bool decodeView(GltfDocument& document, size_t index)
+{
+    const JsonValue& compression = document.json["bufferViews"].getItem(
+        index)["extensions"]["EXT_meshopt_compression"];
+    GltfView compressed;
+    if (!getBufferRange(document, compression, compressed) || !compressed.data)
+        return false;
+
+    const uint64_t count  = compression["count"].getIndex(0);
+    const uint64_t stride = compression["byteStride"].getIndex(0);
+    if (stride == 0 || stride > 256 || count > std::numeric_limits<uint32_t>::max())
+        return false;
+
+    std::vector<uint8_t>& decoded = document.decoded_views[index];
+    decoded.resize(count * stride);
+
+    const std::string& mode   = compression["mode"].getString();
+    const std::string& filter = compression["filter"].getString();
+    bool               valid  = false;
+    if (mode == "ATTRIBUTES")
+    {
+        valid = decodeMeshoptVertices(
+            decoded.data(), count, stride, compressed.data, compressed.size);
+        if (valid && filter == "OCTAHEDRAL")
+            valid = applyMeshoptOctahedralFilter(decoded.data(), count, stride);
+        else if (valid && filter == "EXPONENTIAL")
+            valid = applyMeshoptExponentialFilter(decoded.data(), count, stride);
+        else if (!filter.empty() && filter != "NONE")
+            valid = false;
+    }
+    else if (mode == "TRIANGLES")
+    {
+        valid = decodeMeshoptTriangles(
+            decoded.data(), count, stride, compressed.data, compressed.size);
+    }
+    else if (mode == "INDICES")
+    {
+        valid =
+            decodeMeshoptIndices(decoded.data(), count, stride, compressed.data, compressed.size);
+    }
+    if (!valid)
+        return false;
+
+    GltfView& view = document.views[index];
+    view.data      = decoded.data();
+    view.size      = decoded.size();
+    view.stride    = stride;
+    return true;
+}
+
+static glm::mat4 getLocalTransform(const JsonValue& node)
+{
+    const JsonValue& matrix = node["matrix"];
+    if (matrix.getSize() == 16)
+    {
+        // column major, as glm keeps them
+        glm::mat4 transform;
+        for (size_t index = 0; index < 16; index++)
+        {
+            glm::value_ptr(transform)[index] =
+                static_cast<float>(matrix.getItem(index).getNumber());
+        }
+        return transform;
+    }
+
+    const auto read = [](const JsonValue& values, size_t index, float fallback) {
+        return static_cast<float>(values.getItem(index).getNumber(fallback));
+    };
+    const JsonValue& translation = node["translation"];
+    const JsonValue& rotation    = node["rotation"];
+    const JsonValue& scale       = node["scale"];
+    const glm::quat  orientation(read(rotation, 3, 1.f),
+                                read(rotation, 0, 0.f),
+                                read(rotation, 1, 0.f),
+                                read(rotation, 2, 0.f));
+    return glm::translate(
+               glm::mat4(1.f),
+               glm::vec3(read(translation, 0, 0.f),
+                         read(translation, 1, 0.f),
+                         read(translation, 2, 0.f))) *
+           glm::mat4_cast(orientation) *
+           glm::scale(glm::mat4(1.f),
+                      glm::vec3(read(scale, 0, 1.f), read(scale, 1, 1.f), read(scale, 2, 1.f)));
+}
+
+// whether every node has one parent at most, so the node graph is a forest unless it has cycles,
+// which collectNode() finds
+static bool checkNodes(const std::string& path, const JsonValue& json)
+{
+    const JsonValue&  nodes = json["nodes"];
+    std::vector<bool> is_child(nodes.getSize(), false);
+    for (size_t node = 0; node < nodes.getSize(); node++)
+    {
+        const JsonValue& children = nodes.getItem(node)["children"];
+        for (size_t index = 0; index < children.getSize(); index++)
+        {
+            const uint64_t child = children.getItem(index).getIndex();
+            if (child >= is_child.size() || is_child[child])
+            {
+                std::cout << "ERROR::GLTF:: node " << child << " of " << path
+                          << " is missing or has several parents" << std::endl;
+                return false;
+            }
+            is_child[child] = true;
+        }
+    }
+    return true;
+}
+
+// the triangle primitives of a node and its children, depth first with the node's own first.
+// Fails on a node visited before, through a cycle or a root listed twice, or too deep
+static bool collectNode(const JsonValue&            json,
+                        uint64_t                    node_index,
+                        const glm::mat4&            parent_transform,
+                        uint32_t                    depth,
+                        std::vector<bool>&          visited,
+                        std::vector<GltfPrimitive>& primitives,
+                        size_t&                     skipped)
+{
+    const JsonValue& node = json["nodes"].getItem(node_index);
+    if (!node.isObject())
+        return true;
+    if (visited[node_index] || depth > k_max_node_depth)
+        return false;
+    visited[node_index] = true;
+
+    const glm::mat4  transform  = parent_transform * getLocalTransform(node);
+    const JsonValue& mesh       = json["meshes"].getItem(node["mesh"].getIndex());
+    const JsonValue& primitives_json = mesh["primitives"];
+    for (size_t index = 0; index < primitives_json.getSize(); index++)
+    {
+        const JsonValue& primitive = primitives_json.getItem(index);
+        const uint64_t   mode      = primitive["mode"].getIndex(k_triangles);
+        if (mode >= k_triangles && mode <= k_triangle_fan)
+            primitives.push_back({&primitive, transform});
+        else
+            skipped++;
+    }
+
+    const JsonValue& children = node["children"];
+    for (size_t index = 0; index < children.getSize(); index++)
+    {
+        if (!collectNode(json,
+                         children.getItem(index).getIndex(),
+                         transform,
+                         depth + 1,
+                         visited,
+                         primitives,
+                         skipped))
+            return false;
+    }
+    return true;
+}
+
+// the roots of the default scene, or without scenes the nodes no other node parents
+static std::vector<uint64_t> getRootNodes(const JsonValue& json)
+{
+    std::vector<uint64_t> roots;
+    const JsonValue&      scenes = json["scenes"];
+    if (scenes.getSize() > 0)
+    {
+        const JsonValue& nodes = scenes.getItem(json["scene"].getIndex(0))["nodes"];
+        for (size_t index = 0; index < nodes.getSize(); index++)
+        {
+            roots.push_back(nodes.getItem(index).getIndex());
+        }
+        return roots;
+    }
+
+    const JsonValue&  nodes = json["nodes"];
+    std::vector<bool> is_child(nodes.getSize(), false);
+    for (size_t node = 0; node < nodes.getSize(); node++)
+    {
+        const JsonValue& children = nodes.getItem(node)["children"];
+        for (size_t index = 0; index < children.getSize(); index++)
+        {
+            const uint64_t child = children.getItem(index).getIndex();
+            if (child < is_child.size())
+                is_child[child] = true;
+        }
+    }
+    for (size_t node = 0; node < nodes.getSize(); node++)
+    {
+        if (!is_child[node])
+            roots.push_back(node);
+    }
+    return roots;
+}
+
+// the views an accessor reads, with the ones of its sparse values
+static void addAccessorViews(const JsonValue& json, uint64_t index, std::vector<uint64_t>& views)
+{
+    const JsonValue& accessor = json["accessors"].getItem(index);
+    views.push_back(accessor["bufferView"].getIndex());
+    views.push_back(accessor["sparse"]["indices"]["bufferView"].getIndex());
+    views.push_back(accessor["sparse"]["values"]["bufferView"].getIndex());
+}
+
+static bool getAccessor(const GltfDocument& document, uint64_t index, GltfAccessor& accessor)
+{
+    const JsonValue& json = document.json["accessors"].getItem(index);
+    if (!json.isObject())
+        return false;
+
+    accessor.count           = json["count"].getIndex(0);
+    accessor.component_type  = static_cast<uint32_t>(json["componentType"].getIndex(0));
+    accessor.component_count = getComponentCount(json["type"].getString());
+    accessor.normalized      = json["normalized"].getBool();
+    accessor.sparse          = json["sparse"].isObject() ? &json["sparse"] : nullptr;
+
+    const size_t element_size =
+        getComponentSize(accessor.component_type) * accessor.component_count;
+    if (element_size == 0)
+        return false;
+
+    // without a view every element is zero
+    const uint64_t view_index = json["bufferView"].getIndex();
+    accessor.stride           = element_size;
+    if (view_index == k_no_index)
+        return true;
+    if (view_index >= document.views.size() || !document.views[view_index].data)
+        return false;
+
+    const GltfView& view   = document.views[view_index];
+    const uint64_t  offset = json["byteOffset"].getIndex(0);
+    accessor.stride        = view.stride > 0 ? view.stride : element_size;
+    if (accessor.count > 0 &&
+        (offset > view.size || accessor.count > view.size ||
+         (accessor.count - 1) * accessor.stride + element_size > view.size - offset))
+        return false;
+
+    accessor.data = view.data + offset;
+    return true;
+}
+
+// elements of an integer or float accessor converted to floats, normalized integers mapped onto
+// [0, 1] or [-1, 1]
+template <typename T>
+static void convertElements(const uint8_t* data,
+                            size_t         stride,
+                            size_t         count,
+                            uint32_t       components,
+                            bool           normalized,
+                            uint8_t*       destination,
+                            size_t         destination_stride)
+{
+    float scale = 1.f;
+    if constexpr (std::is_integral<T>::value)
+        scale = normalized ? 1.f / std::numeric_limits<T>::max() : 1.f;
+
+    for (size_t element = 0; element < count; element++)
+    {
+        const uint8_t* source = data + element * stride;
+        float* output = reinterpret_cast<float*>(destination + element * destination_stride);
+        for (uint32_t component = 0; component < components; component++)
+        {
+            T value;
+            memcpy(&value, source + component * sizeof(T), sizeof(T));
+            const float converted = static_cast<float>(value) * scale;
+            output[component]     = normalized ? std::max(converted, -1.f) : converted;
+        }
+    }
+}
+
+static bool convertElements(uint32_t       component_type,
+                            const uint8_t* data,
+                            size_t         stride,
+                            size_t         count,
+                            uint32_t       components,
+                            bool           normalized,
+                            uint8_t*       destination,
+                            size_t         destination_stride)
+{
+    switch (component_type)
+    {
+        case k_byte:
+            convertElements<int8_t>(
+                data, stride, count, components, normalized, destination, destination_stride);
+            return true;
+        case k_unsigned_byte:
+            convertElements<uint8_t>(
+                data, stride, count, components, normalized, destination, destination_stride);
+            return true;
+        case k_short:
+            convertElements<int16_t>(
+                data, stride, count, components, normalized, destination, destination_stride);
+            return true;
+        case k_unsigned_short:
+            convertElements<uint16_t>(
+                data, stride, count, components, normalized, destination, destination_stride);
+            return true;
+        case k_float:
+            convertElements<float>(
+                data, stride, count, components, normalized, destination, destination_stride);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool readSparseIndex(const GltfView& view,
+                            uint32_t        component_type,
+                            size_t          index,
+                            size_t&         value)
+{
+    const size_t size = getComponentSize(component_type);
+    if (component_type != k_unsigned_byte && component_type != k_unsigned_short &&
+        component_type != k_unsigned_int)
+        return false;
+    if ((index + 1) * size > view.size)
+        return false;
+
+    uint32_t read = 0;
+    memcpy(&read, view.data + index * size, size);
+    value = read;
+    return true;
+}
+
+// the elements a sparse accessor replaces, after the ones of its view
+static bool applySparse(const GltfDocument& document,
+                        const GltfAccessor& accessor,
+                        uint32_t            components,
+                        uint8_t*            destination,
+                        size_t              destination_stride)
+{
+    const JsonValue& sparse  = *accessor.sparse;
+    const uint64_t   count   = sparse["count"].getIndex(0);
+    const JsonValue& indices = sparse["indices"];
+    const JsonValue& values  = sparse["values"];
+    const uint64_t   indices_view = indices["bufferView"].getIndex();
+    const uint64_t   values_view  = values["bufferView"].getIndex();
+    if (indices_view >= document.views.size() || values_view >= document.views.size())
+        return false;
+
+    const GltfView& index_view = document.views[indices_view];
+    const GltfView& value_view = document.views[values_view];
+    const uint64_t  index_offset = indices["byteOffset"].getIndex(0);
+    const uint64_t  value_offset = values["byteOffset"].getIndex(0);
+    const size_t    element_size =
+        getComponentSize(accessor.component_type) * accessor.component_count;
+    if (!index_view.data || !value_view.data || index_offset > index_view.size ||
+        value_offset > value_view.size || count > (value_view.size - value_offset) / element_size)
+        return false;
+
+    const GltfView index_range = {index_view.data + index_offset, index_view.size - index_offset};
+    const uint32_t index_type  = static_cast<uint32_t>(indices["componentType"].getIndex(0));
+    for (size_t index = 0; index < count; index++)
+    {
+        size_t element;
+        if (!readSparseIndex(index_range, index_type, index, element) || element >= accessor.count)
+            return false;
+
+        convertElements(accessor.component_type,
+                        value_view.data + value_offset + index * element_size,
+                        element_size,
+                        1,
+                        components,
+                        accessor.normalized,
+                        destination + element * destination_stride,
+                        destination_stride);
+    }
+    return true;
+}
+
+// the first components of an attribute into the floats at destination, one vertex apart
+static bool readAttribute(const GltfDocument& document,
+                          uint64_t            index,
+                          uint32_t            components,
+                          size_t              vertex_count,
+                          float*              destination)
+{
+    GltfAccessor accessor;
+    if (!getAccessor(document, index, accessor) || accessor.count != vertex_count ||
+        accessor.component_count < components)
+        return false;
+
+    uint8_t* output = reinterpret_cast<uint8_t*>(destination);
+    if (accessor.data && !convertElements(accessor.component_type,
+                                          accessor.data,
+                                          accessor.stride,
+                                          accessor.count,
+                                          components,
+                                          accessor.normalized,
+                                          output,
+                                          sizeof(Vertex)))
+        return false;
+    return !accessor.sparse || applySparse(document, accessor, components, output, sizeof(Vertex));
+}
+
+template <typename T>
+static void copyIndices(const GltfAccessor& accessor, uint32_t* indices)
+{
+    for (size_t index = 0; index < accessor.count; index++)
+    {
+        T value;
+        memcpy(&value, accessor.data + index * accessor.stride, sizeof(T));
+        indices[index] = value;
+    }
+}
+
+static bool readIndices(const GltfDocument&    document,
+                        uint64_t               index,
+                        size_t                 vertex_count,
+                        std::vector<uint32_t>& indices)
+{
+    GltfAccessor accessor;
+    if (!getAccessor(document, index, accessor) || !accessor.data || accessor.sparse ||
+        accessor.component_count != 1)
+        return false;
+
+    indices.resize(accessor.count);
+    if (accessor.component_type == k_unsigned_int && accessor.stride == 4)
+        memcpy(indices.data(), accessor.data, accessor.count * 4);
+    else if (accessor.component_type == k_unsigned_int)
+        copyIndices<uint32_t>(accessor, indices.data());
+    else if (accessor.component_type == k_unsigned_short)
+        copyIndices<uint16_t>(accessor, indices.data());
+    else if (accessor.component_type == k_unsigned_byte)
+        copyIndices<uint8_t>(accessor, indices.data());
+    else
+        return false;
+
+    return std::all_of(
+        indices.begin(), indices.end(), [&](uint32_t vertex) { return vertex < vertex_count; });
+}
+
+// strips and fans as triangle lists, odd strip triangles turned back to the winding of the first
+static void makeTriangleList(uint64_t mode, std::vector<uint32_t>& indices)
+{
+    if (mode == k_triangles)
+    {
+        indices.resize(indices.size() - indices.size() % 3);
+        return;
+    }
+
+    std::vector<uint32_t> list;
+    for (size_t first = 0; first + 2 < indices.size(); first++)
+    {
+        if (mode == k_triangle_strip)
+        {
+            const size_t odd = first % 2;
+            list.insert(list.end(),
+                        {indices[first], indices[first + 1 + odd], indices[first + 2 - odd]});
+        }
+        else
+        {
+            list.insert(list.end(), {indices[first + 1], indices[first + 2], indices[0]});
+        }
+    }
+    indices = std::move(list);
+}
+
+// area weighted normals of the triangles around a vertex, summed over the vertices at the same
+// position so seams of the texture coords don't show in the shading
+static void generateNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    std::vector<glm::vec3> sums(vertices.size(), glm::vec3(0.f));
+    for (size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3)
+    {
+        const glm::vec3& a      = vertices[indices[triangle]].position;
+        const glm::vec3  normal = glm::cross(vertices[indices[triangle + 1]].position - a,
+                                            vertices[indices[triangle + 2]].position - a);
+        for (int corner = 0; corner < 3; corner++)
+        {
+            sums[indices[triangle + corner]] += normal;
+        }
+    }
+
+    const auto less = [](const glm::vec3& a, const glm::vec3& b) {
+        return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+    };
+    std::vector<uint32_t> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return less(vertices[a].position, vertices[b].position);
+    });
+
+    for (size_t first = 0; first < order.size();)
+    {
+        size_t    last = first;
+        glm::vec3 sum(0.f);
+        for (; last < order.size() &&
+               vertices[order[last]].position == vertices[order[first]].position;
+             last++)
+        {
+            sum += sums[order[last]];
+        }
+
+        const float length = glm::length(sum);
+        for (size_t vertex = first; vertex < last; vertex++)
+        {
+            vertices[order[vertex]].normal = length > 0.f ? sum / length : glm::vec3(0.f);
+        }
+        first = last;
+    }
+}
+
+static bool buildMesh(const GltfDocument&  document,
+                      const GltfPrimitive& primitive,
+                      uint32_t             default_material,
+                      ImportedMesh&        mesh)
+{
+    const JsonValue& attributes = (*primitive.primitive)["attributes"];
+    GltfAccessor     positions;
+    if (!getAccessor(document, attributes["POSITION"].getIndex(), positions))
+        return false;
+
+    std::vector<Vertex>& vertices = mesh.vertices;
+    vertices.assign(positions.count, Vertex {});
+    if (vertices.empty())
+        return true;
+
+    const uint64_t position  = attributes["POSITION"].getIndex();
+    const uint64_t normals   = attributes["NORMAL"].getIndex();
+    const uint64_t texcoords = attributes["TEXCOORD_0"].getIndex();
+    if (!readAttribute(document, position, 3, vertices.size(), &vertices[0].position.x) ||
+        (normals != k_no_index &&
+         !readAttribute(document, normals, 3, vertices.size(), &vertices[0].normal.x)) ||
+        (texcoords != k_no_index &&
+         !readAttribute(document, texcoords, 2, vertices.size(), &vertices[0].texcoords.x)))
+        return false;
+
+    const uint64_t indices = (*primitive.primitive)["indices"].getIndex();
+    if (indices == k_no_index)
+    {
+        mesh.indices.resize(vertices.size());
+        std::iota(mesh.indices.begin(), mesh.indices.end(), 0);
+    }
+    else if (!readIndices(document, indices, vertices.size(), mesh.indices))
+    {
+        return false;
+    }
+    makeTriangleList((*primitive.primitive)["mode"].getIndex(k_triangles), mesh.indices);
+
+    if (normals == k_no_index)
+        generateNormals(vertices, mesh.indices);
+    if (primitive.transform != glm::mat4(1.f))
+        transformMesh(primitive.transform, mesh);
+
+    const uint64_t material = (*primitive.primitive)["material"].getIndex();
+    mesh.material =
+        material < default_material ? static_cast<uint32_t>(material) : default_material;
+    return true;
+}
+
+// the path of the image a texture of a material shows, empty for images kept in a buffer
+static std::string getImagePath(const JsonValue& json, const JsonValue& texture_info)
+{
+    const JsonValue& texture = json["textures"].getItem(texture_info["index"].getIndex());
+    const JsonValue& image   = json["images"].getItem(texture["source"].getIndex());
+    const std::string& uri   = image["uri"].getString();
+    return uri.compare(0, 5, "data:") == 0 ? std::string() : decodeUri(uri);
+}
+
+bool loadGltf(const std::string&         path,
+              JobSystem&                 jobs,
+              std::vector<GltfMaterial>& materials,
+              std::vector<ImportedMesh>& meshes)
+{
+    materials.clear();
+    meshes.clear();
+
+    GltfDocument document;
+    GltfView     binary;
+    if (!readFile(path, document, binary) || !checkDocument(path, document.json))
+        return false;
+
+    const JsonValue&  json      = document.json;
+    const std::string directory = path.substr(0, path.find_last_of('/'));
+    if (!mapBuffers(path, directory, binary, document) || !resolveViews(path, document))
+        return false;
+
+    if (!checkNodes(path, json))
+        return false;
+
+    std::vector<GltfPrimitive> primitives;
+    std::vector<bool>          visited(json["nodes"].getSize(), false);
+    size_t                     skipped = 0;
+    for (uint64_t root : getRootNodes(json))
+    {
+        if (!collectNode(json, root, glm::mat4(1.f), 0, visited, primitives, skipped))
+        {
+            std::cout << "ERROR::GLTF:: " << path
+                      << " has nodes reached twice, through a cycle or a repeated root, or nested "
+                         "too deep"
+                      << std::endl;
+            return false;
+        }
+    }
+    if (skipped > 0)
+    {
+        std::cout << "Info: Skipped " << skipped << " point and line primitives of " << path
+                  << std::endl;
+    }
+
+    // the compressed views the primitives read, decoded before any of them is built
+    std::vector<uint64_t> views;
+    for (const auto& primitive : primitives)
+    {
+        const JsonValue& attributes = (*primitive.primitive)["attributes"];
+        for (const char* attribute : {"POSITION", "NORMAL", "TEXCOORD_0"})
+        {
+            addAccessorViews(json, attributes[attribute].getIndex(), views);
+        }
+        addAccessorViews(json, (*primitive.primitive)["indices"].getIndex(), views);
+    }
+    std::sort(views.begin(), views.end());
+    views.erase(std::unique(views.begin(), views.end()), views.end());
+    views.erase(std::remove_if(views.begin(),
+                               views.end(),
+                               [&](uint64_t view) {
+                                   return view >= document.views.size() ||
+                                          document.views[view].data;
+                               }),
+                views.end());
+
+    std::vector<uint8_t> decoded(views.size(), 0);
+    jobs.parallelFor(static_cast<uint32_t>(views.size()),
+                     1,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t view = begin; view < end; view++)
+                         {
+                             decoded[view] = decodeView(document, views[view]);
+                         }
+                     });
+    if (std::find(decoded.begin(), decoded.end(), 0) != decoded.end())
+    {
+        std::cout << "ERROR::GLTF:: " << path << " has compressed views that don't decode"
+                  << std::endl;
+        return false;
+    }
+
+    const JsonValue& materials_json   = json["materials"];
+    const uint32_t   default_material = static_cast<uint32_t>(materials_json.getSize());
+    meshes.resize(primitives.size());
+    std::vector<uint8_t> built(primitives.size(), 0);
+    jobs.parallelFor(static_cast<uint32_t>(primitives.size()),
+                     1,
+                     [&](uint32_t begin, uint32_t end, uint32_t) {
+                         for (uint32_t mesh = begin; mesh < end; mesh++)
+                         {
+                             built[mesh] = buildMesh(
+                                 document, primitives[mesh], default_material, meshes[mesh]);
+                         }
+                     });
+    if (std::find(built.begin(), built.end(), 0) != built.end())
+    {
+        std::cout << "ERROR::GLTF:: " << path << " has primitives with accessors it can't read"
+                  << std::endl;
+        meshes.clear();
+        return false;
+    }
+
+    size_t embedded_images = 0;
+    for (size_t index = 0; index <= materials_json.getSize(); index++)
+    {
+        const JsonValue& material   = materials_json.getItem(index);
+        const JsonValue& base_color = material["pbrMetallicRoughness"]["baseColorTexture"];
+        const JsonValue& normal     = material["normalTexture"];
+
+        GltfMaterial loaded;
+        loaded.name           = index < default_material ? material["name"].getString()
+                                                         : std::string(k_default_material);
+        loaded.base_color_map = getImagePath(json, base_color);
+        loaded.normal_map     = getImagePath(json, normal);
+        embedded_images += base_color.isObject() && loaded.base_color_map.empty() ? 1 : 0;
+        embedded_images += normal.isObject() && loaded.normal_map.empty() ? 1 : 0;
+        materials.push_back(loaded);
+    }
+    if (embedded_images > 0)
+    {
+        std::cout << "Info: " << embedded_images << " maps of " << path
+                  << " are images in its buffers, which aren't loaded" << std::endl;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+struct ImportedMesh;
+
+// the maps of a glTF material Model loads, image paths relative to the model. Empty for images
+// without a uri, the ones stored in a buffer
+struct GltfMaterial
+{
+    std::string name;
+    std::string base_color_map; // drawn as the diffuse map, like Assimp does
+    std::string normal_map;
+};
+
+// Reads a .gltf or .glb file without Assimp. The file and the .bin buffers it names are mapped and
+// the accessors read in place: indices packed as 32 bits are copied in one go, the rest convert on
+// the way into the vertices. Quantized attributes (KHR_mesh_quantization) are read as the integer
+// types they are stored in, views compressed with EXT_meshopt_compression are decoded on the jobs
+// first. The primitives of the nodes of the scene are listed depth first like Assimp's collects
+// them, so the mesh cache baked through Assimp applies, then built on the jobs and moved out of
+// their nodes by the world transform of the node.
+//
+// Only triangle primitives are read, strips and fans made into lists, and only the vertices,
+// indices and material of the meshes are filled in, see finishMeshes. Primitives without normals
+// get smooth ones. Tangents are left to the import, which makes MikkTSpace frames like glTF
+// expects. The last material is the default of primitives without one. Returns false when the
+// file can't be read or uses what the loader doesn't: skins, data uris, sparse indices and the
+// required extensions other than the two above
+bool loadGltf(const std::string&         path,
+              JobSystem&                 jobs,
+              std::vector<GltfMaterial>& materials,
+              std::vector<ImportedMesh>& meshes);
@@ -0,0 +1,47 @@
+#include <glad/glad.h>
+
+#include "gpu_timer.h"
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(2 * k_latency, &queries_[0][0]);
+    for (uint32_t index = 0; index < k_latency; index++)
+    {
+        pending_[index] = false;
+    }
+}
+
+GpuTimer::~GpuTimer()
+{
+    glDeleteQueries(2 * k_latency, &queries_[0][0]);
+}
+
+void GpuTimer::begin()
+{
+    // the slot we're about to reuse was issued k_latency frames ago, it is almost always ready. If
+    // it isn't, drop it rather than waiting for it
+    if (pending_[current_])
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(queries_[current_][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
+        {
+            GLuint64 begin_ns = 0;
+            GLuint64 end_ns   = 0;
+            glGetQueryObjectui64v(queries_[current_][0], GL_QUERY_RESULT, &begin_ns);
+            glGetQueryObjectui64v(queries_[current_][1], GL_QUERY_RESULT, &end_ns);
+            elapsed_ms_ = static_cast<float>(end_ns - begin_ns) * 1e-6f;
+        }
+        pending_[current_] = false;
+    }
+
+    glQueryCounter(queries_[current_][0], GL_TIMESTAMP);
+}
+
+void GpuTimer::end()
+{
+    glQueryCounter(queries_[current_][1], GL_TIMESTAMP);
+
+    pending_[current_] = true;
+    current_           = (current_ + 1) % k_latency;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+// Measures the GPU time spent between begin() and end() with a pair of GL_TIMESTAMP queries, so
+// timers may nest and overlap. Queries are kept in a small ring so reading a result never stalls
+// the pipeline: the reported value lags a few frames behind the one being recorded.
+class GpuTimer {
+public:
+    static constexpr uint32_t k_latency = 4;
+
+    GpuTimer();
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    void begin();
+    void end();
+
+    // the most recent resolved measurement in milliseconds
+    float getElapsedMs() const
+    {
+        return elapsed_ms_;
+    }
+
+private:
+    uint32_t queries_[k_latency][2]; // begin and end timestamps
+    bool     pending_[k_latency];
+    uint32_t current_ {0};
+    float    elapsed_ms_ {0.f};
+};
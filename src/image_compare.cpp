@@ -0,0 +1,90 @@
+#include <glad/glad.h>
+
+#include <cmath>
+#include <limits>
+
+#include "image_compare.h"
+
+std::vector<uint8_t> readTexture(uint32_t texture, uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> image(static_cast<size_t>(width) * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureSubImage(texture,
+                         0,
+                         0,
+                         0,
+                         0,
+                         width,
+                         height,
+                         1,
+                         GL_RGBA,
+                         GL_UNSIGNED_BYTE,
+                         static_cast<GLsizei>(image.size()),
+                         image.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    return image;
+}
+
+std::vector<uint8_t> downsampleImage(const std::vector<uint8_t>& image,
+                                     uint32_t                    width,
+                                     uint32_t                    height,
+                                     uint32_t                    factor)
+{
+    const uint32_t       target_width  = width / factor;
+    const uint32_t       target_height = height / factor;
+    std::vector<uint8_t> result(static_cast<size_t>(target_width) * target_height * 4);
+
+    for (uint32_t y = 0; y < target_height; y++)
+    {
+        for (uint32_t x = 0; x < target_width; x++)
+        {
+            uint32_t sum[4] = {0, 0, 0, 0};
+            for (uint32_t sample_y = 0; sample_y < factor; sample_y++)
+            {
+                const size_t row = static_cast<size_t>(y * factor + sample_y) * width;
+                for (uint32_t sample_x = 0; sample_x < factor; sample_x++)
+                {
+                    const uint8_t* texel = &image[(row + x * factor + sample_x) * 4];
+                    for (uint32_t channel = 0; channel < 4; channel++)
+                    {
+                        sum[channel] += texel[channel];
+                    }
+                }
+            }
+
+            uint8_t* target = &result[(static_cast<size_t>(y) * target_width + x) * 4];
+            for (uint32_t channel = 0; channel < 4; channel++)
+            {
+                target[channel] = static_cast<uint8_t>((sum[channel] + factor * factor / 2) /
+                                                       (factor * factor));
+            }
+        }
+    }
+    return result;
+}
+
+ImageError compareImages(const std::vector<uint8_t>& image, const std::vector<uint8_t>& reference)
+{
+    ImageError error;
+    if (image.size() != reference.size() || image.empty())
+        return error;
+
+    // alpha is ignored
+    double abs_sum     = 0.0;
+    double squared_sum = 0.0;
+    for (size_t index = 0; index < image.size(); index++)
+    {
+        if (index % 4 == 3)
+            continue;
+
+        const double difference = (image[index] - reference[index]) / 255.0;
+        abs_sum += std::abs(difference);
+        squared_sum += difference * difference;
+    }
+
+    const double count = static_cast<double>(image.size() / 4 * 3);
+    error.mean_abs     = abs_sum / count;
+    error.psnr         = squared_sum > 0.0 ? 10.0 * std::log10(count / squared_sum) :
+                                             std::numeric_limits<double>::infinity();
+    return error;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Helpers to measure image quality against a reference rendering. Images are tightly packed
+// RGBA8, bottom row first like GL reads them.
+
+struct ImageError
+{
+    double mean_abs {0.0}; // mean absolute error of the color channels, 0-1
+    double psnr {0.0};     // in dB, infinite for identical images
+};
+
+// the bottom-left width x height of a texture
+std::vector<uint8_t> readTexture(uint32_t texture, uint32_t width, uint32_t height);
+
+// box filters factor x factor blocks, width and height are the size of the source
+std::vector<uint8_t> downsampleImage(const std::vector<uint8_t>& image,
+                                     uint32_t                    width,
+                                     uint32_t                    height,
+                                     uint32_t                    factor);
+
+ImageError compareImages(const std::vector<uint8_t>& image, const std::vector<uint8_t>& reference);
@@ -0,0 +1,148 @@
+// CPU benchmark of the mesh import, no GPU needed. Reads a model with Assimp the way Model does,
+// Sponza by default, then converts its meshes with importMeshes on 1, 2, 4, ... threads up to
+// every thread, reports the time and speedup of each, and checks they all give the same meshes:
+//   import_benchmark [model] [options]
+//     --runs <n>       imports timed per thread count, the fastest counts (default 3)
+//     --threads <n>    most threads to try, 0 for all (default)
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "animation.h"
+#include "job_system.h"
+#include "mesh_cache.h"
+#include "mesh_import.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename T>
+static bool sameData(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+static bool sameMeshes(const std::vector<ImportedMesh>& a, const std::vector<ImportedMesh>& b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t mesh = 0; mesh < a.size(); mesh++)
+    {
+        if (!sameData(a[mesh].vertices, b[mesh].vertices) ||
+            !sameData(a[mesh].indices, b[mesh].indices) ||
+            !sameData(a[mesh].lod_indices, b[mesh].lod_indices) ||
+            !sameData(a[mesh].lods, b[mesh].lods) ||
+            !sameData(a[mesh].meshlets, b[mesh].meshlets))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::string model_path  = "../../../data/sponza/sponza.obj";
+    uint32_t    run_count   = 3;
+    uint32_t    max_threads = 0;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--runs") == 0 && index + 1 < argc)
+            run_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            max_threads = std::max(0, atoi(argv[++index]));
+        else if (argv[index][0] != '-')
+            model_path = argv[index];
+    }
+    if (max_threads == 0)
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const Clock::time_point read_start = Clock::now();
+    Assimp::Importer        importer;
+    const aiScene*          scene =
+        importer.ReadFile(model_path,
+                          aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return 1;
+    }
+    const double read_seconds = secondsSince(read_start);
+
+    // the baked lighting and skeleton as Model has them
+    MeshCache mesh_cache;
+    mesh_cache.load(MeshCache::getPath(model_path));
+    Skeleton skeleton;
+    importSkeleton(scene, skeleton);
+
+    std::vector<const aiMesh*> meshes;
+    std::vector<glm::mat4>     transforms;
+    collectMeshes(scene, meshes, transforms);
+    size_t vertex_count = 0;
+    for (const aiMesh* mesh : meshes)
+    {
+        vertex_count += mesh->mNumVertices;
+    }
+    std::cout << "Info: " << model_path << ", " << meshes.size() << " meshes, " << vertex_count
+              << " imported vertices, read by Assimp in " << read_seconds * 1e3 << " ms"
+              << std::endl;
+
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t threads = 1; threads < max_threads; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::vector<ImportedMesh> reference;
+    double                    single_thread_seconds = 0.0;
+    for (uint32_t threads : thread_counts)
+    {
+        JobSystem                 jobs(threads);
+        std::vector<ImportedMesh> imported;
+        double                    seconds = 0.0;
+        for (uint32_t run = 0; run < run_count; run++)
+        {
+            const Clock::time_point start = Clock::now();
+            importMeshes(meshes, transforms, skeleton, mesh_cache, jobs, imported);
+            const double run_seconds = secondsSince(start);
+            seconds                  = run == 0 ? run_seconds : std::min(seconds, run_seconds);
+        }
+
+        if (reference.empty())
+        {
+            reference             = std::move(imported);
+            single_thread_seconds = seconds;
+        }
+        else if (!sameMeshes(reference, imported))
+        {
+            std::cout << "ERROR::IMPORT:: meshes differ between thread counts" << std::endl;
+            return 1;
+        }
+
+        std::cout << "Info:   " << jobs.getThreadCount() << " threads: " << seconds * 1e3
+                  << " ms, " << single_thread_seconds / seconds << "x" << std::endl;
+    }
+
+    size_t welded_count = 0;
+    for (const auto& mesh : reference)
+    {
+        welded_count += mesh.vertices.size();
+    }
+    std::cout << "Info: " << welded_count << " vertices after welding and tangent frames"
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,245 @@
+// CPU benchmark of the instance streaming, no GPU needed. Moves a field of instances every frame,
+// writes the changed blocks to one of three copies standing in for the regions of the persistent
+// ring and culls the instances against a turning camera, on one thread and on every thread.
+// Checks both give the same copies and visible sets and reports the throughput of each step:
+//   instance_benchmark [options]
+//     --instances <n>    instances (default 1000000)
+//     --frames <n>       frames timed per run (default 100)
+//     --threads <n>      worker threads, 0 for all (default)
+//     --moving <f>       fraction of the instances moving every frame (default 1)
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "instance_manager.h"
+#include "job_system.h"
+
+static constexpr float    k_pi         = 3.14159265f;
+static constexpr float    k_time_step  = 1.f / 60.f;
+static constexpr float    k_field_size = 50.f; // radius of the field the instances orbit in
+static constexpr uint32_t k_copy_count = 3;
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static uint32_t hash(uint32_t value)
+{
+    const uint32_t state = value * 747796405u + 2891336453u;
+    const uint32_t word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+static float toUnitFloat(uint32_t value)
+{
+    return (value >> 8) * (1.f / 16777216.f);
+}
+
+// every instance circles the vertical axis at its own radius, height and speed
+struct Orbit
+{
+    float radius;
+    float height;
+    float phase;
+    float speed;
+};
+
+static void placeInstance(InstanceManager& instances,
+                          const Orbit&     orbit,
+                          uint32_t         index,
+                          float            time)
+{
+    const float angle = orbit.phase + orbit.speed * time;
+    instances.getPositions()[index] =
+        glm::vec3(orbit.radius * std::cos(angle), orbit.height, orbit.radius * std::sin(angle));
+    instances.getRotations()[index] = glm::angleAxis(-angle, glm::vec3(0.f, 1.f, 0.f));
+}
+
+struct RunResult
+{
+    double                   update_seconds {0.0};
+    double                   flush_seconds {0.0};
+    double                   cull_seconds {0.0};
+    uint64_t                 written {0};
+    uint64_t                 visible {0};
+    float                    transform_error {0.f}; // of the last copy written against glm
+    std::vector<GpuInstance> copies[k_copy_count];
+    std::vector<uint32_t>    last_visible;
+};
+
+static RunResult run(uint32_t                  instance_count,
+                     uint32_t                  frame_count,
+                     float                     moving,
+                     const std::vector<Orbit>& orbits,
+                     JobSystem&                jobs)
+{
+    InstanceManager instances(k_copy_count);
+    instances.setBounds(glm::vec3(0.f), 0.87f); // a unit cube
+    for (uint32_t index = 0; index < instance_count; index++)
+    {
+        const float scale = 0.2f + 0.3f * toUnitFloat(hash(index * 3 + 2));
+        instances.add(glm::vec3(0.f),
+                      glm::quat(1.f, 0.f, 0.f, 0.f),
+                      glm::vec3(scale),
+                      glm::vec4(toUnitFloat(hash(index)), 0.5f, 1.f, 1.f));
+        placeInstance(instances, orbits[index], index, 0.f);
+    }
+
+    RunResult result;
+    for (auto& copy : result.copies)
+    {
+        copy.resize(instance_count);
+    }
+    std::vector<uint32_t> visible(instance_count);
+
+    const uint32_t  moving_count  = static_cast<uint32_t>(moving * instance_count);
+    const glm::mat4 projection    = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 100.f);
+    uint32_t        visible_count = 0;
+
+    // the first frame writes every copy once
+    for (uint32_t frame = 0; frame < frame_count + k_copy_count; frame++)
+    {
+        const float time  = frame * k_time_step;
+        const bool  timed = frame >= k_copy_count;
+
+        Clock::time_point start = Clock::now();
+        jobs.parallelFor(moving_count,
+                         InstanceManager::k_block_size,
+                         [&](uint32_t begin, uint32_t end, uint32_t) {
+                             for (uint32_t index = begin; index < end; index++)
+                             {
+                                 placeInstance(instances, orbits[index], index, time);
+                             }
+                         });
+        instances.markDirty(0, moving_count);
+        if (timed)
+            result.update_seconds += secondsSince(start);
+
+        start                  = Clock::now();
+        const uint32_t copy    = frame % k_copy_count;
+        const uint32_t written = instances.flush(copy, result.copies[copy].data(), jobs);
+        if (timed)
+        {
+            result.flush_seconds += secondsSince(start);
+            result.written += written;
+        }
+
+        const float     heading = 0.3f * time;
+        const glm::vec3 eye(0.f, 5.f, 0.f);
+        const glm::vec3 direction(std::cos(heading), -0.1f, std::sin(heading));
+        const glm::mat4 view = glm::lookAt(eye, eye + direction, glm::vec3(0.f, 1.f, 0.f));
+
+        start         = Clock::now();
+        visible_count = instances.cull(projection * view, jobs, visible.data());
+        if (timed)
+        {
+            result.cull_seconds += secondsSince(start);
+            result.visible += visible_count;
+        }
+    }
+
+    // the copy the last frame wrote holds every instance as placed then
+    const std::vector<GpuInstance>& last_copy =
+        result.copies[(frame_count + k_copy_count - 1) % k_copy_count];
+    for (uint32_t index = 0; index < instance_count; index += 97)
+    {
+        const glm::mat4 model =
+            glm::translate(glm::mat4(1.f), instances.getPositions()[index]) *
+            glm::mat4_cast(instances.getRotations()[index]) *
+            glm::scale(glm::mat4(1.f), instances.getScales()[index]);
+        for (int row = 0; row < 3; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                result.transform_error =
+                    std::max(result.transform_error,
+                             std::abs(last_copy[index].rows[row][column] - model[column][row]));
+            }
+        }
+    }
+
+    result.last_visible.assign(visible.begin(), visible.begin() + visible_count);
+    std::sort(result.last_visible.begin(), result.last_visible.end());
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t instance_count = 1000000;
+    uint32_t frame_count    = 100;
+    uint32_t thread_count   = 0;
+    float    moving         = 1.f;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--instances") == 0 && index + 1 < argc)
+            instance_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--frames") == 0 && index + 1 < argc)
+            frame_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            thread_count = std::max(0, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--moving") == 0 && index + 1 < argc)
+            moving = glm::clamp(static_cast<float>(atof(argv[++index])), 0.f, 1.f);
+    }
+
+    std::vector<Orbit> orbits(instance_count);
+    for (uint32_t index = 0; index < instance_count; index++)
+    {
+        orbits[index].radius = k_field_size * std::sqrt(toUnitFloat(hash(index * 4 + 0)));
+        orbits[index].height = 10.f * toUnitFloat(hash(index * 4 + 1));
+        orbits[index].phase  = 2.f * k_pi * toUnitFloat(hash(index * 4 + 2));
+        orbits[index].speed  = 0.2f + 0.8f * toUnitFloat(hash(index * 4 + 3));
+    }
+    std::cout << "Info: " << instance_count << " instances, " << moving * 100.f
+              << "% moving, " << sizeof(GpuInstance) * instance_count / (1024 * 1024)
+              << " MB per copy" << std::endl;
+
+    JobSystem jobs(thread_count);
+    JobSystem single_thread(1);
+    RunResult results[2];
+    uint32_t  run_index = 0;
+    for (JobSystem* pool : {&single_thread, &jobs})
+    {
+        RunResult& result = results[run_index++];
+        result            = run(instance_count, frame_count, moving, orbits, *pool);
+
+        const double instances = static_cast<double>(instance_count) * frame_count;
+        std::cout << "Info:   " << pool->getThreadCount() << " threads: update "
+                  << result.update_seconds * 1e3 / frame_count << " ms, flush "
+                  << result.flush_seconds * 1e3 / frame_count << " ms ("
+                  << 1e-6 * result.written / result.flush_seconds << " M instances/s, "
+                  << result.written * sizeof(GpuInstance) / frame_count / (1024 * 1024)
+                  << " MB per frame), cull " << result.cull_seconds * 1e3 / frame_count
+                  << " ms (" << 1e-6 * instances / result.cull_seconds << " M instances/s, "
+                  << result.visible / frame_count << " visible), transform error "
+                  << result.transform_error << std::endl;
+    }
+
+    // the copies and the visible set must not depend on the thread count, only the order of the
+    // visible indices may
+    for (uint32_t copy = 0; copy < k_copy_count; copy++)
+    {
+        if (memcmp(results[0].copies[copy].data(),
+                   results[1].copies[copy].data(),
+                   instance_count * sizeof(GpuInstance)) != 0)
+        {
+            std::cout << "ERROR::INSTANCES:: copies differ between thread counts" << std::endl;
+            return 1;
+        }
+    }
+    if (results[0].last_visible != results[1].last_visible)
+    {
+        std::cout << "ERROR::INSTANCES:: visible sets differ between thread counts" << std::endl;
+        return 1;
+    }
+    return 0;
+}
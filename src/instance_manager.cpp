@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "instance_manager.h"
+#include "job_system.h"
+
+InstanceManager::InstanceManager(uint32_t copy_count) :
+    copy_count_(std::min(std::max(copy_count, 1u), 8u)),
+    all_copies_(static_cast<uint8_t>((1u << copy_count_) - 1))
+{
+}
+
+void InstanceManager::setBounds(const glm::vec3& center, float radius)
+{
+    bounds_center_ = center;
+    bounds_radius_ = radius;
+}
+
+uint32_t InstanceManager::add(const glm::vec3& position,
+                              const glm::quat& rotation,
+                              const glm::vec3& scale,
+                              const glm::vec4& custom)
+{
+    const uint32_t index = getCount();
+    positions_.push_back(position);
+    rotations_.push_back(rotation);
+    scales_.push_back(scale);
+    custom_.push_back(custom);
+    dirty_.resize(index / k_block_size + 1, 0);
+    dirty_[index / k_block_size] = all_copies_;
+    return index;
+}
+
+void InstanceManager::setTransform(uint32_t         index,
+                                   const glm::vec3& position,
+                                   const glm::quat& rotation,
+                                   const glm::vec3& scale)
+{
+    positions_[index]            = position;
+    rotations_[index]            = rotation;
+    scales_[index]               = scale;
+    dirty_[index / k_block_size] = all_copies_;
+}
+
+void InstanceManager::setCustom(uint32_t index, const glm::vec4& custom)
+{
+    custom_[index]               = custom;
+    dirty_[index / k_block_size] = all_copies_;
+}
+
+void InstanceManager::markDirty(uint32_t begin, uint32_t end)
+{
+    if (begin >= end)
+        return;
+    std::fill(dirty_.begin() + begin / k_block_size,
+              dirty_.begin() + (end - 1) / k_block_size + 1,
+              all_copies_);
+}
+
+uint32_t InstanceManager::flush(uint32_t copy, GpuInstance* destination, JobSystem& jobs)
+{
+    const uint8_t         bit = static_cast<uint8_t>(1u << (copy % copy_count_));
+    std::atomic<uint32_t> written {0};
+
+    // batches are whole blocks, so only one thread touches the flags of a block
+    jobs.parallelFor(getCount(), k_block_size, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t block = begin; block < end; block += k_block_size)
+        {
+            uint8_t& dirty = dirty_[block / k_block_size];
+            if (!(dirty & bit))
+                continue;
+            dirty &= ~bit;
+
+            const uint32_t block_end = std::min(block + k_block_size, end);
+            for (uint32_t index = block; index < block_end; index++)
+            {
+                const glm::mat3 rotation = glm::mat3_cast(rotations_[index]);
+                const glm::vec3 scale    = scales_[index];
+                const glm::vec3 position = positions_[index];
+
+                GpuInstance instance;
+                for (int row = 0; row < 3; row++)
+                {
+                    instance.rows[row] = glm::vec4(rotation[0][row] * scale.x,
+                                                   rotation[1][row] * scale.y,
+                                                   rotation[2][row] * scale.z,
+                                                   position[row]);
+                }
+                instance.custom    = custom_[index];
+                destination[index] = instance;
+            }
+            written += block_end - block;
+        }
+    });
+    return written;
+}
+
+uint32_t InstanceManager::cull(const glm::mat4& view_projection, JobSystem& jobs, uint32_t* visible)
+{
+    // frustum planes, a sphere outside of any of them is off screen
+    const glm::mat4 rows = glm::transpose(view_projection);
+    glm::vec4       planes[6];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        planes[2 * axis]     = rows[3] + rows[axis];
+        planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+    for (auto& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    visible_scratch_.resize(jobs.getThreadCount());
+    std::atomic<uint32_t> visible_count {0};
+    jobs.parallelFor(getCount(), k_block_size, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+        std::vector<uint32_t>& batch = visible_scratch_[thread];
+        batch.clear();
+        for (uint32_t index = begin; index < end; index++)
+        {
+            const glm::vec3 scale = glm::abs(scales_[index]);
+            const glm::vec3 center =
+                positions_[index] + rotations_[index] * (scales_[index] * bounds_center_);
+            const float radius = bounds_radius_ * std::max(scale.x, std::max(scale.y, scale.z));
+
+            bool inside = true;
+            for (const auto& plane : planes)
+            {
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                {
+                    inside = false;
+                    break;
+                }
+            }
+            if (inside)
+                batch.push_back(index);
+        }
+
+        // one reservation per batch keeps the runs of indices contiguous
+        if (!batch.empty())
+        {
+            const uint32_t offset = visible_count.fetch_add(static_cast<uint32_t>(batch.size()));
+            memcpy(visible + offset, batch.data(), batch.size() * sizeof(uint32_t));
+        }
+    });
+    return visible_count;
+}
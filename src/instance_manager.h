@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// What the shaders read per instance: the first three rows of the affine model matrix and the
+// custom data, a tint in the scene shaders. 64 bytes, laid out as the std430 Instance struct
+struct GpuInstance
+{
+    glm::vec4 rows[3];
+    glm::vec4 custom;
+};
+
+// Instances of one mesh. Transforms and custom data are kept as separate arrays on the CPU and
+// streamed to a few GPU copies of them, one written per frame, such as the regions of a
+// RingBuffer. Every block of k_block_size instances has a dirty bit per copy, so a copy only gets
+// the blocks that changed since it was last written. Every frame the instances are also culled
+// against the view frustum into a list of the visible ones, which the vertex shaders index with
+// gl_BaseInstance + gl_InstanceID: one instanced draw covers the whole list, or indirect commands
+// cover parts of it. Writing the copies and culling both run in parallel.
+class InstanceManager {
+public:
+    static constexpr uint32_t k_block_size = 1024;
+
+    // copy_count is the number of GPU copies, at most 8
+    explicit InstanceManager(uint32_t copy_count);
+
+    // bounding sphere of the mesh in model space, what the culling tests
+    void setBounds(const glm::vec3& center, float radius);
+
+    uint32_t add(const glm::vec3& position,
+                 const glm::quat& rotation,
+                 const glm::vec3& scale,
+                 const glm::vec4& custom = glm::vec4(1.f));
+
+    uint32_t getCount() const
+    {
+        return static_cast<uint32_t>(positions_.size());
+    }
+
+    void setTransform(uint32_t         index,
+                      const glm::vec3& position,
+                      const glm::quat& rotation,
+                      const glm::vec3& scale);
+    void setCustom(uint32_t index, const glm::vec4& custom);
+
+    // the arrays themselves for bulk updates, which must be followed by markDirty() over the
+    // instances written
+    glm::vec3* getPositions()
+    {
+        return positions_.data();
+    }
+    glm::quat* getRotations()
+    {
+        return rotations_.data();
+    }
+    glm::vec3* getScales()
+    {
+        return scales_.data();
+    }
+    glm::vec4* getCustom()
+    {
+        return custom_.data();
+    }
+    void markDirty(uint32_t begin, uint32_t end);
+
+    // writes the blocks changed since copy was last written to it. The destination holds every
+    // instance, it is only ever written, block by block. Returns the instances written
+    uint32_t flush(uint32_t copy, GpuInstance* destination, JobSystem& jobs);
+
+    // writes the indices of the instances within the frustum of view_projection, in no particular
+    // order, and returns their count. The destination has room for every instance and is only
+    // ever written, in runs of indices
+    uint32_t cull(const glm::mat4& view_projection, JobSystem& jobs, uint32_t* visible);
+
+private:
+    uint32_t copy_count_;
+    uint8_t  all_copies_; // dirty bits of a block every copy has to get
+
+    std::vector<glm::vec3> positions_;
+    std::vector<glm::quat> rotations_;
+    std::vector<glm::vec3> scales_;
+    std::vector<glm::vec4> custom_;
+    std::vector<uint8_t>   dirty_; // a bit per copy for every block
+
+    glm::vec3 bounds_center_ {0.f};
+    float     bounds_radius_ {1.f};
+
+    std::vector<std::vector<uint32_t>> visible_scratch_; // per thread
+};
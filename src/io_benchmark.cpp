@@ -0,0 +1,291 @@
+// CPU benchmark of the asynchronous texture reads, no GPU needed. Reads every file of a directory,
+// the Sponza textures by default, and decodes it with stb_image the way Model does, first one
+// after the other on this thread as Model used to, then with an AsyncFileReader decoding each file
+// on the jobs as soon as it is read. Times the reads alone on io_uring at queue depths 1, 2, 4, ...
+// up to --depth against the jobs reading, then the whole load, cold from the disk and warm from
+// the page cache. Checks every reader hands out the bytes on disk, outside the times:
+//   io_benchmark [directory] [options]
+//     --root <dir>     directory the app runs from the assets of (default ../../..)
+//     --runs <n>       warm loads timed, the fastest counts (default 3)
+//     --depth <n>      deepest queue to try (default 64)
+//     --threads <n>    threads of the jobs, 0 for all (default)
+//     --direct         read the large files with O_DIRECT as well
+// The directory is relative to the root. The cold loads drop the files from the page cache first,
+// which only Linux and the other POSIX systems can do without privileges.
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image/stb_image.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_file.h"
+#include "async_io.h"
+#include "job_system.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// drops the pages of the files from the page cache so the next read goes to the disk
+static bool evictFiles(const std::vector<std::string>& paths)
+{
+#ifdef _WIN32
+    (void)paths;
+    return false;
+#else
+    bool evicted = true;
+    for (const auto& path : paths)
+    {
+        const int file = open(path.c_str(), O_RDONLY);
+        evicted &= file >= 0 && posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        if (file >= 0)
+            close(file);
+    }
+    return evicted;
+#endif
+}
+
+// FNV-1a of the bytes, to tell the readers hand out the same files
+static uint64_t hashBytes(const char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t index = 0; index < size; index++)
+    {
+        hash = (hash ^ static_cast<uint8_t>(data[index])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// a byte of every page, so mapped files are read in whole
+static uint32_t touchPages(const char* data, size_t size)
+{
+    uint32_t sum = 0;
+    for (size_t offset = 0; offset < size; offset += 4096)
+    {
+        sum += static_cast<uint8_t>(data[offset]);
+    }
+    return sum;
+}
+
+// decodes a file like Model does, returns whether it is an image
+static bool decodeImage(const char* data, size_t size)
+{
+    int            width, height, components;
+    unsigned char* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(data),
+                                                  static_cast<int>(size),
+                                                  &width,
+                                                  &height,
+                                                  &components,
+                                                  0);
+    stbi_image_free(pixels);
+    return pixels != nullptr;
+}
+
+// a load of the files, cold and warm
+struct LoadTimes
+{
+    double cold_seconds {0.0};
+    double warm_seconds {0.0};
+    bool   cold {false}; // whether the page cache could be dropped for the cold load
+};
+
+// times load, cold once and warm the fastest of run_count
+template <typename Load>
+static LoadTimes timeLoads(const std::vector<std::string>& paths, uint32_t run_count, Load load)
+{
+    LoadTimes times;
+    times.cold                         = evictFiles(paths);
+    const Clock::time_point cold_start = Clock::now();
+    load();
+    times.cold_seconds = secondsSince(cold_start);
+
+    for (uint32_t run = 0; run < run_count; run++)
+    {
+        const Clock::time_point start = Clock::now();
+        load();
+        const double seconds = secondsSince(start);
+        times.warm_seconds   = run == 0 ? seconds : std::min(times.warm_seconds, seconds);
+    }
+    return times;
+}
+
+static void reportLoads(const std::string& name, const LoadTimes& times, uint64_t size)
+{
+    std::cout << "Info: " << name << ": ";
+    if (times.cold)
+        std::cout << "cold " << times.cold_seconds * 1e3 << " ms ("
+                  << size / 1e6 / times.cold_seconds << " MB/s), ";
+    else
+        std::cout << "cold not measured, the page cache can't be dropped here, ";
+    std::cout << "warm " << times.warm_seconds * 1e3 << " ms (" << size / 1e6 / times.warm_seconds
+              << " MB/s)" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    std::string root         = "../../..";
+    std::string directory    = "data/sponza/textures";
+    uint32_t    run_count    = 3;
+    uint32_t    max_depth    = 64;
+    uint32_t    thread_count = 0;
+    bool        try_direct   = false;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--root") == 0 && index + 1 < argc)
+            root = argv[++index];
+        else if (strcmp(argv[index], "--runs") == 0 && index + 1 < argc)
+            run_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--depth") == 0 && index + 1 < argc)
+            max_depth = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            thread_count = std::max(0, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--direct") == 0)
+            try_direct = true;
+        else if (argv[index][0] != '-')
+            directory = argv[index];
+    }
+
+    std::vector<std::string> paths;
+    std::error_code          error;
+    for (std::filesystem::directory_iterator entry(root + '/' + directory, error);
+         !error && entry != std::filesystem::directory_iterator();
+         entry.increment(error))
+    {
+        if (entry->is_regular_file())
+            paths.push_back(entry->path().string());
+    }
+    if (error || paths.empty())
+    {
+        std::cout << "ERROR::IO_BENCHMARK:: no files in " << root << '/' << directory << std::endl;
+        return 1;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // the files as the blocking reads see them
+    uint64_t              total_size  = 0;
+    uint32_t              image_count = 0;
+    std::vector<uint64_t> hashes(paths.size());
+    for (size_t index = 0; index < paths.size(); index++)
+    {
+        AssetFile file;
+        if (!file.open(paths[index]))
+        {
+            std::cout << "ERROR::IO_BENCHMARK:: can't read " << paths[index] << std::endl;
+            return 1;
+        }
+        hashes[index] = hashBytes(file.getData(), file.getSize());
+        total_size += file.getSize();
+        image_count += decodeImage(file.getData(), file.getSize());
+    }
+
+    JobSystem jobs(thread_count);
+    std::cout << "Info: " << paths.size() << " files, " << total_size / 1e6 << " MB, "
+              << image_count << " images, in " << root << '/' << directory << " on "
+              << jobs.getThreadCount() << " threads" << std::endl;
+
+    // each file read and decoded in turn on this thread
+    uint32_t        checksum = 0;
+    const LoadTimes blocking = timeLoads(paths, run_count, [&] {
+        for (const auto& path : paths)
+        {
+            AssetFile file;
+            if (!file.open(path))
+                continue;
+            checksum += touchPages(file.getData(), file.getSize());
+            decodeImage(file.getData(), file.getSize());
+        }
+    });
+    reportLoads("Blocking reads and decodes", blocking, total_size);
+
+    // every file handled on the jobs as soon as it arrives
+    std::atomic<uint32_t> async_checksum {0};
+    const auto            readFiles = [&](AsyncFileReader& reader, bool decode) {
+        reader.readFiles(paths, [&](uint32_t, const char* data, size_t size, uint32_t) {
+            if (!data)
+                return;
+            async_checksum += touchPages(data, size);
+            if (decode)
+                decodeImage(data, size);
+        });
+    };
+    // whether a reader hands out the files on disk
+    const auto checkFiles = [&](AsyncFileReader& reader) {
+        std::atomic<bool> same {true};
+        reader.readFiles(paths, [&](uint32_t index, const char* data, size_t size, uint32_t) {
+            if (!data || hashBytes(data, size) != hashes[index])
+                same = false;
+        });
+        if (!same)
+            std::cout << "ERROR::IO_BENCHMARK:: the files read differ from the ones on disk"
+                      << std::endl;
+        return same.load();
+    };
+
+    const auto describe = [](const AsyncFileReader& reader, const AsyncReadSettings& settings) {
+        if (reader.getBackend() == AsyncReadBackend::jobs)
+            return std::string("the jobs");
+        return "io_uring, queue depth " + std::to_string(settings.queue_depth) + ", " +
+               std::to_string(reader.getFixedBufferCount()) + " registered buffers" +
+               (settings.direct ? ", O_DIRECT" : "");
+    };
+
+    // the jobs reading, then io_uring at every queue depth
+    std::vector<AsyncReadSettings> read_settings(1);
+    for (int direct = 0; direct < (try_direct ? 2 : 1); direct++)
+    {
+        for (uint32_t depth = 1; depth <= max_depth; depth *= 2)
+        {
+            read_settings.emplace_back();
+            read_settings.back().queue_depth  = depth;
+            read_settings.back().use_io_uring = true;
+            read_settings.back().direct       = direct != 0;
+        }
+    }
+    for (const auto& settings : read_settings)
+    {
+        AsyncFileReader reader(jobs, settings);
+        if (settings.use_io_uring && reader.getBackend() != AsyncReadBackend::io_uring)
+            break;
+        const LoadTimes reads = timeLoads(paths, run_count, [&] { readFiles(reader, false); });
+        reportLoads("Reads on " + describe(reader, settings), reads, total_size);
+        if (!checkFiles(reader))
+            return 1;
+    }
+
+    // the whole load the way Model does it, the default queue depth unless deeper than asked
+    std::vector<AsyncReadSettings> load_settings(try_direct ? 3 : 2);
+    for (size_t index = 1; index < load_settings.size(); index++)
+    {
+        load_settings[index].queue_depth  = std::min(load_settings[index].queue_depth, max_depth);
+        load_settings[index].use_io_uring = true;
+        load_settings[index].direct       = index == 2;
+    }
+    for (const auto& settings : load_settings)
+    {
+        AsyncFileReader reader(jobs, settings);
+        if (settings.use_io_uring && reader.getBackend() != AsyncReadBackend::io_uring)
+            break;
+        const LoadTimes loads = timeLoads(paths, run_count, [&] { readFiles(reader, true); });
+        reportLoads("Reads and decodes on " + describe(reader, settings), loads, total_size);
+    }
+
+    // keeps the reads from being optimized out
+    std::cout << "Info: checksum " << checksum + async_checksum << std::endl;
+    return 0;
+}
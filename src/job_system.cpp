@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "job_system.h"
+
+JobSystem::JobSystem(uint32_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (uint32_t thread = 1; thread < thread_count; thread++)
+    {
+        workers_.emplace_back(&JobSystem::workerLoop, this, thread);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t batch_size, const Job& job)
+{
+    if (count == 0)
+        return;
+
+    batch_size = std::max(batch_size, 1u);
+    if (workers_.empty() || count <= batch_size)
+    {
+        job(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_          = &job;
+        count_        = count;
+        batch_size_   = batch_size;
+        busy_workers_ = static_cast<uint32_t>(workers_.size());
+        next_.store(0);
+        generation_++;
+    }
+    wake_.notify_all();
+
+    runBatches(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_workers_ == 0; });
+    job_ = nullptr;
+}
+
+void JobSystem::workerLoop(uint32_t thread)
+{
+    uint64_t generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&] { return quit_ || generation_ != generation; });
+            if (quit_)
+                return;
+            generation = generation_;
+        }
+
+        runBatches(thread);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busy_workers_ == 0)
+        {
+            done_.notify_one();
+        }
+    }
+}
+
+void JobSystem::runBatches(uint32_t thread)
+{
+    for (;;)
+    {
+        const uint32_t begin = next_.fetch_add(batch_size_);
+        if (begin >= count_)
+            break;
+
+        (*job_)(begin, std::min(begin + batch_size_, count_), thread);
+    }
+}
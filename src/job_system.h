@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for CPU batch work. parallelFor() cuts a range into batches that
+// the workers and the calling thread pull from a shared counter, and returns once every batch is
+// done. One parallelFor() runs at a time, jobs must not start another.
+class JobSystem {
+public:
+    // job over [begin, end), thread is 0 for the caller and 1..getThreadCount()-1 for the workers
+    using Job = std::function<void(uint32_t begin, uint32_t end, uint32_t thread)>;
+
+    // 0 uses every hardware thread
+    explicit JobSystem(uint32_t thread_count = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // workers plus the calling thread
+    uint32_t getThreadCount() const
+    {
+        return static_cast<uint32_t>(workers_.size()) + 1;
+    }
+
+    void parallelFor(uint32_t count, uint32_t batch_size, const Job& job);
+
+private:
+    void workerLoop(uint32_t thread);
+    void runBatches(uint32_t thread);
+
+    std::vector<std::thread> workers_;
+
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    uint64_t                generation_ {0};
+    uint32_t                busy_workers_ {0};
+    bool                    quit_ {false};
+
+    // the running parallelFor(), published to the workers under the mutex
+    const Job*            job_ {nullptr};
+    uint32_t              count_ {0};
+    uint32_t              batch_size_ {1};
+    std::atomic<uint32_t> next_ {0};
+};
@@ -0,0 +1,354 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "json.h"
+
+// nesting deeper than this is taken for a broken file rather than recursed into
+static constexpr uint32_t k_max_depth = 256;
+
+class JsonParser {
+public:
+    JsonParser(const char* text, size_t size) :
+        current_(text), begin_(text), end_(text + size)
+    {}
+
+    bool parseDocument(JsonValue& value)
+    {
+        skipSpace();
+        if (!parseValue(value, 0))
+            return false;
+        skipSpace();
+        return current_ == end_ || fail("text after the document");
+    }
+
+    std::string getError() const
+    {
+        return error_ + " at offset " + std::to_string(current_ - begin_);
+    }
+
+private:
+    const char* current_;
+    const char* begin_;
+    const char* end_;
+    std::string error_;
+
+    bool fail(const char* error)
+    {
+        if (error_.empty())
+            error_ = error;
+        return false;
+    }
+
+    void skipSpace()
+    {
+        while (current_ < end_ &&
+               (*current_ == ' ' || *current_ == '\t' || *current_ == '\n' || *current_ == '\r'))
+        {
+            current_++;
+        }
+    }
+
+    bool consume(const char* literal)
+    {
+        const size_t length = strlen(literal);
+        if (static_cast<size_t>(end_ - current_) < length || memcmp(current_, literal, length) != 0)
+            return false;
+        current_ += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, uint32_t depth)
+    {
+        if (current_ == end_)
+            return fail("unexpected end");
+
+        switch (*current_)
+        {
+            case '{':
+                return parseObject(value, depth + 1);
+            case '[':
+                return parseArray(value, depth + 1);
+            case '"':
+                value.type_ = JsonValue::Type::string;
+                return parseString(value.string_);
+            case 't':
+            case 'f':
+                value.type_    = JsonValue::Type::boolean;
+                value.boolean_ = *current_ == 't';
+                return consume(value.boolean_ ? "true" : "false") || fail("bad literal");
+            case 'n':
+                return consume("null") || fail("bad literal");
+            default:
+                return parseNumber(value);
+        }
+    }
+
+    bool parseObject(JsonValue& value, uint32_t depth)
+    {
+        if (depth > k_max_depth)
+            return fail("nesting too deep");
+
+        value.type_ = JsonValue::Type::object;
+        current_++;
+        skipSpace();
+        if (current_ < end_ && *current_ == '}')
+        {
+            current_++;
+            return true;
+        }
+
+        while (true)
+        {
+            skipSpace();
+            if (current_ == end_ || *current_ != '"')
+                return fail("expected a key");
+
+            value.keys_.emplace_back();
+            if (!parseString(value.keys_.back()))
+                return false;
+
+            skipSpace();
+            if (current_ == end_ || *current_ != ':')
+                return fail("expected ':'");
+            current_++;
+            skipSpace();
+
+            value.items_.emplace_back();
+            if (!parseValue(value.items_.back(), depth))
+                return false;
+
+            skipSpace();
+            if (current_ < end_ && *current_ == ',')
+            {
+                current_++;
+                continue;
+            }
+            if (current_ < end_ && *current_ == '}')
+            {
+                current_++;
+                return true;
+            }
+            return fail("expected ',' or '}'");
+        }
+    }
+
+    bool parseArray(JsonValue& value, uint32_t depth)
+    {
+        if (depth > k_max_depth)
+            return fail("nesting too deep");
+
+        value.type_ = JsonValue::Type::array;
+        current_++;
+        skipSpace();
+        if (current_ < end_ && *current_ == ']')
+        {
+            current_++;
+            return true;
+        }
+
+        while (true)
+        {
+            skipSpace();
+            value.items_.emplace_back();
+            if (!parseValue(value.items_.back(), depth))
+                return false;
+
+            skipSpace();
+            if (current_ < end_ && *current_ == ',')
+            {
+                current_++;
+                continue;
+            }
+            if (current_ < end_ && *current_ == ']')
+            {
+                current_++;
+                return true;
+            }
+            return fail("expected ',' or ']'");
+        }
+    }
+
+    bool parseHex(uint32_t& code)
+    {
+        if (end_ - current_ < 4)
+            return fail("short \\u escape");
+
+        code = 0;
+        for (int digit = 0; digit < 4; digit++)
+        {
+            const char c = *current_++;
+            code <<= 4;
+            if (c >= '0' && c <= '9')
+                code |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                code |= c - 'A' + 10;
+            else
+                return fail("bad \\u escape");
+        }
+        return true;
+    }
+
+    static void appendUtf8(uint32_t code, std::string& string)
+    {
+        if (code < 0x80)
+        {
+            string += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            string += static_cast<char>(0xc0 | (code >> 6));
+            string += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else if (code < 0x10000)
+        {
+            string += static_cast<char>(0xe0 | (code >> 12));
+            string += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            string += static_cast<char>(0x80 | (code & 0x3f));
+        }
+        else
+        {
+            string += static_cast<char>(0xf0 | (code >> 18));
+            string += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+            string += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+            string += static_cast<char>(0x80 | (code & 0x3f));
+        }
+    }
+
+    bool parseString(std::string& string)
+    {
+        current_++;
+        while (true)
+        {
+            // the plain run up to the next quote or escape in one go
+            const char* run = current_;
+            while (current_ < end_ && *current_ != '"' && *current_ != '\\')
+            {
+                current_++;
+            }
+            string.append(run, current_);
+
+            if (current_ == end_)
+                return fail("unterminated string");
+            if (*current_++ == '"')
+                return true;
+            if (current_ == end_)
+                return fail("unterminated string");
+
+            const char escape = *current_++;
+            switch (escape)
+            {
+                case '"':
+                case '\\':
+                case '/':
+                    string += escape;
+                    break;
+                case 'b':
+                    string += '\b';
+                    break;
+                case 'f':
+                    string += '\f';
+                    break;
+                case 'n':
+                    string += '\n';
+                    break;
+                case 'r':
+                    string += '\r';
+                    break;
+                case 't':
+                    string += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t code;
+                    if (!parseHex(code))
+                        return false;
+                    // a high surrogate pairs with the low one escaped after it
+                    if (code >= 0xd800 && code < 0xdc00 && consume("\\u"))
+                    {
+                        uint32_t low;
+                        if (!parseHex(low))
+                            return false;
+                        if (low >= 0xdc00 && low < 0xe000)
+                            code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+                    }
+                    appendUtf8(code, string);
+                    break;
+                }
+                default:
+                    return fail("bad escape");
+            }
+        }
+    }
+
+    bool parseNumber(JsonValue& value)
+    {
+        // strtod reads past the number given the chance, so it gets a terminated copy
+        const char* start = current_;
+        while (current_ < end_ &&
+               ((*current_ >= '0' && *current_ <= '9') || strchr("+-.eE", *current_)))
+        {
+            current_++;
+        }
+        const std::string number(start, current_);
+        if (number.empty())
+            return fail("unexpected character");
+
+        char* number_end = nullptr;
+        value.type_      = JsonValue::Type::number;
+        value.number_    = strtod(number.c_str(), &number_end);
+        return number_end == number.c_str() + number.size() || fail("bad number");
+    }
+};
+
+bool JsonValue::getBool(bool fallback) const
+{
+    return type_ == Type::boolean ? boolean_ : fallback;
+}
+
+double JsonValue::getNumber(double fallback) const
+{
+    return type_ == Type::number ? number_ : fallback;
+}
+
+uint64_t JsonValue::getIndex(uint64_t fallback) const
+{
+    if (type_ != Type::number || number_ < 0.0 || number_ >= 9007199254740992.0 ||
+        std::floor(number_) != number_)
+        return fallback;
+    return static_cast<uint64_t>(number_);
+}
+
+const JsonValue& JsonValue::getItem(size_t index) const
+{
+    static const JsonValue null_value;
+    return type_ == Type::array && index < items_.size() ? items_[index] : null_value;
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const
+{
+    static const JsonValue null_value;
+    if (type_ != Type::object)
+        return null_value;
+
+    for (size_t index = 0; index < keys_.size(); index++)
+    {
+        if (keys_[index] == key)
+            return items_[index];
+    }
+    return null_value;
+}
+
+bool JsonValue::parse(const char* text, size_t size, JsonValue& value, std::string& error)
+{
+    value = JsonValue();
+
+    JsonParser parser(text, size);
+    if (parser.parseDocument(value))
+        return true;
+
+    error = parser.getError();
+    return false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A parsed JSON document, enough for the glTF loader. Reading a member or element that isn't
+// there gives a null value, so lookups chain without checks and fall back to their defaults.
+class JsonValue {
+public:
+    enum class Type
+    {
+        null,
+        boolean,
+        number,
+        string,
+        array,
+        object
+    };
+
+    Type getType() const
+    {
+        return type_;
+    }
+    bool isNull() const
+    {
+        return type_ == Type::null;
+    }
+    bool isNumber() const
+    {
+        return type_ == Type::number;
+    }
+    bool isObject() const
+    {
+        return type_ == Type::object;
+    }
+
+    bool               getBool(bool fallback = false) const;
+    double             getNumber(double fallback = 0.0) const;
+    // a number that is a whole value from 0 up, fallback otherwise
+    uint64_t           getIndex(uint64_t fallback = ~0ull) const;
+    const std::string& getString() const
+    {
+        return string_;
+    }
+
+    // the elements of an array or the member values of an object
+    size_t getSize() const
+    {
+        return items_.size();
+    }
+    const JsonValue& getItem(size_t index) const;
+    const JsonValue& operator[](const char* key) const;
+    // the key of member index of an object
+    const std::string& getKey(size_t index) const
+    {
+        return keys_[index];
+    }
+
+    // false with a message naming the offset where the text stops being JSON
+    static bool parse(const char* text, size_t size, JsonValue& value, std::string& error);
+
+private:
+    friend class JsonParser;
+
+    Type                     type_ {Type::null};
+    bool                     boolean_ {false};
+    double                   number_ {0.0};
+    std::string              string_;
+    std::vector<std::string> keys_; // objects only, one per item
+    std::vector<JsonValue>   items_;
+};
@@ -22,6 +22,19 @@ public:
     float constant {0.f};
     float linear {0.f};
     float quadratic {0.f};
+
+    // distance at which the attenuated brightest channel falls under 5/256, lighting passes ignore
+    // the light beyond it
+    float getRadius() const
+    {
+        const float max_channel = glm::max(glm::max(diffuse.r, diffuse.g), diffuse.b);
+        if (quadratic <= 0.f)
+            return linear > 0.f ? (51.2f * max_channel - constant) / linear : 1e4f;
+
+        return (-linear +
+                glm::sqrt(linear * linear - 4.f * quadratic * (constant - 51.2f * max_channel))) /
+               (2.f * quadratic);
+    }
 };
 
 class SpotLight : public Light {
@@ -31,4 +44,21 @@ public:
     glm::vec3 direction;
 
     float cutoff {0.f};
-};
\ No newline at end of file
+};
+
+// std430 layout of a point light as read by the forward and deferred lighting shaders
+struct GpuPointLight
+{
+    glm::vec4 position_radius; // world position, radius of influence
+    glm::vec4 color;           // diffuse color, specular intensity
+    glm::vec4 attenuation;     // constant, linear, quadratic, unused
+
+    GpuPointLight()
+    {}
+    explicit GpuPointLight(const PointLight& light) :
+        position_radius(light.position, light.getRadius()),
+        color(light.diffuse,
+              glm::max(glm::max(light.specular.r, light.specular.g), light.specular.b)),
+        attenuation(light.constant, light.linear, light.quadratic, 0.f)
+    {}
+};
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <unordered_map>
+
+#include "lightmap_unwrap.h"
+
+// reserved at the atlas origin so uv (0, 0) stays white
+static constexpr uint32_t k_white_corner = 2;
+
+struct Chart
+{
+    uint32_t              mesh;
+    uint32_t              axis; // the projection drops this axis
+    std::vector<uint32_t> triangles;
+    glm::vec2             projected_min {1e30f};
+    glm::vec2             projected_max {-1e30f};
+
+    // placement in texels, including the padding
+    uint32_t x {0};
+    uint32_t y {0};
+};
+
+static glm::vec2 project(const glm::vec3& position, uint32_t axis)
+{
+    return glm::vec2(position[(axis + 1) % 3], position[(axis + 2) % 3]);
+}
+
+static uint32_t findRoot(std::vector<uint32_t>& parents, uint32_t element)
+{
+    while (parents[element] != element)
+    {
+        parents[element] = parents[parents[element]];
+        element          = parents[element];
+    }
+    return element;
+}
+
+// connected triangles with the same signed major axis, connectivity on welded positions so
+// vertices split for normals or uvs don't cut charts apart
+static void buildCharts(const TriangleMesh& mesh, uint32_t mesh_index, std::vector<Chart>& charts)
+{
+    const uint32_t triangle_count = static_cast<uint32_t>(mesh.indices.size() / 3);
+
+    std::map<std::array<float, 3>, uint32_t> welded_ids;
+    std::vector<uint32_t>                    welded(mesh.positions.size());
+    for (size_t vertex = 0; vertex < mesh.positions.size(); vertex++)
+    {
+        const glm::vec3& position = mesh.positions[vertex];
+        welded[vertex] =
+            welded_ids
+                .emplace(std::array<float, 3> {position.x, position.y, position.z},
+                         static_cast<uint32_t>(welded_ids.size()))
+                .first->second;
+    }
+
+    std::vector<uint32_t> axes(triangle_count);
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        const glm::vec3& v0     = mesh.positions[mesh.indices[triangle * 3 + 0]];
+        const glm::vec3& v1     = mesh.positions[mesh.indices[triangle * 3 + 1]];
+        const glm::vec3& v2     = mesh.positions[mesh.indices[triangle * 3 + 2]];
+        const glm::vec3  normal = glm::cross(v1 - v0, v2 - v0);
+        const glm::vec3  extent = glm::abs(normal);
+
+        const uint32_t axis =
+            extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        axes[triangle] = axis * 2 + (normal[axis] < 0.f ? 1 : 0);
+    }
+
+    // sorted (edge, triangle) pairs, triangles sharing an edge end up next to each other
+    std::vector<std::pair<uint64_t, uint32_t>> edges;
+    edges.reserve(mesh.indices.size());
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint64_t a = welded[mesh.indices[triangle * 3 + corner]];
+            const uint64_t b = welded[mesh.indices[triangle * 3 + (corner + 1) % 3]];
+            edges.emplace_back(std::min(a, b) << 32 | std::max(a, b), triangle);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<uint32_t> parents(triangle_count);
+    std::iota(parents.begin(), parents.end(), 0u);
+    for (size_t first = 0; first < edges.size();)
+    {
+        size_t last = first + 1;
+        while (last < edges.size() && edges[last].first == edges[first].first)
+        {
+            const uint32_t a = edges[first].second;
+            const uint32_t b = edges[last].second;
+            if (axes[a] == axes[b])
+            {
+                parents[findRoot(parents, a)] = findRoot(parents, b);
+            }
+            last++;
+        }
+        first = last;
+    }
+
+    std::unordered_map<uint32_t, uint32_t> chart_of_root;
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        const uint32_t root   = findRoot(parents, triangle);
+        auto           insert = chart_of_root.emplace(root, static_cast<uint32_t>(charts.size()));
+        if (insert.second)
+        {
+            Chart chart;
+            chart.mesh = mesh_index;
+            chart.axis = axes[triangle] / 2;
+            charts.push_back(chart);
+        }
+
+        Chart& chart = charts[insert.first->second];
+        chart.triangles.push_back(triangle);
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const glm::vec2 projected =
+                project(mesh.positions[mesh.indices[triangle * 3 + corner]], chart.axis);
+            chart.projected_min = glm::min(chart.projected_min, projected);
+            chart.projected_max = glm::max(chart.projected_max, projected);
+        }
+    }
+}
+
+static glm::uvec2 chartSize(const Chart& chart, float density, uint32_t padding)
+{
+    const glm::vec2 extent = (chart.projected_max - chart.projected_min) * density;
+    return glm::uvec2(glm::ceil(extent)) + glm::uvec2(1 + 2 * padding);
+}
+
+// shelves of decreasing height, charts sorted tallest first
+static bool packCharts(std::vector<Chart>&          charts,
+                       const std::vector<uint32_t>& order,
+                       float                        density,
+                       uint32_t                     size,
+                       uint32_t                     padding)
+{
+    uint32_t x            = k_white_corner;
+    uint32_t y            = 0;
+    uint32_t shelf_height = k_white_corner;
+    for (uint32_t chart_index : order)
+    {
+        Chart&           chart = charts[chart_index];
+        const glm::uvec2 area  = chartSize(chart, density, padding);
+        if (area.x > size)
+            return false;
+
+        if (x + area.x > size)
+        {
+            y += shelf_height;
+            x            = 0;
+            shelf_height = 0;
+        }
+        if (y + area.y > size)
+            return false;
+
+        chart.x = x;
+        chart.y = y;
+        x += area.x;
+        shelf_height = std::max(shelf_height, area.y);
+    }
+    return true;
+}
+
+float unwrapLightmap(const std::vector<TriangleMesh>& meshes,
+                     uint32_t                         size,
+                     uint32_t                         padding,
+                     std::vector<LightmapUnwrap>&     unwraps)
+{
+    std::vector<Chart>    charts;
+    std::vector<uint32_t> first_chart(meshes.size() + 1, 0);
+    for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        first_chart[mesh] = static_cast<uint32_t>(charts.size());
+        buildCharts(meshes[mesh], mesh, charts);
+    }
+    first_chart[meshes.size()] = static_cast<uint32_t>(charts.size());
+
+    std::vector<uint32_t> order(charts.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return charts[a].projected_max.y - charts[a].projected_min.y >
+               charts[b].projected_max.y - charts[b].projected_min.y;
+    });
+
+    // start from the density that fills most of the atlas and shrink until everything fits
+    float total_area = 0.f;
+    for (const auto& chart : charts)
+    {
+        const glm::vec2 extent = chart.projected_max - chart.projected_min;
+        total_area += extent.x * extent.y;
+    }
+    float density = std::sqrt(0.75f * size * size / std::max(total_area, 1e-6f));
+    bool  packed  = false;
+    for (uint32_t attempt = 0; attempt < 100 && !packed; attempt++)
+    {
+        packed = packCharts(charts, order, density, size, padding);
+        if (!packed)
+        {
+            density *= 0.95f;
+        }
+    }
+    if (!packed)
+    {
+        std::cout << "ERROR::LIGHTMAP:: " << charts.size() << " charts don't fit in a " << size
+                  << "x" << size << " atlas" << std::endl;
+        return 0.f;
+    }
+
+    unwraps.assign(meshes.size(), LightmapUnwrap());
+    for (uint32_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        const TriangleMesh& source = meshes[mesh];
+        LightmapUnwrap&     unwrap = unwraps[mesh];
+
+        std::vector<uint32_t> chart_of(source.indices.size() / 3);
+        for (uint32_t chart = first_chart[mesh]; chart < first_chart[mesh + 1]; chart++)
+        {
+            for (uint32_t triangle : charts[chart].triangles)
+            {
+                chart_of[triangle] = chart;
+            }
+        }
+
+        // one vertex per (chart, source vertex)
+        std::unordered_map<uint64_t, uint32_t> vertex_of;
+        unwrap.indices.reserve(source.indices.size());
+        for (size_t index = 0; index < source.indices.size(); index++)
+        {
+            const uint32_t source_vertex = source.indices[index];
+            const Chart&   chart         = charts[chart_of[index / 3]];
+            const uint64_t key = static_cast<uint64_t>(chart_of[index / 3]) << 32 | source_vertex;
+
+            auto insert = vertex_of.emplace(key, static_cast<uint32_t>(unwrap.sources.size()));
+            if (insert.second)
+            {
+                const glm::vec2 texel =
+                    glm::vec2(chart.x + padding, chart.y + padding) +
+                    (project(source.positions[source_vertex], chart.axis) - chart.projected_min) *
+                        density;
+                unwrap.sources.push_back(source_vertex);
+                unwrap.texcoords.push_back(texel / static_cast<float>(size));
+            }
+            unwrap.indices.push_back(insert.first->second);
+        }
+    }
+
+    return density;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// GL-free geometry of one imported mesh, for the offline tools
+struct TriangleMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<uint32_t>  indices;
+};
+
+// Lightmap uvs of a mesh. Vertices on chart seams are duplicated, the index buffer keeps the
+// triangle order of the source
+struct LightmapUnwrap
+{
+    std::vector<uint32_t>  sources;   // source vertex of each vertex
+    std::vector<glm::vec2> texcoords; // atlas uv
+    std::vector<uint32_t>  indices;
+};
+
+// Splits every mesh into charts of connected triangles facing the same major axis, projects
+// them onto that axis plane and shelf-packs all of them into one size x size atlas at the
+// highest uniform texel density that fits. Charts keep padding free texels around them for the
+// dilation of the baked texels. Texel (0, 0) is kept free so uv (0, 0) can sample white.
+// Returns the texel density in texels per world unit
+float unwrapLightmap(const std::vector<TriangleMesh>& meshes,
+                     uint32_t                         size,
+                     uint32_t                         padding,
+                     std::vector<LightmapUnwrap>&     unwraps);
@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "lz4_block.h"
+
+static constexpr size_t   k_min_match     = 4;
+static constexpr size_t   k_last_literals = 5;  // a block always ends in this many literals
+static constexpr size_t   k_match_limit   = 12; // and its last match starts before this many
+static constexpr size_t   k_max_offset    = 65535;
+static constexpr uint32_t k_hash_bits     = 14;
+
+static uint32_t read32(const uint8_t* data)
+{
+    uint32_t value;
+    memcpy(&value, data, 4);
+    return value;
+}
+
+static uint32_t hash32(uint32_t value)
+{
+    return (value * 2654435761u) >> (32 - k_hash_bits);
+}
+
+// a length past the 15 its token nibble holds continues in bytes of 255 and a last smaller one
+static uint8_t* writeLength(uint8_t* out, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *out++ = 255;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+static uint8_t* writeSequence(uint8_t*       out,
+                              const uint8_t* literals,
+                              size_t         literal_length,
+                              size_t         offset,
+                              size_t         match_length)
+{
+    uint8_t* token = out++;
+    *token         = static_cast<uint8_t>(std::min<size_t>(literal_length, 15) << 4);
+    if (literal_length >= 15)
+        out = writeLength(out, literal_length - 15);
+    if (literal_length > 0)
+        memcpy(out, literals, literal_length);
+    out += literal_length;
+
+    // the last sequence is its literals alone
+    if (match_length == 0)
+        return out;
+
+    *out++ = static_cast<uint8_t>(offset);
+    *out++ = static_cast<uint8_t>(offset >> 8);
+    match_length -= k_min_match;
+    *token |= static_cast<uint8_t>(std::min<size_t>(match_length, 15));
+    if (match_length >= 15)
+        out = writeLength(out, match_length - 15);
+    return out;
+}
+
+size_t getLz4Bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t compressLz4Block(const uint8_t* source, size_t size, uint8_t* destination)
+{
+    uint8_t*       out    = destination;
+    const uint8_t* anchor = source;
+    if (size > k_match_limit)
+    {
+        // positions of the last 4 bytes seen with every hash, a stale one fails the compare
+        std::vector<uint32_t> table(size_t(1) << k_hash_bits, 0);
+        const uint8_t*        match_limit = source + size - k_match_limit;
+        const uint8_t*        end_limit   = source + size - k_last_literals;
+        const uint8_t*        current     = source;
+        while (current < match_limit)
+        {
+            const uint32_t hash      = hash32(read32(current));
+            const uint8_t* candidate = source + table[hash];
+            table[hash]              = static_cast<uint32_t>(current - source);
+
+            const size_t offset = static_cast<size_t>(current - candidate);
+            if (offset == 0 || offset > k_max_offset || read32(candidate) != read32(current))
+            {
+                // data that keeps missing is skipped faster, the way LZ4 does
+                current += 1 + ((current - anchor) >> 6);
+                continue;
+            }
+
+            while (current > anchor && candidate > source && current[-1] == candidate[-1])
+            {
+                current--;
+                candidate--;
+            }
+            const uint8_t* match_end = current + k_min_match;
+            while (match_end < end_limit && *match_end == candidate[match_end - current])
+            {
+                match_end++;
+            }
+
+            out = writeSequence(
+                out, anchor, current - anchor, offset, static_cast<size_t>(match_end - current));
+            anchor = current = match_end;
+        }
+    }
+    out = writeSequence(out, anchor, source + size - anchor, 0, 0);
+    return static_cast<size_t>(out - destination);
+}
+
+static bool readLength(const uint8_t*& in, const uint8_t* end, size_t& length)
+{
+    uint8_t byte;
+    do
+    {
+        if (in == end)
+            return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompressLz4Block(const uint8_t* source,
+                        size_t         size,
+                        uint8_t*       destination,
+                        size_t         decompressed_size)
+{
+    const uint8_t* in      = source;
+    const uint8_t* in_end  = source + size;
+    uint8_t*       out     = destination;
+    uint8_t*       out_end = destination + decompressed_size;
+    while (in < in_end)
+    {
+        const uint8_t token          = *in++;
+        size_t        literal_length = token >> 4;
+        if (literal_length == 15 && !readLength(in, in_end, literal_length))
+            return false;
+        if (literal_length > static_cast<size_t>(in_end - in) ||
+            literal_length > static_cast<size_t>(out_end - out))
+            return false;
+        // short runs are copied 16 bytes at a time where both sides have the room, which is
+        // most of the block
+        if (literal_length <= 16 && in_end - in >= 16 && out_end - out >= 16)
+            memcpy(out, in, 16);
+        else if (literal_length > 0)
+            memcpy(out, in, literal_length);
+        in += literal_length;
+        out += literal_length;
+
+        if (in == in_end)
+            return out == out_end;
+
+        if (in_end - in < 2)
+            return false;
+        const size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15 && !readLength(in, in_end, match_length))
+            return false;
+        match_length += k_min_match;
+        if (offset == 0 || offset > static_cast<size_t>(out - destination) ||
+            match_length > static_cast<size_t>(out_end - out))
+            return false;
+
+        // a match closer than its length repeats the bytes it is writing. One at least 8 back is
+        // copied 8 bytes at a time, a closer one in runs that are a whole number of repeats,
+        // copied again in one go and doubling every time
+        const uint8_t* match = out - offset;
+        if (offset >= 8 && static_cast<size_t>(out_end - out) >= match_length + 8)
+        {
+            for (size_t byte = 0; byte < match_length; byte += 8)
+            {
+                memcpy(out + byte, match + byte, 8);
+            }
+            out += match_length;
+            continue;
+        }
+        while (match_length > 0)
+        {
+            const size_t length = std::min(match_length, static_cast<size_t>(out - match));
+            memcpy(out, match, length);
+            out += length;
+            match_length -= length;
+        }
+    }
+    return false;
+}
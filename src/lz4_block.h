@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// The LZ4 block format, a block of sequences each made of a token, literals copied as they are and
+// a match copied from up to 64KB back. Blocks written here read with any LZ4 decoder and the other
+// way round, there is no frame around them.
+
+// the most a block of size bytes can take compressed, data that doesn't compress grows a little
+size_t getLz4Bound(size_t size);
+
+// compresses source into destination, which has room for getLz4Bound(size) bytes. Returns the
+// compressed size. Matches are found greedily through a hash of the next 4 bytes, which keeps it
+// fast rather than small
+size_t compressLz4Block(const uint8_t* source, size_t size, uint8_t* destination);
+
+// decompresses a block of size bytes that decodes to exactly decompressed_size bytes. Returns false
+// for any block that doesn't, without reading or writing out of bounds
+bool decompressLz4Block(const uint8_t* source,
+                        size_t         size,
+                        uint8_t*       destination,
+                        size_t         decompressed_size);
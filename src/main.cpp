@@ -5,13 +5,39 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "ambient_occlusion.h"
+#include "animation_system.h"
+#include "asset_file.h"
+#include "benchmark.h"
 #include "camera.h"
+#include "deferred_renderer.h"
+#include "dynamic_resolution.h"
+#include "gpu_timer.h"
+#include "image_compare.h"
+#include "instance_manager.h"
+#include "job_system.h"
 #include "light.h"
 #include "model.h"
+#include "particle_system.h"
+#include "point_shadow_atlas.h"
+#include "post_aa.h"
+#include "post_process.h"
+#include "render_graph.h"
+#include "ring_buffer.h"
 #include "shader.h"
+#include "shadow_map.h"
+#include "temporal_aa.h"
+#include "vertex_animation.h"
+#include "visibility_renderer.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image/stb_image.h>
@@ -20,6 +46,8 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
 void processInput(GLFWwindow* window);
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
 uint32_t createTexture(const char* texture_file);
 
 uint32_t loadCubemap(std::vector<std::string> faces);
@@ -30,8 +58,725 @@ const int k_height = 900;
 float delta_time      = 0.f;
 float last_frame_time = 0.f;
 
-Camera camera(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, 0.f));
-Light  light;
+Camera           camera(glm::vec3(0.f, 0.f, 3.f), glm::vec3(0.f, 0.f, 0.f));
+Light            light;
+DirectionalLight sun;
+
+enum class RenderPath
+{
+    forward,
+    deferred,
+    visibility
+};
+
+const int k_render_path_count = 3;
+
+const char* k_render_path_names[k_render_path_count] = {"forward", "deferred", "visibility"};
+
+RenderPath render_path = RenderPath::forward;
+
+// MSAA and TAA only apply to the forward path, the post-process modes to every path. The other
+// paths have no velocity buffer and present TAA with FXAA instead, see getPathAntiAliasing()
+enum class AntiAliasing
+{
+    none,
+    msaa,
+    fxaa,
+    smaa,
+    taa
+};
+
+const int k_anti_aliasing_count = 5;
+
+const char* k_anti_aliasing_names[k_anti_aliasing_count] = {"none", "msaa", "fxaa", "smaa", "taa"};
+
+AntiAliasing anti_aliasing = AntiAliasing::msaa;
+
+// screen-space ambient occlusion, off or one of the AmbientOcclusion quality presets
+enum class OcclusionMode
+{
+    off,
+    low,
+    medium,
+    high
+};
+
+const int k_occlusion_mode_count = 4;
+
+const char* k_occlusion_mode_names[k_occlusion_mode_count] = {"off", "low", "medium", "high"};
+
+OcclusionMode occlusion_mode = OcclusionMode::medium;
+
+bool dynamic_resolution_enabled = false;
+
+// sponza's meshes drawn at the level of detail their distance allows, see Model::selectLods
+bool lods_enabled = true;
+
+// where the visibility path culls its meshlets
+const int k_cluster_culling_count = 3;
+
+const char* k_cluster_culling_names[k_cluster_culling_count] = {"off", "cpu", "gpu"};
+
+VisibilityRenderer::ClusterCulling cluster_culling = VisibilityRenderer::ClusterCulling::gpu;
+
+// what reads the OBJ and glTF models, Assimp or the native loaders
+const int k_model_loader_count = 2;
+
+const char* k_model_loader_names[k_model_loader_count] = {"assimp", "native"};
+
+ModelLoader model_loader = ModelLoader::assimp;
+
+// how the models read their textures: mapped on the jobs, queued to io_uring, or on io_uring with
+// O_DIRECT, which only pays off on loads cold from the disk, see io_benchmark
+const int k_texture_read_count = 3;
+
+const char* k_texture_read_names[k_texture_read_count] = {"jobs", "io_uring", "direct"};
+
+AsyncReadSettings texture_reads;
+
+// the directory the paths below start from, the one pack_assets packs from by default
+const char* k_asset_root = "../../..";
+
+CascadedShadowMap* shadow_map   = nullptr;
+RenderGraph*       render_graph = nullptr;
+
+// the anti-aliasing the render path presents with
+AntiAliasing getPathAntiAliasing(RenderPath path, AntiAliasing mode)
+{
+    if (mode == AntiAliasing::taa && path != RenderPath::forward)
+        return AntiAliasing::fxaa;
+    return mode;
+}
+
+// tells when the render path can't present the anti-aliasing asked for
+void reportPathAntiAliasing()
+{
+    const AntiAliasing path_anti_aliasing = getPathAntiAliasing(render_path, anti_aliasing);
+    if (path_anti_aliasing != anti_aliasing)
+    {
+        std::cout << "Info: " << k_anti_aliasing_names[static_cast<int>(anti_aliasing)]
+                  << " only applies to the forward path, the "
+                  << k_render_path_names[static_cast<int>(render_path)] << " path presents with "
+                  << k_anti_aliasing_names[static_cast<int>(path_anti_aliasing)] << " instead"
+                  << std::endl;
+    }
+}
+
+// a grid of colored point lights hovering over the floor
+std::vector<PointLight> createPointLights(int grid_size)
+{
+    std::vector<PointLight> lights;
+    for (int z = 0; z < grid_size; z++)
+    {
+        for (int x = 0; x < grid_size; x++)
+        {
+            const uint32_t hash = static_cast<uint32_t>(x * 73856093 ^ z * 19349663);
+
+            PointLight point_light;
+            point_light.position = glm::vec3(-9.f + 18.f * x / (grid_size - 1),
+                                             0.5f + 0.25f * static_cast<float>(hash % 5),
+                                             -9.f + 18.f * z / (grid_size - 1));
+            point_light.diffuse  = glm::vec3(0.2f + 0.8f * static_cast<float>(hash % 7) / 6.f,
+                                            0.2f + 0.8f * static_cast<float>(hash % 11) / 10.f,
+                                            0.2f + 0.8f * static_cast<float>(hash % 13) / 12.f);
+            point_light.specular  = glm::vec3(1.f);
+            point_light.ambient   = glm::vec3(0.f);
+            point_light.constant  = 1.f;
+            point_light.linear    = 0.7f;
+            point_light.quadratic = 1.8f;
+            lights.push_back(point_light);
+        }
+    }
+    return lights;
+}
+
+// scale of a character model to a common height, and the height that stands it on the floor
+float getCharacterScale(const Model& model, float& floor_height)
+{
+    glm::vec3 bounds_min(1e30f);
+    glm::vec3 bounds_max(-1e30f);
+    for (const auto* mesh : model.getMeshes())
+    {
+        bounds_min = glm::min(bounds_min, mesh->bounds_min);
+        bounds_max = glm::max(bounds_max, mesh->bounds_max);
+    }
+    const float scale = 0.35f / std::max(bounds_max.y - bounds_min.y, 1e-3f);
+    floor_height      = -0.5f - bounds_min.y * scale;
+    return scale;
+}
+
+// a grid of characters standing on the floor, scaled to a common height. Each one blends two of
+// the model's clips at its own phase and speed
+std::vector<glm::mat4> createCrowd(const Model& model, uint32_t count, AnimationSystem& crowd)
+{
+    float       floor_height;
+    const float scale   = getCharacterScale(model, floor_height);
+    const float spacing = 0.5f;
+
+    const uint32_t clip_count = static_cast<uint32_t>(model.getClips().size());
+    const uint32_t columns    = static_cast<uint32_t>(std::ceil(std::sqrt(2.f * count)));
+    const uint32_t rows       = (count + columns - 1) / columns;
+
+    std::vector<glm::mat4> transforms;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const uint32_t  hash = index * 2654435761u;
+        const glm::vec3 position(spacing * (index % columns - 0.5f * (columns - 1)),
+                                 floor_height,
+                                 spacing * (index / columns - 0.5f * (rows - 1)));
+
+        const float yaw       = glm::radians(static_cast<float>(hash % 360));
+        glm::mat4   transform = glm::translate(glm::mat4(1.f), position);
+        transform             = glm::rotate(transform, yaw, glm::vec3(0.f, 1.f, 0.f));
+        transforms.push_back(glm::scale(transform, glm::vec3(scale)));
+
+        AnimationSystem::Character character;
+        character.clips[0] = index % clip_count;
+        character.clips[1] = (index / clip_count) % clip_count;
+        character.times[0] = static_cast<float>(hash % 1000) / 1000.f;
+        character.times[1] = character.times[0];
+        character.blend    = static_cast<float>((hash >> 10) % 100) / 100.f;
+        character.speed    = 0.8f + 0.4f * static_cast<float>((hash >> 20) % 100) / 100.f;
+        crowd.addCharacter(character);
+    }
+    return transforms;
+}
+
+// orbit of a swarm instance around the vertical axis through the middle of the scene
+struct SwarmOrbit
+{
+    float radius;
+    float height;
+    float phase;
+    float speed; // radians per second
+};
+
+void placeSwarmInstance(InstanceManager&  swarm,
+                        const SwarmOrbit& orbit,
+                        uint32_t          index,
+                        float             time)
+{
+    const float angle = orbit.phase + orbit.speed * time;
+    swarm.getPositions()[index] =
+        glm::vec3(orbit.radius * std::cos(angle), orbit.height, orbit.radius * std::sin(angle));
+    swarm.getRotations()[index] = glm::angleAxis(-angle, glm::vec3(0.f, 1.f, 0.f));
+}
+
+// a swarm of small tinted boxes circling over the floor, each at its own radius, height and speed
+std::vector<SwarmOrbit> createSwarm(uint32_t count, InstanceManager& swarm)
+{
+    std::vector<SwarmOrbit> orbits;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const uint32_t hash = index * 2654435761u;
+
+        SwarmOrbit orbit;
+        orbit.radius = 1.f + 8.f * std::sqrt(static_cast<float>(hash % 1000) / 1000.f);
+        orbit.height = -0.3f + 4.f * static_cast<float>((hash >> 10) % 1000) / 1000.f;
+        orbit.phase  = glm::radians(static_cast<float>(hash % 360));
+        orbit.speed  = 0.1f + 0.4f * static_cast<float>((hash >> 20) % 100) / 100.f;
+        orbits.push_back(orbit);
+
+        const glm::vec4 tint(0.4f + 0.6f * static_cast<float>(hash % 7) / 6.f,
+                             0.4f + 0.6f * static_cast<float>(hash % 11) / 10.f,
+                             0.4f + 0.6f * static_cast<float>(hash % 13) / 12.f,
+                             1.f);
+        swarm.add(glm::vec3(0.f), glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3(0.05f), tint);
+        placeSwarmInstance(swarm, orbit, index, 0.f);
+    }
+    return orbits;
+}
+
+// a square grid of characters playing the baked clips at their own time offset and speed, around
+// and past the grid of skinned ones
+void createBackgroundCrowd(const Model&           model,
+                           const VertexAnimation& baked,
+                           uint32_t               count,
+                           InstanceManager&       crowd)
+{
+    float       floor_height;
+    const float scale   = getCharacterScale(model, floor_height);
+    const float spacing = 0.4f;
+
+    const uint32_t clip_count = static_cast<uint32_t>(baked.clips.size());
+    const uint32_t columns    = static_cast<uint32_t>(std::ceil(std::sqrt(count)));
+
+    const glm::vec3 bounds_center = baked.bounds_min + 0.5f * baked.bounds_extent;
+    crowd.setBounds(bounds_center, 0.5f * glm::length(baked.bounds_extent));
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const uint32_t  hash = index * 2654435761u;
+        const uint32_t  clip = hash % clip_count;
+        const glm::vec3 position(spacing * (index % columns - 0.5f * (columns - 1)),
+                                 floor_height,
+                                 spacing * (index / columns - 0.5f * (columns - 1)));
+        const float     yaw = glm::radians(static_cast<float>((hash >> 8) % 360));
+
+        crowd.add(position,
+                  glm::angleAxis(yaw, glm::vec3(0.f, 1.f, 0.f)),
+                  glm::vec3(scale),
+                  glm::vec4(static_cast<float>(clip),
+                            baked.clips[clip].duration * static_cast<float>(hash % 1000) / 1000.f,
+                            0.8f + 0.4f * static_cast<float>((hash >> 20) % 100) / 100.f,
+                            0.f));
+    }
+}
+
+// Instances of one mesh streamed to the scene vertex shaders, see InstanceManager. The instance
+// copies are the regions of one ring, the current and previous ones bound for the motion vectors,
+// and the visible instances are written to a ring of indices one instanced draw covers
+struct InstanceStream
+{
+    InstanceManager manager;
+    RingBuffer      instance_ring;
+    RingBuffer      visible_ring;
+    uint32_t        visible_count {0};
+
+    explicit InstanceStream(uint32_t capacity) :
+        manager(RingBuffer::k_region_count),
+        instance_ring(capacity * sizeof(GpuInstance)),
+        visible_ring(capacity * sizeof(uint32_t))
+    {
+    }
+
+    // writes what changed since this frame's instance copy was last written
+    void flush(JobSystem& jobs)
+    {
+        auto* instances = static_cast<GpuInstance*>(instance_ring.beginFrame());
+        manager.flush(instance_ring.getRegion(), instances, jobs);
+    }
+
+    void cull(const glm::mat4& view_projection, JobSystem& jobs)
+    {
+        auto* visible = static_cast<uint32_t*>(visible_ring.beginFrame());
+        visible_count = manager.cull(view_projection, jobs, visible);
+    }
+
+    void bind() const
+    {
+        instance_ring.bind(16, 17);
+        visible_ring.bind(18);
+    }
+
+    void endFrame()
+    {
+        instance_ring.endFrame();
+        visible_ring.endFrame();
+    }
+
+    float getWaitMs() const
+    {
+        return instance_ring.getWaitMs() + visible_ring.getWaitMs();
+    }
+
+    size_t getMemoryUsage() const
+    {
+        return RingBuffer::k_region_count *
+               (instance_ring.getRegionSize() + visible_ring.getRegionSize());
+    }
+};
+
+// unit cube with per-face normals and texture coordinates
+Mesh createBoxMesh(uint32_t texture)
+{
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
+    for (int face = 0; face < 6; face++)
+    {
+        const int       axis = face / 2;
+        const float     sign = face % 2 == 0 ? 1.f : -1.f;
+        glm::vec3       normal(0.f);
+        normal[axis] = sign;
+        const glm::vec3 u = glm::vec3(normal.y, normal.z, normal.x);
+        const glm::vec3 v = glm::cross(normal, u);
+
+        const uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (int corner = 0; corner < 4; corner++)
+        {
+            const float su = corner == 1 || corner == 2 ? 1.f : -1.f;
+            const float sv = corner >= 2 ? 1.f : -1.f;
+
+            Vertex vertex    = {};
+            vertex.position  = 0.5f * (normal + su * u + sv * v);
+            vertex.normal    = normal;
+            vertex.texcoords = glm::vec2(su, sv) * 0.5f + 0.5f;
+            vertices.push_back(vertex);
+        }
+        const uint32_t quad[] = {0, 1, 2, 0, 2, 3};
+        for (uint32_t index : quad)
+        {
+            indices.push_back(base + index);
+        }
+    }
+
+    return Mesh(vertices, indices, {Texture {texture, TextureType::_diffuse, "box"}});
+}
+
+// What the passes of a frame draw with, created before the loop and alive for all of it
+struct FrameRenderers
+{
+    Shader&                      forward_shader;
+    Shader&                      depth_prepass_shader; // when the ambient occlusion needs it
+    Shader&                      upscale_shader;
+    DeferredRenderer&            deferred_renderer;
+    VisibilityRenderer&          visibility_renderer;
+    TemporalAntiAliasing&        temporal_aa;
+    PostAntiAliasing&            post_aa;
+    PostProcessing&              post_process;
+    AmbientOcclusion&            ambient_occlusion;
+    GpuTimer&                    scene_timer;
+    std::function<void(Shader&)> draw_scene; // every object, with the camera uniforms set
+    ParticleSystem*              particles;  // drawn by the forward path, null without them
+    float                        particle_size;
+    uint32_t                     quad_vao;
+    uint32_t                     light_count;
+    glm::vec3                    clear_color;
+};
+
+// What a frame is declared from, set again every frame
+struct FrameState
+{
+    RenderPath   render_path {RenderPath::forward};
+    AntiAliasing anti_aliasing {AntiAliasing::msaa};
+    bool         taa_active {false};
+    bool         occlusion_enabled {false};
+    glm::mat4    view {1.f};
+    glm::mat4    projection {1.f};      // with the jitter
+    glm::mat4    view_projection {1.f}; // without it, for the velocity buffer with the last one
+    glm::mat4    previous_view_projection {1.f};
+    glm::vec3    camera_pos {0.f};
+    // size the renderers that own their targets were created for
+    uint32_t target_width {0};
+    uint32_t target_height {0};
+    float    exposure_delta_time {0.f};
+    // the presented image is read back into it, when not null
+    std::vector<uint8_t>* captured_image {nullptr};
+};
+
+// Declares the passes of a frame on frame_graph, replacing the last frame's. Every render path is
+// declared and the graph culls the ones the presented image doesn't come from. The passes keep
+// references to renderers and state, so both have to outlive frame_graph.execute()
+void declareFrame(RenderGraph&          frame_graph,
+                  const FrameRenderers& renderers,
+                  const FrameState&     state)
+{
+    frame_graph.reset();
+
+    const RenderGraph::Resource scene_msaa =
+        frame_graph.createTexture("scene_msaa", {GL_RGBA16F, 4, 1.f, true});
+    const RenderGraph::Resource scene_depth =
+        frame_graph.createTexture("scene_depth", {GL_DEPTH24_STENCIL8, 4, 1.f, true});
+    // single-sampled targets of the other anti-aliasing modes
+    const RenderGraph::Resource scene_single =
+        frame_graph.createTexture("scene_single", {GL_RGBA16F, 1, 1.f, true});
+    const RenderGraph::Resource scene_velocity =
+        frame_graph.createTexture("scene_velocity", {GL_RG16F, 1, 1.f, true});
+    const RenderGraph::Resource scene_single_depth =
+        frame_graph.createTexture("scene_single_depth", {GL_DEPTH24_STENCIL8, 1, 1.f, true});
+    const RenderGraph::Resource taa_output =
+        frame_graph.importTexture("taa_output",
+                                  renderers.temporal_aa.getOutputTexture(),
+                                  GL_RGBA16F,
+                                  state.target_width,
+                                  state.target_height);
+    const RenderGraph::Resource deferred_output =
+        frame_graph.importTexture("deferred_output",
+                                  renderers.deferred_renderer.getOutputTexture(),
+                                  GL_RGBA16F,
+                                  state.target_width,
+                                  state.target_height,
+                                  true);
+    const RenderGraph::Resource visibility_output =
+        frame_graph.importTexture("visibility_output",
+                                  renderers.visibility_renderer.getOutputTexture(),
+                                  GL_RGBA16F,
+                                  state.target_width,
+                                  state.target_height,
+                                  true);
+
+    const RenderGraph::Resource deferred_depth =
+        frame_graph.importTexture("deferred_depth",
+                                  renderers.deferred_renderer.getDepthTexture(),
+                                  GL_DEPTH_COMPONENT32F,
+                                  state.target_width,
+                                  state.target_height,
+                                  true);
+    const RenderGraph::Resource visibility_depth =
+        frame_graph.importTexture("visibility_depth",
+                                  renderers.visibility_renderer.getDepthTexture(),
+                                  GL_DEPTH_COMPONENT32F,
+                                  state.target_width,
+                                  state.target_height,
+                                  true);
+    const RenderGraph::Resource occlusion_output =
+        frame_graph.importTexture("occlusion_output",
+                                  renderers.ambient_occlusion.getOutputTexture(),
+                                  GL_R8,
+                                  state.target_width,
+                                  state.target_height,
+                                  true);
+
+    // each path lays down its depth before shading so the ambient occlusion can run in between,
+    // the forward path with a depth prepass when the occlusion is on
+    const RenderGraph::Resource forward_depth =
+        state.anti_aliasing == AntiAliasing::msaa ? scene_depth : scene_single_depth;
+    if (state.occlusion_enabled)
+    {
+        frame_graph
+            .addPass("depth_prepass",
+                     [&renderers, &state](const RenderGraph&) {
+                         renderers.scene_timer.begin();
+                         glClear(GL_DEPTH_BUFFER_BIT);
+                         glEnable(GL_DEPTH_TEST);
+
+                         Shader& shader = renderers.depth_prepass_shader;
+                         shader.use();
+                         shader.setMat4fv("projection", glm::value_ptr(state.projection));
+                         shader.setMat4fv("view", glm::value_ptr(state.view));
+                         renderers.draw_scene(shader);
+                     })
+            .write(forward_depth);
+    }
+
+    // the g-buffer and visibility targets are owned by their renderers, their depth stands
+    // for all of them in the graph
+    frame_graph
+        .addPass("gbuffer",
+                 [&renderers, &state](const RenderGraph&) {
+                     renderers.scene_timer.begin();
+                     Shader& gbuffer_shader = renderers.deferred_renderer.beginGeometryPass(
+                         state.view, state.projection);
+                     renderers.draw_scene(gbuffer_shader);
+                 })
+        .writeStorage(deferred_depth);
+
+    frame_graph
+        .addPass("visibility_raster",
+                 [&renderers, &state](const RenderGraph&) {
+                     renderers.scene_timer.begin();
+                     renderers.visibility_renderer.rasterize(state.view, state.projection);
+                 })
+        .writeStorage(visibility_depth);
+
+    const RenderGraph::Resource path_depths[k_render_path_count] = {
+        forward_depth, deferred_depth, visibility_depth};
+    const RenderGraph::Resource occlusion_depth =
+        path_depths[static_cast<int>(state.render_path)];
+    if (state.occlusion_enabled)
+    {
+        frame_graph
+            .addPass("ambient_occlusion",
+                     [&renderers, &state, occlusion_depth](const RenderGraph& graph) {
+                         renderers.ambient_occlusion.render(graph.getTexture(occlusion_depth),
+                                                            graph.getWidth(occlusion_depth),
+                                                            graph.getHeight(occlusion_depth),
+                                                            state.view,
+                                                            state.projection);
+                     })
+            .read(occlusion_depth)
+            .writeStorage(occlusion_output);
+    }
+
+    RenderGraph::Pass& forward_pass = frame_graph.addPass(
+        "forward", [&renderers, &state](const RenderGraph&) {
+            // the prepass already started the timer and laid down the depth
+            if (!state.occlusion_enabled)
+                renderers.scene_timer.begin();
+            const glm::vec3& clear_color = renderers.clear_color;
+            glClearColor(clear_color.x, clear_color.y, clear_color.z, 1.0f);
+            glClear(state.occlusion_enabled ? GL_COLOR_BUFFER_BIT :
+                                              GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            if (state.taa_active)
+            {
+                const float no_motion[4] = {0.f, 0.f, 0.f, 0.f};
+                glClearBufferfv(GL_COLOR, 1, no_motion);
+            }
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(state.occlusion_enabled ? GL_LEQUAL : GL_LESS);
+
+            renderers.ambient_occlusion.bind(9, state.occlusion_enabled);
+            Shader&          shader     = renderers.forward_shader;
+            const glm::vec3& camera_pos = state.camera_pos;
+            shader.use();
+            shader.setMat4fv("projection", glm::value_ptr(state.projection));
+            shader.setMat4fv("view", glm::value_ptr(state.view));
+            shader.setMat4fv("currentViewProjection", glm::value_ptr(state.view_projection));
+            shader.setMat4fv("previousViewProjection",
+                             glm::value_ptr(state.previous_view_projection));
+            shader.setVec3f("viewPos", camera_pos.x, camera_pos.y, camera_pos.z);
+            shader.setUint("lightCount", renderers.light_count);
+            renderers.draw_scene(shader);
+            if (renderers.particles)
+                renderers.particles->draw(state.view, state.projection, renderers.particle_size);
+            glDepthFunc(GL_LESS);
+            renderers.scene_timer.end();
+        });
+    if (state.occlusion_enabled)
+        forward_pass.read(occlusion_output);
+    if (state.anti_aliasing == AntiAliasing::msaa)
+        forward_pass.write(scene_msaa).write(scene_depth);
+    else if (state.taa_active)
+        forward_pass.write(scene_single).write(scene_velocity).write(scene_single_depth);
+    else
+        forward_pass.write(scene_single).write(scene_single_depth);
+
+    frame_graph
+        .addPass("taa",
+                 [&renderers, scene_single, scene_velocity, scene_single_depth](
+                     const RenderGraph& graph) {
+                     renderers.temporal_aa.resolve(graph.getTexture(scene_single),
+                                                   graph.getTexture(scene_velocity),
+                                                   graph.getTexture(scene_single_depth),
+                                                   graph.getWidth(scene_single),
+                                                   graph.getHeight(scene_single));
+                 })
+        .read(scene_single)
+        .read(scene_velocity)
+        .read(scene_single_depth)
+        .writeStorage(taa_output);
+
+    RenderGraph::Pass& deferred_pass = frame_graph.addPass(
+        "deferred_lighting", [&renderers, &state](const RenderGraph&) {
+            renderers.ambient_occlusion.bind(9, state.occlusion_enabled);
+            renderers.deferred_renderer.lightingPass(
+                state.view, state.projection, renderers.light_count, renderers.clear_color);
+            renderers.scene_timer.end();
+        });
+    deferred_pass.read(deferred_depth).writeStorage(deferred_output);
+    if (state.occlusion_enabled)
+        deferred_pass.read(occlusion_output);
+
+    RenderGraph::Pass& visibility_pass = frame_graph.addPass(
+        "visibility_shade", [&renderers, &state](const RenderGraph&) {
+            renderers.ambient_occlusion.bind(9, state.occlusion_enabled);
+            renderers.visibility_renderer.shade(
+                state.view, state.projection, renderers.light_count, renderers.clear_color);
+            renderers.scene_timer.end();
+        });
+    visibility_pass.read(visibility_depth).writeStorage(visibility_output);
+    if (state.occlusion_enabled)
+        visibility_pass.read(occlusion_output);
+
+    RenderGraph::Resource forward_output = scene_single;
+    if (state.anti_aliasing == AntiAliasing::msaa)
+        forward_output = scene_msaa;
+    else if (state.taa_active)
+        forward_output = taa_output;
+
+    const RenderGraph::Resource path_outputs[k_render_path_count] = {
+        forward_output, deferred_output, visibility_output};
+    const RenderGraph::Resource path_color = path_outputs[static_cast<int>(state.render_path)];
+
+    // HDR post-processing of the path output at its resolution, TAA outputs at full size
+    const bool                  path_dynamic = !state.taa_active;
+    const RenderGraph::Resource bloom_chain =
+        frame_graph.importTexture("bloom_chain",
+                                  renderers.post_process.getBloomTexture(),
+                                  GL_R11F_G11F_B10F,
+                                  state.target_width / 2,
+                                  state.target_height / 2,
+                                  path_dynamic);
+    frame_graph
+        .addPass("bloom",
+                 [&renderers, &state, path_color](const RenderGraph& graph) {
+                     renderers.post_process.bloom(graph.getTexture(path_color),
+                                                  graph.getWidth(path_color),
+                                                  graph.getHeight(path_color),
+                                                  graph.getStorageWidth(path_color),
+                                                  graph.getStorageHeight(path_color),
+                                                  state.exposure_delta_time);
+                 })
+        .read(path_color)
+        .writeStorage(bloom_chain);
+
+    // the SMAA edges are found on the exposure the bloom pass just computed
+    const RenderGraph::Resource smaa_edges =
+        frame_graph.createTexture("smaa_edges", {GL_RG8, 1, 1.f, path_dynamic});
+    const RenderGraph::Resource smaa_weights =
+        frame_graph.createTexture("smaa_weights", {GL_RGBA8, 1, 1.f, path_dynamic});
+    frame_graph
+        .addPass("smaa_edges",
+                 [&renderers, path_color](const RenderGraph& graph) {
+                     renderers.post_aa.smaaEdges(graph.getTexture(path_color),
+                                                 graph.getWidth(path_color),
+                                                 graph.getHeight(path_color),
+                                                 renderers.post_process.getExposureBuffer());
+                 })
+        .read(path_color)
+        .write(smaa_edges);
+    frame_graph
+        .addPass("smaa_weights",
+                 [&renderers, smaa_edges](const RenderGraph& graph) {
+                     renderers.post_aa.smaaWeights(graph.getTexture(smaa_edges),
+                                                   graph.getStorageWidth(smaa_edges),
+                                                   graph.getStorageHeight(smaa_edges));
+                 })
+        .read(smaa_edges)
+        .write(smaa_weights);
+
+    PostProcessing::Filter post_filter = PostProcessing::Filter::none;
+    if (state.anti_aliasing == AntiAliasing::fxaa)
+        post_filter = PostProcessing::Filter::fxaa;
+    else if (state.anti_aliasing == AntiAliasing::smaa)
+        post_filter = PostProcessing::Filter::smaa;
+
+    const RenderGraph::Resource scene_color =
+        frame_graph.createTexture("scene_color", {GL_RGBA8, 1, 1.f, path_dynamic});
+    RenderGraph::Pass& post_pass = frame_graph.addPass(
+        "post",
+        [&renderers, path_color, scene_color, smaa_weights, post_filter](const RenderGraph& graph) {
+            renderers.post_process.resolve(graph.getTexture(path_color),
+                                           graph.getTexture(scene_color),
+                                           graph.getWidth(path_color),
+                                           graph.getHeight(path_color),
+                                           graph.getStorageWidth(path_color),
+                                           graph.getStorageHeight(path_color),
+                                           post_filter,
+                                           post_filter == PostProcessing::Filter::smaa ?
+                                               graph.getTexture(smaa_weights) :
+                                               0);
+        });
+    post_pass.read(path_color).read(bloom_chain);
+    if (post_filter == PostProcessing::Filter::smaa)
+        post_pass.read(smaa_weights);
+    post_pass.writeStorage(scene_color);
+
+    if (state.captured_image)
+    {
+        frame_graph
+            .addPass("capture",
+                     [&state, scene_color](const RenderGraph& graph) {
+                         *state.captured_image = readTexture(graph.getTexture(scene_color),
+                                                             graph.getWidth(scene_color),
+                                                             graph.getHeight(scene_color));
+                     })
+            .read(scene_color)
+            .sideEffect();
+    }
+
+    frame_graph
+        .addPass("present",
+                 [&renderers, scene_color](const RenderGraph& graph) {
+                     glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+                     glClear(GL_COLOR_BUFFER_BIT);
+                     glDisable(GL_DEPTH_TEST);
+
+                     Shader& shader = renderers.upscale_shader;
+                     shader.use();
+                     shader.setVec2f("sourceSize",
+                                     static_cast<float>(graph.getStorageWidth(scene_color)),
+                                     static_cast<float>(graph.getStorageHeight(scene_color)));
+                     shader.setVec2f("renderSize",
+                                     static_cast<float>(graph.getWidth(scene_color)),
+                                     static_cast<float>(graph.getHeight(scene_color)));
+                     glBindVertexArray(renderers.quad_vao);
+                     glActiveTexture(GL_TEXTURE0);
+                     glBindTexture(GL_TEXTURE_2D, graph.getTexture(scene_color));
+                     glDrawArrays(GL_TRIANGLES, 0, 6);
+                 })
+        .read(scene_color)
+        .sideEffect();
+}
 
 float plane_vertices[] = {
     // positions            // normals         // texcoords
@@ -46,8 +791,101 @@ float quad_vertices[] = {
     -1.0f, 1.0f, 0.0f, 1.0f, -1.0f, -1.0f, 0.0f, 0.0f, 1.0f, -1.0f, 1.0f, 0.0f,
     -1.0f, 1.0f, 0.0f, 1.0f, 1.0f,  -1.0f, 1.0f, 0.0f, 1.0f, 1.0f,  1.0f, 1.0f};
 
-int main()
+int main(int argc, char** argv)
 {
+    bool  run_benchmark     = false;
+    bool  run_aa_comparison = false;
+    float target_ms         = 1000.f / 60.f;
+    float render_scale      = 1.f; // when dynamic resolution is off
+    // skinned model with animations to fill the floor with, none by default
+    std::string character_path;
+    uint32_t    character_count = 1000;
+    uint32_t    particle_count  = 0; // capacity of the particle fountain, none by default
+    uint32_t    instance_count  = 0; // boxes in the streamed swarm, none by default
+    uint32_t    baked_count     = 0; // characters drawn from baked vertex animation
+    std::string pack_path;           // asset pack to read the files from, none by default
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--benchmark") == 0)
+            run_benchmark = true;
+        else if (strcmp(argv[index], "--aa-compare") == 0)
+            run_aa_comparison = true;
+        else if (strcmp(argv[index], "--deferred") == 0)
+            render_path = RenderPath::deferred;
+        else if (strcmp(argv[index], "--visibility") == 0)
+            render_path = RenderPath::visibility;
+        else if (strcmp(argv[index], "--dynamic-resolution") == 0)
+            dynamic_resolution_enabled = true;
+        else if (strcmp(argv[index], "--no-lods") == 0)
+            lods_enabled = false;
+        else if (strcmp(argv[index], "--clusters") == 0 && index + 1 < argc)
+        {
+            index++;
+            for (int mode = 0; mode < k_cluster_culling_count; mode++)
+            {
+                if (strcmp(argv[index], k_cluster_culling_names[mode]) == 0)
+                    cluster_culling = static_cast<VisibilityRenderer::ClusterCulling>(mode);
+            }
+        }
+        else if (strcmp(argv[index], "--loader") == 0 && index + 1 < argc)
+        {
+            index++;
+            for (int mode = 0; mode < k_model_loader_count; mode++)
+            {
+                if (strcmp(argv[index], k_model_loader_names[mode]) == 0)
+                    model_loader = static_cast<ModelLoader>(mode);
+            }
+        }
+        else if (strcmp(argv[index], "--texture-reads") == 0 && index + 1 < argc)
+        {
+            index++;
+            for (int mode = 0; mode < k_texture_read_count; mode++)
+            {
+                if (strcmp(argv[index], k_texture_read_names[mode]) == 0)
+                {
+                    texture_reads.use_io_uring = mode > 0;
+                    texture_reads.direct       = mode == 2;
+                }
+            }
+        }
+        else if (strcmp(argv[index], "--target-ms") == 0 && index + 1 < argc)
+            target_ms = static_cast<float>(atof(argv[++index]));
+        else if (strcmp(argv[index], "--aa") == 0 && index + 1 < argc)
+        {
+            index++;
+            for (int mode = 0; mode < k_anti_aliasing_count; mode++)
+            {
+                if (strcmp(argv[index], k_anti_aliasing_names[mode]) == 0)
+                    anti_aliasing = static_cast<AntiAliasing>(mode);
+            }
+        }
+        else if (strcmp(argv[index], "--render-scale") == 0 && index + 1 < argc)
+            render_scale = static_cast<float>(atof(argv[++index]));
+        else if (strcmp(argv[index], "--characters") == 0 && index + 1 < argc)
+            character_path = argv[++index];
+        else if (strcmp(argv[index], "--character-count") == 0 && index + 1 < argc)
+            character_count = static_cast<uint32_t>(std::max(1, atoi(argv[++index])));
+        else if (strcmp(argv[index], "--particles") == 0 && index + 1 < argc)
+            particle_count = static_cast<uint32_t>(std::max(0, atoi(argv[++index])));
+        else if (strcmp(argv[index], "--instances") == 0 && index + 1 < argc)
+            instance_count = static_cast<uint32_t>(std::max(0, atoi(argv[++index])));
+        else if (strcmp(argv[index], "--baked-characters") == 0 && index + 1 < argc)
+            baked_count = static_cast<uint32_t>(std::max(0, atoi(argv[++index])));
+        else if (strcmp(argv[index], "--pack") == 0 && index + 1 < argc)
+            pack_path = argv[++index];
+        else if (strcmp(argv[index], "--ao") == 0 && index + 1 < argc)
+        {
+            index++;
+            for (int mode = 0; mode < k_occlusion_mode_count; mode++)
+            {
+                if (strcmp(argv[index], k_occlusion_mode_names[mode]) == 0)
+                    occlusion_mode = static_cast<OcclusionMode>(mode);
+            }
+        }
+    }
+
+    reportPathAntiAliasing();
+
     if (!glfwInit())
     {
         std::cout << "Failed to initialize GLFW" << std::endl;
@@ -57,6 +895,9 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_SAMPLES, 4);
+    // the comparison only reads its images back
+    if (run_aa_comparison)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     GLFWwindow* window = glfwCreateWindow(k_width, k_height, "LearnOpenGL", NULL, NULL);
     if (window == nullptr)
@@ -69,6 +910,7 @@ int main()
     glfwMakeContextCurrent(window);
 
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetKeyCallback(window, key_callback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
@@ -82,25 +924,213 @@ int main()
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_MULTISAMPLE);
 
-    uint32_t plane_vao, plane_vbo;
-    glGenVertexArrays(1, &plane_vao);
-    glGenBuffers(1, &plane_vbo);
-    glBindVertexArray(plane_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, plane_vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(plane_vertices), &plane_vertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glBindVertexArray(0);
+    // batch work on every core: welding at import, the crowd's poses and the instance transforms
+    JobSystem jobs;
+
+    // every file from here on comes out of the pack when it has it, decompressed on the jobs
+    if (!pack_path.empty() && AssetFile::mountPack(pack_path, k_asset_root, &jobs))
+        std::cout << "Info: Reading the assets from " << pack_path << std::endl;
 
     uint32_t floor_texture = createTexture("../../../data/chess.png");
 
-    Shader blinn_phone_shader("../../../shader/blinn_phone.vs", "../../../shader/blinn_phone.fs");
-    blinn_phone_shader.use();
-    blinn_phone_shader.setInt("texture1", 0);
+    // the floor goes through Mesh like the model meshes so every render path can consume it
+    std::vector<Vertex>   plane_mesh_vertices;
+    std::vector<uint32_t> plane_mesh_indices;
+    for (uint32_t index = 0; index < 6; index++)
+    {
+        const float* src = &plane_vertices[index * 8];
+
+        Vertex vertex    = {};
+        vertex.position  = glm::vec3(src[0], src[1], src[2]);
+        vertex.normal    = glm::vec3(src[3], src[4], src[5]);
+        vertex.texcoords = glm::vec2(src[6], src[7]);
+        plane_mesh_vertices.push_back(vertex);
+        plane_mesh_indices.push_back(index);
+    }
+    Mesh floor_mesh(plane_mesh_vertices,
+                    plane_mesh_indices,
+                    {Texture {floor_texture, TextureType::_diffuse, "chess.png"}});
+
+    Model sponza("../../../data/sponza/sponza.obj", jobs, model_loader, texture_reads);
+
+    // the triangles of every level, summed over the meshes that have it
+    uint32_t              full_triangles = 0;
+    std::vector<uint32_t> level_triangles;
+    for (const auto* mesh : sponza.getMeshes())
+    {
+        full_triangles += static_cast<uint32_t>(mesh->indices.size() / 3);
+        level_triangles.resize(std::max(level_triangles.size(), mesh->lods.size()), 0);
+        for (size_t level = 0; level < mesh->lods.size(); level++)
+        {
+            level_triangles[level] += mesh->lods[level].index_count / 3;
+        }
+    }
+    std::cout << "Info: sponza levels of detail";
+    for (uint32_t triangles : level_triangles)
+    {
+        std::cout << " " << triangles;
+    }
+    std::cout << " triangles" << std::endl;
+
+    // baked occlusion from sponza's mesh cache, for every render path. The floor and the box
+    // have no lightmap coords and sample its white texel at (0, 0)
+    glActiveTexture(GL_TEXTURE10);
+    glBindTexture(GL_TEXTURE_2D, sponza.getLightmapTexture());
+    glActiveTexture(GL_TEXTURE0);
+
+    // the only moving object, it keeps the shadow cascades it covers from being fully cached
+    Mesh box_mesh = createBoxMesh(createTexture("../../../data/container2.png"));
+
+    // the animated crowd: poses are evaluated on every core straight into a ring of palettes the
+    // vertex shaders skin the instances with. The forward and deferred paths draw it
+    std::unique_ptr<Model>           character;
+    std::unique_ptr<AnimationSystem> crowd;
+    std::unique_ptr<RingBuffer>      palette_ring;
+    uint32_t                         crowd_ssbo = 0;
+    if (!character_path.empty())
+    {
+        character =
+            std::make_unique<Model>(character_path.c_str(), jobs, model_loader, texture_reads);
+        if (character->getClips().empty())
+        {
+            std::cout << "ERROR::ANIMATION:: " << character_path << " has no animations"
+                      << std::endl;
+        }
+        else
+        {
+            crowd = std::make_unique<AnimationSystem>(character->getSkeleton(),
+                                                      character->getClips());
+            const std::vector<glm::mat4> crowd_transforms =
+                createCrowd(*character, character_count, *crowd);
+            palette_ring =
+                std::make_unique<RingBuffer>(crowd->getPaletteSize() * sizeof(JointMatrix));
+
+            glGenBuffers(1, &crowd_ssbo);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, crowd_ssbo);
+            glBufferData(GL_SHADER_STORAGE_BUFFER,
+                         crowd_transforms.size() * sizeof(glm::mat4),
+                         crowd_transforms.data(),
+                         GL_STATIC_DRAW);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, crowd_ssbo);
+
+            std::cout << "Info: " << character_count << " characters, "
+                      << character->getSkeleton().getJointCount() << " joints, "
+                      << jobs.getThreadCount() << " animation threads" << std::endl;
+        }
+    }
+
+    // a fountain of sparks simulated, culled and sorted on the GPU, drawn by the forward path.
+    // It emits enough to keep about 90% of its capacity alive
+    std::unique_ptr<ParticleSystem> particles;
+    ParticleEmitter                 emitter;
+    if (particle_count > 0)
+    {
+        const float average_lifetime = 0.5f * (emitter.lifetime_min + emitter.lifetime_max);
+        particles                    = std::make_unique<ParticleSystem>(particle_count);
+        emitter.position             = glm::vec3(0.f, -0.4f, -1.f);
+        emitter.rate                 = 0.9f * particles->getCapacity() / average_lifetime;
+        std::cout << "Info: " << particles->getCapacity() << " particles, "
+                  << particles->getMemoryUsage() / (1024 * 1024) << " MB" << std::endl;
+    }
+
+    // a swarm of boxes moved and culled on every core each frame, streamed to the forward and
+    // deferred paths
+    std::unique_ptr<InstanceStream> swarm;
+    std::vector<SwarmOrbit>         swarm_orbits;
+    if (instance_count > 0)
+    {
+        swarm = std::make_unique<InstanceStream>(instance_count);
+        swarm->manager.setBounds(glm::vec3(0.f), 0.87f); // the unit box
+        swarm_orbits = createSwarm(instance_count, swarm->manager);
+        std::cout << "Info: " << instance_count << " instances, "
+                  << swarm->getMemoryUsage() / (1024 * 1024) << " MB of rings" << std::endl;
+    }
+
+    // background characters: the clips of the skinned crowd baked into vertex animation textures
+    // and played by streamed instances. They stand still, so only culling runs every frame
+    std::unique_ptr<VertexAnimationTextures> baked_animation;
+    std::unique_ptr<InstanceStream>          background_crowd;
+    std::vector<uint32_t>                    baked_mesh_offsets;
+    if (crowd && baked_count > 0)
+    {
+        GLint max_texture_size = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+        VertexAnimationSettings settings;
+        settings.max_height = static_cast<uint32_t>(max_texture_size);
+
+        const double    bake_start = glfwGetTime();
+        VertexAnimation baked;
+        if (bakeVertexAnimation(character->getSkeleton(),
+                                character->getClips(),
+                                character->getMeshes(),
+                                settings,
+                                jobs,
+                                baked))
+        {
+            std::cout << "Info: baked " << baked.frame_count << " frames of "
+                      << baked.vertex_count << " vertices in "
+                      << 1000.0 * (glfwGetTime() - bake_start) << " ms, "
+                      << baked.getMemoryUsage() / 1024 << " KB" << std::endl;
+            for (const auto& clip : baked.clips)
+            {
+                std::cout << "Info:   " << clip.name << ": " << clip.frame_count << " frames, "
+                          << clip.memory / 1024 << " KB, position error "
+                          << clip.frame_position_error << " at the frames and "
+                          << clip.position_error << " between them, normal error "
+                          << clip.normal_error << " degrees" << std::endl;
+            }
+
+            baked_animation    = std::make_unique<VertexAnimationTextures>(baked);
+            baked_mesh_offsets = baked.mesh_offsets;
+            background_crowd   = std::make_unique<InstanceStream>(baked_count);
+            createBackgroundCrowd(*character, baked, baked_count, background_crowd->manager);
+        }
+    }
+
+    sun.direction = glm::vec3(-0.3f, -1.f, -0.2f);
+    sun.ambient   = glm::vec3(0.f);
+    sun.diffuse   = glm::vec3(0.6f);
+    sun.specular  = glm::vec3(0.3f);
+
+    CascadedShadowMap cascaded_shadow_map(2048, 4, 40.f);
+    shadow_map = &cascaded_shadow_map;
+
+    PointShadowAtlas point_shadow_atlas(512, 4);
+    const uint64_t   point_shadow_budget = point_shadow_atlas.getUpdateBudget();
+
+    Shader forward_shader("../../../shader/forward.vs", "../../../shader/forward.fs");
+    forward_shader.use();
+    forward_shader.setInt("texture_diffuse1", 0);
+    forward_shader.setInt("texture_specular1", 1);
+
+    // depth of the forward path before shading, when the ambient occlusion needs it
+    Shader depth_prepass_shader("../../../shader/depth_prepass.vs",
+                                "../../../shader/shadow_depth.fs");
+
+    DeferredRenderer     deferred_renderer(k_width, k_height);
+    VisibilityRenderer   visibility_renderer(k_width, k_height);
+    TemporalAntiAliasing temporal_aa(k_width, k_height);
+    PostAntiAliasing     post_aa;
+    PostProcessing       post_process(k_width, k_height);
+    AmbientOcclusion     ambient_occlusion(k_width, k_height);
+
+    // point lights shared by every render path
+    std::vector<PointLight>    point_lights = createPointLights(8);
+    std::vector<GpuPointLight> gpu_lights;
+    for (const auto& point_light : point_lights)
+    {
+        gpu_lights.push_back(GpuPointLight(point_light));
+    }
+
+    uint32_t light_ssbo;
+    glGenBuffers(1, &light_ssbo);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, light_ssbo);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 gpu_lights.size() * sizeof(GpuPointLight),
+                 gpu_lights.data(),
+                 GL_STATIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, light_ssbo);
+    const uint32_t light_count = static_cast<uint32_t>(gpu_lights.size());
 
     uint32_t quad_vao, quad_vbo;
     glGenVertexArrays(1, &quad_vao);
@@ -114,60 +1144,184 @@ int main()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
     glBindVertexArray(0);
 
-    uint32_t msaa_fbo;
-    glGenFramebuffers(1, &msaa_fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, msaa_fbo);
-
-    uint32_t msaa_tex;
-    glGenTextures(1, &msaa_tex);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, msaa_tex);
-    glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, 4, GL_RGB, k_width, k_height, GL_TRUE);
-    glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
-    glFramebufferTexture2D(
-        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_MULTISAMPLE, msaa_tex, 0);
-
-    uint32_t msaa_rbo;
-    glGenRenderbuffers(1, &msaa_rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, msaa_rbo);
-    glRenderbufferStorageMultisample(GL_RENDERBUFFER, 4, GL_DEPTH24_STENCIL8, k_width, k_height);
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(
-        GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, msaa_rbo);
-
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-    {
-        std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-    }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    uint32_t intermediate_fbo;
-    glGenFramebuffers(1, &intermediate_fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, intermediate_fbo);
-    uint32_t screen_tex;
-    glGenTextures(1, &screen_tex);
-    glBindTexture(GL_TEXTURE_2D, screen_tex);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, k_width, k_height, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screen_tex, 0);
+    RenderGraph frame_graph(k_width, k_height);
+    render_graph = &frame_graph;
+
+    // size the renderers that own their targets were created for, they follow the graph
+    uint32_t target_width  = k_width;
+    uint32_t target_height = k_height;
+
+    // the scene renders at the dynamic resolution, the present pass scales it up to the window
+    Shader upscale_shader("../../../shader/framebuffer_screen.vs", "../../../shader/upscale.fs");
+    upscale_shader.use();
+    upscale_shader.setInt("sourceTexture", 0);
+
+    DynamicResolution dynamic_resolution(target_ms);
+
+    // the scene, sponza scaled down to about 40 units, within the far plane
+    camera.setPerspective(45.f, 0.1f, 100.f);
+    camera.updateProjection((float)k_width / (float)k_height);
+
+    glm::mat4 projection   = camera.getProjection();
+    glm::mat4 view         = glm::mat4(1.f);
+    glm::mat4 model        = glm::mat4(1.f);
+    glm::mat4 sponza_model = glm::scale(glm::mat4(1.f), glm::vec3(0.01f));
+    glm::mat4 box_model    = glm::mat4(1.f);
+
+    // last frame's transforms for the velocity buffer, without jitter
+    glm::mat4 previous_view_projection = camera.getUnjitteredProjection();
+    glm::mat4 previous_box_model       = glm::mat4(1.f);
+
+    // scene time the baked characters play at, this frame and the last
+    float animation_time          = 0.f;
+    float previous_animation_time = 0.f;
+
+    const glm::vec3 clear_color(0.1f, 0.1f, 0.1f);
+
+    // draws every object of the scene with a shader that has its camera uniforms set
+    auto draw_scene = [&](Shader& shader) {
+        shader.setMat4fv("model", glm::value_ptr(model));
+        shader.setMat4fv("previousModel", glm::value_ptr(model));
+        floor_mesh.Draw(shader);
+
+        shader.setMat4fv("model", glm::value_ptr(sponza_model));
+        shader.setMat4fv("previousModel", glm::value_ptr(sponza_model));
+        sponza.Draw(shader);
+
+        shader.setMat4fv("model", glm::value_ptr(box_model));
+        shader.setMat4fv("previousModel", glm::value_ptr(previous_box_model));
+        box_mesh.Draw(shader);
+
+        if (crowd)
+        {
+            shader.setUint("jointCount", character->getSkeleton().getJointCount());
+            character->Draw(shader, crowd->getCharacterCount());
+            shader.setUint("jointCount", 0);
+        }
+
+        if (swarm)
+        {
+            swarm->bind();
+            shader.setBool("streamedInstances", true);
+            box_mesh.Draw(shader, swarm->visible_count);
+            shader.setBool("streamedInstances", false);
+        }
+
+        if (background_crowd)
+        {
+            background_crowd->bind();
+            baked_animation->bind(11, 19);
+            shader.setBool("streamedInstances", true);
+            shader.setBool("vertexAnimation", true);
+            shader.setFloat("animationTime", animation_time);
+            shader.setFloat("previousAnimationTime", previous_animation_time);
+            const std::vector<Mesh*>& meshes = character->getMeshes();
+            for (size_t index = 0; index < meshes.size(); index++)
+            {
+                shader.setUint("animationVertexOffset", baked_mesh_offsets[index]);
+                meshes[index]->Draw(shader, background_crowd->visible_count);
+            }
+            shader.setBool("vertexAnimation", false);
+            shader.setBool("streamedInstances", false);
+        }
+    };
 
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    std::vector<ShadowCaster> shadow_casters;
+    shadow_casters.push_back(ShadowCaster {&floor_mesh, model, true});
+    for (const auto* mesh : sponza.getMeshes())
     {
-        std::cout << "ERROR::FRAMEBUFFER:: Intermediate Framebuffer is not complete!" << std::endl;
+        shadow_casters.push_back(ShadowCaster {mesh, sponza_model, true});
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    shadow_casters.push_back(ShadowCaster {&box_mesh, box_model, false});
 
-    Shader screen_shader("../../../shader/framebuffer_screen.vs",
-                         "../../../shader/framebuffer_screen.fs");
-    screen_shader.use();
-    screen_shader.setInt("screenTexture", 0);
+    visibility_renderer.addMesh(floor_mesh, model);
+    for (const auto* mesh : sponza.getMeshes())
+    {
+        visibility_renderer.addMesh(*mesh, sponza_model);
+    }
+    const uint32_t box_draw = visibility_renderer.addMesh(box_mesh, box_model);
+    visibility_renderer.build();
+
+    GpuTimer scene_timer;
+    // everything the dynamic resolution scale has to keep under the target
+    GpuTimer frame_timer;
 
-    glm::mat4 projection =
-        glm::perspective(glm::radians(45.f), (float)k_width / (float)k_height, 0.1f, 100.f);
-    glm::mat4 view  = glm::mat4(1.f);
-    glm::mat4 model = glm::mat4(1.f);
+    const FrameRenderers frame_renderers {forward_shader,
+                                          depth_prepass_shader,
+                                          upscale_shader,
+                                          deferred_renderer,
+                                          visibility_renderer,
+                                          temporal_aa,
+                                          post_aa,
+                                          post_process,
+                                          ambient_occlusion,
+                                          scene_timer,
+                                          draw_scene,
+                                          particles.get(),
+                                          emitter.size,
+                                          quad_vao,
+                                          light_count,
+                                          clear_color};
+
+    if (run_benchmark || run_aa_comparison)
+    {
+        // measure rendering, not the display refresh
+        glfwSwapInterval(0);
+    }
 
-    glm::vec3 light_pos(0.0f, 0.0f, 0.0f);
+    // replays the standard camera paths once per configuration, then exits. Configurations are
+    // "<render path>[/option]"
+    std::vector<std::string> configurations;
+    for (const char* name : k_render_path_names)
+    {
+        configurations.push_back(name);
+    }
+    configurations.push_back("forward/shadow_nocache");
+    configurations.push_back("forward/point_shadow_nobudget");
+    configurations.push_back("forward/dynres");
+    configurations.push_back("forward/taa");
+    configurations.push_back("forward/taau");
+    configurations.push_back("forward/noaa");
+    configurations.push_back("forward/fxaa");
+    configurations.push_back("forward/smaa");
+    configurations.push_back("forward/ao_medium");
+    configurations.push_back("forward/nolods");
+    configurations.push_back("deferred/ao_low");
+    configurations.push_back("deferred/ao_medium");
+    configurations.push_back("deferred/ao_high");
+    configurations.push_back("visibility/ao_medium");
+    configurations.push_back("visibility/clusters_off");
+    configurations.push_back("visibility/clusters_cpu");
+    Benchmark benchmark(configurations,
+                        Benchmark::standardPaths(),
+                        run_benchmark ? 600 : 0,
+                        2 * GpuTimer::k_latency);
+
+    // renders a few fixed views of the forward path with every anti-aliasing mode, compares them
+    // against a 16x supersampled reference, then exits. The reference averages 4x4 frames jittered
+    // over an ordered grid, so it needs no larger targets. Mode -1 is the reference
+    const uint32_t               k_supersampling = 4;
+    std::vector<CameraPath::Key> comparison_views;
+    for (const auto& path : Benchmark::standardPaths())
+    {
+        comparison_views.push_back(path.sample(0.f));
+        comparison_views.push_back(path.sample(0.5f));
+    }
+    size_t                comparison_view  = 0;
+    int                   comparison_mode  = -1;
+    uint32_t              comparison_frame = 0;
+    std::vector<uint32_t> reference_sum;
+    std::vector<uint8_t>  reference_image;
+    std::vector<uint8_t>  captured_image;
+    ImageError            comparison_errors[k_anti_aliasing_count];
+
+    // frames rendered per mode, the last ones are captured: the reference captures all of its
+    // jittered frames, TAA first converges
+    auto comparison_frames = [&](int mode) -> uint32_t {
+        if (mode < 0)
+            return 1 + k_supersampling * k_supersampling;
+        return static_cast<AntiAliasing>(mode) == AntiAliasing::taa ? 64 : 4;
+    };
 
     uint32_t frame_index = 0;
     while (!glfwWindowShouldClose(window))
@@ -177,56 +1331,456 @@ int main()
 
         processInput(window);
 
+        if (run_benchmark)
+        {
+            if (benchmark.isFinished())
+            {
+                benchmark.report(std::cout);
+                post_process.report(std::cout);
+                dynamic_resolution.report(std::cout, target_width, target_height);
+                if (particles)
+                {
+                    const ParticleSystem::Statistics statistics = particles->readStatistics();
+                    std::cout << "Info: particles " << statistics.alive << " alive, "
+                              << statistics.visible << " visible, " << statistics.dead
+                              << " dead, bounds (" << statistics.bounds_min.x << ", "
+                              << statistics.bounds_min.y << ", " << statistics.bounds_min.z
+                              << ") to (" << statistics.bounds_max.x << ", "
+                              << statistics.bounds_max.y << ", " << statistics.bounds_max.z << ")"
+                              << std::endl;
+                }
+                break;
+            }
+
+            const std::string& configuration = benchmark.getConfiguration();
+            const std::string  path_name     = configuration.substr(0, configuration.find('/'));
+            for (int index = 0; index < k_render_path_count; index++)
+            {
+                if (path_name == k_render_path_names[index])
+                    render_path = static_cast<RenderPath>(index);
+            }
+
+            const bool shadow_caching = configuration.find("/shadow_nocache") == std::string::npos;
+            if (shadow_caching != cascaded_shadow_map.isCaching())
+                cascaded_shadow_map.setCaching(shadow_caching);
+
+            const bool point_shadow_budgeted =
+                configuration.find("/point_shadow_nobudget") == std::string::npos;
+            point_shadow_atlas.setUpdateBudget(point_shadow_budgeted ? point_shadow_budget :
+                                                                       UINT64_MAX);
+
+            dynamic_resolution_enabled = configuration.find("/dynres") != std::string::npos;
+            lods_enabled               = configuration.find("/nolods") == std::string::npos;
+
+            cluster_culling = VisibilityRenderer::ClusterCulling::gpu;
+            for (int mode = 0; mode < k_cluster_culling_count; mode++)
+            {
+                if (configuration.find(std::string("/clusters_") + k_cluster_culling_names[mode]) !=
+                    std::string::npos)
+                    cluster_culling = static_cast<VisibilityRenderer::ClusterCulling>(mode);
+            }
+
+            anti_aliasing = AntiAliasing::msaa;
+            if (configuration.find("/noaa") != std::string::npos)
+                anti_aliasing = AntiAliasing::none;
+            else if (configuration.find("/fxaa") != std::string::npos)
+                anti_aliasing = AntiAliasing::fxaa;
+            else if (configuration.find("/smaa") != std::string::npos)
+                anti_aliasing = AntiAliasing::smaa;
+            else if (configuration.find("/taa") != std::string::npos)
+                anti_aliasing = AntiAliasing::taa;
+
+            // the other configurations run without ambient occlusion
+            occlusion_mode = OcclusionMode::off;
+            for (int mode = 1; mode < k_occlusion_mode_count; mode++)
+            {
+                if (configuration.find(std::string("/ao_") + k_occlusion_mode_names[mode]) !=
+                    std::string::npos)
+                    occlusion_mode = static_cast<OcclusionMode>(mode);
+            }
+
+            // TAAU is TAA upsampling from a fixed 0.7 scale, about half the pixels
+            render_scale = configuration.find("/taau") != std::string::npos ? 0.7f : 1.f;
+
+            const CameraPath::Key key = benchmark.getCameraKey();
+            camera.setPosition(key.position);
+            camera.setTarget(key.target);
+        }
+
+        if (run_aa_comparison)
+        {
+            if (comparison_view == comparison_views.size())
+            {
+                char line[128];
+                std::cout << "Anti-aliasing against 16x supersampling, forward path, "
+                          << comparison_views.size() << " views" << std::endl;
+                snprintf(line, sizeof(line), "%-8s %12s %10s", "mode", "mean_abs", "psnr_db");
+                std::cout << line << std::endl;
+                for (int mode = 0; mode < k_anti_aliasing_count; mode++)
+                {
+                    snprintf(line,
+                             sizeof(line),
+                             "%-8s %12.5f %10.2f",
+                             k_anti_aliasing_names[mode],
+                             comparison_errors[mode].mean_abs / comparison_views.size(),
+                             comparison_errors[mode].psnr / comparison_views.size());
+                    std::cout << line << std::endl;
+                }
+                break;
+            }
+
+            render_path   = RenderPath::forward;
+            anti_aliasing = comparison_mode < 0 ? AntiAliasing::none :
+                                                  static_cast<AntiAliasing>(comparison_mode);
+            dynamic_resolution_enabled = false;
+            render_scale               = 1.f;
+            // its temporal noise would show up in every mode's error
+            occlusion_mode = OcclusionMode::off;
+            // every light shadowed from the first frame on
+            point_shadow_atlas.setUpdateBudget(UINT64_MAX);
+
+            camera.setPosition(comparison_views[comparison_view].position);
+            camera.setTarget(comparison_views[comparison_view].target);
+        }
+
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, msaa_fbo);
-        glClearColor(0.1f, 0.1f, 0.1f, 0.1f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
+        // resizes reach the graph from the framebuffer size callback, the renderers owning their
+        // targets and the projection follow it here
+        if (frame_graph.getWidth() != target_width || frame_graph.getHeight() != target_height)
+        {
+            target_width  = frame_graph.getWidth();
+            target_height = frame_graph.getHeight();
+            deferred_renderer.resize(target_width, target_height);
+            visibility_renderer.resize(target_width, target_height);
+            temporal_aa.resize(target_width, target_height);
+            post_process.resize(target_width, target_height);
+            ambient_occlusion.resize(target_width, target_height);
+            camera.updateProjection((float)target_width / (float)target_height);
+        }
 
         view = camera.getLookAt();
 
         glm::vec3 camera_pos = camera.getPosition();
 
-        blinn_phone_shader.use();
-        blinn_phone_shader.setMat4fv("projection", glm::value_ptr(projection));
-        blinn_phone_shader.setMat4fv("model", glm::value_ptr(model));
-        blinn_phone_shader.setMat4fv("view", glm::value_ptr(view));
-        blinn_phone_shader.setVec3f("lightPos", light_pos.x, light_pos.y, light_pos.z);
-        blinn_phone_shader.setVec3f("viewPos", camera_pos.x, camera_pos.y, camera_pos.z);
-
-        glBindVertexArray(plane_vao);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, floor_texture);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, msaa_fbo);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediate_fbo);
-        glBlitFramebuffer(
-            0, 0, k_width, k_height, 0, 0, k_width, k_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST);
-
-        screen_shader.use();
-        glBindVertexArray(quad_vao);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, screen_tex);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        // fixed time step while benchmarking so every configuration sees the same animation, and
+        // a still scene for the comparison
+        float scene_time       = current_frame_time;
+        float scene_delta_time = delta_time;
+        if (run_benchmark)
+        {
+            scene_time       = static_cast<float>(frame_index) / 60.f;
+            scene_delta_time = 1.f / 60.f;
+        }
+        else if (run_aa_comparison)
+        {
+            scene_time       = 0.f;
+            scene_delta_time = 0.f;
+        }
+        const glm::vec3 box_position(2.f * glm::sin(scene_time), 0.5f, 0.f);
+        box_model = glm::translate(glm::mat4(1.f), box_position);
+        box_model = glm::rotate(box_model, scene_time, glm::vec3(0.f, 1.f, 0.f));
+        shadow_casters.back().transform = box_model;
+        visibility_renderer.setTransform(box_draw, box_model);
+
+        double animation_cpu_ms = 0.0;
+        if (crowd)
+        {
+            const double animation_start = glfwGetTime();
+            crowd->update(scene_delta_time,
+                          jobs,
+                          static_cast<JointMatrix*>(palette_ring->beginFrame()));
+            palette_ring->bind(7, 8);
+            animation_cpu_ms = 1000.0 * (glfwGetTime() - animation_start);
+        }
+
+        frame_timer.begin();
+
+        cascaded_shadow_map.render(sun,
+                                   view,
+                                   glm::radians(camera.getFov()),
+                                   (float)target_width / (float)target_height,
+                                   camera.getNearClip(),
+                                   shadow_casters);
+        cascaded_shadow_map.bind(4);
+
+        point_shadow_atlas.update(
+            point_lights, view, camera.getUnjitteredProjection(), shadow_casters);
+        point_shadow_atlas.bind(5);
+
+        frame_graph.setDynamicScale(
+            dynamic_resolution_enabled ? dynamic_resolution.update(frame_timer.getElapsedMs()) :
+                                         render_scale);
+        deferred_renderer.setRenderSize(frame_graph.getRenderWidth(),
+                                        frame_graph.getRenderHeight());
+        visibility_renderer.setRenderSize(frame_graph.getRenderWidth(),
+                                          frame_graph.getRenderHeight());
+        visibility_renderer.setClusterCulling(cluster_culling);
+
+        const AntiAliasing path_anti_aliasing = getPathAntiAliasing(render_path, anti_aliasing);
+        const bool         taa_active         = path_anti_aliasing == AntiAliasing::taa;
+
+        const bool occlusion_enabled = occlusion_mode != OcclusionMode::off;
+        if (occlusion_enabled)
+        {
+            ambient_occlusion.setQuality(
+                static_cast<AmbientOcclusion::Quality>(static_cast<int>(occlusion_mode) - 1));
+        }
+
+        // the benchmark adapts the exposure on its fixed time step, the comparison has none
+        const float exposure_delta_time = run_benchmark ? 1.f / 60.f : delta_time;
+        if (run_aa_comparison)
+            post_process.resetExposure();
+        if (taa_active)
+        {
+            camera.setJitter(temporal_aa.beginFrame(frame_graph.getRenderWidth(),
+                                                    frame_graph.getRenderHeight()));
+        }
+        else
+        {
+            camera.setJitter(glm::vec2(0.f));
+            temporal_aa.resetHistory();
+        }
+        // the reference frames after the first one cover the pixel with an ordered grid
+        const uint32_t comparison_captures =
+            comparison_mode < 0 ? k_supersampling * k_supersampling : 1;
+        const bool capture = run_aa_comparison && comparison_frame + comparison_captures >=
+                                                      comparison_frames(comparison_mode);
+        if (run_aa_comparison && comparison_mode < 0 && comparison_frame > 0)
+        {
+            const uint32_t  sample = comparison_frame - 1;
+            const glm::vec2 offset =
+                (glm::vec2(sample % k_supersampling, sample / k_supersampling) + 0.5f) /
+                    static_cast<float>(k_supersampling) -
+                0.5f;
+            camera.setJitter(2.f * offset / glm::vec2(target_width, target_height));
+        }
+        projection = camera.getProjection();
+
+        const glm::mat4 view_projection = camera.getUnjitteredProjection() * view;
+
+        // against the projection without jitter so the levels don't flicker with it
+        uint32_t lod_triangles = full_triangles;
+        if (lods_enabled)
+        {
+            lod_triangles = sponza.selectLods(sponza_model,
+                                              camera_pos,
+                                              camera.getUnjitteredProjection(),
+                                              static_cast<float>(frame_graph.getRenderHeight()));
+        }
+        else
+        {
+            sponza.clearLods();
+        }
+
+        if (particles)
+            particles->update(scene_delta_time, emitter, camera_pos, view_projection);
+
+        double instance_update_cpu_ms = 0.0;
+        double instance_cull_cpu_ms   = 0.0;
+        if (swarm)
+        {
+            const double   update_start = glfwGetTime();
+            const uint32_t count        = swarm->manager.getCount();
+            jobs.parallelFor(count,
+                             InstanceManager::k_block_size,
+                             [&](uint32_t begin, uint32_t end, uint32_t) {
+                                 for (uint32_t index = begin; index < end; index++)
+                                 {
+                                     placeSwarmInstance(
+                                         swarm->manager, swarm_orbits[index], index, scene_time);
+                                 }
+                             });
+            swarm->manager.markDirty(0, count);
+            swarm->flush(jobs);
+            instance_update_cpu_ms = 1000.0 * (glfwGetTime() - update_start);
+
+            const double cull_start = glfwGetTime();
+            swarm->cull(view_projection, jobs);
+            instance_cull_cpu_ms = 1000.0 * (glfwGetTime() - cull_start);
+        }
+
+        double background_cull_cpu_ms = 0.0;
+        if (background_crowd)
+        {
+            const double cull_start = glfwGetTime();
+            background_crowd->flush(jobs);
+            background_crowd->cull(view_projection, jobs);
+            background_cull_cpu_ms = 1000.0 * (glfwGetTime() - cull_start);
+        }
+        animation_time = scene_time;
+
+        FrameState frame_state;
+        frame_state.render_path              = render_path;
+        frame_state.anti_aliasing            = path_anti_aliasing;
+        frame_state.taa_active               = taa_active;
+        frame_state.occlusion_enabled        = occlusion_enabled;
+        frame_state.view                     = view;
+        frame_state.projection               = projection;
+        frame_state.view_projection          = view_projection;
+        frame_state.previous_view_projection = previous_view_projection;
+        frame_state.camera_pos               = camera_pos;
+        frame_state.target_width             = target_width;
+        frame_state.target_height            = target_height;
+        frame_state.exposure_delta_time      = exposure_delta_time;
+        frame_state.captured_image           = capture ? &captured_image : nullptr;
+        declareFrame(frame_graph, frame_renderers, frame_state);
+
+        frame_graph.execute();
+
+        frame_timer.end();
+
+        if (palette_ring)
+            palette_ring->endFrame();
+        if (swarm)
+            swarm->endFrame();
+        if (background_crowd)
+            background_crowd->endFrame();
+
+        previous_view_projection = view_projection;
+        previous_box_model       = box_model;
+        previous_animation_time  = animation_time;
+
+        if (capture)
+        {
+            if (comparison_mode < 0)
+            {
+                reference_sum.resize(captured_image.size(), 0);
+                for (size_t index = 0; index < captured_image.size(); index++)
+                {
+                    reference_sum[index] += captured_image[index];
+                }
+            }
+            else
+            {
+                const ImageError error = compareImages(captured_image, reference_image);
+                comparison_errors[comparison_mode].mean_abs += error.mean_abs;
+                comparison_errors[comparison_mode].psnr += error.psnr;
+            }
+        }
+
+        if (run_aa_comparison && ++comparison_frame == comparison_frames(comparison_mode))
+        {
+            if (comparison_mode < 0)
+            {
+                const uint32_t samples = k_supersampling * k_supersampling;
+                reference_image.resize(reference_sum.size());
+                for (size_t index = 0; index < reference_sum.size(); index++)
+                {
+                    reference_image[index] =
+                        static_cast<uint8_t>((reference_sum[index] + samples / 2) / samples);
+                }
+                reference_sum.clear();
+            }
+
+            comparison_frame = 0;
+            if (++comparison_mode == k_anti_aliasing_count)
+            {
+                comparison_mode = -1;
+                comparison_view++;
+            }
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
 
+        if (run_benchmark)
+        {
+            benchmark.record("scene_gpu_ms", scene_timer.getElapsedMs());
+            benchmark.record("frame_gpu_ms", frame_timer.getElapsedMs());
+            benchmark.record("render_scale", frame_graph.getDynamicScale());
+            benchmark.record("lod_triangles", lod_triangles);
+            benchmark.record("full_triangles", full_triangles);
+            benchmark.record("graph_transient_mb",
+                             frame_graph.getMemoryUsage() / (1024.0 * 1024.0));
+            benchmark.record("shadow_gpu_ms", cascaded_shadow_map.getGpuMs());
+            benchmark.record("shadow_draw_calls", cascaded_shadow_map.getStats().draw_calls);
+            benchmark.record("point_shadow_gpu_ms", point_shadow_atlas.getGpuMs());
+            benchmark.record("point_shadow_updates",
+                             point_shadow_atlas.getStats().lights_updated);
+            benchmark.record("point_shadow_deferred",
+                             point_shadow_atlas.getStats().lights_deferred);
+            benchmark.record("post_gpu_ms", post_process.getGpuMs());
+            benchmark.record(
+                "post_downsample_gpu_ms",
+                post_process.getStageStats(PostProcessing::Stage::downsample).gpu_ms);
+            benchmark.record("post_exposure_gpu_ms",
+                             post_process.getStageStats(PostProcessing::Stage::exposure).gpu_ms);
+            benchmark.record("post_upsample_gpu_ms",
+                             post_process.getStageStats(PostProcessing::Stage::upsample).gpu_ms);
+            benchmark.record("post_final_gpu_ms",
+                             post_process.getStageStats(PostProcessing::Stage::final).gpu_ms);
+            benchmark.record("post_read_mb", post_process.getBytesRead() / (1024.0 * 1024.0));
+            benchmark.record("post_written_mb",
+                             post_process.getBytesWritten() / (1024.0 * 1024.0));
+            if (path_anti_aliasing == AntiAliasing::smaa)
+                benchmark.record("smaa_analysis_gpu_ms", post_aa.getGpuMs());
+            if (taa_active)
+            {
+                benchmark.record("taa_gpu_ms", temporal_aa.getGpuMs());
+                benchmark.record("taa_history_mb",
+                                 temporal_aa.getMemoryUsage() / (1024.0 * 1024.0));
+            }
+            if (occlusion_enabled)
+            {
+                benchmark.record("ao_gpu_ms", ambient_occlusion.getGpuMs());
+                benchmark.record("ao_target_mb",
+                                 ambient_occlusion.getMemoryUsage() / (1024.0 * 1024.0));
+            }
+            if (render_path == RenderPath::visibility)
+            {
+                benchmark.record("vis_raster_gpu_ms", visibility_renderer.getRasterMs());
+                benchmark.record("vis_classify_gpu_ms", visibility_renderer.getClassifyMs());
+                benchmark.record("vis_shade_gpu_ms", visibility_renderer.getShadeMs());
+
+                // rejected clusters and the triangles that leaves, a frame late on the gpu
+                const VisibilityRenderer::ClusterStats& clusters =
+                    visibility_renderer.getClusterStats();
+                const double cluster_count  = std::max(clusters.clusters, 1u);
+                const double triangle_count = std::max(clusters.triangles, 1u);
+                benchmark.record("vis_cull_gpu_ms", visibility_renderer.getCullMs());
+                benchmark.record("vis_cull_cpu_ms", visibility_renderer.getCullCpuMs());
+                benchmark.record("vis_frustum_culled_pct",
+                                 100.0 * clusters.frustum_culled / cluster_count);
+                benchmark.record("vis_cone_culled_pct",
+                                 100.0 * clusters.cone_culled / cluster_count);
+                benchmark.record("vis_triangles", clusters.drawn_triangles);
+                benchmark.record("vis_triangles_saved_pct",
+                                 100.0 - 100.0 * clusters.drawn_triangles / triangle_count);
+            }
+            if (crowd)
+            {
+                benchmark.record("animation_cpu_ms", animation_cpu_ms);
+                benchmark.record("palette_wait_ms", palette_ring->getWaitMs());
+            }
+            if (particles)
+                benchmark.record("particle_gpu_ms", particles->getGpuMs());
+            if (swarm)
+            {
+                benchmark.record("instance_update_cpu_ms", instance_update_cpu_ms);
+                benchmark.record("instance_cull_cpu_ms", instance_cull_cpu_ms);
+                benchmark.record("instances_visible", swarm->visible_count);
+                benchmark.record("instance_wait_ms", swarm->getWaitMs());
+            }
+            if (background_crowd)
+            {
+                benchmark.record("baked_cull_cpu_ms", background_cull_cpu_ms);
+                benchmark.record("baked_visible", background_crowd->visible_count);
+            }
+            benchmark.record("frame_ms",
+                             1000.0 * (static_cast<float>(glfwGetTime()) - current_frame_time));
+            benchmark.endFrame();
+        }
+
         frame_index++;
         last_frame_time = current_frame_time;
     }
 
-    glDeleteVertexArrays(1, &plane_vao);
-    glDeleteBuffers(1, &plane_vao);
+    glDeleteBuffers(1, &light_ssbo);
+    glDeleteBuffers(1, &crowd_ssbo);
 
+    AssetFile::unmountPack();
     glfwTerminate();
 
     return 0;
@@ -234,7 +1788,9 @@ int main()
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
-    glViewport(0, 0, width, height);
+    // minimized windows report an empty framebuffer, keep the targets until it comes back
+    if (render_graph && width > 0 && height > 0)
+        render_graph->setResolution(width, height);
 }
 
 void processInput(GLFWwindow* window)
@@ -268,6 +1824,52 @@ void processInput(GLFWwindow* window)
     }
 }
 
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action != GLFW_PRESS)
+        return;
+
+    if (key >= GLFW_KEY_F1 && key < GLFW_KEY_F1 + k_render_path_count)
+    {
+        render_path = static_cast<RenderPath>(key - GLFW_KEY_F1);
+        std::cout << "Info: Render path "
+                  << k_render_path_names[static_cast<int>(render_path)] << std::endl;
+        reportPathAntiAliasing();
+    }
+    else if (key == GLFW_KEY_F5 && shadow_map)
+    {
+        shadow_map->setCaching(!shadow_map->isCaching());
+        std::cout << "Info: Shadow caching " << (shadow_map->isCaching() ? "on" : "off")
+                  << std::endl;
+    }
+    else if (key == GLFW_KEY_F6)
+    {
+        dynamic_resolution_enabled = !dynamic_resolution_enabled;
+        std::cout << "Info: Dynamic resolution " << (dynamic_resolution_enabled ? "on" : "off")
+                  << std::endl;
+    }
+    else if (key == GLFW_KEY_F7)
+    {
+        anti_aliasing = static_cast<AntiAliasing>((static_cast<int>(anti_aliasing) + 1) %
+                                                  k_anti_aliasing_count);
+        std::cout << "Info: Anti-aliasing "
+                  << k_anti_aliasing_names[static_cast<int>(anti_aliasing)] << std::endl;
+        reportPathAntiAliasing();
+    }
+    else if (key == GLFW_KEY_F8)
+    {
+        occlusion_mode = static_cast<OcclusionMode>((static_cast<int>(occlusion_mode) + 1) %
+                                                    k_occlusion_mode_count);
+        std::cout << "Info: Ambient occlusion "
+                  << k_occlusion_mode_names[static_cast<int>(occlusion_mode)] << std::endl;
+    }
+    else if (key == GLFW_KEY_F9)
+    {
+        lods_enabled = !lods_enabled;
+        std::cout << "Info: Levels of detail " << (lods_enabled ? "on" : "off") << std::endl;
+    }
+}
+
 uint32_t createTexture(const char* texture_file)
 {
     uint32_t texture;
@@ -281,8 +1883,18 @@ uint32_t createTexture(const char* texture_file)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     // glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, 8);
 
-    int      width, height, nrChannels;
-    uint8_t* data = stbi_load(texture_file, &width, &height, &nrChannels, 0);
+    int       width, height, nrChannels;
+    AssetFile file;
+    uint8_t*  data = nullptr;
+    if (file.open(texture_file))
+    {
+        data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.getData()),
+                                     static_cast<int>(file.getSize()),
+                                     &width,
+                                     &height,
+                                     &nrChannels,
+                                     0);
+    }
     if (data)
     {
         GLenum format = GL_RGB;
@@ -313,7 +1925,17 @@ uint32_t loadCubemap(std::vector<std::string> faces)
     int width, height, nr_channels;
     for (size_t index = 0; index < faces.size(); index++)
     {
-        unsigned char* data = stbi_load(faces[index].c_str(), &width, &height, &nr_channels, 0);
+        AssetFile      file;
+        unsigned char* data = nullptr;
+        if (file.open(faces[index]))
+        {
+            data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.getData()),
+                                         static_cast<int>(file.getSize()),
+                                         &width,
+                                         &height,
+                                         &nr_channels,
+                                         0);
+        }
         if (data)
         {
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + index,
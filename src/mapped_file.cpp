@@ -0,0 +1,104 @@
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // an empty file can't be mapped, the view keeps the mapping alive after both handles close
+    void* data = nullptr;
+    if (size.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+        {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    if (size.QuadPart > 0 && !data)
+        return false;
+
+    data_ = static_cast<const char*>(data);
+    size_ = static_cast<size_t>(size.QuadPart);
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(file, &status) != 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    void* data = nullptr;
+    if (status.st_size > 0)
+    {
+        data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED)
+            data = nullptr;
+        else
+            madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+    }
+    ::close(file);
+    if (status.st_size > 0 && !data)
+        return false;
+
+    data_ = static_cast<const char*>(data);
+    size_ = static_cast<size_t>(status.st_size);
+#endif
+
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (data_)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
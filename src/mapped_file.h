@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A file mapped read-only into memory for as long as the object lives. Pages are read on first
+// touch, so loaders can parse it in place from several threads without copying it first.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // returns false when the file can't be opened or mapped. An empty file opens with no data
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const
+    {
+        return open_;
+    }
+    const char* getData() const
+    {
+        return data_;
+    }
+    size_t getSize() const
+    {
+        return size_;
+    }
+
+private:
+    const char* data_ {nullptr};
+    size_t      size_ {0};
+    bool        open_ {false};
+};
@@ -1,20 +1,48 @@
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <utility>
+
 #include "mesh.h"
 #include "shader.h"
 
-Mesh::Mesh(const std::vector<Vertex>&   vertices,
-           const std::vector<uint32_t>& indices,
-           const std::vector<Texture>&  textures)
+Mesh::Mesh(std::vector<Vertex>          vertices,
+           std::vector<uint32_t>        indices,
+           const std::vector<Texture>&  textures,
+           const std::vector<uint32_t>& lod_indices,
+           const std::vector<MeshLod>&  lods,
+           std::vector<Meshlet>         meshlets)
 {
-    this->vertices = vertices;
-    this->indices  = indices;
+    this->vertices = std::move(vertices);
+    this->indices  = std::move(indices);
     this->textures = textures;
+    this->meshlets = std::move(meshlets);
+
+    if (this->meshlets.empty())
+        buildMeshlets(this->vertices, this->indices, this->meshlets);
 
-    setupMesh();
+    const uint32_t index_count = static_cast<uint32_t>(this->indices.size());
+    this->lods.push_back({0, index_count, 0.f});
+    for (const auto& lod : lods)
+    {
+        this->lods.push_back({index_count + lod.first_index, lod.index_count, lod.error});
+    }
+
+    if (!this->vertices.empty())
+    {
+        bounds_min = this->vertices[0].position;
+        bounds_max = this->vertices[0].position;
+        for (const auto& vertex : this->vertices)
+        {
+            bounds_min = glm::min(bounds_min, vertex.position);
+            bounds_max = glm::max(bounds_max, vertex.position);
+        }
+    }
+
+    setupMesh(lod_indices);
 }
 
-void Mesh::setupMesh()
+void Mesh::setupMesh(const std::vector<uint32_t>& lod_indices)
 {
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
@@ -25,9 +53,14 @@ void Mesh::setupMesh()
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
+    // the levels of detail after the full mesh
+    const size_t full_size = indices.size() * sizeof(uint32_t);
+    const size_t lod_size  = lod_indices.size() * sizeof(uint32_t);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), &indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, full_size + lod_size, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, full_size, indices.data());
+    if (lod_size > 0)
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, full_size, lod_size, lod_indices.data());
 
     // vertex positons
     glEnableVertexAttribArray(0);
@@ -43,10 +76,30 @@ void Mesh::setupMesh()
     glVertexAttribPointer(
         2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, texcoords));
 
+    // tangent frames
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(
+        3, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+
+    // skinning joints and weights
+    glEnableVertexAttribArray(5);
+    glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, bone_ids));
+    glEnableVertexAttribArray(6);
+    glVertexAttribPointer(
+        6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bone_weights));
+
+    // baked lightmap coords and vertex occlusion
+    glEnableVertexAttribArray(7);
+    glVertexAttribPointer(
+        7, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, lightmap_texcoords));
+    glEnableVertexAttribArray(8);
+    glVertexAttribPointer(
+        8, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, occlusion));
+
     glBindVertexArray(0);
 }
 
-void Mesh::Draw(Shader& shader)
+void Mesh::Draw(Shader& shader, uint32_t instance_count, uint32_t lod)
 {
     uint32_t diffuseNr  = 1;
     uint32_t specularNr = 1;
@@ -59,21 +112,44 @@ void Mesh::Draw(Shader& shader)
         if (textures[index].type == TextureType::_diffuse)
         {
             number = std::to_string(diffuseNr++);
-            name   = "diffuse";
+            name   = "texture_diffuse";
         }
         else if (textures[index].type == TextureType::_specular)
         {
             number = std::to_string(specularNr++);
-            name   = "specular";
+            name   = "texture_specular";
+        }
+        else
+        {
+            continue;
         }
 
-        shader.setFloat(("material." + name + number).c_str(), static_cast<float>(index));
+        shader.setInt(name + number, static_cast<int32_t>(index));
         glBindTexture(GL_TEXTURE_2D, textures[index].id);
     }
 
+    // samplers keep their unit from the previous mesh, lit shaders need to know when the specular
+    // one is stale
+    shader.setBool("hasSpecularMap", specularNr > 1);
+
     glActiveTexture(GL_TEXTURE0);
 
+    drawElements(instance_count, lod);
+}
+
+void Mesh::DrawGeometry(uint32_t instance_count, uint32_t lod) const
+{
+    drawElements(instance_count, lod);
+}
+
+void Mesh::drawElements(uint32_t instance_count, uint32_t lod) const
+{
+    const MeshLod& level = lods[std::min<size_t>(lod, lods.size() - 1)];
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, (uint32_t)indices.size(), GL_UNSIGNED_INT, 0);
+    glDrawElementsInstanced(GL_TRIANGLES,
+                            level.index_count,
+                            GL_UNSIGNED_INT,
+                            (void*)(level.first_index * sizeof(uint32_t)),
+                            instance_count);
     glBindVertexArray(0);
 }
@@ -6,6 +6,8 @@
 #include <string>
 #include <vector>
 
+#include "meshlet.h"
+
 class Shader;
 
 enum class TextureType
@@ -23,10 +25,22 @@ struct Vertex
     glm::vec3 position;
     glm::vec3 normal;
     glm::vec2 texcoords;
-    glm::vec3 tangent;
-    glm::vec3 bitangent;
-    int       bone_ids[MAX_BONE_INFLUENCE];
-    float     bone_weights[MAX_BONE_INFLUENCE];
+    // w is the handedness, bitangent = w * cross(normal, tangent). See generateTangents
+    glm::vec4 tangent {0.f};
+    // joints of the model's skeleton, unused influences have weight 0
+    int       bone_ids[MAX_BONE_INFLUENCE] {};
+    float     bone_weights[MAX_BONE_INFLUENCE] {};
+    // baked by the bake tool, see MeshCache. (0, 0) samples white in any lightmap
+    glm::vec2 lightmap_texcoords {0.f};
+    float     occlusion {1.f};
+};
+
+// a run of the index buffer, level 0 is the full mesh
+struct MeshLod
+{
+    uint32_t first_index {0};
+    uint32_t index_count {0};
+    float    error {0.f}; // bound of the distance to the full mesh, model units
 };
 
 struct Texture
@@ -43,16 +57,32 @@ public:
     std::vector<Vertex>   vertices;
     std::vector<uint32_t> indices;
     std::vector<Texture>  textures;
+    std::vector<MeshLod>  lods;     // coarser as they go, see buildLodChain
+    std::vector<Meshlet>  meshlets; // runs of the full mesh's indices, see buildMeshlets
+
+    // object space bounding box
+    glm::vec3 bounds_min {0.f};
+    glm::vec3 bounds_max {0.f};
+
+    // the indices of the levels after the first follow indices in the index buffer, the first
+    // index of each is an offset into lod_indices. The meshlets are built here when none are
+    // given, given ones must have been built over these indices
+    Mesh(std::vector<Vertex>          vertices,
+         std::vector<uint32_t>        indices,
+         const std::vector<Texture>&  textures,
+         const std::vector<uint32_t>& lod_indices = {},
+         const std::vector<MeshLod>&  lods        = {},
+         std::vector<Meshlet>         meshlets    = {});
 
-    Mesh(const std::vector<Vertex>&   vertices,
-         const std::vector<uint32_t>& indices,
-         const std::vector<Texture>&  textures);
+    void Draw(Shader& shader, uint32_t instance_count = 1, uint32_t lod = 0);
 
-    void Draw(Shader& shader);
+    // binds nothing but the vertex array, for depth-only passes
+    void DrawGeometry(uint32_t instance_count = 1, uint32_t lod = 0) const;
 
 private:
     // render data
     uint32_t VAO, VBO, EBO;
 
-    void setupMesh();
+    void setupMesh(const std::vector<uint32_t>& lod_indices);
+    void drawElements(uint32_t instance_count, uint32_t lod) const;
 };
@@ -0,0 +1,120 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "asset_file.h"
+#include "mesh_cache.h"
+
+static constexpr uint32_t k_magic   = 0x4853454d; // "MESH"
+static constexpr uint32_t k_version = 1;
+
+// every field is 4 bytes, the vertices are written as is
+static_assert(sizeof(MeshCacheVertex) == 16, "MeshCacheVertex must not be padded");
+
+template <typename T>
+static void writeArray(std::ofstream& file, const std::vector<T>& values)
+{
+    file.write(reinterpret_cast<const char*>(values.data()),
+               static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+// the cache read front to back, every read fails once it runs out
+struct CacheReader
+{
+    const char* data;
+    size_t      size;
+    size_t      offset {0};
+
+    bool read(void* values, size_t bytes)
+    {
+        if (bytes > size - offset)
+            return false;
+        memcpy(values, data + offset, bytes);
+        offset += bytes;
+        return true;
+    }
+};
+
+template <typename T>
+static bool readArray(CacheReader& file, std::vector<T>& values, uint32_t count)
+{
+    // a count past the end of the file is a broken one, not one to allocate for
+    if (count > (file.size - file.offset) / sizeof(T))
+        return false;
+    values.resize(count);
+    return file.read(values.data(), values.size() * sizeof(T));
+}
+
+bool MeshCache::load(const std::string& path)
+{
+    // out of the asset pack when it has the cache
+    AssetFile cache_file;
+    if (!cache_file.open(path))
+        return false;
+    CacheReader file {cache_file.getData(), cache_file.getSize()};
+
+    uint32_t header[5] = {};
+    if (!file.read(header, sizeof(header)) || header[0] != k_magic || header[1] != k_version)
+    {
+        std::cout << "ERROR::MESH_CACHE:: " << path << " is not a version " << k_version
+                  << " mesh cache, bake it again" << std::endl;
+        return false;
+    }
+
+    meshes.resize(header[2]);
+    lightmap_width  = header[3];
+    lightmap_height = header[4];
+
+    bool valid = true;
+    for (auto& mesh : meshes)
+    {
+        uint32_t counts[4] = {};
+        valid              = valid && file.read(counts, sizeof(counts));
+
+        mesh.source_vertex_count = counts[0];
+        mesh.source_index_count  = counts[1];
+        valid = valid && readArray(file, mesh.vertices, counts[2]) &&
+                readArray(file, mesh.indices, counts[3]);
+    }
+    valid = valid && readArray(file, lightmap, lightmap_width * lightmap_height);
+
+    if (!valid)
+    {
+        std::cout << "ERROR::MESH_CACHE:: " << path << " is truncated" << std::endl;
+        meshes.clear();
+        lightmap.clear();
+        lightmap_width  = 0;
+        lightmap_height = 0;
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshCache::save(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "ERROR::MESH_CACHE:: Failed to write " << path << std::endl;
+        return false;
+    }
+
+    const uint32_t header[5] = {
+        k_magic, k_version, static_cast<uint32_t>(meshes.size()), lightmap_width, lightmap_height};
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    for (const auto& mesh : meshes)
+    {
+        const uint32_t counts[4] = {mesh.source_vertex_count,
+                                    mesh.source_index_count,
+                                    static_cast<uint32_t>(mesh.vertices.size()),
+                                    static_cast<uint32_t>(mesh.indices.size())};
+        file.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+        writeArray(file, mesh.vertices);
+        writeArray(file, mesh.indices);
+    }
+    writeArray(file, lightmap);
+
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Baked data of a model, stored next to it as <model>.meshcache. The bake tool writes it, Model
+// applies it while loading. Meshes are listed in the order Model creates them. Lightmap charts
+// split vertices along their seams, so every mesh keeps its own vertex list (each one refers to
+// an imported vertex) and index buffer instead of patching the imported ones.
+struct MeshCacheVertex
+{
+    uint32_t  source;             // index of the imported vertex
+    glm::vec2 lightmap_texcoords; // (0, 0) is a white corner of the atlas
+    float     occlusion;          // baked ambient occlusion, 1 when the lightmap carries it
+};
+
+struct MeshCacheMesh
+{
+    // sizes of the imported mesh, a mismatch means the cache is stale
+    uint32_t source_vertex_count {0};
+    uint32_t source_index_count {0};
+
+    std::vector<MeshCacheVertex> vertices;
+    std::vector<uint32_t>        indices;
+};
+
+class MeshCache {
+public:
+    static std::string getPath(const std::string& model_path)
+    {
+        return model_path + ".meshcache";
+    }
+
+    std::vector<MeshCacheMesh> meshes;
+
+    // R8 occlusion atlas of the whole model, empty when only vertices were baked
+    uint32_t             lightmap_width {0};
+    uint32_t             lightmap_height {0};
+    std::vector<uint8_t> lightmap;
+
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+};
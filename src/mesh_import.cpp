@@ -0,0 +1,258 @@
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <numeric>
+
+#include "animation.h"
+#include "job_system.h"
+#include "mesh_cache.h"
+#include "mesh_import.h"
+#include "mesh_simplify.h"
+#include "mesh_weld.h"
+#include "tangent_space.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// swaps the imported vertices and indices for the baked ones. Returns false when the cache was
+// baked from a different version of the mesh
+static bool applyMeshCache(const MeshCacheMesh&   cached,
+                           std::vector<Vertex>&   vertices,
+                           std::vector<uint32_t>& indices)
+{
+    if (cached.source_vertex_count != vertices.size() ||
+        cached.source_index_count != indices.size())
+        return false;
+
+    std::vector<Vertex> baked_vertices;
+    baked_vertices.reserve(cached.vertices.size());
+    for (const auto& cached_vertex : cached.vertices)
+    {
+        if (cached_vertex.source >= vertices.size())
+            return false;
+
+        Vertex vertex             = vertices[cached_vertex.source];
+        vertex.lightmap_texcoords = cached_vertex.lightmap_texcoords;
+        vertex.occlusion          = cached_vertex.occlusion;
+        baked_vertices.push_back(vertex);
+    }
+    for (uint32_t index : cached.indices)
+    {
+        if (index >= baked_vertices.size())
+            return false;
+    }
+
+    vertices = std::move(baked_vertices);
+    indices  = cached.indices;
+    return true;
+}
+
+void transformMesh(const glm::mat4& transform, ImportedMesh& mesh)
+{
+    const NodeTransform node_transform(transform);
+    for (auto& vertex : mesh.vertices)
+    {
+        vertex.position = node_transform.transformPosition(vertex.position);
+        vertex.normal   = node_transform.transformNormal(vertex.normal);
+    }
+    node_transform.orientTriangles(mesh.indices);
+}
+
+// the vertices, skinning, indices and material of an Assimp mesh. Skinned vertices stay in the
+// bind space the skeleton moves them from
+static void extractMesh(const aiMesh*    mesh,
+                        const glm::mat4& transform,
+                        const Skeleton&  skeleton,
+                        ImportedMesh&    imported)
+{
+    std::vector<Vertex>&   vertices = imported.vertices;
+    std::vector<uint32_t>& indices  = imported.indices;
+
+    vertices.resize(mesh->mNumVertices);
+    for (uint32_t index = 0; index < mesh->mNumVertices; index++)
+    {
+        const aiVector3D& position = mesh->mVertices[index];
+
+        Vertex& vertex  = vertices[index];
+        vertex          = Vertex {};
+        vertex.position = glm::vec3(position.x, position.y, position.z);
+        vertex.normal   = glm::vec3(0.f);
+        if (mesh->HasNormals())
+        {
+            const aiVector3D& normal = mesh->mNormals[index];
+            vertex.normal            = glm::vec3(normal.x, normal.y, normal.z);
+        }
+
+        // a vertex can contain up to 8 different texture coordinates, only the first set is used
+        vertex.texcoords = glm::vec2(0.f);
+        if (mesh->mTextureCoords[0])
+        {
+            vertex.texcoords =
+                glm::vec2(mesh->mTextureCoords[0][index].x, mesh->mTextureCoords[0][index].y);
+        }
+    }
+
+    // skinning, the largest MAX_BONE_INFLUENCE weights of every vertex renormalized
+    for (uint32_t bone_index = 0; bone_index < mesh->mNumBones; bone_index++)
+    {
+        const aiBone* bone  = mesh->mBones[bone_index];
+        const int32_t joint = skeleton.findJoint(bone->mName.C_Str());
+        if (joint < 0)
+            continue;
+
+        for (uint32_t index = 0; index < bone->mNumWeights; index++)
+        {
+            const aiVertexWeight& weight = bone->mWeights[index];
+            Vertex&               vertex = vertices[weight.mVertexId];
+
+            int smallest = 0;
+            for (int slot = 1; slot < MAX_BONE_INFLUENCE; slot++)
+            {
+                if (vertex.bone_weights[slot] < vertex.bone_weights[smallest])
+                    smallest = slot;
+            }
+            if (weight.mWeight > vertex.bone_weights[smallest])
+            {
+                vertex.bone_ids[smallest]     = joint;
+                vertex.bone_weights[smallest] = weight.mWeight;
+            }
+        }
+    }
+    if (mesh->mNumBones > 0)
+    {
+        for (auto& vertex : vertices)
+        {
+            float total = 0.f;
+            for (float weight : vertex.bone_weights)
+            {
+                total += weight;
+            }
+            for (float& weight : vertex.bone_weights)
+            {
+                weight = total > 0.f ? weight / total : 0.f;
+            }
+        }
+    }
+
+    size_t index_count = 0;
+    for (uint32_t face = 0; face < mesh->mNumFaces; face++)
+    {
+        index_count += mesh->mFaces[face].mNumIndices;
+    }
+    indices.resize(index_count);
+    uint32_t* index = indices.data();
+    for (uint32_t face = 0; face < mesh->mNumFaces; face++)
+    {
+        index = std::copy_n(mesh->mFaces[face].mIndices, mesh->mFaces[face].mNumIndices, index);
+    }
+
+    imported.material = mesh->mMaterialIndex;
+    if (isMovedByNode(mesh, transform))
+        transformMesh(transform, imported);
+}
+
+// everything after the vertices and indices, on the jobs
+static void finishMesh(const MeshCacheMesh* cached, JobSystem& jobs, ImportedMesh& imported)
+{
+    std::vector<Vertex>&   vertices = imported.vertices;
+    std::vector<uint32_t>& indices  = imported.indices;
+
+    // baked lighting. Meshes the bake tool skipped have no vertices in the cache
+    if (cached && !cached->vertices.empty())
+        imported.stale_cache = !applyMeshCache(*cached, vertices, indices);
+
+    // Assimp splits the vertices per face corner without aiProcess_JoinIdenticalVertices. They
+    // are welded after the cache, whose vertices refer to the imported ones
+    Clock::time_point start    = Clock::now();
+    imported.imported_vertices = vertices.size();
+    weldVertices(vertices, indices, WeldSettings(), jobs);
+    imported.weld_seconds = secondsSince(start);
+
+    // MikkTSpace frames on the welded vertices, splitting the ones mirrored texture coords meet at
+    start = Clock::now();
+    generateTangents(vertices, indices, jobs);
+    imported.tangent_seconds = secondsSince(start);
+
+    // coarser versions for the distance, their indices index the same vertices
+    buildLodChain(vertices, indices, LodSettings(), imported.lod_indices, imported.lods);
+    buildMeshlets(vertices, indices, imported.meshlets);
+}
+
+// the mesh cache lists the meshes in the order they are created
+static const MeshCacheMesh* getCachedMesh(const MeshCache& mesh_cache, size_t mesh)
+{
+    return mesh < mesh_cache.meshes.size() ? &mesh_cache.meshes[mesh] : nullptr;
+}
+
+// runs mesh_job(mesh, jobs) for every mesh, the largest first so the last ones to finish are
+// short. Jobs can't start jobs, every one gets a single thread JobSystem of its own to weld and
+// generate its frames on. A mesh on its own gets all of the jobs
+template <typename MeshJob>
+static void runMeshJobs(const std::vector<size_t>& sizes, JobSystem& jobs, const MeshJob& mesh_job)
+{
+    if (sizes.size() == 1)
+    {
+        mesh_job(0, jobs);
+        return;
+    }
+
+    std::vector<uint32_t> order(sizes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    std::vector<std::unique_ptr<JobSystem>> thread_jobs(jobs.getThreadCount());
+    for (auto& thread_job : thread_jobs)
+    {
+        thread_job = std::make_unique<JobSystem>(1);
+    }
+    const uint32_t mesh_count = static_cast<uint32_t>(sizes.size());
+    jobs.parallelFor(mesh_count, 1, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+        for (uint32_t position = begin; position < end; position++)
+        {
+            mesh_job(order[position], *thread_jobs[thread]);
+        }
+    });
+}
+
+void importMeshes(const std::vector<const aiMesh*>& meshes,
+                  const std::vector<glm::mat4>&     transforms,
+                  const Skeleton&                   skeleton,
+                  const MeshCache&                  mesh_cache,
+                  JobSystem&                        jobs,
+                  std::vector<ImportedMesh>&        imported)
+{
+    imported.clear();
+    imported.resize(meshes.size());
+
+    std::vector<size_t> sizes(meshes.size());
+    for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        sizes[mesh] = meshes[mesh]->mNumVertices;
+    }
+    runMeshJobs(sizes, jobs, [&](uint32_t mesh, JobSystem& mesh_jobs) {
+        extractMesh(meshes[mesh], transforms[mesh], skeleton, imported[mesh]);
+        finishMesh(getCachedMesh(mesh_cache, mesh), mesh_jobs, imported[mesh]);
+    });
+}
+
+void finishMeshes(const MeshCache&           mesh_cache,
+                  JobSystem&                 jobs,
+                  std::vector<ImportedMesh>& imported)
+{
+    std::vector<size_t> sizes(imported.size());
+    for (size_t mesh = 0; mesh < imported.size(); mesh++)
+    {
+        sizes[mesh] = imported[mesh].vertices.size();
+    }
+    runMeshJobs(sizes, jobs, [&](uint32_t mesh, JobSystem& mesh_jobs) {
+        finishMesh(getCachedMesh(mesh_cache, mesh), mesh_jobs, imported[mesh]);
+    });
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+#include "node_transform.h"
+
+class JobSystem;
+class MeshCache;
+class Skeleton;
+struct aiMesh;
+struct aiScene;
+
+// everything Mesh needs of an imported mesh but its GL buffers and textures
+struct ImportedMesh
+{
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices; // reordered into meshlets
+    std::vector<uint32_t> lod_indices;
+    std::vector<MeshLod>  lods;
+    std::vector<Meshlet>  meshlets;
+
+    uint32_t material {0};
+    bool     stale_cache {false}; // the mesh cache was baked from a different version of it
+
+    size_t imported_vertices {0}; // before welding
+    double weld_seconds {0.0};
+    double tangent_seconds {0.0};
+};
+
+// converts the meshes on the jobs, one per job from the largest down: vertices and skinning,
+// meshes without bones moved by their node transform, baked lighting from the cache (which may
+// have no meshes), welding, tangent frames, levels of detail and meshlets. A mesh on its own gets
+// the jobs to itself. The output is the same for any number of threads
+void importMeshes(const std::vector<const aiMesh*>& meshes,
+                  const std::vector<glm::mat4>&     transforms,
+                  const Skeleton&                   skeleton,
+                  const MeshCache&                  mesh_cache,
+                  JobSystem&                        jobs,
+                  std::vector<ImportedMesh>&        imported);
+
+// moves the vertices of a mesh by the transform of its node, see NodeTransform
+void transformMesh(const glm::mat4& transform, ImportedMesh& mesh);
+
+// the rest of importMeshes for meshes another loader filled in the vertices, indices and
+// material of, one vertex per face corner like Assimp's so the mesh cache applies to them
+void finishMeshes(const MeshCache&           mesh_cache,
+                  JobSystem&                 jobs,
+                  std::vector<ImportedMesh>& imported);
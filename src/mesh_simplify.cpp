@@ -0,0 +1,696 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+
+#include "mesh_simplify.h"
+
+static constexpr uint32_t k_none = ~0u;     // no open edge
+static constexpr uint32_t k_many = ~0u - 1; // more than one open edge
+
+// a level that keeps more of the triangles of the one before isn't worth its memory
+static constexpr float k_stalled_reduction = 0.9f;
+
+// position, normal and texture coords, the space the attribute quadrics measure in
+static constexpr int k_dimensions = 8;
+
+enum class VertexKind : uint8_t
+{
+    _manifold, // one vertex, no open edges
+    _border,   // one vertex on a single open loop
+    _seam,     // two vertices meeting along an attribute discontinuity
+    _locked    // anything else, corners and non-manifold fans
+};
+
+// Garland-Heckbert quadric of squared distances to planes in the attribute space
+struct AttributeQuadric
+{
+    float a[k_dimensions * (k_dimensions + 1) / 2] {}; // upper triangle, row by row
+    float b[k_dimensions] {};
+    float c {0.f};
+
+    static int entry(int row, int column)
+    {
+        return row * k_dimensions - row * (row - 1) / 2 + column - row;
+    }
+
+    void add(const AttributeQuadric& other)
+    {
+        for (size_t index = 0; index < std::size(a); index++)
+        {
+            a[index] += other.a[index];
+        }
+        for (int index = 0; index < k_dimensions; index++)
+        {
+            b[index] += other.b[index];
+        }
+        c += other.c;
+    }
+
+    // the triangle spans a plane in the attribute space, the distance to it is measured in the
+    // directions it doesn't cover
+    void addTriangle(const float* p0, const float* p1, const float* p2, float weight)
+    {
+        float e1[k_dimensions], e2[k_dimensions];
+        float length1 = 0.f, projection = 0.f, length2 = 0.f;
+        for (int index = 0; index < k_dimensions; index++)
+        {
+            e1[index] = p1[index] - p0[index];
+            length1 += e1[index] * e1[index];
+        }
+        if (length1 <= 1e-20f)
+            return;
+        length1 = std::sqrt(length1);
+        for (int index = 0; index < k_dimensions; index++)
+        {
+            e1[index] /= length1;
+            projection += e1[index] * (p2[index] - p0[index]);
+        }
+        for (int index = 0; index < k_dimensions; index++)
+        {
+            e2[index] = p2[index] - p0[index] - projection * e1[index];
+            length2 += e2[index] * e2[index];
+        }
+        if (length2 <= 1e-20f)
+            return;
+        length2 = std::sqrt(length2);
+
+        float d1 = 0.f, d2 = 0.f, d0 = 0.f;
+        for (int index = 0; index < k_dimensions; index++)
+        {
+            e2[index] /= length2;
+            d1 += p0[index] * e1[index];
+            d2 += p0[index] * e2[index];
+            d0 += p0[index] * p0[index];
+        }
+
+        for (int row = 0; row < k_dimensions; row++)
+        {
+            for (int column = row; column < k_dimensions; column++)
+            {
+                const float identity = row == column ? 1.f : 0.f;
+                a[entry(row, column)] +=
+                    weight * (identity - e1[row] * e1[column] - e2[row] * e2[column]);
+            }
+            b[row] += weight * (d1 * e1[row] + d2 * e2[row] - p0[row]);
+        }
+        c += weight * (d0 - d1 * d1 - d2 * d2);
+    }
+
+    // a plane of the positions alone
+    void addPlane(const glm::vec3& normal, float distance, float weight)
+    {
+        for (int row = 0; row < 3; row++)
+        {
+            for (int column = row; column < 3; column++)
+            {
+                a[entry(row, column)] += weight * normal[row] * normal[column];
+            }
+            b[row] += weight * normal[row] * distance;
+        }
+        c += weight * distance * distance;
+    }
+
+    float evaluate(const float* point) const
+    {
+        float result = c;
+        for (int row = 0; row < k_dimensions; row++)
+        {
+            float sum = 0.5f * a[entry(row, row)] * point[row] + b[row];
+            for (int column = row + 1; column < k_dimensions; column++)
+            {
+                sum += a[entry(row, column)] * point[column];
+            }
+            result += 2.f * sum * point[row];
+        }
+        return result;
+    }
+};
+
+// sum of squared distances to planes in model units, every plane counts once so its square root
+// bounds the distance to any of them
+struct PlaneQuadric
+{
+    double xx {0.0}, xy {0.0}, xz {0.0}, yy {0.0}, yz {0.0}, zz {0.0};
+    double x {0.0}, y {0.0}, z {0.0}, c {0.0};
+
+    void addPlane(const glm::dvec3& normal, double distance)
+    {
+        xx += normal.x * normal.x;
+        xy += normal.x * normal.y;
+        xz += normal.x * normal.z;
+        yy += normal.y * normal.y;
+        yz += normal.y * normal.z;
+        zz += normal.z * normal.z;
+        x += normal.x * distance;
+        y += normal.y * distance;
+        z += normal.z * distance;
+        c += distance * distance;
+    }
+
+    void add(const PlaneQuadric& other)
+    {
+        xx += other.xx;
+        xy += other.xy;
+        xz += other.xz;
+        yy += other.yy;
+        yz += other.yz;
+        zz += other.zz;
+        x += other.x;
+        y += other.y;
+        z += other.z;
+        c += other.c;
+    }
+
+    double evaluate(const glm::dvec3& p) const
+    {
+        return p.x * (xx * p.x + 2.0 * (xy * p.y + xz * p.z + x)) +
+               p.y * (yy * p.y + 2.0 * (yz * p.z + y)) + p.z * (zz * p.z + 2.0 * z) + c;
+    }
+};
+
+static uint64_t edgeKey(uint32_t from, uint32_t to)
+{
+    return static_cast<uint64_t>(from) << 32 | to;
+}
+
+static bool hasEdge(const std::vector<uint64_t>& edges, uint32_t from, uint32_t to)
+{
+    return std::binary_search(edges.begin(), edges.end(), edgeKey(from, to));
+}
+
+// connectivity of the current triangles, rebuilt after every pass of collapses
+struct Topology
+{
+    std::vector<uint32_t>   wedge_head; // per position, first vertex of its list
+    std::vector<uint32_t>   wedge_next; // per vertex
+    std::vector<uint32_t>   open_out;   // per vertex, the end of its open edge, k_none or k_many
+    std::vector<uint32_t>   open_in;
+    std::vector<VertexKind> kinds; // per position
+    std::vector<uint32_t>   triangle_offsets; // per position, into triangles
+    std::vector<uint32_t>   triangles;        // around every position, in order
+};
+
+static void buildTopology(const std::vector<uint32_t>& indices,
+                          const std::vector<uint32_t>& position_ids,
+                          uint32_t                     position_count,
+                          Topology&                    topology)
+{
+    const uint32_t vertex_count   = static_cast<uint32_t>(position_ids.size());
+    const uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+    std::vector<uint64_t> vertex_edges, position_edges;
+    vertex_edges.reserve(indices.size());
+    position_edges.reserve(indices.size());
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t from = indices[triangle * 3 + corner];
+            const uint32_t to   = indices[triangle * 3 + (corner + 1) % 3];
+            vertex_edges.push_back(edgeKey(from, to));
+            position_edges.push_back(edgeKey(position_ids[from], position_ids[to]));
+        }
+    }
+    std::sort(vertex_edges.begin(), vertex_edges.end());
+    std::sort(position_edges.begin(), position_edges.end());
+
+    topology.kinds.assign(position_count, VertexKind::_manifold);
+    topology.wedge_head.assign(position_count, k_none);
+    topology.wedge_next.assign(vertex_count, k_none);
+    topology.open_out.assign(vertex_count, k_none);
+    topology.open_in.assign(vertex_count, k_none);
+
+    // an edge used twice the same way is non-manifold
+    for (size_t index = 0; index < vertex_edges.size(); index++)
+    {
+        const uint32_t from = static_cast<uint32_t>(vertex_edges[index] >> 32);
+        const uint32_t to   = static_cast<uint32_t>(vertex_edges[index]);
+        if (index > 0 && vertex_edges[index] == vertex_edges[index - 1])
+        {
+            topology.kinds[position_ids[from]] = VertexKind::_locked;
+            topology.kinds[position_ids[to]]   = VertexKind::_locked;
+        }
+        else if (!hasEdge(vertex_edges, to, from))
+        {
+            uint32_t& out = topology.open_out[from];
+            uint32_t& in  = topology.open_in[to];
+            out           = out == k_none ? to : k_many;
+            in            = in == k_none ? from : k_many;
+        }
+    }
+    for (size_t index = 1; index < position_edges.size(); index++)
+    {
+        if (position_edges[index] == position_edges[index - 1])
+        {
+            topology.kinds[position_edges[index] >> 32]                   = VertexKind::_locked;
+            topology.kinds[static_cast<uint32_t>(position_edges[index])] = VertexKind::_locked;
+        }
+    }
+
+    std::vector<uint8_t> referenced(vertex_count, 0);
+    for (uint32_t index : indices)
+    {
+        if (referenced[index])
+            continue;
+        referenced[index]            = 1;
+        topology.wedge_next[index]   = topology.wedge_head[position_ids[index]];
+        topology.wedge_head[position_ids[index]] = index;
+    }
+
+    const auto single = [](uint32_t vertex) { return vertex != k_none && vertex != k_many; };
+    for (uint32_t position = 0; position < position_count; position++)
+    {
+        VertexKind&    kind  = topology.kinds[position];
+        const uint32_t first = topology.wedge_head[position];
+        if (kind == VertexKind::_locked || first == k_none)
+            continue;
+
+        const uint32_t second = topology.wedge_next[first];
+        const uint32_t out    = topology.open_out[first];
+        const uint32_t in     = topology.open_in[first];
+        if (second == k_none)
+        {
+            if (out == k_none && in == k_none)
+                kind = VertexKind::_manifold;
+            else if (single(out) && single(in) &&
+                     !hasEdge(position_edges, position_ids[out], position) &&
+                     !hasEdge(position_edges, position, position_ids[in]))
+                kind = VertexKind::_border;
+            else
+                kind = VertexKind::_locked;
+        }
+        else if (topology.wedge_next[second] == k_none)
+        {
+            // the open edges of both vertices run along the same positions, the other way round
+            const uint32_t other_out = topology.open_out[second];
+            const uint32_t other_in  = topology.open_in[second];
+            if (single(out) && single(in) && single(other_out) && single(other_in) &&
+                position_ids[out] == position_ids[other_in] &&
+                position_ids[in] == position_ids[other_out] &&
+                hasEdge(position_edges, position_ids[out], position) &&
+                hasEdge(position_edges, position, position_ids[in]))
+                kind = VertexKind::_seam;
+            else
+                kind = VertexKind::_locked;
+        }
+        else
+        {
+            kind = VertexKind::_locked;
+        }
+    }
+
+    topology.triangle_offsets.assign(position_count + 1, 0);
+    for (uint32_t index : indices)
+    {
+        topology.triangle_offsets[position_ids[index] + 1]++;
+    }
+    for (uint32_t position = 0; position < position_count; position++)
+    {
+        topology.triangle_offsets[position + 1] += topology.triangle_offsets[position];
+    }
+    topology.triangles.resize(indices.size());
+    std::vector<uint32_t> cursors(topology.triangle_offsets.begin(),
+                                  topology.triangle_offsets.end() - 1);
+    for (uint32_t index = 0; index < indices.size(); index++)
+    {
+        topology.triangles[cursors[position_ids[indices[index]]]++] = index / 3;
+    }
+}
+
+// the vertex every vertex of position from moves to when it collapses into position to, false
+// when the collapse would tear the borders or seams
+static bool findTargets(const std::vector<uint32_t>& indices,
+                        const std::vector<uint32_t>& position_ids,
+                        const Topology&              topology,
+                        uint32_t                     from,
+                        uint32_t                     to,
+                        uint32_t                     (&sources)[2],
+                        uint32_t                     (&targets)[2],
+                        uint32_t&                    count)
+{
+    const VertexKind kind = topology.kinds[from];
+    if (kind == VertexKind::_locked)
+        return false;
+
+    count = 0;
+    for (uint32_t vertex = topology.wedge_head[from]; vertex != k_none;
+         vertex          = topology.wedge_next[vertex])
+    {
+        uint32_t target = k_none;
+        for (uint32_t offset = topology.triangle_offsets[from];
+             offset < topology.triangle_offsets[from + 1];
+             offset++)
+        {
+            const uint32_t* corners = &indices[topology.triangles[offset] * 3];
+            if (corners[0] != vertex && corners[1] != vertex && corners[2] != vertex)
+                continue;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                if (position_ids[corners[corner]] != to)
+                    continue;
+                if (target != k_none && target != corners[corner])
+                    return false;
+                target = corners[corner];
+            }
+        }
+        if (target == k_none)
+            return false;
+        if (kind != VertexKind::_manifold && target != topology.open_out[vertex] &&
+            target != topology.open_in[vertex])
+            return false;
+
+        sources[count] = vertex;
+        targets[count] = target;
+        count++;
+    }
+    return count > 0;
+}
+
+// moving position from onto position to must not turn any of the triangles left around it over
+static bool flipsTriangles(const std::vector<Vertex>&   vertices,
+                           const std::vector<uint32_t>& indices,
+                           const std::vector<uint32_t>& position_ids,
+                           const Topology&              topology,
+                           uint32_t                     from,
+                           const glm::vec3&             destination)
+{
+    for (uint32_t offset = topology.triangle_offsets[from];
+         offset < topology.triangle_offsets[from + 1];
+         offset++)
+    {
+        const uint32_t* corners = &indices[topology.triangles[offset] * 3];
+        glm::vec3       before[3], after[3];
+        bool            collapsing = false;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const uint32_t position = position_ids[corners[corner]];
+            before[corner]          = vertices[corners[corner]].position;
+            after[corner]           = position == from ? destination : before[corner];
+            collapsing |= position != from && after[corner] == destination;
+        }
+        if (collapsing)
+            continue;
+
+        const glm::vec3 normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+        const glm::vec3 normal_after  = glm::cross(after[1] - after[0], after[2] - after[0]);
+        const float     length_before = glm::length(normal_before);
+        const float     length_after  = glm::length(normal_after);
+        if (length_after == 0.f ||
+            glm::dot(normal_before, normal_after) < 0.25f * length_before * length_after)
+            return true;
+    }
+    return false;
+}
+
+struct Collapse
+{
+    float    cost;
+    uint32_t from; // positions
+    uint32_t to;
+};
+
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>&   vertices,
+                                   const std::vector<uint32_t>& indices,
+                                   size_t                       target_index_count,
+                                   const SimplifySettings&      settings,
+                                   float&                       error)
+{
+    error = 0.f;
+    if (vertices.empty() || indices.size() < 3)
+        return indices;
+    const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+
+    // vertices at the same position share one, the collapses move positions
+    std::map<std::array<float, 3>, uint32_t> welded_ids;
+    std::vector<uint32_t>                    position_ids(vertex_count);
+    std::vector<uint32_t>                    position_vertices;
+    glm::vec3                                bounds_min = vertices[0].position;
+    glm::vec3                                bounds_max = vertices[0].position;
+    for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        const glm::vec3& position = vertices[vertex].position;
+        auto             insert   = welded_ids.emplace(
+            std::array<float, 3> {position.x, position.y, position.z},
+            static_cast<uint32_t>(welded_ids.size()));
+        if (insert.second)
+            position_vertices.push_back(vertex);
+        position_ids[vertex] = insert.first->second;
+        bounds_min           = glm::min(bounds_min, position);
+        bounds_max           = glm::max(bounds_max, position);
+    }
+    const uint32_t position_count = static_cast<uint32_t>(position_vertices.size());
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (size_t index = 0; index + 2 < indices.size(); index += 3)
+    {
+        const uint32_t a = position_ids[indices[index + 0]];
+        const uint32_t b = position_ids[indices[index + 1]];
+        const uint32_t c = position_ids[indices[index + 2]];
+        if (a != b && b != c && c != a)
+            result.insert(result.end(), indices.begin() + index, indices.begin() + index + 3);
+    }
+
+    // positions relative to the bounds so the attribute weights don't depend on the model scale
+    const float diagonal  = glm::length(bounds_max - bounds_min);
+    const float scale     = diagonal > 0.f ? 1.f / diagonal : 1.f;
+    const float max_error = settings.max_error * diagonal;
+
+    std::vector<float> points(static_cast<size_t>(vertex_count) * k_dimensions);
+    for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        float*          point    = &points[static_cast<size_t>(vertex) * k_dimensions];
+        const glm::vec3 position = (vertices[vertex].position - bounds_min) * scale;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            point[axis]     = position[axis];
+            point[3 + axis] = vertices[vertex].normal[axis] * settings.normal_weight;
+        }
+        point[6] = vertices[vertex].texcoords.x * settings.texcoord_weight;
+        point[7] = vertices[vertex].texcoords.y * settings.texcoord_weight;
+    }
+
+    std::vector<AttributeQuadric> quadrics(vertex_count);
+    std::vector<PlaneQuadric>     plane_quadrics(position_count);
+    for (size_t index = 0; index < result.size(); index += 3)
+    {
+        const uint32_t* corners = &result[index];
+        const glm::vec3 p0      = vertices[corners[0]].position;
+        const glm::vec3 normal  = glm::cross(vertices[corners[1]].position - p0,
+                                            vertices[corners[2]].position - p0);
+        const float     length  = glm::length(normal);
+        if (length == 0.f)
+            continue;
+
+        // area weighted, so small triangles don't outweigh the large ones they sit next to
+        const float area = 0.5f * length * scale * scale;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            quadrics[corners[corner]].addTriangle(&points[corners[0] * k_dimensions],
+                                                  &points[corners[1] * k_dimensions],
+                                                  &points[corners[2] * k_dimensions],
+                                                  area);
+        }
+
+        const glm::dvec3 plane_normal = glm::dvec3(normal) / static_cast<double>(length);
+        const double     distance     = -glm::dot(plane_normal, glm::dvec3(p0));
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            plane_quadrics[position_ids[corners[corner]]].addPlane(plane_normal, distance);
+        }
+    }
+
+    Topology topology;
+    buildTopology(result, position_ids, position_count, topology);
+
+    // planes through the borders, across their triangles, keep them from pulling in
+    for (size_t index = 0; index < result.size(); index++)
+    {
+        const uint32_t from = result[index];
+        const uint32_t to   = result[index - index % 3 + (index + 1) % 3];
+        if (topology.open_out[from] != to ||
+            (topology.kinds[position_ids[from]] != VertexKind::_border &&
+             topology.kinds[position_ids[to]] != VertexKind::_border))
+            continue;
+
+        const uint32_t  other  = result[index - index % 3 + (index + 2) % 3];
+        const glm::vec3 p0     = vertices[from].position;
+        const glm::vec3 edge   = vertices[to].position - p0;
+        const glm::vec3 normal = glm::cross(edge, glm::cross(edge, vertices[other].position - p0));
+        const float     length = glm::length(normal);
+        if (length == 0.f)
+            continue;
+
+        const glm::vec3 plane_normal = normal / length;
+        const float     distance     = -glm::dot(plane_normal, (p0 - bounds_min) * scale);
+        const float     weight       = glm::dot(edge, edge) * scale * scale;
+        quadrics[from].addPlane(plane_normal, distance, weight);
+        quadrics[to].addPlane(plane_normal, distance, weight);
+
+        const glm::dvec3 model_normal(plane_normal);
+        const double     model_distance = -glm::dot(model_normal, glm::dvec3(p0));
+        plane_quadrics[position_ids[from]].addPlane(model_normal, model_distance);
+        plane_quadrics[position_ids[to]].addPlane(model_normal, model_distance);
+    }
+
+    std::vector<Collapse> collapses;
+    std::vector<uint64_t> edges;
+    std::vector<uint8_t>  touched(position_count);
+    std::vector<uint32_t> remap(vertex_count);
+    for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        remap[vertex] = vertex;
+    }
+
+    target_index_count -= target_index_count % 3;
+    while (result.size() > target_index_count)
+    {
+        // every edge once, both directions are tried
+        edges.clear();
+        for (size_t index = 0; index < result.size(); index++)
+        {
+            const uint32_t a = position_ids[result[index]];
+            const uint32_t b = position_ids[result[index - index % 3 + (index + 1) % 3]];
+            edges.push_back(edgeKey(std::min(a, b), std::max(a, b)));
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t edge : edges)
+        {
+            const uint32_t ends[2] = {static_cast<uint32_t>(edge >> 32),
+                                      static_cast<uint32_t>(edge)};
+            Collapse       best {0.f, k_none, k_none};
+            for (uint32_t end = 0; end < 2; end++)
+            {
+                uint32_t sources[2], targets[2], count;
+                if (!findTargets(
+                        result, position_ids, topology, ends[end], ends[1 - end], sources, targets,
+                        count))
+                    continue;
+
+                float cost = 0.f;
+                for (uint32_t wedge = 0; wedge < count; wedge++)
+                {
+                    const float* target = &points[targets[wedge] * k_dimensions];
+                    cost += quadrics[sources[wedge]].evaluate(target);
+                }
+                cost = std::max(cost, 0.f);
+                if (best.from == k_none || cost < best.cost)
+                    best = {cost, ends[end], ends[1 - end]};
+            }
+            if (best.from != k_none)
+                collapses.push_back(best);
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.cost < b.cost || (a.cost == b.cost && a.from < b.from);
+        });
+
+        // the cheapest collapses first, none of them sharing a triangle so their costs stay true.
+        // Half of what is left per pass, the later ones are better chosen on the mesh they leave
+        const size_t triangles_left = (result.size() - target_index_count) / 3;
+        const size_t pass_limit     = std::max<size_t>(triangles_left / 2, 1);
+        size_t       removed        = 0;
+        std::fill(touched.begin(), touched.end(), 0);
+        for (const Collapse& collapse : collapses)
+        {
+            if (touched[collapse.from] || touched[collapse.to])
+                continue;
+
+            uint32_t sources[2], targets[2], count;
+            findTargets(result,
+                        position_ids,
+                        topology,
+                        collapse.from,
+                        collapse.to,
+                        sources,
+                        targets,
+                        count);
+            const glm::vec3 destination = vertices[targets[0]].position;
+            if (flipsTriangles(
+                    vertices, result, position_ids, topology, collapse.from, destination))
+                continue;
+
+            const float collapse_error = static_cast<float>(std::sqrt(
+                std::max(plane_quadrics[collapse.from].evaluate(glm::dvec3(destination)), 0.0)));
+            if (collapse_error > max_error)
+                continue;
+
+            for (uint32_t wedge = 0; wedge < count; wedge++)
+            {
+                remap[sources[wedge]] = targets[wedge];
+                quadrics[targets[wedge]].add(quadrics[sources[wedge]]);
+            }
+            error = std::max(error, collapse_error);
+            plane_quadrics[collapse.to].add(plane_quadrics[collapse.from]);
+
+            for (uint32_t offset = topology.triangle_offsets[collapse.from];
+                 offset < topology.triangle_offsets[collapse.from + 1];
+                 offset++)
+            {
+                const uint32_t* corners  = &result[topology.triangles[offset] * 3];
+                bool            shared   = false;
+                for (uint32_t corner = 0; corner < 3; corner++)
+                {
+                    touched[position_ids[corners[corner]]] = 1;
+                    shared |= position_ids[corners[corner]] == collapse.to;
+                }
+                removed += shared ? 1 : 0;
+            }
+            if (removed >= pass_limit)
+                break;
+        }
+        if (removed == 0)
+            break;
+
+        size_t kept = 0;
+        for (size_t index = 0; index < result.size(); index += 3)
+        {
+            const uint32_t a = remap[result[index + 0]];
+            const uint32_t b = remap[result[index + 1]];
+            const uint32_t c = remap[result[index + 2]];
+            if (position_ids[a] == position_ids[b] || position_ids[b] == position_ids[c] ||
+                position_ids[c] == position_ids[a])
+                continue;
+            result[kept++] = a;
+            result[kept++] = b;
+            result[kept++] = c;
+        }
+        result.resize(kept);
+        buildTopology(result, position_ids, position_count, topology);
+    }
+    return result;
+}
+
+void buildLodChain(const std::vector<Vertex>&   vertices,
+                   const std::vector<uint32_t>& indices,
+                   const LodSettings&           settings,
+                   std::vector<uint32_t>&       lod_indices,
+                   std::vector<MeshLod>&        lods)
+{
+    std::vector<uint32_t> current     = indices;
+    float                 chain_error = 0.f;
+    for (uint32_t level = 1; level < settings.max_levels; level++)
+    {
+        const size_t triangle_count = current.size() / 3;
+        if (triangle_count <= settings.min_triangles)
+            break;
+
+        const size_t target = std::max<size_t>(
+            static_cast<size_t>(triangle_count * settings.reduction), settings.min_triangles);
+        float                 level_error = 0.f;
+        std::vector<uint32_t> simplified =
+            simplifyMesh(vertices, current, target * 3, settings.simplify, level_error);
+        if (simplified.size() > current.size() * k_stalled_reduction)
+            break;
+
+        chain_error += level_error;
+        lods.push_back({static_cast<uint32_t>(lod_indices.size()),
+                        static_cast<uint32_t>(simplified.size()),
+                        chain_error});
+        lod_indices.insert(lod_indices.end(), simplified.begin(), simplified.end());
+        current = std::move(simplified);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+struct SimplifySettings
+{
+    // weights of the attribute differences against the position ones, which are measured relative
+    // to the bounding box diagonal of the mesh
+    float normal_weight {0.5f};
+    float texcoord_weight {0.25f};
+    // collapses moving a position further from the planes around it than this fraction of the
+    // bounding box diagonal are skipped, the target may be missed
+    float max_error {0.02f};
+};
+
+struct LodSettings
+{
+    uint32_t max_levels {6};     // the full mesh included
+    float    reduction {0.5f};   // triangles of a level against the one before
+    uint32_t min_triangles {64}; // no level gets below
+    SimplifySettings simplify;
+};
+
+// Quadric error simplification by half-edge collapses, so the result indexes the same vertices.
+//
+// Vertices at the same position are welded for the topology: a position with open edges is a
+// border when it has one vertex and a seam when two vertices meet along an attribute
+// discontinuity. Borders and seams only collapse along themselves, anything more complex stays.
+// Collapses are ordered by quadrics over the positions, normals and texture coords of the
+// triangles around each vertex, with planes across the borders to keep them in place, and are
+// rejected when they would flip a triangle or move too far. They run in passes of independent
+// collapses until the index count reaches the target or nothing can collapse.
+//
+// error is set to a bound of how far the result is from the planes of the triangles it replaced,
+// in the units of the positions.
+std::vector<uint32_t> simplifyMesh(const std::vector<Vertex>&   vertices,
+                                   const std::vector<uint32_t>& indices,
+                                   size_t                       target_index_count,
+                                   const SimplifySettings&      settings,
+                                   float&                       error);
+
+// the levels of detail after the full mesh, each simplified from the one before so their errors
+// add up. Their indices are appended to lod_indices, first_index of each is an offset into it.
+// Stops early when a level can't get much smaller than the one before
+void buildLodChain(const std::vector<Vertex>&   vertices,
+                   const std::vector<uint32_t>& indices,
+                   const LodSettings&           settings,
+                   std::vector<uint32_t>&       lod_indices,
+                   std::vector<MeshLod>&        lods);
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#include "job_system.h"
+#include "mesh_weld.h"
+
+static constexpr uint32_t k_none       = ~0u; // empty slot
+static constexpr uint32_t k_batch_size = 1024;
+
+// quantized position, normal, texture coords, joints, weights, lightmap coords and occlusion of a
+// vertex
+static constexpr int k_key_size = 3 * 2 + 2 + 2 * MAX_BONE_INFLUENCE + 2 + 1;
+
+using WeldKey = std::array<int32_t, k_key_size>;
+
+static int32_t quantize(float value, float epsilon)
+{
+    if (epsilon <= 0.f)
+    {
+        int32_t bits;
+        value += 0.f; // -0 welds with 0
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+    const double steps = std::floor(static_cast<double>(value) / epsilon + 0.5);
+    return static_cast<int32_t>(std::clamp(steps, double(INT_MIN), double(INT_MAX)));
+}
+
+static uint32_t hashKey(const WeldKey& key)
+{
+    uint32_t hash = 2166136261u;
+    for (int32_t value : key)
+    {
+        hash = (hash ^ static_cast<uint32_t>(value)) * 16777619u;
+    }
+    // FNV over whole words leaves the low bits the table indexes with poorly mixed
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+void weldVertices(std::vector<Vertex>&   vertices,
+                  std::vector<uint32_t>& indices,
+                  const WeldSettings&    settings,
+                  JobSystem&             jobs)
+{
+    const uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+    if (vertex_count == 0)
+        return;
+
+    glm::vec3 bounds_min = vertices[0].position;
+    glm::vec3 bounds_max = bounds_min;
+    for (const auto& vertex : vertices)
+    {
+        bounds_min = glm::min(bounds_min, vertex.position);
+        bounds_max = glm::max(bounds_max, vertex.position);
+    }
+    const float position_epsilon =
+        settings.position_epsilon * glm::length(bounds_max - bounds_min);
+
+    std::vector<WeldKey>  keys(vertex_count);
+    std::vector<uint32_t> hashes(vertex_count);
+    jobs.parallelFor(vertex_count, k_batch_size, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t vertex = begin; vertex < end; vertex++)
+        {
+            const Vertex& source = vertices[vertex];
+            WeldKey&      key    = keys[vertex];
+            int           next   = 0;
+            const auto    add    = [&](float value, float epsilon) {
+                key[next++] = quantize(value, epsilon);
+            };
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                add(source.position[axis], position_epsilon);
+                add(source.normal[axis], settings.normal_epsilon);
+            }
+            for (int axis = 0; axis < 2; axis++)
+            {
+                add(source.texcoords[axis], settings.texcoord_epsilon);
+                add(source.lightmap_texcoords[axis], settings.lightmap_epsilon);
+            }
+            for (int slot = 0; slot < MAX_BONE_INFLUENCE; slot++)
+            {
+                key[next++] = source.bone_ids[slot];
+                add(source.bone_weights[slot], settings.weight_epsilon);
+            }
+            add(source.occlusion, settings.occlusion_epsilon);
+
+            hashes[vertex] = hashKey(key);
+        }
+    });
+
+    // linear probing in a table at most half full. A slot only ever goes from empty to a vertex
+    // and then to lower vertices of the same key, so concurrent inserts of one key meet in the
+    // same slot and every other key probes past it as before
+    uint32_t capacity = 1;
+    while (capacity < vertex_count * 2)
+    {
+        capacity *= 2;
+    }
+    const uint32_t mask = capacity - 1;
+
+    std::vector<std::atomic<uint32_t>> table(capacity);
+    std::vector<uint32_t>              slots(vertex_count);
+    jobs.parallelFor(capacity, k_batch_size * 4, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t slot = begin; slot < end; slot++)
+        {
+            table[slot].store(k_none, std::memory_order_relaxed);
+        }
+    });
+    jobs.parallelFor(vertex_count, k_batch_size, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t vertex = begin; vertex < end; vertex++)
+        {
+            uint32_t slot = hashes[vertex] & mask;
+            while (true)
+            {
+                uint32_t current = k_none;
+                if (table[slot].compare_exchange_strong(current, vertex))
+                    break;
+
+                if (hashes[current] == hashes[vertex] && keys[current] == keys[vertex])
+                {
+                    while (vertex < current && !table[slot].compare_exchange_weak(current, vertex))
+                    {
+                    }
+                    break;
+                }
+                slot = (slot + 1) & mask;
+            }
+            slots[vertex] = slot;
+        }
+    });
+
+    // the first vertex of every key keeps its place in the order, the lowest comes first so its
+    // new index is known when the others get to it
+    std::vector<uint32_t> remap(vertex_count);
+    uint32_t              welded_count = 0;
+    for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        const uint32_t first = table[slots[vertex]].load(std::memory_order_relaxed);
+        if (first == vertex)
+        {
+            remap[vertex]            = welded_count;
+            vertices[welded_count++] = vertices[vertex];
+        }
+        else
+        {
+            remap[vertex] = remap[first];
+        }
+    }
+    vertices.resize(welded_count);
+    if (welded_count == vertex_count)
+        return;
+
+    const uint32_t index_count = static_cast<uint32_t>(indices.size());
+    jobs.parallelFor(index_count, k_batch_size * 4, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t index = begin; index < end; index++)
+        {
+            indices[index] = remap[indices[index]];
+        }
+    });
+}
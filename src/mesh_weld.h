@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+class JobSystem;
+
+// how far apart two vertex attributes can be and still weld, 0 for bit exact. Attributes are
+// quantized to their epsilon, so values closer than it on either side of a step stay apart
+struct WeldSettings
+{
+    float position_epsilon {1e-6f}; // fraction of the bounding box diagonal
+    float normal_epsilon {1e-3f};
+    float texcoord_epsilon {1e-5f};
+    float weight_epsilon {1e-3f};    // bone weights, the joints must match exactly
+    float lightmap_epsilon {1e-5f};  // lightmap coords
+    float occlusion_epsilon {4e-3f}; // about a step of 8 bits, the bake traces duplicates apart
+};
+
+// merges the vertices whose attributes all quantize the same and remaps the indices to them.
+// Tangents are left out, generateTangents runs after. The first of every group is kept and the
+// order of the kept ones doesn't change. Keys and hashes are computed in parallel and inserted in
+// parallel into an open addressing table, where the lowest index of every key wins
+void weldVertices(std::vector<Vertex>&   vertices,
+                  std::vector<uint32_t>& indices,
+                  const WeldSettings&    settings,
+                  JobSystem&             jobs);
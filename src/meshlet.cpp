@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mesh.h"
+#include "meshlet.h"
+
+static constexpr uint32_t k_none = ~0u;
+
+// unused triangles looked at when a meshlet runs out of neighbours, meshes mostly list nearby
+// triangles close to each other
+static constexpr uint32_t k_search_window = 256;
+
+// cones wider than this are no use, they only cull from behind the surface
+static constexpr float k_min_cone_dot = 0.1f;
+
+static void computeBounds(const std::vector<Vertex>&    vertices,
+                          const std::vector<uint32_t>&  indices,
+                          const std::vector<glm::vec3>& normals,
+                          const std::vector<uint32_t>&  order,
+                          Meshlet&                      meshlet)
+{
+    const uint32_t first = meshlet.first_triangle * 3;
+    const uint32_t last  = first + meshlet.triangle_count * 3;
+
+    glm::vec3 bounds_min = vertices[indices[first]].position;
+    glm::vec3 bounds_max = bounds_min;
+    for (uint32_t index = first; index < last; index++)
+    {
+        bounds_min = glm::min(bounds_min, vertices[indices[index]].position);
+        bounds_max = glm::max(bounds_max, vertices[indices[index]].position);
+    }
+    meshlet.center = 0.5f * (bounds_min + bounds_max);
+    meshlet.radius = 0.f;
+    for (uint32_t index = first; index < last; index++)
+    {
+        const float distance = glm::length(vertices[indices[index]].position - meshlet.center);
+        meshlet.radius       = std::max(meshlet.radius, distance);
+    }
+
+    glm::vec3 normal_sum(0.f);
+    for (uint32_t triangle = 0; triangle < meshlet.triangle_count; triangle++)
+    {
+        normal_sum += normals[order[meshlet.first_triangle + triangle]];
+    }
+    const float length = glm::length(normal_sum);
+    meshlet.cone_cutoff = 1.f;
+    if (length <= 0.f)
+        return;
+
+    meshlet.cone_axis = normal_sum / length;
+    float min_dot     = 1.f;
+    for (uint32_t triangle = 0; triangle < meshlet.triangle_count; triangle++)
+    {
+        const glm::vec3& normal = normals[order[meshlet.first_triangle + triangle]];
+        // degenerate triangles have no normal and never draw
+        if (normal != glm::vec3(0.f))
+            min_dot = std::min(min_dot, glm::dot(normal, meshlet.cone_axis));
+    }
+    if (min_dot > k_min_cone_dot)
+        meshlet.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+}
+
+void buildMeshlets(const std::vector<Vertex>& vertices,
+                   std::vector<uint32_t>&     indices,
+                   std::vector<Meshlet>&      meshlets)
+{
+    meshlets.clear();
+    const uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (triangle_count == 0)
+        return;
+
+    // triangles around every vertex
+    std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+    std::vector<uint32_t> adjacency(triangle_count * 3);
+    for (uint32_t index = 0; index < triangle_count * 3; index++)
+    {
+        offsets[indices[index] + 1]++;
+    }
+    for (size_t vertex = 0; vertex < vertices.size(); vertex++)
+    {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (uint32_t index = 0; index < triangle_count * 3; index++)
+    {
+        adjacency[cursors[indices[index]]++] = index / 3;
+    }
+
+    std::vector<glm::vec3> centroids(triangle_count);
+    std::vector<glm::vec3> normals(triangle_count);
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        const glm::vec3& p0 = vertices[indices[triangle * 3 + 0]].position;
+        const glm::vec3& p1 = vertices[indices[triangle * 3 + 1]].position;
+        const glm::vec3& p2 = vertices[indices[triangle * 3 + 2]].position;
+        const glm::vec3  normal = glm::cross(p1 - p0, p2 - p0);
+        const float      length = glm::length(normal);
+
+        centroids[triangle] = (p0 + p1 + p2) / 3.f;
+        normals[triangle]   = length > 0.f ? normal / length : glm::vec3(0.f);
+    }
+
+    std::vector<uint8_t>  used(triangle_count, 0);
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> vertex_meshlet(vertices.size(), k_none); // last meshlet to use each
+    std::vector<uint32_t> meshlet_vertices;
+    order.reserve(triangle_count);
+    meshlet_vertices.reserve(Meshlet::k_max_vertices);
+
+    // vertices a triangle would add to the current meshlet
+    const auto new_vertices = [&](uint32_t triangle, uint32_t meshlet) {
+        const uint32_t* corners = &indices[triangle * 3];
+        uint32_t        count   = 0;
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            const bool repeated = (corner > 0 && corners[corner] == corners[0]) ||
+                                  (corner > 1 && corners[corner] == corners[1]);
+            if (!repeated && vertex_meshlet[corners[corner]] != meshlet)
+                count++;
+        }
+        return count;
+    };
+
+    uint32_t first_unused = 0;
+    while (order.size() < triangle_count)
+    {
+        while (used[first_unused])
+        {
+            first_unused++;
+        }
+
+        const uint32_t id = static_cast<uint32_t>(meshlets.size());
+        Meshlet        meshlet;
+        meshlet.first_triangle = static_cast<uint32_t>(order.size());
+        meshlet_vertices.clear();
+
+        glm::vec3 centroid_sum(0.f), normal_sum(0.f);
+        uint32_t  triangle = first_unused;
+        while (triangle != k_none)
+        {
+            used[triangle] = 1;
+            order.push_back(triangle);
+            meshlet.triangle_count++;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const uint32_t vertex = indices[triangle * 3 + corner];
+                if (vertex_meshlet[vertex] != id)
+                {
+                    vertex_meshlet[vertex] = id;
+                    meshlet_vertices.push_back(vertex);
+                }
+            }
+            centroid_sum += centroids[triangle];
+            normal_sum += normals[triangle];
+            if (meshlet.triangle_count == Meshlet::k_max_triangles)
+                break;
+
+            // the neighbour adding the fewest vertices, then the closest and most aligned one
+            const glm::vec3 center = centroid_sum / static_cast<float>(meshlet.triangle_count);
+            const glm::vec3 axis =
+                normal_sum != glm::vec3(0.f) ? glm::normalize(normal_sum) : glm::vec3(0.f);
+            uint32_t best_new   = 4;
+            float    best_score = 0.f;
+            triangle            = k_none;
+            for (uint32_t vertex : meshlet_vertices)
+            {
+                for (uint32_t offset = offsets[vertex]; offset < offsets[vertex + 1]; offset++)
+                {
+                    const uint32_t candidate = adjacency[offset];
+                    if (used[candidate])
+                        continue;
+                    const uint32_t added = new_vertices(candidate, id);
+                    if (meshlet_vertices.size() + added > Meshlet::k_max_vertices)
+                        continue;
+
+                    const float score = glm::length(centroids[candidate] - center) *
+                                        (2.f - glm::dot(normals[candidate], axis));
+                    if (added < best_new || (added == best_new && score < best_score))
+                    {
+                        triangle   = candidate;
+                        best_new   = added;
+                        best_score = score;
+                    }
+                }
+            }
+            if (triangle != k_none)
+                continue;
+
+            // nothing connected left, the nearest unused triangle when it is about as close as
+            // the meshlet is wide
+            float radius = 0.f;
+            for (uint32_t vertex : meshlet_vertices)
+            {
+                radius = std::max(radius, glm::length(vertices[vertex].position - center));
+            }
+            float    best_distance = 2.f * radius;
+            uint32_t scanned       = 0;
+            for (uint32_t candidate = first_unused;
+                 candidate < triangle_count && scanned < k_search_window;
+                 candidate++)
+            {
+                if (used[candidate])
+                    continue;
+                scanned++;
+                if (meshlet_vertices.size() + new_vertices(candidate, id) >
+                    Meshlet::k_max_vertices)
+                    continue;
+
+                const float distance = glm::length(centroids[candidate] - center);
+                if (distance <= best_distance)
+                {
+                    triangle      = candidate;
+                    best_distance = distance;
+                }
+            }
+        }
+
+        meshlet.vertex_count = static_cast<uint32_t>(meshlet_vertices.size());
+        meshlets.push_back(meshlet);
+    }
+
+    std::vector<uint32_t> reordered(triangle_count * 3);
+    for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            reordered[triangle * 3 + corner] = indices[order[triangle] * 3 + corner];
+        }
+    }
+    indices.swap(reordered);
+
+    for (auto& meshlet : meshlets)
+    {
+        computeBounds(vertices, indices, normals, order, meshlet);
+    }
+}
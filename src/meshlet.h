@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct Vertex;
+
+// A cluster of neighbouring triangles, a contiguous run of its mesh's index buffer, with the
+// bounds to cull it as a whole
+struct Meshlet
+{
+    static constexpr uint32_t k_max_vertices  = 64;
+    static constexpr uint32_t k_max_triangles = 124;
+
+    uint32_t first_triangle {0};
+    uint32_t triangle_count {0};
+    uint32_t vertex_count {0}; // distinct vertices of its triangles
+
+    // bounding sphere
+    glm::vec3 center {0.f};
+    float     radius {0.f};
+
+    // the normals of all triangles lie within a cone around the axis, the meshlet faces away from
+    // a viewer at p when dot(center - p, axis) >= cone_cutoff * length(center - p) + radius. A
+    // cutoff of 1 never culls
+    glm::vec3 cone_axis {0.f, 0.f, 1.f};
+    float     cone_cutoff {1.f};
+};
+
+// groups the triangles into meshlets of up to k_max_vertices vertices and k_max_triangles
+// triangles, growing each one over the triangles that add the fewest vertices and stay closest to
+// it. Reorders the triangles of indices so every meshlet is a run of them
+void buildMeshlets(const std::vector<Vertex>& vertices,
+                   std::vector<uint32_t>&     indices,
+                   std::vector<Meshlet>&      meshlets);
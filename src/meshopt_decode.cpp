@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "meshopt_decode.h"
+
+// the headers of the encodings, format version 0 for vertices, up to 1 for indices
+static constexpr uint8_t k_vertex_header   = 0xa0;
+static constexpr uint8_t k_triangle_header = 0xe0;
+static constexpr uint8_t k_sequence_header = 0xd0;
+
+static constexpr size_t k_vertex_block_bytes = 8192;
+static constexpr size_t k_vertex_block_max   = 256;
+static constexpr size_t k_byte_group_size    = 16;
+static constexpr size_t k_vertex_tail_min    = 32; // the first vertex, padded to at least this
+
+// vertices per block, the most that fit its bytes in whole groups
+static size_t getVertexBlockSize(size_t stride)
+{
+    const size_t size = (k_vertex_block_bytes / stride) & ~(k_byte_group_size - 1);
+    return std::min(size, k_vertex_block_max);
+}
+
+static uint8_t unzigzag(uint8_t value)
+{
+    return static_cast<uint8_t>((value >> 1) ^ (0u - (value & 1u)));
+}
+
+// the deltas of one byte of every vertex of a block: 2 bits of header per group of 16 choose
+// zeros, 2 or 4 bits per delta (the all-ones value escaping to a byte after the group) or 8 bits
+static const uint8_t* decodeBytes(const uint8_t* data,
+                                  const uint8_t* end,
+                                  uint8_t*       deltas,
+                                  size_t         delta_count)
+{
+    const size_t group_count = delta_count / k_byte_group_size;
+    const size_t header_size = (group_count + 3) / 4;
+    if (static_cast<size_t>(end - data) < header_size)
+        return nullptr;
+
+    const uint8_t* header = data;
+    data += header_size;
+    for (size_t group = 0; group < group_count; group++)
+    {
+        const int bits_log2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+        uint8_t*  output    = deltas + group * k_byte_group_size;
+        if (bits_log2 == 0)
+        {
+            memset(output, 0, k_byte_group_size);
+            continue;
+        }
+        if (bits_log2 == 3)
+        {
+            if (static_cast<size_t>(end - data) < k_byte_group_size)
+                return nullptr;
+            memcpy(output, data, k_byte_group_size);
+            data += k_byte_group_size;
+            continue;
+        }
+
+        // packed high bits first, the escaped values follow in order
+        const int      bits        = bits_log2 == 1 ? 2 : 4;
+        const uint8_t  escape      = static_cast<uint8_t>((1 << bits) - 1);
+        const size_t   packed_size = k_byte_group_size * bits / 8;
+        const uint8_t* escaped     = data + packed_size;
+        if (static_cast<size_t>(end - data) < packed_size)
+            return nullptr;
+
+        for (size_t index = 0; index < k_byte_group_size; index++)
+        {
+            const size_t bit   = index * bits;
+            uint8_t      value = (data[bit / 8] >> (8 - bits - bit % 8)) & escape;
+            if (value == escape)
+            {
+                if (escaped == end)
+                    return nullptr;
+                value = *escaped++;
+            }
+            output[index] = value;
+        }
+        data = escaped;
+    }
+    return data;
+}
+
+// the vertices of a block, every byte the one of the vertex before plus its delta. last holds the
+// bytes of the vertex before the block
+static const uint8_t* decodeVertexBlock(const uint8_t* data,
+                                        const uint8_t* end,
+                                        uint8_t*       vertices,
+                                        size_t         count,
+                                        size_t         stride,
+                                        uint8_t*       last)
+{
+    uint8_t      deltas[k_vertex_block_max];
+    const size_t delta_count = (count + k_byte_group_size - 1) & ~(k_byte_group_size - 1);
+    for (size_t byte = 0; byte < stride; byte++)
+    {
+        data = decodeBytes(data, end, deltas, delta_count);
+        if (!data)
+            return nullptr;
+
+        uint8_t value = last[byte];
+        for (size_t vertex = 0; vertex < count; vertex++)
+        {
+            value += unzigzag(deltas[vertex]);
+            vertices[vertex * stride + byte] = value;
+        }
+        last[byte] = value;
+    }
+    return data;
+}
+
+bool decodeMeshoptVertices(uint8_t*       destination,
+                           size_t         count,
+                           size_t         stride,
+                           const uint8_t* data,
+                           size_t         size)
+{
+    if (stride == 0 || stride > 256 || stride % 4 != 0 || size < 1 + stride ||
+        data[0] != k_vertex_header)
+        return false;
+
+    // the stream ends with the first vertex, the base of the first deltas
+    const uint8_t* end = data + size;
+    uint8_t        last[256];
+    memcpy(last, end - stride, stride);
+
+    const size_t block_size = getVertexBlockSize(stride);
+    data++;
+    for (size_t first = 0; first < count; first += block_size)
+    {
+        const size_t block_count = std::min(block_size, count - first);
+        uint8_t*     vertices    = destination + first * stride;
+
+        data = decodeVertexBlock(data, end, vertices, block_count, stride, last);
+        if (!data)
+            return false;
+    }
+    return static_cast<size_t>(end - data) == std::max(stride, k_vertex_tail_min);
+}
+
+// a variable length integer, 7 bits a byte with the high bit set on all but the last
+static uint32_t decodeVByte(const uint8_t*& data)
+{
+    const uint8_t lead = *data++;
+    if (lead < 128)
+        return lead;
+
+    uint32_t result = lead & 127;
+    uint32_t shift  = 7;
+    for (int byte = 0; byte < 4; byte++)
+    {
+        const uint8_t group = *data++;
+        result |= static_cast<uint32_t>(group & 127) << shift;
+        shift += 7;
+        if (group < 128)
+            break;
+    }
+    return result;
+}
+
+static uint32_t decodeIndex(const uint8_t*& data, uint32_t last)
+{
+    const uint32_t value = decodeVByte(data);
+    return last + ((value >> 1) ^ (0u - (value & 1u)));
+}
+
+static void writeIndex(uint8_t* destination, size_t index, size_t index_size, uint32_t value)
+{
+    if (index_size == 2)
+    {
+        const uint16_t short_value = static_cast<uint16_t>(value);
+        memcpy(destination + index * 2, &short_value, 2);
+    }
+    else
+    {
+        memcpy(destination + index * 4, &value, 4);
+    }
+}
+
+struct TriangleFifos
+{
+    uint32_t edges[16][2];
+    uint32_t vertices[16];
+    uint32_t edge_offset {0};
+    uint32_t vertex_offset {0};
+
+    // the vertex fifo only advances for vertices it didn't hold
+    void pushVertex(uint32_t vertex, bool advance = true)
+    {
+        vertices[vertex_offset] = vertex;
+        vertex_offset           = (vertex_offset + (advance ? 1 : 0)) & 15;
+    }
+    void pushEdge(uint32_t a, uint32_t b)
+    {
+        edges[edge_offset][0] = a;
+        edges[edge_offset][1] = b;
+        edge_offset           = (edge_offset + 1) & 15;
+    }
+};
+
+bool decodeMeshoptTriangles(uint8_t*       destination,
+                            size_t         count,
+                            size_t         index_size,
+                            const uint8_t* data,
+                            size_t         size)
+{
+    // a code byte per triangle, then the data bytes and a 16 byte table of common code pairs
+    if (count % 3 != 0 || (index_size != 2 && index_size != 4) || size < 1 + count / 3 + 16 ||
+        (data[0] & 0xf0) != k_triangle_header || (data[0] & 0x0f) > 1)
+        return false;
+
+    const int      version       = data[0] & 0x0f;
+    const uint8_t* code          = data + 1;
+    const uint8_t* extra         = code + count / 3;
+    const uint8_t* extra_end     = data + size - 16;
+    const uint8_t* code_pairs    = extra_end;
+    const int      fifo_code_max = version >= 1 ? 13 : 15;
+
+    TriangleFifos fifos;
+    memset(fifos.edges, 0xff, sizeof(fifos.edges));
+    memset(fifos.vertices, 0xff, sizeof(fifos.vertices));
+    uint32_t next = 0;
+    uint32_t last = 0;
+
+    for (size_t index = 0; index < count; index += 3)
+    {
+        // a free index takes at most 5 bytes, the table is there to read into
+        if (extra > extra_end)
+            return false;
+
+        const uint8_t triangle_code = *code++;
+        if (triangle_code < 0xf0)
+        {
+            // an edge from the fifo and its third vertex: the next new one, one from the fifo
+            // or a free index, given as a step of one from the last or a delta
+            const uint32_t* edge = fifos.edges[(fifos.edge_offset - 1 - (triangle_code >> 4)) & 15];
+            const uint32_t  a    = edge[0];
+            const uint32_t  b    = edge[1];
+            const int       fec  = triangle_code & 15;
+            uint32_t        c;
+            if (fec == 0)
+                c = next++;
+            else if (fec < fifo_code_max)
+                c = fifos.vertices[(fifos.vertex_offset - 1 - fec) & 15];
+            else if (fec != 15)
+                c = last = last + (fec == 13 ? -1 : 1);
+            else
+                c = last = decodeIndex(extra, last);
+
+            writeIndex(destination, index + 0, index_size, a);
+            writeIndex(destination, index + 1, index_size, b);
+            writeIndex(destination, index + 2, index_size, c);
+            fifos.pushVertex(c, fec == 0 || fec >= fifo_code_max);
+            fifos.pushEdge(c, b);
+            fifos.pushEdge(a, c);
+            continue;
+        }
+
+        // a triangle without a known edge, a is the next new vertex unless given as a free index.
+        // The codes of b and c come from the table or a data byte: 0 for the next new vertex, 15
+        // for a free index, the position in the vertex fifo otherwise
+        uint8_t code_pair;
+        bool    a_free = false;
+        if (triangle_code < 0xfe)
+        {
+            code_pair = code_pairs[triangle_code & 15];
+        }
+        else
+        {
+            code_pair = *extra++;
+            a_free    = triangle_code == 0xff;
+            // a pair of zeros outside the table restarts the vertices from 0
+            if (code_pair == 0)
+                next = 0;
+        }
+        const int feb = code_pair >> 4;
+        const int fec = code_pair & 15;
+
+        uint32_t a = a_free ? 0 : next++;
+        uint32_t b = feb == 0 ? next++ : fifos.vertices[(fifos.vertex_offset - feb) & 15];
+        uint32_t c = fec == 0 ? next++ : fifos.vertices[(fifos.vertex_offset - fec) & 15];
+        if (a_free)
+            a = last = decodeIndex(extra, last);
+        if (feb == 15)
+            b = last = decodeIndex(extra, last);
+        if (fec == 15)
+            c = last = decodeIndex(extra, last);
+
+        writeIndex(destination, index + 0, index_size, a);
+        writeIndex(destination, index + 1, index_size, b);
+        writeIndex(destination, index + 2, index_size, c);
+        fifos.pushVertex(a);
+        fifos.pushVertex(b, feb == 0 || feb == 15);
+        fifos.pushVertex(c, fec == 0 || fec == 15);
+        fifos.pushEdge(b, a);
+        fifos.pushEdge(c, b);
+        fifos.pushEdge(a, c);
+    }
+    return extra == extra_end;
+}
+
+bool decodeMeshoptIndices(uint8_t*       destination,
+                          size_t         count,
+                          size_t         index_size,
+                          const uint8_t* data,
+                          size_t         size)
+{
+    // at least a byte per index and a 4 byte tail to read into
+    if ((index_size != 2 && index_size != 4) || size < 1 + count + 4 ||
+        (data[0] & 0xf0) != k_sequence_header || (data[0] & 0x0f) > 1)
+        return false;
+
+    const uint8_t* end       = data + size - 4;
+    uint32_t       last[2]   = {0, 0};
+    data++;
+    for (size_t index = 0; index < count; index++)
+    {
+        if (data >= end)
+            return false;
+
+        // the low bit picks the baseline, the rest is the zigzag delta from it
+        const uint32_t value    = decodeVByte(data);
+        const uint32_t baseline = value & 1;
+        const uint32_t delta    = value >> 1;
+        last[baseline] += (delta >> 1) ^ (0u - (delta & 1u));
+        writeIndex(destination, index, index_size, last[baseline]);
+    }
+    return data == end;
+}
+
+template <typename T>
+static void decodeOctahedral(T* data, size_t count)
+{
+    // the third component holds the scale the first two are in
+    const float max = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+    for (size_t vector = 0; vector < count; vector++, data += 4)
+    {
+        float x = static_cast<float>(data[0]);
+        float y = static_cast<float>(data[1]);
+        float z = static_cast<float>(data[2]) - std::fabs(x) - std::fabs(y);
+
+        // fold the lower half back out of the corners of the octahedron
+        const float t = std::min(z, 0.f);
+        x += x >= 0.f ? t : -t;
+        y += y >= 0.f ? t : -t;
+
+        const float scale = max / std::sqrt(x * x + y * y + z * z);
+        data[0]           = static_cast<T>(std::lround(x * scale));
+        data[1]           = static_cast<T>(std::lround(y * scale));
+        data[2]           = static_cast<T>(std::lround(z * scale));
+    }
+}
+
+bool applyMeshoptOctahedralFilter(uint8_t* data, size_t count, size_t stride)
+{
+    if (stride == 4)
+        decodeOctahedral(reinterpret_cast<int8_t*>(data), count);
+    else if (stride == 8)
+        decodeOctahedral(reinterpret_cast<int16_t*>(data), count);
+    else
+        return false;
+    return true;
+}
+
+bool applyMeshoptExponentialFilter(uint8_t* data, size_t count, size_t stride)
+{
+    if (stride % 4 != 0)
+        return false;
+
+    // a signed 8 bit exponent over a signed 24 bit mantissa
+    uint32_t* values = reinterpret_cast<uint32_t*>(data);
+    for (size_t index = 0; index < count * stride / 4; index++)
+    {
+        const int32_t mantissa = static_cast<int32_t>(values[index] << 8) >> 8;
+        const int32_t exponent = static_cast<int32_t>(values[index]) >> 24;
+        const float   value    = std::ldexp(static_cast<float>(mantissa), exponent);
+        memcpy(&values[index], &value, 4);
+    }
+    return true;
+}
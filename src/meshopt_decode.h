@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Decoders for the buffer views of EXT_meshopt_compression, the formats meshoptimizer encodes and
+// gltfpack writes. Every one returns false when the data is not a valid encoding of count
+// elements of the given size, leaving destination partly written.
+
+// ATTRIBUTES mode: vertices of stride bytes (a multiple of 4 up to 256), delta coded byte by byte
+// in blocks that pack every group of 16 deltas into 0, 2, 4 or 8 bits each
+bool decodeMeshoptVertices(uint8_t*       destination,
+                           size_t         count,
+                           size_t         stride,
+                           const uint8_t* data,
+                           size_t         size);
+
+// TRIANGLES mode: count indices of index_size bytes (2 or 4) forming triangles, coded against a
+// FIFO of recent edges and one of recent vertices
+bool decodeMeshoptTriangles(uint8_t*       destination,
+                            size_t         count,
+                            size_t         index_size,
+                            const uint8_t* data,
+                            size_t         size);
+
+// INDICES mode: count indices of index_size bytes in any order, as deltas from two baselines
+bool decodeMeshoptIndices(uint8_t*       destination,
+                          size_t         count,
+                          size_t         index_size,
+                          const uint8_t* data,
+                          size_t         size);
+
+// the filters applied in place after ATTRIBUTES decoding. OCTAHEDRAL turns 4 byte or 4 short
+// octahedral encoded unit vectors back into plain ones, EXPONENTIAL turns shared exponent and
+// mantissa pairs back into floats. Return false for a stride the filter doesn't take
+bool applyMeshoptOctahedralFilter(uint8_t* data, size_t count, size_t stride);
+bool applyMeshoptExponentialFilter(uint8_t* data, size_t count, size_t stride);
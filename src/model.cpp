@@ -1,19 +1,166 @@
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <glad/glad.h>
 #include <stb_image/stb_image.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include <iostream>
 
+#include "asset_file.h"
+#include "async_io.h"
+#include "gltf_loader.h"
+#include "job_system.h"
+#include "mesh_import.h"
 #include "model.h"
+#include "obj_loader.h"
 #include "shader.h"
 
 uint32_t TextureFromFile(const char* path, const std::string& directory, bool gamma = false);
+static uint32_t uploadTexture(const unsigned char* data,
+                              int                  width,
+                              int                  height,
+                              int                  nr_components,
+                              const char*          path);
+
+// an asset file as Assimp reads it, read-only
+class AssetIOStream : public Assimp::IOStream {
+public:
+    bool open(const char* path)
+    {
+        return file_.open(path);
+    }
+
+    size_t Read(void* buffer, size_t size, size_t count) override
+    {
+        if (size == 0)
+            return 0;
+        count = std::min(count, (file_.getSize() - position_) / size);
+        memcpy(buffer, file_.getData() + position_, size * count);
+        position_ += size * count;
+        return count;
+    }
+    size_t Write(const void*, size_t, size_t) override
+    {
+        return 0;
+    }
+    // like Assimp's own streams, an offset from the end counts back from it
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        const size_t base = origin == aiOrigin_SET ? 0
+                            : origin == aiOrigin_CUR ? position_
+                                                     : file_.getSize();
+        if (origin == aiOrigin_END ? offset > base : offset > file_.getSize() - base)
+            return aiReturn_FAILURE;
+        position_ = origin == aiOrigin_END ? base - offset : base + offset;
+        return aiReturn_SUCCESS;
+    }
+    size_t Tell() const override
+    {
+        return position_;
+    }
+    size_t FileSize() const override
+    {
+        return file_.getSize();
+    }
+    void Flush() override {}
+
+private:
+    AssetFile file_;
+    size_t    position_ {0};
+};
+
+// the files Assimp opens, the model and the ones it names, out of the asset pack when mounted
+class AssetIOSystem : public Assimp::IOSystem {
+public:
+    bool Exists(const char* path) const override
+    {
+        return AssetFile::exists(path);
+    }
+    char getOsSeparator() const override
+    {
+        return '/';
+    }
+    Assimp::IOStream* Open(const char* path, const char* mode) override
+    {
+        if (strchr(mode, 'w') || strchr(mode, 'a'))
+            return nullptr;
+
+        auto* stream = new AssetIOStream();
+        if (!stream->open(path))
+        {
+            delete stream;
+            return nullptr;
+        }
+        return stream;
+    }
+    void Close(Assimp::IOStream* stream) override
+    {
+        delete stream;
+    }
+};
+
+// calls visit for every texture of a material: the diffuse, specular, normal and height maps, in
+// the order the meshes take them
+using TextureVisitor = std::function<void(const std::string& path, TextureType texture_type)>;
+
+static void forEachTexture(const aiMaterial* material, const TextureVisitor& visit)
+{
+    const auto visit_type = [&](aiTextureType ai_texture_type, TextureType texture_type) {
+        for (uint32_t index = 0; index < material->GetTextureCount(ai_texture_type); index++)
+        {
+            aiString str;
+            material->GetTexture(ai_texture_type, index, &str);
+            visit(str.C_Str(), texture_type);
+        }
+    };
+
+    // 1. diffuse maps
+    visit_type(aiTextureType_DIFFUSE, TextureType::_diffuse);
+    // 2. specular maps
+    visit_type(aiTextureType_SPECULAR, TextureType::_specular);
+    // 3. normal maps
+    visit_type(aiTextureType_NORMALS, TextureType::_normal);
+    // 4. height maps
+    visit_type(aiTextureType_AMBIENT, TextureType::_height);
+}
+
+static void forEachTexture(const ObjMaterial& material, const TextureVisitor& visit)
+{
+    if (!material.diffuse_map.empty())
+        visit(material.diffuse_map, TextureType::_diffuse);
+    if (!material.specular_map.empty())
+        visit(material.specular_map, TextureType::_specular);
+    if (!material.normal_map.empty())
+        visit(material.normal_map, TextureType::_normal);
+    if (!material.ambient_map.empty())
+        visit(material.ambient_map, TextureType::_height);
+}
+
+static void forEachTexture(const GltfMaterial& material, const TextureVisitor& visit)
+{
+    if (!material.base_color_map.empty())
+        visit(material.base_color_map, TextureType::_diffuse);
+    if (!material.normal_map.empty())
+        visit(material.normal_map, TextureType::_normal);
+}
 
-Model::Model(const char* path)
+Model::Model(const char*              path,
+             JobSystem&               jobs,
+             ModelLoader              loader,
+             const AsyncReadSettings& texture_reads)
+    : texture_reads_(texture_reads)
 {
-    loadModel(path);
+    loadModel(path, jobs, loader);
+    createLightmap();
+
+    mesh_cache_ = MeshCache();
 }
 
 Model::~Model()
@@ -22,167 +169,416 @@ Model::~Model()
     {
         delete mesh;
     }
+    glDeleteTextures(1, &lightmap_tex_);
 }
 
-void Model::Draw(Shader& shader)
+// marks a mesh culled in the selection
+static constexpr uint32_t k_lod_culled = ~0u;
+
+void Model::Draw(Shader& shader, uint32_t instance_count)
 {
-    for (auto* mesh : meshes_)
+    for (size_t index = 0; index < meshes_.size(); index++)
     {
-        mesh->Draw(shader);
+        const uint32_t lod = index < lod_selection_.size() ? lod_selection_[index] : 0;
+        if (lod != k_lod_culled)
+            meshes_[index]->Draw(shader, instance_count, lod);
     }
 }
 
-void Model::loadModel(std::string path)
+uint32_t Model::selectLods(const glm::mat4& model,
+                           const glm::vec3& camera_position,
+                           const glm::mat4& projection,
+                           float            viewport_height,
+                           float            pixel_error)
 {
-    Assimp::Importer importer;
-    const aiScene*   scene =
-        importer.ReadFile(path,
-                          aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals |
-                              aiProcess_CalcTangentSpace);
-
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    // pixels a model unit covers at a distance of one, at the largest scale of the transform
+    const float scale  = std::max(glm::length(glm::vec3(model[0])),
+                                 std::max(glm::length(glm::vec3(model[1])),
+                                          glm::length(glm::vec3(model[2]))));
+    const float pixels = 0.5f * viewport_height * projection[1][1] * scale;
+
+    uint32_t triangles = 0;
+    lod_selection_.resize(meshes_.size());
+    for (size_t index = 0; index < meshes_.size(); index++)
     {
-        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-        return;
-    }
+        const Mesh&     mesh     = *meshes_[index];
+        const glm::vec3 center   = 0.5f * (mesh.bounds_min + mesh.bounds_max);
+        const float     radius   = 0.5f * glm::length(mesh.bounds_max - mesh.bounds_min);
+        const float     distance =
+            glm::length(glm::vec3(model * glm::vec4(center, 1.f)) - camera_position);
 
-    directory_ = path.substr(0, path.find_last_of('/'));
+        if (2.f * radius * pixels < distance)
+        {
+            lod_selection_[index] = k_lod_culled;
+            continue;
+        }
 
-    processNode(scene->mRootNode, scene);
+        // the nearest point of the bounds sets the largest the error can get on screen
+        const float nearest = std::max(distance - radius * scale, 1e-4f);
+        uint32_t    lod     = 0;
+        while (lod + 1 < mesh.lods.size() &&
+               mesh.lods[lod + 1].error * pixels <= pixel_error * nearest)
+        {
+            lod++;
+        }
+        lod_selection_[index] = lod;
+        triangles += mesh.lods[lod].index_count / 3;
+    }
+    return triangles;
 }
 
-void Model::processNode(aiNode* node, const aiScene* scene)
+void Model::clearLods()
 {
-    for (uint32_t index = 0; index < node->mNumMeshes; index++)
+    lod_selection_.clear();
+}
+
+void Model::loadModel(std::string path, JobSystem& jobs, ModelLoader loader)
+{
+    directory_ = path.substr(0, path.find_last_of('/'));
+
+    const std::string cache_path = MeshCache::getPath(path);
+    if (mesh_cache_.load(cache_path))
+    {
+        std::cout << "Info: Baked lighting from " << cache_path
+                  << (mesh_cache_.lightmap.empty() ? ", vertex occlusion" : ", lightmap")
+                  << std::endl;
+    }
+
+    const auto has_extension = [&](const char* extension) {
+        const size_t length = strlen(extension);
+        return path.size() > length && path.compare(path.size() - length, length, extension) == 0;
+    };
+    bool loaded = false;
+    if (loader == ModelLoader::native && has_extension(".obj"))
+        loaded = loadObjFile(path, jobs);
+    else if (loader == ModelLoader::native && (has_extension(".gltf") || has_extension(".glb")))
+        loaded = loadGltfFile(path, jobs);
+    else
+        loaded = loadScene(path, jobs);
+
+    if (!loaded && loader == ModelLoader::native)
     {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[index]];
-        meshes_.push_back(processMesh(mesh, scene));
+        std::cout << "Info: Reading " << path << " with Assimp instead" << std::endl;
+        loadScene(path, jobs);
     }
 
-    for (uint32_t index = 0; index < node->mNumChildren; index++)
+    for (auto& decoded : decoded_textures_)
     {
-        processNode(node->mChildren[index], scene);
+        stbi_image_free(decoded.second.pixels);
     }
+    decoded_textures_.clear();
 }
 
-Mesh* Model::processMesh(aiMesh* mesh, const aiScene* scene)
+static double secondsSince(std::chrono::steady_clock::time_point start)
 {
-    std::vector<Vertex>   vertices;
-    std::vector<uint32_t> indices;
-    std::vector<Texture>  textures;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool Model::loadScene(const std::string& path, JobSystem& jobs)
+{
+    const auto       read_start = std::chrono::steady_clock::now();
+    Assimp::Importer importer;
+    importer.SetIOHandler(new AssetIOSystem());
+    const aiScene* scene =
+        importer.ReadFile(path,
+                          aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals);
 
-    for (uint32_t index = 0; index < mesh->mNumVertices; index++)
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
-        Vertex new_vertex;
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return false;
+    }
+    const double read_seconds = secondsSince(read_start);
 
-        // positions
-        new_vertex.position.x = mesh->mVertices[index].x;
-        new_vertex.position.y = mesh->mVertices[index].y;
-        new_vertex.position.z = mesh->mVertices[index].z;
+    if (importSkeleton(scene, skeleton_))
+    {
+        std::vector<AnimationClip> clips;
+        importClips(scene, skeleton_, clips);
 
-        // normals
-        if (mesh->HasNormals())
+        size_t raw_size        = 0;
+        size_t compressed_size = 0;
+        for (const auto& clip : clips)
         {
-            new_vertex.normal.x = mesh->mNormals[index].x;
-            new_vertex.normal.y = mesh->mNormals[index].y;
-            new_vertex.normal.z = mesh->mNormals[index].z;
+            clips_.push_back(compressClip(skeleton_, clip, CompressionSettings()));
+            raw_size += getMemoryUsage(clip);
+            compressed_size += clips_.back().getMemoryUsage();
         }
+        std::cout << "Info: " << skeleton_.getJointCount() << " joints, " << clips_.size()
+                  << " animations in " << path << ", " << compressed_size / 1024 << " KB from "
+                  << raw_size / 1024 << " KB of keys" << std::endl;
+    }
 
-        // texture coordinates
-        if (mesh->mTextureCoords[0])
-        {
-            // a vertex can contain up to 8 different texture coordinates. We thus make the
-            // assumption that we won't use models where a vertex can have multiple txture
-            // coordinates so we always take the first set (0).
-            new_vertex.texcoords.x = mesh->mTextureCoords[0][index].x;
-            new_vertex.texcoords.y = mesh->mTextureCoords[0][index].y;
-
-            // tangent
-            new_vertex.tangent.x = mesh->mTangents[index].x;
-            new_vertex.tangent.y = mesh->mTangents[index].y;
-
-            // bitangent
-            new_vertex.bitangent.x = mesh->mBitangents[index].x;
-            new_vertex.bitangent.y = mesh->mBitangents[index].y;
-        }
-        else
-        {
-            new_vertex.texcoords = glm::vec2(0.f, 0.f);
-        }
+    // the meshes are converted on the jobs, only their buffers and textures are made here
+    const auto                 import_start = std::chrono::steady_clock::now();
+    std::vector<const aiMesh*> scene_meshes;
+    std::vector<glm::mat4>     transforms;
+    std::vector<ImportedMesh>  imported;
+    collectMeshes(scene, scene_meshes, transforms);
+    importMeshes(scene_meshes, transforms, skeleton_, mesh_cache_, jobs, imported);
+    const double import_seconds = secondsSince(import_start);
+    reportImport(path, imported, "Assimp", read_seconds, import_seconds, jobs.getThreadCount());
+
+    std::vector<std::string> texture_paths;
+    for (const auto& mesh : imported)
+    {
+        if (mesh.material < scene->mNumMaterials)
+            forEachTexture(scene->mMaterials[mesh.material],
+                           [&](const std::string& texture_path, TextureType) {
+                               texture_paths.push_back(texture_path);
+                           });
+    }
+    decodeTextures(texture_paths, jobs);
 
-        vertices.push_back(new_vertex);
+    for (auto& mesh : imported)
+    {
+        std::vector<Texture> textures;
+        if (mesh.material < scene->mNumMaterials)
+            textures = loadMaterialTextures(scene->mMaterials[mesh.material]);
+        meshes_.push_back(createMesh(mesh, textures));
     }
+    return true;
+}
 
-    for (uint32_t index = 0; index < mesh->mNumFaces; index++)
+bool Model::loadObjFile(const std::string& path, JobSystem& jobs)
+{
+    const auto                read_start = std::chrono::steady_clock::now();
+    std::vector<ObjMaterial>  materials;
+    std::vector<ImportedMesh> imported;
+    if (!loadObj(path, jobs, materials, imported))
+        return false;
+    const double read_seconds = secondsSince(read_start);
+
+    // the meshes come out of the loader as Assimp's would, the rest of their import is the same.
+    // OBJ files have no skeleton
+    const auto import_start = std::chrono::steady_clock::now();
+    finishMeshes(mesh_cache_, jobs, imported);
+    const double import_seconds = secondsSince(import_start);
+    reportImport(
+        path, imported, "the OBJ loader", read_seconds, import_seconds, jobs.getThreadCount());
+
+    std::vector<std::string> texture_paths;
+    for (const auto& mesh : imported)
     {
-        for (uint32_t j = 0; j < mesh->mFaces[index].mNumIndices; j++)
-        {
-            indices.push_back(mesh->mFaces[index].mIndices[j]);
-        }
+        forEachTexture(materials[mesh.material], [&](const std::string& texture_path, TextureType) {
+            texture_paths.push_back(texture_path);
+        });
     }
+    decodeTextures(texture_paths, jobs);
 
-    // process materials
-    if (mesh->mMaterialIndex >= 0)
+    for (auto& mesh : imported)
     {
-        // we assume a convention for sampler names in the shaders. Each diffuse texture should be
-        // named as 'texture_diffuseN' where N is a sequential number ranging from 1 to
-        // MAX_SAMPLER_NUMBER. Same applies to other texture as the following list summarizes:
-        // diffuse: texture_diffuesN
-        // specular: texture_specularN
-        // normal: texture_normalN
+        meshes_.push_back(createMesh(mesh, loadMaterialTextures(materials[mesh.material])));
+    }
+    return true;
+}
 
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        // 1. diffuse maps
-        std::vector<Texture> diffuse_maps =
-            loadMaterialTextures(material, aiTextureType_DIFFUSE, TextureType::_diffuse);
-        textures.insert(textures.end(), diffuse_maps.begin(), diffuse_maps.end());
+bool Model::loadGltfFile(const std::string& path, JobSystem& jobs)
+{
+    const auto                read_start = std::chrono::steady_clock::now();
+    std::vector<GltfMaterial> materials;
+    std::vector<ImportedMesh> imported;
+    if (!loadGltf(path, jobs, materials, imported))
+        return false;
+    const double read_seconds = secondsSince(read_start);
+
+    // skinned files are left to Assimp, the meshes are already in model space
+    const auto import_start = std::chrono::steady_clock::now();
+    finishMeshes(mesh_cache_, jobs, imported);
+    const double import_seconds = secondsSince(import_start);
+    reportImport(
+        path, imported, "the glTF loader", read_seconds, import_seconds, jobs.getThreadCount());
+
+    std::vector<std::string> texture_paths;
+    for (const auto& mesh : imported)
+    {
+        forEachTexture(materials[mesh.material], [&](const std::string& texture_path, TextureType) {
+            texture_paths.push_back(texture_path);
+        });
+    }
+    decodeTextures(texture_paths, jobs);
 
-        // 2. specular maps
-        std::vector<Texture> specular_maps =
-            loadMaterialTextures(material, aiTextureType_SPECULAR, TextureType::_specular);
-        textures.insert(textures.end(), specular_maps.begin(), specular_maps.end());
+    for (auto& mesh : imported)
+    {
+        meshes_.push_back(createMesh(mesh, loadMaterialTextures(materials[mesh.material])));
+    }
+    return true;
+}
+
+void Model::reportImport(const std::string&               path,
+                         const std::vector<ImportedMesh>& imported,
+                         const char*                      reader,
+                         double                           read_seconds,
+                         double                           import_seconds,
+                         uint32_t                         thread_count)
+{
+    size_t imported_vertices = 0;
+    size_t vertex_count      = 0;
+    double weld_seconds      = 0.0;
+    double tangent_seconds   = 0.0;
+    for (const auto& mesh : imported)
+    {
+        imported_vertices += mesh.imported_vertices;
+        vertex_count += mesh.vertices.size();
+        weld_seconds += mesh.weld_seconds;
+        tangent_seconds += mesh.tangent_seconds;
+        stale_meshes_ += mesh.stale_cache ? 1 : 0;
+    }
 
-        // 3. normal maps
-        std::vector<Texture> normal_maps =
-            loadMaterialTextures(material, aiTextureType_NORMALS, TextureType::_normal);
-        textures.insert(textures.end(), normal_maps.begin(), normal_maps.end());
+    std::cout << "Info: Read " << path << " with " << reader << " in " << read_seconds * 1000.0
+              << " ms" << std::endl;
+    std::cout << "Info: Imported " << imported.size() << " meshes of " << path << " in "
+              << import_seconds * 1000.0 << " ms on " << thread_count << " threads, "
+              << imported_vertices << " vertices welded to " << vertex_count << " ("
+              << weld_seconds * 1000.0 << " ms welding, " << tangent_seconds * 1000.0
+              << " ms tangent frames summed over the meshes)" << std::endl;
 
-        // 4. height maps
-        std::vector<Texture> height_maps =
-            loadMaterialTextures(material, aiTextureType_AMBIENT, TextureType::_height);
-        textures.insert(textures.end(), height_maps.begin(), height_maps.end());
+    if (stale_meshes_ > 0)
+    {
+        std::cout << "ERROR::MESH_CACHE:: " << stale_meshes_ << " meshes don't match "
+                  << MeshCache::getPath(path) << ", bake it again" << std::endl;
     }
+}
+
+void Model::createLightmap()
+{
+    const bool    has_lightmap = !mesh_cache_.lightmap.empty();
+    const uint8_t white        = 255;
+
+    glGenTextures(1, &lightmap_tex_);
+    glBindTexture(GL_TEXTURE_2D, lightmap_tex_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_R8,
+                 has_lightmap ? mesh_cache_.lightmap_width : 1,
+                 has_lightmap ? mesh_cache_.lightmap_height : 1,
+                 0,
+                 GL_RED,
+                 GL_UNSIGNED_BYTE,
+                 has_lightmap ? mesh_cache_.lightmap.data() : &white);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
 
-    Mesh* new_mesh = new Mesh(vertices, indices, textures);
+Mesh* Model::createMesh(ImportedMesh& imported, const std::vector<Texture>& textures)
+{
+    return new Mesh(std::move(imported.vertices),
+                    std::move(imported.indices),
+                    textures,
+                    imported.lod_indices,
+                    imported.lods,
+                    std::move(imported.meshlets));
+}
 
-    return new_mesh;
+std::vector<Texture> Model::loadMaterialTextures(aiMaterial* material)
+{
+    // we assume a convention for sampler names in the shaders. Each diffuse texture should be
+    // named as 'texture_diffuseN' where N is a sequential number ranging from 1 to
+    // MAX_SAMPLER_NUMBER. Same applies to other texture as the following list summarizes:
+    // diffuse: texture_diffuesN
+    // specular: texture_specularN
+    // normal: texture_normalN
+    std::vector<Texture> textures;
+    forEachTexture(material, [&](const std::string& path, TextureType texture_type) {
+        loadMaterialTexture(path, texture_type, textures);
+    });
+    return textures;
 }
 
-std::vector<Texture>
-Model::loadMaterialTextures(aiMaterial* mat, uint32_t ai_texture_type, TextureType texture_type)
+std::vector<Texture> Model::loadMaterialTextures(const ObjMaterial& material)
 {
     std::vector<Texture> textures;
-    for (uint32_t index = 0;
-         index < mat->GetTextureCount(static_cast<aiTextureType>(ai_texture_type));
-         index++)
-    {
-        aiString str;
-        mat->GetTexture(static_cast<aiTextureType>(ai_texture_type), index, &str);
+    forEachTexture(material, [&](const std::string& path, TextureType texture_type) {
+        loadMaterialTexture(path, texture_type, textures);
+    });
+    return textures;
+}
 
-        if (isTextureLoaded(str.C_Str()))
+std::vector<Texture> Model::loadMaterialTextures(const GltfMaterial& material)
+{
+    std::vector<Texture> textures;
+    forEachTexture(material, [&](const std::string& path, TextureType texture_type) {
+        loadMaterialTexture(path, texture_type, textures);
+    });
+    return textures;
+}
+
+void Model::decodeTextures(const std::vector<std::string>& paths, JobSystem& jobs)
+{
+    // every texture once
+    std::vector<std::string> names;
+    std::vector<std::string> files;
+    for (const auto& path : paths)
+    {
+        if (isTextureLoaded(path) || !decoded_textures_.emplace(path, DecodedImage()).second)
             continue;
+        names.push_back(path);
+        files.push_back(directory_ + '/' + path);
+    }
+    if (files.empty())
+        return;
 
-        // new texture
-        Texture texture;
-        texture.id   = TextureFromFile(str.C_Str(), directory_);
-        texture.type = texture_type;
-        texture.path = str.C_Str();
-        textures.push_back(texture);
+    const auto      start = std::chrono::steady_clock::now();
+    AsyncFileReader reader(jobs, texture_reads_);
+
+    // the images are decoded into their own slots, the map is only written here
+    std::vector<DecodedImage> images(files.size());
+    std::atomic<size_t>       read_size {0};
+    reader.readFiles(files, [&](uint32_t index, const char* data, size_t size, uint32_t) {
+        if (!data)
+            return;
+        DecodedImage& image = images[index];
+        image.pixels        = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(data),
+                                                    static_cast<int>(size),
+                                                    &image.width,
+                                                    &image.height,
+                                                    &image.components,
+                                                    0);
+        read_size += size;
+    });
+    for (size_t index = 0; index < names.size(); index++)
+    {
+        decoded_textures_[names[index]] = images[index];
+    }
+
+    std::cout << "Info: " << files.size() << " textures, " << read_size / 1e6
+              << " MB, read and decoded in " << secondsSince(start) * 1e3 << " ms on "
+              << jobs.getThreadCount() << " threads, read with "
+              << (reader.getBackend() == AsyncReadBackend::io_uring ? "io_uring" : "the jobs")
+              << std::endl;
+}
 
-        loaded_textures_.push_back(texture);
+void Model::loadMaterialTexture(const std::string&    path,
+                                TextureType           texture_type,
+                                std::vector<Texture>& textures)
+{
+    if (isTextureLoaded(path))
+        return;
+
+    // new texture, decoded already unless it wasn't collected before the meshes
+    Texture    texture;
+    const auto decoded = decoded_textures_.find(path);
+    if (decoded != decoded_textures_.end())
+    {
+        const DecodedImage& image = decoded->second;
+        texture.id =
+            uploadTexture(image.pixels, image.width, image.height, image.components, path.c_str());
+        stbi_image_free(image.pixels);
+        decoded_textures_.erase(decoded);
     }
+    else
+    {
+        texture.id = TextureFromFile(path.c_str(), directory_);
+    }
+    texture.type = texture_type;
+    texture.path = path;
+    textures.push_back(texture);
 
-    return textures;
+    loaded_textures_.push_back(texture);
 }
 
 bool Model::isTextureLoaded(std::string texture_path) const
@@ -195,16 +591,16 @@ bool Model::isTextureLoaded(std::string texture_path) const
     return false;
 }
 
-uint32_t TextureFromFile(const char* path, const std::string& directory, bool gamma)
+// a texture of the pixels stb_image decoded, left empty with an error when there are none
+static uint32_t uploadTexture(const unsigned char* data,
+                              int                  width,
+                              int                  height,
+                              int                  nr_components,
+                              const char*          path)
 {
-    std::string filename = std::string(path);
-    filename             = directory + '/' + filename;
-
     unsigned int texture_id;
     glGenTextures(1, &texture_id);
 
-    int            width, height, nr_components;
-    unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nr_components, 0);
     if (data)
     {
         GLenum format;
@@ -223,14 +619,34 @@ uint32_t TextureFromFile(const char* path, const std::string& directory, bool ga
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
     }
     else
     {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
     }
 
     return texture_id;
-}
\ No newline at end of file
+}
+
+uint32_t TextureFromFile(const char* path, const std::string& directory, bool gamma)
+{
+    std::string filename = std::string(path);
+    filename             = directory + '/' + filename;
+
+    // decoded straight from the asset pack or the mapped file
+    AssetFile      file;
+    int            width = 0, height = 0, nr_components = 0;
+    unsigned char* data  = nullptr;
+    if (file.open(filename))
+    {
+        data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.getData()),
+                                     static_cast<int>(file.getSize()),
+                                     &width,
+                                     &height,
+                                     &nr_components,
+                                     0);
+    }
+    const uint32_t texture_id = uploadTexture(data, width, height, nr_components, path);
+    stbi_image_free(data);
+    return texture_id;
+}
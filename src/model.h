@@ -1,38 +1,134 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "animation_compression.h"
+#include "async_io.h"
 #include "mesh.h"
+#include "mesh_cache.h"
 
+class JobSystem;
 class Shader;
-struct aiNode;
-struct aiScene;
+struct GltfMaterial;
+struct ImportedMesh;
+struct ObjMaterial;
 struct aiMaterial;
-struct aiMesh;
+
+// what reads the model file. The native loaders read OBJ and glTF files without Assimp, see
+// loadObj and loadGltf, and leave every other format and the files they can't read to Assimp
+enum class ModelLoader
+{
+    assimp,
+    native
+};
 
 class Model {
 
 public:
-    Model(const char* path);
+    // the meshes are imported on the jobs, see importMeshes. The textures are read as
+    // texture_reads says, see decodeTextures
+    Model(const char*              path,
+          JobSystem&               jobs,
+          ModelLoader              loader        = ModelLoader::assimp,
+          const AsyncReadSettings& texture_reads = AsyncReadSettings());
     ~Model();
 
-    void Draw(Shader& shader);
+    void Draw(Shader& shader, uint32_t instance_count = 1);
+
+    // the coarsest level of every mesh whose error stays under pixel_error pixels on screen, or
+    // none for meshes smaller than a pixel. Draw keeps to the selection until the next one or
+    // clearLods. Returns the triangles it draws
+    uint32_t selectLods(const glm::mat4& model,
+                        const glm::vec3& camera_position,
+                        const glm::mat4& projection,
+                        float            viewport_height,
+                        float            pixel_error = 1.f);
+    void     clearLods();
+
+    const std::vector<Mesh*>& getMeshes() const
+    {
+        return meshes_;
+    }
+
+    // R8 lightmap from the mesh cache, or a 1x1 white texture when the model has none. Shaders
+    // multiply it into the ambient term at the baked lightmap coords of the vertices
+    uint32_t getLightmapTexture() const
+    {
+        return lightmap_tex_;
+    }
+
+    // empty for models without bones. The vertices of skinned meshes carry joint indices into it
+    const Skeleton& getSkeleton() const
+    {
+        return skeleton_;
+    }
+    const std::vector<CompressedClip>& getClips() const
+    {
+        return clips_;
+    }
 
 private:
+    // a texture decoded on a job ahead of its upload, without pixels when it can't be read
+    struct DecodedImage
+    {
+        unsigned char* pixels {nullptr};
+        int            width {0};
+        int            height {0};
+        int            components {0};
+    };
+
     // model data
-    std::vector<Mesh*>   meshes_;
-    std::string          directory_;
-    std::vector<Texture> loaded_textures_; // all textures loaded so far
-
-    void  loadModel(std::string path);
-    void  processNode(aiNode* node, const aiScene* scene);
-    Mesh* processMesh(aiMesh* mesh, const aiScene* scene);
-
-    // check all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    std::vector<Texture>
-    loadMaterialTextures(aiMaterial* mat, uint32_t ai_texture_type, TextureType texture_type);
+    std::vector<Mesh*>    meshes_;
+    std::string           directory_;
+    std::vector<Texture>  loaded_textures_; // all textures loaded so far
+    AsyncReadSettings     texture_reads_;
+    uint32_t              lightmap_tex_ {0};
+    std::vector<uint32_t> lod_selection_; // per mesh, empty draws the full meshes
+
+    Skeleton                    skeleton_;
+    std::vector<CompressedClip> clips_;
+
+    // baked data, only kept while loading
+    MeshCache mesh_cache_;
+    uint32_t  stale_meshes_ {0};
+    // by path, from decodeTextures until loadMaterialTexture uploads them
+    std::unordered_map<std::string, DecodedImage> decoded_textures_;
+
+    void loadModel(std::string path, JobSystem& jobs, ModelLoader loader);
+    // read the file and import its meshes on the jobs, then create them. Return false when the
+    // file can't be read, with an error
+    bool loadScene(const std::string& path, JobSystem& jobs);
+    bool loadObjFile(const std::string& path, JobSystem& jobs);
+    bool loadGltfFile(const std::string& path, JobSystem& jobs);
+    // the mesh statistics and the meshes the cache is stale for, before the meshes take their
+    // vertices
+    void reportImport(const std::string&               path,
+                      const std::vector<ImportedMesh>& imported,
+                      const char*                      reader,
+                      double                           read_seconds,
+                      double                           import_seconds,
+                      uint32_t                         thread_count);
+
+    // the GL side of an imported mesh, its buffers and material textures
+    Mesh* createMesh(ImportedMesh& imported, const std::vector<Texture>& textures);
+    void  createLightmap();
+
+    // check all textures of a material and loads the ones not loaded yet. the required info is
+    // returned as Texture structs.
+    std::vector<Texture> loadMaterialTextures(aiMaterial* material);
+    // the same for the maps of an MTL or glTF material, in the order of the Assimp ones
+    std::vector<Texture> loadMaterialTextures(const ObjMaterial& material);
+    std::vector<Texture> loadMaterialTextures(const GltfMaterial& material);
+    // reads the textures with an AsyncFileReader set up with texture_reads_ and decodes each on a
+    // job as soon as it is read, so loadMaterialTexture only uploads them. Runs before the meshes
+    // are created
+    void decodeTextures(const std::vector<std::string>& paths, JobSystem& jobs);
+    // loads the texture into textures unless it is loaded already
+    void loadMaterialTexture(const std::string&    path,
+                             TextureType           texture_type,
+                             std::vector<Texture>& textures);
 
     bool isTextureLoaded(std::string texture_path) const;
 };
\ No newline at end of file
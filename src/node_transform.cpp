@@ -0,0 +1,71 @@
+#include <assimp/scene.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <utility>
+
+#include "node_transform.h"
+
+static void collectNode(const aiNode*               node,
+                        const aiScene*              scene,
+                        const glm::mat4&            parent_transform,
+                        std::vector<const aiMesh*>& meshes,
+                        std::vector<glm::mat4>&     transforms)
+{
+    // Assimp's matrices are row major
+    const glm::mat4 transform =
+        parent_transform * glm::transpose(glm::make_mat4(&node->mTransformation.a1));
+    for (uint32_t index = 0; index < node->mNumMeshes; index++)
+    {
+        meshes.push_back(scene->mMeshes[node->mMeshes[index]]);
+        transforms.push_back(transform);
+    }
+    for (uint32_t index = 0; index < node->mNumChildren; index++)
+    {
+        collectNode(node->mChildren[index], scene, transform, meshes, transforms);
+    }
+}
+
+void collectMeshes(const aiScene*              scene,
+                   std::vector<const aiMesh*>& meshes,
+                   std::vector<glm::mat4>&     transforms)
+{
+    meshes.clear();
+    transforms.clear();
+    if (scene->mRootNode)
+        collectNode(scene->mRootNode, scene, glm::mat4(1.f), meshes, transforms);
+}
+
+bool isMovedByNode(const aiMesh* mesh, const glm::mat4& transform)
+{
+    return mesh->mNumBones == 0 && transform != glm::mat4(1.f);
+}
+
+NodeTransform::NodeTransform(const glm::mat4& transform) :
+    transform_(transform),
+    normal_transform_(glm::transpose(glm::inverse(glm::mat3(transform)))),
+    mirroring_(glm::determinant(glm::mat3(transform)) < 0.f)
+{
+}
+
+glm::vec3 NodeTransform::transformPosition(const glm::vec3& position) const
+{
+    return glm::vec3(transform_ * glm::vec4(position, 1.f));
+}
+
+glm::vec3 NodeTransform::transformNormal(const glm::vec3& normal) const
+{
+    const glm::vec3 transformed = normal_transform_ * normal;
+    const float     length      = glm::length(transformed);
+    return length > 0.f ? transformed / length : transformed;
+}
+
+void NodeTransform::orientTriangles(std::vector<uint32_t>& indices) const
+{
+    if (!mirroring_)
+        return;
+
+    for (size_t triangle = 0; triangle + 2 < indices.size(); triangle += 3)
+    {
+        std::swap(indices[triangle + 1], indices[triangle + 2]);
+    }
+}
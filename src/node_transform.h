@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+struct aiMesh;
+struct aiScene;
+
+// The placement of imported meshes by their nodes, GPU-free so the baker moves the meshes it
+// bakes exactly like the meshes the cache is applied to are moved at import. Both have to agree
+// to the bit, or the cached indices no longer match the meshes
+
+// the meshes of the nodes depth first, a node's own before its children's, and the transform of
+// each node to the root. The order Model creates them in, which the mesh cache follows
+void collectMeshes(const aiScene*              scene,
+                   std::vector<const aiMesh*>& meshes,
+                   std::vector<glm::mat4>&     transforms);
+
+// whether a mesh is moved by the transform of its node. Skinned meshes stay in the bind space the
+// skeleton moves them from
+bool isMovedByNode(const aiMesh* mesh, const glm::mat4& transform);
+
+// moves positions by the transform of a node, normals by its inverse transpose. A mirroring
+// transform turns the triangles around so they keep facing the same side
+class NodeTransform {
+public:
+    explicit NodeTransform(const glm::mat4& transform);
+
+    glm::vec3 transformPosition(const glm::vec3& position) const;
+    // renormalized, zero normals stay zero
+    glm::vec3 transformNormal(const glm::vec3& normal) const;
+
+    // swaps the last two corners of every triangle when the transform mirrors
+    void orientTriangles(std::vector<uint32_t>& indices) const;
+
+private:
+    glm::mat4 transform_;
+    glm::mat3 normal_transform_;
+    bool      mirroring_;
+};
@@ -0,0 +1,257 @@
+// CPU benchmark of the native OBJ loader against Assimp, no GPU needed. Reads every model with
+// Assimp the way Model does, Sponza and the backpack by default, then with loadObj on 1, 2, 4, ...
+// threads up to every thread. Reports the time and speedup of each, checks the loader gives the
+// same meshes on every thread count and the meshes Assimp gives, and times the whole import of
+// both, finishMeshes after the loader and importMeshes after Assimp:
+//   obj_benchmark [models] [options]
+//     --runs <n>       reads timed per loader and thread count, the fastest counts (default 3)
+//     --threads <n>    most threads to try, 0 for all (default)
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "animation.h"
+#include "job_system.h"
+#include "mesh_cache.h"
+#include "mesh_import.h"
+#include "obj_loader.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static bool sameMeshes(const std::vector<ImportedMesh>& a, const std::vector<ImportedMesh>& b)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (size_t mesh = 0; mesh < a.size(); mesh++)
+    {
+        if (a[mesh].material != b[mesh].material || a[mesh].indices != b[mesh].indices ||
+            a[mesh].vertices.size() != b[mesh].vertices.size() ||
+            memcmp(a[mesh].vertices.data(),
+                   b[mesh].vertices.data(),
+                   a[mesh].vertices.size() * sizeof(Vertex)) != 0)
+            return false;
+    }
+    return true;
+}
+
+// the largest differences of the loader's vertices from Assimp's, false when the meshes differ in
+// count or size
+static bool compareWithAssimp(const std::vector<const aiMesh*>& meshes,
+                              const std::vector<ImportedMesh>&  loaded,
+                              float&                            position_difference,
+                              float&                            normal_difference,
+                              float&                            texcoord_difference,
+                              size_t&                           different_triangles)
+{
+    position_difference = normal_difference = texcoord_difference = 0.f;
+    different_triangles                                           = 0;
+    if (meshes.size() != loaded.size())
+        return false;
+
+    for (size_t index = 0; index < meshes.size(); index++)
+    {
+        const aiMesh*       mesh     = meshes[index];
+        const ImportedMesh& imported = loaded[index];
+        if (mesh->mNumVertices != imported.vertices.size())
+            return false;
+
+        for (uint32_t vertex = 0; vertex < mesh->mNumVertices; vertex++)
+        {
+            const Vertex&     target   = imported.vertices[vertex];
+            const aiVector3D& position = mesh->mVertices[vertex];
+            const glm::vec3   source_position(position.x, position.y, position.z);
+            position_difference =
+                std::max(position_difference, glm::length(target.position - source_position));
+            if (mesh->HasNormals())
+            {
+                const aiVector3D& normal = mesh->mNormals[vertex];
+                const glm::vec3   source_normal(normal.x, normal.y, normal.z);
+                normal_difference =
+                    std::max(normal_difference, glm::length(target.normal - source_normal));
+            }
+            if (mesh->mTextureCoords[0])
+            {
+                const aiVector3D& texcoords = mesh->mTextureCoords[0][vertex];
+                const glm::vec2   source_texcoords(texcoords.x, texcoords.y);
+                texcoord_difference =
+                    std::max(texcoord_difference, glm::length(target.texcoords - source_texcoords));
+            }
+        }
+
+        size_t index_count = 0;
+        for (uint32_t face = 0; face < mesh->mNumFaces; face++)
+        {
+            index_count += mesh->mFaces[face].mNumIndices;
+        }
+        if (index_count != imported.indices.size())
+            return false;
+
+        const uint32_t* indices = imported.indices.data();
+        for (uint32_t face = 0; face < mesh->mNumFaces; face++, indices += 3)
+        {
+            const aiFace& triangle = mesh->mFaces[face];
+            different_triangles += std::equal(indices, indices + 3, triangle.mIndices) ? 0 : 1;
+        }
+    }
+    return true;
+}
+
+static bool benchmark(const std::string& model_path, uint32_t run_count, uint32_t max_threads)
+{
+    // Assimp reads on one thread whatever the count, every read frees the scene before
+    Assimp::Importer importer;
+    const aiScene*   scene          = nullptr;
+    double           assimp_seconds = 0.0;
+    for (uint32_t run = 0; run < run_count; run++)
+    {
+        const Clock::time_point start = Clock::now();
+        scene                         = importer.ReadFile(
+            model_path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals);
+        const double run_seconds = secondsSince(start);
+        if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+        {
+            std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+            return false;
+        }
+        assimp_seconds = run == 0 ? run_seconds : std::min(assimp_seconds, run_seconds);
+    }
+
+    std::vector<const aiMesh*> meshes;
+    std::vector<glm::mat4>     transforms;
+    collectMeshes(scene, meshes, transforms);
+    size_t vertex_count = 0;
+    for (const aiMesh* mesh : meshes)
+    {
+        vertex_count += mesh->mNumVertices;
+    }
+    std::cout << "Info: " << model_path << ", " << meshes.size() << " meshes, " << vertex_count
+              << " vertices, read by Assimp in " << assimp_seconds * 1e3 << " ms" << std::endl;
+
+    std::vector<uint32_t> thread_counts;
+    for (uint32_t threads = 1; threads < max_threads; threads *= 2)
+    {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::vector<ImportedMesh> reference;
+    double                    single_thread_seconds = 0.0;
+    for (uint32_t threads : thread_counts)
+    {
+        JobSystem                 jobs(threads);
+        std::vector<ObjMaterial>  materials;
+        std::vector<ImportedMesh> loaded;
+        double                    seconds = 0.0;
+        for (uint32_t run = 0; run < run_count; run++)
+        {
+            const Clock::time_point start = Clock::now();
+            if (!loadObj(model_path, jobs, materials, loaded))
+                return false;
+            const double run_seconds = secondsSince(start);
+            seconds                  = run == 0 ? run_seconds : std::min(seconds, run_seconds);
+        }
+
+        if (reference.empty())
+        {
+            reference             = std::move(loaded);
+            single_thread_seconds = seconds;
+        }
+        else if (!sameMeshes(reference, loaded))
+        {
+            std::cout << "ERROR::OBJ:: meshes differ between thread counts" << std::endl;
+            return false;
+        }
+
+        std::cout << "Info:   " << jobs.getThreadCount() << " threads: " << seconds * 1e3
+                  << " ms, " << single_thread_seconds / seconds << "x, "
+                  << assimp_seconds / seconds << "x Assimp" << std::endl;
+    }
+
+    float  position_difference;
+    float  normal_difference;
+    float  texcoord_difference;
+    size_t different_triangles;
+    if (!compareWithAssimp(meshes,
+                           reference,
+                           position_difference,
+                           normal_difference,
+                           texcoord_difference,
+                           different_triangles))
+    {
+        std::cout << "ERROR::OBJ:: the loader splits the meshes differently from Assimp, the "
+                     "mesh cache won't apply"
+                  << std::endl;
+        return false;
+    }
+    std::cout << "Info: Same meshes as Assimp, differing by up to " << position_difference
+              << " in position, " << normal_difference << " in normal and "
+              << texcoord_difference << " in texture coords, " << different_triangles
+              << " triangles split differently" << std::endl;
+
+    // the whole import on every thread, the loader's vertices go through the same steps
+    MeshCache mesh_cache;
+    mesh_cache.load(MeshCache::getPath(model_path));
+    Skeleton skeleton;
+    importSkeleton(scene, skeleton);
+
+    JobSystem                 jobs(max_threads);
+    std::vector<ImportedMesh> imported;
+    Clock::time_point         start = Clock::now();
+    importMeshes(meshes, transforms, skeleton, mesh_cache, jobs, imported);
+    const double assimp_import_seconds = assimp_seconds + secondsSince(start);
+
+    std::vector<ObjMaterial> materials;
+    start = Clock::now();
+    loadObj(model_path, jobs, materials, imported);
+    finishMeshes(mesh_cache, jobs, imported);
+    const double native_import_seconds = secondsSince(start);
+
+    std::cout << "Info: Read and imported on " << jobs.getThreadCount() << " threads: Assimp "
+              << assimp_import_seconds * 1e3 << " ms, the OBJ loader "
+              << native_import_seconds * 1e3 << " ms, "
+              << assimp_import_seconds / native_import_seconds << "x" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> model_paths;
+    uint32_t                 run_count   = 3;
+    uint32_t                 max_threads = 0;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--runs") == 0 && index + 1 < argc)
+            run_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            max_threads = std::max(0, atoi(argv[++index]));
+        else if (argv[index][0] != '-')
+            model_paths.push_back(argv[index]);
+    }
+    if (model_paths.empty())
+        model_paths = {"../../../data/sponza/sponza.obj", "../../../data/backpack/backpack.obj"};
+    if (max_threads == 0)
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    bool passed = true;
+    for (const auto& model_path : model_paths)
+    {
+        passed &= benchmark(model_path, run_count, max_threads);
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,803 @@
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#include "asset_file.h"
+#include "job_system.h"
+#include "mesh_import.h"
+#include "obj_loader.h"
+
+static constexpr uint32_t k_none         = ~0u;    // corner without texture coords or normal
+static constexpr uint32_t k_out_of_range = ~0u - 1; // index before the first vertex or zero
+
+// Assimp's names for what files leave out
+static const char* k_default_material = "DefaultMaterial";
+static const char* k_default_object   = "defaultobject";
+
+// a chunk per thread at least a few times over, so a slow one doesn't hold up the rest
+static constexpr size_t k_min_chunk_size = 64 * 1024;
+static constexpr size_t k_max_chunk_size = 4 * 1024 * 1024;
+
+struct ObjCorner
+{
+    uint32_t position;
+    uint32_t texcoord;
+    uint32_t normal;
+};
+
+// the lines between faces that change where the next ones go
+enum class ObjCommand
+{
+    object,   // o
+    group,    // g
+    material, // usemtl
+    library   // mtllib
+};
+
+struct ObjEvent
+{
+    ObjCommand  command;
+    uint32_t    face; // faces of the chunk before it
+    std::string name;
+};
+
+struct ObjChunk
+{
+    const char* begin;
+    const char* end;
+
+    // v, vt and vn lines in the chunk, then the ones in every chunk before it
+    uint32_t position_count {0};
+    uint32_t texcoord_count {0};
+    uint32_t normal_count {0};
+    uint32_t first_position {0};
+    uint32_t first_texcoord {0};
+    uint32_t first_normal {0};
+
+    std::vector<ObjCorner> corners;
+    std::vector<uint32_t>  face_ends; // past the last corner of every face
+    std::vector<ObjEvent>  events;
+};
+
+// the attribute streams every chunk writes its part of
+struct ObjStreams
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texcoords;
+    std::vector<glm::vec3> normals;
+};
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && isBlank(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char* findLineEnd(const char* p, const char* end)
+{
+    const void* line_end = memchr(p, '\n', static_cast<size_t>(end - p));
+    return line_end ? static_cast<const char*>(line_end) : end;
+}
+
+// the keyword at p followed by a blank or the end of the line, rest past the blanks after it
+static bool
+matchKeyword(const char* p, const char* end, const char* keyword, bool any_case, const char*& rest)
+{
+    const size_t length = strlen(keyword);
+    if (static_cast<size_t>(end - p) < length)
+        return false;
+
+    for (size_t index = 0; index < length; index++)
+    {
+        const char a = any_case ? static_cast<char>(tolower(p[index])) : p[index];
+        const char b = any_case ? static_cast<char>(tolower(keyword[index])) : keyword[index];
+        if (a != b)
+            return false;
+    }
+    if (p + length < end && !isBlank(p[length]))
+        return false;
+
+    rest = skipBlanks(p + length, end);
+    return true;
+}
+
+// the rest of the line without the blanks around it
+static std::string readName(const char* p, const char* end)
+{
+    p = skipBlanks(p, end);
+    while (end > p && isBlank(end[-1]))
+    {
+        end--;
+    }
+    return std::string(p, end);
+}
+
+// decimal or scientific notation without a copy or the locale strtod goes through. Digits past
+// the 19th only scale the value. Mantissas under 2^53 and exponents up to 22 are exact, the powers
+// of ten are too. Returns nullptr without a number at p
+static const char* parseFloat(const char* p, const char* end, float& value)
+{
+    static const double k_powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                      1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                      1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int      digits   = 0;
+    int      exponent = 0;
+    bool     found    = false;
+    for (; p < end && isDigit(*p); p++)
+    {
+        found = true;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            digits += mantissa > 0 ? 1 : 0;
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && isDigit(*p); p++)
+        {
+            found = true;
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                digits += mantissa > 0 ? 1 : 0;
+                exponent--;
+            }
+        }
+    }
+    if (!found)
+        return nullptr;
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* q             = p + 1;
+        bool        negative_part = false;
+        if (q < end && (*q == '-' || *q == '+'))
+        {
+            negative_part = *q == '-';
+            q++;
+        }
+        if (q < end && isDigit(*q))
+        {
+            int part = 0;
+            for (; q < end && isDigit(*q); q++)
+            {
+                part = std::min(part * 10 + (*q - '0'), 10000);
+            }
+            exponent += negative_part ? -part : part;
+            p = q;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0 && exponent >= -22)
+        result /= k_powers[-exponent];
+    else if (exponent > 0 && exponent <= 22)
+        result *= k_powers[exponent];
+    else if (exponent != 0)
+        result *= std::pow(10.0, exponent);
+
+    value = static_cast<float>(negative ? -result : result);
+    return p;
+}
+
+// the next number of a v, vt or vn line, 0 when the line has no more
+static float readFloat(const char*& p, const char* end)
+{
+    float       value = 0.f;
+    const char* next  = parseFloat(skipBlanks(p, end), end, value);
+    if (next)
+        p = next;
+    return value;
+}
+
+// a 1-based index, or negative from the count read so far. k_none without digits at p
+static const char* parseIndex(const char* p, const char* end, uint32_t count, uint32_t& index)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || !isDigit(*p))
+    {
+        index = k_none;
+        return p;
+    }
+
+    int64_t value = 0;
+    for (; p < end && isDigit(*p); p++)
+    {
+        value = std::min<int64_t>(value * 10 + (*p - '0'), k_out_of_range);
+    }
+    if (value == 0)
+        index = k_out_of_range;
+    else if (negative)
+        index = value <= count ? static_cast<uint32_t>(count - value) : k_out_of_range;
+    else
+        index = static_cast<uint32_t>(value - 1);
+    return p;
+}
+
+// the v, vt and vn lines of the chunk
+static void countChunk(ObjChunk& chunk)
+{
+    const char* rest;
+    for (const char* line = chunk.begin; line < chunk.end;)
+    {
+        const char* line_end = findLineEnd(line, chunk.end);
+        const char* p        = skipBlanks(line, line_end);
+        if (p < line_end && *p == 'v')
+        {
+            if (matchKeyword(p, line_end, "v", false, rest))
+                chunk.position_count++;
+            else if (matchKeyword(p, line_end, "vt", false, rest))
+                chunk.texcoord_count++;
+            else if (matchKeyword(p, line_end, "vn", false, rest))
+                chunk.normal_count++;
+        }
+        line = line_end + 1;
+    }
+}
+
+static void parseChunk(ObjChunk& chunk, ObjStreams& streams)
+{
+    uint32_t position_count = chunk.first_position;
+    uint32_t texcoord_count = chunk.first_texcoord;
+    uint32_t normal_count   = chunk.first_normal;
+
+    // faces are usually triangles or quads of a few dozen bytes
+    const size_t size = static_cast<size_t>(chunk.end - chunk.begin);
+    chunk.face_ends.reserve(size / 64);
+    chunk.corners.reserve(size / 16);
+
+    const char* p;
+    for (const char* line = chunk.begin; line < chunk.end;)
+    {
+        const char* line_end = findLineEnd(line, chunk.end);
+        const char* start    = skipBlanks(line, line_end);
+        line                 = line_end + 1;
+        if (start == line_end || *start == '#')
+            continue;
+
+        const auto face = static_cast<uint32_t>(chunk.face_ends.size());
+        if (matchKeyword(start, line_end, "v", false, p))
+        {
+            glm::vec3& position = streams.positions[position_count++];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                position[axis] = readFloat(p, line_end);
+            }
+        }
+        else if (matchKeyword(start, line_end, "vt", false, p))
+        {
+            glm::vec2& texcoords = streams.texcoords[texcoord_count++];
+            texcoords.x          = readFloat(p, line_end);
+            texcoords.y          = readFloat(p, line_end);
+        }
+        else if (matchKeyword(start, line_end, "vn", false, p))
+        {
+            glm::vec3& normal = streams.normals[normal_count++];
+            for (int axis = 0; axis < 3; axis++)
+            {
+                normal[axis] = readFloat(p, line_end);
+            }
+        }
+        else if (matchKeyword(start, line_end, "f", false, p))
+        {
+            uint32_t corner_count = 0;
+            for (p = skipBlanks(p, line_end); p < line_end; p = skipBlanks(p, line_end))
+            {
+                ObjCorner corner {k_none, k_none, k_none};
+                p = parseIndex(p, line_end, position_count, corner.position);
+                if (p < line_end && *p == '/')
+                {
+                    p = parseIndex(p + 1, line_end, texcoord_count, corner.texcoord);
+                    if (p < line_end && *p == '/')
+                        p = parseIndex(p + 1, line_end, normal_count, corner.normal);
+                }
+                while (p < line_end && !isBlank(*p))
+                {
+                    p++;
+                }
+                chunk.corners.push_back(corner);
+                corner_count++;
+            }
+
+            // points and lines have no triangles
+            if (corner_count >= 3)
+                chunk.face_ends.push_back(static_cast<uint32_t>(chunk.corners.size()));
+            else
+                chunk.corners.resize(chunk.corners.size() - corner_count);
+        }
+        else if (matchKeyword(start, line_end, "o", false, p))
+            chunk.events.push_back({ObjCommand::object, face, readName(p, line_end)});
+        else if (matchKeyword(start, line_end, "g", false, p))
+            chunk.events.push_back({ObjCommand::group, face, readName(p, line_end)});
+        else if (matchKeyword(start, line_end, "usemtl", false, p))
+            chunk.events.push_back({ObjCommand::material, face, readName(p, line_end)});
+        else if (matchKeyword(start, line_end, "mtllib", false, p))
+            chunk.events.push_back({ObjCommand::library, face, readName(p, line_end)});
+    }
+}
+
+// the texture of a map line past its -option arguments
+static std::string readMapPath(const char* p, const char* end)
+{
+    while (p < end && *p == '-')
+    {
+        const char* option = p;
+        while (p < end && !isBlank(*p))
+        {
+            p++;
+        }
+        const std::string name(option, p);
+
+        // -o, -s and -t take up to three numbers, -mm two, the others one word
+        const bool position = name == "-o" || name == "-s" || name == "-t";
+        const int  most     = position ? 3 : name == "-mm" ? 2 : 1;
+        const bool numbers  = most > 1;
+        for (int argument = 0; argument < most; argument++)
+        {
+            const char* next = skipBlanks(p, end);
+            float       value;
+            if (numbers && !parseFloat(next, end, value))
+                break;
+
+            p = next;
+            while (p < end && !isBlank(*p))
+            {
+                p++;
+            }
+        }
+        p = skipBlanks(p, end);
+    }
+    return readName(p, end);
+}
+
+static void loadMtl(const std::string&                         path,
+                    std::vector<ObjMaterial>&                  materials,
+                    std::unordered_map<std::string, uint32_t>& material_indices)
+{
+    AssetFile file;
+    if (!file.open(path))
+    {
+        std::cout << "ERROR::OBJ:: can't open the material library " << path << std::endl;
+        return;
+    }
+
+    const char* end = file.getData() + file.getSize();
+    const char* p;
+    for (const char* line = file.getData(); line < end;)
+    {
+        const char* line_end = findLineEnd(line, end);
+        const char* start    = skipBlanks(line, line_end);
+        line                 = line_end + 1;
+
+        if (matchKeyword(start, line_end, "newmtl", false, p))
+        {
+            materials.push_back(ObjMaterial());
+            materials.back().name = readName(p, line_end);
+            material_indices.emplace(materials.back().name,
+                                     static_cast<uint32_t>(materials.size() - 1));
+            continue;
+        }
+        if (materials.size() <= 1)
+            continue;
+
+        ObjMaterial& material = materials.back();
+        if (matchKeyword(start, line_end, "map_Kd", true, p))
+            material.diffuse_map = readMapPath(p, line_end);
+        else if (matchKeyword(start, line_end, "map_Ks", true, p))
+            material.specular_map = readMapPath(p, line_end);
+        else if (matchKeyword(start, line_end, "norm", true, p) ||
+                 matchKeyword(start, line_end, "map_Kn", true, p))
+            material.normal_map = readMapPath(p, line_end);
+        else if (matchKeyword(start, line_end, "map_Ka", true, p))
+            material.ambient_map = readMapPath(p, line_end);
+    }
+}
+
+// faces [begin, end) of a chunk
+struct ObjFaceSpan
+{
+    uint32_t chunk;
+    uint32_t begin;
+    uint32_t end;
+};
+
+struct ObjMeshFaces
+{
+    uint32_t                 material {k_none}; // k_none until a usemtl, then the default
+    uint32_t                 face_count {0};
+    std::vector<ObjFaceSpan> spans;
+};
+
+// the objects and meshes the events split the faces into, as ObjFileParser builds them. A group
+// that differs from the last one always starts a new object, an object whose name was seen
+// before becomes current again but keeps the current mesh. A material only starts a mesh when
+// the current one has faces and a different material already, otherwise it is assigned the new
+// one. Returns the meshes in the order the importer creates them, the meshes of the objects in
+// turn, without the empty ones
+static std::vector<ObjMeshFaces> splitMeshes(const std::vector<ObjChunk>&                chunks,
+                                             const std::string&                          directory,
+                                             std::vector<ObjMaterial>&                   materials,
+                                             std::unordered_map<std::string, uint32_t>& indices)
+{
+    std::vector<ObjMeshFaces>                 meshes;
+    std::vector<std::vector<uint32_t>>        objects; // the meshes of every object
+    std::unordered_map<std::string, uint32_t> object_indices;
+    uint32_t                                  current_object = k_none;
+    uint32_t                                  current_mesh   = k_none;
+    std::string                               current_material; // empty before any usemtl
+    std::string                               active_group;
+
+    const auto findMaterial = [&](const std::string& name) {
+        const auto found = indices.find(name);
+        return found != indices.end() ? found->second : k_none;
+    };
+    const auto createMesh = [&]() {
+        current_mesh = static_cast<uint32_t>(meshes.size());
+        meshes.emplace_back();
+        if (current_object != k_none)
+            objects[current_object].push_back(current_mesh);
+    };
+    const auto createObject = [&](const std::string& name) {
+        current_object = static_cast<uint32_t>(objects.size());
+        objects.emplace_back();
+        object_indices.emplace(name, current_object);
+        createMesh();
+        if (!current_material.empty())
+            meshes[current_mesh].material = findMaterial(current_material);
+    };
+    const auto addFaces = [&](uint32_t chunk, uint32_t begin, uint32_t end) {
+        if (begin == end)
+            return;
+
+        if (current_object == k_none)
+            createObject(k_default_object);
+        if (current_mesh == k_none)
+            createMesh();
+        meshes[current_mesh].spans.push_back({chunk, begin, end});
+        meshes[current_mesh].face_count += end - begin;
+    };
+
+    for (uint32_t chunk = 0; chunk < chunks.size(); chunk++)
+    {
+        uint32_t face = 0;
+        for (const auto& event : chunks[chunk].events)
+        {
+            addFaces(chunk, face, event.face);
+            face = event.face;
+
+            if (event.command == ObjCommand::object && !event.name.empty())
+            {
+                const auto found = object_indices.find(event.name);
+                if (found != object_indices.end())
+                    current_object = found->second;
+                else
+                    createObject(event.name);
+            }
+            else if (event.command == ObjCommand::group && event.name != active_group)
+            {
+                createObject(event.name);
+                active_group = event.name;
+            }
+            else if (event.command == ObjCommand::material && event.name != current_material)
+            {
+                const uint32_t material = findMaterial(event.name);
+                current_material        = material != k_none ? event.name : k_default_material;
+
+                const ObjMeshFaces* mesh = current_mesh != k_none ? &meshes[current_mesh] : nullptr;
+                if (!mesh || (mesh->material != k_none && mesh->material != material &&
+                              mesh->face_count > 0))
+                    createMesh();
+                meshes[current_mesh].material = material;
+            }
+            else if (event.command == ObjCommand::library)
+            {
+                // several libraries can share the line
+                const char* p   = event.name.c_str();
+                const char* end = p + event.name.size();
+                while ((p = skipBlanks(p, end)) < end)
+                {
+                    const char* name = p;
+                    while (p < end && !isBlank(*p))
+                    {
+                        p++;
+                    }
+                    loadMtl(directory + '/' + std::string(name, p), materials, indices);
+                }
+            }
+        }
+        addFaces(chunk, face, static_cast<uint32_t>(chunks[chunk].face_ends.size()));
+    }
+
+    std::vector<ObjMeshFaces> ordered;
+    for (const auto& object : objects)
+    {
+        for (uint32_t mesh : object)
+        {
+            if (meshes[mesh].face_count > 0)
+                ordered.push_back(std::move(meshes[mesh]));
+        }
+    }
+    return ordered;
+}
+
+// the two triangles of a quad, fanned from its concave corner if it has one
+static void triangulateQuad(const glm::vec3 (&corners)[4], uint32_t& start)
+{
+    start = 0;
+    for (uint32_t corner = 0; corner < 4; corner++)
+    {
+        const glm::vec3& origin   = corners[corner];
+        const glm::vec3  left     = corners[(corner + 3) % 4] - origin;
+        const glm::vec3  diagonal = corners[(corner + 2) % 4] - origin;
+        const glm::vec3  right    = corners[(corner + 1) % 4] - origin;
+        const auto       angle    = [](glm::vec3 a, glm::vec3 b) {
+            const float lengths = glm::length(a) * glm::length(b);
+            return std::acos(lengths > 0.f ? glm::clamp(glm::dot(a, b) / lengths, -1.f, 1.f) : 1.f);
+        };
+        if (angle(left, diagonal) + angle(right, diagonal) > glm::pi<float>())
+        {
+            start = corner;
+            return;
+        }
+    }
+}
+
+// a vertex per face corner. Returns false when a corner indexes past the streams
+static bool buildMesh(const std::vector<ObjChunk>& chunks,
+                      const ObjStreams&            streams,
+                      const ObjMeshFaces&          faces,
+                      ImportedMesh&                mesh)
+{
+    const auto faceCorners = [&](const ObjChunk& chunk, uint32_t face) {
+        return face > 0 ? chunk.face_ends[face - 1] : 0u;
+    };
+
+    size_t corner_count  = 0;
+    size_t index_count   = 0;
+    bool   has_texcoords = false;
+    bool   has_normals   = false;
+    for (const auto& span : faces.spans)
+    {
+        const ObjChunk& chunk = chunks[span.chunk];
+        const uint32_t  begin = faceCorners(chunk, span.begin);
+        const uint32_t  end   = faceCorners(chunk, span.end);
+        for (uint32_t corner = begin; corner < end; corner++)
+        {
+            has_texcoords |= chunk.corners[corner].texcoord != k_none;
+            has_normals |= chunk.corners[corner].normal != k_none;
+        }
+        const uint32_t span_corners = end - begin;
+        corner_count += span_corners;
+        index_count += 3 * (span_corners - 2 * (span.end - span.begin));
+    }
+
+    std::vector<Vertex>&   vertices = mesh.vertices;
+    std::vector<uint32_t>& indices  = mesh.indices;
+    std::vector<uint32_t>  positions(has_normals ? 0 : corner_count);
+    vertices.resize(corner_count);
+    indices.resize(index_count);
+    mesh.material = faces.material != k_none ? faces.material : 0;
+
+    uint32_t  vertex = 0;
+    uint32_t* index  = indices.data();
+    for (const auto& span : faces.spans)
+    {
+        const ObjChunk& chunk = chunks[span.chunk];
+        for (uint32_t face = span.begin; face < span.end; face++)
+        {
+            const uint32_t first = vertex;
+            for (uint32_t corner = faceCorners(chunk, face); corner < chunk.face_ends[face];
+                 corner++)
+            {
+                const ObjCorner& source = chunk.corners[corner];
+                if (source.position >= streams.positions.size() ||
+                    (source.texcoord != k_none && source.texcoord >= streams.texcoords.size()) ||
+                    (source.normal != k_none && source.normal >= streams.normals.size()))
+                    return false;
+
+                Vertex& target  = vertices[vertex];
+                target          = Vertex {};
+                target.position = streams.positions[source.position];
+                target.normal   = glm::vec3(0.f);
+                if (source.normal != k_none)
+                    target.normal = streams.normals[source.normal];
+
+                // corners without coords in a mesh with them are flipped from (0, 0) too
+                target.texcoords = glm::vec2(0.f, has_texcoords ? 1.f : 0.f);
+                if (source.texcoord != k_none)
+                {
+                    const glm::vec2& texcoords = streams.texcoords[source.texcoord];
+                    target.texcoords           = glm::vec2(texcoords.x, 1.f - texcoords.y);
+                }
+
+                if (!has_normals)
+                    positions[vertex] = source.position;
+                vertex++;
+            }
+
+            const uint32_t face_corners = vertex - first;
+            if (face_corners == 4)
+            {
+                const glm::vec3 corners[4] = {vertices[first].position,
+                                              vertices[first + 1].position,
+                                              vertices[first + 2].position,
+                                              vertices[first + 3].position};
+                uint32_t        start;
+                triangulateQuad(corners, start);
+
+                const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+                for (uint32_t corner : quad)
+                {
+                    *index++ = first + (start + corner) % 4;
+                }
+                continue;
+            }
+            for (uint32_t corner = 1; corner + 1 < face_corners; corner++)
+            {
+                *index++ = first;
+                *index++ = first + corner;
+                *index++ = first + corner + 1;
+            }
+        }
+    }
+
+    if (has_normals)
+        return true;
+
+    // every vertex takes the normal of the last triangle it is in, then the corners of a position
+    // share the sum of theirs
+    std::vector<glm::vec3> face_normals(vertices.size(), glm::vec3(0.f));
+    for (size_t triangle = 0; triangle < indices.size(); triangle += 3)
+    {
+        const glm::vec3& a      = vertices[indices[triangle]].position;
+        const glm::vec3  normal = glm::cross(vertices[indices[triangle + 1]].position - a,
+                                            vertices[indices[triangle + 2]].position - a);
+        const float      length = glm::length(normal);
+        for (int corner = 0; corner < 3; corner++)
+        {
+            face_normals[indices[triangle + corner]] = length > 0.f ? normal / length : normal;
+        }
+    }
+
+    const auto [lowest, highest] = std::minmax_element(positions.begin(), positions.end());
+    std::vector<glm::vec3> sums(positions.empty() ? 0 : *highest - *lowest + 1, glm::vec3(0.f));
+    for (size_t corner = 0; corner < positions.size(); corner++)
+    {
+        sums[positions[corner] - *lowest] += face_normals[corner];
+    }
+    for (size_t corner = 0; corner < positions.size(); corner++)
+    {
+        const glm::vec3& sum   = sums[positions[corner] - *lowest];
+        const float      length = glm::length(sum);
+        vertices[corner].normal = length > 0.f ? sum / length : glm::vec3(0.f);
+    }
+    return true;
+}
+
+bool loadObj(const std::string&         path,
+             JobSystem&                 jobs,
+             std::vector<ObjMaterial>&  materials,
+             std::vector<ImportedMesh>& meshes)
+{
+    materials.assign(1, ObjMaterial());
+    materials[0].name = k_default_material;
+    meshes.clear();
+
+    AssetFile file;
+    if (!file.open(path))
+    {
+        std::cout << "ERROR::OBJ:: can't open " << path << std::endl;
+        return false;
+    }
+
+    // cut at the first line end past every chunk size
+    const char*  data = file.getData();
+    const char*  end  = data + file.getSize();
+    const size_t chunk_size = std::clamp(
+        file.getSize() / (4 * jobs.getThreadCount()), k_min_chunk_size, k_max_chunk_size);
+
+    std::vector<ObjChunk> chunks;
+    for (const char* begin = data; begin < end;)
+    {
+        const char* chunk_end =
+            findLineEnd(begin + std::min(chunk_size, static_cast<size_t>(end - begin)) - 1, end);
+        chunk_end = std::min(chunk_end + 1, end);
+
+        chunks.emplace_back();
+        chunks.back().begin = begin;
+        chunks.back().end   = chunk_end;
+        begin               = chunk_end;
+    }
+    const uint32_t chunk_count = static_cast<uint32_t>(chunks.size());
+
+    jobs.parallelFor(chunk_count, 1, [&](uint32_t begin, uint32_t chunk_end, uint32_t) {
+        for (uint32_t chunk = begin; chunk < chunk_end; chunk++)
+        {
+            countChunk(chunks[chunk]);
+        }
+    });
+
+    ObjStreams streams;
+    uint32_t   position_count = 0;
+    uint32_t   texcoord_count = 0;
+    uint32_t   normal_count   = 0;
+    for (auto& chunk : chunks)
+    {
+        chunk.first_position = position_count;
+        chunk.first_texcoord = texcoord_count;
+        chunk.first_normal   = normal_count;
+        position_count += chunk.position_count;
+        texcoord_count += chunk.texcoord_count;
+        normal_count += chunk.normal_count;
+    }
+    streams.positions.resize(position_count);
+    streams.texcoords.resize(texcoord_count);
+    streams.normals.resize(normal_count);
+
+    jobs.parallelFor(chunk_count, 1, [&](uint32_t begin, uint32_t chunk_end, uint32_t) {
+        for (uint32_t chunk = begin; chunk < chunk_end; chunk++)
+        {
+            parseChunk(chunks[chunk], streams);
+        }
+    });
+
+    std::unordered_map<std::string, uint32_t> material_indices = {{k_default_material, 0}};
+    const std::string directory = path.substr(0, path.find_last_of('/'));
+    const std::vector<ObjMeshFaces> faces =
+        splitMeshes(chunks, directory, materials, material_indices);
+
+    meshes.resize(faces.size());
+    std::vector<uint8_t> built(faces.size(), 0);
+    jobs.parallelFor(static_cast<uint32_t>(faces.size()),
+                     1,
+                     [&](uint32_t begin, uint32_t chunk_end, uint32_t) {
+                         for (uint32_t mesh = begin; mesh < chunk_end; mesh++)
+                         {
+                             built[mesh] = buildMesh(chunks, streams, faces[mesh], meshes[mesh]);
+                         }
+                     });
+    if (std::find(built.begin(), built.end(), 0) != built.end())
+    {
+        std::cout << "ERROR::OBJ:: " << path << " has faces past its vertices" << std::endl;
+        meshes.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+struct ImportedMesh;
+
+// the maps of an MTL material Model loads, paths as the library gives them, relative to the model
+struct ObjMaterial
+{
+    std::string name;
+    std::string diffuse_map;  // map_Kd
+    std::string specular_map; // map_Ks
+    std::string normal_map;   // norm or map_Kn, Assimp doesn't count map_Bump as one either
+    std::string ambient_map;  // map_Ka, which Model loads as height maps
+};
+
+// Reads an OBJ file and the MTL libraries it names without Assimp. The file is mapped and cut into
+// line-aligned chunks the jobs parse in place: a first pass counts the v, vt and vn lines of every
+// chunk so the second can write them straight into the shared streams and resolve relative
+// indices, faces stay flat corner lists per chunk. The faces are then gathered into meshes the
+// way Assimp's OBJ importer splits them, per group or object and material in file order, and
+// built on the jobs with a vertex per face corner, so the mesh cache baked through Assimp applies.
+// Like aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals, polygons are
+// triangulated (quads from their concave corner, larger ones as fans), v is flipped and meshes
+// without normals get smooth ones, shared by the corners of a position.
+//
+// Only the vertices, indices and material of the meshes are filled in, see finishMeshes. Material
+// 0 is the default of faces without one. Returns false when the file can't be read or indexes
+// past its vertices
+bool loadObj(const std::string&         path,
+             JobSystem&                 jobs,
+             std::vector<ObjMaterial>&  materials,
+             std::vector<ImportedMesh>& meshes);
@@ -0,0 +1,218 @@
+// Builds the asset pack the app reads its files from with --pack, no GPU needed. Packs every file
+// under the directories, named by their path relative to the root, checks the pack reads back
+// the same, then times opening every file out of the pack against opening the loose files, cold
+// from the disk and warm from the page cache:
+//   pack_assets [directories] [options]
+//     --root <dir>       directory the names in the pack start from, the app's (default ../../..)
+//     --output <file>    pack to write (default <root>/assets.pack)
+//     --runs <n>         warm reads timed, the fastest counts (default 3)
+//     --no-benchmark     only write and check the pack
+// The directories default to data and shader. The cold reads drop the files from the page cache
+// first, which only Linux and the other POSIX systems can do without privileges.
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "asset_file.h"
+#include "asset_pack.h"
+#include "job_system.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// drops the pages of a file from the page cache so the next read goes to the disk
+static bool evictFile(const std::string& path)
+{
+#ifdef _WIN32
+    (void)path;
+    return false;
+#else
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+    const bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(file);
+    return evicted;
+#endif
+}
+
+// a byte of every page, so mapped files are read in whole
+static uint32_t touchPages(const char* data, size_t size)
+{
+    uint32_t sum = 0;
+    for (size_t offset = 0; offset < size; offset += 4096)
+    {
+        sum += static_cast<uint8_t>(data[offset]);
+    }
+    return sum;
+}
+
+// opens every file the way the loaders do, out of the pack when mounted. Returns the seconds
+static double readAll(const std::vector<AssetPackSource>& sources,
+                      const std::string&                  root,
+                      uint32_t&                           checksum)
+{
+    const Clock::time_point start = Clock::now();
+    for (const auto& source : sources)
+    {
+        AssetFile file;
+        if (file.open(root + '/' + source.name))
+            checksum += touchPages(file.getData(), file.getSize());
+    }
+    return secondsSince(start);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> directories;
+    std::string              root          = "../../..";
+    std::string              output_path;
+    uint32_t                 run_count     = 3;
+    bool                     run_benchmark = true;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--root") == 0 && index + 1 < argc)
+            root = argv[++index];
+        else if (strcmp(argv[index], "--output") == 0 && index + 1 < argc)
+            output_path = argv[++index];
+        else if (strcmp(argv[index], "--runs") == 0 && index + 1 < argc)
+            run_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--no-benchmark") == 0)
+            run_benchmark = false;
+        else if (argv[index][0] != '-')
+            directories.push_back(argv[index]);
+    }
+    if (directories.empty())
+        directories = {"data", "shader"};
+    if (output_path.empty())
+        output_path = root + "/assets.pack";
+
+    // every regular file under the directories, named from the root
+    std::vector<AssetPackSource> sources;
+    uint64_t                     loose_size = 0;
+    for (const auto& directory : directories)
+    {
+        std::error_code                               error;
+        std::filesystem::recursive_directory_iterator entry(root + '/' + directory, error);
+        for (; !error && entry != std::filesystem::recursive_directory_iterator();
+             entry.increment(error))
+        {
+            if (!entry->is_regular_file())
+                continue;
+            const std::string relative =
+                std::filesystem::relative(entry->path(), root).generic_string();
+            sources.push_back({AssetPack::normalizePath(relative), entry->path().string()});
+            loose_size += entry->file_size();
+        }
+        if (error)
+        {
+            std::cout << "ERROR::PACK_ASSETS:: can't list " << root << '/' << directory << ": "
+                      << error.message() << std::endl;
+            return 1;
+        }
+    }
+
+    JobSystem               jobs;
+    const Clock::time_point start = Clock::now();
+    if (!AssetPack::write(output_path, sources, jobs))
+        return 1;
+    const double write_seconds = secondsSince(start);
+
+    AssetPack pack;
+    if (!pack.open(output_path))
+        return 1;
+    uint64_t pack_size         = 0;
+    uint32_t compressed_count  = 0;
+    uint64_t compressed_size   = 0;
+    uint64_t compressed_stored = 0;
+    for (const auto& entry : pack.getEntries())
+    {
+        pack_size = std::max(pack_size, entry.offset + entry.stored_size);
+        if (entry.compression == static_cast<uint32_t>(AssetCompression::lz4))
+        {
+            compressed_count++;
+            compressed_size += entry.size;
+            compressed_stored += entry.stored_size;
+        }
+    }
+    pack.close();
+    std::cout << "Info: Packed " << sources.size() << " files, " << loose_size / 1e6 << " MB, into "
+              << output_path << ", " << pack_size / 1e6 << " MB in " << write_seconds * 1e3
+              << " ms. " << compressed_count << " files LZ4 compressed from "
+              << compressed_size / 1e6 << " to " << compressed_stored / 1e6
+              << " MB, the rest stored raw" << std::endl;
+
+    // every file out of the pack has to be the one on disk
+    if (!AssetFile::mountPack(output_path, root, &jobs))
+        return 1;
+    for (const auto& source : sources)
+    {
+        AssetFile packed;
+        AssetFile loose;
+        if (!packed.open(root + '/' + source.name) || !packed.isPacked() ||
+            !loose.open(source.path) || packed.getSize() != loose.getSize() ||
+            memcmp(packed.getData(), loose.getData(), packed.getSize()) != 0)
+        {
+            std::cout << "ERROR::PACK_ASSETS:: " << source.name << " doesn't read back the same"
+                      << std::endl;
+            return 1;
+        }
+    }
+    AssetFile::unmountPack();
+    if (!run_benchmark)
+        return 0;
+
+    // cold reads first, after dropping the files and the pack from the page cache. The pack is
+    // mounted in the cold time, it reads the table of contents
+    uint32_t checksum = 0;
+    for (int packed = 0; packed < 2; packed++)
+    {
+        bool evicted = true;
+        for (const auto& source : sources)
+        {
+            evicted &= evictFile(source.path);
+        }
+        evicted &= evictFile(output_path);
+
+        const Clock::time_point cold_start = Clock::now();
+        if (packed && !AssetFile::mountPack(output_path, root, &jobs))
+            return 1;
+        readAll(sources, root, checksum);
+        const double cold_seconds = secondsSince(cold_start);
+
+        double warm_seconds = 0.0;
+        for (uint32_t run = 0; run < run_count; run++)
+        {
+            const double run_seconds = readAll(sources, root, checksum);
+            warm_seconds             = run == 0 ? run_seconds : std::min(warm_seconds, run_seconds);
+        }
+
+        std::cout << "Info: " << (packed ? "Pack" : "Loose files") << ": ";
+        if (evicted)
+            std::cout << "cold " << cold_seconds * 1e3 << " ms, ";
+        else
+            std::cout << "cold not measured, the page cache can't be dropped here, ";
+        std::cout << "warm " << warm_seconds * 1e3 << " ms on " << jobs.getThreadCount()
+                  << " threads" << std::endl;
+    }
+    AssetFile::unmountPack();
+
+    // keeps the reads from being optimized out
+    std::cout << "Info: checksum " << checksum << std::endl;
+    return 0;
+}
@@ -0,0 +1,298 @@
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "particle_system.h"
+
+static constexpr uint32_t k_sort_block   = 1024;     // keys sorted in shared memory at once
+static constexpr uint32_t k_max_capacity = 1u << 23; // in 256-thread groups of one dispatch
+
+static const glm::vec3 k_gravity(0.f, -9.81f, 0.f);
+static constexpr float k_drag        = 0.2f; // fraction of the velocity lost per second
+static constexpr float k_restitution = 0.4f;
+static constexpr float k_friction    = 0.8f;
+
+// binding points of the buffers, shared by every particle shader
+static constexpr uint32_t k_particle_binding   = 10;
+static constexpr uint32_t k_dead_binding       = 11;
+static constexpr uint32_t k_alive_binding      = 12;
+static constexpr uint32_t k_next_alive_binding = 13;
+static constexpr uint32_t k_draw_list_binding  = 14;
+static constexpr uint32_t k_counter_binding    = 15;
+
+// stages of particle_sort.cs
+static constexpr int k_stage_presort = 0;
+static constexpr int k_stage_global  = 1;
+static constexpr int k_stage_local   = 2;
+
+struct Particle
+{
+    glm::vec4 position_age;
+    glm::vec4 velocity_lifetime;
+};
+
+static uint32_t roundCapacity(uint32_t capacity)
+{
+    uint32_t rounded = k_sort_block;
+    while (rounded < std::min(capacity, k_max_capacity))
+    {
+        rounded *= 2;
+    }
+    return rounded;
+}
+
+// inverse of orderedBits() in particle_simulate.cs
+static float fromOrderedBits(uint32_t bits)
+{
+    bits = bits & 0x80000000u ? bits & 0x7fffffffu : ~bits;
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+ParticleSystem::ParticleSystem(uint32_t capacity) :
+    capacity_(roundCapacity(capacity)),
+    args_shader_("../../../shader/particle_args.cs"),
+    emit_shader_("../../../shader/particle_emit.cs"),
+    simulate_shader_("../../../shader/particle_simulate.cs"),
+    sort_shader_("../../../shader/particle_sort.cs"),
+    render_shader_("../../../shader/particle.vs", "../../../shader/particle.fs")
+{
+    const uint32_t buffer_count = 6;
+    uint32_t       buffers[buffer_count];
+    glGenBuffers(buffer_count, buffers);
+    particle_buffer_  = buffers[0];
+    dead_buffer_      = buffers[1];
+    alive_buffers_[0] = buffers[2];
+    alive_buffers_[1] = buffers[3];
+    draw_list_buffer_ = buffers[4];
+    counter_buffer_   = buffers[5];
+
+    const size_t sizes[buffer_count] = {capacity_ * sizeof(Particle),
+                                        capacity_ * sizeof(uint32_t),
+                                        capacity_ * sizeof(uint32_t),
+                                        capacity_ * sizeof(uint32_t),
+                                        capacity_ * sizeof(glm::uvec2),
+                                        sizeof(Counters)};
+    for (uint32_t index = 0; index < buffer_count; index++)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[index]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizes[index], nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // the quads are generated from gl_VertexID, the draw only needs a vertex array bound
+    glGenVertexArrays(1, &vao_);
+
+    reset();
+}
+
+ParticleSystem::~ParticleSystem()
+{
+    const uint32_t buffers[] = {particle_buffer_,
+                                dead_buffer_,
+                                alive_buffers_[0],
+                                alive_buffers_[1],
+                                draw_list_buffer_,
+                                counter_buffer_};
+    glDeleteBuffers(6, buffers);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void ParticleSystem::reset()
+{
+    std::vector<uint32_t> dead_list(capacity_);
+    for (uint32_t index = 0; index < capacity_; index++)
+    {
+        dead_list[index] = index;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, dead_buffer_);
+    glBufferSubData(
+        GL_SHADER_STORAGE_BUFFER, 0, capacity_ * sizeof(uint32_t), dead_list.data());
+
+    Counters counters {};
+    counters.draw_args[0] = 6;
+    for (uint32_t index = 0; index < 3; index++)
+    {
+        counters.emit_args[index]     = 1;
+        counters.simulate_args[index] = 1;
+        counters.sort_args[index]     = 1;
+    }
+    counters.dead_count = capacity_;
+    counters.sort_size  = k_sort_block;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counter_buffer_);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Counters), &counters);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    emit_remainder_ = 0.f;
+}
+
+void ParticleSystem::update(float                  delta_time,
+                            const ParticleEmitter& emitter,
+                            const glm::vec3&       camera_position,
+                            const glm::mat4&       view_projection)
+{
+    timer_.begin();
+
+    // whole particles of the frame, the fraction left carries over to the next one
+    const float emission  = std::max(emitter.rate * delta_time, 0.f) + emit_remainder_;
+    const float requested = std::min(std::floor(emission), static_cast<float>(capacity_));
+    emit_remainder_       = emission - requested;
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_particle_binding, particle_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_dead_binding, dead_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_alive_binding, alive_buffers_[alive_index_]);
+    glBindBufferBase(
+        GL_SHADER_STORAGE_BUFFER, k_next_alive_binding, alive_buffers_[alive_index_ ^ 1]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_draw_list_binding, draw_list_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_counter_binding, counter_buffer_);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, counter_buffer_);
+
+    args_shader_.use();
+    args_shader_.setBool("afterSimulation", false);
+    args_shader_.setUint("requestedCount", static_cast<uint32_t>(requested));
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    emit_shader_.use();
+    emit_shader_.setVec3f(
+        "emitterPosition", emitter.position.x, emitter.position.y, emitter.position.z);
+    emit_shader_.setFloat("emitterRadius", emitter.radius);
+    emit_shader_.setVec3f(
+        "emitterVelocity", emitter.velocity.x, emitter.velocity.y, emitter.velocity.z);
+    emit_shader_.setFloat("spread", emitter.spread);
+    emit_shader_.setVec2f("lifetimeRange", emitter.lifetime_min, emitter.lifetime_max);
+    emit_shader_.setUint("seed", frame_++);
+    glDispatchComputeIndirect(offsetof(Counters, emit_args));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // frustum planes, a particle outside of any of them by more than its size is off screen
+    const glm::mat4 rows = glm::transpose(view_projection);
+    glm::vec4       planes[6];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        planes[2 * axis]     = rows[3] + rows[axis];
+        planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+    for (auto& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    simulate_shader_.use();
+    simulate_shader_.setFloat("deltaTime", delta_time);
+    simulate_shader_.setVec3f("gravity", k_gravity.x, k_gravity.y, k_gravity.z);
+    simulate_shader_.setFloat("drag", k_drag);
+    simulate_shader_.setFloat("ground", emitter.ground);
+    simulate_shader_.setFloat("restitution", k_restitution);
+    simulate_shader_.setFloat("friction", k_friction);
+    glUniform4fv(glGetUniformLocation(simulate_shader_.ID, "frustumPlanes"),
+                 6,
+                 glm::value_ptr(planes[0]));
+    simulate_shader_.setVec3f(
+        "cameraPosition", camera_position.x, camera_position.y, camera_position.z);
+    simulate_shader_.setFloat("particleSize", emitter.size);
+    glDispatchComputeIndirect(offsetof(Counters, simulate_args));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    args_shader_.use();
+    args_shader_.setBool("afterSimulation", true);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    sort();
+
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    alive_index_ ^= 1;
+
+    timer_.end();
+}
+
+void ParticleSystem::sort()
+{
+    // the dispatches cover the sort size the args pass wrote, the passes for longer sequences
+    // find it already sorted. Their number only depends on the capacity
+    sort_shader_.use();
+    sort_shader_.setInt("stage", k_stage_presort);
+    glDispatchComputeIndirect(offsetof(Counters, sort_args));
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    for (uint32_t sequence = 2 * k_sort_block; sequence <= capacity_; sequence *= 2)
+    {
+        sort_shader_.setUint("sequenceSize", sequence);
+        sort_shader_.setInt("stage", k_stage_global);
+        for (uint32_t stride = sequence / 2; stride >= k_sort_block; stride /= 2)
+        {
+            sort_shader_.setUint("stride", stride);
+            glDispatchComputeIndirect(offsetof(Counters, sort_args));
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        sort_shader_.setInt("stage", k_stage_local);
+        glDispatchComputeIndirect(offsetof(Counters, sort_args));
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+}
+
+void ParticleSystem::draw(const glm::mat4& view, const glm::mat4& projection, float size)
+{
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    // a velocity target next to the color keeps the motion of the surface behind
+    glColorMaski(1, GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+    render_shader_.use();
+    render_shader_.setMat4fv("view", glm::value_ptr(view));
+    render_shader_.setMat4fv("projection", glm::value_ptr(projection));
+    render_shader_.setFloat("particleSize", size);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_particle_binding, particle_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_draw_list_binding, draw_list_buffer_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, counter_buffer_);
+    glBindVertexArray(vao_);
+    glDrawArraysIndirect(GL_TRIANGLES,
+                         reinterpret_cast<const void*>(offsetof(Counters, draw_args)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glColorMaski(1, GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+}
+
+ParticleSystem::Statistics ParticleSystem::readStatistics() const
+{
+    Counters counters;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counter_buffer_);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Counters), &counters);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    Statistics statistics;
+    statistics.alive      = counters.alive_count;
+    statistics.visible    = counters.draw_args[1];
+    statistics.dead       = counters.dead_count;
+    statistics.bounds_min = glm::vec3(0.f);
+    statistics.bounds_max = glm::vec3(0.f);
+    if (statistics.alive > 0)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            statistics.bounds_min[axis] = fromOrderedBits(counters.bounds_min[axis]);
+            statistics.bounds_max[axis] = fromOrderedBits(counters.bounds_max[axis]);
+        }
+    }
+    return statistics;
+}
+
+size_t ParticleSystem::getMemoryUsage() const
+{
+    return capacity_ * (sizeof(Particle) + 3 * sizeof(uint32_t) + sizeof(glm::uvec2)) +
+           sizeof(Counters);
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gpu_timer.h"
+#include "shader.h"
+
+// one source of particles, and the ground they bounce off
+struct ParticleEmitter
+{
+    glm::vec3 position {0.f};
+    float     radius {0.1f}; // particles start anywhere within this sphere
+    glm::vec3 velocity {0.f, 3.f, 0.f};
+    float     spread {1.f};       // random velocity added in every direction
+    float     rate {10000.f};     // particles per second
+    float     lifetime_min {1.f}; // seconds
+    float     lifetime_max {3.f};
+    float     size {0.02f}; // half extent of the quads
+    float     ground {-0.5f};
+};
+
+// Particles that live entirely in GPU storage buffers. Every frame runs in compute:
+//   - args: clamps the requested emission to the free particles and writes the dispatch sizes,
+//   - emit: pops particles off the dead list and appends them to the alive list,
+//   - simulate: ages and integrates the alive particles, appends the survivors to the next alive
+//     list and the dead ones to the dead list, grows the bounds, and appends the survivors in the
+//     view frustum to the draw list keyed by their view distance,
+//   - sort: a bitonic sort of the draw list back to front, blocks of 1024 keys in shared memory,
+//   - draw: one instanced quad per entry of the draw list, its count written by the GPU.
+// The CPU only issues a fixed number of commands per frame whatever the particle count, the
+// indirect dispatch and draw sizes come from the counters the passes update.
+class ParticleSystem {
+public:
+    // particles the system can hold, rounded up to a power of two of at least 1024
+    explicit ParticleSystem(uint32_t capacity);
+    ~ParticleSystem();
+
+    ParticleSystem(const ParticleSystem&) = delete;
+    ParticleSystem& operator=(const ParticleSystem&) = delete;
+
+    uint32_t getCapacity() const
+    {
+        return capacity_;
+    }
+
+    // kills every particle
+    void reset();
+
+    // emits the particles of delta_time, simulates, culls against the frustum of view_projection
+    // and sorts what is left by its distance to camera_position
+    void update(float                  delta_time,
+                const ParticleEmitter& emitter,
+                const glm::vec3&       camera_position,
+                const glm::mat4&       view_projection);
+
+    // alpha blended over the bound framebuffer, depth tested without writing depth
+    void draw(const glm::mat4& view, const glm::mat4& projection, float size);
+
+    struct Statistics
+    {
+        uint32_t  alive;
+        uint32_t  visible;
+        uint32_t  dead;
+        glm::vec3 bounds_min; // of the alive particles
+        glm::vec3 bounds_max;
+    };
+
+    // reads the counters of the last update back, stalls until it is done so only for tests and
+    // reports
+    Statistics readStatistics() const;
+
+    float getGpuMs() const
+    {
+        return timer_.getElapsedMs();
+    }
+
+    // particle, list and counter buffers in bytes
+    size_t getMemoryUsage() const;
+
+private:
+    // std430 mirror of Counters in the particle shaders. The first words are the indirect draw
+    // and dispatch commands, so the buffer is bound as those directly
+    struct Counters
+    {
+        uint32_t draw_args[4]; // vertices, instances = visible particles, first, base instance
+        uint32_t emit_args[3];
+        uint32_t simulate_args[3];
+        uint32_t sort_args[3];
+        uint32_t alive_count;
+        uint32_t next_alive_count;
+        uint32_t dead_count;
+        uint32_t emit_count;
+        uint32_t sort_size;     // visible count rounded up to a power of two
+        uint32_t bounds_min[3]; // floats with their bits ordered as integers
+        uint32_t bounds_max[3];
+    };
+
+    void sort();
+
+    uint32_t capacity_;
+
+    uint32_t particle_buffer_ {0};
+    uint32_t dead_buffer_ {0};
+    uint32_t alive_buffers_[2] {0, 0}; // current and next, swapped every update
+    uint32_t draw_list_buffer_ {0};    // distance key and particle index of the visible ones
+    uint32_t counter_buffer_ {0};
+    uint32_t vao_ {0};
+
+    uint32_t alive_index_ {0};
+    float    emit_remainder_ {0.f}; // fraction of a particle left over from the last update
+    uint32_t frame_ {0};
+
+    Shader   args_shader_;
+    Shader   emit_shader_;
+    Shader   simulate_shader_;
+    Shader   sort_shader_;
+    Shader   render_shader_;
+    GpuTimer timer_;
+};
@@ -0,0 +1,449 @@
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <utility>
+
+#include "light.h"
+#include "mesh.h"
+#include "point_shadow_atlas.h"
+
+// std430 mirror of an entry of the PointShadows buffer
+struct GpuPointShadow
+{
+    glm::ivec4 atlas; // tier (-1 when unshadowed), cube slot, resolution, unused
+    glm::vec4  depth; // window depth = x - y / major axis distance, unused, unused
+};
+
+// lights smaller than this fraction of the screen height get no shadows
+static constexpr float k_min_importance = 1.f / 32.f;
+// how far past a tier boundary (in tiers) a light keeps its tier, to avoid re-rendering lights
+// that sit right on the boundary
+static constexpr float k_tier_hysteresis = 0.25f;
+// a light without a valid cube is unshadowed, refresh it before any stale one
+static constexpr float k_new_cube_priority = 1000.f;
+static constexpr float k_near_ratio        = 0.01f;
+
+static const glm::vec3 k_face_directions[6] = {glm::vec3(1.f, 0.f, 0.f),
+                                               glm::vec3(-1.f, 0.f, 0.f),
+                                               glm::vec3(0.f, 1.f, 0.f),
+                                               glm::vec3(0.f, -1.f, 0.f),
+                                               glm::vec3(0.f, 0.f, 1.f),
+                                               glm::vec3(0.f, 0.f, -1.f)};
+static const glm::vec3 k_face_ups[6]        = {glm::vec3(0.f, -1.f, 0.f),
+                                               glm::vec3(0.f, -1.f, 0.f),
+                                               glm::vec3(0.f, 0.f, 1.f),
+                                               glm::vec3(0.f, 0.f, -1.f),
+                                               glm::vec3(0.f, -1.f, 0.f),
+                                               glm::vec3(0.f, -1.f, 0.f)};
+
+static bool hasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint index = 0; index < count; index++)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, index));
+        if (std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+PointShadowAtlas::PointShadowAtlas(uint32_t top_resolution, uint32_t top_slots) :
+    update_budget_(2 * 6 * static_cast<uint64_t>(top_resolution) * top_resolution),
+    layered_(hasExtension("GL_ARB_shader_viewport_layer_array")),
+    depth_shader_("../../../shader/point_shadow_depth.vs", "../../../shader/shadow_depth.fs")
+{
+    for (uint32_t index = 0; index < k_tier_count; index++)
+    {
+        Tier& tier      = tiers_[index];
+        tier.resolution = std::max(top_resolution >> index, 1u);
+        tier.owners.assign(top_slots << index, -1);
+
+        glGenTextures(1, &tier.texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tier.texture);
+        glTexStorage3D(GL_TEXTURE_CUBE_MAP_ARRAY,
+                       1,
+                       GL_DEPTH_COMPONENT16,
+                       tier.resolution,
+                       tier.resolution,
+                       6 * static_cast<GLsizei>(tier.owners.size()));
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(
+            GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, 0);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &ssbo_);
+
+    std::cout << "Info: Point shadow atlas " << tiers_[0].resolution << "^2 to "
+              << tiers_[k_tier_count - 1].resolution << "^2, "
+              << getMemoryUsage() / (1024 * 1024) << " MB, "
+              << (layered_ ? "single pass" : "one pass per face") << std::endl;
+}
+
+PointShadowAtlas::~PointShadowAtlas()
+{
+    for (auto& tier : tiers_)
+    {
+        glDeleteTextures(1, &tier.texture);
+    }
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteBuffers(1, &ssbo_);
+}
+
+void PointShadowAtlas::update(const std::vector<PointLight>&   lights,
+                              const glm::mat4&                 view,
+                              const glm::mat4&                 projection,
+                              const std::vector<ShadowCaster>& casters)
+{
+    stats_ = Stats();
+    timer_.begin();
+    frame_++;
+
+    if (states_.size() != lights.size())
+    {
+        for (auto& tier : tiers_)
+        {
+            std::fill(tier.owners.begin(), tier.owners.end(), -1);
+        }
+        states_.assign(lights.size(), LightState());
+    }
+
+    // world-space bounds of the casters, min and max per caster
+    std::vector<glm::vec3> caster_bounds(2 * casters.size());
+    for (size_t index = 0; index < casters.size(); index++)
+    {
+        const Mesh& mesh    = *casters[index].mesh;
+        glm::vec3   box_min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3   box_max = glm::vec3(-std::numeric_limits<float>::max());
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 local(corner & 1 ? mesh.bounds_max.x : mesh.bounds_min.x,
+                                  corner & 2 ? mesh.bounds_max.y : mesh.bounds_min.y,
+                                  corner & 4 ? mesh.bounds_max.z : mesh.bounds_min.z);
+            const glm::vec3 world = glm::vec3(casters[index].transform * glm::vec4(local, 1.f));
+            box_min               = glm::min(box_min, world);
+            box_max               = glm::max(box_max, world);
+        }
+        caster_bounds[2 * index]     = box_min;
+        caster_bounds[2 * index + 1] = box_max;
+    }
+
+    // frustum planes, a sphere outside of any of them is off screen
+    const glm::mat4 view_projection = glm::transpose(projection * view);
+    glm::vec4       planes[6];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        planes[2 * axis]     = view_projection[3] + view_projection[axis];
+        planes[2 * axis + 1] = view_projection[3] - view_projection[axis];
+    }
+    for (auto& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+
+    // the importance of a light is the projected radius of its sphere of influence over the half
+    // height of the screen
+    for (size_t index = 0; index < lights.size(); index++)
+    {
+        LightState&       state  = states_[index];
+        const PointLight& light  = lights[index];
+        const float       radius = light.getRadius();
+        if (light.position != state.position || radius != state.radius)
+        {
+            state.position = light.position;
+            state.radius   = radius;
+            state.valid    = false;
+        }
+
+        bool visible = true;
+        for (const auto& plane : planes)
+        {
+            visible = visible && glm::dot(plane, glm::vec4(state.position, 1.f)) > -radius;
+        }
+
+        const float distance = glm::length(glm::vec3(view * glm::vec4(state.position, 1.f)));
+        if (!visible)
+            state.importance = 0.f;
+        else if (distance <= radius)
+            state.importance = 1.f;
+        else
+            state.importance = glm::min(
+                projection[1][1] * radius / glm::sqrt(distance * distance - radius * radius), 1.f);
+    }
+
+    // choose the tiers by decreasing importance, tiers halve in resolution as the light halves in
+    // size on screen and a light that doesn't fit in its tier falls back to the next one
+    std::vector<uint32_t> order(lights.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs) {
+        return states_[lhs].importance > states_[rhs].importance;
+    });
+
+    size_t capacity[k_tier_count];
+    for (uint32_t index = 0; index < k_tier_count; index++)
+    {
+        capacity[index] = tiers_[index].owners.size();
+    }
+
+    std::vector<int32_t> targets(lights.size(), -1);
+    for (uint32_t index : order)
+    {
+        const LightState& state = states_[index];
+        if (state.importance < k_min_importance)
+            break;
+
+        const float level = -glm::log2(state.importance);
+        int32_t     tier  = glm::min(static_cast<int32_t>(level), int32_t(k_tier_count) - 1);
+        if (state.tier >= 0 && level > state.tier - k_tier_hysteresis &&
+            level < state.tier + 1 + k_tier_hysteresis)
+            tier = state.tier;
+
+        while (tier < int32_t(k_tier_count) && capacity[tier] == 0)
+        {
+            tier++;
+        }
+        if (tier == int32_t(k_tier_count))
+            continue;
+
+        capacity[tier]--;
+        targets[index] = tier;
+    }
+
+    // free the slots of the lights that change tier first, so their slots can be reused below
+    for (size_t index = 0; index < lights.size(); index++)
+    {
+        LightState& state = states_[index];
+        if (state.tier >= 0 && state.tier != targets[index])
+        {
+            tiers_[state.tier].owners[state.slot] = -1;
+            state.tier                            = -1;
+            state.slot                            = -1;
+            state.valid                           = false;
+        }
+    }
+
+    std::vector<std::pair<float, uint32_t>> candidates;
+    for (size_t index = 0; index < lights.size(); index++)
+    {
+        LightState& state = states_[index];
+        if (targets[index] < 0)
+            continue;
+
+        if (state.tier < 0)
+        {
+            auto& owners = tiers_[targets[index]].owners;
+            state.tier   = targets[index];
+            state.slot   = static_cast<int32_t>(std::find(owners.begin(), owners.end(), -1) -
+                                              owners.begin());
+            owners[state.slot] = static_cast<int32_t>(index);
+        }
+
+        // cubes only go stale when a dynamic caster enters the light's sphere, or left it since
+        // the cube was drawn and its shadow has to go
+        state.stale = state.has_dynamic;
+        for (size_t caster = 0; caster < casters.size() && !state.stale; caster++)
+        {
+            const glm::vec3 closest = glm::clamp(
+                state.position, caster_bounds[2 * caster], caster_bounds[2 * caster + 1]);
+            state.stale = !casters[caster].is_static &&
+                          glm::dot(closest - state.position, closest - state.position) <
+                              state.radius * state.radius;
+        }
+
+        if (!state.valid)
+            candidates.emplace_back(k_new_cube_priority * state.importance,
+                                    static_cast<uint32_t>(index));
+        else if (state.stale)
+            candidates.emplace_back(static_cast<float>(frame_ - state.last_update) *
+                                        state.importance,
+                                    static_cast<uint32_t>(index));
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first > rhs.first;
+    });
+
+    if (!candidates.empty())
+    {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.f, 4.f);
+
+        depth_shader_.use();
+
+        uint64_t spent = 0;
+        for (const auto& candidate : candidates)
+        {
+            const LightState& state      = states_[candidate.second];
+            const uint64_t    resolution = tiers_[state.tier].resolution;
+            const uint64_t    cost       = 6 * resolution * resolution;
+            if (stats_.lights_updated > 0 && spent + cost > update_budget_)
+            {
+                stats_.lights_deferred++;
+                continue;
+            }
+
+            renderCube(candidate.second, casters, caster_bounds);
+            spent += cost;
+        }
+        stats_.texels_updated = static_cast<uint32_t>(spent);
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    std::vector<GpuPointShadow> shadows(lights.size());
+    for (size_t index = 0; index < lights.size(); index++)
+    {
+        const LightState& state = states_[index];
+        if (state.tier < 0 || !state.valid)
+        {
+            shadows[index].atlas = glm::ivec4(-1, 0, 1, 0);
+            shadows[index].depth = glm::vec4(0.f);
+            continue;
+        }
+
+        // window depth of a perspective projection as a function of the distance along the face
+        // axis, so the lighting passes can compare against the hardware depth
+        const float far_plane  = state.radius;
+        const float near_plane = far_plane * k_near_ratio;
+        shadows[index].atlas =
+            glm::ivec4(state.tier, state.slot, tiers_[state.tier].resolution, 0);
+        shadows[index].depth = glm::vec4(far_plane / (far_plane - near_plane),
+                                         far_plane * near_plane / (far_plane - near_plane),
+                                         0.f,
+                                         0.f);
+        stats_.lights_shadowed++;
+    }
+
+    if (!shadows.empty())
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_);
+        glBufferData(GL_SHADER_STORAGE_BUFFER,
+                     shadows.size() * sizeof(GpuPointShadow),
+                     shadows.data(),
+                     GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    timer_.end();
+}
+
+void PointShadowAtlas::bind(uint32_t first_texture_unit) const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, ssbo_);
+    for (uint32_t index = 0; index < k_tier_count; index++)
+    {
+        glActiveTexture(GL_TEXTURE0 + first_texture_unit + index);
+        glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, tiers_[index].texture);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+size_t PointShadowAtlas::getMemoryUsage() const
+{
+    size_t size = 0;
+    for (const auto& tier : tiers_)
+    {
+        size += static_cast<size_t>(tier.resolution) * tier.resolution * 6 * tier.owners.size() * 2;
+    }
+    return size;
+}
+
+void PointShadowAtlas::renderCube(uint32_t                         light_index,
+                                  const std::vector<ShadowCaster>& casters,
+                                  const std::vector<glm::vec3>&    caster_bounds)
+{
+    LightState& state      = states_[light_index];
+    const Tier& tier       = tiers_[state.tier];
+    const float far_plane  = state.radius;
+    const float near_plane = far_plane * k_near_ratio;
+
+    const glm::mat4 cube_projection =
+        glm::perspective(glm::radians(90.f), 1.f, near_plane, far_plane);
+    for (int face = 0; face < 6; face++)
+    {
+        const glm::mat4 face_matrix =
+            cube_projection *
+            glm::lookAt(state.position, state.position + k_face_directions[face], k_face_ups[face]);
+        depth_shader_.setMat4fv("faceMatrices[" + std::to_string(face) + "]",
+                                glm::value_ptr(face_matrix));
+    }
+
+    const GLint base_layer = 6 * state.slot;
+    const float cleared    = 1.f;
+    glClearTexSubImage(tier.texture,
+                       0,
+                       0,
+                       0,
+                       base_layer,
+                       tier.resolution,
+                       tier.resolution,
+                       6,
+                       GL_DEPTH_COMPONENT,
+                       GL_FLOAT,
+                       &cleared);
+
+    glViewport(0, 0, tier.resolution, tier.resolution);
+    depth_shader_.setInt("baseLayer", base_layer);
+    if (layered_)
+    {
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tier.texture, 0);
+    }
+
+    // one pass with every face instanced, or one pass per face without layered vertex output
+    const int passes      = layered_ ? 1 : 6;
+    bool      has_dynamic = false;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        if (!layered_)
+        {
+            glFramebufferTextureLayer(
+                GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, tier.texture, 0, base_layer + pass);
+        }
+        depth_shader_.setInt("faceOffset", pass);
+
+        for (size_t index = 0; index < casters.size(); index++)
+        {
+            const glm::vec3 closest = glm::clamp(
+                state.position, caster_bounds[2 * index], caster_bounds[2 * index + 1]);
+            if (glm::dot(closest - state.position, closest - state.position) >=
+                state.radius * state.radius)
+                continue;
+
+            depth_shader_.setMat4fv("model", glm::value_ptr(casters[index].transform));
+            casters[index].mesh->DrawGeometry(layered_ ? 6 : 1);
+            stats_.draw_calls++;
+            has_dynamic |= !casters[index].is_static;
+        }
+    }
+
+    state.valid       = true;
+    state.stale       = false;
+    state.has_dynamic = has_dynamic;
+    state.last_update = frame_;
+    stats_.lights_updated++;
+}
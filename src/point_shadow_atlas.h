@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "gpu_timer.h"
+#include "shader.h"
+#include "shadow_map.h"
+
+class PointLight;
+
+// Cube shadow maps for point lights, kept in a shadow atlas of a few resolution tiers.
+//
+// Every tier is a depth cube map array: the top tier has the highest resolution and the fewest
+// slots, each further tier halves the resolution and doubles the slot count. A light's tier
+// follows its size on screen and it keeps its slot for as long as its tier doesn't change, so its
+// cube stays valid across frames. A cube is drawn in one pass, each caster is instanced once per
+// face and the vertex shader routes the instance to its cube face with gl_Layer.
+//
+// Only lights whose cube is new, or that a dynamic caster moves through, need a refresh. They are
+// refreshed by priority until the per-frame texel budget is used up, the others keep their old
+// cube or stay unshadowed until their first refresh.
+class PointShadowAtlas {
+public:
+    static constexpr uint32_t k_tier_count = 4;
+
+    struct Stats
+    {
+        uint32_t lights_shadowed {0};
+        uint32_t lights_updated {0};
+        uint32_t lights_deferred {0}; // needed a refresh but didn't fit in the budget
+        uint32_t texels_updated {0};
+        uint32_t draw_calls {0};
+    };
+
+    PointShadowAtlas(uint32_t top_resolution, uint32_t top_slots);
+    ~PointShadowAtlas();
+
+    PointShadowAtlas(const PointShadowAtlas&) = delete;
+    PointShadowAtlas& operator=(const PointShadowAtlas&) = delete;
+
+    // cube texels (6 * resolution^2 per light) that may be rendered per frame. At least one light
+    // is refreshed per frame whatever the budget
+    void setUpdateBudget(uint64_t texels)
+    {
+        update_budget_ = texels;
+    }
+    uint64_t getUpdateBudget() const
+    {
+        return update_budget_;
+    }
+
+    // assigns the lights to tiers from their screen-space size, refreshes the cubes that fit in
+    // the budget and uploads the PointShadows buffer
+    void update(const std::vector<PointLight>&   lights,
+                const glm::mat4&                 view,
+                const glm::mat4&                 projection,
+                const std::vector<ShadowCaster>& casters);
+
+    // binds the PointShadows buffer to storage binding 6 and the tiers to consecutive texture
+    // units from first_texture_unit
+    void bind(uint32_t first_texture_unit) const;
+
+    const Stats& getStats() const
+    {
+        return stats_;
+    }
+    float getGpuMs() const
+    {
+        return timer_.getElapsedMs();
+    }
+    size_t getMemoryUsage() const;
+
+private:
+    struct LightState
+    {
+        int32_t   tier {-1};
+        int32_t   slot {-1};
+        bool      valid {false};       // the cube holds this light's shadows
+        bool      stale {false};       // a dynamic caster moved through the light
+        bool      has_dynamic {false}; // the cube holds the shadow of a dynamic caster
+        uint32_t  last_update {0};
+        float     importance {0.f};
+        glm::vec3 position {0.f};
+        float     radius {0.f};
+    };
+
+    struct Tier
+    {
+        uint32_t             resolution;
+        uint32_t             texture;
+        std::vector<int32_t> owners; // light holding each slot, -1 when free
+    };
+
+    void renderCube(uint32_t                         light_index,
+                    const std::vector<ShadowCaster>& casters,
+                    const std::vector<glm::vec3>&    caster_bounds);
+
+    Tier                    tiers_[k_tier_count];
+    std::vector<LightState> states_;
+    uint64_t                update_budget_;
+    uint32_t                frame_ {0};
+    bool                    layered_;
+
+    uint32_t fbo_ {0};
+    uint32_t ssbo_ {0};
+
+    Shader   depth_shader_;
+    GpuTimer timer_;
+    Stats    stats_;
+};
@@ -0,0 +1,242 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "post_aa.h"
+
+// area texture: 5x5 slots of k_area_slot x k_area_slot texels
+static constexpr uint32_t k_area_slot = 16;
+static constexpr uint32_t k_area_size = 5 * k_area_slot;
+
+// search texture: 33x33 fetched values per search direction
+static constexpr uint32_t k_search_slots = 33;
+
+// height of the silhouette at the end of a line, in pixels away from the edge. The crossing edge
+// code is the value read across the end times 4: 1 the crossing is on the other side of the line,
+// 3 on the side of the current pixel, 0 and 4 tell nothing about the slope
+static float crossingHeight(uint32_t code)
+{
+    if (code == 1)
+        return 0.5f;
+    if (code == 3)
+        return -0.5f;
+    return 0.f;
+}
+
+// Coverage of the pixel first pixels from one end of a line of edges, with the silhouette
+// revectorized from the crossing edges at both ends. A crossing on one end only gives an L, the
+// silhouette meets the edge halfway; crossings on the same side give a U, on opposite sides a Z
+// going straight from one end to the other. x is the part of the current pixel behind the
+// silhouette, y the part of the pixel across the edge in front of it
+static glm::vec2 orthogonalArea(uint32_t code1, uint32_t code2, float first, float second)
+{
+    const float height1 = crossingHeight(code1);
+    const float height2 = crossingHeight(code2);
+    const float length  = first + second + 1.f;
+    const bool  z_shape = height1 * height2 < 0.f;
+
+    auto height = [&](float x) {
+        if (z_shape)
+            return height1 + (height2 - height1) * x / length;
+        if (x < 0.5f * length)
+            return height1 * (1.f - 2.f * x / length);
+        return height2 * (2.f * x / length - 1.f);
+    };
+
+    // the silhouette may cross the edge inside the pixel, integrate both sides numerically
+    const int steps = 64;
+    glm::vec2 area(0.f);
+    for (int step = 0; step < steps; step++)
+    {
+        const float h = height(first + (step + 0.5f) / steps);
+        area.x += std::max(-h, 0.f) / steps;
+        area.y += std::max(h, 0.f) / steps;
+    }
+    return area;
+}
+
+// one bilinear search fetch reads the edges of two pixels on two rows. Bit 3 is the near pixel on
+// the line's row, 2 the far one, 1 and 0 the same on the other row, with weights
+// 21/32, 7/32, 3/32 and 1/32
+static bool decodeFetch(uint32_t value, bool bits[4])
+{
+    static const uint32_t k_weights[4] = {1, 3, 7, 21};
+    for (uint32_t combination = 0; combination < 16; combination++)
+    {
+        uint32_t sum = 0;
+        for (uint32_t bit = 0; bit < 4; bit++)
+        {
+            bits[bit] = (combination >> bit) & 1;
+            sum += bits[bit] ? k_weights[bit] : 0;
+        }
+        if (sum == value)
+            return true;
+    }
+    return false;
+}
+
+// pixels of the last fetch the line still covers, searching away from where crossing edges are
+// stored (left, up): the near pixel continues the line if it has the edge, the far one if it has
+// it too and nothing crosses between them
+static uint8_t searchDeltaFirst(const bool crossing[4], const bool line[4])
+{
+    uint8_t delta = 0;
+    if (line[3])
+        delta++;
+    if (delta == 1 && line[2] && !crossing[1] && !crossing[3])
+        delta++;
+    return delta;
+}
+
+// toward where crossing edges are stored (right, down), the crossing edge of a pixel lies between
+// it and the pixel before it
+static uint8_t searchDeltaSecond(const bool crossing[4], const bool line[4])
+{
+    uint8_t delta = 0;
+    if (line[3] && !crossing[1] && !crossing[3])
+        delta++;
+    if (delta == 1 && line[2] && !crossing[0] && !crossing[2])
+        delta++;
+    return delta;
+}
+
+PostAntiAliasing::PostAntiAliasing() :
+    edges_shader_("../../../shader/fullscreen.vs", "../../../shader/smaa_edges.fs"),
+    weights_shader_("../../../shader/fullscreen.vs", "../../../shader/smaa_weights.fs")
+{
+    // the fullscreen triangle has no attributes, core profile still needs a vertex array
+    glGenVertexArrays(1, &vao_);
+
+    createLookupTextures();
+}
+
+PostAntiAliasing::~PostAntiAliasing()
+{
+    const uint32_t textures[] = {area_tex_, search_tex_};
+    glDeleteTextures(2, textures);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void PostAntiAliasing::smaaEdges(uint32_t source_texture,
+                                 uint32_t width,
+                                 uint32_t height,
+                                 uint32_t exposure_buffer)
+{
+    timer_.begin();
+
+    // the searches may fetch past the render area, it has to read as no edges
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glDisable(GL_DEPTH_TEST);
+
+    edges_shader_.use();
+    edges_shader_.setVec2i("renderSize", width, height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, source_texture);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, exposure_buffer);
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void PostAntiAliasing::smaaWeights(uint32_t edges_texture,
+                                   uint32_t storage_width,
+                                   uint32_t storage_height)
+{
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    weights_shader_.use();
+    weights_shader_.setVec2f("sourceSize", (float)storage_width, (float)storage_height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, edges_texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, area_tex_);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, search_tex_);
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    timer_.end();
+}
+
+void PostAntiAliasing::createLookupTextures()
+{
+    // area texture, the slot is picked by the crossing codes at both ends and the texel within
+    // it by the square root of the distances, which keeps long lines in a small texture
+    std::vector<uint8_t> area(k_area_size * k_area_size * 2, 0);
+    for (uint32_t code1 : {0u, 1u, 3u, 4u})
+    {
+        for (uint32_t code2 : {0u, 1u, 3u, 4u})
+        {
+            for (uint32_t y = 0; y < k_area_slot; y++)
+            {
+                for (uint32_t x = 0; x < k_area_slot; x++)
+                {
+                    const glm::vec2 value = orthogonalArea(
+                        code1, code2, static_cast<float>(x * x), static_cast<float>(y * y));
+
+                    const size_t texel =
+                        (code2 * k_area_slot + y) * k_area_size + code1 * k_area_slot + x;
+                    area[texel * 2]     = static_cast<uint8_t>(value.x * 255.f + 0.5f);
+                    area[texel * 2 + 1] = static_cast<uint8_t>(value.y * 255.f + 0.5f);
+                }
+            }
+        }
+    }
+
+    glGenTextures(1, &area_tex_);
+    glBindTexture(GL_TEXTURE_2D, area_tex_);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_RG8,
+                 k_area_size,
+                 k_area_size,
+                 0,
+                 GL_RG,
+                 GL_UNSIGNED_BYTE,
+                 area.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // search texture, indexed by the fetched crossing and line values times 32, the first half
+    // for the searches left and up, the second for right and down
+    std::vector<uint8_t> search(2 * k_search_slots * k_search_slots, 0);
+    for (uint32_t line_value = 0; line_value < k_search_slots; line_value++)
+    {
+        for (uint32_t crossing_value = 0; crossing_value < k_search_slots; crossing_value++)
+        {
+            bool line[4], crossing[4];
+            if (!decodeFetch(line_value, line) || !decodeFetch(crossing_value, crossing))
+                continue;
+
+            const size_t row = line_value * 2 * k_search_slots;
+            search[row + crossing_value] = searchDeltaFirst(crossing, line);
+            search[row + k_search_slots + crossing_value] = searchDeltaSecond(crossing, line);
+        }
+    }
+
+    glGenTextures(1, &search_tex_);
+    glBindTexture(GL_TEXTURE_2D, search_tex_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_R8UI,
+                 2 * k_search_slots,
+                 k_search_slots,
+                 0,
+                 GL_RED_INTEGER,
+                 GL_UNSIGNED_BYTE,
+                 search.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
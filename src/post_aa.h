@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+#include "gpu_timer.h"
+#include "shader.h"
+
+// Analysis passes of SMAA 1x, the edge detection and the blending weights, each into its own
+// target. The neighborhood blending that applies the weights, like FXAA, is fused into the final
+// post-processing dispatch (PostProcessing::resolve) and needs no pass of its own.
+//
+// The area and search lookup textures are computed at construction instead of being shipped, the
+// area texture only has the orthogonal patterns (no diagonal or corner detection, SMAA 1x without
+// its optional features).
+//
+// Every pass draws a fullscreen triangle into the bound framebuffer whose viewport covers the
+// render area, the bottom-left width x height of the storage_width x storage_height textures.
+class PostAntiAliasing {
+public:
+    PostAntiAliasing();
+    ~PostAntiAliasing();
+
+    PostAntiAliasing(const PostAntiAliasing&) = delete;
+    PostAntiAliasing& operator=(const PostAntiAliasing&) = delete;
+
+    // into an RG8 target, from the HDR scene with the exposure of PostProcessing
+    void smaaEdges(uint32_t source_texture,
+                   uint32_t width,
+                   uint32_t height,
+                   uint32_t exposure_buffer);
+    // into an RGBA8 target, the edges texture must be linearly filtered
+    void smaaWeights(uint32_t edges_texture, uint32_t storage_width, uint32_t storage_height);
+
+    // time of both SMAA passes
+    float getGpuMs() const
+    {
+        return timer_.getElapsedMs();
+    }
+
+private:
+    void createLookupTextures();
+
+    uint32_t vao_ {0};
+    uint32_t area_tex_ {0};
+    uint32_t search_tex_ {0};
+
+    Shader   edges_shader_;
+    Shader   weights_shader_;
+    GpuTimer timer_;
+};
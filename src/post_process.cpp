@@ -0,0 +1,317 @@
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include "post_process.h"
+
+static constexpr uint32_t k_tile_size  = 64; // of the first mip, per downsample workgroup
+static constexpr uint32_t k_group_size = 8;
+
+// the auto-exposure averages the pixels between these percentiles of the histogram
+static constexpr float k_low_percentile  = 0.5f;
+static constexpr float k_high_percentile = 0.95f;
+// rate at which the exposure closes the gap to its target, per second
+static constexpr float k_adaptation_speed = 1.5f;
+
+static constexpr float k_bloom_strength = 0.04f;
+
+static const char* k_stage_names[PostProcessing::k_stage_count] = {
+    "downsample", "exposure", "upsample", "final"};
+
+static constexpr uint32_t k_downsample = static_cast<uint32_t>(PostProcessing::Stage::downsample);
+static constexpr uint32_t k_exposure   = static_cast<uint32_t>(PostProcessing::Stage::exposure);
+static constexpr uint32_t k_upsample   = static_cast<uint32_t>(PostProcessing::Stage::upsample);
+static constexpr uint32_t k_final      = static_cast<uint32_t>(PostProcessing::Stage::final);
+
+static uint32_t mipSize(uint32_t size, uint32_t mip)
+{
+    return std::max(size >> mip, 1u);
+}
+
+PostProcessing::PostProcessing(uint32_t width, uint32_t height) :
+    width_(width),
+    height_(height),
+    downsample_shader_("../../../shader/post_downsample.cs"),
+    exposure_shader_("../../../shader/post_exposure.cs"),
+    upsample_shader_("../../../shader/post_upsample.cs"),
+    final_shader_("../../../shader/post_final.cs")
+{
+    glGenBuffers(1, &histogram_buffer_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, histogram_buffer_);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER,
+                    k_histogram_bins * sizeof(uint32_t),
+                    nullptr,
+                    GL_DYNAMIC_STORAGE_BIT);
+    const uint32_t zero = 0;
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    // a zero luminance tells the exposure stage it has no previous value to adapt from
+    const float exposure[2] = {0.f, 1.f};
+    glGenBuffers(1, &exposure_buffer_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, exposure_buffer_);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, sizeof(exposure), exposure, 0);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    exposure_shader_.use();
+    exposure_shader_.setFloat("lowPercentile", k_low_percentile);
+    exposure_shader_.setFloat("highPercentile", k_high_percentile);
+
+    final_shader_.use();
+    final_shader_.setFloat("bloomStrength", k_bloom_strength);
+
+    createTargets();
+}
+
+PostProcessing::~PostProcessing()
+{
+    destroyTargets();
+
+    const uint32_t buffers[] = {histogram_buffer_, exposure_buffer_};
+    glDeleteBuffers(2, buffers);
+}
+
+void PostProcessing::resize(uint32_t width, uint32_t height)
+{
+    if (width == width_ && height == height_)
+        return;
+
+    width_  = width;
+    height_ = height;
+
+    destroyTargets();
+    createTargets();
+}
+
+void PostProcessing::bloom(uint32_t scene_texture,
+                           uint32_t width,
+                           uint32_t height,
+                           uint32_t storage_width,
+                           uint32_t storage_height,
+                           float    delta_time)
+{
+    bloom_area_width_  = std::max(width / 2, 1u);
+    bloom_area_height_ = std::max(height / 2, 1u);
+
+    // R11F_G11F_B10F texels of a mip in use
+    auto mip_bytes = [this](uint32_t mip) {
+        return static_cast<size_t>(mipSize(bloom_area_width_, mip)) *
+               mipSize(bloom_area_height_, mip) * 4;
+    };
+
+    size_t chain_bytes = 0;
+    for (uint32_t mip = 0; mip < k_bloom_mips; mip++)
+    {
+        chain_bytes += mip_bytes(mip);
+    }
+
+    // downsample, every mip of the chain and the histogram in one dispatch
+    timers_[k_downsample].begin();
+
+    const uint32_t groups_x = (bloom_area_width_ + k_tile_size - 1) / k_tile_size;
+    const uint32_t groups_y = (bloom_area_height_ + k_tile_size - 1) / k_tile_size;
+
+    downsample_shader_.use();
+    downsample_shader_.setVec2f("sceneSize", (float)storage_width, (float)storage_height);
+    downsample_shader_.setVec2f("renderSize", (float)width, (float)height);
+    downsample_shader_.setVec2i("bloomSize", bloom_area_width_, bloom_area_height_);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene_texture);
+    for (uint32_t mip = 0; mip < k_bloom_mips; mip++)
+    {
+        glBindImageTexture(mip, bloom_tex_, mip, GL_FALSE, 0, GL_WRITE_ONLY, GL_R11F_G11F_B10F);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, histogram_buffer_);
+    glDispatchCompute(groups_x, groups_y, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                    GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    timers_[k_downsample].end();
+    stats_[k_downsample].bytes_read    = static_cast<size_t>(width) * height * 8;
+    stats_[k_downsample].bytes_written = chain_bytes + groups_x * groups_y * k_histogram_bins * 4;
+
+    // exposure, stays on the GPU for the final stage to read
+    timers_[k_exposure].begin();
+
+    const float adaptation =
+        exposure_reset_ ? 1.f : 1.f - std::exp(-delta_time * k_adaptation_speed);
+    exposure_reset_ = false;
+
+    exposure_shader_.use();
+    exposure_shader_.setFloat("adaptation", adaptation);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, exposure_buffer_);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    timers_[k_exposure].end();
+    stats_[k_exposure].bytes_read    = k_histogram_bins * 4 + 8;
+    stats_[k_exposure].bytes_written = k_histogram_bins * 4 + 8;
+
+    // upsample, from the smallest mip into the first one
+    timers_[k_upsample].begin();
+
+    upsample_shader_.use();
+    glBindTexture(GL_TEXTURE_2D, bloom_tex_);
+    stats_[k_upsample].bytes_read    = 0;
+    stats_[k_upsample].bytes_written = 0;
+    for (uint32_t mip = k_bloom_mips - 1; mip-- > 0;)
+    {
+        const uint32_t area_width  = mipSize(bloom_area_width_, mip);
+        const uint32_t area_height = mipSize(bloom_area_height_, mip);
+
+        upsample_shader_.setInt("sourceMip", mip + 1);
+        upsample_shader_.setVec2f("sourceSize",
+                                  (float)mipSize(bloom_width_, mip + 1),
+                                  (float)mipSize(bloom_height_, mip + 1));
+        upsample_shader_.setVec2f("sourceArea",
+                                  (float)mipSize(bloom_area_width_, mip + 1),
+                                  (float)mipSize(bloom_area_height_, mip + 1));
+        upsample_shader_.setVec2i("targetArea", area_width, area_height);
+        glBindImageTexture(0, bloom_tex_, mip, GL_FALSE, 0, GL_READ_WRITE, GL_R11F_G11F_B10F);
+
+        glDispatchCompute((area_width + k_group_size - 1) / k_group_size,
+                          (area_height + k_group_size - 1) / k_group_size,
+                          1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        stats_[k_upsample].bytes_read += mip_bytes(mip) + mip_bytes(mip + 1);
+        stats_[k_upsample].bytes_written += mip_bytes(mip);
+    }
+
+    timers_[k_upsample].end();
+}
+
+void PostProcessing::resolve(uint32_t scene_texture,
+                             uint32_t output_texture,
+                             uint32_t width,
+                             uint32_t height,
+                             uint32_t storage_width,
+                             uint32_t storage_height,
+                             Filter   filter,
+                             uint32_t weights_texture)
+{
+    timers_[k_final].begin();
+
+    final_shader_.use();
+    final_shader_.setVec2f("sceneSize", (float)storage_width, (float)storage_height);
+    final_shader_.setVec2i("renderSize", width, height);
+    final_shader_.setVec2f("bloomSize", (float)bloom_width_, (float)bloom_height_);
+    final_shader_.setVec2f("bloomArea", (float)bloom_area_width_, (float)bloom_area_height_);
+    final_shader_.setInt("filterMode", static_cast<int>(filter));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, scene_texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, bloom_tex_);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, filter == Filter::smaa ? weights_texture : 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindImageTexture(0, output_texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, exposure_buffer_);
+
+    glDispatchCompute(
+        (width + k_group_size - 1) / k_group_size, (height + k_group_size - 1) / k_group_size, 1);
+    // sampled by the present pass, or read back
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    timers_[k_final].end();
+
+    // RGBA16F scene, first bloom mip and RGBA8 weights in, RGBA8 out
+    const size_t pixels = static_cast<size_t>(width) * height;
+    const size_t bloom_bytes =
+        static_cast<size_t>(bloom_area_width_) * bloom_area_height_ * 4;
+    stats_[k_final].bytes_read    = pixels * 8 + bloom_bytes;
+    stats_[k_final].bytes_written = pixels * 4;
+    if (filter == Filter::smaa)
+        stats_[k_final].bytes_read += pixels * 4;
+
+    for (uint32_t stage = 0; stage < k_stage_count; stage++)
+    {
+        stats_[stage].gpu_ms = timers_[stage].getElapsedMs();
+    }
+}
+
+float PostProcessing::getGpuMs() const
+{
+    float total = 0.f;
+    for (const StageStats& stats : stats_)
+    {
+        total += stats.gpu_ms;
+    }
+    return total;
+}
+
+size_t PostProcessing::getBytesRead() const
+{
+    size_t total = 0;
+    for (const StageStats& stats : stats_)
+    {
+        total += stats.bytes_read;
+    }
+    return total;
+}
+
+size_t PostProcessing::getBytesWritten() const
+{
+    size_t total = 0;
+    for (const StageStats& stats : stats_)
+    {
+        total += stats.bytes_written;
+    }
+    return total;
+}
+
+void PostProcessing::report(std::ostream& out) const
+{
+    out << "Post-processing, bloom " << k_bloom_mips << " mips from "
+        << bloom_area_width_ << "x" << bloom_area_height_ << std::endl;
+
+    char line[128];
+    snprintf(line, sizeof(line), "%-12s %10s %10s %10s", "stage", "gpu_ms", "read_mb", "write_mb");
+    out << line << std::endl;
+    for (uint32_t stage = 0; stage < k_stage_count; stage++)
+    {
+        snprintf(line,
+                 sizeof(line),
+                 "%-12s %10.3f %10.2f %10.2f",
+                 k_stage_names[stage],
+                 stats_[stage].gpu_ms,
+                 stats_[stage].bytes_read / (1024.0 * 1024.0),
+                 stats_[stage].bytes_written / (1024.0 * 1024.0));
+        out << line << std::endl;
+    }
+    snprintf(line,
+             sizeof(line),
+             "%-12s %10.3f %10.2f %10.2f",
+             "total",
+             getGpuMs(),
+             getBytesRead() / (1024.0 * 1024.0),
+             getBytesWritten() / (1024.0 * 1024.0));
+    out << line << std::endl;
+}
+
+void PostProcessing::createTargets()
+{
+    // at least large enough for every mip to exist
+    bloom_width_  = std::max(width_ / 2, 1u << (k_bloom_mips - 1));
+    bloom_height_ = std::max(height_ / 2, 1u << (k_bloom_mips - 1));
+
+    glGenTextures(1, &bloom_tex_);
+    glBindTexture(GL_TEXTURE_2D, bloom_tex_);
+    glTexStorage2D(GL_TEXTURE_2D, k_bloom_mips, GL_R11F_G11F_B10F, bloom_width_, bloom_height_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    exposure_reset_ = true;
+}
+
+void PostProcessing::destroyTargets()
+{
+    glDeleteTextures(1, &bloom_tex_);
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "gpu_timer.h"
+#include "shader.h"
+
+// HDR post-processing in compute: bloom, histogram auto-exposure and tonemapping.
+//
+// The scene renders into RGBA16F and reaches the display in four stages, instead of a chain of
+// fullscreen passes that each store their full-resolution result for the next one to read:
+//   - downsample: a single dispatch builds the whole bloom mip chain and the luminance histogram,
+//     every workgroup reduces a 64x64 tile of the first mip in registers and shared memory,
+//   - exposure: one workgroup averages the histogram between two percentiles and adapts the
+//     exposure toward it, the result stays on the GPU,
+//   - upsample: the chain is added back up into its first mip, one small dispatch per level,
+//   - final: exposure, bloom, tonemapping and sRGB encoding fused with the FXAA or SMAA
+//     neighborhood blending, the only full-resolution write of the stack.
+// The bloom chain is half the output size and, like the scene, only used up to the render area.
+class PostProcessing {
+public:
+    static constexpr uint32_t k_bloom_mips     = 6;
+    static constexpr uint32_t k_histogram_bins = 256;
+
+    enum class Stage
+    {
+        downsample,
+        exposure,
+        upsample,
+        final
+    };
+    static constexpr uint32_t k_stage_count = 4;
+
+    // anti-aliasing filter fused into the final dispatch
+    enum class Filter
+    {
+        none,
+        fxaa,
+        smaa
+    };
+
+    struct StageStats
+    {
+        float  gpu_ms {0.f};
+        size_t bytes_read {0}; // each texel counted once, neighborhood re-reads hit the caches
+        size_t bytes_written {0};
+    };
+
+    PostProcessing(uint32_t width, uint32_t height);
+    ~PostProcessing();
+
+    PostProcessing(const PostProcessing&) = delete;
+    PostProcessing& operator=(const PostProcessing&) = delete;
+
+    // output size, the bloom chain follows it
+    void resize(uint32_t width, uint32_t height);
+
+    // the next frame jumps to its exposure instead of adapting toward it
+    void resetExposure()
+    {
+        exposure_reset_ = true;
+    }
+
+    // downsample, exposure and upsample stages on the bottom-left width x height of the scene
+    void bloom(uint32_t scene_texture,
+               uint32_t width,
+               uint32_t height,
+               uint32_t storage_width,
+               uint32_t storage_height,
+               float    delta_time);
+
+    // final stage into the same area of an RGBA8 texture. SMAA needs the blending weights of the
+    // frame, computed on the exposure of bloom()
+    void resolve(uint32_t scene_texture,
+                 uint32_t output_texture,
+                 uint32_t width,
+                 uint32_t height,
+                 uint32_t storage_width,
+                 uint32_t storage_height,
+                 Filter   filter,
+                 uint32_t weights_texture = 0);
+
+    uint32_t getBloomTexture() const
+    {
+        return bloom_tex_;
+    }
+    // two floats: adapted average luminance and exposure
+    uint32_t getExposureBuffer() const
+    {
+        return exposure_buffer_;
+    }
+
+    const StageStats& getStageStats(Stage stage) const
+    {
+        return stats_[static_cast<uint32_t>(stage)];
+    }
+    float  getGpuMs() const;
+    size_t getBytesRead() const;
+    size_t getBytesWritten() const;
+
+    // per-stage time and traffic of the last frame
+    void report(std::ostream& out) const;
+
+private:
+    void createTargets();
+    void destroyTargets();
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t bloom_width_; // of the first mip
+    uint32_t bloom_height_;
+    uint32_t bloom_tex_ {0};
+    uint32_t histogram_buffer_ {0};
+    uint32_t exposure_buffer_ {0};
+    bool     exposure_reset_ {true};
+
+    // bloom chain area of the current frame
+    uint32_t bloom_area_width_ {1};
+    uint32_t bloom_area_height_ {1};
+
+    Shader     downsample_shader_;
+    Shader     exposure_shader_;
+    Shader     upsample_shader_;
+    Shader     final_shader_;
+    GpuTimer   timers_[k_stage_count];
+    StageStats stats_[k_stage_count];
+};
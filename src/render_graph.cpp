@@ -0,0 +1,665 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+#include "render_graph.h"
+
+static constexpr RenderGraph::Resource k_no_resource = UINT32_MAX;
+
+static bool isDepthFormat(uint32_t format)
+{
+    return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 ||
+           format == GL_DEPTH_COMPONENT32F || format == GL_DEPTH24_STENCIL8 ||
+           format == GL_DEPTH32F_STENCIL8;
+}
+
+static bool hasStencil(uint32_t format)
+{
+    return format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8;
+}
+
+static uint32_t getFormatSize(uint32_t format)
+{
+    switch (format)
+    {
+    case GL_R8:
+        return 1;
+    case GL_R16F:
+    case GL_RG8:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    case GL_RGBA16F:
+    case GL_RG32F:
+    case GL_DEPTH32F_STENCIL8:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
+
+RenderGraph::Pass& RenderGraph::Pass::read(Resource resource)
+{
+    reads_.push_back(resource);
+    return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::write(Resource resource)
+{
+    writes_.push_back(resource);
+    return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::writeStorage(Resource resource)
+{
+    storage_writes_.push_back(resource);
+    return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::sideEffect()
+{
+    side_effect_ = true;
+    return *this;
+}
+
+RenderGraph::RenderGraph(uint32_t width, uint32_t height) : width_(width), height_(height)
+{}
+
+RenderGraph::~RenderGraph()
+{
+    releasePool(true);
+}
+
+void RenderGraph::setResolution(uint32_t width, uint32_t height)
+{
+    if (width == width_ && height == height_)
+        return;
+
+    width_   = width;
+    height_  = height;
+    resized_ = true;
+}
+
+void RenderGraph::reset()
+{
+    textures_.clear();
+    passes_.clear();
+    order_.clear();
+}
+
+void RenderGraph::setDynamicScale(float scale)
+{
+    dynamic_scale_ = glm::clamp(scale, 0.f, 1.f);
+}
+
+uint32_t RenderGraph::getRenderWidth() const
+{
+    return std::max(static_cast<uint32_t>(width_ * dynamic_scale_ + 0.5f), 1u);
+}
+
+uint32_t RenderGraph::getRenderHeight() const
+{
+    return std::max(static_cast<uint32_t>(height_ * dynamic_scale_ + 0.5f), 1u);
+}
+
+RenderGraph::Resource RenderGraph::createTexture(const std::string& name, const TextureDesc& desc)
+{
+    textures_.push_back(
+        makeTexture(name,
+                    desc,
+                    std::max(static_cast<uint32_t>(width_ * desc.scale + 0.5f), 1u),
+                    std::max(static_cast<uint32_t>(height_ * desc.scale + 0.5f), 1u)));
+
+    return static_cast<Resource>(textures_.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::importTexture(const std::string& name,
+                                                 uint32_t           texture,
+                                                 uint32_t           format,
+                                                 uint32_t           width,
+                                                 uint32_t           height,
+                                                 bool               dynamic)
+{
+    TextureDesc desc;
+    desc.format  = format;
+    desc.dynamic = dynamic;
+
+    VirtualTexture imported = makeTexture(name, desc, width, height);
+    imported.imported       = true;
+    imported.texture        = texture;
+    textures_.push_back(imported);
+
+    return static_cast<Resource>(textures_.size() - 1);
+}
+
+RenderGraph::Pass& RenderGraph::addPass(const std::string&                      name,
+                                        std::function<void(const RenderGraph&)> execute)
+{
+    passes_.emplace_back();
+    passes_.back().name_    = name;
+    passes_.back().execute_ = std::move(execute);
+    return passes_.back();
+}
+
+void RenderGraph::execute()
+{
+    frame_++;
+    if (resized_)
+    {
+        releasePool(true);
+        resized_ = false;
+    }
+
+    compile();
+    allocate();
+
+    for (current_ = 0; current_ < static_cast<int32_t>(order_.size()); current_++)
+    {
+        const Pass& pass = passes_[order_[current_]];
+        if (pass.resolve_)
+        {
+            const VirtualTexture& source = textures_[pass.reads_[0]];
+            const VirtualTexture& target = textures_[pass.writes_[0]];
+
+            GLbitfield mask = GL_COLOR_BUFFER_BIT;
+            if (isDepthFormat(source.desc.format))
+                mask = hasStencil(source.desc.format) ?
+                           GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT :
+                           GL_DEPTH_BUFFER_BIT;
+
+            // creating a framebuffer binds it, get both before binding either
+            const uint32_t read_framebuffer = getFramebuffer(pass.reads_);
+            const uint32_t draw_framebuffer = getFramebuffer(pass.writes_);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, read_framebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, draw_framebuffer);
+            glBlitFramebuffer(0,
+                              0,
+                              source.width,
+                              source.height,
+                              0,
+                              0,
+                              target.width,
+                              target.height,
+                              mask,
+                              GL_NEAREST);
+        }
+        else
+        {
+            if (pass.writes_.empty())
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, width_, height_);
+            }
+            else
+            {
+                const VirtualTexture& target = textures_[pass.writes_[0]];
+                glBindFramebuffer(GL_FRAMEBUFFER, getFramebuffer(pass.writes_));
+                glViewport(0, 0, target.width, target.height);
+            }
+            pass.execute_(*this);
+        }
+
+        invalidate(current_);
+    }
+    current_ = -1;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    releasePool(false);
+
+    // a short summary whenever the frame configuration changes
+    std::string signature = std::to_string(width_) + "x" + std::to_string(height_) + ":";
+    for (uint32_t index : order_)
+    {
+        signature += " " + passes_[index].name_ + ",";
+    }
+    if (signature != signature_)
+    {
+        signature_ = signature;
+        std::cout << "Info: Render graph " << signature << " " << culled_count_
+                  << " culled, " << memory_usage_ / (1024 * 1024) << " MB transient ("
+                  << unaliased_memory_usage_ / (1024 * 1024) << " MB without aliasing)"
+                  << std::endl;
+    }
+}
+
+uint32_t RenderGraph::getTexture(Resource resource) const
+{
+    // a multisampled texture read by the running pass was replaced by its resolved copy
+    if (current_ >= 0)
+    {
+        for (Resource read : passes_[order_[current_]].reads_)
+        {
+            if (textures_[read].source == resource)
+                return textures_[read].texture;
+        }
+    }
+    return textures_[resource].texture;
+}
+
+uint32_t RenderGraph::getWidth(Resource resource) const
+{
+    return textures_[resource].width;
+}
+
+uint32_t RenderGraph::getHeight(Resource resource) const
+{
+    return textures_[resource].height;
+}
+
+uint32_t RenderGraph::getStorageWidth(Resource resource) const
+{
+    return textures_[resource].storage_width;
+}
+
+uint32_t RenderGraph::getStorageHeight(Resource resource) const
+{
+    return textures_[resource].storage_height;
+}
+
+void RenderGraph::report(std::ostream& out) const
+{
+    char line[256];
+    out << "Render graph " << width_ << "x" << height_ << " (dynamic " << getRenderWidth() << "x"
+        << getRenderHeight() << "), " << order_.size() << " passes, " << culled_count_
+        << " culled" << std::endl;
+    for (size_t position = 0; position < order_.size(); position++)
+    {
+        out << "  " << position << " " << passes_[order_[position]].name_ << std::endl;
+    }
+
+    snprintf(line,
+             sizeof(line),
+             "  %-24s %-11s %7s %10s %9s",
+             "texture",
+             "size",
+             "samples",
+             "lifetime",
+             "physical");
+    out << line << std::endl;
+    for (const auto& texture : textures_)
+    {
+        if (texture.imported || texture.first_use < 0)
+            continue;
+
+        const std::string size = std::to_string(texture.storage_width) + "x" +
+                                 std::to_string(texture.storage_height);
+        const std::string lifetime =
+            std::to_string(texture.first_use) + "-" + std::to_string(texture.last_use);
+        snprintf(line,
+                 sizeof(line),
+                 "  %-24s %-11s %7u %10s %9d",
+                 texture.name.c_str(),
+                 size.c_str(),
+                 texture.desc.samples,
+                 lifetime.c_str(),
+                 texture.physical);
+        out << line << std::endl;
+    }
+    out << "  " << memory_usage_ / (1024 * 1024) << " MB transient, "
+        << unaliased_memory_usage_ / (1024 * 1024) << " MB without aliasing" << std::endl;
+}
+
+RenderGraph::VirtualTexture RenderGraph::makeTexture(const std::string& name,
+                                                     const TextureDesc& desc,
+                                                     uint32_t           storage_width,
+                                                     uint32_t           storage_height) const
+{
+    const float scale = desc.dynamic ? dynamic_scale_ : 1.f;
+
+    VirtualTexture texture;
+    texture.name           = name;
+    texture.desc           = desc;
+    texture.storage_width  = storage_width;
+    texture.storage_height = storage_height;
+    texture.width          = std::max(static_cast<uint32_t>(storage_width * scale + 0.5f), 1u);
+    texture.height         = std::max(static_cast<uint32_t>(storage_height * scale + 0.5f), 1u);
+    texture.imported       = false;
+    texture.texture        = 0;
+    texture.resolved       = k_no_resource;
+    texture.source         = k_no_resource;
+    return texture;
+}
+
+void RenderGraph::compile()
+{
+    // walk back from the passes with side effects, a pass is needed when a needed pass after it
+    // reads what it writes. Attachments keep their previous content so a pass that draws into one
+    // also needs the passes that wrote it before
+    std::vector<bool> needed(textures_.size(), false);
+    std::vector<bool> alive(passes_.size(), false);
+    for (size_t index = passes_.size(); index-- > 0;)
+    {
+        const Pass& pass = passes_[index];
+
+        bool is_alive = pass.side_effect_;
+        for (Resource resource : pass.writes_)
+        {
+            is_alive = is_alive || needed[resource];
+        }
+        for (Resource resource : pass.storage_writes_)
+        {
+            is_alive = is_alive || needed[resource];
+        }
+        if (!is_alive)
+            continue;
+
+        alive[index] = true;
+        for (Resource resource : pass.reads_)
+        {
+            needed[resource] = true;
+        }
+        for (Resource resource : pass.writes_)
+        {
+            needed[resource] = true;
+        }
+    }
+
+    // execution order, with a resolve before the first pass that samples a multisampled texture
+    // since it was last written
+    order_.clear();
+    culled_count_         = 0;
+    const size_t declared = passes_.size();
+    for (size_t index = 0; index < declared; index++)
+    {
+        if (!alive[index])
+        {
+            culled_count_++;
+            continue;
+        }
+
+        for (size_t read = 0; read < passes_[index].reads_.size(); read++)
+        {
+            const Resource resource = passes_[index].reads_[read];
+            if (textures_[resource].desc.samples <= 1)
+                continue;
+
+            if (textures_[resource].resolved == k_no_resource)
+            {
+                VirtualTexture resolved = textures_[resource];
+                resolved.name += "_resolved";
+                resolved.desc.samples = 1;
+                resolved.imported     = false;
+                resolved.texture      = 0;
+                resolved.source       = resource;
+                textures_.push_back(resolved);
+
+                const Resource handle        = static_cast<Resource>(textures_.size() - 1);
+                textures_[resource].resolved = handle;
+
+                Pass resolve;
+                resolve.name_    = "resolve " + textures_[resource].name;
+                resolve.reads_   = {resource};
+                resolve.writes_  = {handle};
+                resolve.resolve_ = true;
+                passes_.push_back(resolve);
+                order_.push_back(static_cast<uint32_t>(passes_.size() - 1));
+            }
+            passes_[index].reads_[read] = textures_[resource].resolved;
+        }
+
+        order_.push_back(static_cast<uint32_t>(index));
+        for (Resource resource : passes_[index].writes_)
+        {
+            textures_[resource].resolved = k_no_resource;
+        }
+    }
+
+    for (int32_t position = 0; position < static_cast<int32_t>(order_.size()); position++)
+    {
+        const Pass& pass = passes_[order_[position]];
+        for (const auto* resources : {&pass.reads_, &pass.writes_, &pass.storage_writes_})
+        {
+            for (Resource resource : *resources)
+            {
+                VirtualTexture& texture = textures_[resource];
+                if (texture.first_use < 0)
+                    texture.first_use = position;
+                texture.last_use = position;
+            }
+        }
+    }
+}
+
+void RenderGraph::allocate()
+{
+    for (auto& physical : pool_)
+    {
+        physical.in_use = false;
+    }
+
+    // walk the passes in order, a texture takes a free pooled texture of the same kind before its
+    // first use and gives it back after its last one
+    unaliased_memory_usage_ = 0;
+    for (int32_t position = 0; position < static_cast<int32_t>(order_.size()); position++)
+    {
+        const Pass& pass = passes_[order_[position]];
+        for (const auto* resources : {&pass.reads_, &pass.writes_, &pass.storage_writes_})
+        {
+            for (Resource resource : *resources)
+            {
+                VirtualTexture& texture = textures_[resource];
+                if (texture.imported || texture.first_use != position || texture.physical >= 0)
+                    continue;
+
+                int32_t found = -1;
+                for (size_t index = 0; index < pool_.size() && found < 0; index++)
+                {
+                    const PhysicalTexture& physical = pool_[index];
+                    if (!physical.in_use && physical.format == texture.desc.format &&
+                        physical.samples == texture.desc.samples &&
+                        physical.width == texture.storage_width &&
+                        physical.height == texture.storage_height)
+                        found = static_cast<int32_t>(index);
+                }
+
+                if (found < 0)
+                {
+                    PhysicalTexture physical;
+                    physical.format  = texture.desc.format;
+                    physical.samples = texture.desc.samples;
+                    physical.width   = texture.storage_width;
+                    physical.height  = texture.storage_height;
+
+                    const GLenum target =
+                        physical.samples > 1 ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+                    glGenTextures(1, &physical.texture);
+                    glBindTexture(target, physical.texture);
+                    if (physical.samples > 1)
+                    {
+                        glTexStorage2DMultisample(target,
+                                                  physical.samples,
+                                                  physical.format,
+                                                  physical.width,
+                                                  physical.height,
+                                                  GL_TRUE);
+                    }
+                    else
+                    {
+                        const GLint filter =
+                            isDepthFormat(physical.format) ? GL_NEAREST : GL_LINEAR;
+                        glTexStorage2D(
+                            target, 1, physical.format, physical.width, physical.height);
+                        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, filter);
+                        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, filter);
+                        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                    }
+                    glBindTexture(target, 0);
+
+                    pool_.push_back(physical);
+                    found = static_cast<int32_t>(pool_.size() - 1);
+                }
+
+                pool_[found].in_use     = true;
+                pool_[found].last_frame = frame_;
+                texture.physical        = found;
+                texture.texture         = pool_[found].texture;
+                unaliased_memory_usage_ += static_cast<size_t>(texture.storage_width) *
+                                           texture.storage_height * texture.desc.samples *
+                                           getFormatSize(texture.desc.format);
+            }
+        }
+
+        for (const auto* resources : {&pass.reads_, &pass.writes_, &pass.storage_writes_})
+        {
+            for (Resource resource : *resources)
+            {
+                const VirtualTexture& texture = textures_[resource];
+                if (!texture.imported && texture.last_use == position && texture.physical >= 0)
+                    pool_[texture.physical].in_use = false;
+            }
+        }
+    }
+
+    memory_usage_ = 0;
+    for (const auto& physical : pool_)
+    {
+        if (physical.last_frame == frame_)
+            memory_usage_ += static_cast<size_t>(physical.width) * physical.height *
+                             physical.samples * getFormatSize(physical.format);
+    }
+}
+
+void RenderGraph::releasePool(bool all)
+{
+    for (size_t index = pool_.size(); index-- > 0;)
+    {
+        const PhysicalTexture& physical = pool_[index];
+        if (!all && physical.last_frame + k_pool_lifetime >= frame_)
+            continue;
+
+        for (auto framebuffer = framebuffers_.begin(); framebuffer != framebuffers_.end();)
+        {
+            const auto& attachments = framebuffer->first;
+            if (std::find(attachments.begin(), attachments.end(), physical.texture) !=
+                attachments.end())
+            {
+                glDeleteFramebuffers(1, &framebuffer->second);
+                framebuffer = framebuffers_.erase(framebuffer);
+            }
+            else
+            {
+                framebuffer++;
+            }
+        }
+
+        glDeleteTextures(1, &physical.texture);
+        pool_.erase(pool_.begin() + index);
+    }
+}
+
+uint32_t RenderGraph::getFramebuffer(const std::vector<Resource>& attachments)
+{
+    std::vector<uint32_t> key;
+    for (Resource resource : attachments)
+    {
+        key.push_back(textures_[resource].texture);
+    }
+
+    auto found = framebuffers_.find(key);
+    if (found != framebuffers_.end())
+        return found->second;
+
+    uint32_t framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    std::vector<GLenum> draw_buffers;
+    for (Resource resource : attachments)
+    {
+        const VirtualTexture& texture    = textures_[resource];
+        GLenum                attachment = GL_COLOR_ATTACHMENT0 + draw_buffers.size();
+        if (isDepthFormat(texture.desc.format))
+            attachment = hasStencil(texture.desc.format) ? GL_DEPTH_STENCIL_ATTACHMENT :
+                                                           GL_DEPTH_ATTACHMENT;
+        else
+            draw_buffers.push_back(attachment);
+
+        glFramebufferTexture(GL_FRAMEBUFFER, attachment, texture.texture, 0);
+    }
+    if (draw_buffers.empty())
+    {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    else
+    {
+        glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::RENDER_GRAPH:: Framebuffer for " << textures_[attachments[0]].name
+                  << " is not complete!" << std::endl;
+    }
+
+    framebuffers_[key] = framebuffer;
+    return framebuffer;
+}
+
+uint32_t RenderGraph::getAttachment(const std::vector<Resource>& attachments,
+                                    Resource                     resource) const
+{
+    GLenum color = GL_COLOR_ATTACHMENT0;
+    for (Resource attached : attachments)
+    {
+        const uint32_t format = textures_[attached].desc.format;
+        if (attached == resource && !isDepthFormat(format))
+            return color;
+        if (attached == resource)
+            return hasStencil(format) ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+        if (!isDepthFormat(format))
+            color++;
+    }
+    return GL_NONE;
+}
+
+void RenderGraph::invalidate(int32_t position)
+{
+    const Pass& pass      = passes_[order_[position]];
+    auto        ends_here = [&](Resource resource) {
+        return !textures_[resource].imported && textures_[resource].last_use == position;
+    };
+
+    // attachments go through the framebuffer so tiled hardware can skip storing them
+    std::vector<GLenum> attachments;
+    for (Resource resource : pass.writes_)
+    {
+        if (ends_here(resource))
+            attachments.push_back(getAttachment(pass.writes_, resource));
+    }
+    if (!attachments.empty())
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, getFramebuffer(pass.writes_));
+        glInvalidateFramebuffer(
+            GL_DRAW_FRAMEBUFFER, static_cast<GLsizei>(attachments.size()), attachments.data());
+    }
+
+    for (Resource resource : pass.reads_)
+    {
+        if (!ends_here(resource) ||
+            std::find(pass.writes_.begin(), pass.writes_.end(), resource) != pass.writes_.end())
+            continue;
+
+        if (pass.resolve_)
+        {
+            const GLenum attachment = getAttachment(pass.reads_, resource);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, getFramebuffer(pass.reads_));
+            glInvalidateFramebuffer(GL_READ_FRAMEBUFFER, 1, &attachment);
+        }
+        else
+        {
+            glInvalidateTexImage(textures_[resource].texture, 0);
+        }
+    }
+
+    for (Resource resource : pass.storage_writes_)
+    {
+        if (ends_here(resource))
+            glInvalidateTexImage(textures_[resource].texture, 0);
+    }
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+// Render graph of the passes of a frame.
+//
+// The graph is declared again every frame: each pass lists the textures it reads and writes, then
+// execute()
+//   - culls the passes whose results nothing needs,
+//   - resolves multisampled textures before the passes that sample them,
+//   - backs the transient textures with a pooled allocator, textures whose lifetimes don't overlap
+//     share the same storage,
+//   - invalidates transient textures after their last use so their content is never stored,
+//   - binds a framebuffer with the attachments a pass writes before running it.
+// Transient textures are sized relative to the graph resolution. setResolution() only records the
+// new size, the pool is rebuilt by the next execute(). Dynamic textures also follow the dynamic
+// resolution scale, their storage stays at full size and passes only use its bottom-left corner
+// so changing the scale never reallocates.
+class RenderGraph {
+public:
+    using Resource = uint32_t;
+
+    // pooled textures that went unused for that many frames are freed
+    static constexpr uint32_t k_pool_lifetime = 8;
+
+    struct TextureDesc
+    {
+        uint32_t format;      // sized internal format
+        uint32_t samples {1};
+        float    scale {1.f}; // of the graph resolution
+        bool     dynamic {false};
+    };
+
+    class Pass {
+    public:
+        // sampled by the pass, multisampled textures are resolved first
+        Pass& read(Resource resource);
+        // as a framebuffer attachment, depth formats go to the depth attachment
+        Pass& write(Resource resource);
+        // from shaders through image stores, or by code the graph doesn't see
+        Pass& writeStorage(Resource resource);
+        // never culled, for the passes that present or read back
+        Pass& sideEffect();
+
+    private:
+        friend class RenderGraph;
+
+        std::string                             name_;
+        std::function<void(const RenderGraph&)> execute_;
+        std::vector<Resource>                   reads_;
+        std::vector<Resource>                   writes_;
+        std::vector<Resource>                   storage_writes_;
+        bool                                    side_effect_ {false};
+        bool                                    resolve_ {false};
+    };
+
+    RenderGraph(uint32_t width, uint32_t height);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    void     setResolution(uint32_t width, uint32_t height);
+    uint32_t getWidth() const
+    {
+        return width_;
+    }
+    uint32_t getHeight() const
+    {
+        return height_;
+    }
+
+    // scale of the area of the dynamic textures in use, applies from the next declared frame
+    void  setDynamicScale(float scale);
+    float getDynamicScale() const
+    {
+        return dynamic_scale_;
+    }
+    // area in use of the full-resolution dynamic textures
+    uint32_t getRenderWidth() const;
+    uint32_t getRenderHeight() const;
+
+    // drops the passes and resources of the previous frame, the pool is kept
+    void reset();
+
+    Resource createTexture(const std::string& name, const TextureDesc& desc);
+    // a texture owned outside of the graph, never aliased nor invalidated. The size is the one of
+    // its storage, a dynamic one is only used up to the dynamic resolution scale
+    Resource importTexture(const std::string& name,
+                           uint32_t           texture,
+                           uint32_t           format,
+                           uint32_t           width,
+                           uint32_t           height,
+                           bool               dynamic = false);
+
+    // the returned pass is only valid until the next addPass()
+    Pass& addPass(const std::string& name, std::function<void(const RenderGraph&)> execute);
+
+    void execute();
+
+    // texture backing a resource, from the pass callbacks. A multisampled texture read by the
+    // running pass gives its resolved texture
+    uint32_t getTexture(Resource resource) const;
+    // area in use, and size of the storage behind it
+    uint32_t getWidth(Resource resource) const;
+    uint32_t getHeight(Resource resource) const;
+    uint32_t getStorageWidth(Resource resource) const;
+    uint32_t getStorageHeight(Resource resource) const;
+
+    // bytes of transient textures used by the last executed frame, with and without aliasing
+    size_t getMemoryUsage() const
+    {
+        return memory_usage_;
+    }
+    size_t getUnaliasedMemoryUsage() const
+    {
+        return unaliased_memory_usage_;
+    }
+
+    // passes and transient textures of the last executed frame
+    void report(std::ostream& out) const;
+
+private:
+    struct VirtualTexture
+    {
+        std::string name;
+        TextureDesc desc;
+        uint32_t    width;  // area in use
+        uint32_t    height;
+        uint32_t    storage_width;
+        uint32_t    storage_height;
+        bool        imported;
+        uint32_t    texture;        // imported texture, or the pooled one while executing
+        int32_t     physical {-1};  // index in the pool
+        Resource    resolved;       // latest single-sampled copy of a multisampled texture
+        Resource    source;         // multisampled texture this one is the resolved copy of
+        int32_t     first_use {-1}; // position in the execution order
+        int32_t     last_use {-1};
+    };
+
+    struct PhysicalTexture
+    {
+        uint32_t texture;
+        uint32_t format;
+        uint32_t samples;
+        uint32_t width;
+        uint32_t height;
+        uint64_t last_frame;
+        bool     in_use;
+    };
+
+    VirtualTexture makeTexture(const std::string& name,
+                               const TextureDesc& desc,
+                               uint32_t           storage_width,
+                               uint32_t           storage_height) const;
+
+    void compile();
+    void allocate();
+    void releasePool(bool all);
+
+    uint32_t getFramebuffer(const std::vector<Resource>& attachments);
+    uint32_t getAttachment(const std::vector<Resource>& attachments, Resource resource) const;
+    void     invalidate(int32_t position);
+
+    uint32_t width_;
+    uint32_t height_;
+    float    dynamic_scale_ {1.f};
+    bool     resized_ {false};
+    uint64_t frame_ {0};
+
+    std::vector<VirtualTexture> textures_;
+    std::vector<Pass>           passes_;
+    std::vector<uint32_t>       order_; // executed passes, culled ones left out
+    uint32_t                    culled_count_ {0};
+    int32_t                     current_ {-1}; // position of the running pass
+
+    std::vector<PhysicalTexture>              pool_;
+    std::map<std::vector<uint32_t>, uint32_t> framebuffers_; // by attached textures
+
+    size_t      memory_usage_ {0};
+    size_t      unaliased_memory_usage_ {0};
+    std::string signature_; // passes of the last reported configuration
+};
@@ -0,0 +1,94 @@
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "ring_buffer.h"
+
+static constexpr GLbitfield k_map_flags =
+    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+RingBuffer::RingBuffer(size_t region_size) : region_size_(std::max<size_t>(region_size, 16))
+{
+    GLint alignment = 1;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    region_stride_ = (region_size_ + alignment - 1) / alignment * alignment;
+
+    const GLsizeiptr size = static_cast<GLsizeiptr>(region_stride_ * k_region_count);
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_);
+    glBufferStorage(GL_SHADER_STORAGE_BUFFER, size, nullptr, k_map_flags);
+    mapped_ =
+        static_cast<uint8_t*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, size, k_map_flags));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+RingBuffer::~RingBuffer()
+{
+    for (auto* fence : fences_)
+    {
+        if (fence)
+            glDeleteSync(fence);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_);
+    glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glDeleteBuffers(1, &buffer_);
+}
+
+void* RingBuffer::beginFrame()
+{
+    previous_region_ = region_;
+    if (started_)
+        region_ = (region_ + 1) % k_region_count;
+    else
+        started_ = true;
+
+    // the region was last written three frames ago and read as the previous one two frames ago,
+    // the fence after that frame is the one to wait for
+    __GLsync*& fence = fences_[(region_ + 1) % k_region_count];
+    wait_ms_         = 0.f;
+    if (fence)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+        {
+            flags = 0;
+        }
+        wait_ms_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() -
+                                                            start)
+                       .count();
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    return mapped_ + region_ * region_stride_;
+}
+
+void RingBuffer::bind(uint32_t binding, uint32_t previous_binding) const
+{
+    bind(binding);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+                      previous_binding,
+                      buffer_,
+                      static_cast<GLintptr>(previous_region_ * region_stride_),
+                      static_cast<GLsizeiptr>(region_size_));
+}
+
+void RingBuffer::bind(uint32_t binding) const
+{
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+                      binding,
+                      buffer_,
+                      static_cast<GLintptr>(region_ * region_stride_),
+                      static_cast<GLsizeiptr>(region_size_));
+}
+
+void RingBuffer::endFrame()
+{
+    if (fences_[region_])
+        glDeleteSync(fences_[region_]);
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
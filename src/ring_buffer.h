@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct __GLsync;
+
+// Per-frame shader storage streamed through one persistently mapped buffer cut into
+// k_region_count regions, one written per frame. A region is read by its frame and, as the
+// previous frame's data, by the next one, so it is only written again once the fence after that
+// second frame has signalled. The CPU writes without stalling the GPU and only waits when it runs
+// more than two frames ahead.
+class RingBuffer {
+public:
+    static constexpr uint32_t k_region_count = 3;
+
+    explicit RingBuffer(size_t region_size);
+    ~RingBuffer();
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // waits until the next region is free and returns it for writing, write-only memory
+    void* beginFrame();
+
+    // binds this frame's region and the previous frame's, the same one on the first frame, to
+    // shader storage bindings
+    void bind(uint32_t binding, uint32_t previous_binding) const;
+    // binds this frame's region only
+    void bind(uint32_t binding) const;
+
+    // fences the frame after the draws that read the ring
+    void endFrame();
+
+    size_t getRegionSize() const
+    {
+        return region_size_;
+    }
+    // index of the region beginFrame() returned, for writers that keep track of what each
+    // region holds
+    uint32_t getRegion() const
+    {
+        return region_;
+    }
+    // time beginFrame() last spent waiting on the GPU
+    float getWaitMs() const
+    {
+        return wait_ms_;
+    }
+
+private:
+    uint32_t  buffer_ {0};
+    uint8_t*  mapped_ {nullptr};
+    size_t    region_size_;
+    size_t    region_stride_; // region size rounded up to the storage buffer offset alignment
+    uint32_t  region_ {0};
+    uint32_t  previous_region_ {0};
+    bool      started_ {false};
+    __GLsync* fences_[k_region_count] {}; // by the region written in the fenced frame
+    float     wait_ms_ {0.f};
+};
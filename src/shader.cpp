@@ -1,52 +1,19 @@
 #include "shader.h"
-#include <fstream>
 #include <glad/glad.h>
 #include <iostream>
-#include <sstream>
+
+#include "asset_file.h"
 
 Shader::Shader(const char* vs_path, const char* fs_path, const char* gs_path)
 {
-    // 1. retrieve the vertex/fragment source code from filePath
+    // 1. retrieve the vertex/fragment source code from filePath, out of the asset pack when one
+    // is mounted
     std::string vertex_code;
     std::string fragment_code;
     std::string geometry_code;
-
-    std::ifstream v_shader_file;
-    std::ifstream f_shader_file;
-    std::ifstream g_shader_file;
-
-    v_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    f_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    g_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-    try
-    {
-        v_shader_file.open(vs_path);
-        f_shader_file.open(fs_path);
-
-        std::stringstream v_shader_stream, f_shader_stream;
-
-        v_shader_stream << v_shader_file.rdbuf();
-        f_shader_stream << f_shader_file.rdbuf();
-
-        v_shader_file.close();
-        f_shader_file.close();
-
-        // convert stream to string
-        vertex_code   = v_shader_stream.str();
-        fragment_code = f_shader_stream.str();
-
-        // if geometry shader path is present, also load a geometry shader
-        if (gs_path != nullptr)
-        {
-            g_shader_file.open(gs_path);
-            std::stringstream g_shader_stream;
-            g_shader_stream << g_shader_file.rdbuf();
-            g_shader_file.close();
-            geometry_code = g_shader_stream.str();
-        }
-    }
-    catch (std::ifstream::failure e)
+    if (!AssetFile::readText(vs_path, vertex_code) ||
+        !AssetFile::readText(fs_path, fragment_code) ||
+        (gs_path != nullptr && !AssetFile::readText(gs_path, geometry_code)))
     {
         std::cout << "ERROR::SHADER::FILE_READ_FAILED" << std::endl;
     }
@@ -97,6 +64,27 @@ Shader::Shader(const char* vs_path, const char* fs_path, const char* gs_path)
     }
 }
 
+Shader::Shader(const char* cs_path)
+{
+    std::string compute_code;
+    if (!AssetFile::readText(cs_path, compute_code))
+        std::cout << "ERROR::SHADER::FILE_READ_FAILED" << std::endl;
+
+    const char* cs_code = compute_code.c_str();
+
+    uint32_t compute_shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(compute_shader, 1, &cs_code, nullptr);
+    glCompileShader(compute_shader);
+    checkCompileErrors(compute_shader, "COMPUTE");
+
+    ID = glCreateProgram();
+    glAttachShader(ID, compute_shader);
+    glLinkProgram(ID);
+    checkCompileErrors(ID, "PROGRAM");
+
+    glDeleteShader(compute_shader);
+}
+
 void Shader::use()
 {
     glUseProgram(ID);
@@ -122,6 +110,11 @@ void Shader::setVec2f(const std::string& name, float x, float y) const
     glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
 }
 
+void Shader::setVec2i(const std::string& name, int x, int y) const
+{
+    glUniform2i(glGetUniformLocation(ID, name.c_str()), x, y);
+}
+
 void Shader::setVec3f(const std::string& name, float x, float y, float z) const
 {
     glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
@@ -137,6 +130,11 @@ void Shader::setMat4fv(const std::string& name, const float* values) const
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, values);
 }
 
+void Shader::setUint(const std::string& name, uint32_t value) const
+{
+    glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+}
+
 void Shader::checkCompileErrors(uint32_t shader, std::string type)
 {
     GLint  success;
@@ -151,17 +149,16 @@ void Shader::checkCompileErrors(uint32_t shader, std::string type)
                       << info_log << "\n -- --------------------------------------------------- -- "
                       << std::endl;
         }
-        else
+    }
+    else
+    {
+        glGetProgramiv(shader, GL_LINK_STATUS, &success);
+        if (!success)
         {
-            glGetProgramiv(shader, GL_LINK_STATUS, &success);
-            if (!success)
-            {
-                glGetProgramInfoLog(shader, 1024, nullptr, info_log);
-                std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n"
-                          << info_log
-                          << "\n -- --------------------------------------------------- -- "
-                          << std::endl;
-            }
+            glGetProgramInfoLog(shader, 1024, nullptr, info_log);
+            std::cerr << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n"
+                      << info_log << "\n -- --------------------------------------------------- -- "
+                      << std::endl;
         }
     }
 }
\ No newline at end of file
@@ -1,11 +1,14 @@
 #ifndef _SHADER_H_
 #define _SHADER_H_
 
+#include <cstdint>
 #include <string>
 
 class Shader {
 public:
     Shader(const char* vs_path, const char* fs_path, const char* gs_path = nullptr);
+    // compute-only program
+    explicit Shader(const char* cs_path);
 
     // use/active this shader
     void use();
@@ -15,9 +18,11 @@ public:
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
     void setVec2f(const std::string& name, float x, float y) const;
+    void setVec2i(const std::string& name, int x, int y) const;
     void setVec3f(const std::string& name, float x, float y, float z) const;
     void setVec4f(const std::string& name, float x, float y, float z, float w) const;
     void setMat4fv(const std::string& name, const float* values) const;
+    void setUint(const std::string& name, uint32_t value) const;
 
 private:
     void checkCompileErrors(uint32_t shader, std::string type);
@@ -0,0 +1,434 @@
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include "light.h"
+#include "mesh.h"
+#include "shadow_map.h"
+
+// std140 mirror of the ShadowData uniform block
+struct ShadowData
+{
+    glm::mat4 light_space[CascadedShadowMap::k_max_cascades];
+    glm::mat4 camera_view;
+    glm::vec4 cascade_splits;
+    glm::vec4 light_direction; // xyz direction, w cascade count
+    glm::vec4 light_color;     // rgb diffuse, a specular
+};
+
+// blend between uniform and logarithmic split distances
+static constexpr float k_split_lambda = 0.75f;
+
+static void copyDepthRegion(uint32_t          src,
+                            GLenum            src_target,
+                            const glm::ivec3& src_offset,
+                            uint32_t          dst,
+                            GLenum            dst_target,
+                            const glm::ivec3& dst_offset,
+                            const glm::ivec2& size)
+{
+    glCopyImageSubData(src,
+                       src_target,
+                       0,
+                       src_offset.x,
+                       src_offset.y,
+                       src_offset.z,
+                       dst,
+                       dst_target,
+                       0,
+                       dst_offset.x,
+                       dst_offset.y,
+                       dst_offset.z,
+                       size.x,
+                       size.y,
+                       1);
+}
+
+CascadedShadowMap::CascadedShadowMap(uint32_t resolution,
+                                     uint32_t cascade_count,
+                                     float    max_distance) :
+    resolution_(resolution),
+    cascade_count_(std::min(cascade_count, k_max_cascades)),
+    max_distance_(max_distance),
+    depth_shader_("../../../shader/shadow_depth.vs", "../../../shader/shadow_depth.fs")
+{
+    auto create_array = [this](bool compare) {
+        uint32_t texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY,
+                       1,
+                       GL_DEPTH_COMPONENT32F,
+                       resolution_,
+                       resolution_,
+                       cascade_count_);
+        const GLint filter = compare ? GL_LINEAR : GL_NEAREST;
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        if (compare)
+        {
+            glTexParameteri(
+                GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
+        return texture;
+    };
+
+    static_tex_    = create_array(false);
+    composite_tex_ = create_array(true);
+
+    glGenTextures(1, &scratch_tex_);
+    glBindTexture(GL_TEXTURE_2D, scratch_tex_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, resolution_, resolution_);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &ubo_);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowData), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    std::cout << "Info: Shadow cascades " << cascade_count_ << "x" << resolution_ << "^2, "
+              << 2 * static_cast<size_t>(resolution_) * resolution_ * cascade_count_ * 4 /
+                     (1024 * 1024)
+              << " MB" << std::endl;
+}
+
+CascadedShadowMap::~CascadedShadowMap()
+{
+    const uint32_t textures[] = {static_tex_, composite_tex_, scratch_tex_};
+    glDeleteTextures(3, textures);
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteBuffers(1, &ubo_);
+}
+
+void CascadedShadowMap::setCaching(bool enabled)
+{
+    caching_ = enabled;
+    invalidate();
+}
+
+void CascadedShadowMap::invalidate()
+{
+    for (auto& cascade : cascades_)
+    {
+        cascade.static_valid = false;
+    }
+}
+
+void CascadedShadowMap::render(const DirectionalLight&          light,
+                               const glm::mat4&                 view,
+                               float                            fov_y,
+                               float                            aspect_ratio,
+                               float                            near_clip,
+                               const std::vector<ShadowCaster>& casters)
+{
+    stats_ = Stats();
+    timer_.begin();
+
+    const glm::vec3 direction = glm::normalize(light.direction);
+    if (direction != light_direction_)
+    {
+        const glm::vec3 up = glm::abs(direction.y) > 0.99f ? glm::vec3(1.f, 0.f, 0.f) :
+                                                             glm::vec3(0.f, 1.f, 0.f);
+        light_direction_ = direction;
+        light_view_      = glm::lookAt(glm::vec3(0.f), direction, up);
+        depth_min_       = 0.f;
+        depth_max_       = 0.f;
+        invalidate();
+    }
+
+    updateCasterBounds(casters);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, resolution_, resolution_);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.f, 4.f);
+
+    depth_shader_.use();
+
+    const glm::mat4  inv_view = glm::inverse(view);
+    const float      tan_y    = glm::tan(fov_y * 0.5f);
+    const float      tan_x    = tan_y * aspect_ratio;
+    const glm::ivec4 full_rect(0, 0, resolution_, resolution_);
+    const int        res = static_cast<int>(resolution_);
+
+    for (uint32_t index = 0; index < cascade_count_; index++)
+    {
+        const float t       = static_cast<float>(index + 1) / static_cast<float>(cascade_count_);
+        const float uniform = near_clip + (max_distance_ - near_clip) * t;
+        const float log     = near_clip * glm::pow(max_distance_ / near_clip, t);
+        splits_[index]      = glm::mix(uniform, log, k_split_lambda);
+
+        const float slice_near = index == 0 ? near_clip : splits_[index - 1];
+
+        // bounding sphere of the frustum slice in light space. Its radius only depends on the
+        // projection so the cascade keeps its size while the camera moves
+        glm::vec3 corners[8];
+        glm::vec3 center(0.f);
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const float     d = (corner & 4) ? splits_[index] : slice_near;
+            const glm::vec4 view_pos((corner & 1 ? 1.f : -1.f) * tan_x * d,
+                                     (corner & 2 ? 1.f : -1.f) * tan_y * d,
+                                     -d,
+                                     1.f);
+            corners[corner] = glm::vec3(light_view_ * inv_view * view_pos);
+            center += corners[corner] / 8.f;
+        }
+        float radius = 0.f;
+        for (const auto& corner : corners)
+        {
+            radius = glm::max(radius, glm::length(corner - center));
+        }
+        radius = glm::ceil(radius * 16.f) / 16.f;
+
+        const float     texel   = 2.f * radius / static_cast<float>(resolution_);
+        const glm::vec2 snapped = glm::floor(glm::vec2(center) / texel) * texel;
+
+        Cascade&         cascade   = cascades_[index];
+        const bool       same_size = cascade.radius == radius;
+        const glm::ivec2 shift     = glm::ivec2(glm::round((snapped - cascade.center) / texel));
+
+        cascade.center      = snapped;
+        cascade.radius      = radius;
+        cascade.light_space = glm::ortho(snapped.x - radius,
+                                         snapped.x + radius,
+                                         snapped.y - radius,
+                                         snapped.y + radius,
+                                         -depth_max_,
+                                         -depth_min_) *
+                              light_view_;
+
+        if (!caching_)
+        {
+            drawCasters(composite_tex_, index, cascade, full_rect, casters, CasterSet::all, true);
+            stats_.cascades_redrawn++;
+            continue;
+        }
+
+        bool static_changed = true;
+        if (!cascade.static_valid || !same_size || glm::abs(shift.x) >= res ||
+            glm::abs(shift.y) >= res)
+        {
+            drawCasters(
+                static_tex_, index, cascade, full_rect, casters, CasterSet::static_only, true);
+            stats_.cascades_redrawn++;
+        }
+        else if (shift == glm::ivec2(0))
+        {
+            static_changed = false;
+            stats_.cascades_cached++;
+        }
+        else
+        {
+            // the content moves by -shift texels, keep the overlap and draw the exposed strips
+            const glm::ivec2 src(glm::max(shift.x, 0), glm::max(shift.y, 0));
+            const glm::ivec2 dst(glm::max(-shift.x, 0), glm::max(-shift.y, 0));
+            const glm::ivec2 size(res - glm::abs(shift.x), res - glm::abs(shift.y));
+
+            // copies within one image must not overlap, go through the scratch texture
+            copyDepthRegion(static_tex_,
+                            GL_TEXTURE_2D_ARRAY,
+                            glm::ivec3(src, index),
+                            scratch_tex_,
+                            GL_TEXTURE_2D,
+                            glm::ivec3(dst, 0),
+                            size);
+            copyDepthRegion(scratch_tex_,
+                            GL_TEXTURE_2D,
+                            glm::ivec3(dst, 0),
+                            static_tex_,
+                            GL_TEXTURE_2D_ARRAY,
+                            glm::ivec3(dst, index),
+                            size);
+
+            if (shift.x != 0)
+            {
+                const int x = shift.x > 0 ? res - shift.x : 0;
+                drawCasters(static_tex_,
+                            index,
+                            cascade,
+                            glm::ivec4(x, 0, glm::abs(shift.x), res),
+                            casters,
+                            CasterSet::static_only,
+                            true);
+            }
+            if (shift.y != 0)
+            {
+                const int y = shift.y > 0 ? res - shift.y : 0;
+                drawCasters(static_tex_,
+                            index,
+                            cascade,
+                            glm::ivec4(dst.x, y, size.x, glm::abs(shift.y)),
+                            casters,
+                            CasterSet::static_only,
+                            true);
+            }
+            stats_.cascades_scrolled++;
+        }
+        cascade.static_valid = true;
+
+        const glm::vec2 cascade_min = snapped - glm::vec2(radius);
+        const glm::vec2 cascade_max = snapped + glm::vec2(radius);
+
+        bool has_dynamic = false;
+        for (size_t caster = 0; caster < casters.size() && !has_dynamic; caster++)
+        {
+            const Rect& rect = caster_rects_[caster];
+            has_dynamic      = !casters[caster].is_static &&
+                          glm::all(glm::lessThan(rect.min, cascade_max)) &&
+                          glm::all(glm::greaterThan(rect.max, cascade_min));
+        }
+
+        if (static_changed || has_dynamic || cascade.composite_has_dynamic)
+        {
+            copyDepthRegion(static_tex_,
+                            GL_TEXTURE_2D_ARRAY,
+                            glm::ivec3(0, 0, index),
+                            composite_tex_,
+                            GL_TEXTURE_2D_ARRAY,
+                            glm::ivec3(0, 0, index),
+                            glm::ivec2(res));
+            if (has_dynamic)
+            {
+                drawCasters(composite_tex_,
+                            index,
+                            cascade,
+                            full_rect,
+                            casters,
+                            CasterSet::dynamic_only,
+                            false);
+            }
+            cascade.composite_has_dynamic = has_dynamic;
+        }
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    ShadowData data;
+    for (uint32_t index = 0; index < k_max_cascades; index++)
+    {
+        data.light_space[index]    = cascades_[std::min(index, cascade_count_ - 1)].light_space;
+        data.cascade_splits[index] = splits_[std::min(index, cascade_count_ - 1)];
+    }
+    data.camera_view     = view;
+    data.light_direction = glm::vec4(direction, static_cast<float>(cascade_count_));
+    data.light_color     = glm::vec4(
+        light.diffuse, glm::max(glm::max(light.specular.r, light.specular.g), light.specular.b));
+
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShadowData), &data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    timer_.end();
+}
+
+void CascadedShadowMap::bind(uint32_t texture_unit) const
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo_);
+    glActiveTexture(GL_TEXTURE0 + texture_unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, composite_tex_);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void CascadedShadowMap::updateCasterBounds(const std::vector<ShadowCaster>& casters)
+{
+    caster_rects_.resize(casters.size());
+
+    float depth_min = std::numeric_limits<float>::max();
+    float depth_max = -std::numeric_limits<float>::max();
+    for (size_t index = 0; index < casters.size(); index++)
+    {
+        const Mesh&     mesh      = *casters[index].mesh;
+        const glm::mat4 transform = light_view_ * casters[index].transform;
+
+        glm::vec3 box_min(std::numeric_limits<float>::max());
+        glm::vec3 box_max(-std::numeric_limits<float>::max());
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 local(corner & 1 ? mesh.bounds_max.x : mesh.bounds_min.x,
+                                  corner & 2 ? mesh.bounds_max.y : mesh.bounds_min.y,
+                                  corner & 4 ? mesh.bounds_max.z : mesh.bounds_min.z);
+            const glm::vec3 light_pos = glm::vec3(transform * glm::vec4(local, 1.f));
+            box_min                   = glm::min(box_min, light_pos);
+            box_max                   = glm::max(box_max, light_pos);
+        }
+
+        caster_rects_[index] = Rect {glm::vec2(box_min), glm::vec2(box_max)};
+        depth_min            = glm::min(depth_min, box_min.z);
+        depth_max            = glm::max(depth_max, box_max.z);
+    }
+
+    // cached depths are only comparable under the same projection, so grow the range with some
+    // slack for dynamic casters rather than following it exactly
+    if (!casters.empty() &&
+        (depth_min < depth_min_ || depth_max > depth_max_ || depth_min_ == depth_max_))
+    {
+        const float padding = 0.1f * (depth_max - depth_min) + 1.f;
+        depth_min_          = depth_min - padding;
+        depth_max_          = depth_max + padding;
+        invalidate();
+    }
+}
+
+void CascadedShadowMap::drawCasters(uint32_t                         texture,
+                                    uint32_t                         layer,
+                                    const Cascade&                   cascade,
+                                    const glm::ivec4&                scissor,
+                                    const std::vector<ShadowCaster>& casters,
+                                    CasterSet                        set,
+                                    bool                             clear)
+{
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+    glScissor(scissor.x, scissor.y, scissor.z, scissor.w);
+    if (clear)
+    {
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+
+    depth_shader_.setMat4fv("lightSpace", glm::value_ptr(cascade.light_space));
+
+    // light-space rectangle covered by the scissor
+    const float     texel      = 2.f * cascade.radius / static_cast<float>(resolution_);
+    const glm::vec2 origin     = cascade.center - glm::vec2(cascade.radius);
+    const glm::vec2 region_min = origin + glm::vec2(scissor.x, scissor.y) * texel;
+    const glm::vec2 region_max =
+        origin + glm::vec2(scissor.x + scissor.z, scissor.y + scissor.w) * texel;
+
+    for (size_t index = 0; index < casters.size(); index++)
+    {
+        const ShadowCaster& caster = casters[index];
+        if ((set == CasterSet::static_only && !caster.is_static) ||
+            (set == CasterSet::dynamic_only && caster.is_static))
+            continue;
+
+        const Rect& rect = caster_rects_[index];
+        if (glm::any(glm::greaterThanEqual(rect.min, region_max)) ||
+            glm::any(glm::lessThanEqual(rect.max, region_min)))
+            continue;
+
+        depth_shader_.setMat4fv("model", glm::value_ptr(caster.transform));
+        caster.mesh->DrawGeometry();
+        stats_.draw_calls++;
+    }
+}
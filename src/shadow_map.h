@@ -0,0 +1,136 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "gpu_timer.h"
+#include "shader.h"
+
+class Mesh;
+class DirectionalLight;
+
+struct ShadowCaster
+{
+    const Mesh* mesh;
+    glm::mat4   transform;
+    bool        is_static;
+};
+
+// Cascaded shadow maps for a directional light.
+//
+// Each cascade bounds its camera frustum slice with a sphere and snaps its center to the shadow
+// texel grid, so cascades only ever move by whole texels. Static casters are rendered into a
+// cache array that is kept as long as the light doesn't change: a cascade that didn't move is
+// reused as is, one that moved is scrolled, the overlapping part is copied and only the newly
+// exposed strips are drawn. Dynamic casters are drawn every frame on top of a copy of the cache.
+class CascadedShadowMap {
+public:
+    static constexpr uint32_t k_max_cascades = 4;
+
+    struct Stats
+    {
+        uint32_t draw_calls {0};
+        uint32_t cascades_redrawn {0};
+        uint32_t cascades_scrolled {0};
+        uint32_t cascades_cached {0};
+    };
+
+    CascadedShadowMap(uint32_t resolution, uint32_t cascade_count, float max_distance);
+    ~CascadedShadowMap();
+
+    CascadedShadowMap(const CascadedShadowMap&) = delete;
+    CascadedShadowMap& operator=(const CascadedShadowMap&) = delete;
+
+    void setCaching(bool enabled);
+    bool isCaching() const
+    {
+        return caching_;
+    }
+
+    // forces the static casters to be redrawn, for when they were edited
+    void invalidate();
+
+    // updates the cascades for the camera and uploads the ShadowData uniform block
+    void render(const DirectionalLight&          light,
+                const glm::mat4&                 view,
+                float                            fov_y,
+                float                            aspect_ratio,
+                float                            near_clip,
+                const std::vector<ShadowCaster>& casters);
+
+    // binds the ShadowData block to uniform binding 0 and the cascade array to the texture unit
+    void bind(uint32_t texture_unit) const;
+
+    const Stats& getStats() const
+    {
+        return stats_;
+    }
+    float getGpuMs() const
+    {
+        return timer_.getElapsedMs();
+    }
+
+private:
+    struct Cascade
+    {
+        glm::vec2 center {0.f}; // light space, snapped to the texel grid
+        float     radius {0.f};
+        glm::mat4 light_space {1.f};
+
+        bool static_valid {false};
+        bool composite_has_dynamic {false};
+    };
+
+    enum class CasterSet
+    {
+        static_only,
+        dynamic_only,
+        all
+    };
+
+    // light-space xy rectangle
+    struct Rect
+    {
+        glm::vec2 min;
+        glm::vec2 max;
+    };
+
+    // light-space bounds of every caster, grows the depth range (dropping the cache) if needed
+    void updateCasterBounds(const std::vector<ShadowCaster>& casters);
+
+    // draws the casters of the set that overlap the scissor rectangle (in texels) of a cascade
+    void drawCasters(uint32_t                         texture,
+                     uint32_t                         layer,
+                     const Cascade&                   cascade,
+                     const glm::ivec4&                scissor,
+                     const std::vector<ShadowCaster>& casters,
+                     CasterSet                        set,
+                     bool                             clear);
+
+    uint32_t resolution_;
+    uint32_t cascade_count_;
+    float    max_distance_;
+    bool     caching_ {true};
+
+    // light view rotation and the light-space depth range covering every caster
+    glm::vec3 light_direction_ {0.f};
+    glm::mat4 light_view_ {1.f};
+    float     depth_min_ {0.f};
+    float     depth_max_ {0.f};
+
+    Cascade           cascades_[k_max_cascades];
+    float             splits_[k_max_cascades];
+    std::vector<Rect> caster_rects_;
+
+    uint32_t static_tex_ {0};    // static casters only
+    uint32_t composite_tex_ {0}; // static + dynamic casters, sampled by the lighting passes
+    uint32_t scratch_tex_ {0};   // scrolling intermediate
+    uint32_t fbo_ {0};
+    uint32_t ubo_ {0};
+
+    Shader   depth_shader_;
+    GpuTimer timer_;
+    Stats    stats_;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <cstdint>
+
+// Thin wrappers over SSE and AVX registers for the CPU ray tracer. Code written against them is
+// templated on the wrapper, so one traversal builds 4-wide everywhere and 8-wide when the
+// compiler targets AVX (/arch:AVX2, -mavx2). Comparisons return all-ones lanes, mask() packs
+// their sign bits into an integer.
+
+struct SimdFloat4
+{
+    static constexpr uint32_t k_width = 4;
+
+    __m128 value;
+
+    static SimdFloat4 load(const float* data)
+    {
+        return {_mm_loadu_ps(data)};
+    }
+    static SimdFloat4 broadcast(float scalar)
+    {
+        return {_mm_set1_ps(scalar)};
+    }
+};
+
+inline SimdFloat4 operator+(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_add_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator-(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_sub_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator*(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_mul_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator/(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_div_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator&(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_and_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator<(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_cmplt_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator<=(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_cmple_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator>(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_cmpgt_ps(a.value, b.value)};
+}
+inline SimdFloat4 operator>=(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_cmpge_ps(a.value, b.value)};
+}
+inline SimdFloat4 min(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_min_ps(a.value, b.value)};
+}
+inline SimdFloat4 max(SimdFloat4 a, SimdFloat4 b)
+{
+    return {_mm_max_ps(a.value, b.value)};
+}
+inline SimdFloat4 abs(SimdFloat4 a)
+{
+    return {_mm_andnot_ps(_mm_set1_ps(-0.f), a.value)};
+}
+inline uint32_t mask(SimdFloat4 a)
+{
+    return static_cast<uint32_t>(_mm_movemask_ps(a.value));
+}
+
+#if defined(__AVX__)
+#define SIMD_HAS_AVX 1
+
+struct SimdFloat8
+{
+    static constexpr uint32_t k_width = 8;
+
+    __m256 value;
+
+    static SimdFloat8 load(const float* data)
+    {
+        return {_mm256_loadu_ps(data)};
+    }
+    static SimdFloat8 broadcast(float scalar)
+    {
+        return {_mm256_set1_ps(scalar)};
+    }
+};
+
+inline SimdFloat8 operator+(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_add_ps(a.value, b.value)};
+}
+inline SimdFloat8 operator-(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_sub_ps(a.value, b.value)};
+}
+inline SimdFloat8 operator*(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_mul_ps(a.value, b.value)};
+}
+inline SimdFloat8 operator/(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_div_ps(a.value, b.value)};
+}
+inline SimdFloat8 operator&(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_and_ps(a.value, b.value)};
+}
+inline SimdFloat8 operator<(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ)};
+}
+inline SimdFloat8 operator<=(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_cmp_ps(a.value, b.value, _CMP_LE_OQ)};
+}
+inline SimdFloat8 operator>(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ)};
+}
+inline SimdFloat8 operator>=(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_cmp_ps(a.value, b.value, _CMP_GE_OQ)};
+}
+inline SimdFloat8 min(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_min_ps(a.value, b.value)};
+}
+inline SimdFloat8 max(SimdFloat8 a, SimdFloat8 b)
+{
+    return {_mm256_max_ps(a.value, b.value)};
+}
+inline SimdFloat8 abs(SimdFloat8 a)
+{
+    return {_mm256_andnot_ps(_mm256_set1_ps(-0.f), a.value)};
+}
+inline uint32_t mask(SimdFloat8 a)
+{
+    return static_cast<uint32_t>(_mm256_movemask_ps(a.value));
+}
+
+#else
+#define SIMD_HAS_AVX 0
+#endif
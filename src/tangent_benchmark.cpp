@@ -0,0 +1,358 @@
+// CPU benchmark of the tangent frame generation, no GPU needed. Imports a model the way Model
+// does, or builds a sphere whose second half mirrors the texture coords of the first when no
+// model is given, welds it and generates its tangent frames on one thread and on every thread,
+// checks both give the same frames and reports the throughput. The frames are compared against
+// reference ones, those of aiProcess_CalcTangentSpace for a model, which is timed as well, and
+// the analytic ones for the sphere:
+//   tangent_benchmark [model] [options]
+//     --runs <n>        generations timed per thread count (default 10)
+//     --threads <n>     worker threads, 0 for all (default)
+//     --segments <n>    segments around the sphere, half as many rings (default 1024)
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+#include "mesh_weld.h"
+#include "tangent_space.h"
+
+static constexpr float k_pi = 3.14159265f;
+
+// frames further than this from the reference count as disagreeing
+static constexpr float k_angle_tolerance = 5.f;
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+struct BenchmarkMesh
+{
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices;
+    // the expected frame at every corner, w is 0 where there is none
+    std::vector<glm::vec4> reference;
+};
+
+static glm::vec4 referenceFrame(const glm::vec3& normal,
+                                const glm::vec3& tangent,
+                                const glm::vec3& bitangent)
+{
+    if (glm::length(tangent) == 0.f || glm::length(bitangent) == 0.f)
+        return glm::vec4(0.f);
+
+    const float handedness = glm::dot(glm::cross(normal, tangent), bitangent) < 0.f ? -1.f : 1.f;
+    return glm::vec4(glm::normalize(tangent), handedness);
+}
+
+static BenchmarkMesh createSphere(uint32_t segments)
+{
+    const uint32_t rings = std::max(segments / 2, 2u);
+
+    BenchmarkMesh mesh;
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            // the last column closes the sphere on the first one
+            const float theta = k_pi * ring / rings;
+            const float phi   = 2.f * k_pi * (segment % segments) / segments;
+            const float u     = 2.f * std::min(segment, segments - segment) / segments;
+
+            Vertex vertex    = {};
+            vertex.position  = glm::vec3(
+                std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            vertex.normal    = vertex.position;
+            vertex.texcoords = glm::vec2(u, static_cast<float>(ring) / rings);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            const uint32_t corner = ring * (segments + 1) + segment;
+            const uint32_t below  = corner + segments + 1;
+            const uint32_t quad[6] = {corner, corner + 1, below, corner + 1, below + 1, below};
+
+            // u grows along phi on the first half and against it on the mirrored one
+            const float direction = segment < segments / 2 ? 1.f : -1.f;
+            for (uint32_t index : quad)
+            {
+                const Vertex&   vertex = mesh.vertices[index];
+                const float     theta  = k_pi * (index / (segments + 1)) / rings;
+                const float     phi    = 2.f * k_pi * (index % (segments + 1)) / segments;
+                const glm::vec3 tangent(-std::sin(phi) * direction, 0.f, std::cos(phi) * direction);
+                const glm::vec3 bitangent(std::cos(theta) * std::cos(phi),
+                                          -std::sin(theta),
+                                          std::cos(theta) * std::sin(phi));
+
+                mesh.indices.push_back(index);
+                // the poles have no tangent direction
+                const bool pole = index / (segments + 1) == 0 || index / (segments + 1) == rings;
+                mesh.reference.push_back(pole ? glm::vec4(0.f)
+                                              : referenceFrame(vertex.normal, tangent, bitangent));
+            }
+        }
+    }
+    return mesh;
+}
+
+// the meshes with the frames of aiProcess_CalcTangentSpace, which is timed on its own
+static bool loadMeshes(const std::string&          path,
+                       std::vector<BenchmarkMesh>& meshes,
+                       double&                     assimp_seconds)
+{
+    Assimp::Importer importer;
+    const aiScene*   scene = importer.ReadFile(
+        path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals);
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    const Clock::time_point start = Clock::now();
+    scene                         = importer.ApplyPostProcessing(aiProcess_CalcTangentSpace);
+    assimp_seconds                = secondsSince(start);
+    if (!scene)
+    {
+        std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    for (uint32_t mesh_index = 0; mesh_index < scene->mNumMeshes; mesh_index++)
+    {
+        const aiMesh* source = scene->mMeshes[mesh_index];
+        if (!source->HasNormals() || !(source->mPrimitiveTypes & aiPrimitiveType_TRIANGLE))
+            continue;
+
+        BenchmarkMesh mesh;
+        for (uint32_t index = 0; index < source->mNumVertices; index++)
+        {
+            Vertex vertex   = {};
+            vertex.position = glm::vec3(
+                source->mVertices[index].x, source->mVertices[index].y, source->mVertices[index].z);
+            vertex.normal = glm::vec3(
+                source->mNormals[index].x, source->mNormals[index].y, source->mNormals[index].z);
+            if (source->mTextureCoords[0])
+            {
+                vertex.texcoords = glm::vec2(source->mTextureCoords[0][index].x,
+                                             source->mTextureCoords[0][index].y);
+            }
+            mesh.vertices.push_back(vertex);
+        }
+        for (uint32_t face = 0; face < source->mNumFaces; face++)
+        {
+            if (source->mFaces[face].mNumIndices != 3)
+                continue;
+
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const uint32_t index = source->mFaces[face].mIndices[corner];
+                mesh.indices.push_back(index);
+                if (!source->mTangents)
+                {
+                    mesh.reference.push_back(glm::vec4(0.f));
+                    continue;
+                }
+
+                const aiVector3D& tangent   = source->mTangents[index];
+                const aiVector3D& bitangent = source->mBitangents[index];
+                mesh.reference.push_back(
+                    referenceFrame(mesh.vertices[index].normal,
+                                   glm::vec3(tangent.x, tangent.y, tangent.z),
+                                   glm::vec3(bitangent.x, bitangent.y, bitangent.z)));
+            }
+        }
+        meshes.push_back(std::move(mesh));
+    }
+    return true;
+}
+
+struct Comparison
+{
+    uint64_t corners {0};          // of non degenerate triangles with a reference frame
+    uint64_t handedness_match {0}; // of those
+    uint64_t within_tolerance {0}; // same handedness and tangent within k_angle_tolerance
+    double   angle_sum {0.0};      // degrees, over the matching handedness
+    uint64_t broken {0};           // frames not unit, not orthogonal or not following the uvs
+};
+
+static void compare(const BenchmarkMesh&         mesh,
+                    const std::vector<Vertex>&   vertices,
+                    const std::vector<uint32_t>& indices,
+                    Comparison&                  comparison)
+{
+    for (const auto& vertex : vertices)
+    {
+        const glm::vec3 tangent(vertex.tangent);
+        if (std::abs(glm::length(tangent) - 1.f) > 1e-3f ||
+            std::abs(glm::dot(glm::normalize(vertex.normal), tangent)) > 1e-3f ||
+            std::abs(vertex.tangent.w) != 1.f)
+            comparison.broken++;
+    }
+
+    for (size_t corner = 0; corner < indices.size(); corner++)
+    {
+        // every corner of a triangle with area in both spaces follows its orientation
+        const Vertex&   v0      = vertices[indices[corner - corner % 3]];
+        const Vertex&   v1      = vertices[indices[corner - corner % 3 + 1]];
+        const Vertex&   v2      = vertices[indices[corner - corner % 3 + 2]];
+        const glm::vec2 t21     = v1.texcoords - v0.texcoords;
+        const glm::vec2 t31     = v2.texcoords - v0.texcoords;
+        const float     uv_area = t21.x * t31.y - t21.y * t31.x;
+        const float     area    = glm::length(glm::cross(v1.position - v0.position,
+                                                     v2.position - v0.position));
+        const Vertex&   vertex  = vertices[indices[corner]];
+        if (uv_area == 0.f || area == 0.f)
+            continue;
+        if ((uv_area > 0.f) != (vertex.tangent.w > 0.f))
+            comparison.broken++;
+
+        // degenerate triangles have no frame of their own to compare
+        const glm::vec4& reference = mesh.reference[corner];
+        if (reference.w == 0.f)
+            continue;
+
+        comparison.corners++;
+        if (reference.w != vertex.tangent.w)
+            continue;
+
+        const glm::vec3 normal = glm::normalize(vertex.normal);
+        const glm::vec3 expected =
+            glm::vec3(reference) - glm::dot(glm::vec3(reference), normal) * normal;
+        if (glm::length(expected) == 0.f)
+            continue;
+
+        const float angle = glm::degrees(std::acos(
+            glm::clamp(glm::dot(glm::normalize(expected), glm::vec3(vertex.tangent)), -1.f, 1.f)));
+        comparison.handedness_match++;
+        comparison.angle_sum += angle;
+        if (angle <= k_angle_tolerance)
+            comparison.within_tolerance++;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string model_path;
+    uint32_t    run_count    = 10;
+    uint32_t    thread_count = 0;
+    uint32_t    segments     = 1024;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--runs") == 0 && index + 1 < argc)
+            run_count = std::max(1, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc)
+            thread_count = std::max(0, atoi(argv[++index]));
+        else if (strcmp(argv[index], "--segments") == 0 && index + 1 < argc)
+            segments = std::max(4, atoi(argv[++index]));
+        else if (argv[index][0] != '-')
+            model_path = argv[index];
+    }
+
+    std::vector<BenchmarkMesh> meshes;
+    double                     assimp_seconds = 0.0;
+    if (model_path.empty())
+        meshes.push_back(createSphere(segments));
+    else if (!loadMeshes(model_path, meshes, assimp_seconds))
+        return 1;
+
+    // welded like Model does, the reference stays per corner
+    JobSystem jobs(thread_count);
+    size_t    vertex_count   = 0;
+    size_t    triangle_count = 0;
+    for (auto& mesh : meshes)
+    {
+        weldVertices(mesh.vertices, mesh.indices, WeldSettings(), jobs);
+        vertex_count += mesh.vertices.size();
+        triangle_count += mesh.indices.size() / 3;
+    }
+    std::cout << "Info: " << (model_path.empty() ? "mirrored sphere" : model_path) << ", "
+              << meshes.size() << " meshes, " << vertex_count << " welded vertices, "
+              << triangle_count << " triangles" << std::endl;
+    if (!model_path.empty())
+    {
+        std::cout << "Info:   aiProcess_CalcTangentSpace " << assimp_seconds * 1e3 << " ms"
+                  << std::endl;
+    }
+
+    JobSystem                        single_thread(1);
+    std::vector<std::vector<Vertex>> results[2];
+    uint32_t                         run_index = 0;
+    for (JobSystem* pool : {&single_thread, &jobs})
+    {
+        std::vector<std::vector<Vertex>>&   vertices = results[run_index++];
+        std::vector<std::vector<uint32_t>> indices(meshes.size());
+        vertices.resize(meshes.size());
+
+        double seconds = 0.0;
+        size_t split   = 0;
+        for (uint32_t run = 0; run < run_count; run++)
+        {
+            split = 0;
+            for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+            {
+                vertices[mesh] = meshes[mesh].vertices;
+                indices[mesh]  = meshes[mesh].indices;
+
+                const Clock::time_point start = Clock::now();
+                generateTangents(vertices[mesh], indices[mesh], *pool);
+                seconds += secondsSince(start);
+                split += vertices[mesh].size() - meshes[mesh].vertices.size();
+            }
+        }
+
+        Comparison comparison;
+        for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+        {
+            compare(meshes[mesh], vertices[mesh], indices[mesh], comparison);
+        }
+        const double corners   = std::max<double>(static_cast<double>(comparison.corners), 1.0);
+        const double triangles = static_cast<double>(triangle_count) * run_count;
+        std::cout << "Info:   " << pool->getThreadCount() << " threads: "
+                  << seconds * 1e3 / run_count << " ms (" << 1e-6 * triangles / seconds
+                  << " M triangles/s), " << split << " vertices split for mirroring" << std::endl;
+        std::cout << "Info:   against " << (model_path.empty() ? "analytic" : "Assimp")
+                  << " frames: " << 100.0 * comparison.handedness_match / corners
+                  << "% same handedness, " << 100.0 * comparison.within_tolerance / corners
+                  << "% within " << k_angle_tolerance << " degrees, mean "
+                  << comparison.angle_sum / std::max<uint64_t>(comparison.handedness_match, 1)
+                  << " degrees" << std::endl;
+        if (comparison.broken > 0)
+        {
+            std::cout << "ERROR::TANGENTS:: " << comparison.broken
+                      << " frames are not unit, not orthogonal or don't follow their uvs"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    // the frames must not depend on the thread count
+    for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+    {
+        if (results[0][mesh].size() != results[1][mesh].size() ||
+            memcmp(results[0][mesh].data(),
+                   results[1][mesh].data(),
+                   results[0][mesh].size() * sizeof(Vertex)) != 0)
+        {
+            std::cout << "ERROR::TANGENTS:: frames differ between thread counts" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cmath>
+
+#include "job_system.h"
+#include "tangent_space.h"
+
+static constexpr uint32_t k_batch_size = 1024;
+
+// the tolerance MikkTSpace treats lengths and areas as zero with
+static constexpr float k_epsilon = 1.17549435e-38f;
+
+struct TriangleFrame
+{
+    glm::vec3 tangent {0.f};  // unit, signed by the orientation
+    uint8_t   preserving {1}; // texture coords wind the same way as the positions
+    uint8_t   valid {0};      // has texture area
+};
+
+static glm::vec3 projectOnPlane(const glm::vec3& vector, const glm::vec3& normal)
+{
+    return vector - glm::dot(vector, normal) * normal;
+}
+
+static glm::vec3 normalizeOrZero(const glm::vec3& vector)
+{
+    const float length = glm::length(vector);
+    return length > k_epsilon ? vector / length : vector;
+}
+
+// the summed direction, or any one orthogonal to the normal for vertices without a textured
+// triangle
+static glm::vec3 finishTangent(const glm::vec3& sum, const glm::vec3& normal)
+{
+    if (glm::length(sum) > k_epsilon)
+        return glm::normalize(sum);
+
+    const glm::vec3 axis =
+        std::abs(normal.x) < 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+    const glm::vec3 tangent = projectOnPlane(axis, normal);
+    return glm::length(tangent) > 0.f ? glm::normalize(tangent) : axis;
+}
+
+static TriangleFrame computeTriangleFrame(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+{
+    const glm::vec3 d1  = v1.position - v0.position;
+    const glm::vec3 d2  = v2.position - v0.position;
+    const glm::vec2 t21 = v1.texcoords - v0.texcoords;
+    const glm::vec2 t31 = v2.texcoords - v0.texcoords;
+
+    const float signed_area = t21.x * t31.y - t21.y * t31.x;
+    const float sign        = signed_area > 0.f ? 1.f : -1.f;
+
+    TriangleFrame frame;
+    frame.preserving = signed_area > 0.f;
+
+    const glm::vec3 os = t31.y * d1 - t21.y * d2;
+    const glm::vec3 ot = -t31.x * d1 + t21.x * d2;
+    if (std::abs(signed_area) <= k_epsilon)
+        return frame;
+
+    // MikkTSpace leaves triangles whose texture coords collapse in either direction out as well
+    const float length_s = glm::length(os);
+    const float length_t = glm::length(ot);
+    frame.valid          = length_s > k_epsilon && length_t > k_epsilon;
+    if (frame.valid)
+        frame.tangent = os * (sign / length_s);
+    return frame;
+}
+
+void generateTangents(std::vector<Vertex>&   vertices,
+                      std::vector<uint32_t>& indices,
+                      JobSystem&             jobs)
+{
+    const uint32_t vertex_count   = static_cast<uint32_t>(vertices.size());
+    const uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+    std::vector<TriangleFrame> frames(triangle_count);
+    jobs.parallelFor(triangle_count, k_batch_size, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t triangle = begin; triangle < end; triangle++)
+        {
+            const uint32_t* corners = &indices[triangle * 3];
+            frames[triangle] = computeTriangleFrame(
+                vertices[corners[0]], vertices[corners[1]], vertices[corners[2]]);
+        }
+    });
+
+    // corners around every vertex
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    std::vector<uint32_t> corners(triangle_count * 3);
+    for (uint32_t index = 0; index < triangle_count * 3; index++)
+    {
+        offsets[indices[index] + 1]++;
+    }
+    for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+    std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+    for (uint32_t index = 0; index < triangle_count * 3; index++)
+    {
+        corners[cursors[indices[index]]++] = index;
+    }
+
+    // the angle weighted sums of both orientations around every vertex, the one with more corners
+    // stays on the vertex
+    std::vector<glm::vec3> sums(vertex_count * 2, glm::vec3(0.f));
+    std::vector<uint8_t>   orientations(vertex_count, 1);
+    std::vector<uint8_t>   mixed(vertex_count, 0);
+    jobs.parallelFor(vertex_count, k_batch_size, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t vertex = begin; vertex < end; vertex++)
+        {
+            const glm::vec3 normal    = normalizeOrZero(vertices[vertex].normal);
+            uint32_t        counts[2] = {0, 0};
+            for (uint32_t offset = offsets[vertex]; offset < offsets[vertex + 1]; offset++)
+            {
+                const uint32_t       corner   = corners[offset];
+                const uint32_t       triangle = corner / 3;
+                const TriangleFrame& frame    = frames[triangle];
+                if (!frame.valid)
+                    continue;
+
+                const uint32_t* around = &indices[triangle * 3];
+                const uint32_t  local  = corner - triangle * 3;
+                const glm::vec3 p0     = vertices[around[local]].position;
+                const glm::vec3 p1     = vertices[around[(local + 1) % 3]].position;
+                const glm::vec3 p2     = vertices[around[(local + 2) % 3]].position;
+                const glm::vec3 edge1  = normalizeOrZero(projectOnPlane(p1 - p0, normal));
+                const glm::vec3 edge2  = normalizeOrZero(projectOnPlane(p2 - p0, normal));
+                const float     angle  = std::acos(glm::clamp(glm::dot(edge1, edge2), -1.f, 1.f));
+
+                sums[vertex * 2 + frame.preserving] +=
+                    angle * normalizeOrZero(projectOnPlane(frame.tangent, normal));
+                counts[frame.preserving]++;
+            }
+            orientations[vertex] = counts[1] >= counts[0];
+            mixed[vertex]        = counts[0] > 0 && counts[1] > 0;
+        }
+    });
+
+    // copies for the smaller side of the mixed vertices, appended in vertex order
+    std::vector<uint32_t> copies(vertex_count, 0);
+    uint32_t              copy_count = 0;
+    for (uint32_t vertex = 0; vertex < vertex_count; vertex++)
+    {
+        if (mixed[vertex])
+            copies[vertex] = vertex_count + copy_count++;
+    }
+    vertices.resize(vertex_count + copy_count);
+
+    jobs.parallelFor(vertex_count, k_batch_size, [&](uint32_t begin, uint32_t end, uint32_t) {
+        for (uint32_t vertex = begin; vertex < end; vertex++)
+        {
+            Vertex&         source = vertices[vertex];
+            const glm::vec3 normal = normalizeOrZero(source.normal);
+            const uint8_t   side   = orientations[vertex];
+
+            source.tangent =
+                glm::vec4(finishTangent(sums[vertex * 2 + side], normal), side ? 1.f : -1.f);
+            if (!mixed[vertex])
+                continue;
+
+            // each corner belongs to one vertex, so the remapping doesn't overlap between jobs
+            Vertex& copy = vertices[copies[vertex]];
+            copy         = source;
+            copy.tangent =
+                glm::vec4(finishTangent(sums[vertex * 2 + 1 - side], normal), side ? -1.f : 1.f);
+            for (uint32_t offset = offsets[vertex]; offset < offsets[vertex + 1]; offset++)
+            {
+                const TriangleFrame& frame = frames[corners[offset] / 3];
+                if (frame.valid && frame.preserving != side)
+                    indices[corners[offset]] = copies[vertex];
+            }
+        }
+    });
+}
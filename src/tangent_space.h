@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mesh.h"
+
+class JobSystem;
+
+// MikkTSpace tangent frames, the ones normal maps are baked against by most tools. Writes
+// Vertex::tangent of every vertex: xyz the unit tangent orthogonal to the normal, w the
+// handedness, with bitangent = w * cross(normal, tangent).
+//
+// Every triangle gets the directions its texture coords increase along, signed by whether it maps
+// them mirrored. A vertex sums them over its triangles, projected onto the plane of its normal
+// and weighted by the angle of each corner. Triangles without texture area don't count. Vertices
+// shared by mirrored and unmirrored triangles are split so each side gets its own frame, the
+// indices of the smaller side are remapped to the copy. The triangles and vertices are spread
+// over the jobs. The normals must be set.
+void generateTangents(std::vector<Vertex>&   vertices,
+                      std::vector<uint32_t>& indices,
+                      JobSystem&             jobs);
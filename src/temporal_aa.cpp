@@ -0,0 +1,126 @@
+#include <glad/glad.h>
+
+#include <iostream>
+
+#include "temporal_aa.h"
+
+static constexpr uint32_t k_group_size = 8;
+
+// weight of the current frame when its sample lands on the output pixel, the history holds about
+// the last 1 / k_blend_factor frames
+static constexpr float k_blend_factor = 0.1f;
+
+static float halton(uint32_t index, uint32_t base)
+{
+    float result   = 0.f;
+    float fraction = 1.f;
+    while (index > 0)
+    {
+        fraction /= static_cast<float>(base);
+        result += fraction * static_cast<float>(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+TemporalAntiAliasing::TemporalAntiAliasing(uint32_t width, uint32_t height) :
+    width_(width), height_(height), resolve_shader_("../../../shader/taa_resolve.cs")
+{
+    createTargets();
+}
+
+TemporalAntiAliasing::~TemporalAntiAliasing()
+{
+    destroyTargets();
+}
+
+void TemporalAntiAliasing::resize(uint32_t width, uint32_t height)
+{
+    if (width == width_ && height == height_)
+        return;
+
+    width_  = width;
+    height_ = height;
+
+    destroyTargets();
+    createTargets();
+}
+
+glm::vec2 TemporalAntiAliasing::beginFrame(uint32_t render_width, uint32_t render_height)
+{
+    current_ = 1 - current_;
+
+    // the sequence starts at 1, Halton(0) is the pixel corner for every base
+    jitter_index_ = jitter_index_ % k_jitter_count + 1;
+    jitter_       = glm::vec2(halton(jitter_index_, 2), halton(jitter_index_, 3)) - 0.5f;
+
+    return 2.f * jitter_ / glm::vec2(render_width, render_height);
+}
+
+void TemporalAntiAliasing::resolve(uint32_t color_texture,
+                                   uint32_t velocity_texture,
+                                   uint32_t depth_texture,
+                                   uint32_t render_width,
+                                   uint32_t render_height)
+{
+    timer_.begin();
+
+    resolve_shader_.use();
+    resolve_shader_.setVec2i("outputSize", width_, height_);
+    resolve_shader_.setVec2i("renderSize", render_width, render_height);
+    resolve_shader_.setVec2f("jitter", jitter_.x, jitter_.y);
+    resolve_shader_.setFloat("blendFactor", k_blend_factor);
+    resolve_shader_.setBool("historyValid", history_valid_);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, color_texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, velocity_texture);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, depth_texture);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D, history_tex_[1 - current_]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindImageTexture(0, history_tex_[current_], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    glDispatchCompute(
+        (width_ + k_group_size - 1) / k_group_size, (height_ + k_group_size - 1) / k_group_size, 1);
+    // sampled by the present pass, and by the next resolve as its history
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    history_valid_ = true;
+
+    timer_.end();
+}
+
+size_t TemporalAntiAliasing::getMemoryUsage() const
+{
+    // two RGBA16F textures
+    return 2 * static_cast<size_t>(width_) * height_ * 8;
+}
+
+void TemporalAntiAliasing::createTargets()
+{
+    glGenTextures(2, history_tex_);
+    for (uint32_t texture : history_tex_)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width_, height_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    current_       = 0;
+    history_valid_ = false;
+
+    std::cout << "Info: TAA history " << width_ << "x" << height_ << ", "
+              << getMemoryUsage() / (1024 * 1024) << " MB" << std::endl;
+}
+
+void TemporalAntiAliasing::destroyTargets()
+{
+    glDeleteTextures(2, history_tex_);
+}
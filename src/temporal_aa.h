@@ -0,0 +1,75 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+#include "gpu_timer.h"
+#include "shader.h"
+
+// Temporal anti-aliasing, and upsampling when the scene renders below the output resolution.
+//
+// Every frame the camera projection is offset by a different sub-pixel jitter (Halton 2,3), so
+// the pixels of successive frames cover different points. The resolve reprojects the previous
+// output with the velocity buffer, clips it to the neighborhood of the current frame so
+// disoccluded and changed pixels don't ghost, and blends the current frame in. Its only targets
+// are two output-sized RGBA16F history textures it ping-pongs between: the scene itself renders
+// single-sampled, which is what makes it cheaper than MSAA.
+class TemporalAntiAliasing {
+public:
+    static constexpr uint32_t k_jitter_count = 8;
+
+    TemporalAntiAliasing(uint32_t width, uint32_t height);
+    ~TemporalAntiAliasing();
+
+    TemporalAntiAliasing(const TemporalAntiAliasing&) = delete;
+    TemporalAntiAliasing& operator=(const TemporalAntiAliasing&) = delete;
+
+    // output size, the history restarts
+    void resize(uint32_t width, uint32_t height);
+
+    // drops the history, after a camera cut or when the frames in between didn't go through it
+    void resetHistory()
+    {
+        history_valid_ = false;
+    }
+
+    // moves to the next history texture and jitter, returns the projection offset in normalized
+    // device coordinates of a render_width x render_height frame
+    glm::vec2 beginFrame(uint32_t render_width, uint32_t render_height);
+
+    // resolves the current frame, the bottom-left render_width x render_height of the given
+    // textures, into the output texture
+    void resolve(uint32_t color_texture,
+                 uint32_t velocity_texture,
+                 uint32_t depth_texture,
+                 uint32_t render_width,
+                 uint32_t render_height);
+
+    // output of this frame's resolve, output-sized
+    uint32_t getOutputTexture() const
+    {
+        return history_tex_[current_];
+    }
+
+    float getGpuMs() const
+    {
+        return timer_.getElapsedMs();
+    }
+    size_t getMemoryUsage() const;
+
+private:
+    void createTargets();
+    void destroyTargets();
+
+    uint32_t  width_;
+    uint32_t  height_;
+    uint32_t  history_tex_[2] {0, 0};
+    uint32_t  current_ {0};
+    bool      history_valid_ {false};
+    uint32_t  jitter_index_ {0};
+    glm::vec2 jitter_ {0.f}; // of the frame being rendered, in render pixels
+
+    Shader   resolve_shader_;
+    GpuTimer timer_;
+};
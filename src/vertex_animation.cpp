@@ -0,0 +1,341 @@
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+#include "job_system.h"
+#include "mesh.h"
+#include "vertex_animation.h"
+
+// std430 mirror of the VertexAnimation block of the scene vertex shaders, the clips follow
+struct GpuAnimationHeader
+{
+    glm::vec3 bounds_min;
+    uint32_t  rows_per_frame;
+    glm::vec3 bounds_extent;
+    uint32_t  width;
+};
+
+struct GpuAnimationClip
+{
+    uint32_t first_frame;
+    uint32_t frame_count;
+    float    duration;
+    float    padding;
+};
+
+// one frame of every vertex, per thread
+struct FrameScratch
+{
+    Pose                     pose;
+    std::vector<glm::mat4>   model_space;
+    std::vector<JointMatrix> palette;
+    std::vector<glm::vec3>   positions;
+    std::vector<glm::vec3>   normals;
+};
+
+// skins every vertex with the pose of clip at time, as SkinMatrix() in the vertex shaders does
+static void skinFrame(const Skeleton&            skeleton,
+                      const CompressedClip&      clip,
+                      float                      time,
+                      const std::vector<Vertex>& vertices,
+                      FrameScratch&              scratch)
+{
+    sampleClip(skeleton, clip, time, scratch.pose);
+    scratch.palette.resize(skeleton.getJointCount());
+    computeSkinningMatrices(skeleton, scratch.pose, scratch.model_space, scratch.palette.data());
+
+    scratch.positions.resize(vertices.size());
+    scratch.normals.resize(vertices.size());
+    for (size_t index = 0; index < vertices.size(); index++)
+    {
+        const Vertex& vertex = vertices[index];
+        glm::vec4     rows[3] {glm::vec4(0.f), glm::vec4(0.f), glm::vec4(0.f)};
+        float         total = 0.f;
+        for (int influence = 0; influence < MAX_BONE_INFLUENCE; influence++)
+        {
+            const float weight = vertex.bone_weights[influence];
+            if (weight <= 0.f)
+                continue;
+
+            const JointMatrix& joint = scratch.palette[vertex.bone_ids[influence]];
+            for (int row = 0; row < 3; row++)
+            {
+                rows[row] += weight * joint.rows[row];
+            }
+            total += weight;
+        }
+        if (total == 0.f)
+        {
+            scratch.positions[index] = vertex.position;
+            scratch.normals[index]   = vertex.normal;
+            continue;
+        }
+
+        const glm::vec4 position(vertex.position, 1.f);
+        const glm::vec4 normal(vertex.normal, 0.f);
+        const glm::vec3 skinned_normal(
+            glm::dot(rows[0], normal), glm::dot(rows[1], normal), glm::dot(rows[2], normal));
+        const float length = glm::length(skinned_normal);
+
+        scratch.positions[index] = glm::vec3(
+            glm::dot(rows[0], position), glm::dot(rows[1], position), glm::dot(rows[2], position));
+        scratch.normals[index] = length > 0.f ? skinned_normal / length : vertex.normal;
+    }
+}
+
+static glm::vec3 decodePosition(const VertexAnimation& baked, size_t texel)
+{
+    const uint16_t* position = &baked.positions[texel * 3];
+    return baked.bounds_min +
+           glm::vec3(position[0], position[1], position[2]) / 65535.f * baked.bounds_extent;
+}
+
+static glm::vec3 decodeNormal(const VertexAnimation& baked, size_t texel)
+{
+    const int8_t* normal = &baked.normals[texel * 4];
+    return glm::max(glm::vec3(normal[0], normal[1], normal[2]) / 127.f, glm::vec3(-1.f));
+}
+
+// in degrees, precise for small angles unlike acos
+static float angleBetween(const glm::vec3& a, const glm::vec3& b)
+{
+    return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+}
+
+bool bakeVertexAnimation(const Skeleton&                    skeleton,
+                         const std::vector<CompressedClip>& clips,
+                         const std::vector<Mesh*>&          meshes,
+                         const VertexAnimationSettings&     settings,
+                         JobSystem&                         jobs,
+                         VertexAnimation&                   baked)
+{
+    baked = VertexAnimation();
+
+    std::vector<Vertex> vertices;
+    for (const Mesh* mesh : meshes)
+    {
+        baked.mesh_offsets.push_back(static_cast<uint32_t>(vertices.size()));
+        vertices.insert(vertices.end(), mesh->vertices.begin(), mesh->vertices.end());
+    }
+    if (vertices.empty() || clips.empty())
+        return false;
+
+    // the clip of every frame
+    const float           sample_rate = std::max(settings.sample_rate, 1.f);
+    std::vector<uint32_t> frame_clips;
+    for (uint32_t index = 0; index < clips.size(); index++)
+    {
+        const CompressedClip& source = clips[index];
+
+        VertexAnimationClip clip;
+        clip.name        = source.name;
+        clip.first_frame = static_cast<uint32_t>(frame_clips.size());
+        clip.frame_count =
+            std::max(1u, static_cast<uint32_t>(std::lround(source.duration * sample_rate)));
+        clip.duration = source.duration > 0.f ? source.duration : 1.f / sample_rate;
+        baked.clips.push_back(clip);
+        frame_clips.insert(frame_clips.end(), clip.frame_count, index);
+    }
+
+    baked.vertex_count   = static_cast<uint32_t>(vertices.size());
+    baked.width          = std::min(baked.vertex_count, std::max(settings.max_width, 1u));
+    baked.rows_per_frame = (baked.vertex_count + baked.width - 1) / baked.width;
+    baked.frame_count    = static_cast<uint32_t>(frame_clips.size());
+    if (baked.getHeight() > settings.max_height)
+    {
+        std::cout << "ERROR::VERTEX_ANIMATION:: " << baked.frame_count << " frames of "
+                  << baked.vertex_count << " vertices need " << baked.getHeight()
+                  << " rows, more than " << settings.max_height << std::endl;
+        return false;
+    }
+
+    // seconds into its clip of a frame, offset in frames
+    auto frameTime = [&](uint32_t frame, float offset) {
+        const VertexAnimationClip& clip = baked.clips[frame_clips[frame]];
+        return (frame - clip.first_frame + offset) * clip.duration / clip.frame_count;
+    };
+    auto frameClip = [&](uint32_t frame) -> const CompressedClip& {
+        return clips[frame_clips[frame]];
+    };
+
+    const uint32_t            thread_count = jobs.getThreadCount();
+    std::vector<FrameScratch> scratch(thread_count);
+
+    // the quantization range, the bounds of every frame
+    std::vector<glm::vec3> thread_mins(thread_count, glm::vec3(FLT_MAX));
+    std::vector<glm::vec3> thread_maxs(thread_count, glm::vec3(-FLT_MAX));
+    jobs.parallelFor(baked.frame_count, 1, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+        for (uint32_t frame = begin; frame < end; frame++)
+        {
+            skinFrame(skeleton, frameClip(frame), frameTime(frame, 0.f), vertices, scratch[thread]);
+            for (const auto& position : scratch[thread].positions)
+            {
+                thread_mins[thread] = glm::min(thread_mins[thread], position);
+                thread_maxs[thread] = glm::max(thread_maxs[thread], position);
+            }
+        }
+    });
+    glm::vec3 bounds_max(-FLT_MAX);
+    baked.bounds_min = glm::vec3(FLT_MAX);
+    for (uint32_t thread = 0; thread < thread_count; thread++)
+    {
+        baked.bounds_min = glm::min(baked.bounds_min, thread_mins[thread]);
+        bounds_max       = glm::max(bounds_max, thread_maxs[thread]);
+    }
+    baked.bounds_extent = glm::max(bounds_max - baked.bounds_min, glm::vec3(1e-6f));
+
+    // quantizes every frame, the padding at the end of the last row of a frame stays 0
+    const size_t frame_texels = static_cast<size_t>(baked.rows_per_frame) * baked.width;
+    baked.positions.resize(frame_texels * baked.frame_count * 3, 0);
+    baked.normals.resize(frame_texels * baked.frame_count * 4, 0);
+    std::vector<float> frame_position_errors(baked.frame_count, 0.f);
+    jobs.parallelFor(baked.frame_count, 1, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+        FrameScratch& frame_scratch = scratch[thread];
+        for (uint32_t frame = begin; frame < end; frame++)
+        {
+            skinFrame(skeleton, frameClip(frame), frameTime(frame, 0.f), vertices, frame_scratch);
+            for (uint32_t vertex = 0; vertex < baked.vertex_count; vertex++)
+            {
+                const size_t    texel = frame * frame_texels + vertex;
+                const glm::vec3 unit  = glm::clamp(
+                    (frame_scratch.positions[vertex] - baked.bounds_min) / baked.bounds_extent,
+                    0.f,
+                    1.f);
+                const glm::vec3 normal = glm::clamp(frame_scratch.normals[vertex], -1.f, 1.f);
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    baked.positions[texel * 3 + axis] =
+                        static_cast<uint16_t>(std::lround(unit[axis] * 65535.f));
+                    baked.normals[texel * 4 + axis] =
+                        static_cast<int8_t>(std::lround(normal[axis] * 127.f));
+                }
+
+                frame_position_errors[frame] =
+                    std::max(frame_position_errors[frame],
+                             glm::length(decodePosition(baked, texel) -
+                                         frame_scratch.positions[vertex]));
+            }
+        }
+    });
+
+    // halfway between a frame and the next, which for the last one of a clip is its first
+    std::vector<float> position_errors(baked.frame_count, 0.f);
+    std::vector<float> normal_errors(baked.frame_count, 0.f);
+    jobs.parallelFor(baked.frame_count, 1, [&](uint32_t begin, uint32_t end, uint32_t thread) {
+        FrameScratch& frame_scratch = scratch[thread];
+        for (uint32_t frame = begin; frame < end; frame++)
+        {
+            const VertexAnimationClip& clip = baked.clips[frame_clips[frame]];
+            const uint32_t             next =
+                clip.first_frame + (frame - clip.first_frame + 1) % clip.frame_count;
+
+            skinFrame(skeleton, frameClip(frame), frameTime(frame, 0.5f), vertices, frame_scratch);
+            for (uint32_t vertex = 0; vertex < baked.vertex_count; vertex++)
+            {
+                const size_t    texel      = frame * frame_texels + vertex;
+                const size_t    next_texel = next * frame_texels + vertex;
+                const glm::vec3 position =
+                    0.5f * (decodePosition(baked, texel) + decodePosition(baked, next_texel));
+                const glm::vec3 normal = glm::normalize(decodeNormal(baked, texel) +
+                                                        decodeNormal(baked, next_texel));
+
+                position_errors[frame] =
+                    std::max(position_errors[frame],
+                             glm::length(position - frame_scratch.positions[vertex]));
+                normal_errors[frame] = std::max(
+                    normal_errors[frame], angleBetween(normal, frame_scratch.normals[vertex]));
+            }
+        }
+    });
+
+    for (auto& clip : baked.clips)
+    {
+        clip.memory = clip.frame_count * frame_texels * (3 * sizeof(uint16_t) + 4 * sizeof(int8_t));
+        for (uint32_t frame = clip.first_frame; frame < clip.first_frame + clip.frame_count;
+             frame++)
+        {
+            clip.frame_position_error =
+                std::max(clip.frame_position_error, frame_position_errors[frame]);
+            clip.position_error = std::max(clip.position_error, position_errors[frame]);
+            clip.normal_error   = std::max(clip.normal_error, normal_errors[frame]);
+        }
+    }
+    return true;
+}
+
+VertexAnimationTextures::VertexAnimationTextures(const VertexAnimation& baked)
+{
+    glGenTextures(1, &position_tex_);
+    glBindTexture(GL_TEXTURE_2D, position_tex_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_RGB16,
+                 baked.width,
+                 baked.getHeight(),
+                 0,
+                 GL_RGB,
+                 GL_UNSIGNED_SHORT,
+                 baked.positions.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &normal_tex_);
+    glBindTexture(GL_TEXTURE_2D, normal_tex_);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_RGBA8_SNORM,
+                 baked.width,
+                 baked.getHeight(),
+                 0,
+                 GL_RGBA,
+                 GL_BYTE,
+                 baked.normals.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    std::vector<uint8_t> table(sizeof(GpuAnimationHeader) +
+                               baked.clips.size() * sizeof(GpuAnimationClip));
+    GpuAnimationHeader*  header = reinterpret_cast<GpuAnimationHeader*>(table.data());
+    header->bounds_min          = baked.bounds_min;
+    header->rows_per_frame      = baked.rows_per_frame;
+    header->bounds_extent       = baked.bounds_extent;
+    header->width               = baked.width;
+    GpuAnimationClip* clips     = reinterpret_cast<GpuAnimationClip*>(header + 1);
+    for (size_t index = 0; index < baked.clips.size(); index++)
+    {
+        clips[index] = GpuAnimationClip {baked.clips[index].first_frame,
+                                         baked.clips[index].frame_count,
+                                         baked.clips[index].duration,
+                                         0.f};
+    }
+
+    glGenBuffers(1, &clip_buffer_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clip_buffer_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, table.size(), table.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    memory_ = baked.getMemoryUsage() + table.size();
+}
+
+VertexAnimationTextures::~VertexAnimationTextures()
+{
+    glDeleteTextures(1, &position_tex_);
+    glDeleteTextures(1, &normal_tex_);
+    glDeleteBuffers(1, &clip_buffer_);
+}
+
+void VertexAnimationTextures::bind(uint32_t unit, uint32_t binding) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, position_tex_);
+    glActiveTexture(GL_TEXTURE0 + unit + 1);
+    glBindTexture(GL_TEXTURE_2D, normal_tex_);
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, clip_buffer_);
+}
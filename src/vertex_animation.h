@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "animation_compression.h"
+
+class JobSystem;
+class Mesh;
+
+struct VertexAnimationSettings
+{
+    float    sample_rate {30.f}; // frames per second baked of every clip
+    uint32_t max_width {8192};   // texels per row, longer frames wrap over several rows
+    uint32_t max_height {16384}; // rows, the texture size limit of the GL
+};
+
+struct VertexAnimationClip
+{
+    std::string name;
+    uint32_t    first_frame {0};
+    uint32_t    frame_count {0};
+    float       duration {0.f}; // seconds, the frames cover it evenly and loop
+    size_t      memory {0};     // bytes of both textures the frames take
+
+    // largest differences from skinning the clip, over every vertex: at the baked frames, which
+    // is the quantization alone, and halfway between them, which adds the interpolation
+    float frame_position_error {0.f}; // model units
+    float position_error {0.f};
+    float normal_error {0.f}; // degrees
+};
+
+// Skinned meshes baked into two textures: the position and the normal of every vertex at every
+// frame of every clip. A frame is a run of vertex_count texels that wraps over rows_per_frame rows
+// of width texels, the frames of a clip follow each other. Positions are 16-bit unorm over the
+// bounds of every frame, normals 8-bit snorm.
+struct VertexAnimation
+{
+    uint32_t              vertex_count {0};
+    uint32_t              width {0};
+    uint32_t              rows_per_frame {0};
+    uint32_t              frame_count {0};
+    std::vector<uint32_t> mesh_offsets; // first vertex of every mesh
+    glm::vec3             bounds_min {0.f};
+    glm::vec3             bounds_extent {0.f};
+
+    std::vector<VertexAnimationClip> clips;
+
+    std::vector<uint16_t> positions; // rgb per texel
+    std::vector<int8_t>   normals;   // rgba per texel
+
+    uint32_t getHeight() const
+    {
+        return frame_count * rows_per_frame;
+    }
+    size_t getMemoryUsage() const
+    {
+        return positions.size() * sizeof(uint16_t) + normals.size() * sizeof(int8_t);
+    }
+};
+
+// samples every clip at the settings' rate, skins the vertices of the meshes in parallel and
+// measures the error of the result. Returns false when the meshes or the clips are empty or the
+// frames don't fit in max_height rows
+bool bakeVertexAnimation(const Skeleton&                    skeleton,
+                         const std::vector<CompressedClip>& clips,
+                         const std::vector<Mesh*>&          meshes,
+                         const VertexAnimationSettings&     settings,
+                         JobSystem&                         jobs,
+                         VertexAnimation&                   baked);
+
+// The textures and the clip table of a bake, what the scene vertex shaders animate streamed
+// instances with: the custom data of an instance holds its clip, time offset and speed
+class VertexAnimationTextures {
+public:
+    explicit VertexAnimationTextures(const VertexAnimation& baked);
+    ~VertexAnimationTextures();
+
+    VertexAnimationTextures(const VertexAnimationTextures&) = delete;
+    VertexAnimationTextures& operator=(const VertexAnimationTextures&) = delete;
+
+    // positions to unit, normals to unit + 1, the clip table to a shader storage binding
+    void bind(uint32_t unit, uint32_t binding) const;
+
+    size_t getMemoryUsage() const
+    {
+        return memory_;
+    }
+
+private:
+    uint32_t position_tex_ {0};
+    uint32_t normal_tex_ {0};
+    uint32_t clip_buffer_ {0};
+    size_t   memory_ {0};
+};
@@ -0,0 +1,603 @@
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+
+#include "mesh.h"
+#include "visibility_renderer.h"
+
+static constexpr uint32_t k_tile_size      = 8;
+static constexpr uint32_t k_floats_per_vtx = 11;
+
+// binding points shared with the visbuffer shaders, 0 is the point light buffer
+static constexpr uint32_t k_draws_binding           = 1;
+static constexpr uint32_t k_vertices_binding        = 2;
+static constexpr uint32_t k_indices_binding         = 3;
+static constexpr uint32_t k_material_args_binding   = 4;
+static constexpr uint32_t k_material_tiles_binding  = 5;
+static constexpr uint32_t k_clusters_binding        = 20;
+static constexpr uint32_t k_culled_commands_binding = 21;
+static constexpr uint32_t k_cluster_counts_binding  = 22;
+
+static constexpr uint32_t k_cull_group_size = 64;
+
+// frustum planes of a view projection, normalized so they give distances
+static void frustumPlanes(const glm::mat4& view_projection, glm::vec4 (&planes)[6])
+{
+    const glm::mat4 rows = glm::transpose(view_projection);
+    for (int axis = 0; axis < 3; axis++)
+    {
+        planes[2 * axis]     = rows[3] + rows[axis];
+        planes[2 * axis + 1] = rows[3] - rows[axis];
+    }
+    for (auto& plane : planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+VisibilityRenderer::VisibilityRenderer(uint32_t width, uint32_t height) :
+    width_(width),
+    height_(height),
+    render_width_(width),
+    render_height_(height),
+    raster_shader_("../../../shader/visbuffer.vs", "../../../shader/visbuffer.fs"),
+    classify_shader_("../../../shader/visbuffer_classify.cs"),
+    shade_shader_("../../../shader/visbuffer_shade.cs"),
+    cull_shader_("../../../shader/visbuffer_cull.cs")
+{
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vertex_buffer_);
+    glGenBuffers(1, &index_buffer_);
+    glGenBuffers(1, &draw_buffer_);
+    glGenBuffers(1, &command_buffer_);
+    glGenBuffers(1, &cluster_buffer_);
+    glGenBuffers(1, &culled_command_buffer_);
+    glGenBuffers(2, count_buffers_);
+    glGenBuffers(1, &material_args_buffer_);
+    glGenBuffers(1, &material_tiles_buffer_);
+
+    createTargets();
+}
+
+VisibilityRenderer::~VisibilityRenderer()
+{
+    destroyTargets();
+
+    const uint32_t buffers[] = {vertex_buffer_,
+                                index_buffer_,
+                                draw_buffer_,
+                                command_buffer_,
+                                cluster_buffer_,
+                                culled_command_buffer_,
+                                count_buffers_[0],
+                                count_buffers_[1],
+                                material_args_buffer_,
+                                material_tiles_buffer_};
+    glDeleteBuffers(10, buffers);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+void VisibilityRenderer::resize(uint32_t width, uint32_t height)
+{
+    if (width == width_ && height == height_)
+        return;
+
+    width_         = width;
+    height_        = height;
+    render_width_  = width;
+    render_height_ = height;
+
+    destroyTargets();
+    createTargets();
+}
+
+void VisibilityRenderer::setRenderSize(uint32_t width, uint32_t height)
+{
+    render_width_  = glm::clamp(width, 1u, width_);
+    render_height_ = glm::clamp(height, 1u, height_);
+}
+
+uint32_t VisibilityRenderer::addMesh(const Mesh& mesh, const glm::mat4& transform)
+{
+    if (draws_.size() >= k_max_draws ||
+        mesh.indices.size() / 3 >= (1u << k_triangle_bits))
+    {
+        std::cout << "ERROR::VISIBILITY:: Mesh doesn't fit in the visibility id encoding"
+                  << std::endl;
+        return k_max_draws;
+    }
+
+    Material material {0, 0};
+    for (const auto& texture : mesh.textures)
+    {
+        if (texture.type == TextureType::_diffuse && material.diffuse == 0)
+            material.diffuse = texture.id;
+        else if (texture.type == TextureType::_specular && material.specular == 0)
+            material.specular = texture.id;
+    }
+
+    uint32_t material_index = 0;
+    while (material_index < materials_.size() &&
+           (materials_[material_index].diffuse != material.diffuse ||
+            materials_[material_index].specular != material.specular))
+    {
+        material_index++;
+    }
+    if (material_index == materials_.size())
+    {
+        if (materials_.size() >= k_max_materials)
+        {
+            std::cout << "ERROR::VISIBILITY:: Too many materials" << std::endl;
+            return k_max_draws;
+        }
+        materials_.push_back(material);
+    }
+
+    DrawData draw;
+    draw.model         = transform;
+    draw.normal_matrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(transform))));
+    draw.first_index   = static_cast<uint32_t>(indices_.size());
+    draw.base_vertex   = static_cast<uint32_t>(vertices_.size() / k_floats_per_vtx);
+    draw.material      = material_index;
+    draw.pad           = 0;
+
+    const uint32_t draw_index = static_cast<uint32_t>(draws_.size());
+    draws_.push_back(draw);
+
+    // one command per meshlet, its base instance finds the cluster in the shaders
+    for (const auto& meshlet : mesh.meshlets)
+    {
+        ClusterData cluster;
+        cluster.sphere         = glm::vec4(meshlet.center, meshlet.radius);
+        cluster.cone           = glm::vec4(meshlet.cone_axis, meshlet.cone_cutoff);
+        cluster.draw           = draw_index;
+        cluster.first_triangle = meshlet.first_triangle;
+        cluster.triangle_count = meshlet.triangle_count;
+        cluster.pad            = 0;
+
+        DrawCommand command;
+        command.count          = meshlet.triangle_count * 3;
+        command.instance_count = 1;
+        command.first_index    = draw.first_index + meshlet.first_triangle * 3;
+        command.base_vertex    = static_cast<int32_t>(draw.base_vertex);
+        command.base_instance  = static_cast<uint32_t>(clusters_.size());
+
+        clusters_.push_back(cluster);
+        commands_.push_back(command);
+    }
+
+    vertices_.reserve(vertices_.size() + mesh.vertices.size() * k_floats_per_vtx);
+    for (const auto& vertex : mesh.vertices)
+    {
+        const float packed[k_floats_per_vtx] = {vertex.position.x,
+                                                vertex.position.y,
+                                                vertex.position.z,
+                                                vertex.normal.x,
+                                                vertex.normal.y,
+                                                vertex.normal.z,
+                                                vertex.texcoords.x,
+                                                vertex.texcoords.y,
+                                                vertex.lightmap_texcoords.x,
+                                                vertex.lightmap_texcoords.y,
+                                                vertex.occlusion};
+        vertices_.insert(vertices_.end(), packed, packed + k_floats_per_vtx);
+    }
+    indices_.insert(indices_.end(), mesh.indices.begin(), mesh.indices.end());
+
+    return draw_index;
+}
+
+void VisibilityRenderer::setTransform(uint32_t draw, const glm::mat4& transform)
+{
+    if (draw >= draws_.size())
+        return;
+
+    draws_[draw].model         = transform;
+    draws_[draw].normal_matrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(transform))));
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, draw_buffer_);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+                    draw * sizeof(DrawData),
+                    2 * sizeof(glm::mat4),
+                    &draws_[draw]);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void VisibilityRenderer::build()
+{
+    glBindVertexArray(vao_);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+    glBufferData(
+        GL_ARRAY_BUFFER, vertices_.size() * sizeof(float), vertices_.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, k_floats_per_vtx * sizeof(float), (void*)0);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 indices_.size() * sizeof(uint32_t),
+                 indices_.data(),
+                 GL_STATIC_DRAW);
+
+    glBindVertexArray(0);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, draw_buffer_);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, draws_.size() * sizeof(DrawData), draws_.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                 commands_.size() * sizeof(DrawCommand),
+                 commands_.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled_command_buffer_);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER,
+                 commands_.size() * sizeof(DrawCommand),
+                 nullptr,
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cluster_buffer_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 clusters_.size() * sizeof(ClusterData),
+                 clusters_.data(),
+                 GL_STATIC_DRAW);
+    const ClusterCounts zero_counts {};
+    for (uint32_t buffer : count_buffers_)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(
+            GL_SHADER_STORAGE_BUFFER, sizeof(ClusterCounts), &zero_counts, GL_DYNAMIC_READ);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    cluster_stats_          = ClusterStats();
+    cluster_stats_.clusters = static_cast<uint32_t>(clusters_.size());
+    for (const auto& cluster : clusters_)
+    {
+        cluster_stats_.triangles += cluster.triangle_count;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, material_args_buffer_);
+    glBufferData(
+        GL_SHADER_STORAGE_BUFFER, k_max_materials * sizeof(glm::uvec4), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    allocateTileLists();
+
+    geometry_bytes_ = vertices_.size() * sizeof(float) + indices_.size() * sizeof(uint32_t) +
+                      draws_.size() * sizeof(DrawData) +
+                      clusters_.size() * (sizeof(ClusterData) + 2 * sizeof(DrawCommand));
+
+    std::cout << "Info: Visibility buffer geometry " << vertices_.size() / k_floats_per_vtx
+              << " vertices, " << indices_.size() / 3 << " triangles, " << draws_.size()
+              << " draws, " << clusters_.size() << " clusters, " << materials_.size()
+              << " materials" << std::endl;
+
+    // the gpu copies are the only ones needed from now on
+    std::vector<float>().swap(vertices_);
+    std::vector<uint32_t>().swap(indices_);
+}
+
+void VisibilityRenderer::render(const glm::mat4& view,
+                                const glm::mat4& projection,
+                                uint32_t         light_count,
+                                const glm::vec3& clear_color)
+{
+    rasterize(view, projection);
+    shade(view, projection, light_count, clear_color);
+}
+
+void VisibilityRenderer::rasterize(const glm::mat4& view, const glm::mat4& projection)
+{
+    const glm::mat4 view_projection = projection * view;
+    const glm::vec3 view_pos        = glm::vec3(glm::inverse(view)[3]);
+
+    bindBuffers();
+
+    // 0. drop the clusters off screen or facing away
+    const uint32_t draw_count = cullClusters(view_projection, view_pos);
+
+    // 1. visibility: ids and depth only
+    raster_timer_.begin();
+    glBindFramebuffer(GL_FRAMEBUFFER, visibility_fbo_);
+    glViewport(0, 0, render_width_, render_height_);
+    const GLuint empty_pixel[] = {0xffffffffu, 0, 0, 0};
+    glClearBufferuiv(GL_COLOR, 0, empty_pixel);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+
+    // the clusters were only culled as facing away for back faces to be culled too
+    if (cluster_culling_ != ClusterCulling::off)
+        glEnable(GL_CULL_FACE);
+
+    raster_shader_.use();
+    raster_shader_.setMat4fv("viewProjection", glm::value_ptr(view_projection));
+
+    glBindVertexArray(vao_);
+    if (cluster_culling_ == ClusterCulling::gpu)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled_command_buffer_);
+        glBindBuffer(GL_PARAMETER_BUFFER, count_buffers_[cull_frame_ % 2]);
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES,
+                                         GL_UNSIGNED_INT,
+                                         nullptr,
+                                         offsetof(ClusterCounts, draw_count),
+                                         static_cast<GLsizei>(commands_.size()),
+                                         0);
+        glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    }
+    else
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
+                     cluster_culling_ == ClusterCulling::off ? command_buffer_ :
+                                                               culled_command_buffer_);
+        glMultiDrawElementsIndirect(
+            GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(draw_count), 0);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    glBindVertexArray(0);
+    glDisable(GL_CULL_FACE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    raster_timer_.end();
+
+    // 2. bin tiles per material
+    classify_timer_.begin();
+    const GLuint empty_args[] = {0, 1, 1, 0};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, material_args_buffer_);
+    glClearBufferData(
+        GL_SHADER_STORAGE_BUFFER, GL_RGBA32UI, GL_RGBA_INTEGER, GL_UNSIGNED_INT, empty_args);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+    glBindImageTexture(0, visibility_tex_, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+    classify_shader_.use();
+    classify_shader_.setUint("maxTiles", max_tiles_);
+    classify_shader_.setVec2i("renderSize", render_width_, render_height_);
+    glDispatchCompute((render_width_ + k_tile_size - 1) / k_tile_size,
+                      (render_height_ + k_tile_size - 1) / k_tile_size,
+                      1);
+    classify_timer_.end();
+}
+
+void VisibilityRenderer::shade(const glm::mat4& view,
+                               const glm::mat4& projection,
+                               uint32_t         light_count,
+                               const glm::vec3& clear_color)
+{
+    const glm::mat4 view_projection = projection * view;
+    const glm::vec3 view_pos        = glm::vec3(glm::inverse(view)[3]);
+
+    // other passes may have run since rasterize()
+    bindBuffers();
+
+    // 3. one indirect dispatch per material over the tiles that contain it
+    shade_timer_.begin();
+    const GLfloat clear_value[] = {clear_color.x, clear_color.y, clear_color.z, 1.f};
+    glClearTexSubImage(output_tex_,
+                       0,
+                       0,
+                       0,
+                       0,
+                       render_width_,
+                       render_height_,
+                       1,
+                       GL_RGBA,
+                       GL_FLOAT,
+                       clear_value);
+
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    glBindImageTexture(1, output_tex_, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    shade_shader_.use();
+    shade_shader_.setMat4fv("viewProjection", glm::value_ptr(view_projection));
+    shade_shader_.setVec3f("viewPos", view_pos.x, view_pos.y, view_pos.z);
+    shade_shader_.setUint("lightCount", light_count);
+    shade_shader_.setUint("maxTiles", max_tiles_);
+    shade_shader_.setVec2i("renderSize", render_width_, render_height_);
+
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, material_args_buffer_);
+    for (uint32_t index = 0; index < materials_.size(); index++)
+    {
+        shade_shader_.setUint("material", index);
+        shade_shader_.setBool("hasSpecularMap", materials_[index].specular != 0);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, materials_[index].diffuse);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, materials_[index].specular);
+
+        glDispatchComputeIndirect(static_cast<GLintptr>(index * sizeof(glm::uvec4)));
+    }
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    // the output is sampled by the post-processing
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    shade_timer_.end();
+}
+
+uint32_t VisibilityRenderer::cullClusters(const glm::mat4& view_projection,
+                                          const glm::vec3& view_pos)
+{
+    const uint32_t cluster_count = static_cast<uint32_t>(clusters_.size());
+    if (cluster_culling_ == ClusterCulling::off)
+    {
+        cluster_stats_.frustum_culled  = 0;
+        cluster_stats_.cone_culled     = 0;
+        cluster_stats_.drawn_triangles = cluster_stats_.triangles;
+        return cluster_count;
+    }
+
+    glm::vec4 planes[6];
+    frustumPlanes(view_projection, planes);
+
+    if (cluster_culling_ == ClusterCulling::cpu)
+    {
+        cluster_stats_.frustum_culled  = 0;
+        cluster_stats_.cone_culled     = 0;
+        cluster_stats_.drawn_triangles = 0;
+        culled_commands_.clear();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t index = 0; index < cluster_count; index++)
+        {
+            const ClusterData& cluster = clusters_[index];
+            const glm::mat4&   model   = draws_[cluster.draw].model;
+
+            // the transforms are similarities, the largest scale keeps the sphere conservative
+            const glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(cluster.sphere), 1.f));
+            const float     scale  = std::max(glm::length(glm::vec3(model[0])),
+                                         std::max(glm::length(glm::vec3(model[1])),
+                                                  glm::length(glm::vec3(model[2]))));
+            const float     radius = cluster.sphere.w * scale;
+
+            bool inside = true;
+            for (const auto& plane : planes)
+            {
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                {
+                    inside = false;
+                    break;
+                }
+            }
+            if (!inside)
+            {
+                cluster_stats_.frustum_culled++;
+                continue;
+            }
+
+            const glm::vec3 axis      = glm::normalize(glm::mat3(model) * glm::vec3(cluster.cone));
+            const glm::vec3 direction = center - view_pos;
+            if (glm::dot(direction, axis) >= cluster.cone.w * glm::length(direction) + radius)
+            {
+                cluster_stats_.cone_culled++;
+                continue;
+            }
+
+            culled_commands_.push_back(commands_[index]);
+            cluster_stats_.drawn_triangles += cluster.triangle_count;
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culled_command_buffer_);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER,
+                        0,
+                        culled_commands_.size() * sizeof(DrawCommand),
+                        culled_commands_.data());
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        cull_cpu_ms_ = std::chrono::duration<float, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+        return static_cast<uint32_t>(culled_commands_.size());
+    }
+
+    // the counts of the last frame have had a frame to land, reading them seldom waits
+    const uint32_t previous = count_buffers_[(cull_frame_ + 1) % 2];
+    ClusterCounts  counts;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, previous);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ClusterCounts), &counts);
+    cluster_stats_.frustum_culled  = counts.frustum_culled;
+    cluster_stats_.cone_culled     = counts.cone_culled;
+    cluster_stats_.drawn_triangles = counts.drawn_triangles;
+
+    cull_frame_++;
+    const uint32_t current = count_buffers_[cull_frame_ % 2];
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, current);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    cull_timer_.begin();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_culled_commands_binding, culled_command_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_cluster_counts_binding, current);
+
+    cull_shader_.use();
+    glUniform4fv(
+        glGetUniformLocation(cull_shader_.ID, "frustumPlanes"), 6, glm::value_ptr(planes[0]));
+    cull_shader_.setVec3f("cameraPosition", view_pos.x, view_pos.y, view_pos.z);
+    cull_shader_.setUint("clusterCount", cluster_count);
+    glDispatchCompute((cluster_count + k_cull_group_size - 1) / k_cull_group_size, 1, 1);
+
+    // the raster reads the commands and their count
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    cull_timer_.end();
+    return 0;
+}
+
+void VisibilityRenderer::bindBuffers() const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_draws_binding, draw_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_vertices_binding, vertex_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_indices_binding, index_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_material_args_binding, material_args_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_material_tiles_binding, material_tiles_buffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, k_clusters_binding, cluster_buffer_);
+}
+
+size_t VisibilityRenderer::getMemoryUsage() const
+{
+    // R32UI + D32F + RGBA16F output
+    const size_t targets = static_cast<size_t>(width_) * height_ * (4 + 4 + 8);
+    return targets + getTileListsSize() + geometry_bytes_;
+}
+
+void VisibilityRenderer::createTargets()
+{
+    glGenFramebuffers(1, &visibility_fbo_);
+    glBindFramebuffer(GL_FRAMEBUFFER, visibility_fbo_);
+
+    glGenTextures(1, &visibility_tex_);
+    glBindTexture(GL_TEXTURE_2D, visibility_tex_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width_, height_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, visibility_tex_, 0);
+
+    // a texture rather than a renderbuffer, the ambient occlusion reads it
+    glGenTextures(1, &depth_tex_);
+    glBindTexture(GL_TEXTURE_2D, depth_tex_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width_, height_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_tex_, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cout << "ERROR::FRAMEBUFFER:: Visibility buffer is not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenTextures(1, &output_tex_);
+    glBindTexture(GL_TEXTURE_2D, output_tex_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16F, width_, height_);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    max_tiles_ = ((width_ + k_tile_size - 1) / k_tile_size) *
+                 ((height_ + k_tile_size - 1) / k_tile_size);
+    allocateTileLists();
+}
+
+void VisibilityRenderer::allocateTileLists()
+{
+    // worst case every tile holds every material
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, material_tiles_buffer_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, getTileListsSize(), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+size_t VisibilityRenderer::getTileListsSize() const
+{
+    const size_t material_count = materials_.empty() ? 1 : materials_.size();
+    return static_cast<size_t>(max_tiles_) * material_count * sizeof(uint32_t);
+}
+
+void VisibilityRenderer::destroyTargets()
+{
+    const uint32_t textures[] = {visibility_tex_, depth_tex_, output_tex_};
+    glDeleteTextures(3, textures);
+    glDeleteFramebuffers(1, &visibility_fbo_);
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "gpu_timer.h"
+#include "shader.h"
+
+class Mesh;
+
+// Visibility-buffer path. Every mesh is merged into shared vertex/index storage buffers and the
+// scene is rasterized with a single multi-draw into a R32UI target holding (draw, triangle) ids
+// plus depth. Materials are then resolved per 8x8 tile: a classification pass bins tiles by the
+// materials they contain and one indirect dispatch per material rebuilds the triangle of each
+// pixel from the geometry buffers and shades it, so shading cost no longer scales with overdraw.
+//
+// Every meshlet of a mesh is a draw command of its own, so the clusters off screen or facing away
+// from the camera can be dropped before the multi-draw, on the CPU or in a compute pass. Facing
+// away is only a loss when back faces are culled, the raster culls them whenever the clusters are.
+class VisibilityRenderer {
+public:
+    static constexpr uint32_t k_triangle_bits = 23;
+    static constexpr uint32_t k_max_draws     = 1u << (32 - k_triangle_bits);
+    static constexpr uint32_t k_max_materials = 256;
+
+    enum class ClusterCulling
+    {
+        off, // every cluster drawn, back faces too
+        cpu, // culled here, the commands uploaded every frame
+        gpu  // culled in a compute pass that writes the commands and their count
+    };
+
+    // of the last culled frame, a frame late when culling on the GPU
+    struct ClusterStats
+    {
+        uint32_t clusters {0};
+        uint32_t frustum_culled {0};
+        uint32_t cone_culled {0};
+        uint32_t triangles {0};
+        uint32_t drawn_triangles {0};
+    };
+
+    VisibilityRenderer(uint32_t width, uint32_t height);
+    ~VisibilityRenderer();
+
+    VisibilityRenderer(const VisibilityRenderer&) = delete;
+    VisibilityRenderer& operator=(const VisibilityRenderer&) = delete;
+
+    void resize(uint32_t width, uint32_t height);
+
+    // renders into the bottom-left width x height of the targets only, for dynamic resolution.
+    // resize() goes back to the full targets
+    void setRenderSize(uint32_t width, uint32_t height);
+
+    // appends a mesh to the merged geometry and returns its draw index, build() uploads
+    // everything added so far
+    uint32_t addMesh(const Mesh& mesh, const glm::mat4& transform);
+    void     build();
+
+    // moves a draw after build()
+    void setTransform(uint32_t draw, const glm::mat4& transform);
+
+    // rasterize() and shade() in one go. Lights are read from the GpuPointLight storage buffer
+    // bound at binding point 0
+    void render(const glm::mat4& view,
+                const glm::mat4& projection,
+                uint32_t         light_count,
+                const glm::vec3& clear_color);
+
+    // visibility and depth, then the material tile lists
+    void rasterize(const glm::mat4& view, const glm::mat4& projection);
+    // resolves the materials of the last rasterize() into the output
+    void shade(const glm::mat4& view,
+               const glm::mat4& projection,
+               uint32_t         light_count,
+               const glm::vec3& clear_color);
+
+    uint32_t getOutputTexture() const
+    {
+        return output_tex_;
+    }
+    uint32_t getDepthTexture() const
+    {
+        return depth_tex_;
+    }
+
+    float getRasterMs() const
+    {
+        return raster_timer_.getElapsedMs();
+    }
+    float getClassifyMs() const
+    {
+        return classify_timer_.getElapsedMs();
+    }
+    float getShadeMs() const
+    {
+        return shade_timer_.getElapsedMs();
+    }
+    // of the compute pass, and of the loop on the CPU path
+    float getCullMs() const
+    {
+        return cull_timer_.getElapsedMs();
+    }
+    float getCullCpuMs() const
+    {
+        return cull_cpu_ms_;
+    }
+
+    void setClusterCulling(ClusterCulling culling)
+    {
+        cluster_culling_ = culling;
+    }
+    ClusterCulling getClusterCulling() const
+    {
+        return cluster_culling_;
+    }
+    const ClusterStats& getClusterStats() const
+    {
+        return cluster_stats_;
+    }
+
+    // render targets plus geometry copies, in bytes
+    size_t getMemoryUsage() const;
+
+private:
+    // std430 mirror of DrawData in the visbuffer shaders
+    struct DrawData
+    {
+        glm::mat4 model;
+        glm::mat4 normal_matrix;
+        uint32_t  first_index;
+        uint32_t  base_vertex;
+        uint32_t  material;
+        uint32_t  pad;
+    };
+
+    // std430 mirror of ClusterData in the visbuffer shaders, a meshlet of a draw
+    struct ClusterData
+    {
+        glm::vec4 sphere; // model space center, radius
+        glm::vec4 cone;   // model space axis, cutoff
+        uint32_t  draw;
+        uint32_t  first_triangle;
+        uint32_t  triangle_count;
+        uint32_t  pad;
+    };
+
+    // written by the culling compute pass, its draw count is the indirect parameter
+    struct ClusterCounts
+    {
+        uint32_t draw_count;
+        uint32_t drawn_triangles;
+        uint32_t frustum_culled;
+        uint32_t cone_culled;
+    };
+
+    struct DrawCommand
+    {
+        uint32_t count;
+        uint32_t instance_count;
+        uint32_t first_index;
+        int32_t  base_vertex;
+        uint32_t base_instance;
+    };
+
+    struct Material
+    {
+        uint32_t diffuse;
+        uint32_t specular; // 0 when the mesh has no specular map
+    };
+
+    // fills the culled command buffer unless culling is off, returns the commands to draw when
+    // the count isn't left on the GPU
+    uint32_t cullClusters(const glm::mat4& view_projection, const glm::vec3& view_pos);
+
+    void   createTargets();
+    void   destroyTargets();
+    void   bindBuffers() const;
+    void   allocateTileLists();
+    size_t getTileListsSize() const;
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t render_width_;
+    uint32_t render_height_;
+    uint32_t max_tiles_ {0};
+
+    // cpu side geometry until build(), the draws and clusters stay for the culling
+    std::vector<float>       vertices_;
+    std::vector<uint32_t>    indices_;
+    std::vector<DrawData>    draws_;
+    std::vector<ClusterData> clusters_;
+    std::vector<DrawCommand> commands_; // one per cluster, base instance is its index
+    std::vector<DrawCommand> culled_commands_;
+    std::vector<Material>    materials_;
+
+    ClusterCulling cluster_culling_ {ClusterCulling::gpu};
+    ClusterStats   cluster_stats_;
+    uint32_t       cull_frame_ {0};
+    float          cull_cpu_ms_ {0.f};
+
+    uint32_t vao_ {0};
+    uint32_t vertex_buffer_ {0};
+    uint32_t index_buffer_ {0};
+    uint32_t draw_buffer_ {0};
+    uint32_t command_buffer_ {0};
+    uint32_t cluster_buffer_ {0};
+    uint32_t culled_command_buffer_ {0};
+    uint32_t count_buffers_[2] {}; // alternate frames, the stats read the one of the last
+    uint32_t material_args_buffer_ {0};
+    uint32_t material_tiles_buffer_ {0};
+    size_t   geometry_bytes_ {0};
+
+    uint32_t visibility_fbo_ {0};
+    uint32_t visibility_tex_ {0};
+    uint32_t depth_tex_ {0};
+    uint32_t output_tex_ {0};
+
+    Shader raster_shader_;
+    Shader classify_shader_;
+    Shader shade_shader_;
+    Shader cull_shader_;
+
+    GpuTimer raster_timer_;
+    GpuTimer classify_timer_;
+    GpuTimer shade_timer_;
+    GpuTimer cull_timer_;
+};